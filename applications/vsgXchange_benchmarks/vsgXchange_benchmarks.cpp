@@ -0,0 +1,421 @@
+#include <vsg/all.h>
+
+#include <vsgXchange/all.h>
+#include <vsgXchange/cpp.h>
+#include <vsgXchange/images.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <vector>
+
+#if defined(_WIN32)
+#    include <windows.h>
+// windows.h must be included before psapi.h
+#    include <psapi.h>
+#else
+#    include <sys/resource.h>
+#endif
+
+//
+// count the allocations made through the global operator new so each benchmark can report the number and size of the allocations made per read or write.
+// The array and nothrow forms of operator new default to calling this one, memory allocated with vsg::allocate() comes from the vsg::Allocator's memory blocks so is only counted as those blocks are allocated.
+//
+namespace
+{
+    std::atomic_uint64_t s_numAllocations = 0;
+    std::atomic_uint64_t s_allocatedBytes = 0;
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    ++s_numAllocations;
+    s_allocatedBytes += size;
+    if (void* ptr = std::malloc(size > 0 ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace benchmarks
+{
+    using clock = std::chrono::steady_clock;
+
+    /// reset the peak resident set size so the next call to peakRSS() reports the peak since the reset, returns false if the platform doesn't support it and the peak is that of the whole process.
+    bool resetPeakRSS()
+    {
+#if defined(__linux__)
+        std::ofstream fout("/proc/self/clear_refs");
+        fout << "5";
+        return fout.good();
+#else
+        return false;
+#endif
+    }
+
+    /// return the peak resident set size in bytes.
+    uint64_t peakRSS()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return counters.PeakWorkingSetSize;
+        return 0;
+#else
+#    if defined(__linux__)
+        // VmHWM honours the reset by clear_refs, unlike getrusage()
+        std::ifstream fin("/proc/self/status");
+        std::string line;
+        while (std::getline(fin, line))
+        {
+            if (line.compare(0, 6, "VmHWM:") == 0) return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+        }
+#    endif
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#    if defined(__APPLE__)
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#    else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#    endif
+#endif
+    }
+
+    struct Settings
+    {
+        uint32_t minIterations = 3;
+        double minDuration = 1.0;
+        std::string readerWriterName;
+        std::string tempDirectory = ".";
+    };
+
+    struct Result
+    {
+        std::string readerWriter;
+        std::string operation;
+        vsg::Path filename;
+        uint64_t bytes = 0;
+        uint32_t iterations = 0;
+        double seconds = 0.0;
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+        uint64_t peakRSS = 0;
+        bool image = false;
+
+        double megabytesPerSecond() const { return seconds > 0.0 ? (static_cast<double>(bytes) * iterations) / (seconds * 1024.0 * 1024.0) : 0.0; }
+        double operationsPerSecond() const { return seconds > 0.0 ? iterations / seconds : 0.0; }
+    };
+
+    /// run an operation once to check it succeeds, then repeatedly until both the minimum number of iterations and minimum duration are reached.
+    /// The operation returns the number of bytes read or written, 0 on failure.
+    template<typename F>
+    bool run(const Settings& settings, Result& result, F operation)
+    {
+        result.bytes = operation();
+        if (result.bytes == 0) return false;
+
+        resetPeakRSS();
+        uint64_t numAllocations = s_numAllocations;
+        uint64_t allocatedBytes = s_allocatedBytes;
+
+        auto start = clock::now();
+        do
+        {
+            operation();
+            ++result.iterations;
+            result.seconds = std::chrono::duration<double>(clock::now() - start).count();
+        } while (result.iterations < settings.minIterations || result.seconds < settings.minDuration);
+
+        result.allocations = (s_numAllocations - numAllocations) / result.iterations;
+        result.allocatedBytes = (s_allocatedBytes - allocatedBytes) / result.iterations;
+        result.peakRSS = peakRSS();
+        return true;
+    }
+
+    /// add the files in path to files, recursing into directories.
+    void collectFiles(const vsg::Path& path, vsg::Paths& files)
+    {
+        if (vsg::fileType(path) == vsg::DIRECTORY)
+        {
+            for (auto& name : vsg::getDirectoryContents(path))
+            {
+                if (name.string() == "." || name.string() == "..") continue;
+                collectFiles(path / name, files);
+            }
+        }
+        else if (vsg::fileExists(path))
+        {
+            files.push_back(path);
+        }
+        else
+        {
+            std::cout << "Warning: could not find " << path << std::endl;
+        }
+    }
+
+    std::vector<uint8_t> readFile(const vsg::Path& filename)
+    {
+        std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+        if (!fin) return {};
+
+        std::vector<uint8_t> buffer(static_cast<size_t>(fin.tellg()));
+        fin.seekg(0);
+        fin.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        return buffer;
+    }
+
+    uint64_t fileSize(const vsg::Path& filename)
+    {
+        std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+        auto size = fin ? fin.tellg() : std::streampos(0);
+        return size > 0 ? static_cast<uint64_t>(size) : 0;
+    }
+
+    std::string name(const vsg::ReaderWriter& rw)
+    {
+        if (auto lazy = dynamic_cast<const vsgXchange::LazyReaderWriter*>(&rw)) return lazy->implementationClassName;
+        return rw.className();
+    }
+
+    std::string jsonString(const std::string& str)
+    {
+        std::ostringstream out;
+        out << '"';
+        for (auto c : str)
+        {
+            switch (c)
+            {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                    out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+                else
+                    out << c;
+                break;
+            }
+        }
+        out << '"';
+        return out.str();
+    }
+
+    void writeJSON(std::ostream& out, const std::vector<Result>& results)
+    {
+        out << "{\n";
+        out << "  \"vsg_version\": " << jsonString(vsgGetVersionString()) << ",\n";
+        out << "  \"vsgXchange_version\": " << jsonString(vsgXchangeGetVersionString()) << ",\n";
+        out << "  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            auto& result = results[i];
+            out << (i > 0 ? ",\n" : "\n") << "    {";
+            out << "\"reader_writer\": " << jsonString(result.readerWriter);
+            out << ", \"operation\": " << jsonString(result.operation);
+            out << ", \"file\": " << jsonString(result.filename.string());
+            out << ", \"bytes\": " << result.bytes;
+            out << ", \"iterations\": " << result.iterations;
+            out << ", \"seconds\": " << result.seconds;
+            out << ", \"mb_per_second\": " << result.megabytesPerSecond();
+            out << ", \"per_second\": " << result.operationsPerSecond();
+            if (result.image) out << ", \"images_per_second\": " << result.operationsPerSecond();
+            out << ", \"allocations\": " << result.allocations;
+            out << ", \"allocated_bytes\": " << result.allocatedBytes;
+            out << ", \"peak_rss\": " << result.peakRSS;
+            out << "}";
+        }
+        out << "\n  ]\n}" << std::endl;
+    }
+
+    void writeTable(std::ostream& out, const std::vector<Result>& results)
+    {
+        out << std::left << std::setw(20) << "ReaderWriter" << std::setw(16) << "operation" << std::right << std::setw(10) << "MB/s" << std::setw(12) << "ops/s"
+            << std::setw(12) << "allocs/op" << std::setw(12) << "peak MB" << "  file" << std::endl;
+        out << std::fixed << std::setprecision(1);
+        for (auto& result : results)
+        {
+            out << std::left << std::setw(20) << result.readerWriter << std::setw(16) << result.operation << std::right << std::setw(10) << result.megabytesPerSecond()
+                << std::setw(12) << result.operationsPerSecond() << std::setw(12) << result.allocations << std::setw(12) << result.peakRSS / (1024.0 * 1024.0) << "  " << result.filename << std::endl;
+        }
+        out << std::defaultfloat;
+    }
+
+    /// benchmark writing object to each of the extensions the ReaderWriter can write to a file.
+    void benchmarkWrites(const vsg::ReaderWriter& rw, const vsg::Object& object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options, const Settings& settings, std::vector<Result>& results)
+    {
+        vsg::ReaderWriter::Features features;
+        if (!rw.getFeatures(features)) return;
+
+        for (auto& [ext, mask] : features.extensionFeatureMap)
+        {
+            if ((mask & vsg::ReaderWriter::WRITE_FILENAME) == 0) continue;
+
+            auto dest_filename = vsg::Path(settings.tempDirectory) / vsg::simpleFilename(filename).concat(vsg::Path("_benchmark")).concat(ext);
+
+            Result result{name(rw), "write_file", filename};
+            if (run(settings, result, [&]() -> uint64_t { return rw.write(&object, dest_filename, options) ? fileSize(dest_filename) : 0; }))
+            {
+                result.operation += ext.string();
+                results.push_back(result);
+            }
+            std::remove(dest_filename.string().c_str());
+        }
+    }
+
+    /// benchmark reading filename from file, istream and memory with each of the ReaderWriter that supports its extension, returning the first object read.
+    vsg::ref_ptr<vsg::Object> benchmarkReads(const std::vector<vsg::ref_ptr<vsg::ReaderWriter>>& readerWriters, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options, const Settings& settings, std::vector<Result>& results)
+    {
+        auto ext = vsg::lowerCaseFileExtension(filename);
+        auto buffer = readFile(filename);
+        if (buffer.empty()) return {};
+
+        auto hintOptions = vsg::Options::create(*options);
+        hintOptions->extensionHint = ext;
+
+        vsg::ref_ptr<vsg::Object> first;
+        for (auto& rw : readerWriters)
+        {
+            if (!settings.readerWriterName.empty() && name(*rw) != settings.readerWriterName) continue;
+
+            vsg::ReaderWriter::Features features;
+            if (!rw->getFeatures(features)) continue;
+
+            auto itr = features.extensionFeatureMap.find(ext);
+            if (itr == features.extensionFeatureMap.end()) continue;
+            auto mask = itr->second;
+
+            vsg::ref_ptr<vsg::Object> object;
+            auto readFromFile = [&]() -> uint64_t {
+                object = rw->read(filename, options);
+                return object ? buffer.size() : 0;
+            };
+            auto readStream = [&]() -> uint64_t {
+                std::ifstream fin(filename, std::ios::in | std::ios::binary);
+                object = rw->read(fin, hintOptions);
+                return object ? buffer.size() : 0;
+            };
+            auto readMemory = [&]() -> uint64_t {
+                object = rw->read(buffer.data(), buffer.size(), hintOptions);
+                return object ? buffer.size() : 0;
+            };
+
+            auto benchmark = [&](const char* operation, vsg::ReaderWriter::FeatureMask required, auto func) {
+                if ((mask & required) == 0) return;
+                Result result{name(*rw), operation, filename};
+                if (run(settings, result, func))
+                {
+                    result.image = object.cast<vsg::Data>() && object.cast<vsg::Data>()->dimensions() >= 2;
+                    results.push_back(result);
+                    if (!first) first = object;
+                }
+                else
+                {
+                    std::cout << "Warning: " << name(*rw) << " " << operation << " failed for " << filename << std::endl;
+                }
+                object = {};
+            };
+
+            benchmark("read_file", vsg::ReaderWriter::READ_FILENAME, readFromFile);
+            benchmark("read_istream", vsg::ReaderWriter::READ_ISTREAM, readStream);
+            benchmark("read_memory", vsg::ReaderWriter::READ_MEMORY, readMemory);
+        }
+        return first;
+    }
+
+} // namespace benchmarks
+
+int main(int argc, char** argv)
+{
+    vsg::CommandLine arguments(&argc, argv);
+
+    if (arguments.read({"-h", "--help"}) || argc < 2)
+    {
+        std::cout << "Usage:\n";
+        std::cout << "    vsgXchange_benchmarks [options] file|directory...\n\n";
+        std::cout << "Options:\n";
+        std::cout << "    -n iterations       # minimum number of timed iterations of each benchmark, defaults to 3\n";
+        std::cout << "    -d seconds          # minimum duration of each benchmark, defaults to 1.0\n";
+        std::cout << "    --rw name           # only benchmark the ReaderWriter with the specified class name, such as vsgXchange::stbi\n";
+        std::cout << "    --tmp directory     # directory the write benchmarks write to, defaults to the current directory\n";
+        std::cout << "    --json filename     # write the results as JSON to filename, or to the console when filename is -\n";
+        std::cout << "\nReads each file from file, istream and memory with every vsgXchange::all ReaderWriter that supports its extension,\n";
+        std::cout << "and writes the first object read with the stbi, openexr and cpp ReaderWriters, reporting MB/s, reads or writes per second,\n";
+        std::cout << "allocations per read or write and the peak resident set size." << std::endl;
+        return argc < 2 ? 1 : 0;
+    }
+
+    benchmarks::Settings settings;
+    arguments.read("-n", settings.minIterations);
+    arguments.read("-d", settings.minDuration);
+    arguments.read("--rw", settings.readerWriterName);
+    arguments.read("--tmp", settings.tempDirectory);
+    std::string jsonFilename;
+    arguments.read("--json", jsonFilename);
+
+    auto all = vsgXchange::all::create();
+    auto options = vsg::Options::create(all);
+    arguments.read(options);
+
+    if (arguments.errors()) return arguments.writeErrorMessages(std::cerr);
+
+    vsg::Paths files;
+    for (int i = 1; i < argc; ++i) benchmarks::collectFiles(vsg::Path(argv[i]), files);
+
+    std::vector<vsg::ref_ptr<vsg::ReaderWriter>> readerWriters;
+    for (auto& rw : all->readerWriters)
+    {
+        // benchmark the ReaderWriter itself rather than the proxy that defers its creation
+        if (auto lazy = rw.cast<vsgXchange::LazyReaderWriter>())
+            readerWriters.push_back(lazy->implementation());
+        else
+            readerWriters.push_back(rw);
+    }
+
+    std::vector<vsg::ref_ptr<vsg::ReaderWriter>> writers{vsgXchange::stbi::create(), vsgXchange::openexr::create(), vsgXchange::cpp::create()};
+
+    std::vector<benchmarks::Result> results;
+    for (auto& filename : files)
+    {
+        std::cout << "benchmarking " << filename << std::endl;
+        if (auto object = benchmarks::benchmarkReads(readerWriters, filename, options, settings, results))
+        {
+            for (auto& writer : writers)
+            {
+                if (settings.readerWriterName.empty() || writer->className() == settings.readerWriterName)
+                {
+                    benchmarks::benchmarkWrites(*writer, *object, filename, options, settings, results);
+                }
+            }
+        }
+    }
+
+    if (jsonFilename == "-")
+    {
+        benchmarks::writeJSON(std::cout, results);
+    }
+    else
+    {
+        benchmarks::writeTable(std::cout, results);
+        if (!jsonFilename.empty())
+        {
+            std::ofstream fout(jsonFilename);
+            benchmarks::writeJSON(fout, results);
+        }
+    }
+
+    return 0;
+}
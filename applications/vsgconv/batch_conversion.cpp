@@ -0,0 +1,545 @@
+#include "batch_conversion.h"
+
+#include <vsg/all.h>
+
+#include <vsgXchange/mesh_optimizer.h>
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+using namespace vsgconv;
+
+namespace
+{
+    /// match a filename against a pattern with * and ? wildcards, backtracking to the most recent * on a mismatch.
+    bool matchPattern(const char* pattern, const char* str)
+    {
+        const char* star = nullptr;
+        const char* resume = nullptr;
+        while (*str)
+        {
+            if (*pattern == '?' || (*pattern != '*' && *pattern == *str))
+            {
+                ++pattern;
+                ++str;
+            }
+            else if (*pattern == '*')
+            {
+                star = pattern++;
+                resume = str;
+            }
+            else if (star)
+            {
+                pattern = star + 1;
+                str = ++resume;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        while (*pattern == '*') ++pattern;
+        return *pattern == 0;
+    }
+
+    bool hasWildcards(const std::string& str)
+    {
+        return str.find_first_of("*?") != std::string::npos;
+    }
+
+    /// split a path into its directory and filename components.
+    std::pair<vsg::Path, std::string> splitFilename(const vsg::Path& path)
+    {
+        auto str = path.string();
+        auto pos = str.find_last_of("/\\");
+        if (pos == std::string::npos) return {vsg::Path("."), str};
+        return {vsg::Path(str.substr(0, pos)), str.substr(pos + 1)};
+    }
+
+    struct BatchFile
+    {
+        vsg::Path src_filename;
+        vsg::Path dest_filename;
+    };
+
+    struct CollectFiles
+    {
+        const BatchSettings& settings;
+        std::vector<std::pair<vsg::Path, vsg::Path>> files; // source filename and its path relative to the input, used to name the output
+
+        void directory(const vsg::Path& path, const vsg::Path& relative)
+        {
+            for (auto& entry : vsg::getDirectoryContents(path))
+            {
+                auto name = entry.string();
+                if (name == "." || name == "..") continue;
+
+                auto filename = path / entry;
+                auto relative_filename = relative ? relative / entry : entry;
+                auto type = vsg::fileType(filename);
+                if (type == vsg::DIRECTORY)
+                    directory(filename, relative_filename);
+                else if (type == vsg::REGULAR_FILE && matchPattern(settings.match.c_str(), name.c_str()))
+                    files.emplace_back(filename, relative_filename);
+            }
+        }
+
+        void input(const vsg::Path& path)
+        {
+            auto [parent, name] = splitFilename(path);
+            if (hasWildcards(name))
+            {
+                for (auto& entry : vsg::getDirectoryContents(parent))
+                {
+                    auto filename = parent / entry;
+                    if (matchPattern(name.c_str(), entry.string().c_str()) && vsg::fileType(filename) == vsg::REGULAR_FILE) files.emplace_back(filename, entry);
+                }
+            }
+            else if (vsg::fileType(path) == vsg::DIRECTORY)
+            {
+                directory(path, {});
+            }
+            else
+            {
+                files.emplace_back(path, vsg::Path(name));
+            }
+        }
+    };
+
+    vsg::Path destinationFilename(const vsg::Path& output, const vsg::Path& relative, const BatchSettings& settings)
+    {
+        auto stem = vsg::removeExtension(relative);
+        auto outputString = output.string();
+        if (auto pos = outputString.find('*'); pos != std::string::npos)
+        {
+            return vsg::Path(outputString.substr(0, pos) + stem.string() + outputString.substr(pos + 1));
+        }
+        return output / stem.concat(vsg::Path(settings.outputExtension));
+    }
+
+    void hashBytes(uint64_t& hash, const uint8_t* data, size_t size)
+    {
+        // FNV-1a
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    constexpr uint64_t hashSeed = 14695981039346656037ull;
+
+    uint64_t hashString(const std::string& str)
+    {
+        uint64_t hash = hashSeed;
+        hashBytes(hash, reinterpret_cast<const uint8_t*>(str.data()), str.size());
+        return hash;
+    }
+
+    bool hashFile(const vsg::Path& filename, uint64_t& hash)
+    {
+        std::ifstream fin(filename, std::ios::in | std::ios::binary);
+        if (!fin) return false;
+
+        hash = hashSeed;
+        std::vector<char> buffer(65536);
+        while (fin)
+        {
+            fin.read(buffer.data(), buffer.size());
+            hashBytes(hash, reinterpret_cast<const uint8_t*>(buffer.data()), static_cast<size_t>(fin.gcount()));
+        }
+        return true;
+    }
+
+    /// records the files resolved by vsg::findFile() while a file is converted, such as its textures, buffers and material files.
+    struct DependencyTracker : public vsg::Inherit<vsg::Object, DependencyTracker>
+    {
+        std::mutex mutex;
+        std::set<vsg::Path> filenames;
+
+        void track(vsg::Options& options)
+        {
+            vsg::ref_ptr<DependencyTracker> tracker(this);
+            options.findFileCallback = [tracker](const vsg::Path& filename, const vsg::Options* opts) -> vsg::Path {
+                // same search as vsg::findFile() does without a callback
+                auto hint = opts ? opts->checkFilenameHint : vsg::Options::CHECK_ORIGINAL_FILENAME_EXISTS_FIRST;
+                vsg::Path found;
+                if (hint == vsg::Options::CHECK_ORIGINAL_FILENAME_EXISTS_FIRST && vsg::fileExists(filename)) found = filename;
+                if (!found && opts) found = vsg::findFile(filename, opts->paths);
+                if (!found && hint == vsg::Options::CHECK_ORIGINAL_FILENAME_EXISTS_LAST && vsg::fileExists(filename)) found = filename;
+
+                if (found)
+                {
+                    std::scoped_lock<std::mutex> lock(tracker->mutex);
+                    tracker->filenames.insert(found);
+                }
+                return found;
+            };
+        }
+    };
+
+    /// content hashes of the source and dependencies of each converted file along with a hash of the options used to convert them, so later runs can skip files that are up to date.
+    class Manifest
+    {
+    public:
+        struct Dependency
+        {
+            vsg::Path filename;
+            uint64_t hash = 0;
+        };
+
+        struct Entry
+        {
+            uint64_t optionsHash = 0;
+            Dependency source;
+            std::vector<Dependency> dependencies;
+        };
+
+        bool read(const vsg::Path& filename)
+        {
+            std::ifstream fin(filename);
+            if (!fin) return false;
+
+            std::string line;
+            if (!std::getline(fin, line) || line != "vsgconv manifest 1") return false;
+
+            Entry* entry = nullptr;
+            while (std::getline(fin, line))
+            {
+                auto pos = line.find(' ');
+                if (pos == std::string::npos) continue;
+
+                auto key = line.substr(0, pos);
+                auto value = line.substr(pos + 1);
+                if (key == "file")
+                {
+                    entry = &_entries[vsg::Path(value)];
+                    *entry = {};
+                }
+                else if (entry && key == "options")
+                {
+                    entry->optionsHash = std::stoull(value, nullptr, 16);
+                }
+                else if (entry && (key == "source" || key == "depends"))
+                {
+                    auto hash_end = value.find(' ');
+                    if (hash_end == std::string::npos) continue;
+
+                    Dependency dependency{vsg::Path(value.substr(hash_end + 1)), std::stoull(value.substr(0, hash_end), nullptr, 16)};
+                    if (key == "source")
+                        entry->source = dependency;
+                    else
+                        entry->dependencies.push_back(dependency);
+                }
+            }
+            return true;
+        }
+
+        bool write(const vsg::Path& filename)
+        {
+            std::scoped_lock<std::mutex> lock(_mutex);
+
+            std::ofstream fout(filename);
+            if (!fout) return false;
+
+            fout << "vsgconv manifest 1\n";
+            fout << std::hex;
+            for (auto& [dest_filename, entry] : _entries)
+            {
+                fout << "file " << dest_filename.string() << "\n";
+                fout << "options " << entry.optionsHash << "\n";
+                fout << "source " << entry.source.hash << " " << entry.source.filename.string() << "\n";
+                for (auto& dependency : entry.dependencies)
+                {
+                    fout << "depends " << dependency.hash << " " << dependency.filename.string() << "\n";
+                }
+            }
+            return fout.good();
+        }
+
+        /// return true if the destination file exists and was converted from the current contents of the source file and its dependencies with the same options.
+        bool upToDate(const BatchFile& file, uint64_t optionsHash)
+        {
+            Entry entry;
+            {
+                std::scoped_lock<std::mutex> lock(_mutex);
+                auto itr = _entries.find(file.dest_filename);
+                if (itr == _entries.end()) return false;
+                entry = itr->second;
+            }
+
+            if (entry.optionsHash != optionsHash || entry.source.filename != file.src_filename || !vsg::fileExists(file.dest_filename)) return false;
+
+            uint64_t hash = 0;
+            if (!contentHash(entry.source.filename, hash) || hash != entry.source.hash) return false;
+            for (auto& dependency : entry.dependencies)
+            {
+                if (!contentHash(dependency.filename, hash) || hash != dependency.hash) return false;
+            }
+            return true;
+        }
+
+        /// record the hashes of the source and dependencies a file has been converted from, returns false if they couldn't be read so the file will be converted again on the next run.
+        bool record(const BatchFile& file, uint64_t optionsHash, const std::set<vsg::Path>& dependencies)
+        {
+            Entry entry;
+            entry.optionsHash = optionsHash;
+            entry.source.filename = file.src_filename;
+            if (!hashFile(file.src_filename, entry.source.hash)) return false;
+
+            for (auto& filename : dependencies)
+            {
+                if (filename == file.src_filename) continue;
+
+                Dependency dependency{filename, 0};
+                if (!contentHash(filename, dependency.hash)) return false;
+                entry.dependencies.push_back(dependency);
+            }
+
+            std::scoped_lock<std::mutex> lock(_mutex);
+            _entries[file.dest_filename] = entry;
+            return true;
+        }
+
+    protected:
+        /// hash of a file's contents, cached for the duration of the run as dependencies such as textures are often shared.
+        bool contentHash(const vsg::Path& filename, uint64_t& hash)
+        {
+            {
+                std::scoped_lock<std::mutex> lock(_mutex);
+                if (auto itr = _hashes.find(filename); itr != _hashes.end())
+                {
+                    hash = itr->second;
+                    return true;
+                }
+            }
+
+            if (!hashFile(filename, hash)) return false;
+
+            std::scoped_lock<std::mutex> lock(_mutex);
+            _hashes[filename] = hash;
+            return true;
+        }
+
+        std::mutex _mutex;
+        std::map<vsg::Path, Entry> _entries;
+        std::map<vsg::Path, uint64_t> _hashes;
+    };
+
+    bool makeDirectoryIfRequired(const vsg::Path& filename)
+    {
+        vsg::Path path = vsg::filePath(filename);
+        if (!path || vsg::fileExists(path)) return true;
+
+        // another thread may create the same directory concurrently, so only fail if it still doesn't exist
+        return vsg::makeDirectory(path) || vsg::fileExists(path);
+    }
+
+    bool convertFile(const BatchFile& file, vsg::ref_ptr<const vsg::Options> options, const BatchSettings& settings, DependencyTracker* tracker)
+    {
+        // each file is written on its own, so give it its own SharedObjects rather than accumulating the objects of the whole batch
+        auto local_options = vsg::clone(options);
+        local_options->sharedObjects = vsg::SharedObjects::create();
+        if (tracker) tracker->track(*local_options);
+
+        auto stats = settings.stats.get();
+
+        vsg::ref_ptr<vsg::Object> object;
+        {
+            ScopedStage stage(stats, "read");
+            object = vsg::read(file.src_filename, local_options);
+        }
+        if (!object)
+        {
+            vsg::warn("Failed to load ", file.src_filename);
+            return false;
+        }
+        if (auto readError = object.cast<vsg::ReadError>())
+        {
+            vsg::warn("Failed to load ", file.src_filename, " : ", readError->message);
+            return false;
+        }
+
+        if (auto image = object.cast<vsg::Data>())
+        {
+            ScopedStage stage(stats, "process textures");
+            object = processImage(image, settings.textureSettings);
+        }
+        else if (auto node = object.cast<vsg::Node>())
+        {
+            {
+                ScopedStage stage(stats, "compile shaders");
+                auto shaderCompiler = vsg::ShaderCompiler::create();
+                node->accept(*shaderCompiler);
+            }
+
+            {
+                ScopedStage stage(stats, "process textures");
+                processTextures(*node, settings.textureSettings);
+            }
+
+            if (settings.optimizeMeshes)
+            {
+                ScopedStage stage(stats, "optimize meshes");
+                auto optimize = vsgXchange::OptimizeMeshes::create();
+                node->accept(*optimize);
+            }
+
+            if (settings.lodLevels > 0)
+            {
+                ScopedStage stage(stats, "generate LODs");
+                auto generateLODs = vsgXchange::GenerateLODs::create();
+                generateLODs->numLevels = settings.lodLevels;
+                generateLODs->errorThreshold = settings.lodError;
+                node->accept(*generateLODs);
+            }
+        }
+        else if (settings.compileShaders)
+        {
+            auto ss = object.cast<vsg::ShaderStage>();
+            auto sm = ss ? ss->module : object.cast<vsg::ShaderModule>();
+            if (sm && !sm->source.empty() && sm->code.empty())
+            {
+                ScopedStage stage(stats, "compile shaders");
+                if (!ss) ss = vsg::ShaderStage::create(VK_SHADER_STAGE_ALL, "main", sm);
+
+                vsg::ShaderStages stagesToCompile{ss};
+                auto shaderCompiler = vsg::ShaderCompiler::create();
+                shaderCompiler->compile(stagesToCompile);
+                object = ss;
+            }
+        }
+
+        if (stats) stats->countObjects(*object);
+
+        if (!makeDirectoryIfRequired(file.dest_filename))
+        {
+            vsg::warn("Could not create directory for ", file.dest_filename);
+            return false;
+        }
+
+        if (!vsg::write(object, file.dest_filename, local_options))
+        {
+            vsg::warn("Failed to write ", file.dest_filename);
+            return false;
+        }
+
+        return true;
+    }
+
+    struct ConvertOperation : public vsg::Inherit<vsg::Operation, ConvertOperation>
+    {
+        ConvertOperation(const BatchFile& in_file, vsg::ref_ptr<const vsg::Options> in_options, const BatchSettings& in_settings, Manifest* in_manifest, vsg::ref_ptr<vsg::Latch> in_latch,
+                         std::atomic_size_t& in_numConverted, std::atomic_size_t& in_numFailed, size_t in_numFiles) :
+            file(in_file),
+            options(in_options),
+            settings(in_settings),
+            manifest(in_manifest),
+            latch(in_latch),
+            numConverted(in_numConverted),
+            numFailed(in_numFailed),
+            numFiles(in_numFiles)
+        {
+        }
+
+        void run() override
+        {
+            uint64_t optionsHash = hashString(settings.optionsSignature);
+            if (manifest && manifest->upToDate(file, optionsHash))
+            {
+                vsg::debug("up to date ", file.dest_filename);
+            }
+            else
+            {
+                auto tracker = manifest ? DependencyTracker::create() : vsg::ref_ptr<DependencyTracker>();
+                if (convertFile(file, options, settings, tracker.get()))
+                {
+                    if (manifest && !manifest->record(file, optionsHash, tracker->filenames)) vsg::warn("Unable to record dependencies of ", file.src_filename, " in manifest.");
+
+                    vsg::info("converted ", ++numConverted, "/", numFiles, " ", file.src_filename, " to ", file.dest_filename);
+                }
+                else
+                {
+                    ++numFailed;
+                }
+            }
+
+            latch->count_down();
+        }
+
+        BatchFile file;
+        vsg::ref_ptr<const vsg::Options> options;
+        const BatchSettings& settings;
+        Manifest* manifest;
+        vsg::ref_ptr<vsg::Latch> latch;
+        std::atomic_size_t& numConverted;
+        std::atomic_size_t& numFailed;
+        size_t numFiles;
+    };
+} // namespace
+
+size_t vsgconv::convertBatch(const std::vector<vsg::Path>& inputs, const vsg::Path& output, vsg::ref_ptr<const vsg::Options> options, const BatchSettings& settings)
+{
+    CollectFiles collectFiles{settings, {}};
+    for (auto& input : inputs) collectFiles.input(input);
+
+    if (collectFiles.files.empty())
+    {
+        vsg::warn("No input files found.");
+        return 0;
+    }
+
+    std::vector<BatchFile> files;
+    files.reserve(collectFiles.files.size());
+    for (auto& [src_filename, relative_filename] : collectFiles.files)
+    {
+        files.push_back(BatchFile{src_filename, destinationFilename(output, relative_filename, settings)});
+    }
+
+    vsg::info("converting ", files.size(), " files using ", settings.numThreads, " threads");
+
+    std::atomic_size_t numConverted = 0;
+    std::atomic_size_t numFailed = 0;
+
+    std::unique_ptr<Manifest> manifest;
+    vsg::Path manifestFilename = settings.manifest;
+    if (settings.incremental)
+    {
+        if (!manifestFilename)
+        {
+            bool outputPattern = output.string().find('*') != std::string::npos;
+            manifestFilename = (outputPattern ? vsg::filePath(output) : output) / "vsgconv.manifest";
+        }
+
+        manifest = std::make_unique<Manifest>();
+        if (manifest->read(manifestFilename)) vsg::info("read manifest ", manifestFilename);
+    }
+
+    auto status = vsg::ActivityStatus::create();
+    auto operationThreads = vsg::OperationThreads::create(std::max(1u, settings.numThreads), status);
+    auto latch = vsg::Latch::create(static_cast<int>(files.size()));
+
+    for (auto& file : files)
+    {
+        operationThreads->queue->add(ConvertOperation::create(file, options, settings, manifest.get(), latch, numConverted, numFailed, files.size()));
+    }
+
+    // wait until all the files have been converted, then signal the threads to close
+    latch->wait();
+    status->set(false);
+
+    vsg::info("converted ", numConverted.load(), " files, ", numFailed.load(), " failed");
+
+    if (manifest && (numConverted > 0 || !vsg::fileExists(manifestFilename)))
+    {
+        if (!makeDirectoryIfRequired(manifestFilename) || !manifest->write(manifestFilename)) vsg::warn("Failed to write manifest ", manifestFilename);
+    }
+
+    return numFailed;
+}
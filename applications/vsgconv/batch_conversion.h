@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vsg/io/Options.h>
+#include <vsg/io/Path.h>
+
+#include "conversion_stats.h"
+#include "texture_processing.h"
+
+namespace vsgconv
+{
+    struct BatchSettings
+    {
+        /// extension of the files written to an output directory, ignored when the output is a pattern.
+        std::string outputExtension = ".vsgb";
+
+        /// pattern that the names of the files found in input directories must match, supporting * and ? wildcards.
+        std::string match = "*";
+
+        /// number of files converted in parallel.
+        uint32_t numThreads = 16;
+
+        bool compileShaders = true;
+        bool optimizeMeshes = false;
+        uint32_t lodLevels = 0;
+        float lodError = 0.005f;
+        TextureSettings textureSettings;
+
+        /// only convert the files whose source, the files read while converting them, or the optionsSignature have changed since the manifest was last written.
+        bool incremental = false;
+
+        /// manifest recording the content hashes of each converted file's source and dependencies, defaults to vsgconv.manifest in the output directory.
+        vsg::Path manifest;
+
+        /// the command line options used, converted files are stale if they were converted with different options.
+        std::string optionsSignature;
+
+        /// optional --stats profile that the stages of each file's conversion are added to.
+        vsg::ref_ptr<ConversionStats> stats;
+    };
+
+    /// convert each of the input files, directories searched recursively, or filename patterns with * and ? wildcards, to its own output file
+    /// in parallel on a vsg::OperationThreads pool. The output is either a directory, which the input directory structure is recreated under,
+    /// or a pattern such as "output/*.vsgb" where * is replaced by each input file's name without extension. With settings.incremental only stale files are converted.
+    /// Returns the number of files that failed to convert.
+    extern size_t convertBatch(const std::vector<vsg::Path>& inputs, const vsg::Path& output, vsg::ref_ptr<const vsg::Options> options, const BatchSettings& settings);
+
+} // namespace vsgconv
@@ -0,0 +1,278 @@
+#include "conversion_stats.h"
+
+#include <vsg/all.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using namespace vsgconv;
+
+namespace
+{
+    const char* operationName(vsgXchange::ReadWriteEvent::Operation operation)
+    {
+        switch (operation)
+        {
+        case vsgXchange::ReadWriteEvent::READ_FILENAME: return "read file";
+        case vsgXchange::ReadWriteEvent::READ_ISTREAM: return "read istream";
+        case vsgXchange::ReadWriteEvent::READ_MEMORY: return "read memory";
+        case vsgXchange::ReadWriteEvent::WRITE_FILENAME: return "write file";
+        case vsgXchange::ReadWriteEvent::WRITE_OSTREAM: return "write ostream";
+        }
+        return "unknown";
+    }
+
+    void accumulate(ConversionStats::Totals& totals, double duration)
+    {
+        ++totals.count;
+        totals.duration += duration;
+        totals.maxDuration = std::max(totals.maxDuration, duration);
+    }
+
+    double megabytes(uint64_t bytes)
+    {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+
+    std::string jsonString(const std::string& str)
+    {
+        std::ostringstream out;
+        out << '"';
+        for (auto c : str)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20)
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+            else
+                out << c;
+        }
+        out << '"';
+        return out.str();
+    }
+
+    void writeTotals(std::ostream& out, const ConversionStats::Totals& totals)
+    {
+        out << "\"count\": " << totals.count << ", \"failed\": " << totals.failed << ", \"bytes_in\": " << totals.bytesIn << ", \"bytes_out\": " << totals.bytesOut
+            << ", \"peak_memory\": " << totals.peakMemory << ", \"seconds\": " << totals.duration << ", \"find_file_seconds\": " << totals.findFileDuration << ", \"max_seconds\": " << totals.maxDuration;
+    }
+
+    struct CountObjects : public vsg::ConstVisitor
+    {
+        ConversionStats::ObjectCounts& counts;
+        std::set<const vsg::Object*> visited;
+
+        explicit CountObjects(ConversionStats::ObjectCounts& in_counts) :
+            counts(in_counts) {}
+
+        bool firstVisit(const vsg::Object& object) { return visited.insert(&object).second; }
+
+        void apply(const vsg::Object& object) override
+        {
+            if (firstVisit(object)) object.traverse(*this);
+        }
+
+        void apply(const vsg::Node& node) override
+        {
+            if (!firstVisit(node)) return;
+            ++counts.nodes;
+            node.traverse(*this);
+        }
+
+        void applyMesh(const vsg::Node& node)
+        {
+            if (!firstVisit(node)) return;
+            ++counts.nodes;
+            ++counts.meshes;
+            node.traverse(*this);
+        }
+
+        void apply(const vsg::VertexIndexDraw& vid) override { applyMesh(vid); }
+        void apply(const vsg::VertexDraw& vd) override { applyMesh(vd); }
+        void apply(const vsg::Geometry& geometry) override { applyMesh(geometry); }
+
+        void apply(const vsg::DescriptorImage& descriptorImage) override
+        {
+            if (!firstVisit(descriptorImage)) return;
+            for (auto& imageInfo : descriptorImage.imageInfoList)
+            {
+                if (!imageInfo || !imageInfo->imageView || !imageInfo->imageView->image) continue;
+                if (auto& data = imageInfo->imageView->image->data; data && firstVisit(*data))
+                {
+                    ++counts.textures;
+                    counts.dataBytes += data->dataSize();
+                }
+            }
+        }
+
+        void apply(const vsg::Data& data) override
+        {
+            if (!firstVisit(data)) return;
+            ++counts.arrays;
+            counts.dataBytes += data.dataSize();
+        }
+    };
+} // namespace
+
+ConversionStats::ConversionStats() :
+    _startTime(std::chrono::steady_clock::now()),
+    _startClock(std::clock())
+{
+}
+
+void ConversionStats::report(const vsgXchange::ReadWriteEvent& event)
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    std::string readerWriter = event.cached ? std::string("vsgXchange::DataCache") : (event.readerWriter.empty() ? std::string("none") : event.readerWriter);
+
+    auto& totals = _readWrites[Key(operationName(event.operation), readerWriter, event.extension.string())];
+    accumulate(totals, event.duration);
+    if (!event.succeeded) ++totals.failed;
+    totals.bytesIn += event.bytesIn;
+    totals.bytesOut += event.bytesOut;
+    totals.peakMemory = std::max(totals.peakMemory, event.peakMemory);
+    totals.findFileDuration += event.findFileDuration;
+
+    for (auto& phase : event.phases)
+    {
+        accumulate(_phases[std::make_pair(readerWriter, phase.name)], phase.duration);
+    }
+
+    // nested reads run within the read that issued them so don't add to the thread's busy time
+    if (!event.nested) _threadBusy[event.threadId] += event.duration;
+}
+
+void ConversionStats::addStage(const std::string& name, double seconds)
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    auto itr = std::find_if(_stages.begin(), _stages.end(), [&](auto& stage) { return stage.first == name; });
+    if (itr == _stages.end()) itr = _stages.insert(_stages.end(), std::make_pair(name, Totals{}));
+    accumulate(itr->second, seconds);
+}
+
+void ConversionStats::countObjects(const vsg::Object& object)
+{
+    ObjectCounts counts;
+    CountObjects countObjects(counts);
+    object.accept(countObjects);
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _objects.nodes += counts.nodes;
+    _objects.meshes += counts.meshes;
+    _objects.textures += counts.textures;
+    _objects.arrays += counts.arrays;
+    _objects.dataBytes += counts.dataBytes;
+}
+
+void ConversionStats::print(std::ostream& out) const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - _startTime).count();
+    double cpuTime = static_cast<double>(std::clock() - _startClock) / CLOCKS_PER_SEC;
+
+    auto flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+
+    out << "\nvsgconv stats\n";
+    out << "    wall time " << wallTime << "s, cpu time " << cpuTime << "s, average threads busy " << (wallTime > 0.0 ? cpuTime / wallTime : 0.0) << "\n";
+
+    out << "\n    " << std::left << std::setw(16) << "operation" << std::setw(26) << "ReaderWriter" << std::setw(10) << "extension" << std::right << std::setw(8) << "count"
+        << std::setw(8) << "failed" << std::setw(12) << "MB in" << std::setw(12) << "MB out" << std::setw(12) << "MB peak" << std::setw(12) << "seconds" << std::setw(12) << "findFile" << std::setw(12) << "max" << "\n";
+    for (auto& [key, totals] : _readWrites)
+    {
+        out << "    " << std::left << std::setw(16) << std::get<0>(key) << std::setw(26) << std::get<1>(key) << std::setw(10) << std::get<2>(key) << std::right << std::setw(8) << totals.count
+            << std::setw(8) << totals.failed << std::setw(12) << megabytes(totals.bytesIn) << std::setw(12) << megabytes(totals.bytesOut) << std::setw(12) << megabytes(totals.peakMemory) << std::setw(12) << totals.duration
+            << std::setw(12) << totals.findFileDuration << std::setw(12) << totals.maxDuration << "\n";
+    }
+
+    if (!_phases.empty())
+    {
+        out << "\n    " << std::left << std::setw(26) << "ReaderWriter" << std::setw(24) << "phase" << std::right << std::setw(8) << "count" << std::setw(12) << "seconds"
+            << std::setw(12) << "max" << "\n";
+        for (auto& [key, totals] : _phases)
+        {
+            out << "    " << std::left << std::setw(26) << key.first << std::setw(24) << key.second << std::right << std::setw(8) << totals.count << std::setw(12) << totals.duration
+                << std::setw(12) << totals.maxDuration << "\n";
+        }
+    }
+
+    if (!_stages.empty())
+    {
+        // stages run in parallel by --batch and -l conversions can add up to more than the wall time
+        out << "\n    " << std::left << std::setw(24) << "stage" << std::right << std::setw(8) << "count" << std::setw(12) << "seconds" << std::setw(12) << "max" << "\n";
+        for (auto& [name, totals] : _stages)
+        {
+            out << "    " << std::left << std::setw(24) << name << std::right << std::setw(8) << totals.count << std::setw(12) << totals.duration << std::setw(12) << totals.maxDuration << "\n";
+        }
+    }
+
+    out << "\n    objects: " << _objects.nodes << " nodes, " << _objects.meshes << " meshes, " << _objects.textures << " textures, " << _objects.arrays << " arrays, "
+        << megabytes(_objects.dataBytes) << " MB of data\n";
+
+    out << "    threads: " << _threadBusy.size() << " threads read or wrote files";
+    for (auto& [id, busy] : _threadBusy)
+    {
+        if (wallTime > 0.0) out << ", " << std::setprecision(0) << 100.0 * busy / wallTime << "%" << std::setprecision(3);
+    }
+    out << " of the wall time" << std::endl;
+
+    out.flags(flags);
+}
+
+void ConversionStats::writeJSON(std::ostream& out) const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - _startTime).count();
+    double cpuTime = static_cast<double>(std::clock() - _startClock) / CLOCKS_PER_SEC;
+
+    out << "{\n";
+    out << "  \"wall_seconds\": " << wallTime << ",\n";
+    out << "  \"cpu_seconds\": " << cpuTime << ",\n";
+
+    out << "  \"read_writes\": [";
+    const char* separator = "\n";
+    for (auto& [key, totals] : _readWrites)
+    {
+        out << separator << "    {\"operation\": " << jsonString(std::get<0>(key)) << ", \"reader_writer\": " << jsonString(std::get<1>(key)) << ", \"extension\": " << jsonString(std::get<2>(key)) << ", ";
+        writeTotals(out, totals);
+        out << "}";
+        separator = ",\n";
+    }
+    out << "\n  ],\n";
+
+    out << "  \"phases\": [";
+    separator = "\n";
+    for (auto& [key, totals] : _phases)
+    {
+        out << separator << "    {\"reader_writer\": " << jsonString(key.first) << ", \"phase\": " << jsonString(key.second) << ", \"count\": " << totals.count
+            << ", \"peak_memory\": " << totals.peakMemory << ", \"seconds\": " << totals.duration << ", \"max_seconds\": " << totals.maxDuration << "}";
+        separator = ",\n";
+    }
+    out << "\n  ],\n";
+
+    out << "  \"stages\": [";
+    separator = "\n";
+    for (auto& [name, totals] : _stages)
+    {
+        out << separator << "    {\"stage\": " << jsonString(name) << ", \"count\": " << totals.count << ", \"peak_memory\": " << totals.peakMemory << ", \"seconds\": " << totals.duration << ", \"max_seconds\": " << totals.maxDuration << "}";
+        separator = ",\n";
+    }
+    out << "\n  ],\n";
+
+    out << "  \"objects\": {\"nodes\": " << _objects.nodes << ", \"meshes\": " << _objects.meshes << ", \"textures\": " << _objects.textures << ", \"arrays\": " << _objects.arrays
+        << ", \"data_bytes\": " << _objects.dataBytes << "},\n";
+
+    out << "  \"threads\": [";
+    separator = "";
+    for (auto& [id, busy] : _threadBusy)
+    {
+        out << separator << "{\"busy_seconds\": " << busy << ", \"utilisation\": " << (wallTime > 0.0 ? busy / wallTime : 0.0) << "}";
+        separator = ", ";
+    }
+    out << "]\n}" << std::endl;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vsg/core/Object.h>
+
+#include <vsgXchange/read_write_observer.h>
+
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace vsgconv
+{
+    /// profile of a conversion collected for --stats, the reads and writes reported by vsgXchange::all grouped by ReaderWriter and extension along with
+    /// the phases the ReaderWriters time, such as assimp's import and scene conversion, the time spent in each stage of the conversion, the objects converted and thread utilisation.
+    /// Stages and events may be reported from several threads at once.
+    class ConversionStats : public vsg::Inherit<vsgXchange::ReadWriteObserver, ConversionStats>
+    {
+    public:
+        ConversionStats();
+
+        void report(const vsgXchange::ReadWriteEvent& event) override;
+
+        /// add the time spent in a stage of the conversion, accumulating the time of repeated stages such as the per file stages of a --batch conversion.
+        void addStage(const std::string& name, double seconds);
+
+        /// count the nodes, meshes, textures and data bytes of a converted object, shared objects are counted once per call.
+        void countObjects(const vsg::Object& object);
+
+        /// print a summary of the reads and writes, stages, object counts and thread utilisation.
+        void print(std::ostream& out) const;
+
+        /// write the same information as print() as JSON.
+        void writeJSON(std::ostream& out) const;
+
+        struct Totals
+        {
+            size_t count = 0;
+            size_t failed = 0;
+            uint64_t bytesIn = 0;
+            uint64_t bytesOut = 0;
+            uint64_t peakMemory = 0; /// largest peak memory of a single read
+            double duration = 0.0;
+            double findFileDuration = 0.0;
+            double maxDuration = 0.0;
+        };
+
+        struct ObjectCounts
+        {
+            size_t nodes = 0;
+            size_t meshes = 0;
+            size_t textures = 0;
+            size_t arrays = 0;
+            uint64_t dataBytes = 0;
+        };
+
+    protected:
+        using Key = std::tuple<std::string, std::string, std::string>; // operation, ReaderWriter, extension
+
+        mutable std::mutex _mutex;
+        std::chrono::steady_clock::time_point _startTime;
+        std::clock_t _startClock;
+
+        std::map<Key, Totals> _readWrites;
+        std::map<std::pair<std::string, std::string>, Totals> _phases; // ReaderWriter, phase name
+        std::vector<std::pair<std::string, Totals>> _stages;           // in the order first reported
+        std::map<std::thread::id, double> _threadBusy;
+        ObjectCounts _objects;
+    };
+
+    /// adds the time until its destruction as a stage to stats, does nothing if stats is null.
+    class ScopedStage
+    {
+    public:
+        ScopedStage(ConversionStats* in_stats, const char* in_name) :
+            stats(in_stats),
+            name(in_name),
+            start(std::chrono::steady_clock::now()) {}
+
+        ScopedStage(const ScopedStage&) = delete;
+        ScopedStage& operator=(const ScopedStage&) = delete;
+
+        ~ScopedStage()
+        {
+            if (stats) stats->addStage(name, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        ConversionStats* stats;
+        const char* name;
+        std::chrono::steady_clock::time_point start;
+    };
+
+} // namespace vsgconv
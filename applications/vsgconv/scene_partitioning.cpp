@@ -0,0 +1,422 @@
+#include "scene_partitioning.h"
+
+#include <vsg/all.h>
+
+#include <vsgXchange/mesh_optimizer.h>
+#include <vsgXchange/write_queue.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+using namespace vsgconv;
+
+namespace
+{
+    /// a renderable subgraph along with the state and transform inherited from the scene graph above it
+    struct Item
+    {
+        std::vector<vsg::ref_ptr<vsg::StateGroup>> stateGroups;
+        vsg::dmat4 matrix;
+        bool transformed = false;
+        vsg::ref_ptr<vsg::Node> node;
+        vsg::dbox bounds;
+        size_t primitives = 0;
+    };
+
+    /// vsg::ComputeBounds doesn't handle the snorm16 positions or the instance arrays that vsgXchange::assimp can create, so use the bound of the CullNode
+    /// that decorate instanced meshes and dequantize snorm16 positions.
+    struct ComputeItemBounds : public vsg::ComputeBounds
+    {
+        using vsg::ComputeBounds::apply;
+
+        void apply(const vsg::CullNode& cullNode) override
+        {
+            auto& bound = cullNode.bound;
+            for (int i = 0; i < 8; ++i)
+            {
+                vsg::dvec3 corner(bound.center.x + ((i & 1) ? bound.radius : -bound.radius),
+                                  bound.center.y + ((i & 2) ? bound.radius : -bound.radius),
+                                  bound.center.z + ((i & 4) ? bound.radius : -bound.radius));
+                if (matrixStack.empty())
+                    bounds.add(corner);
+                else
+                    bounds.add(matrixStack.back() * corner);
+            }
+        }
+
+        void apply(const vsg::svec4Array& vertices) override
+        {
+            const double scale = 1.0 / 32767.0;
+            for (auto& v : vertices)
+            {
+                vsg::dvec3 vertex(v.x * scale, v.y * scale, v.z * scale);
+                if (matrixStack.empty())
+                    bounds.add(vertex);
+                else
+                    bounds.add(matrixStack.back() * vertex);
+            }
+        }
+    };
+
+    /// count the primitives drawn at the highest level of detail
+    struct CountPrimitives : public vsg::ConstVisitor
+    {
+        size_t primitives = 0;
+
+        void apply(const vsg::Object& object) override { object.traverse(*this); }
+        void apply(const vsg::LOD& lod) override
+        {
+            if (!lod.children.empty() && lod.children.front().node) lod.children.front().node->accept(*this);
+        }
+        void apply(const vsg::VertexIndexDraw& vid) override { primitives += static_cast<size_t>(vid.indexCount / 3) * vid.instanceCount; }
+        void apply(const vsg::VertexDraw& vd) override { primitives += static_cast<size_t>(vd.vertexCount / 3) * vd.instanceCount; }
+        void apply(const vsg::DrawIndexed& drawIndexed) override { primitives += static_cast<size_t>(drawIndexed.indexCount / 3) * drawIndexed.instanceCount; }
+        void apply(const vsg::Draw& draw) override { primitives += static_cast<size_t>(draw.vertexCount / 3) * draw.instanceCount; }
+    };
+
+    /// flatten the scene graph into Items, descending through Groups, StateGroups and MatrixTransforms.
+    struct CollectItems : public vsg::Visitor
+    {
+        std::vector<vsg::ref_ptr<vsg::StateGroup>> stateGroups;
+        std::vector<vsg::dmat4> matrixStack{vsg::dmat4()};
+        std::vector<Item> items;
+        bool animated = false;
+
+        void apply(vsg::Node& node) override
+        {
+            Item item;
+            item.stateGroups = stateGroups;
+            item.matrix = matrixStack.back();
+            item.transformed = matrixStack.size() > 1;
+            item.node = &node;
+
+            ComputeItemBounds computeBounds;
+            computeBounds.matrixStack.push_back(item.matrix);
+            node.accept(computeBounds);
+            item.bounds = computeBounds.bounds;
+
+            CountPrimitives countPrimitives;
+            node.accept(countPrimitives);
+            item.primitives = countPrimitives.primitives;
+
+            items.push_back(item);
+        }
+
+        void apply(vsg::Group& group) override { group.traverse(*this); }
+
+        void apply(vsg::StateGroup& stateGroup) override
+        {
+            stateGroups.emplace_back(&stateGroup);
+            stateGroup.traverse(*this);
+            stateGroups.pop_back();
+        }
+
+        void apply(vsg::Transform& transform) override { apply(static_cast<vsg::Node&>(transform)); }
+
+        void apply(vsg::MatrixTransform& transform) override
+        {
+            matrixStack.push_back(matrixStack.back() * transform.matrix);
+            transform.traverse(*this);
+            matrixStack.pop_back();
+        }
+
+        void apply(vsg::AnimationGroup& animationGroup) override
+        {
+            animated = true;
+            animationGroup.traverse(*this);
+        }
+
+        void apply(vsg::Joint& joint) override
+        {
+            animated = true;
+            apply(static_cast<vsg::Node&>(joint));
+        }
+    };
+
+    struct Cell
+    {
+        std::vector<size_t> items;
+        vsg::dbox bounds;
+        size_t primitives = 0;
+        std::unique_ptr<Cell> children[2];
+    };
+
+    VkPrimitiveTopology pipelineTopology(const vsg::StateGroup& stateGroup, VkPrimitiveTopology topology)
+    {
+        for (auto& stateCommand : stateGroup.stateCommands)
+        {
+            if (auto bindPipeline = stateCommand.cast<vsg::BindGraphicsPipeline>(); bindPipeline && bindPipeline->pipeline)
+            {
+                for (auto& pipelineState : bindPipeline->pipeline->pipelineStates)
+                {
+                    if (auto inputAssemblyState = pipelineState.cast<vsg::InputAssemblyState>()) topology = inputAssemblyState->topology;
+                }
+            }
+        }
+        return topology;
+    }
+
+    class ScenePartitioner
+    {
+    public:
+        ScenePartitioner(const vsg::Path& in_dest_filename, vsg::ref_ptr<const vsg::Options> in_options, const PartitionSettings& in_settings) :
+            dest_filename(in_dest_filename),
+            options(in_options),
+            settings(in_settings)
+        {
+            cells_path = vsg::simpleFilename(dest_filename) + "_cells";
+            generateLODs = vsgXchange::GenerateLODs::create();
+
+            // only drop the vertices no longer referenced by the simplified proxies
+            optimizeMeshes = vsgXchange::OptimizeMeshes::create();
+            optimizeMeshes->weldVertices = false;
+            optimizeMeshes->optimizeVertexCache = false;
+            optimizeMeshes->optimizeOverdraw = false;
+        }
+
+        vsg::Path dest_filename;
+        vsg::Path cells_path;
+        vsg::ref_ptr<const vsg::Options> options;
+        PartitionSettings settings;
+        std::vector<Item> items;
+        vsg::ref_ptr<vsgXchange::GenerateLODs> generateLODs;
+        vsg::ref_ptr<vsgXchange::OptimizeMeshes> optimizeMeshes;
+        vsg::ref_ptr<vsgXchange::WriteQueue> writeQueue;
+        size_t numCellFiles = 0;
+
+        void split(Cell& cell, unsigned int depth)
+        {
+            if (cell.primitives <= settings.maxCellPrimitives || cell.items.size() < 2 || depth >= 32) return;
+
+            // split along the longest axis of the item centres, where half the primitives lie on either side
+            vsg::dbox centres;
+            for (auto i : cell.items) centres.add((items[i].bounds.min + items[i].bounds.max) * 0.5);
+
+            auto extents = centres.max - centres.min;
+            int axis = (extents.x >= extents.y && extents.x >= extents.z) ? 0 : ((extents.y >= extents.z) ? 1 : 2);
+            if (extents[axis] <= 0.0) return;
+
+            auto sorted = cell.items;
+            std::sort(sorted.begin(), sorted.end(), [&](size_t lhs, size_t rhs) {
+                return (items[lhs].bounds.min[axis] + items[lhs].bounds.max[axis]) < (items[rhs].bounds.min[axis] + items[rhs].bounds.max[axis]);
+            });
+
+            size_t splitIndex = 0;
+            size_t primitives = 0;
+            while (splitIndex < sorted.size() - 1 && (primitives + items[sorted[splitIndex]].primitives) * 2 <= cell.primitives)
+            {
+                primitives += items[sorted[splitIndex++]].primitives;
+            }
+            if (splitIndex == 0) splitIndex = 1;
+
+            for (int c = 0; c < 2; ++c)
+            {
+                auto child = std::make_unique<Cell>();
+                auto begin = (c == 0) ? sorted.begin() : sorted.begin() + splitIndex;
+                auto end = (c == 0) ? sorted.begin() + splitIndex : sorted.end();
+                for (auto itr = begin; itr != end; ++itr)
+                {
+                    child->items.push_back(*itr);
+                    child->bounds.add(items[*itr].bounds);
+                    child->primitives += items[*itr].primitives;
+                }
+                split(*child, depth + 1);
+                cell.children[c] = std::move(child);
+            }
+        }
+
+        /// create a coarse copy of a subgraph, replacing VertexIndexDraw with simplified versions and LOD with their least detailed child.
+        vsg::ref_ptr<vsg::Node> createProxy(vsg::ref_ptr<vsg::Node> node, VkPrimitiveTopology topology, float maxError) const
+        {
+            if (!node) return {};
+
+            if (auto vid = node.cast<vsg::VertexIndexDraw>())
+            {
+                if (topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST || vid->instanceCount != 1) return node;
+
+                auto simplified = generateLODs->simplify(*vid, maxError);
+                if (!simplified) return node;
+                if (simplified->indexCount == 0) return {};
+
+                optimizeMeshes->optimize(*simplified, topology);
+                return simplified;
+            }
+            if (auto lod = node.cast<vsg::LOD>())
+            {
+                return lod->children.empty() ? vsg::ref_ptr<vsg::Node>() : createProxy(lod->children.back().node, topology, maxError);
+            }
+            if (auto cullNode = node.cast<vsg::CullNode>())
+            {
+                auto child = createProxy(cullNode->child, topology, maxError);
+                return child ? vsg::CullNode::create(cullNode->bound, child) : vsg::ref_ptr<vsg::Node>();
+            }
+            if (auto depthSorted = node.cast<vsg::DepthSorted>())
+            {
+                auto child = createProxy(depthSorted->child, topology, maxError);
+                if (!child) return {};
+
+                auto copy = vsg::DepthSorted::create();
+                copy->binNumber = depthSorted->binNumber;
+                copy->bound = depthSorted->bound;
+                copy->child = child;
+                return copy;
+            }
+
+            vsg::ref_ptr<vsg::Group> copy;
+            if (auto stateGroup = node.cast<vsg::StateGroup>())
+            {
+                auto stateGroupCopy = vsg::StateGroup::create();
+                stateGroupCopy->stateCommands = stateGroup->stateCommands;
+                stateGroupCopy->prototypeArrayState = stateGroup->prototypeArrayState;
+                topology = pipelineTopology(*stateGroup, topology);
+                copy = stateGroupCopy;
+            }
+            else if (auto transform = node.cast<vsg::MatrixTransform>())
+            {
+                copy = vsg::MatrixTransform::create(transform->matrix);
+            }
+            else if (node->is_compatible(typeid(vsg::Group)) && !node->is_compatible(typeid(vsg::Transform)))
+            {
+                copy = vsg::Group::create();
+            }
+            else
+            {
+                return node;
+            }
+
+            for (auto& child : node.cast<vsg::Group>()->children)
+            {
+                if (auto proxy = createProxy(child, topology, maxError)) copy->addChild(proxy);
+            }
+            return copy->children.empty() ? vsg::ref_ptr<vsg::Node>() : vsg::ref_ptr<vsg::Node>(copy);
+        }
+
+        /// assemble the items into a subgraph, sharing copies of the StateGroups between items that inherited the same state.
+        vsg::ref_ptr<vsg::Node> createContent(const std::vector<size_t>& itemIndices, bool proxy, double cellSize) const
+        {
+            auto root = vsg::Group::create();
+            std::map<std::pair<vsg::Group*, vsg::StateGroup*>, vsg::ref_ptr<vsg::StateGroup>> stateGroupCopies;
+
+            for (auto i : itemIndices)
+            {
+                auto& item = items[i];
+                auto node = item.node;
+                if (proxy)
+                {
+                    double size = vsg::length(item.bounds.max - item.bounds.min);
+                    if (size < settings.proxyMinimumSize * cellSize) continue;
+
+                    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
+                    for (auto& stateGroup : item.stateGroups) topology = pipelineTopology(*stateGroup, topology);
+
+                    float maxError = static_cast<float>(std::min(1.0, settings.proxyError * cellSize / std::max(size, 1e-12)));
+                    node = createProxy(node, topology, maxError);
+                    if (!node) continue;
+                }
+
+                vsg::Group* parent = root.get();
+                for (auto& stateGroup : item.stateGroups)
+                {
+                    auto& copy = stateGroupCopies[{parent, stateGroup.get()}];
+                    if (!copy)
+                    {
+                        copy = vsg::StateGroup::create();
+                        copy->stateCommands = stateGroup->stateCommands;
+                        copy->prototypeArrayState = stateGroup->prototypeArrayState;
+                        parent->addChild(copy);
+                    }
+                    parent = copy.get();
+                }
+
+                if (item.transformed)
+                {
+                    auto transform = vsg::MatrixTransform::create(item.matrix);
+                    transform->addChild(node);
+                    node = transform;
+                }
+                parent->addChild(node);
+            }
+
+            if (root->children.size() == 1) return root->children.front();
+            return root;
+        }
+
+        vsg::ref_ptr<vsg::Node> build(const Cell& cell, const std::string& id)
+        {
+            if (!cell.children[0]) return createContent(cell.items, false, 0.0);
+
+            auto group = vsg::Group::create();
+            for (int c = 0; c < 2; ++c)
+            {
+                if (auto child = build(*cell.children[c], id + static_cast<char>('0' + c))) group->addChild(child);
+            }
+
+            auto filename = cells_path / (id + vsg::fileExtension(dest_filename));
+            writeQueue->write(group, vsg::filePath(dest_filename) / filename, options);
+            ++numCellFiles;
+
+            double cellSize = vsg::length(cell.bounds.max - cell.bounds.min);
+            auto proxy = createContent(cell.items, true, cellSize);
+
+            auto plod = vsg::PagedLOD::create();
+            plod->bound = vsg::dsphere((cell.bounds.min + cell.bounds.max) * 0.5, cellSize * 0.5);
+            plod->children[0] = vsg::PagedLOD::Child{settings.minimumScreenHeightRatio, {}};
+            plod->children[1] = vsg::PagedLOD::Child{0.0, proxy};
+            plod->filename = filename;
+            return plod;
+        }
+    };
+} // namespace
+
+vsg::ref_ptr<vsg::Node> vsgconv::partitionScene(vsg::ref_ptr<vsg::Node> scene, const vsg::Path& dest_filename, vsg::ref_ptr<const vsg::Options> options, const PartitionSettings& settings)
+{
+    if (!scene) return {};
+
+    CollectItems collectItems;
+    scene->accept(collectItems);
+    if (collectItems.animated)
+    {
+        vsg::warn("vsgconv: partitioning of animated scenes isn't supported.");
+        return {};
+    }
+
+    ScenePartitioner partitioner(dest_filename, options, settings);
+    partitioner.items = std::move(collectItems.items);
+
+    // items without bounds, such as lights, stay in the root
+    Cell root;
+    std::vector<size_t> unbounded;
+    for (size_t i = 0; i < partitioner.items.size(); ++i)
+    {
+        auto& item = partitioner.items[i];
+        if (item.bounds.valid())
+        {
+            root.items.push_back(i);
+            root.bounds.add(item.bounds);
+            root.primitives += item.primitives;
+        }
+        else
+        {
+            unbounded.push_back(i);
+        }
+    }
+
+    partitioner.split(root, 0);
+
+    partitioner.writeQueue = vsgXchange::WriteQueue::create(std::max(1u, settings.numThreads));
+    auto hierarchy = partitioner.build(root, "r");
+    partitioner.writeQueue->flush();
+
+    if (partitioner.writeQueue->numFailed() > 0) vsg::warn("vsgconv: failed to write ", partitioner.writeQueue->numFailed(), " of ", partitioner.numCellFiles, " cells.");
+
+    vsg::info("vsgconv: partitioned ", root.primitives, " primitives into ", partitioner.numCellFiles, " cell files in ", partitioner.cells_path);
+
+    if (unbounded.empty()) return hierarchy;
+
+    auto group = vsg::Group::create();
+    if (auto content = partitioner.createContent(unbounded, false, 0.0)) group->addChild(content);
+    if (hierarchy) group->addChild(hierarchy);
+    return group;
+}
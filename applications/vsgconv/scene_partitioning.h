@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vsg/io/Options.h>
+#include <vsg/io/Path.h>
+#include <vsg/nodes/Node.h>
+
+namespace vsgconv
+{
+    struct PartitionSettings
+    {
+        /// maximum number of primitives, such as triangles, held by each cell before it's split.
+        size_t maxCellPrimitives = 100000;
+
+        /// screen height ratio of a cell's bound at which its children are paged in to replace the coarse proxy.
+        double minimumScreenHeightRatio = 0.5;
+
+        /// maximum error of the coarse proxies as a ratio of the cell's bounding box diagonal.
+        float proxyError = 0.01f;
+
+        /// meshes smaller than this ratio of the cell's bounding box diagonal are left out of the cell's coarse proxy.
+        double proxyMinimumSize = 0.1;
+
+        /// number of threads used to write the cells.
+        uint32_t numThreads = 4;
+    };
+
+    /// partition the scene with a kd-tree over its mesh bounds, writing each cell to its own file alongside dest_filename and referencing them from a PagedLOD hierarchy
+    /// where each PagedLOD holds a coarse proxy of its cell, simplified with vsgXchange::GenerateLODs, until its children are paged in. Returns the root of the hierarchy,
+    /// which is not written, or null if the scene can't be partitioned.
+    extern vsg::ref_ptr<vsg::Node> partitionScene(vsg::ref_ptr<vsg::Node> scene, const vsg::Path& dest_filename, vsg::ref_ptr<const vsg::Options> options, const PartitionSettings& settings);
+
+} // namespace vsgconv
@@ -0,0 +1,734 @@
+#include "texture_processing.h"
+
+#include <vsg/all.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct FloatImage
+    {
+        FloatImage(uint32_t w, uint32_t h) :
+            width(w), height(h), pixels(static_cast<size_t>(w) * h) {}
+
+        uint32_t width;
+        uint32_t height;
+        std::vector<vsg::vec4> pixels;
+
+        vsg::vec4* row(uint32_t y) { return pixels.data() + static_cast<size_t>(y) * width; }
+        const vsg::vec4* row(uint32_t y) const { return pixels.data() + static_cast<size_t>(y) * width; }
+    };
+
+    uint32_t numComponents(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB: return 1;
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB: return 2;
+        case VK_FORMAT_R8G8B8_UNORM:
+        case VK_FORMAT_R8G8B8_SRGB: return 3;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB: return 4;
+        default: return 0;
+        }
+    }
+
+    bool isSRGB(VkFormat format)
+    {
+        return format == VK_FORMAT_R8_SRGB || format == VK_FORMAT_R8G8_SRGB || format == VK_FORMAT_R8G8B8_SRGB || format == VK_FORMAT_R8G8B8A8_SRGB;
+    }
+
+    float linearToSRGB(float c)
+    {
+        return (c <= 0.0031308f) ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    }
+
+    uint8_t toByte(float c)
+    {
+        return static_cast<uint8_t>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    // convert to linear RGBA so mipmaps of sRGB images are filtered in linear space
+    FloatImage toFloat(const vsg::Data& image, uint32_t components, bool srgb)
+    {
+        std::array<float, 256> decode;
+        for (int i = 0; i < 256; ++i)
+        {
+            float c = static_cast<float>(i) / 255.0f;
+            decode[i] = srgb ? ((c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f)) : c;
+        }
+
+        FloatImage result(image.width(), image.height());
+        const uint32_t stride = image.properties.stride > 0 ? image.properties.stride : components;
+        auto src = static_cast<const uint8_t*>(image.dataPointer());
+        for (auto& pixel : result.pixels)
+        {
+            pixel.set(decode[src[0]],
+                      (components > 1) ? decode[src[1]] : 0.0f,
+                      (components > 2) ? decode[src[2]] : 0.0f,
+                      (components > 3) ? static_cast<float>(src[3]) / 255.0f : 1.0f);
+            src += stride;
+        }
+        return result;
+    }
+
+    // convert to 8 bit RGBA, re-applying the sRGB encoding if required
+    std::vector<uint8_t> toBytes(const FloatImage& image, bool srgb)
+    {
+        std::vector<uint8_t> result(image.pixels.size() * 4);
+        auto dest = result.data();
+        for (auto& pixel : image.pixels)
+        {
+            for (int c = 0; c < 3; ++c) *(dest++) = toByte(srgb ? linearToSRGB(pixel[c]) : pixel[c]);
+            *(dest++) = toByte(pixel.a);
+        }
+        return result;
+    }
+
+    // 2x2 box filter, clamping at the edges of odd sized images
+    FloatImage downsampleBox(const FloatImage& src)
+    {
+        FloatImage dest(std::max(1u, src.width / 2), std::max(1u, src.height / 2));
+        for (uint32_t y = 0; y < dest.height; ++y)
+        {
+            const auto row0 = src.row(std::min(y * 2, src.height - 1));
+            const auto row1 = src.row(std::min(y * 2 + 1, src.height - 1));
+            auto dest_row = dest.row(y);
+            for (uint32_t x = 0; x < dest.width; ++x)
+            {
+                const uint32_t x0 = std::min(x * 2, src.width - 1);
+                const uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+                dest_row[x] = (row0[x0] + row0[x1] + row1[x0] + row1[x1]) * 0.25f;
+            }
+        }
+        return dest;
+    }
+
+    // 8 tap Kaiser windowed sinc for downsampling by 2, taps at source offsets -3.5 to 3.5 from the destination pixel centre
+    std::array<float, 8> kaiserWeights()
+    {
+        auto bessel0 = [](float x) {
+            float sum = 1.0f, term = 1.0f;
+            for (int k = 1; k < 16; ++k)
+            {
+                float t = x / (2.0f * static_cast<float>(k));
+                term *= t * t;
+                sum += term;
+            }
+            return sum;
+        };
+
+        const float alpha = 4.0f;
+        const float pi = 3.14159265358979f;
+
+        std::array<float, 8> weights;
+        float total = 0.0f;
+        for (int i = 0; i < 8; ++i)
+        {
+            float d = static_cast<float>(i) - 3.5f;
+            float t = d / 4.0f;
+            float sinc = std::sin(pi * d * 0.5f) / (pi * d * 0.5f);
+            weights[i] = sinc * bessel0(alpha * std::sqrt(1.0f - t * t)) / bessel0(alpha);
+            total += weights[i];
+        }
+        for (auto& weight : weights) weight /= total;
+        return weights;
+    }
+
+    FloatImage downsampleKaiser(const FloatImage& src)
+    {
+        static const auto weights = kaiserWeights();
+
+        // separable, filter the rows into an intermediate image then the columns
+        FloatImage horizontal(std::max(1u, src.width / 2), src.height);
+        for (uint32_t y = 0; y < src.height; ++y)
+        {
+            const auto src_row = src.row(y);
+            auto dest_row = horizontal.row(y);
+            for (uint32_t x = 0; x < horizontal.width; ++x)
+            {
+                vsg::vec4 sum;
+                for (int i = 0; i < 8; ++i)
+                {
+                    int sx = std::clamp(static_cast<int>(x * 2) - 3 + i, 0, static_cast<int>(src.width) - 1);
+                    sum += src_row[sx] * weights[i];
+                }
+                dest_row[x] = sum;
+            }
+        }
+
+        FloatImage dest(horizontal.width, std::max(1u, src.height / 2));
+        for (uint32_t y = 0; y < dest.height; ++y)
+        {
+            auto dest_row = dest.row(y);
+            std::fill(dest_row, dest_row + dest.width, vsg::vec4());
+            for (int i = 0; i < 8; ++i)
+            {
+                int sy = std::clamp(static_cast<int>(y * 2) - 3 + i, 0, static_cast<int>(horizontal.height) - 1);
+                const auto src_row = horizontal.row(sy);
+                const float weight = weights[i];
+                for (uint32_t x = 0; x < dest.width; ++x) dest_row[x] += src_row[x] * weight;
+            }
+
+            // the negative lobes can overshoot, clamp so the alpha and colours stay in range
+            for (uint32_t x = 0; x < dest.width; ++x)
+            {
+                for (int c = 0; c < 4; ++c) dest_row[x][c] = std::clamp(dest_row[x][c], 0.0f, 1.0f);
+            }
+        }
+        return dest;
+    }
+
+    using Texels = std::array<std::array<uint8_t, 4>, 16>;
+
+    // gather a 4x4 block of RGBA texels, clamping at the edges of levels smaller than a block
+    Texels gatherBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by)
+    {
+        Texels texels;
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+            uint32_t y = std::min(by * 4 + j, height - 1);
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                uint32_t x = std::min(bx * 4 + i, width - 1);
+                std::memcpy(texels[j * 4 + i].data(), rgba + (static_cast<size_t>(y) * width + x) * 4, 4);
+            }
+        }
+        return texels;
+    }
+
+    // endpoints along the principal axis of the first numChannels channels of the texels
+    void computeEndpoints(const Texels& texels, int numChannels, float e0[4], float e1[4])
+    {
+        float mean[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (auto& texel : texels)
+            for (int c = 0; c < numChannels; ++c) mean[c] += texel[c];
+        for (int c = 0; c < numChannels; ++c) mean[c] /= 16.0f;
+
+        float covariance[4][4] = {};
+        for (auto& texel : texels)
+        {
+            for (int r = 0; r < numChannels; ++r)
+                for (int c = 0; c < numChannels; ++c) covariance[r][c] += (texel[r] - mean[r]) * (texel[c] - mean[c]);
+        }
+
+        // power iteration for the dominant eigenvector
+        float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            float length = 0.0f;
+            for (int r = 0; r < numChannels; ++r)
+            {
+                for (int c = 0; c < numChannels; ++c) next[r] += covariance[r][c] * axis[c];
+                length = std::max(length, std::abs(next[r]));
+            }
+            if (length == 0.0f) break;
+            for (int c = 0; c < numChannels; ++c) axis[c] = next[c] / length;
+        }
+
+        float tMin = 0.0f, tMax = 0.0f;
+        for (auto& texel : texels)
+        {
+            float t = 0.0f;
+            for (int c = 0; c < numChannels; ++c) t += (texel[c] - mean[c]) * axis[c];
+            tMin = std::min(tMin, t);
+            tMax = std::max(tMax, t);
+        }
+
+        float lengthSquared = 0.0f;
+        for (int c = 0; c < numChannels; ++c) lengthSquared += axis[c] * axis[c];
+        if (lengthSquared > 0.0f)
+        {
+            tMin /= lengthSquared;
+            tMax /= lengthSquared;
+        }
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            e0[c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+            e1[c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+        }
+    }
+
+    uint16_t toRGB565(const float c[4])
+    {
+        auto r = static_cast<uint16_t>(c[0] * 31.0f / 255.0f + 0.5f);
+        auto g = static_cast<uint16_t>(c[1] * 63.0f / 255.0f + 0.5f);
+        auto b = static_cast<uint16_t>(c[2] * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void fromRGB565(uint16_t v, int c[3])
+    {
+        int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+        c[0] = (r << 3) | (r >> 2);
+        c[1] = (g << 2) | (g >> 4);
+        c[2] = (b << 3) | (b >> 2);
+    }
+
+    template<typename T>
+    void writeLittleEndian(uint8_t* dest, T value)
+    {
+        for (size_t i = 0; i < sizeof(T); ++i) dest[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (i * 8));
+    }
+
+    // 8 byte BC1 colour block, always using the 4 colour mode so it's also valid as the colour part of BC3
+    void encodeColorBlock(const Texels& texels, uint8_t* dest)
+    {
+        float e0[4], e1[4];
+        computeEndpoints(texels, 3, e0, e1);
+
+        uint16_t c0 = toRGB565(e0);
+        uint16_t c1 = toRGB565(e1);
+        if (c0 < c1) std::swap(c0, c1);
+
+        uint32_t indices = 0;
+        if (c0 != c1)
+        {
+            int palette[4][3];
+            fromRGB565(c0, palette[0]);
+            fromRGB565(c1, palette[1]);
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (int i = 0; i < 16; ++i)
+            {
+                uint32_t best = 0;
+                int bestError = std::numeric_limits<int>::max();
+                for (uint32_t p = 0; p < 4; ++p)
+                {
+                    int error = 0;
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        int d = texels[i][c] - palette[p][c];
+                        error += d * d;
+                    }
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                indices |= best << (i * 2);
+            }
+        }
+
+        writeLittleEndian(dest, c0);
+        writeLittleEndian(dest + 2, c1);
+        writeLittleEndian(dest + 4, indices);
+    }
+
+    // 8 byte BC4 single channel block, as used for BC3 alpha and each BC5 channel
+    void encodeChannelBlock(const Texels& texels, int channel, uint8_t* dest)
+    {
+        uint8_t a0 = 0, a1 = 255;
+        for (auto& texel : texels)
+        {
+            a0 = std::max(a0, texel[channel]);
+            a1 = std::min(a1, texel[channel]);
+        }
+
+        uint64_t indices = 0;
+        if (a0 != a1)
+        {
+            int palette[8] = {a0, a1};
+            for (int i = 2; i < 8; ++i) palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+
+            for (int i = 0; i < 16; ++i)
+            {
+                uint64_t best = 0;
+                int bestError = std::numeric_limits<int>::max();
+                for (uint64_t p = 0; p < 8; ++p)
+                {
+                    int error = std::abs(texels[i][channel] - palette[p]);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                indices |= best << (i * 3);
+            }
+        }
+
+        dest[0] = a0;
+        dest[1] = a1;
+        for (int i = 0; i < 6; ++i) dest[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+
+    struct BitWriter
+    {
+        uint8_t* dest;
+        uint32_t position = 0;
+
+        void write(uint32_t value, uint32_t numBits)
+        {
+            for (uint32_t i = 0; i < numBits; ++i, ++position)
+            {
+                if ((value >> i) & 1) dest[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+            }
+        }
+    };
+
+    // 16 byte BC7 block using mode 6, a single subset with 7 bit RGBA endpoints plus p-bits and 4 bit indices
+    void encodeBC7Block(const Texels& texels, uint8_t* dest)
+    {
+        float e[2][4];
+        computeEndpoints(texels, 4, e[0], e[1]);
+
+        // quantize each endpoint to 7 bits plus a shared p-bit, picking the p-bit that gives the smallest error
+        uint32_t quantized[2][4];
+        uint32_t pbits[2];
+        int endpoints[2][4];
+        for (int ep = 0; ep < 2; ++ep)
+        {
+            float bestError = std::numeric_limits<float>::max();
+            for (uint32_t p = 0; p < 2; ++p)
+            {
+                float error = 0.0f;
+                uint32_t q[4];
+                for (int c = 0; c < 4; ++c)
+                {
+                    q[c] = static_cast<uint32_t>(std::clamp(static_cast<int>((e[ep][c] - static_cast<float>(p)) * 0.5f + 0.5f), 0, 127));
+                    float d = static_cast<float>((q[c] << 1) | p) - e[ep][c];
+                    error += d * d;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    pbits[ep] = p;
+                    for (int c = 0; c < 4; ++c) quantized[ep][c] = q[c];
+                }
+            }
+            for (int c = 0; c < 4; ++c) endpoints[ep][c] = static_cast<int>((quantized[ep][c] << 1) | pbits[ep]);
+        }
+
+        static const int weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+        int palette[16][4];
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 4; ++c) palette[i][c] = ((64 - weights[i]) * endpoints[0][c] + weights[i] * endpoints[1][c] + 32) >> 6;
+        }
+
+        uint32_t indices[16];
+        for (int i = 0; i < 16; ++i)
+        {
+            int bestError = std::numeric_limits<int>::max();
+            for (uint32_t p = 0; p < 16; ++p)
+            {
+                int error = 0;
+                for (int c = 0; c < 4; ++c)
+                {
+                    int d = texels[i][c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    indices[i] = p;
+                }
+            }
+        }
+
+        // the most significant bit of the anchor index is implicitly 0, so swap the endpoints if required
+        if (indices[0] >= 8)
+        {
+            std::swap(quantized[0], quantized[1]);
+            std::swap(pbits[0], pbits[1]);
+            for (auto& index : indices) index = 15 - index;
+        }
+
+        std::memset(dest, 0, 16);
+        BitWriter bits{dest};
+        bits.write(1 << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            bits.write(quantized[0][c], 7);
+            bits.write(quantized[1][c], 7);
+        }
+        bits.write(pbits[0], 1);
+        bits.write(pbits[1], 1);
+        bits.write(indices[0], 3);
+        for (int i = 1; i < 16; ++i) bits.write(indices[i], 4);
+    }
+
+    uint32_t blockSize(vsgconv::BlockCompression compression)
+    {
+        return (compression == vsgconv::BlockCompression::BC1) ? 8 : 16;
+    }
+
+    void encodeBlockRow(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, uint32_t blocksX, uint32_t by, vsgconv::BlockCompression compression, uint8_t* dest)
+    {
+        for (uint32_t bx = 0; bx < blocksX; ++bx)
+        {
+            auto texels = gatherBlock(rgba.data(), width, height, bx, by);
+            switch (compression)
+            {
+            case vsgconv::BlockCompression::BC1:
+                encodeColorBlock(texels, dest);
+                break;
+            case vsgconv::BlockCompression::BC3:
+                encodeChannelBlock(texels, 3, dest);
+                encodeColorBlock(texels, dest + 8);
+                break;
+            case vsgconv::BlockCompression::BC5:
+                encodeChannelBlock(texels, 0, dest);
+                encodeChannelBlock(texels, 1, dest + 8);
+                break;
+            case vsgconv::BlockCompression::BC7:
+                encodeBC7Block(texels, dest);
+                break;
+            default:
+                break;
+            }
+            dest += blockSize(compression);
+        }
+    }
+
+    // rows of blocks are independent, so are handed out to the threads through an atomic counter, each thread writing its rows directly to their place in dest.
+    void encodeBlocks(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, uint32_t blocksX, uint32_t blocksY, vsgconv::BlockCompression compression, uint8_t* dest, uint32_t numThreads)
+    {
+        const size_t rowSize = static_cast<size_t>(blocksX) * blockSize(compression);
+        std::atomic_uint32_t nextRow = 0;
+        auto encodeRows = [&]() {
+            for (uint32_t by = nextRow++; by < blocksY; by = nextRow++)
+            {
+                encodeBlockRow(rgba, width, height, blocksX, by, compression, dest + by * rowSize);
+            }
+        };
+
+        numThreads = std::min(numThreads, blocksY);
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < numThreads; ++i) threads.emplace_back(encodeRows);
+        encodeRows();
+        for (auto& thread : threads) thread.join();
+    }
+
+    VkFormat compressedFormat(vsgconv::BlockCompression compression, bool srgb)
+    {
+        switch (compression)
+        {
+        case vsgconv::BlockCompression::BC1: return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case vsgconv::BlockCompression::BC3: return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        case vsgconv::BlockCompression::BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+        case vsgconv::BlockCompression::BC7: return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+        default: return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    // number of mipmap levels down to 1x1, limited to the levels where the block counts of each level match the halving of block counts that vsg::Data assumes.
+    uint32_t computeNumLevels(uint32_t width, uint32_t height, bool compressed)
+    {
+        uint32_t numLevels = 1;
+        while ((std::max(width, height) >> numLevels) > 0)
+        {
+            if (compressed)
+            {
+                auto blocks = [](uint32_t size, uint32_t level) { return (std::max(1u, size >> level) + 3) / 4; };
+                if (blocks(width, numLevels) != std::max(1u, (width / 4) >> numLevels) || blocks(height, numLevels) != std::max(1u, (height / 4) >> numLevels)) break;
+            }
+            ++numLevels;
+        }
+        return numLevels;
+    }
+
+    template<typename T>
+    vsg::ref_ptr<vsg::Data> createImage(uint32_t width, uint32_t height, uint8_t* data, const vsg::Data::Properties& properties)
+    {
+        return vsg::Array2D<T>::create(width, height, reinterpret_cast<T*>(data), properties);
+    }
+
+    struct ProcessTextures : public vsg::Visitor
+    {
+        explicit ProcessTextures(const vsgconv::TextureSettings& in_settings) :
+            settings(in_settings) {}
+
+        const vsgconv::TextureSettings& settings;
+        std::map<vsg::ref_ptr<vsg::Data>, vsg::ref_ptr<vsg::Data>> processed;
+
+        void apply(vsg::Object& object) override
+        {
+            object.traverse(*this);
+        }
+
+        void apply(vsg::DescriptorImage& descriptorImage) override
+        {
+            for (auto& imageInfo : descriptorImage.imageInfoList)
+            {
+                if (!imageInfo || !imageInfo->imageView || !imageInfo->imageView->image) continue;
+
+                auto image = imageInfo->imageView->image;
+                if (!image->data) continue;
+
+                // images can be shared between textures, so only process each once
+                auto& processedData = processed[image->data];
+                if (!processedData) processedData = vsgconv::processImage(image->data, settings);
+                if (processedData == image->data) continue;
+
+                const auto& properties = processedData->properties;
+                image->data = processedData;
+                image->format = properties.format;
+                image->mipLevels = properties.maxNumMipmaps;
+                imageInfo->imageView->format = properties.format;
+
+                if (imageInfo->sampler) imageInfo->sampler->maxLod = std::max(imageInfo->sampler->maxLod, static_cast<float>(properties.maxNumMipmaps));
+            }
+        }
+    };
+
+} // namespace
+
+bool vsgconv::readTextureSettings(vsg::CommandLine& arguments, TextureSettings& settings)
+{
+    std::string filter;
+    if (arguments.read("--mipmaps", filter) || arguments.read("--mipmaps"))
+    {
+        if (filter.empty() || filter == "box")
+            settings.mipmapFilter = MipmapFilter::Box;
+        else if (filter == "kaiser")
+            settings.mipmapFilter = MipmapFilter::Kaiser;
+        else
+        {
+            std::cout << "Warning: unsupported --mipmaps filter " << filter << ", use box or kaiser." << std::endl;
+            return false;
+        }
+    }
+
+    std::string compression;
+    if (arguments.read("--compress", compression))
+    {
+        if (compression == "bc1")
+            settings.blockCompression = BlockCompression::BC1;
+        else if (compression == "bc3")
+            settings.blockCompression = BlockCompression::BC3;
+        else if (compression == "bc5")
+            settings.blockCompression = BlockCompression::BC5;
+        else if (compression == "bc7")
+            settings.blockCompression = BlockCompression::BC7;
+        else if (compression == "auto")
+            settings.blockCompression = BlockCompression::Auto;
+        else
+        {
+            std::cout << "Warning: unsupported --compress format " << compression << ", use bc1, bc3, bc5, bc7 or auto." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+vsgconv::TextureSettings vsgconv::resolveTextureSettings(const TextureSettings& settings, const vsg::Path& outputFilename)
+{
+    auto resolved = settings;
+    if (resolved.blockCompression == BlockCompression::Auto)
+    {
+        auto ext = vsg::lowerCaseFileExtension(outputFilename);
+        bool gpuContainer = (ext == ".ktx2" || ext == ".vsgb" || ext == ".vsgt");
+        resolved.blockCompression = gpuContainer ? BlockCompression::BC7 : BlockCompression::None;
+    }
+    return resolved;
+}
+
+vsg::ref_ptr<vsg::Data> vsgconv::processImage(vsg::ref_ptr<vsg::Data> image, const TextureSettings& settings)
+{
+    if (!image || !settings.enabled()) return image;
+
+    const auto& properties = image->properties;
+    const auto components = numComponents(properties.format);
+    if (components == 0 || image->dimensions() != 2 || properties.blockWidth != 1 || properties.blockHeight != 1) return image;
+    if (properties.imageViewType != VK_IMAGE_VIEW_TYPE_2D && properties.imageViewType != VK_IMAGE_VIEW_TYPE_MAX_ENUM) return image;
+
+    const bool srgb = isSRGB(properties.format);
+    const uint32_t width = image->width();
+    const uint32_t height = image->height();
+
+    auto compression = (settings.blockCompression == BlockCompression::Auto) ? BlockCompression::None : settings.blockCompression;
+    if (compression != BlockCompression::None && ((width % 4) != 0 || (height % 4) != 0))
+    {
+        vsg::warn("vsgconv: image dimensions ", width, "x", height, " are not a multiple of 4, leaving uncompressed.");
+        compression = BlockCompression::None;
+    }
+    const bool compressed = compression != BlockCompression::None;
+
+    const uint32_t numLevels = (settings.mipmapFilter != MipmapFilter::None) ? computeNumLevels(width, height, compressed) : 1;
+    if (numLevels == 1 && !compressed) return image;
+
+    size_t totalSize = 0;
+    for (uint32_t level = 0; level < numLevels; ++level)
+    {
+        if (compressed)
+            totalSize += static_cast<size_t>(std::max(1u, (width / 4) >> level)) * std::max(1u, (height / 4) >> level) * blockSize(compression);
+        else
+            totalSize += static_cast<size_t>(std::max(1u, width >> level)) * std::max(1u, height >> level) * components;
+    }
+
+    auto data = static_cast<uint8_t*>(vsg::allocate(totalSize, vsg::ALLOCATOR_AFFINITY_DATA));
+    auto dest = data;
+
+    FloatImage levelImage = toFloat(*image, components, srgb);
+    for (uint32_t level = 0; level < numLevels; ++level)
+    {
+        if (level > 0) levelImage = (settings.mipmapFilter == MipmapFilter::Kaiser) ? downsampleKaiser(levelImage) : downsampleBox(levelImage);
+
+        auto rgba = toBytes(levelImage, srgb);
+        if (compressed)
+        {
+            uint32_t blocksX = std::max(1u, (width / 4) >> level);
+            uint32_t blocksY = std::max(1u, (height / 4) >> level);
+            encodeBlocks(rgba, levelImage.width, levelImage.height, blocksX, blocksY, compression, dest, settings.numThreads);
+            dest += static_cast<size_t>(blocksX) * blocksY * blockSize(compression);
+        }
+        else
+        {
+            for (size_t i = 0; i < levelImage.pixels.size(); ++i)
+            {
+                for (uint32_t c = 0; c < components; ++c) *(dest++) = rgba[i * 4 + c];
+            }
+        }
+    }
+
+    auto layout = properties;
+    layout.maxNumMipmaps = static_cast<uint8_t>(numLevels);
+    if (compressed)
+    {
+        layout.format = compressedFormat(compression, srgb);
+        layout.blockWidth = 4;
+        layout.blockHeight = 4;
+        layout.stride = blockSize(compression);
+
+        if (compression == BlockCompression::BC1) return createImage<vsg::block64>(width / 4, height / 4, data, layout);
+        return createImage<vsg::block128>(width / 4, height / 4, data, layout);
+    }
+
+    layout.stride = components;
+    switch (components)
+    {
+    case 1: return createImage<uint8_t>(width, height, data, layout);
+    case 2: return createImage<vsg::ubvec2>(width, height, data, layout);
+    case 3: return createImage<vsg::ubvec3>(width, height, data, layout);
+    default: return createImage<vsg::ubvec4>(width, height, data, layout);
+    }
+}
+
+void vsgconv::processTextures(vsg::Object& object, const TextureSettings& settings)
+{
+    if (!settings.enabled()) return;
+
+    ProcessTextures processTextures(settings);
+    object.accept(processTextures);
+}
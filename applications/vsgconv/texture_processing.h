@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vsg/core/Data.h>
+#include <vsg/io/Path.h>
+#include <vsg/utils/CommandLine.h>
+
+namespace vsgconv
+{
+    enum class MipmapFilter
+    {
+        None,
+        Box,
+        Kaiser
+    };
+
+    enum class BlockCompression
+    {
+        None,
+        BC1,
+        BC3,
+        BC5,
+        BC7,
+        /// BC7 when writing to a .ktx2, .vsgb or .vsgt file that the GPU can upload directly, otherwise left uncompressed, resolved by resolveTextureSettings().
+        Auto
+    };
+
+    struct TextureSettings
+    {
+        MipmapFilter mipmapFilter = MipmapFilter::None;
+        BlockCompression blockCompression = BlockCompression::None;
+
+        /// number of threads used to encode the blocks of each mipmap level.
+        uint32_t numThreads = 1;
+
+        bool enabled() const { return mipmapFilter != MipmapFilter::None || blockCompression != BlockCompression::None; }
+    };
+
+    /// read the --mipmaps [box|kaiser] and --compress bc1|bc3|bc5|bc7|auto command line options, returning false if an unrecognized value is specified.
+    extern bool readTextureSettings(vsg::CommandLine& arguments, TextureSettings& settings);
+
+    /// return a copy of settings with BlockCompression::Auto replaced by the compression appropriate to the extension of outputFilename.
+    extern TextureSettings resolveTextureSettings(const TextureSettings& settings, const vsg::Path& outputFilename);
+
+    /// generate the mipmap chain of a 2D R8, R8G8, R8G8B8 or R8G8B8A8 image and/or encode it to BC blocks, returning the original image if it can't be processed.
+    extern vsg::ref_ptr<vsg::Data> processImage(vsg::ref_ptr<vsg::Data> image, const TextureSettings& settings);
+
+    /// process the images of all the DescriptorImage in the scene graph, updating the vsg::Image, vsg::ImageView and vsg::Sampler settings to match.
+    extern void processTextures(vsg::Object& object, const TextureSettings& settings);
+
+} // namespace vsgconv
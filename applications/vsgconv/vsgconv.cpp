@@ -1,12 +1,27 @@
 #include <vsg/all.h>
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <ostream>
+#include <set>
 #include <thread>
 
 #include <vsgXchange/Version.h>
 #include <vsgXchange/all.h>
+#include <vsgXchange/archive.h>
+#include <vsgXchange/mesh_optimizer.h>
+#include <vsgXchange/write_queue.h>
+
+#include "batch_conversion.h"
+#include "conversion_stats.h"
+#include "scene_partitioning.h"
+#include "texture_processing.h"
 
 namespace vsgconv
 {
@@ -19,18 +34,43 @@ namespace vsgconv
         (std::cout << ... << args) << std::endl;
     }
 
-    void writeAndMakeDirectoryIfRequired(vsg::ref_ptr<vsg::Object> object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options)
+    bool writeAndMakeDirectoryIfRequired(vsg::ref_ptr<vsg::Object> object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options)
     {
-        vsg::Path path = vsg::filePath(filename);
+        // members of a .vsga archive are written within the archive's file, so it's the archive's directory that's required
+        vsg::Path archiveFilename, member;
+        vsg::Path path = vsg::filePath(vsgXchange::archive::split(filename, archiveFilename, member) ? archiveFilename : filename);
         if (path && !vsg::fileExists(path))
         {
             if (!vsg::makeDirectory(path))
             {
                 log("Warning: could not create directory for ", path);
-                return;
+                return false;
             }
         }
-        vsg::write(object, filename, options);
+        return vsg::write(object, filename, options);
+    }
+
+    /// close the vsgXchange::archive ReaderWriters, writing the index of the .vsga archives written by the conversion, returning false if any failed.
+    bool closeArchives(const vsg::ReaderWriters& readerWriters)
+    {
+        bool result = true;
+        for (auto& rw : readerWriters)
+        {
+            if (auto archive = rw.cast<vsgXchange::archive>())
+                result = archive->close() && result;
+            else if (auto composite = rw.cast<vsg::CompositeReaderWriter>())
+                result = closeArchives(composite->readerWriters) && result;
+        }
+        return result;
+    }
+
+    /// return the size of a file, or 0 if it can't be opened.
+    uint64_t fileSize(const vsg::Path& filename)
+    {
+        std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+        if (!fin) return 0;
+        auto size = fin.tellg();
+        return size > 0 ? static_cast<uint64_t>(size) : 0;
     }
 
     struct ReadRequest
@@ -79,55 +119,549 @@ namespace vsgconv
         }
     };
 
-    struct ReadOperation : public vsg::Inherit<vsg::Operation, ReadOperation>
+    /// append only record of the PagedLOD tiles written by an export, so an interrupted export can be resumed.
+    /// Each tile is recorded along with the children it references once it has been completely written, so a tile that is missing from the journal,
+    /// or whose file no longer matches the recorded size, was partially written and is converted again, while a complete tile is skipped without reading its source.
+    class ExportJournal
     {
-        ReadOperation(vsg::observer_ptr<vsg::OperationQueue> in_queue, vsg::ref_ptr<vsg::Latch> in_latch, ReadRequest in_readRequest, size_t in_level, size_t in_max_level) :
-            level(in_level),
-            max_level(in_max_level),
-            queue(in_queue),
-            latch(in_latch),
-            readRequest(in_readRequest)
+    public:
+        struct Tile
         {
+            uint64_t size = 0;
+            std::vector<std::pair<vsg::Path, vsg::Path>> children; // src_filename, dest_filename
+        };
+
+        /// read the tiles recorded by a previous export, returns false if there is no valid journal.
+        bool read(const vsg::Path& filename)
+        {
+            std::ifstream fin(filename);
+            if (!fin) return false;
+
+            std::string line;
+            if (!std::getline(fin, line) || line != "vsgconv journal 1") return false;
+
+            // children precede the tile that references them, so children left by a tile that was interrupted before being recorded are discarded
+            Tile tile;
+            while (std::getline(fin, line))
+            {
+                auto pos = line.find(' ');
+                if (pos == std::string::npos) continue;
+
+                auto key = line.substr(0, pos);
+                auto value = line.substr(pos + 1);
+                if (key == "child")
+                {
+                    auto separator = value.find('\t');
+                    if (separator == std::string::npos) continue;
+                    tile.children.emplace_back(vsg::Path(value.substr(0, separator)), vsg::Path(value.substr(separator + 1)));
+                }
+                else if (key == "tile")
+                {
+                    auto size_end = value.find(' ');
+                    if (size_end == std::string::npos) continue;
+
+                    tile.size = std::stoull(value.substr(0, size_end), nullptr, 16);
+                    _tiles[vsg::Path(value.substr(size_end + 1))] = std::move(tile);
+                    tile = {};
+                }
+            }
+            return true;
         }
 
-        void run() override
+        /// open the journal for appending, keeping the tiles already recorded when resuming.
+        bool open(const vsg::Path& filename, bool resume)
+        {
+            std::scoped_lock<std::mutex> lock(_mutex);
+
+            bool append = resume && !_tiles.empty();
+            _fout.open(filename, append ? std::ios::app : std::ios::trunc);
+            if (!_fout) return false;
+
+            if (!append) _fout << "vsgconv journal 1\n";
+            _fout << std::hex;
+            _fout.flush();
+            return _fout.good();
+        }
+
+        /// return true if the tile was completely written by a previous export, filling in the children it references.
+        bool complete(const vsg::Path& dest_filename, Tile& tile)
         {
-            auto vsg_scene = vsg::read(readRequest.src_filename, readRequest.options);
-            if (vsg_scene)
             {
-                log("   loaded ", readRequest.src_filename, ", writing to ", readRequest.dest_filename, ", level ", level);
+                std::scoped_lock<std::mutex> lock(_mutex);
+                auto itr = _tiles.find(dest_filename);
+                if (itr == _tiles.end()) return false;
+                tile = itr->second;
+            }
+            return tile.size > 0 && fileSize(dest_filename) == tile.size;
+        }
 
-                vsgconv::CollectReadRequests collectReadRequests;
-                if (level < max_level && collectReadRequests(*vsg_scene, readRequest.dest_filename))
+        /// record a tile once it has been completely written, flushing the journal so it survives the process being killed.
+        void record(const vsg::Path& dest_filename, uint64_t size, const std::map<vsg::Path, ReadRequest>& children)
+        {
+            std::scoped_lock<std::mutex> lock(_mutex);
+            if (!_fout) return;
+
+            for (auto& entry : children)
+            {
+                _fout << "child " << entry.second.src_filename.string() << "\t" << entry.second.dest_filename.string() << "\n";
+            }
+            _fout << "tile " << size << " " << dest_filename.string() << "\n";
+            _fout.flush();
+        }
+
+    protected:
+        std::mutex _mutex;
+        std::map<vsg::Path, Tile> _tiles;
+        std::ofstream _fout;
+    };
+
+    /// schedules the ReadRequest of a PagedLOD hierarchy across worker threads, each with its own deque of requests that it processes last in first out,
+    /// so subtrees are completed depth first and the number of pending requests grows with the depth of the hierarchy rather than its breadth.
+    /// Idle workers steal the oldest request from the front of another worker's deque, which being nearest the root covers the largest subtree.
+    /// Once maxPending requests are queued, workers read the children of a tile themselves rather than queuing them, bounding memory use.
+    /// When a journal is assigned, tiles it records as complete are skipped and each tile written is recorded.
+    class ReadScheduler
+    {
+    public:
+        ReadScheduler(size_t in_numThreads, size_t in_maxLevel, size_t in_maxPending, const TextureSettings& in_textureSettings) :
+            maxLevel(in_maxLevel),
+            maxPending(std::max(size_t(1), in_maxPending)),
+            textureSettings(in_textureSettings)
+        {
+            for (size_t i = 0; i < std::max(size_t(1), in_numThreads); ++i) workers.emplace_back(std::make_unique<Worker>());
+        }
+
+        ExportJournal* journal = nullptr;
+
+        /// interval in seconds between reports of progress and throughput, 0 disables reporting.
+        double progressInterval = 10.0;
+
+        /// read, process and write the requested tiles and all their descendants up to maxLevel, returning once they have all been written.
+        void run(const std::map<vsg::Path, ReadRequest>& readRequests, size_t level)
+        {
+            size_t index = 0;
+            for (auto& entry : readRequests)
+            {
+                push(index, Task{entry.second, level});
+                index = (index + 1) % workers.size();
+            }
+
+            auto startTime = vsg::clock::now();
+
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < workers.size(); ++i)
+            {
+                threads.emplace_back([this, i]() { work(i); });
+            }
+
+            auto reportTime = startTime;
+            while (numOutstanding > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+                auto time = vsg::clock::now();
+                if (progressInterval > 0.0 && std::chrono::duration<double>(time - reportTime).count() >= progressInterval)
                 {
-                    vsg::ref_ptr<vsg::OperationQueue> ref_queue = queue;
+                    reportProgress(std::chrono::duration<double>(time - startTime).count());
+                    reportTime = time;
+                }
+            }
 
-                    for (auto itr = collectReadRequests.readRequests.begin(); itr != collectReadRequests.readRequests.end(); ++itr)
-                    {
-                        latch->count_up();
+            for (auto& thread : threads) thread.join();
 
-                        ref_queue->add(vsgconv::ReadOperation::create(queue, latch, itr->second, level + 1, max_level));
-                    }
+            reportProgress(std::chrono::duration<double>(vsg::clock::now() - startTime).count());
+        }
+
+    protected:
+        struct Task
+        {
+            ReadRequest readRequest;
+            size_t level = 0;
+        };
+
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        size_t maxLevel = 0;
+        size_t maxPending = 4096;
+        TextureSettings textureSettings;
+
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        // number of tasks queued, and queued or being processed
+        std::atomic_size_t numQueued{0};
+        std::atomic_size_t numOutstanding{0};
+
+        std::mutex idleMutex;
+        std::condition_variable idleCondition;
+
+        // progress of the export
+        std::atomic_size_t numWritten{0};
+        std::atomic_size_t numSkipped{0};
+        std::atomic_size_t numFailed{0};
+        std::atomic_uint64_t bytesWritten{0};
+
+        void reportProgress(double duration) const
+        {
+            size_t written = numWritten;
+            double megabytes = static_cast<double>(bytesWritten.load()) / (1024.0 * 1024.0);
+            double tilesPerSecond = duration > 0.0 ? static_cast<double>(written) / duration : 0.0;
+            double megabytesPerSecond = duration > 0.0 ? megabytes / duration : 0.0;
+
+            log("   progress: ", written, " tiles written (", tilesPerSecond, " tiles/s, ", megabytesPerSecond, " MB/s), ",
+                numSkipped.load(), " skipped, ", numFailed.load(), " failed, ", numQueued.load(), " queued, ", duration, "s elapsed");
+        }
+
+        void push(size_t index, Task task)
+        {
+            ++numOutstanding;
+            ++numQueued;
+            {
+                std::scoped_lock<std::mutex> lock(workers[index]->mutex);
+                workers[index]->tasks.push_back(std::move(task));
+            }
+            idleCondition.notify_one();
+        }
+
+        bool pop(size_t index, Task& task)
+        {
+            // take the most recent task from this worker's own deque so its subtrees are completed depth first
+            {
+                auto& worker = *workers[index];
+                std::scoped_lock<std::mutex> lock(worker.mutex);
+                if (!worker.tasks.empty())
+                {
+                    task = std::move(worker.tasks.back());
+                    worker.tasks.pop_back();
+                    --numQueued;
+                    return true;
                 }
+            }
 
-                vsgconv::writeAndMakeDirectoryIfRequired(vsg_scene, readRequest.dest_filename, readRequest.options);
+            // steal the oldest task from another worker
+            for (size_t i = 1; i < workers.size(); ++i)
+            {
+                auto& victim = *workers[(index + i) % workers.size()];
+                std::scoped_lock<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty())
+                {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    --numQueued;
+                    return true;
+                }
             }
+            return false;
+        }
+
+        void work(size_t index)
+        {
+            while (true)
+            {
+                Task task;
+                if (pop(index, task))
+                {
+                    process(index, task);
+                    if (--numOutstanding == 0) idleCondition.notify_all();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(idleMutex);
+                if (numOutstanding == 0) return;
+
+                // the timeout covers tasks pushed between pop() failing and waiting
+                idleCondition.wait_for(lock, std::chrono::milliseconds(10));
+            }
+        }
+
+        void schedule(size_t index, Task child)
+        {
+            if (numQueued < maxPending)
+                push(index, std::move(child));
             else
+                process(index, child);
+        }
+
+        void process(size_t index, const Task& task)
+        {
+            auto& readRequest = task.readRequest;
+
+            ExportJournal::Tile tile;
+            if (journal && journal->complete(readRequest.dest_filename, tile))
+            {
+                ++numSkipped;
+                if (task.level >= maxLevel) return;
+
+                for (auto& [src_filename, dest_filename] : tile.children)
+                {
+                    schedule(index, Task{ReadRequest{readRequest.options, src_filename, dest_filename}, task.level + 1});
+                }
+                return;
+            }
+
+            auto vsg_scene = vsg::read(readRequest.src_filename, readRequest.options);
+            if (!vsg_scene)
             {
                 log("   failed to read ", readRequest.src_filename);
+                ++numFailed;
+                return;
+            }
+
+            log("   loaded ", readRequest.src_filename, ", writing to ", readRequest.dest_filename, ", level ", task.level);
+
+            processTextures(*vsg_scene, textureSettings);
+
+            vsgconv::CollectReadRequests collectReadRequests;
+            bool hasChildren = task.level < maxLevel && collectReadRequests(*vsg_scene, readRequest.dest_filename);
+
+            // write the tile before its children are read so it isn't held in memory while its subtree is processed
+            bool written = vsgconv::writeAndMakeDirectoryIfRequired(vsg_scene, readRequest.dest_filename, readRequest.options);
+            vsg_scene = {};
+
+            if (written)
+            {
+                auto size = fileSize(readRequest.dest_filename);
+                ++numWritten;
+                bytesWritten += size;
+                if (journal) journal->record(readRequest.dest_filename, size, collectReadRequests.readRequests);
             }
+            else
+            {
+                log("   failed to write ", readRequest.dest_filename);
+                ++numFailed;
+            }
+
+            if (!hasChildren) return;
+
+            for (auto& entry : collectReadRequests.readRequests)
+            {
+                schedule(index, Task{entry.second, task.level + 1});
+            }
+        }
+    };
 
-            // we have finished this read operation so decrement the latch, which will release any threads waiting on it.
+    struct TilePyramid : public vsg::Inherit<vsg::Object, TilePyramid>
+    {
+        vsg::Path src_filename;
+        vsg::Path dest_filename;
+        vsg::Path tiles_path;
+        vsg::ref_ptr<const vsg::Options> options;
+        vsg::ref_ptr<vsgXchange::WriteQueue> writeQueue;
+        TextureSettings textureSettings;
+
+        int rasterWidth = 0;
+        int rasterHeight = 0;
+        double geoTransform[6] = {0.0, 1.0, 0.0, 0.0, 0.0, -1.0};
+
+        int tileSize = 256;
+        int maxLevel = 0;
+        int leafPixels = 256; // raster pixels covered by the width of a tile at maxLevel
+        double minimumScreenHeightRatio = 0.5;
+
+        bool setUp(const vsg::Path& in_src_filename, const vsg::Path& in_dest_filename, vsg::ref_ptr<const vsg::Options> in_options, int in_tileSize, int levels)
+        {
+            src_filename = in_src_filename;
+            dest_filename = in_dest_filename;
+            tileSize = std::max(1, in_tileSize);
+
+            // tiles are read directly as images, so don't retain them in the shared objects cache.
+            auto tileOptions = vsg::Options::create(*in_options);
+            tileOptions->sharedObjects = {};
+            options = tileOptions;
+
+            // read a single pixel to get the dimensions and georeferencing of the raster without loading it
+            auto readOptions = vsg::Options::create(*tileOptions);
+            readOptions->setValue(vsgXchange::GDAL::window, vsg::ivec4(0, 0, 1, 1));
+
+            auto pixel = vsg::read_cast<vsg::Data>(src_filename, readOptions);
+            if (!pixel || !pixel->getValue("RasterXSize", rasterWidth) || !pixel->getValue("RasterYSize", rasterHeight))
+            {
+                log("Warning: unable to read raster dimensions from ", src_filename, ", pyramid generation requires GDAL support.");
+                return false;
+            }
+
+            if (auto transform = pixel->getObject<vsg::doubleArray>("GeoTransform"); transform && transform->size() == 6)
+            {
+                for (int i = 0; i < 6; ++i) geoTransform[i] = transform->at(i);
+            }
+
+            // add levels until the highest resolution tiles map one to one with the raster pixels
+            int fullLevels = 0;
+            while ((static_cast<int64_t>(tileSize) << fullLevels) < std::max(rasterWidth, rasterHeight)) ++fullLevels;
+
+            // when the depth is capped the root still covers the whole raster, with each leaf tile covering a larger window downsampled to the tile size
+            maxLevel = (levels > 0) ? std::min(fullLevels, levels) : fullLevels;
+            leafPixels = tileSize << (fullLevels - maxLevel);
+            if (maxLevel < fullLevels) log("Capping pyramid at ", maxLevel + 1, " levels, highest resolution tiles are downsampled by ", (1 << (fullLevels - maxLevel)));
+
+            tiles_path = vsg::simpleFilename(dest_filename) + "_tiles";
+
+            log("Building ", maxLevel + 1, " level pyramid of ", tileSize, "x", tileSize, " tiles from ", rasterWidth, "x", rasterHeight, " raster ", src_filename);
+
+            return true;
+        }
+
+        int tilePixels(int level) const { return leafPixels << (maxLevel - level); }
+
+        bool contains(int level, int x, int y) const
+        {
+            return x * tilePixels(level) < rasterWidth && y * tilePixels(level) < rasterHeight;
+        }
+
+        vsg::Path childrenFilename(int level, int x, int y) const
+        {
+            return tiles_path / vsg::make_string(level + 1) / vsg::make_string(x) / (vsg::make_string(y) + vsg::fileExtension(dest_filename));
+        }
+
+        vsg::dvec3 rasterToLocal(double px, double py) const
+        {
+            return vsg::dvec3(px * geoTransform[1] + py * geoTransform[2], px * geoTransform[4] + py * geoTransform[5], 0.0);
+        }
+
+        vsg::ref_ptr<vsg::Node> createTile(int level, int x, int y) const
+        {
+            int scale = tilePixels(level) / tileSize;
+            int x0 = x * tilePixels(level);
+            int y0 = y * tilePixels(level);
+            int w = std::min(tilePixels(level), rasterWidth - x0);
+            int h = std::min(tilePixels(level), rasterHeight - y0);
+
+            // read just the window covered by this tile, downsampled to the tile resolution, letting GDAL pick the appropriate overview
+            auto readOptions = vsg::Options::create(*options);
+            readOptions->setValue(vsgXchange::GDAL::window, vsg::ivec4(x0, y0, w, h));
+            readOptions->setValue(vsgXchange::GDAL::output_size, vsg::ivec2((w + scale - 1) / scale, (h + scale - 1) / scale));
+
+            auto image = vsg::read_cast<vsg::Data>(src_filename, readOptions);
+            if (!image)
+            {
+                log("   failed to read tile ", level, "/", x, "/", y, " from ", src_filename);
+                return {};
+            }
+
+            // positions are relative to the raster origin, with the absolute origin placed in the root MatrixTransform to retain precision
+            auto center = rasterToLocal(x0 + 0.5 * w, y0 + 0.5 * h);
+            auto dx = rasterToLocal(w, 0.0);
+            auto dy = -rasterToLocal(0.0, h);
+
+            vsg::GeometryInfo geomInfo;
+            geomInfo.position = vsg::vec3(center);
+            geomInfo.dx = vsg::vec3(dx);
+            geomInfo.dy = vsg::vec3(dy);
+
+            vsg::StateInfo stateInfo;
+            stateInfo.lighting = false;
+            stateInfo.image = processImage(image, textureSettings);
+
+            auto builder = vsg::Builder::create();
+            auto quad = builder->createQuad(geomInfo, stateInfo);
+
+            if (level >= maxLevel) return quad;
+
+            auto plod = vsg::PagedLOD::create();
+            plod->bound = vsg::dsphere(center, 0.5 * vsg::length(dx + dy));
+            plod->children[0] = vsg::PagedLOD::Child{minimumScreenHeightRatio, {}};
+            plod->children[1] = vsg::PagedLOD::Child{0.0, quad};
+            plod->filename = childrenFilename(level, x, y);
+            return plod;
+        }
+    };
+
+    struct PyramidOperation : public vsg::Inherit<vsg::Operation, PyramidOperation>
+    {
+        PyramidOperation(vsg::observer_ptr<vsg::OperationQueue> in_queue, vsg::ref_ptr<vsg::Latch> in_latch, vsg::ref_ptr<const TilePyramid> in_pyramid, int in_level, int in_x, int in_y) :
+            level(in_level),
+            x(in_x),
+            y(in_y),
+            queue(in_queue),
+            latch(in_latch),
+            pyramid(in_pyramid)
+        {
+        }
+
+        void run() override
+        {
+            // build the up to 4 child tiles of this tile, each only holding its own window of the raster
+            auto group = vsg::Group::create();
+            for (int j = 0; j < 2; ++j)
+            {
+                for (int i = 0; i < 2; ++i)
+                {
+                    int child_x = x * 2 + i;
+                    int child_y = y * 2 + j;
+                    if (!pyramid->contains(level + 1, child_x, child_y)) continue;
+
+                    if (auto tile = pyramid->createTile(level + 1, child_x, child_y))
+                    {
+                        group->addChild(tile);
+
+                        if (level + 1 < pyramid->maxLevel)
+                        {
+                            vsg::ref_ptr<vsg::OperationQueue> ref_queue = queue;
+
+                            latch->count_up();
+                            ref_queue->add(PyramidOperation::create(queue, latch, pyramid, level + 1, child_x, child_y));
+                        }
+                    }
+                }
+            }
+
+            auto filename = vsg::filePath(pyramid->dest_filename) / pyramid->childrenFilename(level, x, y);
+            log("   writing ", filename, ", level ", level + 1);
+
+            // hand the tiles over to the write queue so this thread can get on with reading the next tiles
+            pyramid->writeQueue->write(group, filename, pyramid->options);
+
+            // we have finished this tile so decrement the latch, which will release any threads waiting on it.
             latch->count_down();
         }
 
-        size_t level;
-        size_t max_level;
+        int level;
+        int x;
+        int y;
         vsg::observer_ptr<vsg::OperationQueue> queue;
         vsg::ref_ptr<vsg::Latch> latch;
-        ReadRequest readRequest;
+        vsg::ref_ptr<const TilePyramid> pyramid;
     };
 
+    int writePyramid(const vsg::Path& src_filename, const vsg::Path& dest_filename, vsg::ref_ptr<const vsg::Options> options, int tileSize, int levels, size_t numThreads, const TextureSettings& textureSettings)
+    {
+        auto pyramid = TilePyramid::create();
+        pyramid->textureSettings = textureSettings;
+        if (!pyramid->setUp(src_filename, dest_filename, options, tileSize, levels)) return 1;
+
+        auto root_tile = pyramid->createTile(0, 0, 0);
+        if (!root_tile) return 1;
+
+        if (pyramid->maxLevel > 0)
+        {
+            pyramid->writeQueue = vsgXchange::WriteQueue::create(std::max(size_t(1), numThreads / 2));
+
+            auto status = vsg::ActivityStatus::create();
+            auto operationThreads = vsg::OperationThreads::create(numThreads, status);
+            auto latch = vsg::Latch::create(1);
+
+            vsg::observer_ptr<vsg::OperationQueue> obs_queue(operationThreads->queue);
+            operationThreads->queue->add(PyramidOperation::create(obs_queue, latch, pyramid, 0, 0, 0));
+
+            // wait until the latch goes to zero i.e. all tiles have been read, then wait for them to be written
+            latch->wait();
+            pyramid->writeQueue->flush();
+
+            // signal that we are finished and the thread should close
+            status->set(false);
+        }
+
+        auto transform = vsg::MatrixTransform::create(vsg::translate(pyramid->geoTransform[0], pyramid->geoTransform[3], 0.0));
+        transform->addChild(root_tile);
+
+        vsgconv::writeAndMakeDirectoryIfRequired(transform, dest_filename, options);
+
+        return 0;
+    }
+
     struct indent
     {
         int chars = 0;
@@ -152,6 +686,13 @@ namespace vsgconv
         return input;
     }
 
+    /// return the className() of the ReaderWriter, or of the ReaderWriter a vsgXchange::LazyReaderWriter stands in for.
+    std::string readerWriterName(const vsg::ReaderWriter& rw)
+    {
+        if (auto lazy = dynamic_cast<const vsgXchange::LazyReaderWriter*>(&rw)) return lazy->implementationClassName;
+        return rw.className();
+    }
+
     void printFeatures(std::ostream& out, vsg::ref_ptr<vsg::ReaderWriter> rw, int indentation = 0)
     {
         if (auto cws = rw.cast<vsg::CompositeReaderWriter>(); cws)
@@ -166,7 +707,7 @@ namespace vsgconv
         {
             vsg::ReaderWriter::Features features;
             rw->getFeatures(features);
-            out << indent{indentation} << rw->className() << " provides support for " << features.extensionFeatureMap.size() << " extensions, and " << features.protocolFeatureMap.size() << " protocols." << std::endl;
+            out << indent{indentation} << readerWriterName(*rw) << " provides support for " << features.extensionFeatureMap.size() << " extensions, and " << features.protocolFeatureMap.size() << " protocols." << std::endl;
 
             indentation += 4;
             bool precedingNewline = false;
@@ -245,7 +786,7 @@ namespace vsgconv
 
     void printMatchedFeatures(std::ostream& out, const std::string& rw_name, vsg::ref_ptr<vsg::ReaderWriter> rw, int indentation = 0)
     {
-        if (rw_name == rw->className())
+        if (rw_name == readerWriterName(*rw))
         {
             printFeatures(out, rw, indentation);
             return;
@@ -267,11 +808,33 @@ void printHelp(std::ostream& out)
     out << "Usage:\n";
     out << "    vsgconv input_filename output_filename\n";
     out << "    vsgconv input_filename_1 input_filename_2 output_filename\n";
+    out << "    vsgconv --batch input_filename|directory|pattern ... output_directory|output_pattern\n";
+    out << "    vsgconv input_filename archive.vsga/output_filename -l levels   # pack the exported PagedLOD tiles into a single .vsga archive\n";
     out << "Options:\n";
     out << "    --features          # list all ReaderWriters and the formats supported\n";
     out << "    --features rw_name  # list formats supported by the specified ReaderWriter\n";
     out << "    --nc --no-compile   # do not compile shaders to SPIRV\n";
     out << "    --rgb               # leave RGB source data in its original form rather than converting to RGBA\n";
+    out << "    --pyramid           # build a PagedLOD tile pyramid from a GDAL raster, reading it a tile at a time\n";
+    out << "    --tile-size size    # the width and height of each pyramid tile, defaults to 256\n";
+    out << "    --mipmaps [filter]  # generate mipmaps for textures on the CPU, filter is box (default) or kaiser\n";
+    out << "    --compress format   # encode textures to GPU block compressed format, bc1, bc3, bc5 or bc7, or auto to use bc7 for .ktx2, .vsgb and .vsgt outputs\n";
+    out << "    --optimize-meshes   # weld vertices and reorder meshes for vertex cache, overdraw and vertex fetch efficiency\n";
+    out << "    --lods levels       # replace meshes with a vsg::LOD of the original and up to levels simplified versions\n";
+    out << "    --lod-error ratio   # maximum error of the first simplified level relative to the mesh size, defaults to 0.005\n";
+    out << "    --partition         # partition the scene into cells written as separate files, paged in by a PagedLOD hierarchy of coarse proxies\n";
+    out << "    --cell-primitives n # maximum number of primitives in each partitioned cell, defaults to 100000\n";
+    out << "    --max-pending n     # maximum number of PagedLOD tiles queued when exporting with -l, defaults to 4096\n";
+    out << "    --resume            # resume an interrupted -l export, skipping the tiles its journal records as completely written\n";
+    out << "    --journal filename  # journal of the tiles written by a -l export, defaults to the output filename with .journal appended\n";
+    out << "    --progress seconds  # interval between reports of -l export progress and throughput, defaults to 10, 0 disables\n";
+    out << "    --batch             # convert each input file, directory or quoted wildcard pattern to its own output file in parallel\n";
+    out << "    --ext extension     # extension of the files written to a --batch output directory, defaults to .vsgb\n";
+    out << "    --match pattern     # wildcard pattern the files found in --batch input directories must match, defaults to *\n";
+    out << "    --incremental       # only convert --batch files whose source, dependencies or options changed since the last run\n";
+    out << "    --manifest filename # manifest of content hashes used by --incremental, defaults to vsgconv.manifest in the output directory\n";
+    out << "    --stats             # report the time, bytes and objects of each stage and ReaderWriter of the conversion once it completes\n";
+    out << "    --stats-json file   # also write the --stats report as JSON to file\n";
     out << "    -v --version        # report version\n";
 }
 
@@ -282,6 +845,9 @@ int main(int argc, char** argv)
     options->paths = vsg::getEnvPaths("VSG_FILE_PATH");
     options->sharedObjects = vsg::SharedObjects::create();
 
+    // keep the original arguments so the options used can be recorded in an incremental conversion's manifest
+    std::vector<std::string> originalArguments(argv + 1, argv + argc);
+
     // set up defaults and read command line arguments to override them
     vsg::CommandLine arguments(&argc, argv);
 
@@ -330,7 +896,64 @@ int main(int argc, char** argv)
 
     auto levels = arguments.value(0, "-l");
     auto numThreads = arguments.value(16, "-t");
+    auto maxPending = arguments.value<size_t>(4096, "--max-pending");
+    bool resume = arguments.read("--resume");
+    auto journalFilename = arguments.value<std::string>("", "--journal");
+    auto progressInterval = arguments.value(10.0, "--progress");
     bool compileShaders = !arguments.read({"--no-compile", "--nc"});
+    bool pyramid = arguments.read("--pyramid");
+    auto tileSize = arguments.value(256, "--tile-size");
+    bool optimizeMeshes = arguments.read("--optimize-meshes");
+    auto lodLevels = arguments.value(0u, "--lods");
+    auto lodError = arguments.value(0.005f, "--lod-error");
+
+    vsgconv::PartitionSettings partitionSettings;
+    bool partition = arguments.read("--partition");
+    arguments.read("--cell-primitives", partitionSettings.maxCellPrimitives);
+    partitionSettings.numThreads = static_cast<uint32_t>(std::max(1, numThreads / 2));
+
+    vsgconv::TextureSettings textureSettings;
+    if (!vsgconv::readTextureSettings(arguments, textureSettings)) return 1;
+
+    vsgconv::BatchSettings batchSettings;
+    bool batch = arguments.read("--batch");
+    arguments.read("--ext", batchSettings.outputExtension);
+    arguments.read("--match", batchSettings.match);
+    batchSettings.incremental = arguments.read("--incremental");
+    if (std::string manifest; arguments.read("--manifest", manifest)) batchSettings.manifest = manifest;
+
+    bool printStats = arguments.read("--stats");
+    auto statsFilename = arguments.value<std::string>("", "--stats-json");
+    vsg::ref_ptr<vsgconv::ConversionStats> stats;
+    if (printStats || !statsFilename.empty())
+    {
+        // observe every read and write dispatched through vsgXchange::all
+        stats = vsgconv::ConversionStats::create();
+        for (auto& rw : options->readerWriters)
+        {
+            if (auto composite = rw.cast<vsgXchange::IndexedCompositeReaderWriter>()) composite->observer = stats;
+        }
+    }
+
+    auto reportStats = [&](int result) {
+        // archives can't be read until their index has been written
+        if (!vsgconv::closeArchives(options->readerWriters))
+        {
+            vsgconv::log("Warning: failed to write the index of a .vsga archive.");
+            result = 1;
+        }
+
+        if (stats)
+        {
+            stats->print(std::cout);
+            if (!statsFilename.empty())
+            {
+                std::ofstream fout(statsFilename);
+                stats->writeJSON(fout);
+            }
+        }
+        return result;
+    };
 
     if (argc <= 2)
     {
@@ -342,6 +965,42 @@ int main(int argc, char** argv)
 
     vsg::Path outputFilename = arguments[argc - 1];
 
+    if (batch)
+    {
+        batchSettings.numThreads = static_cast<uint32_t>(std::max(1, numThreads));
+        batchSettings.compileShaders = compileShaders;
+        batchSettings.optimizeMeshes = optimizeMeshes;
+        batchSettings.lodLevels = lodLevels;
+        batchSettings.lodError = lodError;
+        // files are converted in parallel, so each file's blocks are encoded on its own thread
+        batchSettings.textureSettings = vsgconv::resolveTextureSettings(textureSettings, vsg::Path(batchSettings.outputExtension));
+        batchSettings.stats = stats;
+
+        std::vector<vsg::Path> inputs;
+        for (int i = 1; i < argc - 1; ++i) inputs.emplace_back(arguments[i]);
+
+        // the options are the original arguments that remain once the input and output filenames are removed
+        std::multiset<std::string> filenames(argv + 1, argv + argc);
+        for (auto& argument : originalArguments)
+        {
+            if (auto itr = filenames.find(argument); itr != filenames.end())
+                filenames.erase(itr);
+            else
+                batchSettings.optionsSignature += argument + ' ';
+        }
+
+        return reportStats(vsgconv::convertBatch(inputs, outputFilename, options, batchSettings) == 0 ? 0 : 1);
+    }
+
+    if (pyramid)
+    {
+        // the raster is read a window at a time, so don't load it up front with the other input files
+        return reportStats(vsgconv::writePyramid(arguments[1], outputFilename, options, tileSize, levels, numThreads, vsgconv::resolveTextureSettings(textureSettings, outputFilename)));
+    }
+
+    textureSettings = vsgconv::resolveTextureSettings(textureSettings, outputFilename);
+    textureSettings.numThreads = static_cast<uint32_t>(std::max(1, numThreads));
+
     using VsgObjects = std::vector<vsg::ref_ptr<vsg::Object>>;
     VsgObjects vsgObjects;
 
@@ -350,7 +1009,11 @@ int main(int argc, char** argv)
     {
         vsg::Path filename = arguments[i];
 
-        auto loaded_object = vsg::read(filename, options);
+        vsg::ref_ptr<vsg::Object> loaded_object;
+        {
+            vsgconv::ScopedStage stage(stats, "read");
+            loaded_object = vsg::read(filename, options);
+        }
         if (loaded_object)
         {
             vsgObjects.push_back(loaded_object);
@@ -366,7 +1029,7 @@ int main(int argc, char** argv)
     if (vsgObjects.empty())
     {
         std::cout << "No files loaded." << std::endl;
-        return 1;
+        return reportStats(1);
     }
 
     if (options->sharedObjects && options->sharedObjects->contains(outputFilename, options))
@@ -397,6 +1060,13 @@ int main(int argc, char** argv)
     if (numImages == vsgObjects.size())
     {
         // all images
+        {
+            vsgconv::ScopedStage stage(stats, "process textures");
+            for (auto& object : vsgObjects)
+            {
+                object = vsgconv::processImage(object.cast<vsg::Data>(), textureSettings);
+            }
+        }
         vsg::ref_ptr<vsg::Node> vsg_scene;
 
         if (numImages == 1)
@@ -448,6 +1118,7 @@ int main(int argc, char** argv)
 
             if (!stagesToCompile.empty())
             {
+                vsgconv::ScopedStage stage(stats, "compile shaders");
                 auto shaderCompiler = vsg::ShaderCompiler::create();
                 shaderCompiler->compile(stagesToCompile);
             }
@@ -481,8 +1152,45 @@ int main(int argc, char** argv)
             vsg_scene = group;
         }
 
-        auto shaderCompiler = vsg::ShaderCompiler::create();
-        vsg_scene->accept(*shaderCompiler);
+        {
+            vsgconv::ScopedStage stage(stats, "compile shaders");
+            auto shaderCompiler = vsg::ShaderCompiler::create();
+            vsg_scene->accept(*shaderCompiler);
+        }
+
+        {
+            vsgconv::ScopedStage stage(stats, "process textures");
+            vsgconv::processTextures(*vsg_scene, textureSettings);
+        }
+
+        if (optimizeMeshes)
+        {
+            vsgconv::ScopedStage stage(stats, "optimize meshes");
+            auto optimize = vsgXchange::OptimizeMeshes::create();
+            vsg_scene->accept(*optimize);
+            vsgconv::log("optimized ", optimize->numOptimized, " meshes");
+        }
+
+        if (lodLevels > 0)
+        {
+            vsgconv::ScopedStage stage(stats, "generate LODs");
+            auto generateLODs = vsgXchange::GenerateLODs::create();
+            generateLODs->numLevels = lodLevels;
+            generateLODs->errorThreshold = lodError;
+            vsg_scene->accept(*generateLODs);
+            vsgconv::log("created ", generateLODs->numLODs, " LODs");
+        }
+
+        if (stats) stats->countObjects(*vsg_scene);
+
+        if (partition)
+        {
+            vsgconv::ScopedStage stage(stats, "partition");
+            if (auto partitioned = vsgconv::partitionScene(vsg_scene, outputFilename, options, partitionSettings))
+                vsg_scene = partitioned;
+            else
+                vsgconv::log("Warning: unable to partition scene, writing it to a single file.");
+        }
 
         vsgconv::CollectReadRequests collectReadRequests;
 
@@ -490,23 +1198,36 @@ int main(int argc, char** argv)
         {
             vsgconv::writeAndMakeDirectoryIfRequired(vsg_scene, outputFilename, options);
 
-            auto status = vsg::ActivityStatus::create();
-            auto operationThreads = vsg::OperationThreads::create(numThreads, status);
-            auto operationQueue = operationThreads->queue;
-            auto latch = vsg::Latch::create(collectReadRequests.readRequests.size());
+            // an archive is rewritten by each export, so exports to an archive can't be resumed
+            vsg::Path archiveFilename, member;
+            bool toArchive = vsgXchange::archive::split(outputFilename, archiveFilename, member);
+            if (toArchive && resume) vsgconv::log("Warning: exports to the archive ", archiveFilename, " can't be resumed, exporting all tiles.");
 
-            vsg::observer_ptr<vsg::OperationQueue> obs_queue(operationQueue);
+            vsg::Path journalPath = journalFilename.empty() ? (outputFilename + ".journal") : vsg::Path(journalFilename);
 
-            for (auto itr = collectReadRequests.readRequests.begin(); itr != collectReadRequests.readRequests.end(); ++itr)
+            vsgconv::ExportJournal journal;
+            if (resume && !toArchive)
             {
-                operationQueue->add(vsgconv::ReadOperation::create(obs_queue, latch, itr->second, 1, levels));
+                if (journal.read(journalPath))
+                    vsgconv::log("resuming export recorded in ", journalPath);
+                else
+                    vsgconv::log("Warning: no journal found at ", journalPath, ", exporting all tiles.");
             }
 
-            // wait until the latch goes to zero i.e. all read operations have completed
-            latch->wait();
+            // tiles are read and processed in parallel by the scheduler's workers, so encode each tile's blocks on a single thread
+            auto tileTextureSettings = textureSettings;
+            tileTextureSettings.numThreads = 1;
+            vsgconv::ReadScheduler scheduler(numThreads, levels, maxPending, tileTextureSettings);
+            scheduler.progressInterval = progressInterval;
+            if (toArchive)
+                scheduler.journal = nullptr;
+            else if (journal.open(journalPath, resume))
+                scheduler.journal = &journal;
+            else
+                vsgconv::log("Warning: unable to write journal ", journalPath, ", the export won't be resumable.");
 
-            // signal that we are finished and the thread should close
-            status->set(false);
+            vsgconv::ScopedStage stage(stats, "export tiles");
+            scheduler.run(collectReadRequests.readRequests, 1);
         }
         else
         {
@@ -533,5 +1254,5 @@ int main(int argc, char** argv)
         }
     }
 
-    return 0;
+    return reportStats(0);
 }
@@ -25,6 +25,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <vsg/io/ReaderWriter.h>
 #include <vsgXchange/Version.h>
+#include <vsgXchange/composite.h>
+
+#include <functional>
+#include <mutex>
 
 namespace vsgXchange
 {
@@ -32,12 +36,56 @@ namespace vsgXchange
     /// so that any serialization that includes vsgXchange ReaderWriters will be able to load them.
     extern VSGXCHANGE_DECLSPEC void init();
 
+    /// ReaderWriter proxy that defers creating the ReaderWriter it stands in for until a file with one of the extensions listed in its features, or with no extension, is read or written,
+    /// answering getFeatures() from those features so that libraries with costly initialization, such as GDAL and assimp, aren't set up by applications that never use them.
+    /// Streams and memory blocks are matched against the vsg::Options::extensionHint, and readOptions() only creates the ReaderWriter when the arguments include one of its options.
+    class VSGXCHANGE_DECLSPEC LazyReaderWriter : public vsg::Inherit<vsg::ReaderWriter, LazyReaderWriter>
+    {
+    public:
+        using CreateFunction = std::function<vsg::ref_ptr<vsg::ReaderWriter>()>;
+
+        LazyReaderWriter(const std::string& in_implementationClassName, const Features& in_features, CreateFunction in_create);
+
+        /// className() of the ReaderWriter that is created.
+        const std::string implementationClassName;
+
+        vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+        vsg::ref_ptr<vsg::Object> read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+        vsg::ref_ptr<vsg::Object> read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
+        bool write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+        bool write(const vsg::Object* object, std::ostream& fout, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
+        bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
+
+        bool getFeatures(Features& features) const override;
+
+        /// return the ReaderWriter, creating it on the first call.
+        vsg::ref_ptr<vsg::ReaderWriter> implementation() const;
+
+        /// return true if the ReaderWriter has been created.
+        bool created() const;
+
+    protected:
+        bool supported(const vsg::Path& ext, FeatureMask mask) const;
+
+        /// return true if filename's extension, or the options->extensionHint when it has none, is supported. Filenames with neither are passed through to the ReaderWriter.
+        bool supportedFilename(const vsg::Path& filename, const vsg::Options* options, FeatureMask mask) const;
+
+        Features _features;
+        CreateFunction _create;
+
+        mutable std::mutex _mutex;
+        mutable vsg::ref_ptr<vsg::ReaderWriter> _implementation;
+    };
+
     /// ReaderWriter that has all the ReaderWriter implementations that vsgXchange provides.
-    class VSGXCHANGE_DECLSPEC all : public vsg::Inherit<vsg::CompositeReaderWriter, all>
+    class VSGXCHANGE_DECLSPEC all : public vsg::Inherit<IndexedCompositeReaderWriter, all>
     {
     public:
         all();
     };
 } // namespace vsgXchange
 
+EVSG_type_name(vsgXchange::LazyReaderWriter);
 EVSG_type_name(vsgXchange::all);
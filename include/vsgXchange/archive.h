@@ -0,0 +1,73 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/io/ReaderWriter.h>
+#include <vsgXchange/Version.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace vsgXchange
+{
+    /// ReaderWriter for .vsga archives that pack the many small files of a paged database, such as the tiles written by vsgconv -l, into a single file to avoid the per file overhead of the filesystem.
+    /// Members are addressed by their path within the archive, such as archive.vsga/tiles/12/34.vsgb, and are looked up in a hashed index at the end of the archive.
+    /// Archives are memory mapped when first read, so reading a member is an index lookup followed by reading its slice of the mapping through the memory read path,
+    /// with the member's directory within the archive prepended to the Options::paths so relative filenames, such as those of PagedLOD children, resolve to members of the same archive.
+    /// Writing an object to a member serializes it according to the member's extension and appends it, creating the archive on the first write to it by this ReaderWriter.
+    /// The index is written by close(), or when the ReaderWriter is destroyed, until then the archive can't be read.
+    class VSGXCHANGE_DECLSPEC archive : public vsg::Inherit<vsg::ReaderWriter, archive>
+    {
+    public:
+        archive();
+
+        vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
+        bool write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
+        bool getFeatures(Features& features) const override;
+
+        /// write the index of each archive written by this ReaderWriter and close them, returning false if any of them failed.
+        bool close();
+
+        /// split a filename within an archive, such as archive.vsga/tiles/12/34.vsgb, into the filename of the archive and the path of the member within it, returning false if it isn't within an archive.
+        static bool split(const vsg::Path& filename, vsg::Path& archiveFilename, vsg::Path& member);
+
+    protected:
+        virtual ~archive();
+
+        class Reader;
+        class Writer;
+
+        vsg::ref_ptr<vsg::Object> readMember(const vsg::Path& archiveFilename, const vsg::Path& member, vsg::ref_ptr<const vsg::Options> options) const;
+
+        mutable std::mutex _mutex;
+        mutable std::map<vsg::Path, std::shared_ptr<Reader>> _readers;
+        mutable std::map<vsg::Path, std::shared_ptr<Writer>> _writers;
+    };
+
+} // namespace vsgXchange
+
+EVSG_type_name(vsgXchange::archive);
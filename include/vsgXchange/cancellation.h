@@ -0,0 +1,72 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/core/Inherit.h>
+#include <vsg/io/Options.h>
+#include <vsgXchange/Version.h>
+
+#include <atomic>
+
+namespace vsgXchange
+{
+    /// key of the vsg::Options::setObject() entry that holds the CancellationToken of a read.
+    static constexpr const char* cancellation_token = "vsgXchange::cancellation_token";
+
+    /// token carried by the vsg::Options of a read so it can be abandoned while in progress, such as a PagedLOD tile the camera has moved away from before the DatabasePager has loaded it.
+    /// The curl, GDAL, assimp and freetype ReaderWriters poll it at transfer progress, tile, mesh and glyph boundaries and return null once it's cancelled,
+    /// and IndexedCompositeReaderWriter stops offering the read to further ReaderWriters. Assign with setCancellationToken().
+    class VSGXCHANGE_DECLSPEC CancellationToken : public vsg::Inherit<vsg::Object, CancellationToken>
+    {
+    public:
+        CancellationToken() = default;
+        CancellationToken(const CancellationToken& rhs, const vsg::CopyOp& copyop = {});
+
+        /// request cancellation of the reads using this token, may be called from any thread.
+        void cancel() { _cancelled = true; }
+
+        /// return true if the reads using this token should be abandoned. Called from the reading threads, so override with a thread safe test
+        /// to derive cancellation from application state, such as whether the PagedLOD that requested the read is still active.
+        virtual bool cancelled() const { return _cancelled; }
+
+    protected:
+        std::atomic_bool _cancelled{false};
+    };
+
+    /// assign the CancellationToken polled by reads using options, a null token removes it.
+    extern VSGXCHANGE_DECLSPEC void setCancellationToken(vsg::Options& options, vsg::ref_ptr<CancellationToken> token);
+
+    /// return the CancellationToken of options, or null if it doesn't have one.
+    extern VSGXCHANGE_DECLSPEC const CancellationToken* getCancellationToken(const vsg::Options* options);
+
+    /// return true if options has a CancellationToken that has been cancelled.
+    inline bool cancelled(const vsg::Options* options)
+    {
+        auto token = getCancellationToken(options);
+        return token && token->cancelled();
+    }
+
+} // namespace vsgXchange
+
+EVSG_type_name(vsgXchange::CancellationToken);
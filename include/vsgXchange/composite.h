@@ -0,0 +1,84 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/io/ReaderWriter.h>
+#include <vsgXchange/Version.h>
+#include <vsgXchange/data_cache.h>
+#include <vsgXchange/read_write_observer.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vsgXchange
+{
+    /// CompositeReaderWriter that dispatches each read or write to just the child ReaderWriters whose getFeatures() claim the file's extension or protocol,
+    /// rather than trying every child in turn, using an index built from the children's features on first use and rebuilt whenever readerWriters is changed.
+    /// Filenames within a container file, such as the archive.vsga/tiles/12/34.vsgb members of an archive, are also dispatched to the children that claim the container's extension.
+    /// Candidates are tried in the order of readerWriters, and children that report no features are tried for every file.
+    /// Files without an extension, and streams without an Options::extensionHint, are identified by the magic number of PNG, JPEG, KTX/KTX2, DDS, EXR, glTF/GLB, TIFF and vsgb/vsgt data,
+    /// and offered to the children supporting the identified extension with it assigned as the extensionHint, unidentified contents are offered to all children.
+    class VSGXCHANGE_DECLSPEC IndexedCompositeReaderWriter : public vsg::Inherit<vsg::CompositeReaderWriter, IndexedCompositeReaderWriter>
+    {
+    public:
+        /// optional cache of the vsg::Data and vsg::Font read from files, checked before dispatching a read(filename).
+        vsg::ref_ptr<DataCache> dataCache;
+
+        /// optional observer reported the ReaderWriter chosen, bytes in and out and durations of each read and write, null by default so there is no profiling overhead.
+        vsg::ref_ptr<ReadWriteObserver> observer;
+
+        vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+        vsg::ref_ptr<vsg::Object> read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+        vsg::ref_ptr<vsg::Object> read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
+        bool write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+        bool write(const vsg::Object* object, std::ostream& fout, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
+    protected:
+        using Candidates = std::vector<vsg::ref_ptr<vsg::ReaderWriter>>;
+
+        struct Index
+        {
+            std::vector<vsg::ref_ptr<vsg::ReaderWriter>> readerWriters; // snapshot of readerWriters the index was built from
+            std::map<vsg::Path, std::vector<size_t>> extensions;
+            std::map<vsg::Path, std::vector<size_t>> protocols;
+            std::vector<size_t> unindexed;
+
+            /// return the readerWriters at the specified indices in readerWriters order, sorting and removing duplicates from indices.
+            Candidates select(std::vector<size_t>& indices) const;
+        };
+
+        /// dispatch a read of filename to the candidate ReaderWriters, recording the ReaderWriter that read it to event when it's non null.
+        vsg::ref_ptr<vsg::Object> readUncached(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options, ReadWriteEvent* event) const;
+
+        /// return the index, rebuilding it if readerWriters has changed since it was built.
+        std::shared_ptr<const Index> index() const;
+
+        /// return the children that may read or write filename, in readerWriters order.
+        Candidates candidates(const vsg::Path& filename, const vsg::Options* options) const;
+
+        /// return the children that may read or write a stream or block of memory with the specified extension hint, in readerWriters order.
+        Candidates candidatesForExtension(const vsg::Path& ext) const;
+
+        /// return a copy of options with the extensionHint set to the extension identified from a file's contents.
+        static vsg::ref_ptr<const vsg::Options> hintExtension(vsg::ref_ptr<const vsg::Options> options, const vsg::Path& ext);
+
+        mutable std::mutex _indexMutex;
+        mutable std::shared_ptr<const Index> _index;
+    };
+
+} // namespace vsgXchange
+
+EVSG_type_name(vsgXchange::IndexedCompositeReaderWriter);
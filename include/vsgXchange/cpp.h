@@ -40,6 +40,11 @@ namespace vsgXchange
 
         bool getFeatures(Features& features) const override;
 
+        // vsg::Options::setValue(str, value) supported options:
+        static constexpr const char* embed_mode = "embed_mode"; /// std::string, how the serialized object is embedded in the .cpp: "array" (default), "compressed" for an LZ compressed byte array that is decompressed when the generated function is called, or "embed" for a C23/C++26 #embed of a .vsgb/.vsgt file written alongside the .cpp
+
+        bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
+
     protected:
         void write(std::ostream& out, const std::string& str) const;
     };
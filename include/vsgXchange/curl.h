@@ -26,7 +26,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vsg/io/ReaderWriter.h>
 #include <vsgXchange/Export.h>
 
+#include <future>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace vsgXchange
 {
@@ -39,10 +42,57 @@ namespace vsgXchange
         curl();
         vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
 
+        /// asynchronously read a file from http/https, the download is done by a background thread using curl_multi so many requests can be in flight at once,
+        /// with the parsing of the downloaded data done by the thread that calls future.get().
+        std::future<vsg::ref_ptr<vsg::Object>> readAsync(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const;
+
+        /// asynchronously read a batch of files, returning a future for each filename in the same order.
+        std::vector<std::future<vsg::ref_ptr<vsg::Object>>> readAsync(const vsg::Paths& filenames, vsg::ref_ptr<const vsg::Options> options = {}) const;
+
         bool getFeatures(Features& features) const override;
 
         // vsg::Options::setValue(str, value) supported options:
         static constexpr const char* SSL_OPTIONS = "CURLOPT_SSL_OPTIONS"; ///  uint32_t
+        static constexpr const char* SHARE_CONNECTIONS = "CURL_SHARE_CONNECTIONS"; /// bool, share DNS, TLS session and connection caches between requests, defaults to true
+        static constexpr const char* HANDLE_POOL_SIZE = "CURL_HANDLE_POOL_SIZE";   /// uint32_t, maximum number of idle easy handles kept for reuse, 0 disables reuse, defaults to 16
+        static constexpr const char* CACHE_REVALIDATE = "CURL_CACHE_REVALIDATE";   /// bool, revalidate expired fileCache entries using ETag/Last-Modified conditional requests, entries without max-age or Expires are fresh for 10% of their age since Last-Modified (up to a day), defaults to true
+        static constexpr const char* COALESCE_REQUESTS = "CURL_COALESCE_REQUESTS"; /// bool, concurrent blocking and async reads of the same URL with equivalent Options share a single transfer and the resulting object, defaults to true
+        static constexpr const char* TRANSFER_METADATA = "CURL_TRANSFER_METADATA"; /// bool, assign the transfer timings and size to the returned object as "curl_*" values, defaults to false
+        static constexpr const char* ACCEPT_ENCODING = "CURLOPT_ACCEPT_ENCODING"; /// std::string, Accept-Encoding requested from the server, an empty string requests all the encodings libcurl supports and "identity" disables compression, defaults to ""
+        static constexpr const char* CACHE_COMPRESSION = "CURL_CACHE_COMPRESSION"; /// uint32_t, zstd level used to compress fileCache entries, 0 stores them uncompressed, compressed entries are always read, defaults to 0
+        static constexpr const char* DEFER_EXTENSIONS = "CURL_DEFER_EXTENSIONS";   /// std::string, comma separated list of extensions, such as ".tif,.vrt", that curl leaves to other ReaderWriters to read from http/https, for instance GDAL with its vsicurl option, defaults to ""
+        static constexpr const char* PREFETCH = "CURL_PREFETCH";                   /// bool, download the PagedLOD children of each subgraph read in the background, ahead of the DatabasePager requesting them, defaults to false
+        static constexpr const char* PREFETCH_BANDWIDTH = "CURL_PREFETCH_BANDWIDTH"; /// uint64_t, maximum bytes per second shared by the prefetch transfers, 0 for unlimited, defaults to 0
+        static constexpr const char* PREFETCH_MAX_TRANSFERS = "CURL_PREFETCH_MAX_TRANSFERS"; /// uint32_t, maximum number of concurrent prefetch transfers, defaults to 2
+        static constexpr const char* PREFETCH_MAX_PENDING = "CURL_PREFETCH_MAX_PENDING"; /// uint32_t, maximum number of queued prefetch requests, the oldest are discarded first, defaults to 256
+        static constexpr const char* PREFETCH_MEMORY_CACHE = "CURL_PREFETCH_MEMORY_CACHE"; /// uint64_t, bytes of prefetched data held in memory when no Options::fileCache is set, defaults to 64MB
+
+        /// transfer statistics accumulated over all the reads made through this ReaderWriter, times are in seconds.
+        struct Statistics
+        {
+            uint64_t numTransfers = 0;
+            uint64_t numFailedTransfers = 0;
+            uint64_t bytesDownloaded = 0;
+            uint64_t numCacheHits = 0;
+            uint64_t numCacheMisses = 0;
+            uint64_t numCacheRevalidations = 0; /// number of 304 Not Modified responses that reused the file cache entry
+            uint64_t numPrefetches = 0;         /// number of prefetch transfers completed, which are also included in numTransfers
+            uint64_t numPrefetchHits = 0;       /// number of reads satisfied from the in memory prefetch cache
+            double dnsTime = 0.0;
+            double connectTime = 0.0;
+            double tlsTime = 0.0;
+            double timeToFirstByte = 0.0;
+            double totalTime = 0.0;
+        };
+
+        /// discard the queued prefetch requests and abort the prefetch transfers in progress, the data already prefetched is retained.
+        void cancelPrefetch() const;
+
+        /// get a snapshot of the accumulated transfer statistics.
+        Statistics getStatistics() const;
+
+        /// reset the accumulated transfer statistics to zero.
+        void resetStatistics();
 
         /// specify whether libcurl should be initialized and cleaned up by vsgXchange::curl.
         static bool s_do_curl_global_init_and_cleanup; // defaults to true
@@ -51,8 +101,13 @@ namespace vsgXchange
         ~curl();
 
         class Implementation;
+        Implementation* getImplementation() const;
+
         mutable std::mutex _mutex;
         mutable Implementation* _implementation;
+
+        mutable std::mutex _statisticsMutex;
+        mutable Statistics _statistics;
     };
 
 } // namespace vsgXchange
@@ -0,0 +1,104 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+#include <vsg/core/Inherit.h>
+#include <vsg/io/Options.h>
+#include <vsg/io/Path.h>
+#include <vsgXchange/Version.h>
+
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace vsgXchange
+{
+    /// cache of decoded vsg::Data, such as images, and vsg::Font, keyed by the resolved path of the file they were read from along with the options that affect decoding,
+    /// holding up to maxBytes of the vsg::Data they reference and evicting the least recently used entries beyond that.
+    /// Assign to IndexedCompositeReaderWriter::dataCache, i.e. vsgXchange::all, so re-reads of the same textures and fonts are served without decoding again.
+    /// Cached objects are shared between all the callers that read them so must not be modified.
+    class VSGXCHANGE_DECLSPEC DataCache : public vsg::Inherit<vsg::Object, DataCache>
+    {
+    public:
+        explicit DataCache(size_t in_maxBytes = 512 * 1024 * 1024);
+
+        struct Statistics
+        {
+            size_t numHits = 0;
+            size_t numMisses = 0;
+            size_t numEvictions = 0;
+            size_t numEntries = 0;
+            size_t numBytes = 0;
+        };
+
+        /// return the cached object read from filename with compatible options, or null if it isn't cached.
+        vsg::ref_ptr<vsg::Object> get(const vsg::Path& filename, const vsg::Options* options);
+
+        /// add an object read from filename with the specified options to the cache, returns false if the object isn't cacheable or is larger than maxBytes.
+        bool add(const vsg::Path& filename, const vsg::Options* options, vsg::ref_ptr<vsg::Object> object);
+
+        /// return true if objects of this type are cached, vsg::Data and vsg::Font.
+        static bool cacheable(const vsg::Object* object);
+
+        /// change the budget, evicting entries as required.
+        void setMaxBytes(size_t in_maxBytes);
+        size_t getMaxBytes() const;
+
+        /// remove all entries.
+        void clear();
+
+        Statistics getStatistics() const;
+
+    protected:
+        /// the options that affect decoding, the extension hint and the vsg::Options::setValue() values
+        struct Key
+        {
+            vsg::Path extensionHint;
+            bool mapRGBtoRGBAHint = true;
+            std::map<std::string, vsg::ref_ptr<vsg::Object>> values;
+
+            explicit Key(const vsg::Options* options);
+            bool operator==(const Key& rhs) const;
+        };
+
+        struct Entry
+        {
+            vsg::Path filename;
+            Key key;
+            vsg::ref_ptr<vsg::Object> object;
+            size_t size = 0;
+        };
+
+        using Entries = std::list<Entry>;
+
+        void evict();
+
+        mutable std::mutex _mutex;
+        size_t _maxBytes = 0;
+        Entries _entries; // most recently used first
+        std::multimap<vsg::Path, Entries::iterator> _index;
+        Statistics _statistics;
+    };
+} // namespace vsgXchange
+
+EVSG_type_name(vsgXchange::DataCache);
@@ -24,9 +24,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 </editor-fold> */
 
 #include <vsg/io/ReaderWriter.h>
+#include <vsg/text/Font.h>
+#include <vsg/utils/ShaderSet.h>
 #include <vsgXchange/Export.h>
 
 #include <memory>
+#include <vector>
 
 namespace vsgXchange
 {
@@ -37,11 +40,29 @@ namespace vsgXchange
         freetype();
         vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
 
+        /// add the glyphs for the charcodes that aren't already in a font read by vsgXchange::freetype, growing its atlas to fit them, returns the number of glyphs added.
+        /// The font's atlas, glyphMetrics and charmap are replaced, so vsg::Text using the font need to be recreated and compiled to use the new glyphs.
+        uint32_t addGlyphs(vsg::Font& font, const std::vector<uint32_t>& charcodes, vsg::ref_ptr<const vsg::Options> options = {}) const;
+
         bool getFeatures(Features& features) const override;
 
         // vsg::Options::setValue(str, value) supported options:
         static constexpr const char* texel_margin_ratio = "texel_margin_ratio";
         static constexpr const char* quad_margin_ratio = "quad_margin_ratio";
+        static constexpr const char* num_threads = "num_threads";       /// uint32_t, number of threads used to compute the glyph signed distance fields, defaults to std::thread::hardware_concurrency()
+        static constexpr const char* character_set = "character_set";   /// std::string, comma separated list of the charcodes and charcode ranges to generate glyphs for, i.e. "32-126,0xA0-0xFF", defaults to all the charcodes in the font
+        static constexpr const char* pixel_size = "pixel_size";         /// uint32_t, size in texels of the em square the glyphs are rendered at in the atlas, defaults to 48
+        static constexpr const char* atlas_format = "atlas_format";     /// std::string, texel format of the signed distance field atlas, "r16_snorm" or "r8_snorm" to halve the atlas memory, defaults to "r16_snorm"
+        static constexpr const char* max_atlas_size = "max_atlas_size"; /// uint32_t, maximum width of the glyph atlas, typically the device's maxImageDimension2D, the atlas is given the smallest power of two width that keeps it no taller than wide, defaults to 16384
+        static constexpr const char* font_cache = "font_cache";         /// std::string, directory where generated fonts are written as .vsgb files, named by a hash of the font file and the options that affect the font, and read back on later reads, defaults to no caching
+        static constexpr const char* msdf = "msdf";                     /// bool, generate a multi-channel signed distance field atlas, VK_FORMAT_R8G8B8A8_SNORM with the red, green and blue channels holding edge coloured pseudo distances that keep corners sharp at small pixel_size and alpha holding the signed distance, the font is assigned the ShaderSet from createMSDFShaderSet() as its msdf_shader_set object, defaults to false
+
+        /// key of the vsg::ShaderSet assigned to fonts generated with the msdf option, assign it to vsg::Text::shaderSet, or to the Options::shaderSets["text"] used to create the text, to render them.
+        static constexpr const char* msdf_shader_set = "msdf_shader_set";
+
+        /// create a copy of vsg::createTextShaderSet(options) with the fragment shader replaced by one that renders multi-channel signed distance field atlases,
+        /// using the median of the red, green and blue channels for the glyph and the signed distance in alpha for the outline. The shader is provided as GLSL so requires VSG's shader compiler.
+        static vsg::ref_ptr<vsg::ShaderSet> createMSDFShaderSet(vsg::ref_ptr<const vsg::Options> options = {});
 
         bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
 
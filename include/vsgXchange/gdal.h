@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <vsg/io/ReaderWriter.h>
 #include <vsgXchange/Version.h>
+#include <vsgXchange/cancellation.h>
 
 #include <istream>
 #include <memory>
@@ -43,6 +44,30 @@ namespace vsgXchange
 
         bool getFeatures(Features& features) const override;
 
+        /// get the features known without initializing GDAL, a static table of the extensions of the commonly built GDAL raster drivers and the supported options,
+        /// used by vsgXchange::all to defer creating the GDAL ReaderWriter until one of its extensions is read.
+        static void getStaticFeatures(Features& features);
+
+        // vsg::Options::setValue(str, value) supported options:
+        static constexpr const char* vsicurl = "vsicurl";                       /// bool, read http/https rasters through GDAL's /vsicurl/ virtual file system using HTTP range requests, rather than downloading the whole file, list the extensions in the "CURL_DEFER_EXTENSIONS" option so vsgXchange::curl doesn't download them first, defaults to false
+        static constexpr const char* vsicurl_cache_size = "vsicurl_cache_size"; /// uint64_t, size in bytes of the global /vsicurl/ block cache, defaults to GDAL's own default of 16MB
+        static constexpr const char* window = "window";                         /// vsg::ivec4, pixel window (x, y, width, height) of the full resolution raster to read
+        static constexpr const char* geographic_window = "geographic_window";   /// vsg::dvec4, window (minX, minY, maxX, maxY) in the dataset's georeferenced coordinates to read, used when no pixel window is specified, and as the spatial filter of vector layers
+        static constexpr const char* output_size = "output_size";               /// vsg::ivec2, dimensions (width, height) of the returned image, the window is resampled to fit
+        static constexpr const char* overview_level = "overview_level";         /// int, read from the specified overview level rather than the full resolution raster
+        static constexpr const char* read_threads = "read_threads";             /// uint32_t, number of threads to use to decode the blocks of the raster, each with its own dataset handle, defaults to 1
+        static constexpr const char* drivers = "drivers";                       /// std::string, comma separated list of GDAL drivers to register as they are first requested, i.e. "GTiff,COG,PNG", defaults to all drivers
+        static constexpr const char* target_srs = "target_srs";                 /// std::string, reproject the raster or vector layers on load to the specified spatial reference, any form accepted by OGRSpatialReference::SetFromUserInput() i.e. "EPSG:4326"
+        static constexpr const char* heightfield = "heightfield";               /// bool, convert single band elevation rasters into a heightfield mesh, returned as a vsg::MatrixTransform containing a phong shaded vsg::StateGroup and vsg::VertexIndexDraw, with holes where the raster has NoData
+        static constexpr const char* heightfield_step = "heightfield_step";     /// uint32_t, sample every Nth pixel in each direction when building the heightfield mesh, defaults to 1
+        static constexpr const char* resample = "resample";                     /// std::string, resampling algorithm used when reprojecting: "nearest" (default), "bilinear", "cubic", "cubicspline", "lanczos" or "average"
+        static constexpr const char* mask = "mask";                             /// std::string, assign the combined NoData/mask band validity of the pixels read to the image as a "Mask" object, "byte" for an 8-bit mask or "bit" for a packed 1-bit mask, defaults to no mask
+        static constexpr const char* vector_layers = "vector_layers";           /// std::string, comma separated list of the names of the vector layers to read, defaults to all layers
+        static constexpr const char* vector_color = "vector_color";             /// vsg::vec4, sRGB color of vector features that have no OGR style, defaults to white
+        static constexpr const char* point_size = "point_size";                 /// double, width of the quads drawn for vector point features in the layer's coordinates, defaults to a 500th of the extent of the layer's points
+
+        bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
+
     protected:
         ~GDAL();
 
@@ -60,17 +85,25 @@ EVSG_type_name(vsgXchange::GDAL);
 #    include "ogr_spatialref.h"
 
 #    include <vsg/core/Data.h>
+#    include <vsg/io/Options.h>
+#    include <vsg/nodes/Node.h>
 #    include <vsg/io/Path.h>
 #    include <vsg/maths/vec4.h>
 
 #    include <memory>
 #    include <set>
+#    include <string>
+#    include <vector>
 
 namespace vsgXchange
 {
-    /// call GDALAllRegister() etc. if it hasn't already been called. Return true if this call to initGDAL() invoked GDAL setup, or false if it has previously been done.
+    /// call GDALAllRegister() etc. if it hasn't already been called, thread safe. Return true if this call to initGDAL() invoked GDALAllRegister(), or false if it has previously been done.
     extern VSGXCHANGE_DECLSPEC bool initGDAL();
 
+    /// register just the specified GDAL drivers, such as {"GTiff", "COG", "PNG"}, that aren't already registered, avoiding the startup cost of GDALAllRegister().
+    /// Drivers built into GDAL by default are registered individually, others fall back to GDALAllRegister(). Thread safe, return true if this call registered any drivers.
+    extern VSGXCHANGE_DECLSPEC bool initGDAL(const std::vector<std::string>& drivers);
+
     /// Call GDALOpen(..) to open specified file returning a std::shared_ptr<GDALDataset> to reboustly manage the lifetime of the GDALDataSet, automatiically call GDALClose.
     inline std::shared_ptr<GDALDataset> openDataSet(const vsg::Path& filename, GDALAccess access)
     {
@@ -85,6 +118,9 @@ namespace vsgXchange
         return std::shared_ptr<GDALDataset>(static_cast<GDALDataset*>(GDALOpenShared(filename.string().c_str(), access)), [](GDALDataset* dataset) { GDALClose(dataset); });
     }
 
+    /// assign a progress function to the RasterIO extra arguments that aborts the RasterIO once cancellation is cancelled, GDAL calls it as each block row is read. Does nothing if cancellation is null.
+    extern VSGXCHANGE_DECLSPEC void assignCancellation(GDALRasterIOExtraArg& extraArg, const CancellationToken* cancellation);
+
     /// return true if two GDALDataset has the same projection reference string/
     extern VSGXCHANGE_DECLSPEC bool compatibleDatasetProjections(const GDALDataset& lhs, const GDALDataset& rhs);
 
@@ -94,9 +130,45 @@ namespace vsgXchange
     /// create a vsg::Image2D of the approrpiate type that maps to specified dimensions and GDALDataType
     extern VSGXCHANGE_DECLSPEC vsg::ref_ptr<vsg::Data> createImage2D(int width, int height, int numComponents, GDALDataType dataType, vsg::dvec4 def = {0.0, 0.0, 0.0, 1.0});
 
+    /// create a vsg::Image2D of the approrpiate type that maps to specified dimensions and GDALDataType, leaving the pixels uninitialized for when the caller will overwrite every pixel.
+    extern VSGXCHANGE_DECLSPEC vsg::ref_ptr<vsg::Data> allocateImage2D(int width, int height, int numComponents, GDALDataType dataType);
+
     /// copy a RasterBand onto a target RGBA component of a vsg::Data.  Dimensions and datatypes must be compatble between RasterBand and vsg::Data. Return true on success, false on failure to copy.
     extern VSGXCHANGE_DECLSPEC bool copyRasterBandToImage(GDALRasterBand& band, vsg::Data& image, int component);
 
+    /// copy a window (in the band's pixel coordinates) of a RasterBand onto a target RGBA component of a vsg::Data, resampling the window to the dimensions of the vsg::Data using GDALRasterBand::RasterIO.
+    /// Datatypes must be compatible between RasterBand and vsg::Data. Return true on success, false on failure to copy.
+    /// The read is abandoned, returning false, if the optional cancellation token is cancelled while the blocks are read.
+    extern VSGXCHANGE_DECLSPEC bool copyRasterBandWindowToImage(GDALRasterBand& band, int xOffset, int yOffset, int xSize, int ySize, vsg::Data& image, int component, const CancellationToken* cancellation = nullptr);
+
+    /// copy a window of the specified raster bands (1 based band numbers) of a GDALDataset into consecutive components of a vsg::Data, resampling to the dimensions of the vsg::Data.
+    /// All the bands are read with a single GDALDataset::RasterIO call, interleaving directly into the vsg::Data. Return true on success, false on failure to copy.
+    /// The read is abandoned, returning false, if the optional cancellation token is cancelled while the blocks are read.
+    extern VSGXCHANGE_DECLSPEC bool copyRasterBandsToImage(GDALDataset& dataset, const std::vector<int>& bandNumbers, int xOffset, int yOffset, int xSize, int ySize, vsg::Data& image, const CancellationToken* cancellation = nullptr);
+
+    /// create a validity mask for a window (in the bands' pixel coordinates) of the specified raster bands, resampled to width x height, combining the bands' NoData values and mask bands so a pixel is only valid when valid in all bands.
+    /// When packed is false returns a ubyteArray2D with 255 for valid and 0 for invalid pixels, when packed is true returns a ubyteArray2D of (width + 7) / 8 bytes per row with one bit per pixel, most significant bit first, and the pixel width assigned as "Width".
+    /// Returns null when all the pixels of all the bands are valid.
+    extern VSGXCHANGE_DECLSPEC vsg::ref_ptr<vsg::Data> createMask(const std::vector<GDALRasterBand*>& bands, int xOffset, int yOffset, int xSize, int ySize, int width, int height, bool packed);
+
+    /// create a heightfield mesh from a single component elevation image, using the image's "GeoTransform" to position the vertices and sampling every step'th pixel.
+    /// Samples matching the image's "NoDataValue", or that aren't finite, are left as holes in the mesh. Returns a vsg::MatrixTransform positioned at the origin of the mesh,
+    /// containing a vsg::StateGroup with a phong shaded pipeline from options, shared through options->sharedObjects, and a vsg::VertexIndexDraw with vertex, normal and texcoord arrays.
+    extern VSGXCHANGE_DECLSPEC vsg::ref_ptr<vsg::Node> createHeightField(const vsg::Data& image, uint32_t step = 1, vsg::ref_ptr<const vsg::Options> options = {});
+
+    /// Call GDALOpenEx(..) to open the vector layers of the specified file, returning a std::shared_ptr<GDALDataset> that automatically calls GDALClose.
+    /// Vector datasets aren't opened shared as reading a layer advances its cursor.
+    inline std::shared_ptr<GDALDataset> openVectorDataSet(const vsg::Path& filename)
+    {
+        return std::shared_ptr<GDALDataset>(static_cast<GDALDataset*>(GDALOpenEx(filename.string().c_str(), GDAL_OF_VECTOR | GDAL_OF_READONLY, nullptr, nullptr, nullptr)), [](GDALDataset* dataset) { GDALClose(dataset); });
+    }
+
+    /// create a scene graph from the vector layers of a dataset, streaming each layer's features and batching them into a vsg::VertexIndexDraw per primitive type and style color.
+    /// Lines are drawn as line lists, polygons are triangulated and points are drawn as quads, instanced when the flat shaded ShaderSet supports vsg_Translation.
+    /// Each layer is returned as a vsg::MatrixTransform positioned at its first vertex, with the layer's name and "ProjectionRef", honouring the GDAL::geographic_window, target_srs, vector_layers, vector_color and point_size options.
+    /// Returns null if no features were read or the read was cancelled.
+    extern VSGXCHANGE_DECLSPEC vsg::ref_ptr<vsg::Node> createVectorScene(GDALDataset& dataset, vsg::ref_ptr<const vsg::Options> options);
+
     /// assign GDAL MetaData mapping the "key=value" entries to vsg::Object as setValue(key, std::string(value)).
     extern VSGXCHANGE_DECLSPEC bool assignMetaData(GDALDataset& dataset, vsg::Object& object);
 
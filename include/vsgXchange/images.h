@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <vsg/io/ReaderWriter.h>
 #include <vsgXchange/Version.h>
+#include <vsgXchange/composite.h>
 
 #include <memory>
 #include <unordered_set>
@@ -33,13 +34,17 @@ namespace vsgXchange
 {
     /// Composite ReaderWriter that holds the used 3rd party image format loaders.
     /// By default utilizes the stbi, dds and ktx ReaderWriters so that users only need to create vsgXchange::images::create() to utilize them all.
-    class VSGXCHANGE_DECLSPEC images : public vsg::Inherit<vsg::CompositeReaderWriter, images>
+    class VSGXCHANGE_DECLSPEC images : public vsg::Inherit<IndexedCompositeReaderWriter, images>
     {
     public:
         images();
+
+        // vsg::Options::setValue(str, value) options supported by all the image ReaderWriters:
+        static constexpr const char* max_texture_size = "max_texture_size";                         /// uint32_t, downscale images on load so their width, height and depth are no larger than max_texture_size, dropping mip levels, reading overviews or decoding at reduced scale where the format allows, defaults to 0 for no limit
+        static constexpr const char* supported_compressed_formats = "supported_compressed_formats"; /// std::string, comma separated list of the block compressed format families the device can sample, "bc", "etc2" and "astc", matching the textureCompressionBC, textureCompressionETC2 and textureCompressionASTC_LDR device features. The ktx and dds ReaderWriters decode BC1-5, BC7, ETC2 and EAC textures in other families to R8G8B8A8 on load, defaults to decoding none
     };
 
-    /// add png, jpeg and gif support using local build of stbi.
+    /// add png, jpeg, gif and hdr support using local build of stbi.
     class VSGXCHANGE_DECLSPEC stbi : public vsg::Inherit<vsg::ReaderWriter, stbi>
     {
     public:
@@ -54,8 +59,34 @@ namespace vsgXchange
         bool getFeatures(Features& features) const override;
 
         // vsg::Options::setValue(str, value) supported options:
-        static constexpr const char* jpeg_quality = "jpeg_quality"; /// set the int quality value when writing out to image as jpeg file.
-        static constexpr const char* image_format = "image_format"; /// Override read image format (8bit RGB/RGBA default to sRGB) to be specified class of CoordinateSpace (sRGB or LINEAR).
+        static constexpr const char* jpeg_quality = "jpeg_quality";                   /// set the int quality value when writing out to image as jpeg file.
+        static constexpr const char* image_format = "image_format";                   /// Override read image format (8bit RGB/RGBA default to sRGB) to be specified class of CoordinateSpace (sRGB or LINEAR).
+        static constexpr const char* convert_pixels = "convert_pixels";               /// bool, convert the pixels of 8bit images between the sRGB and linear encodings to match image_format, rather than just relabelling the format, defaults to false.
+        static constexpr const char* native_channels = "native_channels";             /// bool, keep grey and grey alpha images as R8/R8G8 rather than expanding to RGBA, with RGB only expanded to RGBA when Options::mapRGBtoRGBAHint is set.
+        static constexpr const char* png_compression_level = "png_compression_level"; /// int, zlib compression level used when writing png files, lower values write faster but larger files, defaults to 8.
+        static constexpr const char* png_filter = "png_filter";                       /// int, force the png filter mode 0 to 5 rather than choosing it per row, 0 (no filtering) is fastest to write, defaults to -1 for per row selection.
+
+        bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
+
+    private:
+        std::set<vsg::Path> _supportedExtensions;
+    };
+
+    /// optional fast path .jpeg support using libjpeg-turbo's SIMD decoder, registered ahead of stbi so stbi is only used for jpeg when turbojpeg isn't available or fails to decode.
+    /// Honours the stbi::native_channels and stbi::image_format options so it is a drop in replacement for stbi's jpeg support.
+    class VSGXCHANGE_DECLSPEC turbojpeg : public vsg::Inherit<vsg::ReaderWriter, turbojpeg>
+    {
+    public:
+        turbojpeg();
+
+        vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+        vsg::ref_ptr<vsg::Object> read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+        vsg::ref_ptr<vsg::Object> read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
+        bool getFeatures(Features& features) const override;
+
+        // vsg::Options::setValue(str, value) supported options:
+        static constexpr const char* jpeg_scale = "jpeg_scale"; /// uint32_t, downscale the image during decode by 1/2, 1/4 or 1/8 by setting jpeg_scale to 2, 4 or 8, defaults to 1
 
         bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
 
@@ -73,8 +104,13 @@ namespace vsgXchange
         vsg::ref_ptr<vsg::Object> read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options = {}) const override;
         vsg::ref_ptr<vsg::Object> read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options = {}) const override;
 
+        bool write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+        bool write(const vsg::Object* object, std::ostream& fout, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
         bool getFeatures(Features& features) const override;
 
+        bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
+
     private:
         std::set<vsg::Path> _supportedExtensions;
     };
@@ -89,8 +125,20 @@ namespace vsgXchange
         vsg::ref_ptr<vsg::Object> read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options = {}) const override;
         vsg::ref_ptr<vsg::Object> read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options = {}) const override;
 
+        bool write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+        bool write(const vsg::Object* object, std::ostream& fout, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
         bool getFeatures(Features& features) const override;
 
+        // vsg::Options::setValue(str, value) supported options:
+        static constexpr const char* base_level = "base_level";               /// uint32_t, first mip level to load, so the returned image's base level is this level of the file, defaults to 0
+        static constexpr const char* num_levels = "num_levels";               /// uint32_t, maximum number of mip levels to load, starting from the base level, defaults to all
+        static constexpr const char* max_dimension = "max_dimension";         /// uint32_t, skip the mip levels with a width, height or depth larger than max_dimension, defaults to 0 for no limit
+        static constexpr const char* zstd_level = "zstd_level";               /// uint32_t, zstd supercompression level, 1 to 22, used when writing KTX2 files, defaults to 0 for no supercompression
+        static constexpr const char* transcode_formats = "transcode_formats"; /// std::string, comma separated list of the GPU compressed formats the device supports, in order of preference, that Basis Universal KTX2 textures are transcoded to: "bc7", "astc", "etc2", "bc3" or "rgba", defaults to "rgba"
+
+        bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
+
     private:
         std::set<vsg::Path> _supportedExtensions;
     };
@@ -110,6 +158,15 @@ namespace vsgXchange
 
         bool getFeatures(Features& features) const override;
 
+        // vsg::Options::setValue(str, value) supported options:
+        static constexpr const char* num_threads = "num_threads"; /// uint32_t, number of threads used to decode each file, increasing the OpenEXR global thread count to match, defaults to the OpenEXR global thread count
+        static constexpr const char* window = "window";           /// vsg::ivec4, pixel window (x, y, width, height) of the data window to read, defaults to the whole data window
+        static constexpr const char* level = "level";             /// vsg::ivec2, x and y level of a tiled mipmap or ripmap file to read, for mipmaps both are the same, defaults to 0, 0
+        static constexpr const char* compression = "compression"; /// std::string, compression used when writing: "none", "rle", "zips", "zip", "piz", "pxr24", "b44", "b44a", "dwaa" or "dwab", defaults to "zip"
+        static constexpr const char* half_float = "half_float";   /// bool, write float images as half float channels, defaults to false
+
+        bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
+
     private:
         std::set<vsg::Path> _supportedExtensions;
     };
@@ -118,6 +175,7 @@ namespace vsgXchange
 
 EVSG_type_name(vsgXchange::images);
 EVSG_type_name(vsgXchange::stbi);
+EVSG_type_name(vsgXchange::turbojpeg);
 EVSG_type_name(vsgXchange::dds);
 EVSG_type_name(vsgXchange::ktx);
 EVSG_type_name(vsgXchange::openexr);
@@ -0,0 +1,108 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/core/Visitor.h>
+#include <vsg/nodes/Group.h>
+#include <vsg/nodes/StateGroup.h>
+#include <vsg/nodes/VertexIndexDraw.h>
+#include <vsgXchange/Version.h>
+
+#include <map>
+#include <set>
+
+namespace vsgXchange
+{
+    /// visitor that reorders the vertices and indices of the VertexIndexDraw in a scene graph to improve GPU vertex throughput.
+    /// Duplicate vertices are welded, triangle lists are reordered for post transform vertex cache reuse and then clusters of triangles sorted outside in to reduce overdraw,
+    /// and finally vertices are reordered into the order they are first referenced so vertex fetches are sequential.
+    /// The primitive topology is taken from the InputAssemblyState of the GraphicsPipeline bound by the enclosing StateGroup, only welding and vertex fetch reordering are applied when it's not a triangle list.
+    class VSGXCHANGE_DECLSPEC OptimizeMeshes : public vsg::Inherit<vsg::Visitor, OptimizeMeshes>
+    {
+    public:
+        bool weldVertices = true;
+        bool optimizeVertexCache = true;
+        bool optimizeOverdraw = true;
+        bool optimizeVertexFetch = true;
+
+        /// number of entries of the post transform vertex cache modelled when reordering triangles.
+        uint32_t vertexCacheSize = 16;
+
+        /// number of VertexIndexDraw modified.
+        size_t numOptimized = 0;
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::StateGroup& stateGroup) override;
+        void apply(vsg::VertexIndexDraw& vid) override;
+
+        /// optimize a single VertexIndexDraw drawn with the specified topology, returns true if the VertexIndexDraw was modified.
+        /// Doesn't modify the visitor so can be called from multiple threads.
+        bool optimize(vsg::VertexIndexDraw& vid, VkPrimitiveTopology topology) const;
+
+    protected:
+        VkPrimitiveTopology _topology = VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
+        std::set<vsg::VertexIndexDraw*> _visited;
+    };
+
+    /// visitor that replaces the triangle list VertexIndexDraw in a scene graph with a vsg::LOD of the original and versions simplified using quadric edge collapse.
+    /// Each simplified level is created from the original VertexIndexDraw with twice the maximum error of the previous level, and shares the original's vertex arrays with only the indices reduced.
+    /// The topology is taken from the enclosing StateGroup as with OptimizeMeshes, instanced VertexIndexDraw are left unchanged.
+    class VSGXCHANGE_DECLSPEC GenerateLODs : public vsg::Inherit<vsg::Visitor, GenerateLODs>
+    {
+    public:
+        /// maximum number of simplified levels to create for each VertexIndexDraw.
+        uint32_t numLevels = 3;
+
+        /// maximum geometric error of the first simplified level, as a ratio of the mesh's bounding box diagonal.
+        float errorThreshold = 0.005f;
+
+        /// geometric error, as a ratio of the screen height, at which the LOD switches to the next more detailed level.
+        float screenErrorRatio = 0.002f;
+
+        /// VertexIndexDraw with fewer triangles than this aren't simplified.
+        uint32_t minimumTriangles = 64;
+
+        /// number of vsg::LOD created.
+        size_t numLODs = 0;
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::Group& group) override;
+        void apply(vsg::StateGroup& stateGroup) override;
+
+        /// create a vsg::LOD for the VertexIndexDraw drawn with the specified topology, returns null if no simplified levels could be created.
+        /// Doesn't modify the visitor so can be called from multiple threads.
+        vsg::ref_ptr<vsg::Node> createLOD(vsg::VertexIndexDraw& vid, VkPrimitiveTopology topology) const;
+
+        /// create a simplified copy of a triangle list VertexIndexDraw with a maximum geometric error, as a ratio of the mesh's bounding box diagonal, returns null if it can't be simplified.
+        vsg::ref_ptr<vsg::VertexIndexDraw> simplify(const vsg::VertexIndexDraw& vid, float maxError) const;
+
+    protected:
+        VkPrimitiveTopology _topology = VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
+        std::map<vsg::VertexIndexDraw*, vsg::ref_ptr<vsg::Node>> _lods;
+    };
+
+} // namespace vsgXchange
+
+EVSG_type_name(vsgXchange::OptimizeMeshes);
+EVSG_type_name(vsgXchange::GenerateLODs);
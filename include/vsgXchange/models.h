@@ -23,20 +23,74 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 </editor-fold> */
 
+#include <vsg/animation/AnimationSampler.h>
+#include <vsg/core/Array.h>
 #include <vsg/io/ReaderWriter.h>
+#include <vsg/state/ImageInfo.h>
 #include <vsgXchange/Version.h>
+#include <vsgXchange/composite.h>
 
 #include <memory>
+#include <vector>
 
 namespace vsgXchange
 {
     /// Composite ReaderWriter that holds the used 3rd party model format loaders.
-    class VSGXCHANGE_DECLSPEC models : public vsg::Inherit<vsg::CompositeReaderWriter, models>
+    class VSGXCHANGE_DECLSPEC models : public vsg::Inherit<IndexedCompositeReaderWriter, models>
     {
     public:
         models();
     };
 
+    /// native glTF 2.0 ReaderWriter for .gltf and .glb files, converting the glTF document directly to a scene graph rather than via assimp's aiScene.
+    /// A GLB's binary chunk, and each external or embedded buffer, is read once into a vsg::ubyteArray, and the vertex and index accessors whose layout matches
+    /// the vsg::Array they are converted to are created as views of it rather than copied, accessors in other formats are converted.
+    /// Files using features it doesn't convert, such as skins, animations, morph targets, cameras, lights, sparse accessors and compressed meshes, aren't read
+    /// so that vsgXchange::models and vsgXchange::all fall back to the assimp ReaderWriter.
+    class VSGXCHANGE_DECLSPEC gltf : public vsg::Inherit<vsg::ReaderWriter, gltf>
+    {
+    public:
+        gltf();
+        vsg::ref_ptr<vsg::Object> read(const vsg::Path&, vsg::ref_ptr<const vsg::Options>) const override;
+        vsg::ref_ptr<vsg::Object> read(std::istream&, vsg::ref_ptr<const vsg::Options>) const override;
+        vsg::ref_ptr<vsg::Object> read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options = {}) const override;
+
+        bool getFeatures(Features& features) const override;
+
+        // vsg::Options::setValue(str, value) supported options:
+        static constexpr const char* use_assimp = "use_assimp";   /// bool, leave .gltf and .glb files to the assimp ReaderWriter, defaults to false
+        static constexpr const char* num_threads = "num_threads"; /// uint32_t, number of threads used to read textures and convert meshes, shared with assimp::num_threads, defaults to std::thread::hardware_concurrency()
+
+        bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
+    };
+
+    /// point cloud ReaderWriter for .las files, and .laz and .e57 files when built with LASzip and libE57Format, that streams the points in chunks to build an octree of vsg::PagedLOD tiles,
+    /// so scans of billions of points are paged in by view rather than read as a single mesh. Each tile holds the first point in each cell of a tile_resolution^3 grid over its octree cell,
+    /// quantized to snorm16 positions and unorm8 colors drawn as a point list, passing the remaining points down to its children so the children add detail to their ancestors.
+    /// The tiles are written as .vsgb files to the tile_directory and reused by later reads of the unchanged file, and the whole octree can be exported with vsgconv's -l option.
+    class VSGXCHANGE_DECLSPEC pointcloud : public vsg::Inherit<vsg::ReaderWriter, pointcloud>
+    {
+    public:
+        pointcloud();
+        vsg::ref_ptr<vsg::Object> read(const vsg::Path&, vsg::ref_ptr<const vsg::Options>) const override;
+
+        bool getFeatures(Features& features) const override;
+
+        // vsg::Options::setValue(str, value) supported options:
+        static constexpr const char* tile_directory = "tile_directory";     /// std::string, directory the octree's tiles are written to, defaults to a directory named by a hash of the file and settings in the Options::fileCache, or the system's temporary directory
+        static constexpr const char* points_per_tile = "points_per_tile";   /// uint32_t, octree cells with more points than this are subdivided, defaults to 65536
+        static constexpr const char* tile_resolution = "tile_resolution";   /// uint32_t, resolution of the grid each tile's points are subsampled on, defaults to 128
+        static constexpr const char* chunk_points = "chunk_points";         /// uint64_t, maximum number of points in the chunks the octree is built from, each thread holds about 64 bytes per point of its chunk, defaults to 2000000
+        static constexpr const char* lod_screen_ratio = "lod_screen_ratio"; /// double, minimumScreenHeightRatio of the PagedLOD children, defaults to 0.5
+        static constexpr const char* num_threads = "num_threads";           /// uint32_t, number of threads used to build the chunks' subtrees, shared with gltf::num_threads, defaults to std::thread::hardware_concurrency()
+        static constexpr const char* rebuild = "rebuild";                   /// bool, rebuild the tiles even if the tile_directory holds a complete octree, defaults to false
+
+        bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
+
+    protected:
+        bool supportedExtension(const vsg::Path& ext) const;
+    };
+
     /// optional assimp ReaderWriter
     class VSGXCHANGE_DECLSPEC assimp : public vsg::Inherit<vsg::ReaderWriter, assimp>
     {
@@ -48,6 +102,10 @@ namespace vsgXchange
 
         bool getFeatures(Features& features) const override;
 
+        /// get the features known without creating an Assimp::Importer, a static table of the extensions supported by assimp's importers and the supported options,
+        /// used by vsgXchange::all to defer creating the assimp ReaderWriter until one of its extensions is read.
+        static void getStaticFeatures(Features& features);
+
         // vsg::Options::setValue(str, value) supported options:
         static constexpr const char* generate_smooth_normals = "generate_smooth_normals";
         static constexpr const char* generate_sharp_normals = "generate_sharp_normals";
@@ -60,6 +118,22 @@ namespace vsgXchange
         static constexpr const char* culling = "culling";                                   /// bool, insert cull nodes, defaults to true
         static constexpr const char* vertex_color_space = "vertex_color_space";             /// CoordinateSpace {sRGB or LINEAR} to assume when reading vertex colors
         static constexpr const char* material_color_space = "material_color_space";         /// CoordinateSpace {sRGB or LINEAR} to assume when reading materials colors
+        static constexpr const char* num_threads = "num_threads";                           /// uint32_t, number of threads used to read textures and convert meshes, defaults to std::thread::hardware_concurrency()
+        static constexpr const char* deferred_textures = "deferred_textures";               /// bool, assign placeholder images to external textures and attach the vsgXchange::DeferredTexture to the root as a vsg::Objects named "deferred_textures", so they can be read later, defaults to false
+        static constexpr const char* uint8_indices = "uint8_indices";                       /// bool, use uint8_t indices for meshes with fewer than 255 vertices, requires the device to enable the VK_EXT_index_type_uint8 indexTypeUint8 feature, defaults to false
+        static constexpr const char* optimize_meshes = "optimize_meshes";                   /// bool, weld duplicate vertices and reorder each mesh for vertex cache, overdraw and vertex fetch efficiency using vsgXchange::OptimizeMeshes, defaults to false
+        static constexpr const char* quantize_vertices = "quantize_vertices";               /// bool, pack vertex attributes into snorm16 positions with a dequantizing MatrixTransform, snorm8 normals, unorm16/half texcoords, unorm8 colors and 8/16 bit joints, defaults to false
+        static constexpr const char* instance_meshes = "instance_meshes";                   /// bool, draw meshes that are referenced by several static nodes, or have identical geometry, with a single instanced VertexIndexDraw using the vsg_Translation, vsg_Rotation and vsg_Scale instance arrays, defaults to false
+        static constexpr const char* merge_static_meshes = "merge_static_meshes";           /// bool, pre-transform the meshes of nodes that aren't animated, bones or referenced by cameras and lights, and join the meshes that share a material, defaults to false
+        static constexpr const char* lod_levels = "lod_levels";                             /// uint32_t, number of simplified levels of each mesh to create using vsgXchange::GenerateLODs, placing them in a vsg::LOD, defaults to 0
+        static constexpr const char* lod_error = "lod_error";                               /// float, maximum error of the first simplified level as a ratio of the mesh's bounding box diagonal, doubled for each subsequent level, defaults to 0.005
+        static constexpr const char* import_flags = "import_flags";                         /// uint32_t, aiPostProcessSteps flags passed to the Assimp::Importer, replacing the default aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_OptimizeMeshes | aiProcess_SortByPType | aiProcess_ImproveCacheLocality | aiProcess_GenUVCoords | aiProcess_PopulateArmatureData
+        static constexpr const char* animation_tolerance = "animation_tolerance";           /// double, tolerance within which keyframes that can be linearly interpolated from their neighbours are removed, in model units for positions and scales and radians for rotations, 0 disables reduction, defaults to 0
+        static constexpr const char* animation_sample_rate = "animation_sample_rate";       /// double, resample animation channels with more keyframes than this rate in keyframes per second to this fixed rate, 0 keeps the original keyframes, defaults to 0
+        static constexpr const char* pack_joints = "pack_joints";                           /// bool, pack skinned mesh joint indices into 8 or 16 bit integers and joint weights into unorm8, implied by quantize_vertices, defaults to false
+        static constexpr const char* max_joints = "max_joints";                             /// uint32_t, split skinned meshes so each references at most this many joints, drawing each with its own palette of joint matrices updated by a vsgXchange::JointPaletteSampler, 0 uses a single joint matrix array for the whole model, defaults to 0
+        static constexpr const char* cull_hierarchy = "cull_hierarchy";                     /// bool, rebalance nodes with many children into a bounding volume hierarchy of vsg::CullGroup using the bounds computed during conversion, defaults to false
+        static constexpr const char* texture_arrays = "texture_arrays";                     /// bool, stack the same size and format textures of otherwise identical materials into 2D array images, using vsgXchange::convertToTextureArrays shaders and a per instance vsg_TextureLayer, so their meshes share a descriptor set, defaults to false
 
         bool readOptions(vsg::Options& options, vsg::CommandLine& arguments) const override;
 
@@ -70,7 +144,47 @@ namespace vsgXchange
         Implementation* _implementation;
     };
 
+    /// external texture of a model read with the assimp::deferred_textures option, the imageInfos reference a placeholder image until load() reads the texture file.
+    /// load() can be called from a background thread, once it has returned the descriptors using the imageInfos need to be compiled again for the texture to be used.
+    class VSGXCHANGE_DECLSPEC DeferredTexture : public vsg::Inherit<vsg::Object, DeferredTexture>
+    {
+    public:
+        vsg::Path filename;
+        vsg::ref_ptr<const vsg::Options> options;
+        vsg::ref_ptr<vsg::Data> placeholder;
+        std::vector<vsg::ref_ptr<vsg::ImageInfo>> imageInfos;
+
+        /// read the texture file and assign it to the imageInfos, returns the texture read, or null if it couldn't be read.
+        vsg::ref_ptr<vsg::Data> load();
+    };
+
+    /// animation sampler that copies the joint matrices referenced by a skinned mesh from the model's vsg::JointSampler into a smaller palette of joint matrices,
+    /// so the mesh's joint indices index into the palette. Must be updated after the JointSampler that computes the jointMatrices.
+    class VSGXCHANGE_DECLSPEC JointPaletteSampler : public vsg::Inherit<vsg::AnimationSampler, JointPaletteSampler>
+    {
+    public:
+        JointPaletteSampler();
+        JointPaletteSampler(const JointPaletteSampler& rhs, const vsg::CopyOp& copyop = {});
+
+        /// joint matrices of the whole model, computed by the vsg::JointSampler
+        vsg::ref_ptr<vsg::mat4Array> jointMatrices;
+
+        /// joint matrices used by the mesh, paletteMatrices[i] is assigned jointMatrices[joints[i]]
+        vsg::ref_ptr<vsg::mat4Array> paletteMatrices;
+        std::vector<uint32_t> joints;
+
+        void update(double time) override;
+        double maxTime() const override { return 0.0; }
+
+        void read(vsg::Input& input) override;
+        void write(vsg::Output& output) const override;
+    };
+
 } // namespace vsgXchange
 
 EVSG_type_name(vsgXchange::models);
+EVSG_type_name(vsgXchange::DeferredTexture);
+EVSG_type_name(vsgXchange::JointPaletteSampler);
+EVSG_type_name(vsgXchange::gltf);
+EVSG_type_name(vsgXchange::pointcloud);
 EVSG_type_name(vsgXchange::assimp);
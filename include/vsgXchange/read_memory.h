@@ -0,0 +1,135 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/io/Options.h>
+#include <vsgXchange/Version.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace vsgXchange
+{
+    /// key of the uint64_t vsg::Options value that caps the bytes a single read may allocate for its decoded images and geometry, such as the reads of the vsg::DatabasePager threads.
+    /// Reads that would exceed it are abandoned and return null. Unset or 0 for no limit. Assign with options->setValue(vsgXchange::read_memory_budget, uint64_t(256) << 20);
+    static constexpr const char* read_memory_budget = "vsgXchange::read_memory_budget";
+
+    /// accounting of the memory allocated by a read, installed for the current thread by IndexedCompositeReaderWriter when reading with a read_memory_budget or a ReadWriteObserver.
+    /// ReaderWriters reserve their final image and vertex buffers, along with any large transient buffers, before allocating them so oversized reads fail early rather than exhausting memory.
+    /// Reads nested within another read, such as the textures of a model, count towards the budget of the read they are nested within.
+    /// reserve() and release() may be called from the worker threads of a read, so install currentReadMemory() on them with ScopedReadMemory when handing them work.
+    class VSGXCHANGE_DECLSPEC ReadMemory
+    {
+    public:
+        explicit ReadMemory(uint64_t in_budget);
+        ReadMemory(const ReadMemory&) = delete;
+        ReadMemory& operator=(const ReadMemory&) = delete;
+        ~ReadMemory();
+
+        /// add size bytes to the memory allocated by the read, returning false and marking the read as exceeded if that would take it over its budget.
+        bool reserve(uint64_t size);
+
+        /// remove size bytes of previously reserved transient buffers once they have been freed.
+        void release(uint64_t size);
+
+        /// discard the reservations, called when the read failed so the memory it allocated has been freed.
+        void discard() { release(allocated()); }
+
+        uint64_t budget() const { return _budget; } /// 0 for no limit
+        uint64_t allocated() const { return _allocated; }
+        uint64_t peak() const { return _peak; }
+        bool exceeded() const { return _exceeded; }
+
+    protected:
+        ReadMemory* _parent = nullptr;
+        uint64_t _parentAllocated = 0;
+        uint64_t _budget = 0;
+        std::atomic<uint64_t> _allocated{0};
+        std::atomic<uint64_t> _peak{0};
+        std::atomic_bool _exceeded{false};
+    };
+
+    /// return the ReadMemory of the read in progress on the current thread, or null if its memory isn't being accounted.
+    extern VSGXCHANGE_DECLSPEC ReadMemory* currentReadMemory();
+
+    /// make readMemory the current ReadMemory of the calling thread while in scope, so the work a read hands to other threads, such as by parallel_for, is accounted to it.
+    class VSGXCHANGE_DECLSPEC ScopedReadMemory
+    {
+    public:
+        explicit ScopedReadMemory(ReadMemory* readMemory);
+        ScopedReadMemory(const ScopedReadMemory&) = delete;
+        ScopedReadMemory& operator=(const ScopedReadMemory&) = delete;
+        ~ScopedReadMemory();
+
+    protected:
+        ReadMemory* _previous = nullptr;
+    };
+
+    /// return the read_memory_budget assigned to options, 0 if there isn't one.
+    extern VSGXCHANGE_DECLSPEC uint64_t readMemoryBudget(const vsg::Options* options);
+
+    /// reserve size bytes against the read in progress on the current thread, returns true when its memory isn't being accounted.
+    inline bool reserveReadMemory(uint64_t size)
+    {
+        auto readMemory = currentReadMemory();
+        return !readMemory || readMemory->reserve(size);
+    }
+
+    /// allocate size bytes for decoded data with vsg::allocate(size, vsg::ALLOCATOR_AFFINITY_DATA), so it shares the vsg::Allocator's data blocks with the rest of the scene graph,
+    /// reserving it against the read in progress on the current thread. Returns null if the reservation exceeds the read's budget. Release with vsg::deallocate().
+    extern VSGXCHANGE_DECLSPEC void* allocateReadData(size_t size);
+
+    /// reservation of a transient buffer against the read in progress on the current thread, released when it goes out of scope.
+    class ReadMemoryReservation
+    {
+    public:
+        explicit ReadMemoryReservation(uint64_t in_size) :
+            _readMemory(currentReadMemory()),
+            _size(in_size)
+        {
+            if (_readMemory && !_readMemory->reserve(_size))
+            {
+                _size = 0;
+                _valid = false;
+            }
+        }
+
+        ReadMemoryReservation(const ReadMemoryReservation&) = delete;
+        ReadMemoryReservation& operator=(const ReadMemoryReservation&) = delete;
+
+        ~ReadMemoryReservation()
+        {
+            if (_readMemory && _size > 0) _readMemory->release(_size);
+        }
+
+        /// false if the reservation would exceed the read's budget.
+        explicit operator bool() const { return _valid; }
+
+    protected:
+        ReadMemory* _readMemory = nullptr;
+        uint64_t _size = 0;
+        bool _valid = true;
+    };
+
+} // namespace vsgXchange
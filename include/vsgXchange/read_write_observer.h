@@ -0,0 +1,134 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/core/Inherit.h>
+#include <vsg/io/Path.h>
+#include <vsg/utils/Instrumentation.h>
+#include <vsgXchange/Version.h>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace vsgXchange
+{
+    /// time spent in a named phase of a read or write, such as assimp's import and the conversion of its materials and meshes.
+    struct ReadWritePhase
+    {
+        std::string name;
+        double duration = 0.0; /// seconds
+    };
+
+    /// details of a read or write dispatched by an IndexedCompositeReaderWriter, such as vsgXchange::all, reported to its ReadWriteObserver once the operation completes.
+    struct ReadWriteEvent
+    {
+        enum Operation
+        {
+            READ_FILENAME,
+            READ_ISTREAM,
+            READ_MEMORY,
+            WRITE_FILENAME,
+            WRITE_OSTREAM
+        };
+
+        Operation operation = READ_FILENAME;
+        vsg::Path filename;       /// filename or URL passed to the read or write, empty for streams and memory blocks
+        vsg::Path foundFilename;  /// filename found by vsg::findFile() when reading a file, empty if it wasn't found or is remote
+        vsg::Path extension;      /// extension of the filename, or the Options::extensionHint for streams and memory blocks
+        std::string readerWriter; /// class name of the ReaderWriter that read or wrote the object, empty if none succeeded
+        bool succeeded = false;
+        bool cached = false; /// true if the object was returned from the IndexedCompositeReaderWriter::dataCache
+
+        uint64_t bytesIn = 0;  /// size of the file, stream or memory block read, or of the vsg::Data being written
+        uint64_t bytesOut = 0; /// size of the vsg::Data read, or of the file or stream written
+
+        uint64_t peakMemory = 0;           /// peak bytes reserved through ReadMemory by the ReaderWriter while reading, including reads nested within it
+        bool memoryBudgetExceeded = false; /// true if the read was abandoned because it would have exceeded the Options' read_memory_budget
+
+        double findFileDuration = 0.0; /// seconds spent resolving the filename with vsg::findFile()
+        double duration = 0.0;         /// total wall time of the read or write in seconds, including findFileDuration
+
+        std::thread::id threadId; /// thread that the read or write was called from, such as one of the vsg::DatabasePager threads
+        bool nested = false;      /// true if called while another observed read or write was in progress on the same thread, such as a texture read by a model's ReaderWriter
+
+        /// phases of the read or write timed by the ReaderWriter with ReadWritePhaseTimer.
+        std::vector<ReadWritePhase> phases;
+
+        /// seconds spent in the ReaderWriter, i.e. reading and decoding, excluding the time spent finding the file.
+        double decodeDuration() const { return duration - findFileDuration; }
+    };
+
+    /// observer of the reads and writes dispatched by an IndexedCompositeReaderWriter, assign to IndexedCompositeReaderWriter::observer to profile which formats and ReaderWriters dominate load times.
+    /// report() is called from the thread that performed each read or write, so may be called from several threads at once.
+    class VSGXCHANGE_DECLSPEC ReadWriteObserver : public vsg::Inherit<vsg::Object, ReadWriteObserver>
+    {
+    public:
+        using Callback = std::function<void(const ReadWriteEvent&)>;
+
+        ReadWriteObserver() = default;
+        explicit ReadWriteObserver(Callback in_callback);
+
+        /// function called with each ReadWriteEvent, by the default report() implementation.
+        Callback callback;
+
+        /// optional instrumentation, such as the vsg::Viewer's vsg::TracyInstrumentation, that each read and write is reported to as a CPU zone.
+        vsg::ref_ptr<vsg::Instrumentation> instrumentation;
+
+        /// called once each read or write completes, override to collect the events directly.
+        virtual void report(const ReadWriteEvent& event);
+    };
+
+    /// return the ReadWriteEvent of the observed read or write in progress on the current thread, or null if there isn't one.
+    extern VSGXCHANGE_DECLSPEC ReadWriteEvent* currentReadWriteEvent();
+
+    /// make event the current thread's ReadWriteEvent, returning the previous one so it can be restored when the nested read or write completes. Called by IndexedCompositeReaderWriter.
+    extern VSGXCHANGE_DECLSPEC ReadWriteEvent* setCurrentReadWriteEvent(ReadWriteEvent* event);
+
+    /// times consecutive phases of the observed read or write in progress on the current thread, adding each to its ReadWriteEvent::phases, does nothing when the read or write isn't observed.
+    /// Used by ReaderWriters to break down where their time goes, i.e. ReadWritePhaseTimer timer("parse"); ... timer.next("convert"); ... with the last phase ending when the timer is destroyed.
+    class VSGXCHANGE_DECLSPEC ReadWritePhaseTimer
+    {
+    public:
+        explicit ReadWritePhaseTimer(const char* name);
+        ReadWritePhaseTimer(const ReadWritePhaseTimer&) = delete;
+        ReadWritePhaseTimer& operator=(const ReadWritePhaseTimer&) = delete;
+        ~ReadWritePhaseTimer();
+
+        /// end the current phase and start the named one.
+        void next(const char* name);
+
+        /// end the current phase.
+        void end();
+
+    protected:
+        ReadWriteEvent* _event = nullptr;
+        const char* _name = nullptr;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+} // namespace vsgXchange
+
+EVSG_type_name(vsgXchange::ReadWriteObserver);
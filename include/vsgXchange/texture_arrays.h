@@ -0,0 +1,55 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/core/Data.h>
+#include <vsg/utils/ShaderSet.h>
+#include <vsgXchange/Version.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace vsgXchange
+{
+    /// name of the per instance float vertex attribute that selects the layer of the textures sampled from texture arrays by a ShaderSet converted with convertToTextureArrays().
+    static constexpr const char* texture_layer_attribute = "vsg_TextureLayer";
+
+    /// maximum number of layers of the texture arrays created by createTextureArray(), the minimum VkPhysicalDeviceLimits::maxImageArrayLayers required by Vulkan.
+    static constexpr uint32_t max_texture_array_layers = 256;
+
+    /// rewrite the GLSL shaders of shaderSet so the named textures are sampled from VK_IMAGE_VIEW_TYPE_2D_ARRAY images, at the layer selected by the texture_layer_attribute.
+    /// Materials that only differ by their textures can then share a single descriptor set, with each mesh selecting its material's layer.
+    /// shaderSet is modified in place so must not yet be shared, such as one just created by vsg::createPhysicsBasedRenderingShaderSet().
+    /// Returns the names of the textures converted, or an empty set, leaving shaderSet unchanged, if the shaders don't have GLSL source or use a texture in a way that can't be rewritten.
+    extern VSGXCHANGE_DECLSPEC std::set<std::string> convertToTextureArrays(vsg::ShaderSet& shaderSet, const std::set<std::string>& textureNames);
+
+    /// return true if data can be a layer of a texture array, an uncompressed or block compressed 2D image without stored mipmaps.
+    extern VSGXCHANGE_DECLSPEC bool textureArrayCompatible(const vsg::Data& data);
+
+    /// stack layers of the same dimensions and format into a single VK_IMAGE_VIEW_TYPE_2D_ARRAY image, allocated against the read's read_memory_budget.
+    /// Returns null if the layers aren't all textureArrayCompatible() with the same dimensions and format, or the allocation would exceed the budget.
+    extern VSGXCHANGE_DECLSPEC vsg::ref_ptr<vsg::Data> createTextureArray(const std::vector<vsg::ref_ptr<vsg::Data>>& layers);
+
+} // namespace vsgXchange
@@ -0,0 +1,95 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/core/Inherit.h>
+#include <vsg/io/Options.h>
+#include <vsg/io/Path.h>
+#include <vsgXchange/Version.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vsgXchange
+{
+    /// service that writes objects to file on a pool of worker threads, so that callers such as render loops capturing frames or batch converters don't block on encoding and file I/O.
+    /// The memory held by the vsg::Data referenced by queued objects is bounded, write() blocks while the limit is exceeded to provide back-pressure, and flush() waits for all queued writes to complete.
+    class VSGXCHANGE_DECLSPEC WriteQueue : public vsg::Inherit<vsg::Object, WriteQueue>
+    {
+    public:
+        explicit WriteQueue(uint32_t numThreads = 2, size_t maxPendingBytes = 256 * 1024 * 1024, vsg::ref_ptr<const vsg::Options> in_options = {});
+
+        /// options used by writes that don't provide their own.
+        vsg::ref_ptr<const vsg::Options> options;
+
+        /// create the directory of the filename if it doesn't already exist before writing, defaults to true.
+        bool makeDirectory = true;
+
+        /// queue the object to be written to filename, blocking while the vsg::Data referenced by pending writes exceeds maxPendingBytes. Return false if the queue has been stopped.
+        /// The object must not be modified until it has been written.
+        bool write(vsg::ref_ptr<vsg::Object> object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> writeOptions = {});
+
+        /// wait until all the writes queued so far have completed.
+        void flush();
+
+        /// complete any queued writes and stop the worker threads, subsequent calls to write() return false.
+        void stop();
+
+        /// number of writes that are queued or in progress.
+        size_t pending() const;
+
+        /// number of writes that have failed since the WriteQueue was created.
+        size_t numFailed() const;
+
+    protected:
+        virtual ~WriteQueue();
+
+        struct Request
+        {
+            vsg::ref_ptr<vsg::Object> object;
+            vsg::Path filename;
+            vsg::ref_ptr<const vsg::Options> options;
+            size_t size = 0;
+        };
+
+        void run();
+
+        const size_t _maxPendingBytes;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _requestAvailable;
+        std::condition_variable _requestCompleted;
+        std::deque<Request> _requests;
+        std::vector<std::thread> _threads;
+        size_t _pendingBytes = 0;
+        size_t _numActive = 0;
+        size_t _numFailed = 0;
+        bool _stopped = false;
+    };
+} // namespace vsgXchange
+
+EVSG_type_name(vsgXchange::WriteQueue);
@@ -11,6 +11,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 </editor-fold> */
 
 #include <vsgXchange/all.h>
+#include <vsgXchange/archive.h>
 #include <vsgXchange/cpp.h>
 #include <vsgXchange/curl.h>
 #include <vsgXchange/freetype.h>
@@ -42,18 +43,129 @@ void vsgXchange::init()
     vsg::ObjectFactory::instance()->add<vsgXchange::curl>();
 
     vsg::ObjectFactory::instance()->add<vsgXchange::cpp>();
+    vsg::ObjectFactory::instance()->add<vsgXchange::archive>();
 
     vsg::ObjectFactory::instance()->add<vsgXchange::stbi>();
+    vsg::ObjectFactory::instance()->add<vsgXchange::turbojpeg>();
     vsg::ObjectFactory::instance()->add<vsgXchange::dds>();
     vsg::ObjectFactory::instance()->add<vsgXchange::ktx>();
 
     vsg::ObjectFactory::instance()->add<vsgXchange::openexr>();
     vsg::ObjectFactory::instance()->add<vsgXchange::freetype>();
+    vsg::ObjectFactory::instance()->add<vsgXchange::gltf>();
+    vsg::ObjectFactory::instance()->add<vsgXchange::pointcloud>();
     vsg::ObjectFactory::instance()->add<vsgXchange::assimp>();
+    vsg::ObjectFactory::instance()->add<vsgXchange::JointPaletteSampler>();
     vsg::ObjectFactory::instance()->add<vsgXchange::GDAL>();
     //    vsg::ObjectFactory::instance()->add<vsgXchange::OSG>();
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LazyReaderWriter
+//
+LazyReaderWriter::LazyReaderWriter(const std::string& in_implementationClassName, const Features& in_features, CreateFunction in_create) :
+    implementationClassName(in_implementationClassName),
+    _features(in_features),
+    _create(in_create)
+{
+}
+
+vsg::ref_ptr<vsg::ReaderWriter> LazyReaderWriter::implementation() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    if (!_implementation && _create)
+    {
+        vsg::debug("LazyReaderWriter creating ", implementationClassName);
+        _implementation = _create();
+    }
+    return _implementation;
+}
+
+bool LazyReaderWriter::created() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _implementation.valid();
+}
+
+bool LazyReaderWriter::supported(const vsg::Path& ext, FeatureMask mask) const
+{
+    auto itr = _features.extensionFeatureMap.find(ext);
+    return itr != _features.extensionFeatureMap.end() && (itr->second & mask) != 0;
+}
+
+bool LazyReaderWriter::supportedFilename(const vsg::Path& filename, const vsg::Options* options, FeatureMask mask) const
+{
+    auto ext = vsg::lowerCaseFileExtension(filename);
+    if (!ext && options) ext = options->extensionHint;
+
+    // without an extension or hint only the ReaderWriter itself can identify the file, so pass it through as if the ReaderWriter had been created up front
+    if (!ext) return true;
+
+    return supported(ext, mask);
+}
+
+vsg::ref_ptr<vsg::Object> LazyReaderWriter::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!supportedFilename(filename, options.get(), READ_FILENAME)) return {};
+    auto rw = implementation();
+    return rw ? rw->read(filename, options) : vsg::ref_ptr<vsg::Object>();
+}
+
+vsg::ref_ptr<vsg::Object> LazyReaderWriter::read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!options || !supported(options->extensionHint, READ_ISTREAM)) return {};
+    auto rw = implementation();
+    return rw ? rw->read(fin, options) : vsg::ref_ptr<vsg::Object>();
+}
+
+vsg::ref_ptr<vsg::Object> LazyReaderWriter::read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!options || !supported(options->extensionHint, READ_MEMORY)) return {};
+    auto rw = implementation();
+    return rw ? rw->read(ptr, size, options) : vsg::ref_ptr<vsg::Object>();
+}
+
+bool LazyReaderWriter::write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!supportedFilename(filename, options.get(), WRITE_FILENAME)) return false;
+    auto rw = implementation();
+    return rw && rw->write(object, filename, options);
+}
+
+bool LazyReaderWriter::write(const vsg::Object* object, std::ostream& fout, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!options || !supported(options->extensionHint, WRITE_OSTREAM)) return false;
+    auto rw = implementation();
+    return rw && rw->write(object, fout, options);
+}
+
+bool LazyReaderWriter::readOptions(vsg::Options& options, vsg::CommandLine& arguments) const
+{
+    bool optionUsed = false;
+    for (int i = 1; i < arguments.argc() && !optionUsed; ++i)
+    {
+        std::string argument(arguments[i]);
+        optionUsed = _features.optionNameTypeMap.count(argument) != 0 || (argument.compare(0, 2, "--") == 0 && _features.optionNameTypeMap.count(argument.substr(2)) != 0);
+    }
+    if (!optionUsed) return false;
+
+    auto rw = implementation();
+    return rw && rw->readOptions(options, arguments);
+}
+
+bool LazyReaderWriter::getFeatures(Features& features) const
+{
+    features.extensionFeatureMap.insert(_features.extensionFeatureMap.begin(), _features.extensionFeatureMap.end());
+    features.protocolFeatureMap.insert(_features.protocolFeatureMap.begin(), _features.protocolFeatureMap.end());
+    features.optionNameTypeMap.insert(_features.optionNameTypeMap.begin(), _features.optionNameTypeMap.end());
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// all
+//
 all::all()
 {
     // for convenience make sure the init() method is called
@@ -69,7 +181,11 @@ all::all()
     add(vsg::txt::create());
 
     add(cpp::create());
+    add(archive::create());
 
+#ifdef vsgXchange_turbojpeg
+    add(turbojpeg::create());
+#endif
     add(stbi::create());
     add(dds::create());
     add(ktx::create());
@@ -82,12 +198,22 @@ all::all()
     add(freetype::create());
 #endif
 
+    // glTF files are read natively, falling back to assimp for the files using features the gltf ReaderWriter doesn't support
+    add(gltf::create());
+    add(pointcloud::create());
+
+    // assimp and GDAL are only created when one of their extensions is first read, avoiding registering all their importers and drivers at startup.
+    // curl isn't deferred as it already leaves curl_global_init() to the first read of a URL.
 #ifdef vsgXchange_assimp
-    add(assimp::create());
+    Features assimpFeatures;
+    assimp::getStaticFeatures(assimpFeatures);
+    add(LazyReaderWriter::create(vsg::type_name<assimp>(), assimpFeatures, []() { return vsg::ref_ptr<vsg::ReaderWriter>(assimp::create()); }));
 #endif
 
 #ifdef vsgXchange_GDAL
-    add(GDAL::create());
+    Features gdalFeatures;
+    GDAL::getStaticFeatures(gdalFeatures);
+    add(LazyReaderWriter::create(vsg::type_name<GDAL>(), gdalFeatures, []() { return vsg::ref_ptr<vsg::ReaderWriter>(GDAL::create()); }));
 #endif
 
 #ifdef vsgXchange_OSG
@@ -0,0 +1,659 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include "block_decompress.h"
+#include "parallel_for.h"
+
+#include <vsgXchange/images.h>
+
+#include <vsg/core/Array2D.h>
+#include <vsg/core/Array3D.h>
+#include <vsg/io/Logger.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// ETC2 and EAC block decoders from the vendored libktx/etcdec.cxx
+extern void setupAlphaTable();
+extern void decompressBlockETC2c(unsigned int block_part1, unsigned int block_part2, uint8_t* img, int width, int height, int startx, int starty, int channels);
+extern void decompressBlockETC21BitAlphaC(unsigned int block_part1, unsigned int block_part2, uint8_t* img, uint8_t* alphaimg, int width, int height, int startx, int starty, int channelsRGB);
+extern void decompressBlockAlphaC(uint8_t* data, uint8_t* img, int width, int height, int ix, int iy, int channels);
+extern void decompressBlockAlpha16bitC(uint8_t* data, uint8_t* img, int width, int height, int ix, int iy, int channels);
+
+using namespace vsgXchange;
+
+namespace
+{
+    enum class BlockFormat
+    {
+        Unsupported,
+        BC1,
+        BC1_ALPHA,
+        BC2,
+        BC3,
+        BC4,
+        BC5,
+        BC7,
+        ETC2,
+        ETC2_A1,
+        ETC2_A8,
+        EAC_R11,
+        EAC_RG11
+    };
+
+    BlockFormat blockFormat(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK: return BlockFormat::BC1;
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: return BlockFormat::BC1_ALPHA;
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK: return BlockFormat::BC2;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK: return BlockFormat::BC3;
+        case VK_FORMAT_BC4_UNORM_BLOCK: return BlockFormat::BC4;
+        case VK_FORMAT_BC5_UNORM_BLOCK: return BlockFormat::BC5;
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK: return BlockFormat::BC7;
+        case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK: return BlockFormat::ETC2;
+        case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK: return BlockFormat::ETC2_A1;
+        case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK: return BlockFormat::ETC2_A8;
+        case VK_FORMAT_EAC_R11_UNORM_BLOCK: return BlockFormat::EAC_R11;
+        case VK_FORMAT_EAC_R11G11_UNORM_BLOCK: return BlockFormat::EAC_RG11;
+        default: return BlockFormat::Unsupported;
+        }
+    }
+
+    bool isSRGB(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK: return true;
+        default: return false;
+        }
+    }
+
+    size_t blockSize(BlockFormat format)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1:
+        case BlockFormat::BC1_ALPHA:
+        case BlockFormat::BC4:
+        case BlockFormat::ETC2:
+        case BlockFormat::ETC2_A1:
+        case BlockFormat::EAC_R11: return 8;
+        default: return 16;
+        }
+    }
+
+    // a decoded 4x4 block of RGBA pixels, in row order
+    using Pixels = uint8_t[16][4];
+
+    void expand565(uint16_t color, uint8_t* rgb)
+    {
+        const uint32_t r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+        rgb[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+        rgb[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+        rgb[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+    }
+
+    // BC1 color block, also used by BC2 and BC3 which always use the four color mode
+    void decodeBC1(const uint8_t* src, Pixels& pixels, bool transparent, bool fourColor)
+    {
+        const uint16_t c0 = static_cast<uint16_t>(src[0] | (src[1] << 8));
+        const uint16_t c1 = static_cast<uint16_t>(src[2] | (src[3] << 8));
+
+        uint8_t colors[4][4];
+        expand565(c0, colors[0]);
+        expand565(c1, colors[1]);
+        colors[0][3] = colors[1][3] = colors[2][3] = colors[3][3] = 255;
+
+        if (fourColor || c0 > c1)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                colors[2][c] = static_cast<uint8_t>((2 * colors[0][c] + colors[1][c] + 1) / 3);
+                colors[3][c] = static_cast<uint8_t>((colors[0][c] + 2 * colors[1][c] + 1) / 3);
+            }
+        }
+        else
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                colors[2][c] = static_cast<uint8_t>((colors[0][c] + colors[1][c] + 1) / 2);
+                colors[3][c] = 0;
+            }
+            if (transparent) colors[3][3] = 0;
+        }
+
+        const uint32_t indices = src[4] | (src[5] << 8) | (src[6] << 16) | (static_cast<uint32_t>(src[7]) << 24);
+        for (uint32_t i = 0; i < 16; ++i) std::memcpy(pixels[i], colors[(indices >> (2 * i)) & 3], 4);
+    }
+
+    // BC4 single channel block, also used for the alpha of BC3 and the red and green of BC5
+    void decodeBC4(const uint8_t* src, Pixels& pixels, int channel)
+    {
+        uint32_t values[8] = {src[0], src[1]};
+        if (values[0] > values[1])
+        {
+            for (uint32_t i = 2; i < 8; ++i) values[i] = ((8 - i) * values[0] + (i - 1) * values[1] + 3) / 7;
+        }
+        else
+        {
+            for (uint32_t i = 2; i < 6; ++i) values[i] = ((6 - i) * values[0] + (i - 1) * values[1] + 2) / 5;
+            values[6] = 0;
+            values[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; ++i) indices |= static_cast<uint64_t>(src[2 + i]) << (8 * i);
+        for (uint32_t i = 0; i < 16; ++i) pixels[i][channel] = static_cast<uint8_t>(values[(indices >> (3 * i)) & 7]);
+    }
+
+    // BC7 mode descriptions from the BC7 specification
+    struct BC7Mode
+    {
+        uint8_t numSubsets;
+        uint8_t partitionBits;
+        uint8_t rotationBits;
+        uint8_t indexSelectionBits;
+        uint8_t colorBits;
+        uint8_t alphaBits;
+        uint8_t endpointPBits;
+        uint8_t sharedPBits;
+        uint8_t indexBits;
+        uint8_t secondaryIndexBits;
+    };
+
+    const BC7Mode s_bc7Modes[8] = {
+        {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+        {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+        {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+        {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+        {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+        {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+        {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+        {2, 6, 0, 0, 5, 5, 1, 0, 2, 0}};
+
+    // subset of each pixel of the 2 subset partitions, one bit per pixel
+    const uint16_t s_bc7Partitions2[64] = {
+        0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+        0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+        0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+        0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+        0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+        0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+        0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+        0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+    };
+
+    const uint8_t s_bc7Partitions3[64][16] = {
+        {0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2},
+        {0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+        {0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+        {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+        {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2},
+        {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+        {0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1},
+        {0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+        {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2},
+        {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+        {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+        {0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+        {0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2},
+        {0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+        {0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+        {0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+        {0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2},
+        {0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+        {0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2},
+        {0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+        {0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2},
+        {0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+        {0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2},
+        {0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+        {0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0},
+        {0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+        {0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0},
+        {0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+        {0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2},
+        {0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+        {0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1},
+        {0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+        {0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+        {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+        {0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2},
+        {0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+        {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0},
+        {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+        {0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0},
+        {0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+        {0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1},
+        {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+        {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1},
+        {0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+        {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1},
+        {0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+        {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1},
+        {0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+        {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2},
+        {0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+        {0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2},
+        {0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+        {0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2},
+        {0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+        {0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2},
+        {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+        {0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2},
+        {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+        {0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+        {0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1},
+        {0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+        {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
+        {0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0},
+    };
+
+    // index of the anchor pixel of the second subset of the 2 subset partitions, and the second and third subsets of the 3 subset partitions
+    const uint8_t s_bc7Anchors2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+        15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+        6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+    };
+
+    const uint8_t s_bc7Anchors3Second[64] = {
+        3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+        3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+        8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+        3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,
+    };
+
+    const uint8_t s_bc7Anchors3Third[64] = {
+        15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+        15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+        15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+        15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8,
+    };
+
+    const uint32_t s_bc7Weights2[4] = {0, 21, 43, 64};
+    const uint32_t s_bc7Weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+    const uint32_t s_bc7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    const uint32_t* bc7Weights(uint32_t indexBits)
+    {
+        return (indexBits == 2) ? s_bc7Weights2 : ((indexBits == 3) ? s_bc7Weights3 : s_bc7Weights4);
+    }
+
+    // read the bits of a 128 bit block, least significant bit first
+    struct BitReader
+    {
+        uint64_t low = 0;
+        uint64_t high = 0;
+        uint32_t position = 0;
+
+        explicit BitReader(const uint8_t* src)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                low |= static_cast<uint64_t>(src[i]) << (8 * i);
+                high |= static_cast<uint64_t>(src[8 + i]) << (8 * i);
+            }
+        }
+
+        uint32_t read(uint32_t numBits)
+        {
+            if (numBits == 0) return 0;
+
+            uint64_t value;
+            if (position >= 64)
+                value = high >> (position - 64);
+            else if (position + numBits <= 64)
+                value = low >> position;
+            else
+                value = (low >> position) | (high << (64 - position));
+
+            position += numBits;
+            return static_cast<uint32_t>(value) & ((1u << numBits) - 1);
+        }
+    };
+
+    uint32_t expandBits(uint32_t value, uint32_t numBits)
+    {
+        value <<= (8 - numBits);
+        return value | (value >> numBits);
+    }
+
+    void decodeBC7(const uint8_t* src, Pixels& pixels)
+    {
+        uint32_t mode = 0;
+        while (mode < 8 && (src[0] & (1 << mode)) == 0) ++mode;
+
+        // the reserved mode decodes to transparent black
+        if (mode == 8)
+        {
+            std::memset(pixels, 0, sizeof(Pixels));
+            return;
+        }
+
+        const auto& m = s_bc7Modes[mode];
+        BitReader bits(src);
+        bits.read(mode + 1);
+
+        const uint32_t partition = bits.read(m.partitionBits);
+        const uint32_t rotation = bits.read(m.rotationBits);
+        const uint32_t indexSelection = bits.read(m.indexSelectionBits);
+
+        // endpoints are stored as all the red values, then green, blue and alpha
+        const uint32_t numEndpoints = m.numSubsets * 2u;
+        uint32_t endpoints[6][4];
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            for (uint32_t e = 0; e < numEndpoints; ++e) endpoints[e][c] = bits.read(m.colorBits);
+        }
+        for (uint32_t e = 0; e < numEndpoints; ++e) endpoints[e][3] = m.alphaBits ? bits.read(m.alphaBits) : 255;
+
+        uint32_t colorBits = m.colorBits;
+        uint32_t alphaBits = m.alphaBits;
+        if (m.endpointPBits || m.sharedPBits)
+        {
+            uint32_t pbits[6];
+            if (m.endpointPBits)
+            {
+                for (uint32_t e = 0; e < numEndpoints; ++e) pbits[e] = bits.read(1);
+            }
+            else
+            {
+                for (uint32_t s = 0; s < m.numSubsets; ++s) pbits[2 * s] = pbits[2 * s + 1] = bits.read(1);
+            }
+
+            for (uint32_t e = 0; e < numEndpoints; ++e)
+            {
+                for (uint32_t c = 0; c < 3; ++c) endpoints[e][c] = (endpoints[e][c] << 1) | pbits[e];
+                if (alphaBits) endpoints[e][3] = (endpoints[e][3] << 1) | pbits[e];
+            }
+
+            ++colorBits;
+            if (alphaBits) ++alphaBits;
+        }
+
+        for (uint32_t e = 0; e < numEndpoints; ++e)
+        {
+            for (uint32_t c = 0; c < 3; ++c) endpoints[e][c] = expandBits(endpoints[e][c], colorBits);
+            if (alphaBits) endpoints[e][3] = expandBits(endpoints[e][3], alphaBits);
+        }
+
+        auto subset = [&](uint32_t i) -> uint32_t {
+            if (m.numSubsets == 2) return (s_bc7Partitions2[partition] >> i) & 1;
+            if (m.numSubsets == 3) return s_bc7Partitions3[partition][i];
+            return 0;
+        };
+
+        // the anchor pixel of each subset has its index's most significant bit implicitly zero
+        auto anchor = [&](uint32_t i) {
+            if (i == 0) return true;
+            if (m.numSubsets == 2) return i == s_bc7Anchors2[partition];
+            if (m.numSubsets == 3) return i == s_bc7Anchors3Second[partition] || i == s_bc7Anchors3Third[partition];
+            return false;
+        };
+
+        uint32_t indices[16];
+        for (uint32_t i = 0; i < 16; ++i) indices[i] = bits.read(anchor(i) ? m.indexBits - 1u : m.indexBits);
+
+        uint32_t secondaryIndices[16] = {};
+        if (m.secondaryIndexBits)
+        {
+            for (uint32_t i = 0; i < 16; ++i) secondaryIndices[i] = bits.read(i == 0 ? m.secondaryIndexBits - 1u : m.secondaryIndexBits);
+        }
+
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const uint32_t s = subset(i);
+            const uint32_t* e0 = endpoints[2 * s];
+            const uint32_t* e1 = endpoints[2 * s + 1];
+
+            // modes 4 and 5 have separate color and alpha indices, with mode 4's index selection bit choosing which uses the 3 bit indices
+            uint32_t colorWeight = bc7Weights(m.indexBits)[indices[i]];
+            uint32_t alphaWeight = colorWeight;
+            if (m.secondaryIndexBits)
+            {
+                if (indexSelection)
+                    colorWeight = bc7Weights(m.secondaryIndexBits)[secondaryIndices[i]];
+                else
+                    alphaWeight = bc7Weights(m.secondaryIndexBits)[secondaryIndices[i]];
+            }
+
+            auto& pixel = pixels[i];
+            for (uint32_t c = 0; c < 3; ++c) pixel[c] = static_cast<uint8_t>(((64 - colorWeight) * e0[c] + colorWeight * e1[c] + 32) >> 6);
+            pixel[3] = static_cast<uint8_t>(((64 - alphaWeight) * e0[3] + alphaWeight * e1[3] + 32) >> 6);
+
+            if (rotation > 0) std::swap(pixel[rotation - 1], pixel[3]);
+        }
+    }
+
+    uint32_t readBigEndian(const uint8_t* src)
+    {
+        return (static_cast<uint32_t>(src[0]) << 24) | (src[1] << 16) | (src[2] << 8) | src[3];
+    }
+
+    // EAC 11 bit channel, decoded by etcdec to 16 bits and reduced to 8 bits
+    void decodeEAC11(const uint8_t* src, Pixels& pixels, int channel)
+    {
+        uint8_t block[8];
+        std::memcpy(block, src, 8);
+
+        uint16_t values[16];
+        decompressBlockAlpha16bitC(block, reinterpret_cast<uint8_t*>(values), 4, 4, 0, 0, 1);
+        for (uint32_t i = 0; i < 16; ++i) pixels[i][channel] = static_cast<uint8_t>(values[i] >> 8);
+    }
+
+    void decodeBlock(BlockFormat format, const uint8_t* src, Pixels& pixels)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1: decodeBC1(src, pixels, false, false); break;
+        case BlockFormat::BC1_ALPHA: decodeBC1(src, pixels, true, false); break;
+        case BlockFormat::BC2:
+            decodeBC1(src + 8, pixels, false, true);
+            for (uint32_t i = 0; i < 16; ++i) pixels[i][3] = static_cast<uint8_t>(((src[i / 2] >> ((i & 1) * 4)) & 15) * 17);
+            break;
+        case BlockFormat::BC3:
+            decodeBC1(src + 8, pixels, false, true);
+            decodeBC4(src, pixels, 3);
+            break;
+        case BlockFormat::BC4:
+            std::memset(pixels, 0, sizeof(Pixels));
+            decodeBC4(src, pixels, 0);
+            for (auto& pixel : pixels) pixel[3] = 255;
+            break;
+        case BlockFormat::BC5:
+            std::memset(pixels, 0, sizeof(Pixels));
+            decodeBC4(src, pixels, 0);
+            decodeBC4(src + 8, pixels, 1);
+            for (auto& pixel : pixels) pixel[3] = 255;
+            break;
+        case BlockFormat::BC7: decodeBC7(src, pixels); break;
+        case BlockFormat::ETC2:
+            std::memset(pixels, 255, sizeof(Pixels));
+            decompressBlockETC2c(readBigEndian(src), readBigEndian(src + 4), &pixels[0][0], 4, 4, 0, 0, 4);
+            break;
+        case BlockFormat::ETC2_A1:
+            decompressBlockETC21BitAlphaC(readBigEndian(src), readBigEndian(src + 4), &pixels[0][0], nullptr, 4, 4, 0, 0, 4);
+            break;
+        case BlockFormat::ETC2_A8: {
+            uint8_t alphaBlock[8];
+            std::memcpy(alphaBlock, src, 8);
+            decompressBlockETC2c(readBigEndian(src + 8), readBigEndian(src + 12), &pixels[0][0], 4, 4, 0, 0, 4);
+            decompressBlockAlphaC(alphaBlock, &pixels[0][3], 4, 4, 0, 0, 4);
+            break;
+        }
+        case BlockFormat::EAC_R11:
+            std::memset(pixels, 0, sizeof(Pixels));
+            decodeEAC11(src, pixels, 0);
+            for (auto& pixel : pixels) pixel[3] = 255;
+            break;
+        case BlockFormat::EAC_RG11:
+            std::memset(pixels, 0, sizeof(Pixels));
+            decodeEAC11(src, pixels, 0);
+            decodeEAC11(src + 8, pixels, 1);
+            for (auto& pixel : pixels) pixel[3] = 255;
+            break;
+        default: std::memset(pixels, 0, sizeof(Pixels)); break;
+        }
+    }
+
+    // a row of blocks of one level and layer, decoded into the rows of pixels it covers
+    struct BlockRow
+    {
+        const uint8_t* src;
+        uint8_t* dest;
+        uint32_t width;
+        uint32_t numRows;
+    };
+
+} // namespace
+
+std::string vsgXchange::compressedFormatFamily(VkFormat format)
+{
+    if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK) return "bc";
+    if (format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK) return "etc2";
+    if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK) return "astc";
+    return {};
+}
+
+bool vsgXchange::canDecompress(VkFormat format)
+{
+    return blockFormat(format) != BlockFormat::Unsupported;
+}
+
+vsg::ref_ptr<vsg::Data> vsgXchange::decompressImage(const vsg::Data& image, uint32_t numThreads)
+{
+    const auto& properties = image.properties;
+    const auto format = blockFormat(properties.format);
+    if (format == BlockFormat::Unsupported || properties.blockWidth != 4 || properties.blockHeight != 4) return {};
+    if (properties.imageViewType == VK_IMAGE_VIEW_TYPE_1D || properties.imageViewType == VK_IMAGE_VIEW_TYPE_1D_ARRAY) return {};
+
+    // the mip levels of 3D images halve in depth, while the layers of arrays and cubemaps are in every level
+    const bool is3D = properties.imageViewType == VK_IMAGE_VIEW_TYPE_3D;
+    const uint32_t width = image.width() * properties.blockWidth;
+    const uint32_t height = image.height() * properties.blockHeight;
+    const uint32_t depth = image.depth();
+    const size_t srcBlockSize = blockSize(format);
+
+    // lay out the rows of blocks of each level, the levels' data following each other as vsg::Data::Properties::maxNumMipmaps describes
+    std::vector<BlockRow> rows;
+    std::vector<size_t> destOffsets;
+    const uint8_t* src = static_cast<const uint8_t*>(image.dataPointer());
+    const uint32_t numLevels = std::max(1u, static_cast<uint32_t>(properties.maxNumMipmaps));
+    size_t destSize = 0;
+    for (uint32_t level = 0; level < numLevels; ++level)
+    {
+        const uint32_t w = std::max(1u, width >> level);
+        const uint32_t h = std::max(1u, height >> level);
+        const uint32_t d = is3D ? std::max(1u, depth >> level) : depth;
+        const uint32_t blocksX = (w + 3) / 4;
+        const uint32_t blocksY = (h + 3) / 4;
+
+        for (uint32_t layer = 0; layer < d; ++layer)
+        {
+            for (uint32_t by = 0; by < blocksY; ++by)
+            {
+                // the destination pointers are assigned from the offsets once the decoded image is allocated
+                rows.push_back(BlockRow{src + (static_cast<size_t>(layer) * blocksY + by) * blocksX * srcBlockSize, nullptr, w, std::min(4u, h - by * 4)});
+                destOffsets.push_back(destSize + (static_cast<size_t>(layer) * h + by * 4) * w * 4);
+            }
+        }
+
+        src += static_cast<size_t>(blocksX) * blocksY * d * srcBlockSize;
+        destSize += static_cast<size_t>(w) * h * d * 4;
+    }
+
+    auto dest = static_cast<uint8_t*>(vsg::allocate(destSize, vsg::ALLOCATOR_AFFINITY_DATA));
+    for (size_t i = 0; i < rows.size(); ++i) rows[i].dest = dest + destOffsets[i];
+
+    static std::once_flag s_alphaTableInitialized;
+    std::call_once(s_alphaTableInitialized, setupAlphaTable);
+
+    // decode the rows of blocks in parallel, only spreading over threads when there are enough blocks to amortize starting them
+    const size_t numBlocks = destSize / (16 * 4);
+    numThreads = static_cast<uint32_t>(std::min<size_t>(numThreads, std::max<size_t>(1, numBlocks / 4096)));
+    parallel_for(rows.size(), numThreads, [&](size_t i) {
+        const auto& row = rows[i];
+        Pixels pixels;
+        const uint8_t* block = row.src;
+        for (uint32_t x = 0; x < row.width; x += 4, block += srcBlockSize)
+        {
+            decodeBlock(format, block, pixels);
+
+            const uint32_t numColumns = std::min(4u, row.width - x);
+            for (uint32_t y = 0; y < row.numRows; ++y)
+            {
+                std::memcpy(row.dest + (static_cast<size_t>(y) * row.width + x) * 4, pixels[y * 4], numColumns * 4);
+            }
+        }
+    });
+
+    auto layout = properties;
+    layout.format = isSRGB(properties.format) ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    layout.stride = 4;
+    layout.blockWidth = 1;
+    layout.blockHeight = 1;
+    layout.blockDepth = 1;
+    layout.maxNumMipmaps = static_cast<uint8_t>(numLevels);
+
+    if (depth > 1 || is3D) return vsg::ubvec4Array3D::create(width, height, depth, reinterpret_cast<vsg::ubvec4*>(dest), layout);
+    return vsg::ubvec4Array2D::create(width, height, reinterpret_cast<vsg::ubvec4*>(dest), layout);
+}
+
+vsg::ref_ptr<vsg::Data> vsgXchange::decompressUnsupportedFormat(vsg::ref_ptr<vsg::Data> image, const vsg::Options* options)
+{
+    std::string supportedFormats;
+    if (!image || !options || !options->getValue(images::supported_compressed_formats, supportedFormats)) return image;
+
+    const auto family = compressedFormatFamily(image->properties.format);
+    if (family.empty()) return image;
+
+    std::stringstream sstr(supportedFormats);
+    std::string supported;
+    while (std::getline(sstr, supported, ','))
+    {
+        supported.erase(0, supported.find_first_not_of(' '));
+        supported.erase(supported.find_last_not_of(' ') + 1);
+        std::transform(supported.begin(), supported.end(), supported.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        if (supported == family) return image;
+    }
+
+    if (auto decompressed = decompressImage(*image, std::max(1u, std::thread::hardware_concurrency()))) return decompressed;
+
+    vsg::warn("vsgXchange::decompressUnsupportedFormat() no decoder for VkFormat ", image->properties.format, ", image left in a format the device doesn't support.");
+    return image;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <vsg/core/Data.h>
+#include <vsg/io/Options.h>
+
+#include <string>
+
+namespace vsgXchange
+{
+    /// return the family of a block compressed format, "bc", "etc2" or "astc", matching the textureCompressionBC, textureCompressionETC2 and textureCompressionASTC_LDR device features, or an empty string for other formats.
+    extern std::string compressedFormatFamily(VkFormat format);
+
+    /// return true if decompressImage() can decode the format.
+    extern bool canDecompress(VkFormat format);
+
+    /// decode a block compressed image, including its mip levels and array layers, to R8G8B8A8 using up to numThreads threads to decode the rows of blocks.
+    /// Supports BC1 to BC5, BC7, ETC2 and the unsigned EAC formats, returns null for other formats.
+    extern vsg::ref_ptr<vsg::Data> decompressImage(const vsg::Data& image, uint32_t numThreads);
+
+    /// decode the image to R8G8B8A8 if it's block compressed in a format family not listed in the images::supported_compressed_formats option, otherwise return it unchanged.
+    extern vsg::ref_ptr<vsg::Data> decompressUnsupportedFormat(vsg::ref_ptr<vsg::Data> image, const vsg::Options* options);
+
+} // namespace vsgXchange
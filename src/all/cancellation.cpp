@@ -0,0 +1,37 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <vsgXchange/cancellation.h>
+
+using namespace vsgXchange;
+
+CancellationToken::CancellationToken(const CancellationToken& rhs, const vsg::CopyOp& copyop) :
+    Inherit(rhs, copyop),
+    _cancelled(rhs._cancelled.load())
+{
+}
+
+void vsgXchange::setCancellationToken(vsg::Options& options, vsg::ref_ptr<CancellationToken> token)
+{
+    if (token)
+        options.setObject(cancellation_token, token);
+    else
+        options.removeObject(cancellation_token);
+}
+
+const CancellationToken* vsgXchange::getCancellationToken(const vsg::Options* options)
+{
+    // most reads don't have any auxiliary values, so avoid the lookup
+    if (!options || !options->getAuxiliary()) return nullptr;
+    return options->getObject<CancellationToken>(cancellation_token);
+}
@@ -0,0 +1,250 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+
+#include "color_space.h"
+
+#include <vsgXchange/images.h>
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define VSGXCHANGE_COLOR_SPACE_SSE2
+#    include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    define VSGXCHANGE_COLOR_SPACE_NEON
+#    include <arm_neon.h>
+#endif
+
+using namespace vsgXchange;
+
+namespace
+{
+    // the piecewise sRGB transfer functions, matching vsg::sRGB_to_linear() and vsg::linear_to_sRGB()
+    inline float sRGB_to_linear(float c)
+    {
+        if (c <= 0.04045f) return c * (1.0f / 12.92f);
+        return std::pow((c + 0.055f) * (1.0f / 1.055f), 2.4f);
+    }
+
+    inline float linear_to_sRGB(float c)
+    {
+        if (c <= 0.0031308f) return c * 12.92f;
+        return 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // 4096 segments keep the interpolation error below 2e-5, well under the 1/255 step of 8bit colours
+    constexpr int tableSegments = 4096;
+
+    struct Tables
+    {
+        // one extra entry so that an input of exactly 1.0 can still interpolate towards the next entry
+        float toLinear[tableSegments + 2];
+        float toSRGB[tableSegments + 2];
+        uint8_t toLinear8[256];
+        uint8_t toSRGB8[256];
+
+        Tables()
+        {
+            for (int i = 0; i <= tableSegments; ++i)
+            {
+                float c = static_cast<float>(i) / static_cast<float>(tableSegments);
+                toLinear[i] = sRGB_to_linear(c);
+                toSRGB[i] = linear_to_sRGB(c);
+            }
+            toLinear[tableSegments + 1] = toLinear[tableSegments];
+            toSRGB[tableSegments + 1] = toSRGB[tableSegments];
+
+            for (int i = 0; i < 256; ++i)
+            {
+                float c = static_cast<float>(i) / 255.0f;
+                toLinear8[i] = static_cast<uint8_t>(sRGB_to_linear(c) * 255.0f + 0.5f);
+                toSRGB8[i] = static_cast<uint8_t>(linear_to_sRGB(c) * 255.0f + 0.5f);
+            }
+        }
+    };
+
+    const Tables& tables()
+    {
+        static const Tables s_tables;
+        return s_tables;
+    }
+
+    inline float lookup(const float* table, float c)
+    {
+        float f = c * static_cast<float>(tableSegments);
+        int i = static_cast<int>(f);
+        float a = table[i];
+        return a + (table[i + 1] - a) * (f - static_cast<float>(i));
+    }
+
+    // convert the r, g and b components of one colour, using the table for components in the 0 to 1 range and the exact function for the rest
+    inline void convertColor(float* c, const float* table, float (*exact)(float))
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            c[i] = (c[i] >= 0.0f && c[i] <= 1.0f) ? lookup(table, c[i]) : exact(c[i]);
+        }
+    }
+
+    void convertComponents(size_t count, float* c, const float* table, float (*exact)(float))
+    {
+#if defined(VSGXCHANGE_COLOR_SPACE_SSE2)
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(static_cast<float>(tableSegments));
+        const __m128 rgbMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+        for (size_t n = 0; n < count; ++n, c += 4)
+        {
+            __m128 x = _mm_loadu_ps(c);
+
+            // fall back to the exact functions when r, g or b is outside the table's range, alpha is never converted so isn't checked
+            __m128 inRange = _mm_and_ps(_mm_cmpge_ps(x, zero), _mm_cmple_ps(x, one));
+            if ((_mm_movemask_ps(inRange) & 7) != 7)
+            {
+                convertColor(c, table, exact);
+                continue;
+            }
+
+            __m128 f = _mm_mul_ps(_mm_min_ps(_mm_max_ps(x, zero), one), scale);
+            __m128i i = _mm_cvttps_epi32(f);
+            __m128 t = _mm_sub_ps(f, _mm_cvtepi32_ps(i));
+
+            alignas(16) int32_t index[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(index), i);
+
+            __m128 a = _mm_setr_ps(table[index[0]], table[index[1]], table[index[2]], table[index[3]]);
+            __m128 b = _mm_setr_ps(table[index[0] + 1], table[index[1] + 1], table[index[2] + 1], table[index[3] + 1]);
+            __m128 result = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+
+            // keep the original alpha
+            _mm_storeu_ps(c, _mm_or_ps(_mm_and_ps(rgbMask, result), _mm_andnot_ps(rgbMask, x)));
+        }
+#elif defined(VSGXCHANGE_COLOR_SPACE_NEON)
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t scale = vdupq_n_f32(static_cast<float>(tableSegments));
+        const uint32_t rgbMaskValues[4] = {0xffffffffu, 0xffffffffu, 0xffffffffu, 0u};
+        const uint32x4_t rgbMask = vld1q_u32(rgbMaskValues);
+
+        for (size_t n = 0; n < count; ++n, c += 4)
+        {
+            float32x4_t x = vld1q_f32(c);
+
+            // fall back to the exact functions when r, g or b is outside the table's range, alpha is never converted so isn't checked
+            uint32x4_t inRange = vandq_u32(vcgeq_f32(x, zero), vcleq_f32(x, one));
+            if (vgetq_lane_u32(inRange, 0) == 0 || vgetq_lane_u32(inRange, 1) == 0 || vgetq_lane_u32(inRange, 2) == 0)
+            {
+                convertColor(c, table, exact);
+                continue;
+            }
+
+            float32x4_t f = vmulq_f32(vminq_f32(vmaxq_f32(x, zero), one), scale);
+            int32x4_t i = vcvtq_s32_f32(f);
+            float32x4_t t = vsubq_f32(f, vcvtq_f32_s32(i));
+
+            int32_t index[4];
+            vst1q_s32(index, i);
+
+            const float aValues[4] = {table[index[0]], table[index[1]], table[index[2]], table[index[3]]};
+            const float bValues[4] = {table[index[0] + 1], table[index[1] + 1], table[index[2] + 1], table[index[3] + 1]};
+            float32x4_t a = vld1q_f32(aValues);
+            float32x4_t b = vld1q_f32(bValues);
+            float32x4_t result = vmlaq_f32(a, vsubq_f32(b, a), t);
+
+            // keep the original alpha
+            vst1q_f32(c, vbslq_f32(rgbMask, result, x));
+        }
+#else
+        for (size_t n = 0; n < count; ++n, c += 4)
+        {
+            convertColor(c, table, exact);
+        }
+#endif
+    }
+
+    // return the number of components per pixel and how many of them are colour channels, following Vulkan's sRGB formats which convert every channel but alpha
+    bool pixelLayout(VkFormat format, uint32_t& components, uint32_t& colorComponents)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB: components = colorComponents = 1; return true;
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB: components = colorComponents = 2; return true;
+        case VK_FORMAT_R8G8B8_UNORM:
+        case VK_FORMAT_R8G8B8_SRGB:
+        case VK_FORMAT_B8G8R8_UNORM:
+        case VK_FORMAT_B8G8R8_SRGB: components = colorComponents = 3; return true;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            components = 4;
+            colorComponents = 3;
+            return true;
+        default: return false;
+        }
+    }
+} // namespace
+
+void vsgXchange::convertColors(size_t count, vsg::vec4* colors, vsg::CoordinateSpace source, vsg::CoordinateSpace target)
+{
+    if (count == 0 || !colors || source == target || source == vsg::CoordinateSpace::NO_PREFERENCE || target == vsg::CoordinateSpace::NO_PREFERENCE) return;
+
+    if (source == vsg::CoordinateSpace::sRGB)
+        convertComponents(count, colors->data(), tables().toLinear, sRGB_to_linear);
+    else
+        convertComponents(count, colors->data(), tables().toSRGB, linear_to_sRGB);
+}
+
+bool vsgXchange::convertPixels(vsg::Data& image, vsg::CoordinateSpace target)
+{
+    auto& properties = image.properties;
+
+    uint32_t components = 0, colorComponents = 0;
+    if (!pixelLayout(properties.format, components, colorComponents) || properties.stride != components) return false;
+
+    auto sRGBFormat = vsg::uNorm_to_sRGB(properties.format);
+    auto source = (sRGBFormat == properties.format) ? vsg::CoordinateSpace::sRGB : vsg::CoordinateSpace::LINEAR;
+    if (target == vsg::CoordinateSpace::NO_PREFERENCE || target == source) return true;
+
+    const uint8_t* table = (source == vsg::CoordinateSpace::sRGB) ? tables().toLinear8 : tables().toSRGB8;
+
+    // the decoded images are tightly packed, so every mip level and layer has the same pixel layout
+    auto pixel = static_cast<uint8_t*>(image.dataPointer());
+    auto end = pixel + image.dataSize();
+    for (; pixel + components <= end; pixel += components)
+    {
+        for (uint32_t i = 0; i < colorComponents; ++i) pixel[i] = table[pixel[i]];
+    }
+
+    properties.format = (target == vsg::CoordinateSpace::sRGB) ? sRGBFormat : vsg::sRGB_to_uNorm(properties.format);
+    return true;
+}
+
+void vsgXchange::applyImageFormat(vsg::Data& image, const vsg::Options* options)
+{
+    vsg::CoordinateSpace coordinateSpace;
+    if (!options || !options->getValue(stbi::image_format, coordinateSpace)) return;
+
+    bool convert = false;
+    if (options->getValue(stbi::convert_pixels, convert) && convert && convertPixels(image, coordinateSpace)) return;
+
+    if (coordinateSpace == vsg::CoordinateSpace::sRGB)
+        image.properties.format = vsg::uNorm_to_sRGB(image.properties.format);
+    else if (coordinateSpace == vsg::CoordinateSpace::LINEAR)
+        image.properties.format = vsg::sRGB_to_uNorm(image.properties.format);
+}
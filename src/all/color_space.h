@@ -0,0 +1,46 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <vsg/core/Data.h>
+#include <vsg/io/Options.h>
+#include <vsg/maths/vec4.h>
+#include <vsg/utils/CoordinateSpace.h>
+
+namespace vsgXchange
+{
+    /// convert count RGBA colours in place between the sRGB and linear encodings, alpha is left unchanged and nothing is done when either CoordinateSpace is NO_PREFERENCE or they match.
+    /// Components in the 0 to 1 range are converted with an interpolated lookup table, vectorized with SSE2 or NEON where available, rather than evaluating std::pow() per component,
+    /// components outside that range use the exact transfer functions.
+    extern void convertColors(size_t count, vsg::vec4* colors, vsg::CoordinateSpace source, vsg::CoordinateSpace target);
+
+    /// convert the pixels of an 8bit image, whose format has both UNORM and SRGB variants, in place from the CoordinateSpace of its format to target, and relabel the format to match.
+    /// Colour channels are converted using a lookup table and alpha is left unchanged. Returns false if the image's format or layout isn't supported.
+    extern bool convertPixels(vsg::Data& image, vsg::CoordinateSpace target);
+
+    /// apply the stbi::image_format option to a decoded image, relabelling its format or, when stbi::convert_pixels is also set, converting its pixels.
+    extern void applyImageFormat(vsg::Data& image, const vsg::Options* options);
+
+} // namespace vsgXchange
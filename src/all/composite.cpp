@@ -0,0 +1,490 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <vsgXchange/all.h>
+#include <vsgXchange/cancellation.h>
+#include <vsgXchange/composite.h>
+#include <vsgXchange/read_memory.h>
+
+#include <vsg/core/Data.h>
+#include <vsg/io/FileSystem.h>
+#include <vsg/io/Logger.h>
+#include <vsg/io/Options.h>
+
+#include "content_type.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <optional>
+
+using namespace vsgXchange;
+
+namespace
+{
+    std::string lowerCase(std::string str)
+    {
+        for (auto& c : str) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return str;
+    }
+
+    /// return the lower case protocol of a URL such as https://server/file.vsgb, or an empty path if it doesn't have one.
+    vsg::Path protocol(const vsg::Path& filename)
+    {
+        auto str = filename.string();
+        auto pos = str.find("://");
+        if (pos == std::string::npos || pos == 0) return {};
+        return lowerCase(str.substr(0, pos));
+    }
+
+    /// return the lower case extensions of the directories of a filename, such as .vsga for a member of an archive like archive.vsga/tiles/12/34.vsgb, including its last component when it's a directory.
+    std::vector<vsg::Path> containerExtensions(const vsg::Path& filename, bool directory)
+    {
+        std::vector<vsg::Path> extensions;
+        auto str = directory ? (filename.string() + '/') : filename.string();
+        size_t start = 0;
+        for (auto end = str.find_first_of("/\\", start); end != std::string::npos; start = end + 1, end = str.find_first_of("/\\", start))
+        {
+            auto directory = str.substr(start, end - start);
+            auto pos = directory.rfind('.');
+            if (pos != std::string::npos && pos > 0 && pos + 1 < directory.size()) extensions.emplace_back(lowerCase(directory.substr(pos)));
+        }
+        return extensions;
+    }
+
+    /// return the key a feature's extension is indexed under, matching vsg::lowerCaseFileExtension() so compound extensions such as .mesh.xml are indexed by their last extension.
+    vsg::Path indexExtension(const vsg::Path& ext)
+    {
+        auto str = ext.string();
+        auto pos = str.rfind('.');
+        return lowerCase(pos == std::string::npos ? ("." + str) : str.substr(pos));
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    double seconds(clock::time_point start)
+    {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    /// class name of the ReaderWriter, or of the ReaderWriter a LazyReaderWriter stands in for.
+    std::string readerWriterName(const vsg::ReaderWriter& rw)
+    {
+        if (auto lazy = dynamic_cast<const LazyReaderWriter*>(&rw)) return lazy->implementationClassName;
+        return rw.className();
+    }
+
+    uint64_t dataSize(const vsg::Object* object)
+    {
+        auto data = dynamic_cast<const vsg::Data*>(object);
+        return data ? data->dataSize() : 0;
+    }
+
+    uint64_t fileSize(const vsg::Path& filename)
+    {
+        std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+        auto size = fin ? fin.tellg() : std::streampos(0);
+        return size > 0 ? static_cast<uint64_t>(size) : 0;
+    }
+
+    /// number of bytes from the current position to the end of a seekable stream, 0 if the stream can't seek.
+    uint64_t remaining(std::istream& fin)
+    {
+        auto pos = fin.tellg();
+        if (pos < 0) return 0;
+        fin.seekg(0, std::ios::end);
+        auto end = fin.tellg();
+        fin.seekg(pos);
+        return end > pos ? static_cast<uint64_t>(end - pos) : 0;
+    }
+
+    /// collects the ReadWriteEvent of a read or write when an observer is assigned, reporting it to the observer on destruction.
+    class ObservedOperation
+    {
+    public:
+        ObservedOperation(ReadWriteObserver* in_observer, ReadWriteEvent::Operation operation, const vsg::Path& filename, const vsg::Path& extension) :
+            _observer(in_observer)
+        {
+            if (!_observer) return;
+
+            _event.emplace();
+            _event->operation = operation;
+            _event->filename = filename;
+            _event->extension = extension;
+            _event->threadId = std::this_thread::get_id();
+            _previous = setCurrentReadWriteEvent(&(*_event));
+            _event->nested = (_previous != nullptr);
+            _start = clock::now();
+        }
+
+        ObservedOperation(const ObservedOperation&) = delete;
+        ObservedOperation& operator=(const ObservedOperation&) = delete;
+
+        ~ObservedOperation()
+        {
+            if (!_observer) return;
+
+            _event->duration = seconds(_start);
+            setCurrentReadWriteEvent(_previous);
+            _observer->report(*_event);
+        }
+
+        explicit operator bool() const { return _event.has_value(); }
+        ReadWriteEvent* operator->() { return &(*_event); }
+        ReadWriteEvent* get() { return _event ? &(*_event) : nullptr; }
+
+        void succeeded(const vsg::ReaderWriter& rw, uint64_t bytesIn, uint64_t bytesOut)
+        {
+            if (!_event) return;
+
+            _event->readerWriter = readerWriterName(rw);
+            _event->succeeded = true;
+            _event->bytesIn = bytesIn;
+            _event->bytesOut = bytesOut;
+        }
+
+    protected:
+        ReadWriteObserver* _observer = nullptr;
+        std::optional<ReadWriteEvent> _event;
+        ReadWriteEvent* _previous = nullptr;
+        clock::time_point _start;
+    };
+
+    /// accounts for the memory allocated by a read when it has a read_memory_budget, is observed or is nested within an accounted read, recording the peak in its ReadWriteEvent.
+    class AccountedRead
+    {
+    public:
+        AccountedRead(const vsg::Options* options, const vsg::Path& filename, ReadWriteEvent* in_event) :
+            _filename(filename),
+            _event(in_event)
+        {
+            auto budget = readMemoryBudget(options);
+            if (budget > 0 || _event || currentReadMemory()) _readMemory.emplace(budget);
+        }
+
+        AccountedRead(const AccountedRead&) = delete;
+        AccountedRead& operator=(const AccountedRead&) = delete;
+
+        ~AccountedRead()
+        {
+            if (!_readMemory) return;
+
+            if (_readMemory->exceeded()) vsg::warn("vsgXchange::all::read(", _filename, ") abandoned as it exceeds the read_memory_budget of ", _readMemory->budget(), " bytes.");
+
+            if (_event)
+            {
+                _event->peakMemory = _readMemory->peak();
+                _event->memoryBudgetExceeded = _readMemory->exceeded();
+            }
+        }
+
+    protected:
+        vsg::Path _filename;
+        ReadWriteEvent* _event = nullptr;
+        std::optional<ReadMemory> _readMemory;
+    };
+
+    /// discard the memory reserved by a ReaderWriter that failed to read, returning true if it failed as the read would exceed its read_memory_budget, so further ReaderWriters shouldn't be tried.
+    bool abandonRead()
+    {
+        auto readMemory = currentReadMemory();
+        if (!readMemory) return false;
+
+        readMemory->discard();
+        return readMemory->exceeded();
+    }
+
+    const vsg::Instrumentation* instrumentation(const ReadWriteObserver* observer)
+    {
+        return observer ? observer->instrumentation.get() : nullptr;
+    }
+} // namespace
+
+IndexedCompositeReaderWriter::Candidates IndexedCompositeReaderWriter::Index::select(std::vector<size_t>& indices) const
+{
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    Candidates result;
+    result.reserve(indices.size());
+    for (auto i : indices) result.push_back(readerWriters[i]);
+    return result;
+}
+
+std::shared_ptr<const IndexedCompositeReaderWriter::Index> IndexedCompositeReaderWriter::index() const
+{
+    std::scoped_lock<std::mutex> lock(_indexMutex);
+    if (_index && _index->readerWriters == readerWriters) return _index;
+
+    auto newIndex = std::make_shared<Index>();
+    newIndex->readerWriters = readerWriters;
+
+    for (size_t i = 0; i < readerWriters.size(); ++i)
+    {
+        Features features;
+        if (!readerWriters[i] || !readerWriters[i]->getFeatures(features) || (features.extensionFeatureMap.empty() && features.protocolFeatureMap.empty()))
+        {
+            newIndex->unindexed.push_back(i);
+            continue;
+        }
+
+        for (auto& entry : features.extensionFeatureMap)
+        {
+            if (entry.first) newIndex->extensions[indexExtension(entry.first)].push_back(i);
+        }
+        for (auto& entry : features.protocolFeatureMap) newIndex->protocols[lowerCase(entry.first.string())].push_back(i);
+    }
+
+    _index = newIndex;
+    return _index;
+}
+
+IndexedCompositeReaderWriter::Candidates IndexedCompositeReaderWriter::candidatesForExtension(const vsg::Path& ext) const
+{
+    auto currentIndex = index();
+    if (!ext) return currentIndex->readerWriters;
+
+    std::vector<size_t> indices(currentIndex->unindexed);
+    if (auto itr = currentIndex->extensions.find(indexExtension(ext)); itr != currentIndex->extensions.end()) indices.insert(indices.end(), itr->second.begin(), itr->second.end());
+
+    return currentIndex->select(indices);
+}
+
+IndexedCompositeReaderWriter::Candidates IndexedCompositeReaderWriter::candidates(const vsg::Path& filename, const vsg::Options* options) const
+{
+    auto ext = vsg::lowerCaseFileExtension(filename);
+    auto currentIndex = index();
+    if (!ext) return currentIndex->readerWriters;
+
+    std::vector<size_t> indices(currentIndex->unindexed);
+    if (auto itr = currentIndex->extensions.find(ext); itr != currentIndex->extensions.end()) indices.insert(indices.end(), itr->second.begin(), itr->second.end());
+
+    // a URL, or a filename relative to a server address at the front of the Options::paths, goes to the children that handle the protocol
+    auto urlProtocol = protocol(filename);
+    if (!urlProtocol && options && !options->paths.empty()) urlProtocol = protocol(options->paths.front());
+    if (urlProtocol)
+    {
+        if (auto itr = currentIndex->protocols.find(urlProtocol); itr != currentIndex->protocols.end()) indices.insert(indices.end(), itr->second.begin(), itr->second.end());
+    }
+
+    // a filename within a container file such as archive.vsga/tiles/12/34.vsgb, or relative to a directory within one at the front of the Options::paths, goes to the children that handle the container
+    auto addContainers = [&](const vsg::Path& path, bool directory) {
+        for (auto& containerExt : containerExtensions(path, directory))
+        {
+            if (auto itr = currentIndex->extensions.find(containerExt); itr != currentIndex->extensions.end()) indices.insert(indices.end(), itr->second.begin(), itr->second.end());
+        }
+    };
+    addContainers(filename, false);
+    if (options && !options->paths.empty()) addContainers(options->paths.front(), true);
+
+    return currentIndex->select(indices);
+}
+
+vsg::ref_ptr<const vsg::Options> IndexedCompositeReaderWriter::hintExtension(vsg::ref_ptr<const vsg::Options> options, const vsg::Path& ext)
+{
+    auto local_options = options ? vsg::clone(options) : vsg::Options::create();
+    local_options->extensionHint = ext;
+    return local_options;
+}
+
+vsg::ref_ptr<vsg::Object> IndexedCompositeReaderWriter::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    CPU_INSTRUMENTATION_L1_N(instrumentation(observer), "vsgXchange read filename");
+
+    auto ext = vsg::lowerCaseFileExtension(filename);
+    ObservedOperation observed(observer, ReadWriteEvent::READ_FILENAME, filename, (!ext && options) ? options->extensionHint : ext);
+    AccountedRead accounted(options.get(), filename, observed.get());
+
+    if (!dataCache && !observed) return readUncached(filename, options, nullptr);
+
+    // resolve the filename once, keying the cache by the resolved path so the same file reached through different relative paths is shared,
+    // and passing it on so the time taken searching the Options::paths is reported separately from the ReaderWriter's read.
+    auto findStart = clock::now();
+    vsg::Path foundFilename = vsg::findFile(filename, options.get());
+    if (observed)
+    {
+        observed->foundFilename = foundFilename;
+        observed->findFileDuration = seconds(findStart);
+    }
+
+    // remote files are cached by their URL
+    vsg::Path cacheFilename = foundFilename;
+    if (!cacheFilename && protocol(filename)) cacheFilename = filename;
+
+    if (dataCache && cacheFilename)
+    {
+        if (auto object = dataCache->get(cacheFilename, options.get()))
+        {
+            if (observed)
+            {
+                observed->succeeded = true;
+                observed->cached = true;
+                observed->bytesOut = dataSize(object);
+            }
+            return object;
+        }
+    }
+
+    auto object = readUncached(foundFilename ? foundFilename : filename, options, observed.get());
+    if (object && dataCache && cacheFilename) dataCache->add(cacheFilename, options.get(), object);
+
+    if (object && observed)
+    {
+        observed->succeeded = true;
+        observed->bytesIn = foundFilename ? fileSize(foundFilename) : 0;
+        observed->bytesOut = dataSize(object);
+    }
+    return object;
+}
+
+vsg::ref_ptr<vsg::Object> IndexedCompositeReaderWriter::readUncached(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options, ReadWriteEvent* event) const
+{
+    if (!vsg::lowerCaseFileExtension(filename) && (!options || !options->extensionHint))
+    {
+        // identify local files without an extension by their contents so they are only offered to the matching ReaderWriters
+        if (auto foundFilename = vsg::findFile(filename, options.get()))
+        {
+            std::ifstream fin(foundFilename, std::ios::in | std::ios::binary);
+            if (auto ext = extensionFromContents(fin))
+            {
+                if (event) event->extension = ext;
+
+                auto local_options = hintExtension(options, ext);
+                for (auto& rw : candidatesForExtension(ext))
+                {
+                    if (cancelled(local_options.get())) return {};
+
+                    if (auto object = rw->read(filename, local_options))
+                    {
+                        if (event) event->readerWriter = readerWriterName(*rw);
+                        return object;
+                    }
+                    if (abandonRead()) return {};
+                }
+                return {};
+            }
+        }
+    }
+
+    for (auto& rw : candidates(filename, options.get()))
+    {
+        if (cancelled(options.get())) return {};
+
+        if (auto object = rw->read(filename, options))
+        {
+            if (event) event->readerWriter = readerWriterName(*rw);
+            return object;
+        }
+        if (abandonRead()) return {};
+    }
+    return {};
+}
+
+vsg::ref_ptr<vsg::Object> IndexedCompositeReaderWriter::read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options) const
+{
+    CPU_INSTRUMENTATION_L1_N(instrumentation(observer), "vsgXchange read istream");
+
+    if (!options || !options->extensionHint)
+    {
+        if (auto ext = extensionFromContents(fin)) options = hintExtension(options, ext);
+    }
+
+    ObservedOperation observed(observer, ReadWriteEvent::READ_ISTREAM, {}, options ? options->extensionHint : vsg::Path());
+    AccountedRead accounted(options.get(), "istream", observed.get());
+    auto start = observed ? fin.tellg() : std::streampos(-1);
+    auto size = observed ? remaining(fin) : 0;
+
+    for (auto& rw : candidatesForExtension(options ? options->extensionHint : vsg::Path()))
+    {
+        if (cancelled(options.get())) return {};
+
+        if (auto object = rw->read(fin, options))
+        {
+            if (observed)
+            {
+                // report the bytes consumed when the stream position is still valid, otherwise assume the ReaderWriter read to the end
+                auto end = fin.tellg();
+                observed.succeeded(*rw, (start >= 0 && end > start) ? static_cast<uint64_t>(end - start) : size, dataSize(object));
+            }
+            return object;
+        }
+        if (abandonRead()) return {};
+    }
+    return {};
+}
+
+vsg::ref_ptr<vsg::Object> IndexedCompositeReaderWriter::read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options) const
+{
+    CPU_INSTRUMENTATION_L1_N(instrumentation(observer), "vsgXchange read memory");
+
+    if (!options || !options->extensionHint)
+    {
+        if (auto ext = extensionFromContents(ptr, size)) options = hintExtension(options, ext);
+    }
+
+    ObservedOperation observed(observer, ReadWriteEvent::READ_MEMORY, {}, options ? options->extensionHint : vsg::Path());
+    AccountedRead accounted(options.get(), "memory block", observed.get());
+
+    for (auto& rw : candidatesForExtension(options ? options->extensionHint : vsg::Path()))
+    {
+        if (cancelled(options.get())) return {};
+
+        if (auto object = rw->read(ptr, size, options))
+        {
+            observed.succeeded(*rw, size, dataSize(object));
+            return object;
+        }
+        if (abandonRead()) return {};
+    }
+    return {};
+}
+
+bool IndexedCompositeReaderWriter::write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    CPU_INSTRUMENTATION_L1_N(instrumentation(observer), "vsgXchange write filename");
+
+    ObservedOperation observed(observer, ReadWriteEvent::WRITE_FILENAME, filename, vsg::lowerCaseFileExtension(filename));
+
+    for (auto& rw : candidates(filename, options.get()))
+    {
+        if (rw->write(object, filename, options))
+        {
+            if (observed) observed.succeeded(*rw, dataSize(object), fileSize(filename));
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IndexedCompositeReaderWriter::write(const vsg::Object* object, std::ostream& fout, vsg::ref_ptr<const vsg::Options> options) const
+{
+    CPU_INSTRUMENTATION_L1_N(instrumentation(observer), "vsgXchange write ostream");
+
+    ObservedOperation observed(observer, ReadWriteEvent::WRITE_OSTREAM, {}, options ? options->extensionHint : vsg::Path());
+    auto start = observed ? fout.tellp() : std::streampos(-1);
+
+    for (auto& rw : candidatesForExtension(options ? options->extensionHint : vsg::Path()))
+    {
+        if (rw->write(object, fout, options))
+        {
+            if (observed)
+            {
+                auto end = fout.tellp();
+                observed.succeeded(*rw, dataSize(object), (start >= 0 && end > start) ? static_cast<uint64_t>(end - start) : 0);
+            }
+            return true;
+        }
+    }
+    return false;
+}
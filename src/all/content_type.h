@@ -0,0 +1,122 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <vsg/io/Path.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <string>
+
+namespace vsgXchange
+{
+    /// number of leading bytes extensionFromContents() needs to identify all the formats it recognizes.
+    constexpr size_t contentSniffSize = 256;
+
+    /// return the extension of the format identified by the magic number at the start of a block of data, PNG, JPEG, KTX/KTX2, DDS, EXR, glTF/GLB, TIFF and vsgb/vsgt are recognized.
+    /// Returns an empty path if the format isn't recognized.
+    inline vsg::Path extensionFromContents(const uint8_t* ptr, size_t size)
+    {
+        auto startsWith = [&](const void* magic, size_t length) { return size >= length && std::memcmp(ptr, magic, length) == 0; };
+
+        static const uint8_t png[] = {0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a};
+        static const uint8_t jpeg[] = {0xff, 0xd8, 0xff};
+        static const uint8_t ktx[] = {0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
+        static const uint8_t ktx2[] = {0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
+        static const uint8_t exr[] = {0x76, 0x2f, 0x31, 0x01};
+        static const uint8_t tiff_le[] = {'I', 'I', 0x2a, 0x00};
+        static const uint8_t tiff_be[] = {'M', 'M', 0x00, 0x2a};
+        static const uint8_t bigtiff_le[] = {'I', 'I', 0x2b, 0x00};
+        static const uint8_t bigtiff_be[] = {'M', 'M', 0x00, 0x2b};
+
+        if (startsWith(png, sizeof(png))) return ".png";
+        if (startsWith(jpeg, sizeof(jpeg))) return ".jpg";
+        if (startsWith(ktx, sizeof(ktx))) return ".ktx";
+        if (startsWith(ktx2, sizeof(ktx2))) return ".ktx2";
+        if (startsWith("DDS ", 4)) return ".dds";
+        if (startsWith(exr, sizeof(exr))) return ".exr";
+        if (startsWith("glTF", 4)) return ".glb";
+        if (startsWith(tiff_le, sizeof(tiff_le)) || startsWith(tiff_be, sizeof(tiff_be)) || startsWith(bigtiff_le, sizeof(bigtiff_le)) || startsWith(bigtiff_be, sizeof(bigtiff_be))) return ".tif";
+        if (startsWith("#vsgb", 5)) return ".vsgb";
+        if (startsWith("#vsga", 5)) return ".vsgt"; // ascii .vsgt files start with the #vsga header token
+
+        // glTF JSON is an object with an "asset" property, which writers conventionally place first
+        size_t pos = 0;
+        while (pos < size && std::isspace(ptr[pos])) ++pos;
+        if (pos < size && ptr[pos] == '{')
+        {
+            const char* begin = reinterpret_cast<const char*>(ptr);
+            const char* end = begin + std::min(size, contentSniffSize);
+            static const char asset[] = "\"asset\"";
+            if (std::search(begin + pos, end, asset, asset + sizeof(asset) - 1) != end) return ".gltf";
+        }
+
+        return {};
+    }
+
+    /// return the extension of the format identified by the magic number at the start of the stream, restoring the stream position afterwards.
+    /// Returns an empty path if the stream isn't seekable or the format isn't recognized.
+    inline vsg::Path extensionFromContents(std::istream& fin)
+    {
+        auto pos = fin.tellg();
+        if (pos == std::istream::pos_type(-1)) return {};
+
+        uint8_t buffer[contentSniffSize];
+        fin.read(reinterpret_cast<char*>(buffer), sizeof(buffer));
+        auto size = static_cast<size_t>(fin.gcount());
+
+        fin.clear();
+        fin.seekg(pos);
+
+        return extensionFromContents(buffer, size);
+    }
+
+    /// return the extension associated with an HTTP Content-Type such as "image/png" or "model/gltf-binary", ignoring any parameters such as charset.
+    /// Returns an empty path for generic types such as application/octet-stream.
+    inline vsg::Path extensionFromContentType(const std::string& contentType)
+    {
+        std::string type = contentType.substr(0, contentType.find(';'));
+        type.erase(type.find_last_not_of(" \t") + 1);
+        for (auto& c : type) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+        if (type == "image/png") return ".png";
+        if (type == "image/jpeg" || type == "image/jpg") return ".jpg";
+        if (type == "image/ktx") return ".ktx";
+        if (type == "image/ktx2") return ".ktx2";
+        if (type == "image/vnd-ms.dds" || type == "image/vnd.ms-dds" || type == "image/dds") return ".dds";
+        if (type == "image/x-exr" || type == "image/aces") return ".exr";
+        if (type == "image/tiff" || type == "image/tiff-fx") return ".tif";
+        if (type == "model/gltf-binary") return ".glb";
+        if (type == "model/gltf+json") return ".gltf";
+        if (type == "image/gif") return ".gif";
+        if (type == "image/bmp") return ".bmp";
+        if (type == "image/vnd.radiance") return ".hdr";
+        return {};
+    }
+
+} // namespace vsgXchange
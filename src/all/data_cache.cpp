@@ -0,0 +1,186 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <vsgXchange/cancellation.h>
+#include <vsgXchange/data_cache.h>
+#include <vsgXchange/read_memory.h>
+
+#include <vsg/core/ConstVisitor.h>
+#include <vsg/core/Data.h>
+#include <vsg/core/compare.h>
+#include <vsg/text/Font.h>
+
+#include <iterator>
+
+using namespace vsgXchange;
+
+namespace
+{
+    // accumulate the size of the vsg::Data referenced by a cached object, such as a font's atlas and glyph metrics.
+    struct CollectDataSize : public vsg::ConstVisitor
+    {
+        size_t size = 0;
+
+        void apply(const vsg::Object& object) override
+        {
+            object.traverse(*this);
+        }
+
+        void apply(const vsg::Data& data) override
+        {
+            size += data.dataSize();
+        }
+    };
+} // namespace
+
+DataCache::Key::Key(const vsg::Options* options)
+{
+    if (!options) return;
+
+    extensionHint = options->extensionHint;
+    mapRGBtoRGBAHint = options->mapRGBtoRGBAHint;
+    if (auto auxiliary = options->getAuxiliary())
+    {
+        values.insert(auxiliary->userObjects.begin(), auxiliary->userObjects.end());
+
+        // each read may have its own CancellationToken and read_memory_budget, they don't affect decoding so mustn't prevent sharing
+        values.erase(cancellation_token);
+        values.erase(read_memory_budget);
+    }
+}
+
+bool DataCache::Key::operator==(const Key& rhs) const
+{
+    if (extensionHint != rhs.extensionHint || mapRGBtoRGBAHint != rhs.mapRGBtoRGBAHint || values.size() != rhs.values.size()) return false;
+
+    for (auto lhs_itr = values.begin(), rhs_itr = rhs.values.begin(); lhs_itr != values.end(); ++lhs_itr, ++rhs_itr)
+    {
+        if (lhs_itr->first != rhs_itr->first || vsg::compare_pointer(lhs_itr->second, rhs_itr->second) != 0) return false;
+    }
+    return true;
+}
+
+DataCache::DataCache(size_t in_maxBytes) :
+    _maxBytes(in_maxBytes)
+{
+}
+
+bool DataCache::cacheable(const vsg::Object* object)
+{
+    return object && (dynamic_cast<const vsg::Data*>(object) || dynamic_cast<const vsg::Font*>(object));
+}
+
+vsg::ref_ptr<vsg::Object> DataCache::get(const vsg::Path& filename, const vsg::Options* options)
+{
+    Key key(options);
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+    auto range = _index.equal_range(filename);
+    for (auto itr = range.first; itr != range.second; ++itr)
+    {
+        if (itr->second->key == key)
+        {
+            // move to the front of the least recently used list
+            _entries.splice(_entries.begin(), _entries, itr->second);
+            ++_statistics.numHits;
+            return itr->second->object;
+        }
+    }
+
+    ++_statistics.numMisses;
+    return {};
+}
+
+bool DataCache::add(const vsg::Path& filename, const vsg::Options* options, vsg::ref_ptr<vsg::Object> object)
+{
+    if (!cacheable(object.get())) return false;
+
+    CollectDataSize collectDataSize;
+    object->accept(collectDataSize);
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+    if (collectDataSize.size > _maxBytes) return false;
+
+    Key key(options);
+
+    // replace any existing entry read concurrently with the same key
+    auto range = _index.equal_range(filename);
+    for (auto itr = range.first; itr != range.second; ++itr)
+    {
+        if (itr->second->key == key)
+        {
+            _statistics.numBytes -= itr->second->size;
+            _entries.erase(itr->second);
+            _index.erase(itr);
+            break;
+        }
+    }
+
+    _entries.push_front(Entry{filename, std::move(key), object, collectDataSize.size});
+    _index.emplace(filename, _entries.begin());
+    _statistics.numBytes += collectDataSize.size;
+
+    evict();
+    return true;
+}
+
+void DataCache::evict()
+{
+    while (_statistics.numBytes > _maxBytes && !_entries.empty())
+    {
+        auto last = std::prev(_entries.end());
+
+        auto range = _index.equal_range(last->filename);
+        for (auto itr = range.first; itr != range.second; ++itr)
+        {
+            if (itr->second == last)
+            {
+                _index.erase(itr);
+                break;
+            }
+        }
+
+        _statistics.numBytes -= last->size;
+        _entries.erase(last);
+        ++_statistics.numEvictions;
+    }
+}
+
+void DataCache::setMaxBytes(size_t in_maxBytes)
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _maxBytes = in_maxBytes;
+    evict();
+}
+
+size_t DataCache::getMaxBytes() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _maxBytes;
+}
+
+void DataCache::clear()
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _entries.clear();
+    _index.clear();
+    _statistics.numBytes = 0;
+}
+
+DataCache::Statistics DataCache::getStatistics() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    auto statistics = _statistics;
+    statistics.numEntries = _entries.size();
+    return statistics;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <vsg/core/Array2D.h>
+#include <vsg/io/Options.h>
+#include <vsgXchange/images.h>
+
+#include <algorithm>
+
+namespace vsgXchange
+{
+    /// return the images::max_texture_size set on the options, 0 when there is no limit.
+    inline uint32_t maxTextureSize(const vsg::Options* options)
+    {
+        uint32_t maxSize = 0;
+        if (options) options->getValue(images::max_texture_size, maxSize);
+        return maxSize;
+    }
+
+    /// number of times the dimensions need to be halved, rounding down as mip levels do, for the largest to fit within maxSize.
+    inline uint32_t downsampleLevels(uint32_t width, uint32_t height, uint32_t depth, uint32_t maxSize)
+    {
+        uint32_t levels = 0;
+        if (maxSize == 0) return levels;
+        while (std::max({width >> levels, height >> levels, depth >> levels}) > maxSize) ++levels;
+        return levels;
+    }
+
+    namespace detail
+    {
+        inline uint8_t average(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { return static_cast<uint8_t>((uint32_t(a) + uint32_t(b) + uint32_t(c) + uint32_t(d) + 2) >> 2); }
+        inline uint16_t average(uint16_t a, uint16_t b, uint16_t c, uint16_t d) { return static_cast<uint16_t>((uint32_t(a) + uint32_t(b) + uint32_t(c) + uint32_t(d) + 2) >> 2); }
+        inline float average(float a, float b, float c, float d) { return (a + b + c + d) * 0.25f; }
+
+        // 2x2 box filter of interleaved components, rows and columns are clamped so odd and single pixel dimensions are handled.
+        // The inner loop over a row's components is kept free of branches and aliasing so the compiler vectorizes it.
+        template<typename C>
+        void boxFilter(const C* __restrict src, uint32_t width, uint32_t height, uint32_t components, C* __restrict dest)
+        {
+            const uint32_t destWidth = std::max(1u, width / 2);
+            const uint32_t destHeight = std::max(1u, height / 2);
+            const size_t rowLength = static_cast<size_t>(width) * components;
+            const size_t destRowLength = static_cast<size_t>(destWidth) * components;
+            const size_t pairStride = (width > 1) ? components : 0;
+
+            for (uint32_t y = 0; y < destHeight; ++y)
+            {
+                const C* row0 = src + std::min(2 * y, height - 1) * rowLength;
+                const C* row1 = src + std::min(2 * y + 1, height - 1) * rowLength;
+                C* out = dest + y * destRowLength;
+                for (uint32_t x = 0; x < destWidth; ++x)
+                {
+                    const size_t i0 = static_cast<size_t>(2 * x) * components;
+                    const size_t i1 = i0 + pairStride;
+                    for (uint32_t c = 0; c < components; ++c)
+                    {
+                        out[x * components + c] = average(row0[i0 + c], row0[i1 + c], row1[i0 + c], row1[i1 + c]);
+                    }
+                }
+            }
+        }
+
+        template<typename C>
+        vsg::ref_ptr<vsg::Data> createImage2D(uint32_t components, uint32_t width, uint32_t height, const vsg::Data::Properties& properties)
+        {
+            switch (components)
+            {
+            case 1: return vsg::Array2D<C>::create(width, height, properties);
+            case 2: return vsg::Array2D<vsg::t_vec2<C>>::create(width, height, properties);
+            case 3: return vsg::Array2D<vsg::t_vec3<C>>::create(width, height, properties);
+            case 4: return vsg::Array2D<vsg::t_vec4<C>>::create(width, height, properties);
+            default: return {};
+            }
+        }
+
+        template<typename C>
+        vsg::ref_ptr<vsg::Data> downsample(vsg::ref_ptr<vsg::Data> image, uint32_t levels)
+        {
+            const uint32_t components = static_cast<uint32_t>(image->properties.stride / sizeof(C));
+            for (uint32_t level = 0; level < levels; ++level)
+            {
+                const uint32_t width = image->width();
+                const uint32_t height = image->height();
+                auto dest = createImage2D<C>(components, std::max(1u, width / 2), std::max(1u, height / 2), image->properties);
+                if (!dest) return image;
+
+                boxFilter(static_cast<const C*>(image->dataPointer()), width, height, components, static_cast<C*>(dest->dataPointer()));
+
+                // release each level as soon as the next is computed so at most the source and a quarter sized copy are alive
+                image = dest;
+            }
+            return image;
+        }
+    } // namespace detail
+
+    /// downsample a 2D image with repeated 2x2 box filtering until its width and height fit within maxSize.
+    /// Only single level, uncompressed 8 and 16 bit normalized and 32 bit float formats are downsampled, other images are returned unchanged.
+    inline vsg::ref_ptr<vsg::Data> downsampleImage(vsg::ref_ptr<vsg::Data> image, uint32_t maxSize)
+    {
+        if (!image || maxSize == 0) return image;
+
+        auto& properties = image->properties;
+        const uint32_t levels = downsampleLevels(image->width(), image->height(), 1, maxSize);
+        if (levels == 0 || image->depth() > 1 || properties.maxNumMipmaps > 1 || properties.blockWidth > 1 || properties.blockHeight > 1) return image;
+        if (image->dataSize() != static_cast<size_t>(image->width()) * image->height() * properties.stride) return image;
+
+        switch (properties.format)
+        {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB:
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB:
+        case VK_FORMAT_R8G8B8_UNORM:
+        case VK_FORMAT_R8G8B8_SRGB:
+        case VK_FORMAT_B8G8R8_UNORM:
+        case VK_FORMAT_B8G8R8_SRGB:
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            return detail::downsample<uint8_t>(image, levels);
+        case VK_FORMAT_R16_UNORM:
+        case VK_FORMAT_R16G16_UNORM:
+        case VK_FORMAT_R16G16B16_UNORM:
+        case VK_FORMAT_R16G16B16A16_UNORM:
+            return detail::downsample<uint16_t>(image, levels);
+        case VK_FORMAT_R32_SFLOAT:
+        case VK_FORMAT_R32G32_SFLOAT:
+        case VK_FORMAT_R32G32B32_SFLOAT:
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return detail::downsample<float>(image, levels);
+        default:
+            return image;
+        }
+    }
+
+} // namespace vsgXchange
@@ -0,0 +1,63 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 André Normann & Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgXchange/models.h>
+
+#include <vsg/io/Input.h>
+#include <vsg/io/Output.h>
+
+#include <algorithm>
+
+using namespace vsgXchange;
+
+JointPaletteSampler::JointPaletteSampler()
+{
+}
+
+JointPaletteSampler::JointPaletteSampler(const JointPaletteSampler& rhs, const vsg::CopyOp& copyop) :
+    Inherit(rhs, copyop),
+    jointMatrices(copyop(rhs.jointMatrices)),
+    paletteMatrices(copyop(rhs.paletteMatrices)),
+    joints(rhs.joints)
+{
+}
+
+void JointPaletteSampler::update(double)
+{
+    if (!jointMatrices || !paletteMatrices) return;
+
+    size_t numJoints = std::min(joints.size(), static_cast<size_t>(paletteMatrices->size()));
+    for (size_t i = 0; i < numJoints; ++i)
+    {
+        if (joints[i] < jointMatrices->size()) paletteMatrices->at(i) = jointMatrices->at(joints[i]);
+    }
+
+    paletteMatrices->dirty();
+}
+
+void JointPaletteSampler::read(vsg::Input& input)
+{
+    AnimationSampler::read(input);
+
+    input.read("jointMatrices", jointMatrices);
+    input.read("paletteMatrices", paletteMatrices);
+    input.readValues("joints", joints);
+}
+
+void JointPaletteSampler::write(vsg::Output& output) const
+{
+    AnimationSampler::write(output);
+
+    output.write("jointMatrices", jointMatrices);
+    output.write("paletteMatrices", paletteMatrices);
+    output.writeValues("joints", joints);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/io/Path.h>
+
+#include <cstdint>
+
+namespace vsgXchange
+{
+    /// read only memory mapping of a whole file, using mmap on POSIX systems and MapViewOfFile on Windows, so file contents are paged in by the OS on demand rather than copied through user space buffers.
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const vsg::Path& filename);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        const uint8_t* data() const { return _data; }
+        size_t size() const { return _size; }
+
+        /// return true if the file was successfully mapped
+        explicit operator bool() const { return _data != nullptr; }
+
+    protected:
+        const uint8_t* _data = nullptr;
+        size_t _size = 0;
+#if defined(_WIN32)
+        void* _mapping = nullptr;
+#endif
+    };
+
+} // namespace vsgXchange
@@ -0,0 +1,929 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgXchange/mesh_optimizer.h>
+
+#include <vsg/core/Array.h>
+#include <vsg/io/Logger.h>
+#include <vsg/nodes/LOD.h>
+#include <vsg/state/GraphicsPipeline.h>
+#include <vsg/state/InputAssemblyState.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <queue>
+#include <unordered_map>
+
+using namespace vsgXchange;
+
+namespace
+{
+    const uint32_t invalid_index = ~0u;
+
+    bool readIndices(const vsg::Data& data, std::vector<uint32_t>& indices)
+    {
+        if (data.stride() != data.valueSize()) return false;
+
+        indices.resize(data.valueCount());
+        switch (data.valueSize())
+        {
+        case 1: std::copy_n(static_cast<const uint8_t*>(data.dataPointer()), indices.size(), indices.begin()); return true;
+        case 2: std::copy_n(static_cast<const uint16_t*>(data.dataPointer()), indices.size(), indices.begin()); return true;
+        case 4: std::copy_n(static_cast<const uint32_t*>(data.dataPointer()), indices.size(), indices.begin()); return true;
+        default: return false;
+        }
+    }
+
+    template<class A>
+    vsg::ref_ptr<vsg::Data> createIndices(const vsg::Data& original, const std::vector<uint32_t>& indices)
+    {
+        auto properties = original.properties;
+        properties.stride = 0;
+
+        auto array = A::create(static_cast<uint32_t>(indices.size()), properties);
+        auto itr = array->begin();
+        for (auto index : indices) (*itr++) = static_cast<typename A::value_type>(index);
+        return array;
+    }
+
+    /// create indices of the same type as the original indices
+    vsg::ref_ptr<vsg::Data> createIndices(const vsg::Data& original, const std::vector<uint32_t>& indices)
+    {
+        switch (original.valueSize())
+        {
+        case 1: return createIndices<vsg::ubyteArray>(original, indices);
+        case 2: return createIndices<vsg::ushortArray>(original, indices);
+        default: return createIndices<vsg::uintArray>(original, indices);
+        }
+    }
+
+    template<class A>
+    vsg::ref_ptr<vsg::Data> remapArray(const A& array, const std::vector<uint32_t>& newToOld)
+    {
+        auto properties = array.properties;
+        properties.stride = 0;
+
+        auto result = A::create(static_cast<uint32_t>(newToOld.size()), properties);
+        for (size_t i = 0; i < newToOld.size(); ++i) result->at(i) = array.at(newToOld[i]);
+        return result;
+    }
+
+    /// create a copy of a vertex array with the elements in newToOld order, returns null for unsupported array types.
+    vsg::ref_ptr<vsg::Data> remapArray(const vsg::Data& data, const std::vector<uint32_t>& newToOld)
+    {
+        if (auto array = data.cast<vsg::vec3Array>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::vec2Array>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::vec4Array>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::floatArray>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::dvec3Array>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::ivec4Array>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::uivec4Array>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::usvec4Array>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::ubvec4Array>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::uintArray>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::svec4Array>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::bvec4Array>()) return remapArray(*array, newToOld);
+        if (auto array = data.cast<vsg::usvec2Array>()) return remapArray(*array, newToOld);
+        return {};
+    }
+
+    bool supportedArray(const vsg::Data& data)
+    {
+        return data.stride() == data.valueSize() && (data.is_compatible(typeid(vsg::vec3Array)) || data.is_compatible(typeid(vsg::vec2Array)) || data.is_compatible(typeid(vsg::vec4Array)) ||
+                                                     data.is_compatible(typeid(vsg::floatArray)) || data.is_compatible(typeid(vsg::dvec3Array)) || data.is_compatible(typeid(vsg::ivec4Array)) ||
+                                                     data.is_compatible(typeid(vsg::uivec4Array)) || data.is_compatible(typeid(vsg::usvec4Array)) || data.is_compatible(typeid(vsg::ubvec4Array)) ||
+                                                     data.is_compatible(typeid(vsg::uintArray)) || data.is_compatible(typeid(vsg::svec4Array)) || data.is_compatible(typeid(vsg::bvec4Array)) ||
+                                                     data.is_compatible(typeid(vsg::usvec2Array)));
+    }
+
+    /// map each index to the first vertex with identical values in all of the vertex arrays
+    void weldVertices(const std::vector<const vsg::Data*>& arrays, uint32_t numVertices, std::vector<uint32_t>& indices)
+    {
+        auto hashVertex = [&](uint32_t v) {
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (auto array : arrays)
+            {
+                auto size = array->valueSize();
+                auto ptr = static_cast<const uint8_t*>(array->dataPointer()) + v * size;
+                for (auto end = ptr + size; ptr != end; ++ptr) hash = (hash ^ *ptr) * 0x100000001b3ull;
+            }
+            return hash;
+        };
+
+        auto equalVertices = [&](uint32_t lhs, uint32_t rhs) {
+            for (auto array : arrays)
+            {
+                auto size = array->valueSize();
+                auto ptr = static_cast<const uint8_t*>(array->dataPointer());
+                if (std::memcmp(ptr + lhs * size, ptr + rhs * size, size) != 0) return false;
+            }
+            return true;
+        };
+
+        // the hash is incremented on collisions between vertices with different values, so each key maps to a single distinct vertex
+        std::vector<uint32_t> remap(numVertices, invalid_index);
+        std::unordered_map<uint64_t, uint32_t> firstVertices;
+        firstVertices.reserve(numVertices);
+        for (auto& index : indices)
+        {
+            if (remap[index] == invalid_index)
+            {
+                for (uint64_t hash = hashVertex(index);; ++hash)
+                {
+                    auto [itr, inserted] = firstVertices.emplace(hash, index);
+                    if (inserted || equalVertices(itr->second, index))
+                    {
+                        remap[index] = itr->second;
+                        break;
+                    }
+                }
+            }
+            index = remap[index];
+        }
+    }
+
+    /// reorder triangles so they reuse the vertices in the post transform cache, using Tom Forsyth's linear-speed vertex cache optimisation.
+    void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t numVertices, uint32_t cacheSize)
+    {
+        const float cacheDecayPower = 1.5f;
+        const float lastTriangleScore = 0.75f;
+        const float valenceBoostScale = 2.0f;
+        const float valenceBoostPower = 0.5f;
+
+        size_t numTriangles = indices.size() / 3;
+        cacheSize = std::max(cacheSize, 4u);
+
+        // triangles adjacent to each vertex
+        std::vector<uint32_t> liveTriangles(numVertices, 0);
+        for (auto index : indices) ++liveTriangles[index];
+
+        std::vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+        for (uint32_t v = 0; v < numVertices; ++v) adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); ++i) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<int> cachePositions(numVertices, -1);
+        auto vertexScore = [&](uint32_t v) -> float {
+            if (liveTriangles[v] == 0) return -1.0f;
+
+            float score = 0.0f;
+            int position = cachePositions[v];
+            if (position >= 0)
+            {
+                if (position < 3)
+                    score = lastTriangleScore;
+                else
+                    score = std::pow(1.0f - float(position - 3) / float(cacheSize - 3), cacheDecayPower);
+            }
+            return score + valenceBoostScale * std::pow(float(liveTriangles[v]), -valenceBoostPower);
+        };
+
+        std::vector<float> vertexScores(numVertices);
+        for (uint32_t v = 0; v < numVertices; ++v) vertexScores[v] = vertexScore(v);
+
+        std::vector<float> triangleScores(numTriangles);
+        for (size_t t = 0; t < numTriangles; ++t) triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+        std::vector<bool> emitted(numTriangles, false);
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+
+        std::vector<uint32_t> cache, newCache;
+        cache.reserve(cacheSize + 3);
+        newCache.reserve(cacheSize + 3);
+
+        size_t nextUnemitted = 0;
+        int64_t bestTriangle = numTriangles > 0 ? std::distance(triangleScores.begin(), std::max_element(triangleScores.begin(), triangleScores.end())) : -1;
+        while (output.size() < indices.size())
+        {
+            if (bestTriangle < 0)
+            {
+                // no triangle adjacent to the cache remains, so continue with the next triangle in the original order
+                while (emitted[nextUnemitted]) ++nextUnemitted;
+                bestTriangle = static_cast<int64_t>(nextUnemitted);
+            }
+
+            size_t triangle = static_cast<size_t>(bestTriangle);
+            emitted[triangle] = true;
+
+            const uint32_t* tri = &indices[triangle * 3];
+            newCache.assign(tri, tri + 3);
+            for (int i = 0; i < 3; ++i)
+            {
+                uint32_t v = tri[i];
+                output.push_back(v);
+
+                // remove the triangle from the vertex's live triangles
+                uint32_t begin = adjacencyOffsets[v];
+                uint32_t end = begin + liveTriangles[v];
+                for (uint32_t a = begin; a < end; ++a)
+                {
+                    if (adjacency[a] == triangle)
+                    {
+                        std::swap(adjacency[a], adjacency[end - 1]);
+                        break;
+                    }
+                }
+                --liveTriangles[v];
+            }
+
+            for (auto v : cache)
+            {
+                if (v != tri[0] && v != tri[1] && v != tri[2]) newCache.push_back(v);
+            }
+
+            // vertices pushed out of the cache lose their cache score
+            for (size_t i = cacheSize; i < newCache.size(); ++i) cachePositions[newCache[i]] = -1;
+            if (newCache.size() > cacheSize) newCache.resize(cacheSize);
+            for (size_t i = 0; i < newCache.size(); ++i) cachePositions[newCache[i]] = static_cast<int>(i);
+
+            // update the scores of the vertices that changed and their triangles, and pick the best triangle adjacent to the cache
+            auto updateVertex = [&](uint32_t v) {
+                float score = vertexScore(v);
+                float delta = score - vertexScores[v];
+                vertexScores[v] = score;
+
+                uint32_t begin = adjacencyOffsets[v];
+                uint32_t end = begin + liveTriangles[v];
+                for (uint32_t a = begin; a < end; ++a) triangleScores[adjacency[a]] += delta;
+            };
+
+            for (auto v : cache)
+            {
+                if (cachePositions[v] < 0) updateVertex(v);
+            }
+            for (auto v : newCache) updateVertex(v);
+
+            bestTriangle = -1;
+            float bestScore = -1.0f;
+            for (auto v : newCache)
+            {
+                uint32_t begin = adjacencyOffsets[v];
+                uint32_t end = begin + liveTriangles[v];
+                for (uint32_t a = begin; a < end; ++a)
+                {
+                    auto t = adjacency[a];
+                    if (triangleScores[t] > bestScore)
+                    {
+                        bestScore = triangleScores[t];
+                        bestTriangle = t;
+                    }
+                }
+            }
+
+            cache.swap(newCache);
+        }
+
+        indices.swap(output);
+    }
+
+    /// split the triangles into the clusters that start where the modelled vertex cache misses all three vertices,
+    /// then sort the clusters so those facing outwards from the centre of the mesh are drawn first, occluding the inner clusters.
+    void optimizeOverdraw(std::vector<uint32_t>& indices, const vsg::vec3Array& vertices, uint32_t cacheSize)
+    {
+        size_t numTriangles = indices.size() / 3;
+        if (numTriangles < 2) return;
+
+        std::vector<size_t> clusterStarts;
+        std::vector<uint32_t> cacheTimestamps(vertices.size(), 0);
+        uint32_t timestamp = cacheSize + 1;
+        for (size_t t = 0; t < numTriangles; ++t)
+        {
+            uint32_t misses = 0;
+            for (int i = 0; i < 3; ++i)
+            {
+                uint32_t v = indices[t * 3 + i];
+                if (timestamp - cacheTimestamps[v] > cacheSize)
+                {
+                    cacheTimestamps[v] = timestamp++;
+                    ++misses;
+                }
+            }
+            if (misses == 3 || t == 0) clusterStarts.push_back(t);
+        }
+        if (clusterStarts.size() < 2) return;
+
+        vsg::vec3 meshCentroid;
+        float meshArea = 0.0f;
+        auto triangleNormal = [&](size_t t, vsg::vec3& centroid) {
+            auto& v0 = vertices.at(indices[t * 3]);
+            auto& v1 = vertices.at(indices[t * 3 + 1]);
+            auto& v2 = vertices.at(indices[t * 3 + 2]);
+            centroid = (v0 + v1 + v2) / 3.0f;
+            return vsg::cross(v1 - v0, v2 - v0);
+        };
+
+        struct Cluster
+        {
+            size_t start;
+            size_t end;
+            vsg::vec3 centroid;
+            vsg::vec3 normal;
+            float area;
+            float sortKey;
+        };
+
+        std::vector<Cluster> clusters(clusterStarts.size());
+        for (size_t c = 0; c < clusters.size(); ++c)
+        {
+            auto& cluster = clusters[c];
+            cluster.start = clusterStarts[c];
+            cluster.end = (c + 1 < clusterStarts.size()) ? clusterStarts[c + 1] : numTriangles;
+            cluster.area = 0.0f;
+
+            for (size_t t = cluster.start; t < cluster.end; ++t)
+            {
+                vsg::vec3 centroid;
+                auto normal = triangleNormal(t, centroid);
+                float area = vsg::length(normal);
+                cluster.normal += normal;
+                cluster.centroid += centroid * area;
+                cluster.area += area;
+            }
+
+            meshCentroid += cluster.centroid;
+            meshArea += cluster.area;
+            if (cluster.area > 0.0f) cluster.centroid /= cluster.area;
+        }
+
+        if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+        for (auto& cluster : clusters)
+        {
+            float length = vsg::length(cluster.normal);
+            cluster.sortKey = (length > 0.0f) ? vsg::dot(cluster.centroid - meshCentroid, cluster.normal / length) : 0.0f;
+        }
+
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& lhs, const Cluster& rhs) { return lhs.sortKey > rhs.sortKey; });
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+        for (auto& cluster : clusters)
+        {
+            output.insert(output.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+        }
+        indices.swap(output);
+    }
+
+    /// symmetric 4x4 matrix of the summed squared distances to a set of planes, along with the summed weights of the planes.
+    struct Quadric
+    {
+        double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+        double b2 = 0.0, bc = 0.0, bd = 0.0;
+        double c2 = 0.0, cd = 0.0;
+        double d2 = 0.0;
+        double weight = 0.0;
+
+        void addPlane(const vsg::dvec3& n, double d, double w)
+        {
+            a2 += w * n.x * n.x;
+            ab += w * n.x * n.y;
+            ac += w * n.x * n.z;
+            ad += w * n.x * d;
+            b2 += w * n.y * n.y;
+            bc += w * n.y * n.z;
+            bd += w * n.y * d;
+            c2 += w * n.z * n.z;
+            cd += w * n.z * d;
+            d2 += w * d * d;
+            weight += w;
+        }
+
+        Quadric& operator+=(const Quadric& rhs)
+        {
+            a2 += rhs.a2;
+            ab += rhs.ab;
+            ac += rhs.ac;
+            ad += rhs.ad;
+            b2 += rhs.b2;
+            bc += rhs.bc;
+            bd += rhs.bd;
+            c2 += rhs.c2;
+            cd += rhs.cd;
+            d2 += rhs.d2;
+            weight += rhs.weight;
+            return *this;
+        }
+
+        /// mean squared distance of the point to the planes
+        double error(const vsg::dvec3& p) const
+        {
+            if (weight <= 0.0) return 0.0;
+            double sum = a2 * p.x * p.x + 2.0 * ab * p.x * p.y + 2.0 * ac * p.x * p.z + 2.0 * ad * p.x +
+                         b2 * p.y * p.y + 2.0 * bc * p.y * p.z + 2.0 * bd * p.y +
+                         c2 * p.z * p.z + 2.0 * cd * p.z + d2;
+            return std::max(sum, 0.0) / weight;
+        }
+    };
+
+    /// simplify a triangle list by collapsing edges onto one of their end points, in order of the quadric error, until no collapse has a squared error below maxError2.
+    /// Vertices sharing a position are collapsed together, a collapse is only permitted when every vertex at the removed position shares a triangle with a vertex at the
+    /// kept position, so vertex attributes are only ever taken from a neighbouring vertex, and when it doesn't flip any triangle. Boundary edges are preserved by adding
+    /// planes perpendicular to them to the quadrics.
+    void simplifyTriangles(const std::vector<vsg::dvec3>& vertices, std::vector<uint32_t>& indices, double maxError2)
+    {
+        // map the vertices to unique positions
+        std::vector<uint32_t> positionOf(vertices.size());
+        std::vector<vsg::dvec3> positions;
+        {
+            std::map<vsg::dvec3, uint32_t> positionMap;
+            for (size_t v = 0; v < vertices.size(); ++v)
+            {
+                auto result = positionMap.emplace(vertices[v], static_cast<uint32_t>(positions.size()));
+                if (result.second) positions.push_back(vertices[v]);
+                positionOf[v] = result.first->second;
+            }
+        }
+
+        size_t numTriangles = indices.size() / 3;
+        std::vector<bool> triangleActive(numTriangles, true);
+        std::vector<std::vector<uint32_t>> positionTriangles(positions.size());
+        std::vector<Quadric> quadrics(positions.size());
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> edgeCounts;
+
+        auto edgeKey = [](uint32_t a, uint32_t b) { return a < b ? std::make_pair(a, b) : std::make_pair(b, a); };
+
+        for (size_t t = 0; t < numTriangles; ++t)
+        {
+            uint32_t p[3] = {positionOf[indices[t * 3]], positionOf[indices[t * 3 + 1]], positionOf[indices[t * 3 + 2]]};
+            if (p[0] == p[1] || p[1] == p[2] || p[2] == p[0])
+            {
+                triangleActive[t] = false;
+                continue;
+            }
+
+            auto normal = vsg::cross(positions[p[1]] - positions[p[0]], positions[p[2]] - positions[p[0]]);
+            double length = vsg::length(normal);
+            if (length > 0.0)
+            {
+                normal /= length;
+                double d = -vsg::dot(normal, positions[p[0]]);
+                for (int k = 0; k < 3; ++k) quadrics[p[k]].addPlane(normal, d, length * 0.5);
+            }
+
+            for (int k = 0; k < 3; ++k)
+            {
+                positionTriangles[p[k]].push_back(static_cast<uint32_t>(t));
+                ++edgeCounts[edgeKey(p[k], p[(k + 1) % 3])];
+            }
+        }
+
+        // constrain boundary edges with planes through the edge perpendicular to the triangle
+        const double boundaryWeight = 10.0;
+        for (size_t t = 0; t < numTriangles; ++t)
+        {
+            if (!triangleActive[t]) continue;
+
+            uint32_t p[3] = {positionOf[indices[t * 3]], positionOf[indices[t * 3 + 1]], positionOf[indices[t * 3 + 2]]};
+            auto normal = vsg::cross(positions[p[1]] - positions[p[0]], positions[p[2]] - positions[p[0]]);
+            if (vsg::length(normal) == 0.0) continue;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t a = p[k], b = p[(k + 1) % 3];
+                if (edgeCounts[edgeKey(a, b)] != 1) continue;
+
+                auto edge = positions[b] - positions[a];
+                auto planeNormal = vsg::cross(edge, normal);
+                double length = vsg::length(planeNormal);
+                if (length == 0.0) continue;
+
+                planeNormal /= length;
+                double d = -vsg::dot(planeNormal, positions[a]);
+                double w = vsg::dot(edge, edge) * boundaryWeight;
+                quadrics[a].addPlane(planeNormal, d, w);
+                quadrics[b].addPlane(planeNormal, d, w);
+            }
+        }
+
+        struct Collapse
+        {
+            double error;
+            uint32_t from;
+            uint32_t to;
+            uint32_t fromVersion;
+            uint32_t toVersion;
+
+            bool operator<(const Collapse& rhs) const { return error > rhs.error; }
+        };
+
+        std::vector<uint32_t> versions(positions.size(), 0);
+        std::vector<bool> positionActive(positions.size(), true);
+        std::priority_queue<Collapse> collapses;
+
+        auto collapseError = [&](uint32_t from, uint32_t to) {
+            Quadric q = quadrics[from];
+            q += quadrics[to];
+            return q.error(positions[to]);
+        };
+
+        auto addCollapses = [&](uint32_t p) {
+            std::set<uint32_t> neighbours;
+            for (auto t : positionTriangles[p])
+            {
+                if (!triangleActive[t]) continue;
+                for (int k = 0; k < 3; ++k)
+                {
+                    uint32_t n = positionOf[indices[t * 3 + k]];
+                    if (n != p) neighbours.insert(n);
+                }
+            }
+
+            for (auto n : neighbours)
+            {
+                double forward = collapseError(p, n);
+                double backward = collapseError(n, p);
+                if (forward <= backward)
+                    collapses.push(Collapse{forward, p, n, versions[p], versions[n]});
+                else
+                    collapses.push(Collapse{backward, n, p, versions[n], versions[p]});
+            }
+        };
+
+        for (uint32_t p = 0; p < positions.size(); ++p) addCollapses(p);
+
+        auto tryCollapse = [&](uint32_t from, uint32_t to) {
+            // map each vertex at the from position to a vertex at the to position that shares a triangle with it
+            std::vector<std::pair<uint32_t, uint32_t>> vertexMap;
+            auto mapped = [&](uint32_t vertex) {
+                for (auto& [a, b] : vertexMap)
+                    if (a == vertex) return b;
+                return invalid_index;
+            };
+
+            for (auto t : positionTriangles[from])
+            {
+                if (!triangleActive[t]) continue;
+
+                uint32_t fromVertex = invalid_index, toVertex = invalid_index;
+                for (int k = 0; k < 3; ++k)
+                {
+                    uint32_t v = indices[t * 3 + k];
+                    if (positionOf[v] == from) fromVertex = v;
+                    if (positionOf[v] == to) toVertex = v;
+                }
+                if (toVertex != invalid_index && mapped(fromVertex) == invalid_index) vertexMap.emplace_back(fromVertex, toVertex);
+            }
+
+            for (auto t : positionTriangles[from])
+            {
+                if (!triangleActive[t]) continue;
+
+                bool containsTo = false;
+                uint32_t p[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    uint32_t v = indices[t * 3 + k];
+                    p[k] = positionOf[v];
+                    if (p[k] == to) containsTo = true;
+                    if (p[k] == from && mapped(v) == invalid_index) return false;
+                }
+                if (containsTo) continue;
+
+                // reject collapses that flip the remaining triangles
+                auto before = vsg::cross(positions[p[1]] - positions[p[0]], positions[p[2]] - positions[p[0]]);
+                for (auto& pk : p)
+                    if (pk == from) pk = to;
+                auto after = vsg::cross(positions[p[1]] - positions[p[0]], positions[p[2]] - positions[p[0]]);
+                if (vsg::dot(before, after) <= 0.0) return false;
+            }
+
+            for (auto t : positionTriangles[from])
+            {
+                if (!triangleActive[t]) continue;
+
+                bool containsTo = false;
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (positionOf[indices[t * 3 + k]] == to) containsTo = true;
+                }
+
+                if (containsTo)
+                {
+                    triangleActive[t] = false;
+                    continue;
+                }
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    auto& v = indices[t * 3 + k];
+                    if (positionOf[v] == from) v = mapped(v);
+                }
+                positionTriangles[to].push_back(t);
+            }
+
+            quadrics[to] += quadrics[from];
+            positionActive[from] = false;
+            positionTriangles[from].clear();
+            return true;
+        };
+
+        while (!collapses.empty())
+        {
+            auto collapse = collapses.top();
+            collapses.pop();
+
+            if (collapse.error > maxError2) break;
+            if (!positionActive[collapse.from] || !positionActive[collapse.to]) continue;
+            if (versions[collapse.from] != collapse.fromVersion || versions[collapse.to] != collapse.toVersion) continue;
+
+            if (tryCollapse(collapse.from, collapse.to))
+            {
+                ++versions[collapse.to];
+                addCollapses(collapse.to);
+            }
+        }
+
+        std::vector<uint32_t> output;
+        for (size_t t = 0; t < numTriangles; ++t)
+        {
+            if (triangleActive[t]) output.insert(output.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+        }
+        indices.swap(output);
+    }
+
+    /// read the positions from a vec3Array or the snorm16 svec4Array used by quantized positions, which only differ from the original positions by a uniform scale and translation.
+    bool readPositions(const vsg::Data& data, std::vector<vsg::dvec3>& positions)
+    {
+        if (auto vertices = data.cast<vsg::vec3Array>())
+        {
+            positions.clear();
+            for (auto& v : *vertices) positions.emplace_back(v.x, v.y, v.z);
+            return true;
+        }
+        if (auto quantizedVertices = data.cast<vsg::svec4Array>())
+        {
+            positions.clear();
+            for (auto& v : *quantizedVertices) positions.emplace_back(v.x, v.y, v.z);
+            return true;
+        }
+        return false;
+    }
+
+    /// return the topology of the GraphicsPipeline bound by the StateGroup, or the inherited topology if it doesn't bind one.
+    VkPrimitiveTopology pipelineTopology(const vsg::StateGroup& stateGroup, VkPrimitiveTopology topology)
+    {
+        for (auto& stateCommand : stateGroup.stateCommands)
+        {
+            if (auto bindPipeline = stateCommand.cast<vsg::BindGraphicsPipeline>(); bindPipeline && bindPipeline->pipeline)
+            {
+                for (auto& pipelineState : bindPipeline->pipeline->pipelineStates)
+                {
+                    if (auto inputAssemblyState = pipelineState.cast<vsg::InputAssemblyState>()) topology = inputAssemblyState->topology;
+                }
+            }
+        }
+        return topology;
+    }
+
+} // namespace
+
+void OptimizeMeshes::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void OptimizeMeshes::apply(vsg::StateGroup& stateGroup)
+{
+    auto previous = _topology;
+    _topology = pipelineTopology(stateGroup, _topology);
+
+    stateGroup.traverse(*this);
+
+    _topology = previous;
+}
+
+void OptimizeMeshes::apply(vsg::VertexIndexDraw& vid)
+{
+    if (_visited.insert(&vid).second && optimize(vid, _topology)) ++numOptimized;
+}
+
+bool OptimizeMeshes::optimize(vsg::VertexIndexDraw& vid, VkPrimitiveTopology topology) const
+{
+    if (!vid.indices || !vid.indices->data || vid.arrays.empty() || !vid.arrays.front() || !vid.arrays.front()->data) return false;
+
+    auto& originalIndices = *vid.indices->data;
+    std::vector<uint32_t> indices;
+    if (!readIndices(originalIndices, indices) || indices.empty()) return false;
+
+    // only whole index buffers can be reordered
+    if (vid.firstIndex != 0 || vid.vertexOffset != 0 || vid.indexCount != indices.size()) return false;
+
+    // vertex arrays are those with an entry per vertex, per instance arrays are left unchanged
+    uint32_t numVertices = vid.arrays.front()->data->valueCount();
+    for (auto index : indices)
+    {
+        if (index >= numVertices) return false;
+    }
+
+    std::vector<const vsg::Data*> vertexArrays;
+    bool remapVertices = weldVertices || optimizeVertexFetch;
+    for (auto& bufferInfo : vid.arrays)
+    {
+        if (!bufferInfo || !bufferInfo->data) return false;
+        if (bufferInfo->data->valueCount() != numVertices) continue;
+
+        vertexArrays.push_back(bufferInfo->data.get());
+        if (!supportedArray(*bufferInfo->data)) remapVertices = false;
+    }
+
+    if (!remapVertices) vsg::debug("OptimizeMeshes::optimize() unsupported vertex array type, vertices not welded or reordered.");
+
+    bool triangles = topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST && (indices.size() % 3) == 0;
+    if (!remapVertices && !triangles) return false;
+
+    if (remapVertices && weldVertices) ::weldVertices(vertexArrays, numVertices, indices);
+
+    if (triangles && optimizeVertexCache) ::optimizeVertexCache(indices, numVertices, vertexCacheSize);
+
+    if (triangles && optimizeOverdraw)
+    {
+        if (auto vertices = vid.arrays.front()->data.cast<vsg::vec3Array>())
+        {
+            ::optimizeOverdraw(indices, *vertices, vertexCacheSize);
+        }
+        else if (auto quantizedVertices = vid.arrays.front()->data.cast<vsg::svec4Array>())
+        {
+            // snorm16 positions only differ from the original positions by a uniform scale and translation so the cluster order is unchanged
+            auto dequantizedVertices = vsg::vec3Array::create(quantizedVertices->size());
+            auto itr = dequantizedVertices->begin();
+            for (auto& v : *quantizedVertices) (itr++)->set(v.x, v.y, v.z);
+            ::optimizeOverdraw(indices, *dequantizedVertices, vertexCacheSize);
+        }
+    }
+
+    vsg::DataList arrays;
+    if (remapVertices)
+    {
+        // number the vertices in the order they are first referenced, which also drops vertices welded to others or no longer referenced
+        std::vector<uint32_t> oldToNew(numVertices, invalid_index);
+        std::vector<uint32_t> newToOld;
+        newToOld.reserve(numVertices);
+        for (auto& index : indices)
+        {
+            if (oldToNew[index] == invalid_index)
+            {
+                oldToNew[index] = static_cast<uint32_t>(newToOld.size());
+                newToOld.push_back(index);
+            }
+            index = oldToNew[index];
+        }
+
+        for (auto& bufferInfo : vid.arrays)
+        {
+            if (bufferInfo->data->valueCount() == numVertices)
+                arrays.push_back(remapArray(*bufferInfo->data, newToOld));
+            else
+                arrays.push_back(bufferInfo->data);
+        }
+    }
+    else
+    {
+        for (auto& bufferInfo : vid.arrays) arrays.push_back(bufferInfo->data);
+    }
+
+    vid.assignArrays(arrays);
+    vid.assignIndices(createIndices(originalIndices, indices));
+    vid.indexCount = static_cast<uint32_t>(indices.size());
+
+    return true;
+}
+
+void GenerateLODs::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void GenerateLODs::apply(vsg::Group& group)
+{
+    for (auto& child : group.children)
+    {
+        if (auto vid = child.cast<vsg::VertexIndexDraw>())
+        {
+            auto itr = _lods.find(vid);
+            if (itr == _lods.end())
+            {
+                itr = _lods.emplace(vid, createLOD(*vid, _topology)).first;
+                if (itr->second) ++numLODs;
+            }
+            if (itr->second) child = itr->second;
+        }
+        else if (child)
+        {
+            child->accept(*this);
+        }
+    }
+}
+
+void GenerateLODs::apply(vsg::StateGroup& stateGroup)
+{
+    auto previous = _topology;
+    _topology = pipelineTopology(stateGroup, _topology);
+
+    apply(static_cast<vsg::Group&>(stateGroup));
+
+    _topology = previous;
+}
+
+vsg::ref_ptr<vsg::Node> GenerateLODs::createLOD(vsg::VertexIndexDraw& vid, VkPrimitiveTopology topology) const
+{
+    if (topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST || vid.instanceCount != 1 || vid.indexCount < minimumTriangles * 3) return {};
+    if (vid.arrays.empty() || !vid.arrays.front() || !vid.arrays.front()->data) return {};
+
+    std::vector<vsg::dvec3> positions;
+    if (!readPositions(*vid.arrays.front()->data, positions) || positions.empty()) return {};
+
+    vsg::dbox bounds;
+    for (auto& position : positions) bounds.add(position);
+
+    // only keep levels that remove a worthwhile proportion of the triangles of the previous level
+    std::vector<std::pair<float, vsg::ref_ptr<vsg::VertexIndexDraw>>> levels;
+    uint32_t previousIndexCount = vid.indexCount;
+    float maxError = errorThreshold;
+    for (uint32_t level = 0; level < numLevels; ++level, maxError *= 2.0f)
+    {
+        auto simplified = simplify(vid, maxError);
+        if (!simplified) break;
+        if (simplified->indexCount > (previousIndexCount / 5) * 4) continue;
+
+        previousIndexCount = simplified->indexCount;
+        levels.emplace_back(maxError, simplified);
+        if (previousIndexCount == 0) break;
+    }
+
+    if (levels.empty()) return {};
+
+    // switch to the less detailed level once its error, relative to the bound diameter, projects to less than screenErrorRatio of the screen height
+    auto lod = vsg::LOD::create();
+    lod->bound.set((bounds.min.x + bounds.max.x) * 0.5, (bounds.min.y + bounds.max.y) * 0.5, (bounds.min.z + bounds.max.z) * 0.5, vsg::length(bounds.max - bounds.min) * 0.5);
+    if (vid.arrays.front()->data->is_compatible(typeid(vsg::svec4Array)))
+    {
+        // the bound is in the quantized coordinates so convert to those of the dequantizing transform
+        const double scale = 1.0 / 32767.0;
+        lod->bound.center *= scale;
+        lod->bound.radius *= scale;
+    }
+
+    lod->addChild(vsg::LOD::Child{screenErrorRatio / levels.front().first, vsg::ref_ptr<vsg::Node>(&vid)});
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        auto& [error, simplified] = levels[i];
+        double minimumScreenHeightRatio = (i + 1 < levels.size()) ? screenErrorRatio / levels[i + 1].first : 0.0;
+
+        // a level simplified to nothing is represented by not drawing anything beyond its switching distance
+        if (simplified->indexCount > 0) lod->addChild(vsg::LOD::Child{minimumScreenHeightRatio, simplified});
+    }
+
+    std::string name;
+    if (vid.getValue("name", name)) lod->setValue("name", name);
+
+    return lod;
+}
+
+vsg::ref_ptr<vsg::VertexIndexDraw> GenerateLODs::simplify(const vsg::VertexIndexDraw& vid, float maxError) const
+{
+    if (!vid.indices || !vid.indices->data || vid.arrays.empty() || !vid.arrays.front() || !vid.arrays.front()->data) return {};
+
+    auto& originalIndices = *vid.indices->data;
+    std::vector<uint32_t> indices;
+    if (!readIndices(originalIndices, indices) || indices.empty() || (indices.size() % 3) != 0) return {};
+    if (vid.firstIndex != 0 || vid.vertexOffset != 0 || vid.indexCount != indices.size()) return {};
+
+    std::vector<vsg::dvec3> positions;
+    if (!readPositions(*vid.arrays.front()->data, positions)) return {};
+
+    for (auto index : indices)
+    {
+        if (index >= positions.size()) return {};
+    }
+
+    vsg::dbox bounds;
+    for (auto& position : positions) bounds.add(position);
+
+    double error = static_cast<double>(maxError) * vsg::length(bounds.max - bounds.min);
+    simplifyTriangles(positions, indices, error * error);
+
+    // the vertex arrays are shared with the original, only the indices are replaced
+    auto simplified = vsg::VertexIndexDraw::create();
+    simplified->arrays = vid.arrays;
+    simplified->assignIndices(createIndices(originalIndices, indices));
+    simplified->indexCount = static_cast<uint32_t>(indices.size());
+    simplified->instanceCount = vid.instanceCount;
+    simplified->firstInstance = vid.firstInstance;
+    return simplified;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgXchange/read_memory.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace vsgXchange
+{
+    /// call func(i) for each i in [0, count) using up to numThreads threads, including the calling thread.
+    /// Indices are handed out one at a time so items that vary in cost are balanced across the threads, returns once all items have been processed.
+    template<typename Func>
+    void parallel_for(size_t count, uint32_t numThreads, Func func)
+    {
+        numThreads = static_cast<uint32_t>(std::min<size_t>(std::max(1u, numThreads), count));
+        if (numThreads <= 1)
+        {
+            for (size_t i = 0; i < count; ++i) func(i);
+            return;
+        }
+
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t i = next++; i < count; i = next++) func(i);
+        };
+
+        // the allocations made on the worker threads count towards the read in progress on the calling thread
+        auto readMemory = currentReadMemory();
+
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < numThreads; ++i)
+        {
+            threads.emplace_back([&]() {
+                ScopedReadMemory scopedReadMemory(readMemory);
+                worker();
+            });
+        }
+        worker();
+        for (auto& thread : threads) thread.join();
+    }
+
+} // namespace vsgXchange
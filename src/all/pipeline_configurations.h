@@ -0,0 +1,158 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/core/compare.h>
+#include <vsg/nodes/StateGroup.h>
+#include <vsg/state/ColorBlendState.h>
+#include <vsg/state/InputAssemblyState.h>
+#include <vsg/state/RasterizationState.h>
+#include <vsg/state/VertexInputState.h>
+#include <vsg/utils/GraphicsPipelineConfigurator.h>
+#include <vsg/utils/SharedObjects.h>
+
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vsgXchange
+{
+    /// the GraphicsPipelineConfigurator of the meshes converted by a read, deduplicated as they're assigned and initialized together once all the meshes have been converted.
+    /// assign() finds an equivalent configuration from a hash of its shader defines and pipeline states, rather than initializing each configuration while holding
+    /// the SharedObjects lock, then initialize() initializes the unique configurations concurrently and binds them to each mesh's StateGroup.
+    class PipelineConfigurations
+    {
+    public:
+        /// replace config with an equivalent configuration already assigned, deferring config->copyTo(stateGroup) until initialize(). Can be called from multiple threads.
+        void assign(vsg::ref_ptr<vsg::GraphicsPipelineConfigurator>& config, vsg::ref_ptr<vsg::StateGroup> stateGroup)
+        {
+            auto hash = hashConfiguration(*config);
+
+            std::scoped_lock<std::mutex> lock(_mutex);
+            auto range = _configurations.equal_range(hash);
+            auto itr = std::find_if(range.first, range.second, [&](auto& entry) { return vsg::compare_pointer(entry.second, config) == 0; });
+            if (itr != range.second)
+                config = itr->second;
+            else
+                _configurations.emplace(hash, config);
+
+            _stateGroups.emplace_back(config, stateGroup);
+        }
+
+        /// initialize the unique configurations using up to numThreads threads, replace those equivalent to configurations already held by sharedObjects,
+        /// such as from previous reads, and copy the pipeline and descriptor set bindings to the StateGroups assigned.
+        void initialize(vsg::ref_ptr<vsg::SharedObjects> sharedObjects, uint32_t numThreads)
+        {
+            std::vector<vsg::ref_ptr<vsg::GraphicsPipelineConfigurator>> unique;
+            unique.reserve(_configurations.size());
+            for (auto& entry : _configurations) unique.push_back(entry.second);
+
+            parallel_for(unique.size(), numThreads, [&](size_t i) { unique[i]->init(); });
+
+            std::map<const vsg::GraphicsPipelineConfigurator*, vsg::ref_ptr<vsg::GraphicsPipelineConfigurator>> shared;
+            for (auto& config : unique)
+            {
+                auto& sharedConfig = shared[config.get()];
+                sharedConfig = config;
+                if (sharedObjects) sharedObjects->share(sharedConfig);
+            }
+
+            for (auto& [config, stateGroup] : _stateGroups)
+            {
+                shared[config.get()]->copyTo(stateGroup, sharedObjects);
+            }
+
+            clear();
+        }
+
+        /// discard the assigned configurations, such as when a read is abandoned.
+        void clear()
+        {
+            _configurations.clear();
+            _stateGroups.clear();
+        }
+
+        /// return a hash of the defines and pipeline states that distinguish the configurations of the meshes of a model, equivalent configurations have the same hash.
+        static uint64_t hashConfiguration(const vsg::GraphicsPipelineConfigurator& config)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            auto add = [&hash](const void* ptr, size_t size) {
+                auto bytes = static_cast<const uint8_t*>(ptr);
+                for (size_t i = 0; i < size; ++i) hash = (hash ^ bytes[i]) * 1099511628211ull;
+            };
+            auto addValue = [&add](const auto& value) { add(&value, sizeof(value)); };
+
+            addValue(config.subpass);
+            addValue(config.baseAttributeBinding);
+            if (config.shaderHints)
+            {
+                for (auto& define : config.shaderHints->defines) add(define.data(), define.size());
+            }
+
+            for (auto& state : config.pipelineStates)
+            {
+                if (auto vertexInputState = state.cast<vsg::VertexInputState>())
+                {
+                    for (auto& binding : vertexInputState->vertexBindingDescriptions)
+                    {
+                        addValue(binding.binding);
+                        addValue(binding.stride);
+                        addValue(binding.inputRate);
+                    }
+                    for (auto& attribute : vertexInputState->vertexAttributeDescriptions)
+                    {
+                        addValue(attribute.location);
+                        addValue(attribute.binding);
+                        addValue(attribute.format);
+                        addValue(attribute.offset);
+                    }
+                }
+                else if (auto inputAssemblyState = state.cast<vsg::InputAssemblyState>())
+                {
+                    addValue(inputAssemblyState->topology);
+                }
+                else if (auto rasterizationState = state.cast<vsg::RasterizationState>())
+                {
+                    addValue(rasterizationState->cullMode);
+                }
+                else if (auto colorBlendState = state.cast<vsg::ColorBlendState>())
+                {
+                    for (auto& attachment : colorBlendState->attachments) addValue(attachment.blendEnable);
+                }
+            }
+            return hash;
+        }
+
+    protected:
+        std::mutex _mutex;
+        std::unordered_multimap<uint64_t, vsg::ref_ptr<vsg::GraphicsPipelineConfigurator>> _configurations;
+        std::vector<std::pair<vsg::ref_ptr<vsg::GraphicsPipelineConfigurator>, vsg::ref_ptr<vsg::StateGroup>>> _stateGroups;
+    };
+
+} // namespace vsgXchange
@@ -0,0 +1,115 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+
+#include <vsgXchange/read_memory.h>
+
+#include <vsg/core/Allocator.h>
+
+#include <algorithm>
+
+using namespace vsgXchange;
+
+namespace
+{
+    thread_local ReadMemory* s_currentReadMemory = nullptr;
+}
+
+ReadMemory::ReadMemory(uint64_t in_budget) :
+    _parent(s_currentReadMemory),
+    _budget(in_budget)
+{
+    // a nested read can only use what remains of the budget of the read it's nested within, with at least 1 byte as a budget of 0 is unlimited
+    if (_parent)
+    {
+        _parentAllocated = _parent->allocated();
+        if (_parent->budget() > 0)
+        {
+            uint64_t remaining = std::max<uint64_t>(_parent->budget() - std::min(_parent->budget(), _parentAllocated), 1);
+            _budget = (_budget > 0) ? std::min(_budget, remaining) : remaining;
+        }
+    }
+
+    s_currentReadMemory = this;
+}
+
+ReadMemory::~ReadMemory()
+{
+    s_currentReadMemory = _parent;
+
+    if (_parent)
+    {
+        // the nested read's data is now held by the read it's nested within, and as its budget is bounded by what remained of the parent's, exceeding it exceeds the parent's too
+        _parent->_allocated += _allocated.load();
+        if (_exceeded) _parent->_exceeded = true;
+
+        uint64_t nestedPeak = _parentAllocated + _peak.load();
+        uint64_t parentPeak = _parent->_peak.load();
+        while (nestedPeak > parentPeak && !_parent->_peak.compare_exchange_weak(parentPeak, nestedPeak)) {}
+    }
+}
+
+bool ReadMemory::reserve(uint64_t size)
+{
+    uint64_t previous = _allocated.load();
+    uint64_t next = 0;
+    do
+    {
+        next = previous + size;
+        if (_budget > 0 && next > _budget)
+        {
+            _exceeded = true;
+            return false;
+        }
+    } while (!_allocated.compare_exchange_weak(previous, next));
+
+    uint64_t peak = _peak.load();
+    while (next > peak && !_peak.compare_exchange_weak(peak, next)) {}
+
+    return true;
+}
+
+void ReadMemory::release(uint64_t size)
+{
+    uint64_t previous = _allocated.load();
+    while (!_allocated.compare_exchange_weak(previous, (previous > size) ? (previous - size) : 0)) {}
+}
+
+ReadMemory* vsgXchange::currentReadMemory()
+{
+    return s_currentReadMemory;
+}
+
+ScopedReadMemory::ScopedReadMemory(ReadMemory* readMemory) :
+    _previous(s_currentReadMemory)
+{
+    s_currentReadMemory = readMemory;
+}
+
+ScopedReadMemory::~ScopedReadMemory()
+{
+    s_currentReadMemory = _previous;
+}
+
+uint64_t vsgXchange::readMemoryBudget(const vsg::Options* options)
+{
+    uint64_t budget = 0;
+    if (options && options->getAuxiliary()) options->getValue(read_memory_budget, budget);
+    return budget;
+}
+
+void* vsgXchange::allocateReadData(size_t size)
+{
+    if (!reserveReadMemory(size)) return nullptr;
+    return vsg::allocate(size, vsg::ALLOCATOR_AFFINITY_DATA);
+}
@@ -0,0 +1,71 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <vsgXchange/read_write_observer.h>
+
+using namespace vsgXchange;
+
+ReadWriteObserver::ReadWriteObserver(Callback in_callback) :
+    callback(in_callback)
+{
+}
+
+void ReadWriteObserver::report(const ReadWriteEvent& event)
+{
+    if (callback) callback(event);
+}
+
+namespace
+{
+    thread_local ReadWriteEvent* s_currentEvent = nullptr;
+}
+
+ReadWriteEvent* vsgXchange::currentReadWriteEvent()
+{
+    return s_currentEvent;
+}
+
+ReadWriteEvent* vsgXchange::setCurrentReadWriteEvent(ReadWriteEvent* event)
+{
+    auto previous = s_currentEvent;
+    s_currentEvent = event;
+    return previous;
+}
+
+ReadWritePhaseTimer::ReadWritePhaseTimer(const char* name) :
+    _event(s_currentEvent)
+{
+    next(name);
+}
+
+ReadWritePhaseTimer::~ReadWritePhaseTimer()
+{
+    end();
+}
+
+void ReadWritePhaseTimer::next(const char* name)
+{
+    if (!_event) return;
+
+    end();
+    _name = name;
+    _start = std::chrono::steady_clock::now();
+}
+
+void ReadWritePhaseTimer::end()
+{
+    if (!_event || !_name) return;
+
+    _event->phases.push_back(ReadWritePhase{_name, std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count()});
+    _name = nullptr;
+}
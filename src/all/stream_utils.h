@@ -0,0 +1,119 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/io/mem_stream.h>
+
+#include <cstdint>
+#include <istream>
+#include <sstream>
+#include <streambuf>
+#include <vector>
+
+namespace vsgXchange
+{
+    /// contiguous view of the remaining contents of a std::istream, either referencing the memory the stream already reads from, or the storage the contents were read into.
+    struct StreamData
+    {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        std::vector<uint8_t> storage;
+
+        bool owned() const { return !storage.empty() && data == storage.data(); }
+    };
+
+    namespace detail
+    {
+        /// provide access to the get area of a std::streambuf, so in memory streams can be read without copying.
+        struct streambuf_access : public std::streambuf
+        {
+            static const char* current(std::streambuf* buf) { return (buf->*(&streambuf_access::gptr))(); }
+            static const char* end(std::streambuf* buf) { return (buf->*(&streambuf_access::egptr))(); }
+        };
+    } // namespace detail
+
+    /// read the remaining contents of a std::istream into a StreamData.
+    /// vsg::mem_stream and std::istringstream are referenced in place, std::stringstream contents are copied directly from str(),
+    /// seekable streams are read into storage allocated up front from a tellg()/seekg() size probe, and only non seekable streams are read in chunks.
+    /// Returns false if no data could be read.
+    inline bool readStream(std::istream& fin, StreamData& result)
+    {
+        result = {};
+
+        if (dynamic_cast<vsg::mem_stream*>(&fin) || dynamic_cast<std::istringstream*>(&fin))
+        {
+            // the whole of the stream's content is in the get area so can be used directly.
+            auto buf = fin.rdbuf();
+            auto begin = detail::streambuf_access::current(buf);
+            auto end = detail::streambuf_access::end(buf);
+            if (begin && end > begin)
+            {
+                result.data = reinterpret_cast<const uint8_t*>(begin);
+                result.size = static_cast<size_t>(end - begin);
+                return true;
+            }
+        }
+
+        if (auto sstr = dynamic_cast<std::stringstream*>(&fin))
+        {
+            auto pos = fin.tellg();
+            auto str = sstr->str();
+            size_t offset = pos > 0 ? static_cast<size_t>(pos) : 0;
+            if (offset < str.size()) result.storage.assign(str.begin() + offset, str.end());
+        }
+        else
+        {
+            auto pos = fin.tellg();
+            if (pos != std::istream::pos_type(-1) && fin.seekg(0, std::ios_base::end))
+            {
+                auto end = fin.tellg();
+                fin.seekg(pos);
+                if (end > pos)
+                {
+                    result.storage.resize(static_cast<size_t>(end - pos));
+                    fin.read(reinterpret_cast<char*>(result.storage.data()), result.storage.size());
+                    result.storage.resize(static_cast<size_t>(fin.gcount()));
+                }
+            }
+            else
+            {
+                // non seekable stream so read in chunks, growing geometrically
+                fin.clear();
+                size_t size = 0;
+                result.storage.resize(1 << 16);
+                while (fin.read(reinterpret_cast<char*>(result.storage.data() + size), result.storage.size() - size), fin.gcount() > 0)
+                {
+                    size += static_cast<size_t>(fin.gcount());
+                    if (size == result.storage.size()) result.storage.resize(result.storage.size() * 2);
+                }
+                result.storage.resize(size);
+            }
+        }
+
+        result.data = result.storage.data();
+        result.size = result.storage.size();
+        return result.size > 0;
+    }
+
+} // namespace vsgXchange
@@ -0,0 +1,414 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgXchange/read_memory.h>
+#include <vsgXchange/texture_arrays.h>
+
+#include <vsg/core/Array3D.h>
+#include <vsg/io/Logger.h>
+#include <vsg/state/ShaderModule.h>
+#include <vsg/state/ShaderStage.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+
+using namespace vsgXchange;
+
+namespace
+{
+    //
+    // minimal GLSL tokenizer, just enough to find the uses of the samplers with comments skipped
+    //
+    struct Token
+    {
+        enum Type
+        {
+            IDENTIFIER,
+            NUMBER,
+            PUNCTUATION
+        };
+
+        Type type;
+        size_t position;
+        size_t length;
+    };
+
+    bool isIdentifierChar(char c)
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    std::vector<Token> tokenize(const std::string& source)
+    {
+        std::vector<Token> tokens;
+        size_t i = 0;
+        const size_t size = source.size();
+        while (i < size)
+        {
+            char c = source[i];
+            if (std::isspace(static_cast<unsigned char>(c)))
+            {
+                ++i;
+            }
+            else if (c == '/' && (i + 1) < size && source[i + 1] == '/')
+            {
+                i = source.find('\n', i);
+                if (i == std::string::npos) break;
+            }
+            else if (c == '/' && (i + 1) < size && source[i + 1] == '*')
+            {
+                i = source.find("*/", i + 2);
+                if (i == std::string::npos) break;
+                i += 2;
+            }
+            else if (isIdentifierChar(c))
+            {
+                size_t end = i;
+                while (end < size && (isIdentifierChar(source[end]) || (source[end] == '.' && std::isdigit(static_cast<unsigned char>(c))))) ++end;
+                tokens.push_back(Token{std::isdigit(static_cast<unsigned char>(c)) ? Token::NUMBER : Token::IDENTIFIER, i, end - i});
+                i = end;
+            }
+            else
+            {
+                tokens.push_back(Token{Token::PUNCTUATION, i, 1});
+                ++i;
+            }
+        }
+        return tokens;
+    }
+
+    struct Edit
+    {
+        size_t position;
+        size_t length;
+        std::string text;
+    };
+
+    struct Shader
+    {
+        std::string source;
+        std::vector<Token> tokens;
+
+        bool is(size_t i, const char* str) const { return i < tokens.size() && source.compare(tokens[i].position, tokens[i].length, str) == 0; }
+        bool isIdentifier(size_t i) const { return i < tokens.size() && tokens[i].type == Token::IDENTIFIER; }
+        std::string str(size_t i) const { return source.substr(tokens[i].position, tokens[i].length); }
+        size_t end(size_t i) const { return tokens[i].position + tokens[i].length; }
+
+        bool contains(const std::string& name) const
+        {
+            for (size_t i = 0; i < tokens.size(); ++i)
+            {
+                if (isIdentifier(i) && is(i, name.c_str())) return true;
+            }
+            return false;
+        }
+
+        /// return the index of the token that ends the parenthesized argument list, or argument, starting at i, tokens.size() if it isn't terminated.
+        size_t closing(size_t i, bool stopAtComma) const
+        {
+            int depth = 0;
+            for (; i < tokens.size(); ++i)
+            {
+                if (is(i, "(") || is(i, "[")) ++depth;
+                else if (is(i, ")") || is(i, "]"))
+                {
+                    if (depth == 0) return i;
+                    if (--depth == 0 && !stopAtComma) return i;
+                }
+                else if (stopAtComma && depth == 0 && is(i, ",")) return i;
+            }
+            return tokens.size();
+        }
+
+        /// return the highest location assigned by layout(location = N) to the in or out variables, -1 if there aren't any.
+        int maxLocation(const char* qualifier) const
+        {
+            int result = -1;
+            for (size_t i = 0; i < tokens.size(); ++i)
+            {
+                if (!is(i, "layout") || !is(i + 1, "(")) continue;
+
+                size_t close = closing(i + 1, false);
+                int location = -1;
+                for (size_t j = i + 2; (j + 2) < close; ++j)
+                {
+                    if (is(j, "location") && is(j + 1, "=") && tokens[j + 2].type == Token::NUMBER) location = std::atoi(str(j + 2).c_str());
+                }
+                if (location < 0) continue;
+
+                size_t j = close + 1;
+                while (is(j, "flat") || is(j, "smooth") || is(j, "noperspective") || is(j, "centroid")) ++j;
+                if (!is(j, qualifier) || !isIdentifier(j + 1)) continue;
+
+                // matrices and arrays occupy consecutive locations
+                int count = 1;
+                auto type = str(j + 1);
+                if (type.compare(0, 3, "mat") == 0 && type.size() > 3) count = type[3] - '0';
+                if (is(j + 3, "[") && j + 4 < tokens.size() && tokens[j + 4].type == Token::NUMBER) count *= std::atoi(str(j + 4).c_str());
+
+                result = std::max(result, location + count - 1);
+            }
+            return result;
+        }
+
+        /// return the position of the start of the first layout line outside of any #if block, where global declarations can be inserted.
+        size_t declarationPosition() const
+        {
+            int depth = 0;
+            size_t position = 0;
+            while (position < source.size())
+            {
+                size_t lineEnd = source.find('\n', position);
+                if (lineEnd == std::string::npos) lineEnd = source.size();
+
+                size_t start = source.find_first_not_of(" \t", position);
+                if (start < lineEnd)
+                {
+                    if (source.compare(start, 3, "#if") == 0) ++depth;
+                    else if (source.compare(start, 6, "#endif") == 0) --depth;
+                    else if (depth == 0 && source.compare(start, 6, "layout") == 0) return position;
+                }
+                position = lineEnd + 1;
+            }
+            return std::string::npos;
+        }
+
+        /// return the position just after the opening brace of main(), std::string::npos if there isn't one.
+        size_t mainPosition() const
+        {
+            for (size_t i = 1; i < tokens.size(); ++i)
+            {
+                if (is(i - 1, "void") && is(i, "main") && is(i + 1, "("))
+                {
+                    size_t j = closing(i + 1, false) + 1;
+                    if (is(j, "{")) return end(j);
+                }
+            }
+            return std::string::npos;
+        }
+
+        /// add the edits that sample name as a sampler2DArray at the layer selected by the float layer expression, returns false if name is used in a way that can't be converted.
+        bool convert(const std::string& name, const std::string& layer, std::vector<Edit>& edits) const
+        {
+            static const std::set<std::string> floatCoordinates{"texture", "textureLod", "textureGrad", "textureOffset", "textureLodOffset", "textureGradOffset", "textureGather", "textureGatherOffset"};
+            static const std::set<std::string> integerCoordinates{"texelFetch", "texelFetchOffset"};
+
+            for (size_t i = 0; i < tokens.size(); ++i)
+            {
+                if (!isIdentifier(i) || !is(i, name.c_str())) continue;
+
+                if (i > 0 && is(i - 1, "sampler2D"))
+                {
+                    edits.push_back(Edit{tokens[i - 1].position, tokens[i - 1].length, "sampler2DArray"});
+                    continue;
+                }
+
+                if (i < 2 || !is(i - 1, "(") || !isIdentifier(i - 2)) return false;
+
+                auto function = str(i - 2);
+                if (function == "textureSize")
+                {
+                    // textureSize of an array returns ivec3, keep the ivec2 the shader expects
+                    size_t close = closing(i - 1, false);
+                    if (close == tokens.size()) return false;
+                    edits.push_back(Edit{end(close), 0, ".xy"});
+                    continue;
+                }
+                if (function == "textureQueryLevels") continue;
+
+                bool floatCoordinate = floatCoordinates.count(function) > 0;
+                if (!floatCoordinate && integerCoordinates.count(function) == 0) return false;
+                if (!is(i + 1, ",")) return false;
+
+                size_t argumentEnd = closing(i + 2, true);
+                if (argumentEnd == tokens.size() || argumentEnd == (i + 2)) return false;
+
+                edits.push_back(Edit{tokens[i + 2].position, 0, floatCoordinate ? "vec3(" : "ivec3("});
+                edits.push_back(Edit{end(argumentEnd - 1), 0, floatCoordinate ? (", " + layer + ")") : (", int(" + layer + "))")});
+            }
+            return true;
+        }
+
+        bool declares(const std::string& name) const
+        {
+            for (size_t i = 1; i < tokens.size(); ++i)
+            {
+                if (is(i - 1, "sampler2D") && is(i, name.c_str())) return true;
+            }
+            return false;
+        }
+    };
+
+    std::string apply(std::string source, std::vector<Edit> edits)
+    {
+        std::stable_sort(edits.begin(), edits.end(), [](const Edit& lhs, const Edit& rhs) { return lhs.position > rhs.position; });
+        for (auto& edit : edits)
+        {
+            source.replace(edit.position, edit.length, edit.text);
+        }
+        return source;
+    }
+
+    template<typename T>
+    vsg::ref_ptr<vsg::Data> createArray(uint32_t width, uint32_t height, uint32_t depth, void* data, const vsg::Data::Properties& properties)
+    {
+        return vsg::Array3D<T>::create(width, height, depth, static_cast<T*>(data), properties);
+    }
+
+} // namespace
+
+std::set<std::string> vsgXchange::convertToTextureArrays(vsg::ShaderSet& shaderSet, const std::set<std::string>& textureNames)
+{
+    const std::string layerAttribute = texture_layer_attribute;
+    const std::string layerVarying = "textureLayer";
+
+    vsg::ref_ptr<vsg::ShaderStage> vertexStage, fragmentStage;
+    for (auto& stage : shaderSet.stages)
+    {
+        // geometry and tessellation stages would have to pass the layer on, so are left to hand written shaders
+        if (!stage->module || stage->module->source.empty()) return {};
+        if (stage->stage == VK_SHADER_STAGE_VERTEX_BIT) vertexStage = stage;
+        else if (stage->stage == VK_SHADER_STAGE_FRAGMENT_BIT) fragmentStage = stage;
+        else return {};
+    }
+    if (!vertexStage || !fragmentStage || shaderSet.getAttributeBinding(layerAttribute)) return {};
+
+    Shader vertex{vertexStage->module->source, tokenize(vertexStage->module->source)};
+    Shader fragment{fragmentStage->module->source, tokenize(fragmentStage->module->source)};
+    if (vertex.contains(layerAttribute) || vertex.contains(layerVarying) || fragment.contains(layerVarying)) return {};
+
+    std::set<std::string> converted;
+    std::vector<Edit> vertexEdits, fragmentEdits;
+    for (auto& name : textureNames)
+    {
+        if (!vertex.declares(name) && !fragment.declares(name)) continue;
+
+        std::vector<Edit> nameVertexEdits, nameFragmentEdits;
+        if (vertex.convert(name, layerAttribute, nameVertexEdits) && fragment.convert(name, layerVarying, nameFragmentEdits))
+        {
+            vertexEdits.insert(vertexEdits.end(), nameVertexEdits.begin(), nameVertexEdits.end());
+            fragmentEdits.insert(fragmentEdits.end(), nameFragmentEdits.begin(), nameFragmentEdits.end());
+            converted.insert(name);
+        }
+        else
+        {
+            vsg::debug("vsgXchange::convertToTextureArrays() unable to convert uses of ", name);
+        }
+    }
+    if (converted.empty()) return {};
+
+    size_t vertexDeclarations = vertex.declarationPosition();
+    size_t vertexMain = vertex.mainPosition();
+    size_t fragmentDeclarations = fragment.declarationPosition();
+    if (vertexDeclarations == std::string::npos || vertexMain == std::string::npos || fragmentDeclarations == std::string::npos) return {};
+
+    int attributeLocation = vertex.maxLocation("in");
+    for (auto& binding : shaderSet.attributeBindings) attributeLocation = std::max(attributeLocation, static_cast<int>(binding.location));
+    ++attributeLocation;
+
+    int varyingLocation = std::max(vertex.maxLocation("out"), fragment.maxLocation("in")) + 1;
+
+    vertexEdits.push_back(Edit{vertexDeclarations, 0, vsg::make_string("layout(location = ", attributeLocation, ") in float ", layerAttribute, ";\nlayout(location = ", varyingLocation, ") flat out float ", layerVarying, ";\n\n")});
+    vertexEdits.push_back(Edit{vertexMain, 0, vsg::make_string("\n    ", layerVarying, " = ", layerAttribute, ";")});
+    fragmentEdits.push_back(Edit{fragmentDeclarations, 0, vsg::make_string("layout(location = ", varyingLocation, ") flat in float ", layerVarying, ";\n\n")});
+
+    // the stock ShaderSet stages may be shared between ShaderSets so replace rather than modify them
+    auto replaceStage = [](const vsg::ShaderStage& original, const std::string& source) {
+        auto module = vsg::ShaderModule::create(source, original.module->hints);
+        auto stage = vsg::ShaderStage::create(original.stage, original.entryPointName, module);
+        stage->specializationConstants = original.specializationConstants;
+        return stage;
+    };
+
+    for (auto& stage : shaderSet.stages)
+    {
+        if (stage == vertexStage) stage = replaceStage(*vertexStage, apply(vertex.source, vertexEdits));
+        else stage = replaceStage(*fragmentStage, apply(fragment.source, fragmentEdits));
+    }
+    shaderSet.variants.clear();
+
+    shaderSet.addAttributeBinding(layerAttribute, "", static_cast<uint32_t>(attributeLocation), VK_FORMAT_R32_SFLOAT, vsg::floatValue::create(0.0f));
+
+    return converted;
+}
+
+bool vsgXchange::textureArrayCompatible(const vsg::Data& data)
+{
+    auto& properties = data.properties;
+    if (data.depth() != 1 || data.width() == 0 || data.height() == 0) return false;
+    if (properties.imageViewType >= 0 && properties.imageViewType != VK_IMAGE_VIEW_TYPE_2D) return false;
+    if (properties.maxNumMipmaps > 1 || properties.format == VK_FORMAT_UNDEFINED) return false;
+
+    switch (data.stride())
+    {
+    case 1:
+    case 2:
+    case 3:
+    case 4:
+    case 6:
+    case 8:
+    case 12:
+    case 16: break;
+    default: return false;
+    }
+
+    // the layers are copied with a single memcpy so must be tightly packed
+    return data.dataSize() == static_cast<size_t>(data.width()) * data.height() * data.stride();
+}
+
+vsg::ref_ptr<vsg::Data> vsgXchange::createTextureArray(const std::vector<vsg::ref_ptr<vsg::Data>>& layers)
+{
+    if (layers.empty() || layers.size() > max_texture_array_layers || !layers.front()) return {};
+
+    auto& first = *layers.front();
+    for (auto& layer : layers)
+    {
+        if (!layer || !textureArrayCompatible(*layer)) return {};
+        if (layer->width() != first.width() || layer->height() != first.height() || layer->stride() != first.stride()) return {};
+
+        auto& properties = layer->properties;
+        if (properties.format != first.properties.format || properties.blockWidth != first.properties.blockWidth || properties.blockHeight != first.properties.blockHeight) return {};
+    }
+
+    const size_t layerSize = first.dataSize();
+    auto data = static_cast<uint8_t*>(allocateReadData(layerSize * layers.size()));
+    if (!data) return {};
+
+    for (size_t i = 0; i < layers.size(); ++i)
+    {
+        std::memcpy(data + i * layerSize, layers[i]->dataPointer(), layerSize);
+    }
+
+    auto properties = first.properties;
+    properties.imageViewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    properties.allocatorType = vsg::ALLOCATOR_TYPE_VSG_ALLOCATOR;
+    properties.maxNumMipmaps = 0;
+
+    const uint32_t width = first.width();
+    const uint32_t height = first.height();
+    const auto depth = static_cast<uint32_t>(layers.size());
+    const bool compressed = properties.blockWidth > 1 || properties.blockHeight > 1;
+
+    switch (first.stride())
+    {
+    case 1: return createArray<uint8_t>(width, height, depth, data, properties);
+    case 2: return createArray<vsg::ubvec2>(width, height, depth, data, properties);
+    case 3: return createArray<vsg::ubvec3>(width, height, depth, data, properties);
+    case 4: return createArray<vsg::ubvec4>(width, height, depth, data, properties);
+    case 6: return createArray<vsg::usvec3>(width, height, depth, data, properties);
+    case 8: return compressed ? createArray<vsg::block64>(width, height, depth, data, properties) : createArray<vsg::usvec4>(width, height, depth, data, properties);
+    case 12: return createArray<vsg::vec3>(width, height, depth, data, properties);
+    default: return compressed ? createArray<vsg::block128>(width, height, depth, data, properties) : createArray<vsg::vec4>(width, height, depth, data, properties);
+    }
+}
@@ -0,0 +1,165 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgXchange/archive.h>
+#include <vsgXchange/write_queue.h>
+
+#include <vsg/core/ConstVisitor.h>
+#include <vsg/core/Data.h>
+#include <vsg/io/FileSystem.h>
+#include <vsg/io/Logger.h>
+#include <vsg/io/write.h>
+
+using namespace vsgXchange;
+
+namespace
+{
+    // accumulate the size of the vsg::Data referenced by an object, such as the images in a scene graph, to account for the memory a queued write holds on to.
+    struct CollectDataSize : public vsg::ConstVisitor
+    {
+        size_t size = 0;
+
+        void apply(const vsg::Object& object) override
+        {
+            object.traverse(*this);
+        }
+
+        void apply(const vsg::Data& data) override
+        {
+            size += data.dataSize();
+        }
+    };
+} // namespace
+
+WriteQueue::WriteQueue(uint32_t numThreads, size_t maxPendingBytes, vsg::ref_ptr<const vsg::Options> in_options) :
+    options(in_options),
+    _maxPendingBytes(maxPendingBytes)
+{
+    if (numThreads == 0) numThreads = 1;
+    for (uint32_t i = 0; i < numThreads; ++i)
+    {
+        _threads.emplace_back([this]() { run(); });
+    }
+}
+
+WriteQueue::~WriteQueue()
+{
+    stop();
+}
+
+bool WriteQueue::write(vsg::ref_ptr<vsg::Object> object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> writeOptions)
+{
+    if (!object || !filename) return false;
+
+    Request request{object, filename, writeOptions ? writeOptions : options, 0};
+    CollectDataSize collectDataSize;
+    object->accept(collectDataSize);
+    request.size = collectDataSize.size;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // block until there is room for the request, always accepting a request when nothing is pending so objects larger than the limit can still be written.
+    _requestCompleted.wait(lock, [&]() { return _stopped || _pendingBytes == 0 || (_pendingBytes + request.size) <= _maxPendingBytes; });
+    if (_stopped) return false;
+
+    _pendingBytes += request.size;
+    _requests.push_back(std::move(request));
+    _requestAvailable.notify_one();
+
+    return true;
+}
+
+void WriteQueue::flush()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _requestCompleted.wait(lock, [&]() { return _requests.empty() && _numActive == 0; });
+}
+
+void WriteQueue::stop()
+{
+    std::vector<std::thread> threads;
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        if (_stopped) return;
+
+        _stopped = true;
+        threads.swap(_threads);
+    }
+
+    // worker threads drain any remaining requests before exiting
+    _requestAvailable.notify_all();
+    _requestCompleted.notify_all();
+
+    for (auto& thread : threads)
+    {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+size_t WriteQueue::pending() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _requests.size() + _numActive;
+}
+
+size_t WriteQueue::numFailed() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _numFailed;
+}
+
+void WriteQueue::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        _requestAvailable.wait(lock, [&]() { return _stopped || !_requests.empty(); });
+        if (_requests.empty())
+        {
+            if (_stopped) return;
+            continue;
+        }
+
+        auto request = std::move(_requests.front());
+        _requests.pop_front();
+        ++_numActive;
+
+        lock.unlock();
+
+        bool result = true;
+        if (makeDirectory)
+        {
+            // members of an archive are written within the archive's file, so it's the archive's directory that's required
+            vsg::Path archiveFilename, member;
+            vsg::Path path = vsg::filePath(archive::split(request.filename, archiveFilename, member) ? archiveFilename : request.filename);
+            if (path && !vsg::fileExists(path) && !vsg::makeDirectory(path))
+            {
+                vsg::warn("WriteQueue could not create directory for ", request.filename);
+                result = false;
+            }
+        }
+
+        if (result) result = vsg::write(request.object, request.filename, request.options);
+        if (!result) vsg::warn("WriteQueue failed to write ", request.filename);
+
+        // release the object before signalling completion so the memory is freed by the time a blocked write() resumes
+        request.object = {};
+
+        lock.lock();
+
+        --_numActive;
+        _pendingBytes -= request.size;
+        if (!result) ++_numFailed;
+
+        _requestCompleted.notify_all();
+    }
+}
@@ -0,0 +1,430 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <vsgXchange/archive.h>
+
+#include "../all/mapped_file.h"
+
+#include <vsg/io/FileSystem.h>
+#include <vsg/io/Logger.h>
+#include <vsg/io/VSG.h>
+#include <vsg/io/mem_stream.h>
+#include <vsg/io/read.h>
+
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace vsgXchange;
+
+namespace
+{
+    // the archive starts with the Header, followed by the members' contents, each aligned to DATA_ALIGNMENT,
+    // and ends with the index of numBuckets Buckets, an open addressing hash table using linear probing, followed by the members' names.
+    constexpr char ARCHIVE_MAGIC[8] = {'v', 's', 'g', 'a', 'r', 'c', 'h', 0};
+    constexpr uint32_t ARCHIVE_VERSION = 1;
+    constexpr uint64_t DATA_ALIGNMENT = 16;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version = ARCHIVE_VERSION;
+        uint32_t numBuckets = 0;
+        uint64_t indexOffset = 0;
+        uint64_t numMembers = 0;
+    };
+
+    /// Bucket of the hashed index, unused buckets have a nameLength of 0.
+    struct Bucket
+    {
+        uint64_t hash = 0;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t nameOffset = 0; // relative to the end of the buckets
+        uint32_t nameLength = 0;
+    };
+
+    static_assert(sizeof(Header) == 32 && sizeof(Bucket) == 32, "archive index layout must not be padded");
+
+    /// 64 bit FNV-1a hash of a member's name.
+    uint64_t hashName(const std::string& name)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (auto c : name)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::string lowerCase(std::string str)
+    {
+        for (auto& c : str) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return str;
+    }
+
+    /// return the member's path with forward slashes and any . and .. directories resolved, or an empty string if it refers to outside the archive.
+    std::string normalizeMember(const std::string& member)
+    {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (start <= member.size())
+        {
+            size_t end = member.find_first_of("/\\", start);
+            if (end == std::string::npos) end = member.size();
+
+            auto part = member.substr(start, end - start);
+            if (part == "..")
+            {
+                if (parts.empty()) return {};
+                parts.pop_back();
+            }
+            else if (!part.empty() && part != ".")
+            {
+                parts.push_back(part);
+            }
+            start = end + 1;
+        }
+
+        std::string result;
+        for (auto& part : parts)
+        {
+            if (!result.empty()) result += '/';
+            result += part;
+        }
+        return result;
+    }
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// archive::Reader
+//
+class archive::Reader
+{
+public:
+    explicit Reader(const vsg::Path& filename) :
+        _file(filename)
+    {
+        if (!_file || _file.size() < sizeof(Header)) return;
+
+        auto header = reinterpret_cast<const Header*>(_file.data());
+        if (std::memcmp(header->magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || header->version != ARCHIVE_VERSION) return;
+
+        // an archive that wasn't closed has no index
+        uint32_t numBuckets = header->numBuckets;
+        if (numBuckets == 0 || (numBuckets & (numBuckets - 1)) != 0) return;
+        if (header->indexOffset < sizeof(Header) || header->indexOffset > _file.size() || (_file.size() - header->indexOffset) / sizeof(Bucket) < numBuckets) return;
+
+        _buckets = reinterpret_cast<const Bucket*>(_file.data() + header->indexOffset);
+        _numBuckets = numBuckets;
+        _dataEnd = header->indexOffset;
+        _names = reinterpret_cast<const char*>(_buckets + numBuckets);
+        _namesSize = _file.size() - header->indexOffset - numBuckets * sizeof(Bucket);
+    }
+
+    /// return true if the archive was mapped and has a valid index.
+    bool valid() const { return _buckets != nullptr; }
+
+    /// find the member in the index, assigning the slice of the mapping it occupies.
+    bool find(const std::string& member, const uint8_t*& ptr, size_t& size) const
+    {
+        if (!_buckets || member.empty()) return false;
+
+        uint64_t hash = hashName(member);
+        uint32_t mask = _numBuckets - 1;
+        for (uint32_t i = static_cast<uint32_t>(hash) & mask, probes = 0; probes < _numBuckets; i = (i + 1) & mask, ++probes)
+        {
+            auto& bucket = _buckets[i];
+            if (bucket.nameLength == 0) return false;
+
+            if (bucket.hash == hash && bucket.nameLength == member.size() && static_cast<uint64_t>(bucket.nameOffset) + bucket.nameLength <= _namesSize &&
+                std::memcmp(_names + bucket.nameOffset, member.data(), member.size()) == 0)
+            {
+                if (bucket.offset > _dataEnd || bucket.size > _dataEnd - bucket.offset) return false;
+
+                ptr = _file.data() + bucket.offset;
+                size = static_cast<size_t>(bucket.size);
+                return true;
+            }
+        }
+        return false;
+    }
+
+protected:
+    MappedFile _file;
+    const Bucket* _buckets = nullptr;
+    uint32_t _numBuckets = 0;
+    uint64_t _dataEnd = 0;
+    const char* _names = nullptr;
+    uint64_t _namesSize = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// archive::Writer
+//
+class archive::Writer
+{
+public:
+    explicit Writer(const vsg::Path& filename) :
+        _filename(filename),
+        _fout(filename, std::ios::out | std::ios::binary | std::ios::trunc)
+    {
+        // the header is rewritten with the location of the index once it's been written by close()
+        Header header;
+        std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        _fout.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        _end = sizeof(Header);
+    }
+
+    bool good() const { return _fout.good(); }
+
+    /// append the member's contents, a member that is added again replaces the earlier one in the index.
+    bool add(const std::string& member, const std::string& contents)
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        if (_closed || !_fout) return false;
+
+        pad(DATA_ALIGNMENT);
+        _members[member] = std::make_pair(_end, static_cast<uint64_t>(contents.size()));
+        _fout.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        _end += contents.size();
+        return _fout.good();
+    }
+
+    /// write the index and header, after which no more members can be added.
+    bool close()
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        if (_closed) return _fout.good();
+        _closed = true;
+
+        // keep the index at most half full so probe sequences stay short
+        uint32_t numBuckets = 1;
+        while (numBuckets < _members.size() * 2) numBuckets *= 2;
+
+        std::vector<Bucket> buckets(numBuckets);
+        std::string names;
+        for (auto& [name, entry] : _members)
+        {
+            uint64_t hash = hashName(name);
+            uint32_t i = static_cast<uint32_t>(hash) & (numBuckets - 1);
+            while (buckets[i].nameLength != 0) i = (i + 1) & (numBuckets - 1);
+
+            auto& bucket = buckets[i];
+            bucket.hash = hash;
+            bucket.offset = entry.first;
+            bucket.size = entry.second;
+            bucket.nameOffset = static_cast<uint32_t>(names.size());
+            bucket.nameLength = static_cast<uint32_t>(name.size());
+            names += name;
+        }
+
+        pad(sizeof(Bucket));
+
+        Header header;
+        std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        header.numBuckets = numBuckets;
+        header.indexOffset = _end;
+        header.numMembers = _members.size();
+
+        _fout.write(reinterpret_cast<const char*>(buckets.data()), static_cast<std::streamsize>(buckets.size() * sizeof(Bucket)));
+        _fout.write(names.data(), static_cast<std::streamsize>(names.size()));
+        _fout.seekp(0);
+        _fout.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        _fout.close();
+
+        if (!_fout) vsg::warn("vsgXchange::archive failed to write ", _filename);
+        return _fout.good();
+    }
+
+protected:
+    void pad(uint64_t alignment)
+    {
+        for (; (_end % alignment) != 0; ++_end) _fout.put(0);
+    }
+
+    vsg::Path _filename;
+    std::mutex _mutex;
+    std::ofstream _fout;
+    uint64_t _end = 0;
+    std::map<std::string, std::pair<uint64_t, uint64_t>> _members; // offset, size
+    bool _closed = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// archive
+//
+archive::archive()
+{
+}
+
+archive::~archive()
+{
+    close();
+}
+
+bool archive::split(const vsg::Path& filename, vsg::Path& archiveFilename, vsg::Path& member)
+{
+    auto str = filename.string();
+    auto lower = lowerCase(str);
+
+    const std::string ext(".vsga");
+    for (auto pos = lower.find(ext); pos != std::string::npos; pos = lower.find(ext, pos + ext.size()))
+    {
+        auto end = pos + ext.size();
+        if (end < str.size() && (str[end] == '/' || str[end] == '\\'))
+        {
+            auto normalized = normalizeMember(str.substr(end + 1));
+            if (normalized.empty()) return false;
+
+            archiveFilename = str.substr(0, end);
+            member = normalized;
+            return true;
+        }
+    }
+    return false;
+}
+
+vsg::ref_ptr<vsg::Object> archive::readMember(const vsg::Path& archiveFilename, const vsg::Path& member, vsg::ref_ptr<const vsg::Options> options) const
+{
+    auto foundFilename = vsg::findFile(archiveFilename, options.get());
+    if (!foundFilename) return {};
+
+    std::shared_ptr<Reader> reader;
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+
+        // an archive being written has no index until it's closed
+        if (_writers.count(archiveFilename) != 0 || _writers.count(foundFilename) != 0) return {};
+
+        auto& cached = _readers[foundFilename];
+        if (!cached) cached = std::make_shared<Reader>(foundFilename);
+        reader = cached;
+
+        // don't retain an invalid archive so it's read again once it has been rewritten
+        if (!reader->valid()) _readers.erase(foundFilename);
+    }
+
+    if (!reader->valid())
+    {
+        vsg::warn("vsgXchange::archive could not read the index of ", foundFilename);
+        return {};
+    }
+
+    const uint8_t* ptr = nullptr;
+    size_t size = 0;
+    if (!reader->find(member.string(), ptr, size)) return {};
+
+    auto local_options = options ? vsg::clone(options) : vsg::Options::create();
+    local_options->paths.insert(local_options->paths.begin(), foundFilename / vsg::filePath(member));
+    local_options->extensionHint = vsg::lowerCaseFileExtension(member);
+
+    // the reader holds the mapping, so the slice remains valid until the read completes
+    auto object = vsg::read(ptr, size, local_options);
+    if (!object)
+    {
+        // fallback to istream path for ReaderWriters that don't support reading from memory
+        vsg::mem_stream stream(ptr, size);
+        object = vsg::read(stream, local_options);
+    }
+    return object;
+}
+
+vsg::ref_ptr<vsg::Object> archive::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    vsg::Path archiveFilename, member;
+    if (split(filename, archiveFilename, member)) return readMember(archiveFilename, member, options);
+
+    // filenames relative to a directory within an archive, such as those of the PagedLOD children of a tile read from an archive
+    if (options)
+    {
+        for (auto& path : options->paths)
+        {
+            if (split(path / filename, archiveFilename, member))
+            {
+                if (auto object = readMember(archiveFilename, member, options)) return object;
+            }
+        }
+    }
+    return {};
+}
+
+bool archive::write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    vsg::Path archiveFilename, member;
+    if (!object || !split(filename, archiveFilename, member)) return false;
+
+    auto local_options = options ? vsg::clone(options) : vsg::Options::create();
+    local_options->extensionHint = vsg::lowerCaseFileExtension(member);
+
+    // serialize the member with the ReaderWriters that support its extension, before taking the archive's lock so members are encoded in parallel
+    std::ostringstream contents(std::ios::out | std::ios::binary);
+    bool serialized = false;
+    for (auto itr = local_options->readerWriters.begin(); itr != local_options->readerWriters.end() && !serialized; ++itr)
+    {
+        serialized = (*itr)->write(object, contents, local_options);
+    }
+    if (!serialized)
+    {
+        vsg::VSG io;
+        serialized = io.write(object, contents, local_options);
+    }
+    if (!serialized) return false;
+
+    std::shared_ptr<Writer> writer;
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        auto& cached = _writers[archiveFilename];
+        if (!cached)
+        {
+            cached = std::make_shared<Writer>(archiveFilename);
+            _readers.erase(archiveFilename);
+        }
+        writer = cached;
+    }
+
+    if (!writer->good())
+    {
+        vsg::warn("vsgXchange::archive could not open ", archiveFilename, " for writing.");
+        return false;
+    }
+    return writer->add(member.string(), contents.str());
+}
+
+bool archive::close()
+{
+    std::map<vsg::Path, std::shared_ptr<Writer>> writers;
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        writers.swap(_writers);
+    }
+
+    bool result = true;
+    for (auto& [filename, writer] : writers)
+    {
+        if (!writer->close()) result = false;
+    }
+    return result;
+}
+
+bool archive::getFeatures(Features& features) const
+{
+    features.extensionFeatureMap[".vsga"] = static_cast<vsg::ReaderWriter::FeatureMask>(vsg::ReaderWriter::READ_FILENAME | vsg::ReaderWriter::WRITE_FILENAME);
+    return true;
+}
@@ -0,0 +1,239 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 André Normann & Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include "IOSystem.h"
+#include "../all/mapped_file.h"
+#include "../all/stream_utils.h"
+
+#include <vsg/core/Array.h>
+#include <vsg/io/FileSystem.h>
+#include <vsg/io/Logger.h>
+#include <vsg/io/ReaderWriter.h>
+#include <vsg/io/read.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace vsgXchange;
+
+namespace
+{
+    bool isServerAddress(const std::string& filename)
+    {
+        return filename.compare(0, 7, "http://") == 0 || filename.compare(0, 8, "https://") == 0;
+    }
+
+    /// ReaderWriter that returns the raw contents of the streams and memory blocks it's passed as a vsg::ubyteArray,
+    /// used so that the curl ReaderWriter downloads the files Assimp requests and hands them back without them being parsed.
+    class RawDataReaderWriter : public vsg::Inherit<vsg::ReaderWriter, RawDataReaderWriter>
+    {
+    public:
+        vsg::ref_ptr<vsg::Object> read(std::istream& fin, vsg::ref_ptr<const vsg::Options>) const override
+        {
+            vsgXchange::StreamData input;
+            if (!vsgXchange::readStream(fin, input)) return {};
+            return read(input.data, input.size, {});
+        }
+
+        vsg::ref_ptr<vsg::Object> read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options>) const override
+        {
+            if (!ptr || size == 0) return {};
+
+            auto data = vsg::ubyteArray::create(static_cast<uint32_t>(size));
+            std::memcpy(data->dataPointer(), ptr, size);
+            return data;
+        }
+    };
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// MemoryIOStream
+//
+MemoryIOStream::MemoryIOStream(vsg::ref_ptr<vsg::Data> in_data) :
+    _data(in_data)
+{
+    if (_data)
+    {
+        _buffer = static_cast<const uint8_t*>(_data->dataPointer());
+        _size = _data->dataSize();
+    }
+}
+
+MemoryIOStream::MemoryIOStream(std::shared_ptr<MappedFile> in_mappedFile) :
+    _mappedFile(in_mappedFile)
+{
+    if (_mappedFile)
+    {
+        _buffer = _mappedFile->data();
+        _size = _mappedFile->size();
+    }
+}
+
+size_t MemoryIOStream::Read(void* buffer, size_t size, size_t count)
+{
+    if (!buffer || size == 0 || count == 0) return 0;
+
+    // only return whole elements, matching the semantics of fread()
+    size_t available = (_size - _position) / size;
+    size_t numRead = std::min(count, available);
+    if (numRead > 0)
+    {
+        std::memcpy(buffer, _buffer + _position, numRead * size);
+        _position += numRead * size;
+    }
+    return numRead;
+}
+
+size_t MemoryIOStream::Write(const void*, size_t, size_t)
+{
+    return 0;
+}
+
+aiReturn MemoryIOStream::Seek(size_t offset, aiOrigin origin)
+{
+    size_t position = 0;
+    switch (origin)
+    {
+    case aiOrigin_SET: position = offset; break;
+    case aiOrigin_CUR: position = _position + offset; break;
+    case aiOrigin_END:
+        if (offset > _size) return AI_FAILURE;
+        position = _size - offset;
+        break;
+    default: return AI_FAILURE;
+    }
+
+    if (position > _size) return AI_FAILURE;
+
+    _position = position;
+    return AI_SUCCESS;
+}
+
+size_t MemoryIOStream::Tell() const
+{
+    return _position;
+}
+
+size_t MemoryIOStream::FileSize() const
+{
+    return _size;
+}
+
+void MemoryIOStream::Flush()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// IOSystem
+//
+IOSystem::IOSystem(vsg::ref_ptr<const vsg::Options> in_options) :
+    _options(in_options)
+{
+    if (_options)
+    {
+        // read remote files through the same ReaderWriters, so the curl ReaderWriter and options->fileCache are used, with the RawDataReaderWriter first to return the downloaded data unparsed.
+        _remoteOptions = vsg::clone(_options);
+        _remoteOptions->extensionHint = {};
+        _remoteOptions->readerWriters.insert(_remoteOptions->readerWriters.begin(), RawDataReaderWriter::create());
+    }
+}
+
+IOSystem::Entry IOSystem::read(const std::string& in_filename) const
+{
+    std::string filename(in_filename);
+    std::replace(filename.begin(), filename.end(), '\\', '/');
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    if (auto itr = _entries.find(filename); itr != _entries.end()) return itr->second;
+
+    auto& entry = _entries[filename];
+
+    std::string url;
+    if (isServerAddress(filename))
+    {
+        url = filename;
+    }
+    else if (auto filenameToUse = vsg::findFile(filename, _options))
+    {
+        auto mappedFile = std::make_shared<MappedFile>(filenameToUse);
+        if (*mappedFile) entry.mappedFile = mappedFile;
+        return entry;
+    }
+    else if (_options && !_options->paths.empty() && isServerAddress(_options->paths.front().string()))
+    {
+        // the scene was read from a server so its siblings are relative to the server path the curl ReaderWriter put first in options->paths
+        url = (_options->paths.front() / filename).string();
+    }
+
+    if (url.empty() || !_remoteOptions) return entry;
+
+    // always go through the ReaderWriters so the curl ReaderWriter applies its file cache freshness checks and decompresses .zst cache entries
+    entry.data = vsg::read_cast<vsg::Data>(url, _remoteOptions);
+    if (!entry.data) vsg::debug("vsgXchange::assimp::IOSystem unable to read ", url);
+
+    return entry;
+}
+
+bool IOSystem::Exists(const char* filename) const
+{
+    if (!filename) return false;
+
+    return read(filename).valid();
+}
+
+Assimp::IOStream* IOSystem::Open(const char* filename, const char* mode)
+{
+    if (!filename) return nullptr;
+
+    // only reading is supported
+    if (mode && (std::strchr(mode, 'w') || std::strchr(mode, 'a') || std::strchr(mode, '+'))) return nullptr;
+
+    std::string key(filename);
+    std::replace(key.begin(), key.end(), '\\', '/');
+
+    auto entry = read(key);
+
+    Assimp::IOStream* stream = nullptr;
+    if (entry.data)
+        stream = new MemoryIOStream(entry.data);
+    else if (entry.mappedFile)
+        stream = new MemoryIOStream(entry.mappedFile);
+    else
+        return nullptr;
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+    ++_entries[key].numOpenStreams;
+    _openStreams[stream] = key;
+    return stream;
+}
+
+void IOSystem::Close(Assimp::IOStream* file)
+{
+    {
+        // the stream holds its own reference to the data, so release the entry once the last stream opened on it is closed
+        std::scoped_lock<std::mutex> lock(_mutex);
+        if (auto itr = _openStreams.find(file); itr != _openStreams.end())
+        {
+            if (auto entryItr = _entries.find(itr->second); entryItr != _entries.end() && --entryItr->second.numOpenStreams == 0)
+            {
+                _entries.erase(entryItr);
+            }
+            _openStreams.erase(itr);
+        }
+    }
+
+    delete file;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 André Normann & Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/core/Data.h>
+#include <vsg/io/Options.h>
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace vsgXchange
+{
+    class MappedFile;
+
+    /// read only Assimp::IOStream over a contiguous block of memory, holding either the vsg::Data or MappedFile that the memory belongs to.
+    class MemoryIOStream : public Assimp::IOStream
+    {
+    public:
+        MemoryIOStream(vsg::ref_ptr<vsg::Data> in_data);
+        MemoryIOStream(std::shared_ptr<MappedFile> in_mappedFile);
+
+        size_t Read(void* buffer, size_t size, size_t count) override;
+        size_t Write(const void* buffer, size_t size, size_t count) override;
+        aiReturn Seek(size_t offset, aiOrigin origin) override;
+        size_t Tell() const override;
+        size_t FileSize() const override;
+        void Flush() override;
+
+    protected:
+        vsg::ref_ptr<vsg::Data> _data;
+        std::shared_ptr<MappedFile> _mappedFile;
+        const uint8_t* _buffer = nullptr;
+        size_t _size = 0;
+        size_t _position = 0;
+    };
+
+    /// Assimp::IOSystem that resolves the files an importer reads, such as glTF .bin buffers and OBJ .mtl files, through vsg::findFile() and the vsg::Options::paths,
+    /// memory mapping local files and reading http/https URLs through the vsg::Options::readerWriters, so the curl ReaderWriter's file cache and connection reuse apply.
+    /// A file's data is kept from the Exists() or Open() that reads it until the last IOStream opened on it is closed, so Exists() followed by Open() doesn't download a remote file twice,
+    /// without holding every file the importer reads for the importer's lifetime.
+    class IOSystem : public Assimp::IOSystem
+    {
+    public:
+        explicit IOSystem(vsg::ref_ptr<const vsg::Options> in_options);
+
+        bool Exists(const char* filename) const override;
+        char getOsSeparator() const override { return '/'; }
+        Assimp::IOStream* Open(const char* filename, const char* mode = "rb") override;
+        void Close(Assimp::IOStream* file) override;
+
+    protected:
+        struct Entry
+        {
+            vsg::ref_ptr<vsg::Data> data;
+            std::shared_ptr<MappedFile> mappedFile;
+            uint32_t numOpenStreams = 0;
+            bool valid() const { return data || mappedFile; }
+        };
+
+        Entry read(const std::string& filename) const;
+
+        vsg::ref_ptr<const vsg::Options> _options;
+        vsg::ref_ptr<vsg::Options> _remoteOptions;
+
+        mutable std::mutex _mutex;
+        mutable std::map<std::string, Entry> _entries;
+        std::map<Assimp::IOStream*, std::string> _openStreams;
+    };
+
+} // namespace vsgXchange
@@ -12,6 +12,17 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include "SceneConverter.h"
 
+#include <vsgXchange/cancellation.h>
+#include <vsgXchange/read_memory.h>
+#include <vsgXchange/read_write_observer.h>
+
+#include "../all/color_space.h"
+#include "../all/parallel_for.h"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
 using namespace vsgXchange;
 
 SubgraphStats SceneConverter::collectSubgraphStats(const aiNode* in_node, unsigned int depth)
@@ -374,61 +385,198 @@ SubgraphStats SceneConverter::print(std::ostream& out, const aiScene* in_scene,
     return stats;
 }
 
-SamplerData SceneConverter::convertTexture(const aiMaterial& material, aiTextureType type) const
+vsg::ref_ptr<vsg::Data> SceneConverter::readTexture(const std::string& texPath, const vsg::Path& externalTextureFilename) const
 {
-    aiString texPath;
-    aiTextureMapMode wrapMode[]{aiTextureMapMode_Wrap, aiTextureMapMode_Wrap, aiTextureMapMode_Wrap};
-
-    if (material.GetTexture(type, 0, &texPath, nullptr, nullptr, nullptr, nullptr, wrapMode) == AI_SUCCESS)
+    if (auto texture = scene->GetEmbeddedTexture(texPath.c_str()))
     {
-        SamplerData samplerImage;
-        vsg::Path externalTextureFilename;
+        // embedded texture has no width so must be invalid
+        if (texture->mWidth == 0) return {};
+
+        if (texture->mHeight == 0)
+        {
+            vsg::debug("filename = ", filename, " : Embedded compressed format texture->achFormatHint = ", texture->achFormatHint);
 
-        if (auto texture = scene->GetEmbeddedTexture(texPath.C_Str()))
+            // texture is a compressed format, defer to the VSG's vsg::read() to convert the block of data to vsg::Data image.
+            auto imageOptions = vsg::clone(options);
+            imageOptions->extensionHint = vsg::Path(".") + texture->achFormatHint;
+            return vsg::read_cast<vsg::Data>(reinterpret_cast<const uint8_t*>(texture->pcData), texture->mWidth, imageOptions);
+        }
+        else
         {
-            // embedded texture has no width so must be invalid
-            if (texture->mWidth == 0) return {};
+            vsg::debug("filename = ", filename, " : Embedded raw format texture->achFormatHint = ", texture->achFormatHint);
+
+            // Vulkan doesn't support this format, we have to reorder it to RGBA
+            if (!reserveReadMemory(static_cast<uint64_t>(texture->mWidth) * texture->mHeight * sizeof(vsg::ubvec4))) return {};
 
-            if (texture->mHeight == 0)
+            auto image = vsg::ubvec4Array2D::create(texture->mWidth, texture->mHeight, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
+            auto src = texture->pcData;
+            for (auto& dest_c : *image)
             {
-                vsg::debug("filename = ", filename, " : Embedded compressed format texture->achFormatHint = ", texture->achFormatHint);
+                auto& src_c = *(src++);
+                dest_c.r = src_c.r;
+                dest_c.g = src_c.g;
+                dest_c.b = src_c.b;
+                dest_c.a = src_c.a;
+            }
+            return image;
+        }
+    }
+    else
+    {
+        auto data = vsg::read_cast<vsg::Data>(externalTextureFilename, options);
+        if (!data)
+        {
+            vsg::warn("Failed to load texture: ", externalTextureFilename, " texPath = ", texPath);
+        }
+        return data;
+    }
+}
+
+TextureData SceneConverter::resolveTexture(const std::string& texPath) const
+{
+    TextureData texture;
+    if (!scene->GetEmbeddedTexture(texPath.c_str()))
+    {
+        texture.filename = vsg::findFile(texPath, options);
+    }
+    return texture;
+}
 
-                // texture is a compressed format, defer to the VSG's vsg::read() to convert the block of data to vsg::Data image.
-                auto imageOptions = vsg::clone(options);
-                imageOptions->extensionHint = vsg::Path(".") + texture->achFormatHint;
-                samplerImage.data = vsg::read_cast<vsg::Data>(reinterpret_cast<const uint8_t*>(texture->pcData), texture->mWidth, imageOptions);
+void SceneConverter::readTextures()
+{
+    const aiTextureType types[] = {aiTextureType_DIFFUSE, aiTextureType_EMISSIVE, aiTextureType_LIGHTMAP, aiTextureType_AMBIENT, aiTextureType_NORMALS,
+                                   aiTextureType_METALNESS, aiTextureType_UNKNOWN, aiTextureType_SPECULAR};
 
-                // if no data assigned return null
-                if (!samplerImage.data) return {};
+    // resolve each of the unique texture paths referenced by the materials to an embedded texture or filename
+    textureData.clear();
+    for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
+    {
+        for (auto type : types)
+        {
+            aiString texPath;
+            if (scene->mMaterials[i]->GetTexture(type, 0, &texPath) == AI_SUCCESS && textureData.count(texPath.C_Str()) == 0)
+            {
+                textureData[texPath.C_Str()] = resolveTexture(texPath.C_Str());
             }
-            else
+        }
+    }
+
+    // different texture paths can resolve to the same file, so only read each embedded texture and file once
+    std::vector<TextureData*> sources;
+    std::vector<std::string> sourceTexPaths;
+    std::map<std::string, size_t> sourceIndices;
+    std::vector<std::pair<TextureData*, size_t>> references;
+    for (auto& [texPath, texture] : textureData)
+    {
+        std::string key = texture.filename ? texture.filename.string() : texPath;
+        auto [itr, inserted] = sourceIndices.emplace(key, sources.size());
+        if (inserted)
+        {
+            sources.push_back(&texture);
+            sourceTexPaths.push_back(texPath);
+        }
+        else
+        {
+            references.emplace_back(&texture, itr->second);
+        }
+    }
+
+    // external textures can be deferred, assigning a placeholder that DeferredTexture::load() later replaces
+    std::vector<size_t> sourcesToRead;
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        if (deferTextures && sources[i]->filename)
+        {
+            auto placeholder = vsg::ubvec4Array2D::create(1, 1, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
+            placeholder->set(0, 0, vsg::ubvec4(255, 255, 255, 255));
+
+            // the filename keeps the placeholders of different textures distinct when descriptors are shared
+            placeholder->setValue("filename", sources[i]->filename.string());
+
+            auto deferredTexture = DeferredTexture::create();
+            deferredTexture->filename = sources[i]->filename;
+            deferredTexture->options = options;
+            deferredTexture->placeholder = placeholder;
+            deferredTextures[placeholder.get()] = deferredTexture;
+
+            sources[i]->data = placeholder;
+        }
+        else
+        {
+            sourcesToRead.push_back(i);
+        }
+    }
+
+    parallel_for(sourcesToRead.size(), numThreads, [&](size_t i) {
+        auto source = sourcesToRead[i];
+        sources[source]->data = readTexture(sourceTexPaths[source], sources[source]->filename);
+    });
+
+    for (auto& [texture, index] : references)
+    {
+        texture->data = sources[index]->data;
+    }
+}
+
+void SceneConverter::collectDeferredTextures()
+{
+    // find the ImageInfo that reference the placeholders so DeferredTexture::load() can replace their images
+    std::vector<vsg::DescriptorConfigurator*> materials;
+    for (auto& material : convertedMaterials) materials.push_back(material.get());
+    for (auto& [mesh, material] : jointPaletteMaterials) materials.push_back(material.get());
+
+    for (auto material : materials)
+    {
+        for (auto& ds : material->descriptorSets)
+        {
+            if (!ds) continue;
+            for (auto& descriptor : ds->descriptors)
             {
-                vsg::debug("filename = ", filename, " : Embedded raw format texture->achFormatHint = ", texture->achFormatHint);
+                auto descriptorImage = descriptor.cast<vsg::DescriptorImage>();
+                if (!descriptorImage) continue;
 
-                // Vulkan doesn't support this format, we have to reorder it to RGBA
-                auto image = vsg::ubvec4Array2D::create(texture->mWidth, texture->mHeight, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
-                auto src = texture->pcData;
-                for (auto& dest_c : *image)
+                for (auto& imageInfo : descriptorImage->imageInfoList)
                 {
-                    auto& src_c = *(src++);
-                    dest_c.r = src_c.r;
-                    dest_c.g = src_c.g;
-                    dest_c.b = src_c.b;
-                    dest_c.a = src_c.a;
+                    if (!imageInfo || !imageInfo->imageView || !imageInfo->imageView->image) continue;
+                    if (auto itr = deferredTextures.find(imageInfo->imageView->image->data.get()); itr != deferredTextures.end())
+                    {
+                        auto& imageInfos = itr->second->imageInfos;
+                        if (std::find(imageInfos.begin(), imageInfos.end(), imageInfo) == imageInfos.end()) imageInfos.push_back(imageInfo);
+                    }
                 }
-                samplerImage.data = image;
             }
         }
+    }
+}
+
+SamplerData SceneConverter::convertTexture(const aiMaterial& material, aiTextureType type) const
+{
+    aiString texPath;
+    aiTextureMapMode wrapMode[]{aiTextureMapMode_Wrap, aiTextureMapMode_Wrap, aiTextureMapMode_Wrap};
+
+    if (material.GetTexture(type, 0, &texPath, nullptr, nullptr, nullptr, nullptr, wrapMode) == AI_SUCCESS)
+    {
+        SamplerData samplerImage;
+
+        // use the texture resolved and read by readTextures() if available
+        TextureData texture;
+        if (auto itr = textureData.find(texPath.C_Str()); itr != textureData.end())
+        {
+            texture = itr->second;
+        }
         else
         {
-            externalTextureFilename = vsg::findFile(texPath.C_Str(), options);
-            if (samplerImage.data = vsg::read_cast<vsg::Data>(externalTextureFilename, options); !samplerImage.data.valid())
-            {
-                vsg::warn("Failed to load texture: ", externalTextureFilename, " texPath = ", texPath.C_Str());
-                return {};
-            }
+            texture = resolveTexture(texPath.C_Str());
+            texture.data = readTexture(texPath.C_Str(), texture.filename);
         }
 
+        samplerImage.data = texture.data;
+        vsg::Path externalTextureFilename = texture.filename;
+
+        if (!samplerImage.data) return {};
+
+        bool deferred = deferredTextures.count(samplerImage.data.get()) != 0;
+
         samplerImage.sampler = vsg::Sampler::create();
         samplerImage.sampler->addressModeU = getWrapMode(wrapMode[0]);
         samplerImage.sampler->addressModeV = getWrapMode(wrapMode[1]);
@@ -437,7 +585,12 @@ SamplerData SceneConverter::convertTexture(const aiMaterial& material, aiTexture
         samplerImage.sampler->maxAnisotropy = 16.0f;
         samplerImage.sampler->maxLod = samplerImage.data->properties.maxNumMipmaps;
 
-        if (samplerImage.sampler->maxLod <= 1.0)
+        if (deferred)
+        {
+            // the texture's dimensions aren't known until it's loaded so don't limit the mipmap levels
+            samplerImage.sampler->maxLod = VK_LOD_CLAMP_NONE;
+        }
+        else if (samplerImage.sampler->maxLod <= 1.0)
         {
             // Calculate maximum lod level
             auto maxDim = std::max(samplerImage.data->width(), samplerImage.data->height());
@@ -446,11 +599,12 @@ SamplerData SceneConverter::convertTexture(const aiMaterial& material, aiTexture
 
         if (sharedObjects)
         {
-            sharedObjects->share(samplerImage.data);
+            // placeholders must remain the objects recorded in deferredTextures
+            if (!deferred) sharedObjects->share(samplerImage.data);
             sharedObjects->share(samplerImage.sampler);
         }
 
-        if (externalTextures && externalObjects)
+        if (externalTextures && externalObjects && !deferred)
         {
             // calculate the texture filename
             switch (externalTextureFormat)
@@ -492,7 +646,7 @@ SamplerData SceneConverter::convertTexture(const aiMaterial& material, aiTexture
     }
 }
 
-void SceneConverter::convert(const aiMaterial* material, vsg::DescriptorConfigurator& convertedMaterial)
+void SceneConverter::convert(const aiMaterial* material, vsg::DescriptorConfigurator& convertedMaterial, vsg::ref_ptr<vsg::Data> jointMatrices)
 {
     auto& defines = convertedMaterial.defines;
 
@@ -674,7 +828,7 @@ void SceneConverter::convert(const aiMaterial* material, vsg::DescriptorConfigur
     {
         // useful reference for GLTF animation support
         // https://github.com/KhronosGroup/glTF/blob/main/specification/2.0/figures/gltfOverview-2.0.0d.png
-        convertedMaterial.assignDescriptor("jointMatrices", jointSampler->jointMatrices);
+        convertedMaterial.assignDescriptor("jointMatrices", jointMatrices ? jointMatrices : jointSampler->jointMatrices);
     }
 
     if (sharedObjects)
@@ -690,217 +844,743 @@ void SceneConverter::convert(const aiMaterial* material, vsg::DescriptorConfigur
     }
 }
 
-vsg::ref_ptr<vsg::Data> SceneConverter::createIndices(const aiMesh* mesh, unsigned int numIndicesPerFace, uint32_t numIndices)
+namespace
 {
-    if (mesh->mNumVertices > 16384)
+    struct MaterialDescriptors
     {
-        auto indices = vsg::uintArray::create(numIndices);
-        auto itr = indices->begin();
-        for (unsigned int j = 0; j < mesh->mNumFaces; ++j)
+        std::vector<std::pair<std::string, SamplerData>> textures;
+        std::vector<std::pair<std::string, vsg::ref_ptr<vsg::Data>>> buffers;
+    };
+
+    // collect the textures and uniforms assigned to a material, returns false if it has other descriptors that a texture array material couldn't replicate.
+    bool getMaterialDescriptors(const vsg::DescriptorConfigurator& material, MaterialDescriptors& descriptors)
+    {
+        auto& bindings = material.shaderSet->descriptorBindings;
+        for (size_t set = 0; set < material.descriptorSets.size(); ++set)
         {
-            const auto& face = mesh->mFaces[j];
-            if (face.mNumIndices == numIndicesPerFace)
+            auto& ds = material.descriptorSets[set];
+            if (!ds) continue;
+
+            for (auto& descriptor : ds->descriptors)
             {
-                for (unsigned int i = 0; i < numIndicesPerFace; ++i) (*itr++) = static_cast<uint32_t>(face.mIndices[i]);
+                auto binding = std::find_if(bindings.begin(), bindings.end(), [&](const vsg::DescriptorBinding& db) { return db.set == set && db.binding == descriptor->dstBinding; });
+                if (binding == bindings.end()) return false;
+
+                if (auto descriptorImage = descriptor.cast<vsg::DescriptorImage>())
+                {
+                    if (descriptorImage->imageInfoList.size() != 1) return false;
+
+                    auto& imageInfo = descriptorImage->imageInfoList.front();
+                    if (!imageInfo || !imageInfo->imageView || !imageInfo->imageView->image || !imageInfo->imageView->image->data) return false;
+
+                    SamplerData texture;
+                    texture.sampler = imageInfo->sampler;
+                    texture.data = imageInfo->imageView->image->data;
+                    descriptors.textures.emplace_back(binding->name, texture);
+                }
+                else if (auto descriptorBuffer = descriptor.cast<vsg::DescriptorBuffer>())
+                {
+                    if (descriptorBuffer->bufferInfoList.size() != 1 || !descriptorBuffer->bufferInfoList.front() || !descriptorBuffer->bufferInfoList.front()->data) return false;
+                    descriptors.buffers.emplace_back(binding->name, descriptorBuffer->bufferInfoList.front()->data);
+                }
+                else
+                {
+                    return false;
+                }
             }
         }
-        return indices;
+
+        std::sort(descriptors.textures.begin(), descriptors.textures.end(), [](auto& lhs, auto& rhs) { return lhs.first < rhs.first; });
+        std::sort(descriptors.buffers.begin(), descriptors.buffers.end(), [](auto& lhs, auto& rhs) { return lhs.first < rhs.first; });
+        return true;
+    }
+} // namespace
+
+const SceneConverter::TextureArrayShaderSet& SceneConverter::getOrCreateTextureArrayShaderSet(const vsg::ShaderSet& shaderSet)
+{
+    if (auto itr = textureArrayShaderSets.find(&shaderSet); itr != textureArrayShaderSets.end()) return itr->second;
+
+    // convert a copy as the ShaderSet may be shared with other models, such as one assigned to Options::shaderSets
+    auto copy = vsg::ShaderSet::create();
+    copy->stages = shaderSet.stages;
+    copy->attributeBindings = shaderSet.attributeBindings;
+    copy->descriptorBindings = shaderSet.descriptorBindings;
+    copy->pushConstantRanges = shaderSet.pushConstantRanges;
+    copy->definesArrayStates = shaderSet.definesArrayStates;
+    copy->optionalDefines = shaderSet.optionalDefines;
+    copy->defaultGraphicsPipelineStates = shaderSet.defaultGraphicsPipelineStates;
+    copy->customDescriptorSetBindings = shaderSet.customDescriptorSetBindings;
+    copy->defaultShaderHints = shaderSet.defaultShaderHints;
+
+    std::set<std::string> textureNames;
+    for (auto& binding : shaderSet.descriptorBindings)
+    {
+        if (binding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) textureNames.insert(binding.name);
+    }
+
+    auto& textureArrayShaderSet = textureArrayShaderSets[&shaderSet];
+    textureArrayShaderSet.textureNames = convertToTextureArrays(*copy, textureNames);
+    if (!textureArrayShaderSet.textureNames.empty())
+    {
+        textureArrayShaderSet.shaderSet = copy;
+        if (sharedObjects) sharedObjects->share(textureArrayShaderSet.shaderSet);
     }
     else
     {
-        auto indices = vsg::ushortArray::create(numIndices);
-        auto itr = indices->begin();
-        for (unsigned int j = 0; j < mesh->mNumFaces; ++j)
-        {
-            const auto& face = mesh->mFaces[j];
-            if (face.mNumIndices == numIndicesPerFace)
-            {
-                for (unsigned int i = 0; i < numIndicesPerFace; ++i) (*itr++) = static_cast<uint16_t>(face.mIndices[i]);
-            }
-        }
-        return indices;
+        vsg::info("vsgXchange::assimp unable to convert ShaderSet to texture arrays, materials left with individual textures.");
     }
+    return textureArrayShaderSet;
 }
 
-void SceneConverter::convert(const aiMesh* mesh, vsg::ref_ptr<vsg::Node>& node)
+void SceneConverter::consolidateTextureArrays()
 {
-    if (convertedMaterials.size() <= mesh->mMaterialIndex)
-    {
-        vsg::warn("Warning:  mesh (", mesh, ") mesh->mMaterialIndex = ", mesh->mMaterialIndex, " exceeds available materials.size()= ", convertedMaterials.size());
-        return;
-    }
+    textureLayers.assign(convertedMaterials.size(), -1.0f);
 
-    if (mesh->mNumVertices == 0 || mesh->mVertices == nullptr)
+    // skinned materials are copied for each joint palette, and external and deferred textures aren't resident to be copied into arrays
+    if (!textureArrays || jointSampler || externalTextures || !deferredTextures.empty()) return;
+
+    // materials can share a texture array when everything but the images of their textures match
+    using TextureKey = std::tuple<std::string, const vsg::Sampler*, uint32_t, uint32_t, VkFormat>;
+    using MaterialKey = std::tuple<const vsg::ShaderSet*, bool, bool, std::set<std::string>, std::vector<std::pair<std::string, std::vector<uint8_t>>>, std::vector<TextureKey>>;
+
+    std::vector<MaterialDescriptors> materialDescriptors(convertedMaterials.size());
+    std::map<MaterialKey, std::vector<size_t>> groups;
+    for (size_t i = 0; i < convertedMaterials.size(); ++i)
     {
-        vsg::warn("Warning:  mesh (", mesh, ") no vertices data, mesh->mNumVertices = ", mesh->mNumVertices, " mesh->mVertices = ", mesh->mVertices);
-        return;
+        auto& material = *convertedMaterials[i];
+        auto& descriptors = materialDescriptors[i];
+        if (!material.shaderSet || !getMaterialDescriptors(material, descriptors) || descriptors.textures.empty()) continue;
+
+        auto& textureArrayShaderSet = getOrCreateTextureArrayShaderSet(*material.shaderSet);
+        if (!textureArrayShaderSet.shaderSet) continue;
+
+        MaterialKey key{material.shaderSet.get(), material.blending, material.two_sided, material.defines, {}, {}};
+
+        bool compatible = true;
+        for (auto& [name, texture] : descriptors.textures)
+        {
+            compatible = compatible && textureArrayShaderSet.textureNames.count(name) > 0 && textureArrayCompatible(*texture.data);
+            std::get<5>(key).emplace_back(name, texture.sampler.get(), texture.data->width(), texture.data->height(), texture.data->properties.format);
+        }
+        if (!compatible) continue;
+
+        for (auto& [name, data] : descriptors.buffers)
+        {
+            auto ptr = static_cast<const uint8_t*>(data->dataPointer());
+            std::get<4>(key).emplace_back(name, std::vector<uint8_t>(ptr, ptr + data->dataSize()));
+        }
+
+        groups[key].push_back(i);
     }
 
-    if (mesh->mNumFaces == 0 || mesh->mFaces == nullptr)
+    size_t numConsolidated = 0;
+    for (auto& [key, members] : groups)
     {
-        vsg::warn("Warning:  mesh (", mesh, ") no mesh data, mesh->mNumFaces = ", mesh->mNumFaces);
-        return;
+        if (members.size() < 2) continue;
+
+        auto& first = *convertedMaterials[members.front()];
+        auto& firstDescriptors = materialDescriptors[members.front()];
+        auto textureArrayShaderSet = getOrCreateTextureArrayShaderSet(*first.shaderSet).shaderSet;
+
+        // materials with the same images share a layer, a further material is created for each max_texture_array_layers
+        for (size_t start = 0; start < members.size();)
+        {
+            std::map<std::vector<const vsg::Data*>, uint32_t> layerIndices;
+            std::vector<std::vector<vsg::ref_ptr<vsg::Data>>> layers(firstDescriptors.textures.size());
+            std::vector<std::pair<size_t, uint32_t>> materialLayers;
+
+            for (; start < members.size(); ++start)
+            {
+                auto& textures = materialDescriptors[members[start]].textures;
+
+                std::vector<const vsg::Data*> images;
+                for (auto& [name, texture] : textures) images.push_back(texture.data.get());
+
+                auto itr = layerIndices.find(images);
+                if (itr == layerIndices.end())
+                {
+                    if (layerIndices.size() == max_texture_array_layers) break;
+
+                    itr = layerIndices.emplace(images, static_cast<uint32_t>(layerIndices.size())).first;
+                    for (size_t t = 0; t < textures.size(); ++t) layers[t].push_back(textures[t].second.data);
+                }
+                materialLayers.emplace_back(members[start], itr->second);
+            }
+            if (materialLayers.size() < 2) continue;
+
+            auto material = vsg::DescriptorConfigurator::create(textureArrayShaderSet);
+            material->defines = first.defines;
+            material->blending = first.blending;
+            material->two_sided = first.two_sided;
+
+            bool assigned = true;
+            for (size_t t = 0; assigned && t < layers.size(); ++t)
+            {
+                auto& [name, texture] = firstDescriptors.textures[t];
+                auto textureArray = createTextureArray(layers[t]);
+                assigned = textureArray && material->assignTexture(name, textureArray, texture.sampler);
+            }
+            for (auto& [name, data] : firstDescriptors.buffers)
+            {
+                assigned = assigned && material->assignDescriptor(name, data);
+            }
+            if (!assigned) continue;
+
+            if (sharedObjects)
+            {
+                for (auto& ds : material->descriptorSets)
+                {
+                    if (ds)
+                    {
+                        sharedObjects->share(ds->descriptors);
+                        sharedObjects->share(ds);
+                    }
+                }
+            }
+
+            for (auto& [index, layer] : materialLayers)
+            {
+                convertedMaterials[index] = material;
+                textureLayers[index] = static_cast<float>(layer);
+            }
+            numConsolidated += materialLayers.size();
+        }
     }
 
-    std::string name = mesh->mName.C_Str();
-    auto material = convertedMaterials[mesh->mMaterialIndex];
+    vsg::debug("SceneConverter::consolidateTextureArrays() ", numConsolidated, " of ", convertedMaterials.size(), " materials share texture arrays");
+}
 
-    // count the number of indices of each type
-    uint32_t numTriangleIndices = 0;
-    uint32_t numLineIndices = 0;
-    uint32_t numPointIndices = 0;
+vsg::ref_ptr<vsg::Data> SceneConverter::createIndices(const aiMesh* mesh, VkPrimitiveTopology& topology)
+{
+    // gather the point, line and triangle indices, and the largest index of each, in a single pass over the faces
+    std::vector<uint32_t> primitiveIndices[3];
+    uint32_t maxIndices[3] = {0, 0, 0};
+    primitiveIndices[2].reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
     for (unsigned int j = 0; j < mesh->mNumFaces; ++j)
     {
         const auto& face = mesh->mFaces[j];
-        if (face.mNumIndices == 3)
-            numTriangleIndices += 3;
-        else if (face.mNumIndices == 2)
-            numLineIndices += 2;
-        else if (face.mNumIndices == 1)
-            numPointIndices += 1;
-        else
+        if (face.mNumIndices < 1 || face.mNumIndices > 3)
         {
             vsg::warn("Warning: unsupported number of indices on face ", face.mNumIndices);
+            continue;
+        }
+
+        auto& indices = primitiveIndices[face.mNumIndices - 1];
+        auto& maxIndex = maxIndices[face.mNumIndices - 1];
+        for (unsigned int i = 0; i < face.mNumIndices; ++i)
+        {
+            indices.push_back(face.mIndices[i]);
+            maxIndex = std::max(maxIndex, face.mIndices[i]);
         }
     }
 
+    auto& pointIndices = primitiveIndices[0];
+    auto& lineIndices = primitiveIndices[1];
+    auto& triangleIndices = primitiveIndices[2];
+
     int numPrimitiveTypes = 0;
-    if (numTriangleIndices > 0) ++numPrimitiveTypes;
-    if (numLineIndices > 0) ++numPrimitiveTypes;
-    if (numPointIndices > 0) ++numPrimitiveTypes;
+    if (!triangleIndices.empty()) ++numPrimitiveTypes;
+    if (!lineIndices.empty()) ++numPrimitiveTypes;
+    if (!pointIndices.empty()) ++numPrimitiveTypes;
 
     if (numPrimitiveTypes > 1)
     {
-        vsg::warn("Warning: more than one primitive type required, numTriangleIndices = ", numTriangleIndices, ", numLineIndices = ", numLineIndices, ", numPointIndices = ", numPointIndices);
+        vsg::warn("Warning: more than one primitive type required, numTriangleIndices = ", triangleIndices.size(), ", numLineIndices = ", lineIndices.size(), ", numPointIndices = ", pointIndices.size());
     }
 
-    unsigned int numIndicesPerFace = 0;
-    uint32_t numIndices = 0;
-    VkPrimitiveTopology topology{};
-    if (numTriangleIndices > 0)
+    int type = 0;
+    if (!triangleIndices.empty())
     {
         topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        numIndicesPerFace = 3;
-        numIndices = numTriangleIndices;
+        type = 2;
     }
-    else if (numLineIndices > 0)
+    else if (!lineIndices.empty())
     {
         topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
-        numIndicesPerFace = 2;
-        numIndices = numLineIndices;
+        type = 1;
     }
-    else if (numPointIndices > 0)
+    else if (!pointIndices.empty())
     {
         topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
-        numIndicesPerFace = 1;
-        numIndices = numPointIndices;
+        type = 0;
     }
     else
     {
         vsg::warn("Warning: no primitive indices ");
-        return;
+        return {};
     }
 
-    auto config = vsg::GraphicsPipelineConfigurator::create(material->shaderSet);
-    config->descriptorConfigurator = material;
-    if (options) config->assignInheritedState(options->inheritedState);
+    auto& indices = primitiveIndices[type];
+    auto copyIndices = [&indices](auto array) -> vsg::ref_ptr<vsg::Data> {
+        using value_type = typename std::decay_t<decltype(*array)>::value_type;
+        auto itr = array->begin();
+        for (auto index : indices) (*itr++) = static_cast<value_type>(index);
+        return array;
+    };
+
+    // use the narrowest index type that can represent the largest index, leaving the all ones value that's reserved for primitive restart unused
+    uint32_t numIndices = static_cast<uint32_t>(indices.size());
+    uint32_t maxIndex = maxIndices[type];
+    uint64_t indexSize = (uint8Indices && maxIndex < 0xff) ? 1 : ((maxIndex < 0xffff) ? 2 : 4);
+    if (!reserveReadMemory(numIndices * indexSize)) return {};
+
+    if (uint8Indices && maxIndex < 0xff)
+        return copyIndices(vsg::ubyteArray::create(numIndices));
+    else if (maxIndex < 0xffff)
+        return copyIndices(vsg::ushortArray::create(numIndices));
+    else
+        return copyIndices(vsg::uintArray::create(numIndices));
+}
+
+namespace
+{
+    /// convert a float to IEEE 754 half float, rounding to nearest and clamping out of range values to infinity.
+    uint16_t float_to_half(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
 
-    auto indices = createIndices(mesh, numIndicesPerFace, numIndices);
+        uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+        uint32_t mantissa = bits & 0x7fffff;
 
-    vsg::DataList vertexArrays;
-    auto vertices = vsg::vec3Array::create(mesh->mNumVertices);
-    std::memcpy(vertices->dataPointer(), mesh->mVertices, mesh->mNumVertices * 12);
-    config->assignArray(vertexArrays, "vsg_Vertex", VK_VERTEX_INPUT_RATE_VERTEX, vertices);
+        if (((bits >> 23) & 0xff) == 0xff) return sign | 0x7c00 | (mantissa ? 0x200 : 0); // inf or NaN
+        if (exponent >= 31) return sign | 0x7c00;                                           // overflow
+        if (exponent <= 0)
+        {
+            if (exponent < -10) return sign; // underflow
+            mantissa |= 0x800000;
+            uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            if ((mantissa >> (shift - 1)) & 1) ++half;
+            return sign | static_cast<uint16_t>(half);
+        }
 
-    if (mesh->mNormals)
+        uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        if (mantissa & 0x1000) ++half; // round, carrying into the exponent if required
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    template<typename T>
+    T quantize_snorm(float value)
     {
-        auto normals = vsg::vec3Array::create(mesh->mNumVertices);
-        std::memcpy(normals->dataPointer(), mesh->mNormals, mesh->mNumVertices * 12);
-        config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_VERTEX, normals);
+        constexpr float maxValue = static_cast<float>(std::numeric_limits<T>::max());
+        return static_cast<T>(std::round(std::clamp(value, -1.0f, 1.0f) * maxValue));
     }
-    else
+
+    template<typename T>
+    T quantize_unorm(float value)
     {
-        auto normal = vsg::vec3Value::create(vsg::vec3(0.0f, 0.0f, 1.0f));
-        config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_INSTANCE, normal);
+        constexpr float maxValue = static_cast<float>(std::numeric_limits<T>::max());
+        return static_cast<T>(std::round(std::clamp(value, 0.0f, 1.0f) * maxValue));
     }
 
-    if (mesh->mTextureCoords[0])
+    vsg::dmat4 toMatrix(aiMatrix4x4 m)
     {
-        auto dest_texcoords = vsg::vec2Array::create(mesh->mNumVertices);
-        auto src_texcoords = mesh->mTextureCoords[0];
-        for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+        m.Transpose();
+        return vsg::dmat4(vsg::mat4((float*)&m));
+    }
+
+    vsg::dbox transformBounds(const vsg::dmat4& matrix, const vsg::dbox& bounds)
+    {
+        vsg::dbox transformed;
+        if (!bounds.valid()) return transformed;
+
+        for (int i = 0; i < 8; ++i)
         {
-            auto& tc = src_texcoords[i];
-            dest_texcoords->at(i).set(tc[0], tc[1]);
+            vsg::dvec3 corner((i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? bounds.max.y : bounds.min.y, (i & 4) ? bounds.max.z : bounds.min.z);
+            transformed.add(matrix * corner);
         }
-        config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_VERTEX, dest_texcoords);
+        return transformed;
     }
-    else
+
+    vsg::dsphere toSphere(const vsg::dbox& bounds)
     {
-        auto texcoord = vsg::vec2Value::create(vsg::vec2(0.0f, 0.0f));
-        config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_INSTANCE, texcoord);
+        return vsg::dsphere((bounds.min + bounds.max) * 0.5, vsg::length(bounds.max - bounds.min) * 0.5);
     }
 
+    using BoundedNodes = std::vector<std::pair<vsg::ref_ptr<vsg::Node>, vsg::dbox>>;
 
-    vsg::AttributeBinding& colorBinding = config->shaderSet->getAttributeBinding("vsg_Color");
-    targetVertexColorSpace = colorBinding.coordinateSpace;
-
-    if (mesh->mColors[0])
+    /// recursively split the nodes at the median of their centers along the longest axis, creating a binary hierarchy of CullGroup with up to maxLeafChildren nodes in each leaf.
+    vsg::ref_ptr<vsg::Node> createCullHierarchy(BoundedNodes& nodes, size_t begin, size_t end, size_t maxLeafChildren)
     {
-        auto colors = vsg::vec4Array::create(mesh->mNumVertices);
-        std::memcpy(colors->dataPointer(), mesh->mColors[0], mesh->mNumVertices * 16);
-        vsg::convert(colors->size(), &(colors->at(0)), sourceVertexColorSpace, targetVertexColorSpace);
-        config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_VERTEX, colors);
+        vsg::dbox bounds;
+        vsg::dbox centers;
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto& nodeBounds = nodes[i].second;
+            bounds.add(nodeBounds.min);
+            bounds.add(nodeBounds.max);
+            centers.add((nodeBounds.min + nodeBounds.max) * 0.5);
+        }
 
-        vsg::debug("vsg::convert(", colors, ", ", sourceVertexColorSpace, ", ", targetVertexColorSpace, ")");
-    }
-    else
-    {
-        auto colors = vsg::vec4Value::create(vsg::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-        vsg::convert(colors->value(), sourceVertexColorSpace, targetVertexColorSpace);
-        config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_INSTANCE, colors);
+        auto cullGroup = vsg::CullGroup::create();
+        cullGroup->bound = toSphere(bounds);
 
-        vsg::debug("vsg::convert(", colors, ", ", sourceVertexColorSpace, ", ", targetVertexColorSpace, ")");
+        if (end - begin <= maxLeafChildren)
+        {
+            for (size_t i = begin; i < end; ++i) cullGroup->addChild(nodes[i].first);
+            return cullGroup;
+        }
+
+        auto extents = centers.max - centers.min;
+        int axis = (extents.x >= extents.y && extents.x >= extents.z) ? 0 : ((extents.y >= extents.z) ? 1 : 2);
+
+        size_t mid = begin + (end - begin) / 2;
+        std::nth_element(nodes.begin() + begin, nodes.begin() + mid, nodes.begin() + end, [axis](const BoundedNodes::value_type& lhs, const BoundedNodes::value_type& rhs) {
+            return (lhs.second.min[axis] + lhs.second.max[axis]) < (rhs.second.min[axis] + rhs.second.max[axis]);
+        });
+
+        cullGroup->addChild(createCullHierarchy(nodes, begin, mid, maxLeafChildren));
+        cullGroup->addChild(createCullHierarchy(nodes, mid, end, maxLeafChildren));
+        return cullGroup;
     }
 
-    if (mesh->HasBones() && jointSampler)
+    /// decompose a matrix into the translation, rotation and scale used by the instance arrays, returns false if the matrix isn't an unmirrored TRS transform.
+    bool decomposeInstance(const vsg::dmat4& matrix, vsg::dvec3& translation, vsg::dquat& rotation, vsg::dvec3& scale)
     {
-        // useful reference for GLTF animation support
-        // https://github.com/KhronosGroup/glTF/blob/main/specification/2.0/figures/gltfOverview-2.0.0d.png
+        if (vsg::determinant(matrix) <= 0.0) return false;
+        if (!vsg::decompose(matrix, translation, rotation, scale)) return false;
 
-        // now done as part of the aiMaterial/DescriptorConfigurator setup.
-        // config->assignDescriptor("jointMatrices", jointSampler->jointMatrices);
+        auto composed = vsg::translate(translation) * vsg::rotate(rotation) * vsg::scale(scale);
+        double maxValue = 1.0;
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r) maxValue = std::max(maxValue, std::abs(matrix[c][r]));
 
-        auto jointIndices = vsg::ivec4Array::create(mesh->mNumVertices, vsg::ivec4(0, 0, 0, 0));
-        auto jointWeights = vsg::vec4Array::create(mesh->mNumVertices, vsg::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r)
+                if (std::abs(composed[c][r] - matrix[c][r]) > maxValue * 1e-5) return false;
 
-        auto objects = vsg::Objects::create();
-        objects->addChild(jointIndices);
-        objects->addChild(jointWeights);
+        return true;
+    }
 
-        std::vector<uint32_t> weightCounts(mesh->mNumVertices, 0);
+    template<typename T>
+    bool equalArrays(const T* lhs, const T* rhs, unsigned int size)
+    {
+        if (lhs == rhs) return true;
+        if (!lhs || !rhs) return false;
+        return std::memcmp(lhs, rhs, size * sizeof(T)) == 0;
+    }
 
-        config->assignArray(vertexArrays, "vsg_JointIndices", VK_VERTEX_INPUT_RATE_VERTEX, jointIndices);
-        config->assignArray(vertexArrays, "vsg_JointWeights", VK_VERTEX_INPUT_RATE_VERTEX, jointWeights);
+    /// hash of the vertices, used to find candidate meshes with identical geometry before the full comparison by identicalMeshes().
+    uint64_t meshHash(const aiMesh* mesh)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto add = [&hash](const void* ptr, size_t size) {
+            auto bytes = static_cast<const uint8_t*>(ptr);
+            for (size_t i = 0; i < size; ++i) hash = (hash ^ bytes[i]) * 1099511628211ull;
+        };
+        add(&mesh->mMaterialIndex, sizeof(mesh->mMaterialIndex));
+        add(&mesh->mNumVertices, sizeof(mesh->mNumVertices));
+        add(&mesh->mNumFaces, sizeof(mesh->mNumFaces));
+        add(mesh->mVertices, mesh->mNumVertices * sizeof(aiVector3D));
+        return hash;
+    }
 
-        // vsg::info("\nProcessing bones");
-        // vsg::info("mesh->mNumBones = ", mesh->mNumBones);
-        // vsg::info("mesh->mNumVertices = ", mesh->mNumVertices);
+    bool identicalMeshes(const aiMesh* lhs, const aiMesh* rhs)
+    {
+        if (lhs->mMaterialIndex != rhs->mMaterialIndex || lhs->mNumVertices != rhs->mNumVertices || lhs->mNumFaces != rhs->mNumFaces) return false;
+        if (lhs->mPrimitiveTypes != rhs->mPrimitiveTypes) return false;
 
-        bool normalizeWeights = false;
+        auto numVertices = lhs->mNumVertices;
+        if (!equalArrays(lhs->mVertices, rhs->mVertices, numVertices) ||
+            !equalArrays(lhs->mNormals, rhs->mNormals, numVertices) ||
+            !equalArrays(lhs->mTextureCoords[0], rhs->mTextureCoords[0], numVertices) ||
+            !equalArrays(lhs->mColors[0], rhs->mColors[0], numVertices)) return false;
 
-        for (size_t i = 0; i < mesh->mNumBones; ++i)
+        for (unsigned int i = 0; i < lhs->mNumFaces; ++i)
         {
-            aiBone* bone = mesh->mBones[i];
+            auto& lhs_face = lhs->mFaces[i];
+            auto& rhs_face = rhs->mFaces[i];
+            if (lhs_face.mNumIndices != rhs_face.mNumIndices || !equalArrays(lhs_face.mIndices, rhs_face.mIndices, lhs_face.mNumIndices)) return false;
+        }
+        return true;
+    }
 
-            aiMatrix4x4 m = bone->mOffsetMatrix;
-            m.Transpose();
+    /// vsg::ComputeBounds only handles float vertex arrays and doesn't account for instance arrays, so extend it to dequantize the snorm16 positions
+    /// created by the quantize_vertices option and use the bounds of the CullNode that decorate the instanced meshes.
+    struct ComputeSceneBounds : public vsg::ComputeBounds
+    {
+        using vsg::ComputeBounds::apply;
 
-            jointSampler->offsetMatrices[i] = vsg::dmat4(vsg::mat4((float*)&m));
+        void apply(const vsg::CullNode& cullNode) override
+        {
+            auto& bound = cullNode.bound;
+            for (int i = 0; i < 8; ++i)
+            {
+                vsg::dvec3 corner(bound.center.x + ((i & 1) ? bound.radius : -bound.radius),
+                                  bound.center.y + ((i & 2) ? bound.radius : -bound.radius),
+                                  bound.center.z + ((i & 4) ? bound.radius : -bound.radius));
+                if (matrixStack.empty())
+                    bounds.add(corner);
+                else
+                    bounds.add(matrixStack.back() * corner);
+            }
+        }
+
+        void apply(const vsg::svec4Array& vertices) override
+        {
+            const double scale = 1.0 / 32767.0;
+            for (auto& v : vertices)
+            {
+                vsg::dvec3 vertex(v.x * scale, v.y * scale, v.z * scale);
+                if (matrixStack.empty())
+                    bounds.add(vertex);
+                else
+                    bounds.add(matrixStack.back() * vertex);
+            }
+        }
+    };
+} // namespace
+
+void SceneConverter::convert(const aiMesh* mesh, vsg::ref_ptr<vsg::Node>& node, const std::vector<vsg::dmat4>* instanceMatrices, vsg::dbox* meshBounds)
+{
+    if (convertedMaterials.size() <= mesh->mMaterialIndex)
+    {
+        vsg::warn("Warning:  mesh (", mesh, ") mesh->mMaterialIndex = ", mesh->mMaterialIndex, " exceeds available materials.size()= ", convertedMaterials.size());
+        return;
+    }
+
+    if (mesh->mNumVertices == 0 || mesh->mVertices == nullptr)
+    {
+        vsg::warn("Warning:  mesh (", mesh, ") no vertices data, mesh->mNumVertices = ", mesh->mNumVertices, " mesh->mVertices = ", mesh->mVertices);
+        return;
+    }
+
+    if (mesh->mNumFaces == 0 || mesh->mFaces == nullptr)
+    {
+        vsg::warn("Warning:  mesh (", mesh, ") no mesh data, mesh->mNumFaces = ", mesh->mNumFaces);
+        return;
+    }
+
+    std::string name = mesh->mName.C_Str();
+    auto material = convertedMaterials[mesh->mMaterialIndex];
+
+    // meshes with a joint palette have their own copy of the material with the palette's joint matrices, and index the palette with their own bone indices
+    bool jointPalette = false;
+    if (auto itr = jointPaletteMaterials.find(mesh); itr != jointPaletteMaterials.end())
+    {
+        material = itr->second;
+        jointPalette = true;
+    }
+
+    VkPrimitiveTopology topology{};
+    auto indices = createIndices(mesh, topology);
+    if (!indices) return;
+
+    auto config = vsg::GraphicsPipelineConfigurator::create(material->shaderSet);
+    config->descriptorConfigurator = material;
+    if (options) config->assignInheritedState(options->inheritedState);
+
+    vsg::box bounds;
+    for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+    {
+        auto& v = mesh->mVertices[i];
+        bounds.add(v.x, v.y, v.z);
+    }
+
+    // skinned meshes are transformed by the joint matrices before the model view matrix so can't be dequantized by a MatrixTransform.
+    bool skinned = mesh->HasBones() && jointSampler;
+
+    // the instance arrays are applied in the vertex shader before the model view matrix so instanced positions can't be dequantized by a MatrixTransform either,
+    // and the per instance fallback values need an entry for each instance.
+    uint32_t instanceCount = instanceMatrices ? static_cast<uint32_t>(instanceMatrices->size()) : 1;
+
+    // reserve the per vertex arrays against the read's read_memory_budget before creating them, the unpacked colours and joints used while packing are transient
+    bool quantizePositions = quantizeVertices && !skinned && !instanceMatrices;
+    uint64_t vertexSize = quantizePositions ? sizeof(vsg::svec4) : sizeof(vsg::vec3);
+    if (mesh->mNormals) vertexSize += quantizeVertices ? sizeof(vsg::bvec4) : sizeof(vsg::vec3);
+    if (mesh->mTextureCoords[0]) vertexSize += quantizeVertices ? sizeof(vsg::usvec2) : sizeof(vsg::vec2);
+    if (mesh->mColors[0]) vertexSize += quantizeVertices ? sizeof(vsg::ubvec4) : sizeof(vsg::vec4);
+    if (skinned) vertexSize += packJoints ? (sizeof(vsg::svec4) + sizeof(vsg::ubvec4)) : (sizeof(vsg::ivec4) + sizeof(vsg::vec4));
+    if (!reserveReadMemory(static_cast<uint64_t>(mesh->mNumVertices) * vertexSize)) return;
+
+    vsg::DataList vertexArrays;
+    vsg::ref_ptr<vsg::MatrixTransform> dequantize;
+    if (quantizePositions)
+    {
+        // use the same scale on all axes so the normals don't need to be corrected.
+        vsg::vec3 center = (bounds.min + bounds.max) * 0.5f;
+        vsg::vec3 halfExtents = (bounds.max - bounds.min) * 0.5f;
+        float scale = std::max(std::max(halfExtents.x, halfExtents.y), halfExtents.z);
+        float inverseScale = (scale > 0.0f) ? (1.0f / scale) : 1.0f;
+
+        auto vertices = vsg::svec4Array::create(mesh->mNumVertices, vsg::Data::Properties{VK_FORMAT_R16G16B16A16_SNORM});
+        for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+        {
+            auto& v = mesh->mVertices[i];
+            vertices->at(i).set(quantize_snorm<int16_t>((v.x - center.x) * inverseScale),
+                                quantize_snorm<int16_t>((v.y - center.y) * inverseScale),
+                                quantize_snorm<int16_t>((v.z - center.z) * inverseScale),
+                                0);
+        }
+        config->assignArray(vertexArrays, "vsg_Vertex", VK_VERTEX_INPUT_RATE_VERTEX, vertices);
+
+        double dequantizeScale = (scale > 0.0f) ? scale : 1.0;
+        dequantize = vsg::MatrixTransform::create(vsg::translate(vsg::dvec3(center)) * vsg::scale(dequantizeScale, dequantizeScale, dequantizeScale));
+        dequantize->subgraphRequiresLocalFrustum = false;
+    }
+    else
+    {
+        auto vertices = vsg::vec3Array::create(mesh->mNumVertices);
+        std::memcpy(vertices->dataPointer(), mesh->mVertices, mesh->mNumVertices * 12);
+        config->assignArray(vertexArrays, "vsg_Vertex", VK_VERTEX_INPUT_RATE_VERTEX, vertices);
+    }
+
+    if (mesh->mNormals && quantizeVertices)
+    {
+        auto normals = vsg::bvec4Array::create(mesh->mNumVertices, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_SNORM});
+        for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+        {
+            auto& n = mesh->mNormals[i];
+            normals->at(i).set(quantize_snorm<int8_t>(n.x), quantize_snorm<int8_t>(n.y), quantize_snorm<int8_t>(n.z), 0);
+        }
+        config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_VERTEX, normals);
+    }
+    else if (mesh->mNormals)
+    {
+        auto normals = vsg::vec3Array::create(mesh->mNumVertices);
+        std::memcpy(normals->dataPointer(), mesh->mNormals, mesh->mNumVertices * 12);
+        config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_VERTEX, normals);
+    }
+    else
+    {
+        vsg::ref_ptr<vsg::Data> normal;
+        if (instanceCount > 1)
+            normal = vsg::vec3Array::create(instanceCount, vsg::vec3(0.0f, 0.0f, 1.0f));
+        else
+            normal = vsg::vec3Value::create(vsg::vec3(0.0f, 0.0f, 1.0f));
+        config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_INSTANCE, normal);
+    }
+
+    if (mesh->mTextureCoords[0] && quantizeVertices)
+    {
+        auto src_texcoords = mesh->mTextureCoords[0];
+        bool unitRange = true;
+        for (unsigned int i = 0; i < mesh->mNumVertices && unitRange; ++i)
+        {
+            auto& tc = src_texcoords[i];
+            unitRange = tc[0] >= 0.0f && tc[0] <= 1.0f && tc[1] >= 0.0f && tc[1] <= 1.0f;
+        }
+
+        // unorm16 has the better precision but can only be used when no texcoords are outside the 0 to 1 range, typically for repeating textures, otherwise fallback to half floats
+        auto dest_texcoords = vsg::usvec2Array::create(mesh->mNumVertices, vsg::Data::Properties{unitRange ? VK_FORMAT_R16G16_UNORM : VK_FORMAT_R16G16_SFLOAT});
+        for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+        {
+            auto& tc = src_texcoords[i];
+            if (unitRange)
+                dest_texcoords->at(i).set(quantize_unorm<uint16_t>(tc[0]), quantize_unorm<uint16_t>(tc[1]));
+            else
+                dest_texcoords->at(i).set(float_to_half(tc[0]), float_to_half(tc[1]));
+        }
+        config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_VERTEX, dest_texcoords);
+    }
+    else if (mesh->mTextureCoords[0])
+    {
+        auto dest_texcoords = vsg::vec2Array::create(mesh->mNumVertices);
+        auto src_texcoords = mesh->mTextureCoords[0];
+        for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+        {
+            auto& tc = src_texcoords[i];
+            dest_texcoords->at(i).set(tc[0], tc[1]);
+        }
+        config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_VERTEX, dest_texcoords);
+    }
+    else
+    {
+        vsg::ref_ptr<vsg::Data> texcoord;
+        if (instanceCount > 1)
+            texcoord = vsg::vec2Array::create(instanceCount, vsg::vec2(0.0f, 0.0f));
+        else
+            texcoord = vsg::vec2Value::create(vsg::vec2(0.0f, 0.0f));
+        config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_INSTANCE, texcoord);
+    }
+
+
+    vsg::AttributeBinding& colorBinding = config->shaderSet->getAttributeBinding("vsg_Color");
+    auto targetVertexColorSpace = colorBinding.coordinateSpace;
+
+    if (mesh->mColors[0])
+    {
+        auto colors = vsg::vec4Array::create(mesh->mNumVertices);
+        std::memcpy(colors->dataPointer(), mesh->mColors[0], mesh->mNumVertices * 16);
+        convertColors(colors->size(), colors->data(), sourceVertexColorSpace, targetVertexColorSpace);
+
+        if (quantizeVertices)
+        {
+            auto packed_colors = vsg::ubvec4Array::create(mesh->mNumVertices, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
+            for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+            {
+                auto& c = colors->at(i);
+                packed_colors->at(i).set(quantize_unorm<uint8_t>(c.r), quantize_unorm<uint8_t>(c.g), quantize_unorm<uint8_t>(c.b), quantize_unorm<uint8_t>(c.a));
+            }
+            config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_VERTEX, packed_colors);
+        }
+        else
+        {
+            config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_VERTEX, colors);
+        }
+
+        vsg::debug("vsgXchange::convertColors(", colors, ", ", sourceVertexColorSpace, ", ", targetVertexColorSpace, ")");
+    }
+    else
+    {
+        vsg::vec4 color(1.0f, 1.0f, 1.0f, 1.0f);
+        vsg::convert(color, sourceVertexColorSpace, targetVertexColorSpace);
+
+        vsg::ref_ptr<vsg::Data> colors;
+        if (instanceCount > 1)
+            colors = vsg::vec4Array::create(instanceCount, color);
+        else
+            colors = vsg::vec4Value::create(color);
+        config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_INSTANCE, colors);
+
+        vsg::debug("vsg::convert(", colors, ", ", sourceVertexColorSpace, ", ", targetVertexColorSpace, ")");
+    }
+
+    // materials consolidated into texture arrays select their layer of the arrays with a per instance attribute
+    if (float textureLayer = textureLayers.empty() ? -1.0f : textureLayers[mesh->mMaterialIndex]; textureLayer >= 0.0f)
+    {
+        vsg::ref_ptr<vsg::Data> layers;
+        if (instanceCount > 1)
+            layers = vsg::floatArray::create(instanceCount, textureLayer);
+        else
+            layers = vsg::floatValue::create(textureLayer);
+        config->assignArray(vertexArrays, texture_layer_attribute, VK_VERTEX_INPUT_RATE_INSTANCE, layers);
+    }
+
+    if (skinned)
+    {
+        // useful reference for GLTF animation support
+        // https://github.com/KhronosGroup/glTF/blob/main/specification/2.0/figures/gltfOverview-2.0.0d.png
+
+        // now done as part of the aiMaterial/DescriptorConfigurator setup.
+        // config->assignDescriptor("jointMatrices", jointSampler->jointMatrices);
+
+        auto jointIndices = vsg::ivec4Array::create(mesh->mNumVertices, vsg::ivec4(0, 0, 0, 0));
+        auto jointWeights = vsg::vec4Array::create(mesh->mNumVertices, vsg::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+
+        auto objects = vsg::Objects::create();
+        objects->addChild(jointIndices);
+        objects->addChild(jointWeights);
+
+        std::vector<uint32_t> weightCounts(mesh->mNumVertices, 0);
+
+        // vsg::info("\nProcessing bones");
+        // vsg::info("mesh->mNumBones = ", mesh->mNumBones);
+        // vsg::info("mesh->mNumVertices = ", mesh->mNumVertices);
+
+        bool normalizeWeights = false;
+
+        for (size_t i = 0; i < mesh->mNumBones; ++i)
+        {
+            aiBone* bone = mesh->mBones[i];
 
             // vsg::info("    bone[", i, "], bone->mName = ", bone->mName.C_Str());
 
-            unsigned int boneIndex = bones[bone].index;
+            // bones are all collected by collectSubgraphStats(), so look up rather than insert as meshes are converted in parallel
+            auto bone_itr = bones.find(bone);
+            unsigned int boneIndex = jointPalette ? static_cast<unsigned int>(i) : ((bone_itr != bones.end()) ? bone_itr->second.index : 0);
 
             //! The number of vertices affected by this bone.
             //! The maximum value for this member is #AI_MAX_BONE_WEIGHTS.
@@ -952,15 +1632,115 @@ void SceneConverter::convert(const aiMesh* mesh, vsg::ref_ptr<vsg::Node>& node)
                 }
             }
         }
+
+        if (packJoints)
+        {
+            // the SINT formats are used so the joint indices still map to the ivec4 vsg_JointIndices shader input
+            int maxJointIndex = 0;
+            for (auto& jointIndex : *jointIndices)
+            {
+                maxJointIndex = std::max(maxJointIndex, std::max(std::max(jointIndex[0], jointIndex[1]), std::max(jointIndex[2], jointIndex[3])));
+            }
+
+            vsg::ref_ptr<vsg::Data> packed_jointIndices;
+            if (maxJointIndex <= std::numeric_limits<int8_t>::max())
+            {
+                auto packed = vsg::bvec4Array::create(mesh->mNumVertices, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_SINT});
+                for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+                {
+                    auto& ji = jointIndices->at(i);
+                    packed->at(i).set(static_cast<int8_t>(ji[0]), static_cast<int8_t>(ji[1]), static_cast<int8_t>(ji[2]), static_cast<int8_t>(ji[3]));
+                }
+                packed_jointIndices = packed;
+            }
+            else
+            {
+                auto packed = vsg::svec4Array::create(mesh->mNumVertices, vsg::Data::Properties{VK_FORMAT_R16G16B16A16_SINT});
+                for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+                {
+                    auto& ji = jointIndices->at(i);
+                    packed->at(i).set(static_cast<int16_t>(ji[0]), static_cast<int16_t>(ji[1]), static_cast<int16_t>(ji[2]), static_cast<int16_t>(ji[3]));
+                }
+                packed_jointIndices = packed;
+            }
+
+            // distribute the rounding error onto the largest weight so the weights still sum to 1.0
+            auto packed_jointWeights = vsg::ubvec4Array::create(mesh->mNumVertices, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
+            for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+            {
+                auto& weights = jointWeights->at(i);
+                auto& packed = packed_jointWeights->at(i);
+                int total = 0;
+                unsigned int maxWeightIndex = 0;
+                for (unsigned int wi = 0; wi < 4; ++wi)
+                {
+                    packed[wi] = quantize_unorm<uint8_t>(weights[wi]);
+                    total += packed[wi];
+                    if (packed[wi] > packed[maxWeightIndex]) maxWeightIndex = wi;
+                }
+                if (total != 0) packed[maxWeightIndex] = static_cast<uint8_t>(std::clamp(packed[maxWeightIndex] + 255 - total, 0, 255));
+            }
+
+            config->assignArray(vertexArrays, "vsg_JointIndices", VK_VERTEX_INPUT_RATE_VERTEX, packed_jointIndices);
+            config->assignArray(vertexArrays, "vsg_JointWeights", VK_VERTEX_INPUT_RATE_VERTEX, packed_jointWeights);
+        }
+        else
+        {
+            config->assignArray(vertexArrays, "vsg_JointIndices", VK_VERTEX_INPUT_RATE_VERTEX, jointIndices);
+            config->assignArray(vertexArrays, "vsg_JointWeights", VK_VERTEX_INPUT_RATE_VERTEX, jointWeights);
+        }
+    }
+
+    vsg::dsphere instancesBound;
+    if (instanceMatrices)
+    {
+        auto translations = vsg::vec3Array::create(instanceCount);
+        auto rotations = vsg::quatArray::create(instanceCount);
+        auto scales = vsg::vec3Array::create(instanceCount);
+        bool identityRotations = true;
+        bool identityScales = true;
+
+        vsg::dbox instancesBox;
+        for (uint32_t i = 0; i < instanceCount; ++i)
+        {
+            auto& matrix = (*instanceMatrices)[i];
+
+            // collectMeshInstances() only selects matrices that can be decomposed
+            vsg::dvec3 translation, scale;
+            vsg::dquat rotation;
+            decomposeInstance(matrix, translation, rotation, scale);
+
+            translations->at(i) = vsg::vec3(translation);
+            rotations->at(i) = vsg::quat(rotation);
+            scales->at(i) = vsg::vec3(scale);
+            auto& q = rotations->at(i);
+            if (q.x != 0.0f || q.y != 0.0f || q.z != 0.0f) identityRotations = false;
+            if (scales->at(i) != vsg::vec3(1.0f, 1.0f, 1.0f)) identityScales = false;
+
+            for (int c = 0; c < 8; ++c)
+            {
+                vsg::dvec3 corner((c & 1) ? bounds.max.x : bounds.min.x, (c & 2) ? bounds.max.y : bounds.min.y, (c & 4) ? bounds.max.z : bounds.min.z);
+                instancesBox.add(matrix * corner);
+            }
+        }
+
+        instancesBound = vsg::dsphere((instancesBox.min + instancesBox.max) * 0.5, vsg::length(instancesBox.max - instancesBox.min) * 0.5);
+
+        config->assignArray(vertexArrays, "vsg_Translation", VK_VERTEX_INPUT_RATE_INSTANCE, translations);
+        if (!identityRotations) config->assignArray(vertexArrays, "vsg_Rotation", VK_VERTEX_INPUT_RATE_INSTANCE, rotations);
+        if (!identityScales) config->assignArray(vertexArrays, "vsg_Scale", VK_VERTEX_INPUT_RATE_INSTANCE, scales);
     }
 
     auto vid = vsg::VertexIndexDraw::create();
     vid->assignArrays(vertexArrays);
     vid->assignIndices(indices);
     vid->indexCount = static_cast<uint32_t>(indices->valueCount());
-    vid->instanceCount = 1;
+    vid->instanceCount = instanceCount;
     if (!name.empty()) vid->setValue("name", name);
 
+    // OptimizeMeshes can't distinguish per instance arrays that happen to have the same size as the vertex arrays
+    if (meshOptimizer && (instanceCount == 1 || instanceCount != mesh->mNumVertices)) meshOptimizer->optimize(*vid, topology);
+
     if (mesh->mNumAnimMeshes != 0)
     {
         vid->setValue("animationMeshes", mesh->mNumAnimMeshes);
@@ -986,24 +1766,32 @@ void SceneConverter::convert(const aiMesh* mesh, vsg::ref_ptr<vsg::Node>& node)
     } sps(topology, material->blending, material->two_sided);
     config->accept(sps);
 
-    if (sharedObjects)
-        sharedObjects->share(config, [](auto gpc) { gpc->init(); });
-    else
-        config->init();
-
     // create StateGroup as the root of the scene/command graph to hold the GraphicsPipeline, and binding of Descriptors to decorate the whole graph
     auto stateGroup = vsg::StateGroup::create();
 
-    config->copyTo(stateGroup, sharedObjects);
+    // the pipeline is bound once all the meshes are converted, so the unique configurations can be initialized concurrently
+    pipelineConfigurations.assign(config, stateGroup);
 
-    stateGroup->addChild(vid);
+    vsg::ref_ptr<vsg::Node> draw = vid;
+    if (lodGenerator)
+    {
+        if (auto lod = lodGenerator->createLOD(*vid, topology)) draw = lod;
+    }
+
+    if (dequantize)
+    {
+        dequantize->addChild(draw);
+        stateGroup->addChild(dequantize);
+    }
+    else
+    {
+        stateGroup->addChild(draw);
+    }
 
     if (material->blending)
     {
-        vsg::ComputeBounds computeBounds;
-        vid->accept(computeBounds);
-        vsg::dvec3 center = (computeBounds.bounds.min + computeBounds.bounds.max) * 0.5;
-        double radius = vsg::length(computeBounds.bounds.max - computeBounds.bounds.min) * 0.5;
+        vsg::dvec3 center((bounds.min + bounds.max) * 0.5f);
+        double radius = vsg::length(bounds.max - bounds.min) * 0.5f;
 
         auto depthSorted = vsg::DepthSorted::create();
         depthSorted->binNumber = 10;
@@ -1012,10 +1800,122 @@ void SceneConverter::convert(const aiMesh* mesh, vsg::ref_ptr<vsg::Node>& node)
 
         node = depthSorted;
     }
+    else if (instanceMatrices && culling)
+    {
+        node = vsg::CullNode::create(instancesBound, stateGroup);
+    }
     else
     {
         node = stateGroup;
     }
+
+    // skinned and morphed meshes are deformed when animated so have no fixed bounds
+    if (meshBounds && !skinned && mesh->mNumAnimMeshes == 0)
+    {
+        *meshBounds = vsg::dbox(vsg::dvec3(bounds.min), vsg::dvec3(bounds.max));
+    }
+}
+
+void SceneConverter::collectMeshInstances(const aiNode* node, const vsg::dmat4& parentMatrix, bool staticTransforms, const std::vector<unsigned int>& uniqueMeshes,
+                                          std::map<unsigned int, std::vector<std::pair<const aiNode*, vsg::dmat4>>>& meshReferences) const
+{
+    std::string name = node->mName.C_Str();
+    if (boneTransforms.count(node) != 0 || (!name.empty() && animationTransforms.count(name) != 0)) staticTransforms = false;
+
+    auto matrix = parentMatrix * toMatrix(node->mTransformation);
+    if (staticTransforms)
+    {
+        for (unsigned int i = 0; i < node->mNumMeshes; ++i)
+        {
+            auto mesh_index = node->mMeshes[i];
+            if (mesh_index < uniqueMeshes.size()) meshReferences[uniqueMeshes[mesh_index]].emplace_back(node, matrix);
+        }
+    }
+
+    for (unsigned int i = 0; i < node->mNumChildren; ++i)
+    {
+        collectMeshInstances(node->mChildren[i], matrix, staticTransforms, uniqueMeshes, meshReferences);
+    }
+}
+
+vsg::Group::Children SceneConverter::collectMeshInstances()
+{
+    meshInstances.clear();
+    instancedMeshReferences.clear();
+
+    // map each mesh to the first mesh with identical geometry and material
+    std::vector<unsigned int> uniqueMeshes(scene->mNumMeshes);
+    std::multimap<uint64_t, unsigned int> meshHashes;
+    for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+    {
+        auto mesh = scene->mMeshes[i];
+        uniqueMeshes[i] = i;
+        if (mesh->HasBones() || mesh->mNumAnimMeshes != 0) continue;
+
+        auto hash = meshHash(mesh);
+        auto range = meshHashes.equal_range(hash);
+        for (auto itr = range.first; itr != range.second; ++itr)
+        {
+            if (identicalMeshes(scene->mMeshes[itr->second], mesh))
+            {
+                uniqueMeshes[i] = itr->second;
+                break;
+            }
+        }
+        if (uniqueMeshes[i] == i) meshHashes.emplace(hash, i);
+    }
+
+    std::map<unsigned int, std::vector<std::pair<const aiNode*, vsg::dmat4>>> meshReferences;
+    collectMeshInstances(scene->mRootNode, vsg::dmat4(), true, uniqueMeshes, meshReferences);
+
+    for (auto& [mesh_index, references] : meshReferences)
+    {
+        auto mesh = scene->mMeshes[mesh_index];
+        if (mesh->HasBones() || mesh->mNumAnimMeshes != 0 || mesh->mMaterialIndex >= convertedMaterials.size()) continue;
+
+        // depth sorted blended meshes are left as individual draws, as is any ShaderSet without the instance arrays
+        auto& material = convertedMaterials[mesh->mMaterialIndex];
+        if (material->blending || !material->shaderSet || !material->shaderSet->getAttributeBinding("vsg_Translation")) continue;
+
+        std::vector<vsg::dmat4> matrices;
+        std::vector<const aiNode*> nodes;
+        for (auto& [node, matrix] : references)
+        {
+            vsg::dvec3 translation, scale;
+            vsg::dquat rotation;
+            if (decomposeInstance(matrix, translation, rotation, scale))
+            {
+                matrices.push_back(matrix);
+                nodes.push_back(node);
+            }
+        }
+        if (matrices.size() < 2) continue;
+
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            auto node = nodes[i];
+            for (unsigned int mi = 0; mi < node->mNumMeshes; ++mi)
+            {
+                if (uniqueMeshes[node->mMeshes[mi]] == mesh_index) instancedMeshReferences.emplace(node, node->mMeshes[mi]);
+            }
+        }
+        meshInstances[mesh_index] = std::move(matrices);
+    }
+
+    std::vector<unsigned int> instancedMeshes;
+    for (auto& entry : meshInstances) instancedMeshes.push_back(entry.first);
+
+    vsg::Group::Children children(instancedMeshes.size());
+    parallel_for(instancedMeshes.size(), numThreads, [&](size_t i) {
+        auto mesh_index = instancedMeshes[i];
+        convert(scene->mMeshes[mesh_index], children[i], &meshInstances[mesh_index]);
+    });
+
+    children.erase(std::remove(children.begin(), children.end(), vsg::ref_ptr<vsg::Node>()), children.end());
+
+    vsg::debug("SceneConverter::collectMeshInstances() ", instancedMeshReferences.size(), " mesh references replaced by ", children.size(), " instanced meshes");
+
+    return children;
 }
 
 vsg::ref_ptr<vsg::Node> SceneConverter::visit(const aiScene* in_scene, vsg::ref_ptr<const vsg::Options> in_options, const vsg::Path& ext)
@@ -1027,6 +1927,26 @@ vsg::ref_ptr<vsg::Node> SceneConverter::visit(const aiScene* in_scene, vsg::ref_
     externalTextures = vsg::value<bool>(false, assimp::external_textures, options);
     externalTextureFormat = vsg::value<TextureFormat>(TextureFormat::native, assimp::external_texture_format, options);
     culling = vsg::value<bool>(true, assimp::culling, options);
+    numThreads = vsg::value<uint32_t>(std::thread::hardware_concurrency(), assimp::num_threads, options);
+    deferTextures = vsg::value<bool>(false, assimp::deferred_textures, options);
+    uint8Indices = vsg::value<bool>(false, assimp::uint8_indices, options);
+    meshOptimizer = vsg::value<bool>(false, assimp::optimize_meshes, options) ? OptimizeMeshes::create() : vsg::ref_ptr<OptimizeMeshes>();
+    quantizeVertices = vsg::value<bool>(false, assimp::quantize_vertices, options);
+    instanceMeshes = vsg::value<bool>(false, assimp::instance_meshes, options);
+    packJoints = quantizeVertices || vsg::value<bool>(false, assimp::pack_joints, options);
+    maxJoints = vsg::value<uint32_t>(0, assimp::max_joints, options);
+    cullHierarchy = vsg::value<bool>(false, assimp::cull_hierarchy, options);
+    textureArrays = vsg::value<bool>(false, assimp::texture_arrays, options);
+    animationTolerance = vsg::value<double>(0.0, assimp::animation_tolerance, options);
+    animationSampleRate = vsg::value<double>(0.0, assimp::animation_sample_rate, options);
+    if (auto lodLevels = vsg::value<uint32_t>(0, assimp::lod_levels, options); lodLevels > 0)
+    {
+        lodGenerator = GenerateLODs::create();
+        lodGenerator->numLevels = lodLevels;
+        lodGenerator->errorThreshold = vsg::value<float>(lodGenerator->errorThreshold, assimp::lod_error, options);
+    }
+    deferredTextures.clear();
+    pipelineConfigurations.clear();
     topEmptyTransform = {};
 
     if (ext == ".gltf" || ext == ".glb")
@@ -1064,30 +1984,105 @@ vsg::ref_ptr<vsg::Node> SceneConverter::visit(const aiScene* in_scene, vsg::ref_
         jointSampler->jointMatrices = vsg::mat4Array::create(sceneStats.numBones);
         jointSampler->jointMatrices->properties.dataVariance = vsg::DYNAMIC_DATA;
         jointSampler->offsetMatrices.resize(sceneStats.numBones);
+
+        for (auto& [bone, boneStats] : bones)
+        {
+            aiMatrix4x4 m = bone->mOffsetMatrix;
+            m.Transpose();
+
+            jointSampler->offsetMatrices[boneStats.index] = vsg::dmat4(vsg::mat4((float*)&m));
+        }
     }
 
+    // time each phase of the conversion when the read is observed, i.e. by vsgconv --stats
+    vsgXchange::ReadWritePhaseTimer phaseTimer("assimp animations");
     processAnimations();
     processCameras();
     processLights();
 
-    // convert the materials
+    // read the textures in parallel, then convert the materials that use them
+    phaseTimer.next("assimp textures");
+    readTextures();
+
+    // abandon the conversion once the read is cancelled, such as a tile the DatabasePager no longer needs
+    auto cancellation = vsgXchange::getCancellationToken(options.get());
+    if (cancellation && cancellation->cancelled()) return {};
+
+    phaseTimer.next("assimp materials");
     convertedMaterials.resize(scene->mNumMaterials);
     for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
     {
         convertedMaterials[i] = vsg::DescriptorConfigurator::create();
         convert(scene->mMaterials[i], *convertedMaterials[i]);
     }
+    consolidateTextureArrays();
+
+    jointPaletteMaterials.clear();
+    jointPaletteSamplers.clear();
+    if (jointSampler && maxJoints > 0) createJointPalettes();
 
-    // convert the meshes
+    if (!deferredTextures.empty()) collectDeferredTextures();
+
+    // convert the meshes in parallel, each mesh only reads the converted materials and writes its own convertedMeshes entry,
+    // the node graph that references them is then assembled serially by visit(aiNode*)
+    phaseTimer.next("assimp meshes");
+    convertedMeshes.clear();
     convertedMeshes.resize(scene->mNumMeshes);
-    for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
-    {
-        convert(scene->mMeshes[i], convertedMeshes[i]);
-    }
+    convertedMeshBounds.clear();
+    convertedMeshBounds.resize(scene->mNumMeshes);
+    parallel_for(scene->mNumMeshes, numThreads, [&](size_t i) {
+        if (cancellation && cancellation->cancelled()) return;
+        convert(scene->mMeshes[i], convertedMeshes[i], nullptr, &convertedMeshBounds[i]);
+    });
+    if (cancellation && cancellation->cancelled()) return {};
+
+    // meshes and textures that would exceed the read's read_memory_budget are skipped, so rather than return an incomplete model abandon the read
+    if (auto readMemory = currentReadMemory(); readMemory && readMemory->exceeded()) return {};
+
+    vsg::Group::Children instancedMeshes;
+    if (instanceMeshes) instancedMeshes = collectMeshInstances();
+
+    phaseTimer.next("assimp pipelines");
+    pipelineConfigurations.initialize(sharedObjects, numThreads);
+
+    textureData.clear();
 
+    phaseTimer.next("assimp scene graph");
     auto vsg_scene = visit(scene->mRootNode, 0);
+
+    auto& rootStats = subgraphStats[scene->mRootNode];
+    bool sceneBounded = rootStats.bounded;
+    vsg::dbox sceneBounds = rootStats.bounds;
+
+    // the instance matrices are relative to the root node so the instanced meshes are siblings of the root node's subgraph
+    if (!instancedMeshes.empty())
+    {
+        auto group = vsg::Group::create();
+        if (vsg_scene) group->addChild(vsg_scene);
+        for (auto& child : instancedMeshes) group->addChild(child);
+        vsg_scene = group;
+
+        for (auto& child : instancedMeshes)
+        {
+            if (auto cullNode = child.cast<vsg::CullNode>())
+            {
+                auto& bound = cullNode->bound;
+                sceneBounds.add(bound.center - vsg::dvec3(bound.radius, bound.radius, bound.radius));
+                sceneBounds.add(bound.center + vsg::dvec3(bound.radius, bound.radius, bound.radius));
+            }
+            else
+            {
+                sceneBounded = false;
+            }
+        }
+
+        meshInstances.clear();
+        instancedMeshReferences.clear();
+    }
     if (!vsg_scene)
     {
+        sceneBounded = false;
+
         if (scene->mNumMeshes == 1)
         {
             vsg_scene = convertedMeshes[0];
@@ -1109,6 +2104,7 @@ vsg::ref_ptr<vsg::Node> SceneConverter::visit(const aiScene* in_scene, vsg::ref_
     {
         transform->addChild(vsg_scene);
         vsg_scene = transform;
+        sceneBounds = transformBounds(transform->matrix, sceneBounds);
 
         // TODO check if subgraph requires culling
         // transform->subgraphRequiresLocalFrustum = false;
@@ -1132,6 +2128,9 @@ vsg::ref_ptr<vsg::Node> SceneConverter::visit(const aiScene* in_scene, vsg::ref_
                 if (assignJointSampler)
                 {
                     animation->samplers.push_back(jointSampler);
+
+                    // the palettes copy from the jointMatrices so must be updated after the jointSampler
+                    for (auto& paletteSampler : jointPaletteSamplers) animation->samplers.push_back(paletteSampler);
                 }
             }
 
@@ -1162,13 +2161,26 @@ vsg::ref_ptr<vsg::Node> SceneConverter::visit(const aiScene* in_scene, vsg::ref_
 
     if (!name.empty()) vsg_scene->setValue("name", name);
 
+    if (!deferredTextures.empty())
+    {
+        std::vector<vsg::ref_ptr<DeferredTexture>> sortedTextures;
+        for (auto& entry : deferredTextures) sortedTextures.push_back(entry.second);
+        std::sort(sortedTextures.begin(), sortedTextures.end(), [](auto& lhs, auto& rhs) { return lhs->filename < rhs->filename; });
+
+        auto objects = vsg::Objects::create();
+        for (auto& deferredTexture : sortedTextures) objects->addChild(deferredTexture);
+        vsg_scene->setObject("deferred_textures", objects);
+
+        deferredTextures.clear();
+    }
+
     if (printAssimp > 0) print(std::cout, in_scene, vsg::indentation{0});
 
     if (culling)
     {
-        auto bounds = vsg::visit<vsg::ComputeBounds>(vsg_scene).bounds;
-        vsg::dsphere bs((bounds.max + bounds.min) * 0.5, vsg::length(bounds.max - bounds.min) * 0.5);
-        auto cullNode = vsg::CullNode::create(bs, vsg_scene);
+        // use the bounds computed during conversion when they cover the whole scene, otherwise compute them from the scene graph
+        auto bounds = (sceneBounded && sceneBounds.valid()) ? sceneBounds : vsg::visit<ComputeSceneBounds>(vsg_scene).bounds;
+        auto cullNode = vsg::CullNode::create(toSphere(bounds), vsg_scene);
         vsg_scene = cullNode;
     }
 
@@ -1179,6 +2191,23 @@ vsg::ref_ptr<vsg::Node> SceneConverter::visit(const aiNode* node, int depth)
 {
     vsg::Group::Children children;
 
+    // bounds of the meshes and child subgraphs in this node's local coordinate frame, gathered as they are converted
+    BoundedNodes boundedChildren;
+    vsg::dbox localBounds;
+    bool bounded = true;
+    auto addBounded = [&](vsg::ref_ptr<vsg::Node> child, bool childBounded, const vsg::dbox& childBounds) {
+        if (!childBounded)
+        {
+            bounded = false;
+        }
+        else if (childBounds.valid())
+        {
+            localBounds.add(childBounds.min);
+            localBounds.add(childBounds.max);
+            boundedChildren.emplace_back(child, childBounds);
+        }
+    };
+
     auto& stats = subgraphStats[node];
     bool subgraphActive = stats.numMesh;
 
@@ -1202,9 +2231,15 @@ vsg::ref_ptr<vsg::Node> SceneConverter::visit(const aiNode* node, int depth)
     for (unsigned int i = 0; i < node->mNumMeshes; ++i)
     {
         auto mesh_index = node->mMeshes[i];
+        if (instancedMeshReferences.count({node, mesh_index}) != 0)
+        {
+            subgraphActive = true;
+            continue;
+        }
         if (auto child = convertedMeshes[mesh_index])
         {
             children.push_back(child);
+            if (mesh_index < convertedMeshBounds.size()) addBounded(child, convertedMeshBounds[mesh_index].valid(), convertedMeshBounds[mesh_index]);
         }
         subgraphActive = true;
     }
@@ -1215,11 +2250,34 @@ vsg::ref_ptr<vsg::Node> SceneConverter::visit(const aiNode* node, int depth)
         if (auto child = visit(node->mChildren[i], depth + 1))
         {
             children.push_back(child);
+
+            auto& childStats = subgraphStats[node->mChildren[i]];
+            addBounded(child, childStats.bounded, childStats.bounds);
         }
     }
 
+    // rebalance long lists of children into a bounding volume hierarchy so they can be culled hierarchically, leaving the children of Joint unchanged for the JointSampler
+    const size_t maxLeafChildren = 4;
+    if (cullHierarchy && boundedChildren.size() > 2 * maxLeafChildren && boneTransforms.count(node) == 0)
+    {
+        std::set<vsg::Node*> hierarchyChildren;
+        for (auto& boundedChild : boundedChildren) hierarchyChildren.insert(boundedChild.first.get());
+
+        vsg::Group::Children balancedChildren;
+        for (auto& child : children)
+        {
+            if (hierarchyChildren.count(child.get()) == 0) balancedChildren.push_back(child);
+        }
+        balancedChildren.push_back(createCullHierarchy(boundedChildren, 0, boundedChildren.size(), maxLeafChildren));
+
+        children.swap(balancedChildren);
+    }
+
     bool boneTransform = boneTransforms.find(node) != boneTransforms.end();
     bool animationTransform = !name.empty() && (animationTransforms.find(name) != animationTransforms.end());
+
+    stats.bounded = bounded && !boneTransform && !animationTransform;
+    stats.bounds = stats.bounded ? transformBounds(toMatrix(node->mTransformation), localBounds) : vsg::dbox();
     if (boneTransform || animationTransform)
     {
         aiMatrix4x4 m = node->mTransformation;
@@ -1313,9 +2371,125 @@ vsg::ref_ptr<vsg::Node> SceneConverter::visit(const aiNode* node, int depth)
     }
 }
 
-void SceneConverter::processAnimations()
+void SceneConverter::createJointPalettes()
+{
+    // meshes have been split by aiProcess_SplitByBoneCount so that each references at most maxJoints bones,
+    // give each its own palette of joint matrices so the uniform/storage buffer bound per mesh only holds the joints it uses.
+    for (unsigned int mi = 0; mi < scene->mNumMeshes; ++mi)
+    {
+        auto mesh = scene->mMeshes[mi];
+        if (!mesh->HasBones() || mesh->mNumBones > maxJoints || mesh->mMaterialIndex >= scene->mNumMaterials) continue;
+
+        auto paletteSampler = JointPaletteSampler::create();
+        paletteSampler->name = mesh->mName.C_Str();
+        paletteSampler->jointMatrices = jointSampler->jointMatrices;
+        paletteSampler->paletteMatrices = vsg::mat4Array::create(mesh->mNumBones);
+        paletteSampler->paletteMatrices->properties.dataVariance = vsg::DYNAMIC_DATA;
+        paletteSampler->joints.resize(mesh->mNumBones, 0);
+        for (unsigned int bi = 0; bi < mesh->mNumBones; ++bi)
+        {
+            if (auto itr = bones.find(mesh->mBones[bi]); itr != bones.end()) paletteSampler->joints[bi] = itr->second.index;
+        }
+
+        auto material = vsg::DescriptorConfigurator::create();
+        convert(scene->mMaterials[mesh->mMaterialIndex], *material, paletteSampler->paletteMatrices);
+
+        jointPaletteMaterials[mesh] = material;
+        jointPaletteSamplers.push_back(paletteSampler);
+    }
+}
+
+namespace
 {
+    double keyframeError(const vsg::dvec3& lhs, const vsg::dvec3& rhs)
+    {
+        return vsg::length(lhs - rhs);
+    }
+
+    double keyframeError(const vsg::dquat& lhs, const vsg::dquat& rhs)
+    {
+        // angle between the two rotations, q and -q being the same rotation
+        double cosHalfAngle = std::min(1.0, std::fabs(lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z + lhs.w * rhs.w));
+        return 2.0 * std::acos(cosHalfAngle);
+    }
+
+    /// sample the keyframes at the specified time, interpolating the same way as vsg::TransformSampler.
+    template<typename K>
+    auto sampleKeyframes(const std::vector<K>& keys, double time)
+    {
+        if (time <= keys.front().time) return keys.front().value;
+        if (time >= keys.back().time) return keys.back().value;
+
+        auto after = std::upper_bound(keys.begin(), keys.end(), time, [](double t, const K& key) { return t < key.time; });
+        auto before = after - 1;
+        double delta = after->time - before->time;
+        double r = delta > 0.0 ? (time - before->time) / delta : 0.0;
+        return vsg::mix(before->value, after->value, r);
+    }
+
+    /// resample the keyframes at a fixed rate, keeping the start and end times, if that reduces the number of keyframes.
+    template<typename K>
+    void resampleKeyframes(std::vector<K>& keys, double sampleRate)
+    {
+        if (keys.size() < 2 || sampleRate <= 0.0) return;
+
+        double startTime = keys.front().time;
+        double endTime = keys.back().time;
+        size_t numIntervals = static_cast<size_t>(std::ceil((endTime - startTime) * sampleRate - 1e-6));
+        if (numIntervals + 1 >= keys.size()) return;
+
+        std::vector<K> resampled(numIntervals + 1);
+        for (size_t i = 0; i < numIntervals; ++i)
+        {
+            double time = startTime + static_cast<double>(i) / sampleRate;
+            resampled[i].time = time;
+            resampled[i].value = sampleKeyframes(keys, time);
+        }
+        resampled.back() = keys.back();
+
+        keys.swap(resampled);
+    }
+
+    /// remove the keyframes that can be linearly interpolated from the keyframes kept either side of them within the tolerance,
+    /// reducing channels whose keyframes all lie within the tolerance of each other to a single keyframe.
+    template<typename K>
+    void reduceKeyframes(std::vector<K>& keys, double tolerance)
+    {
+        if (keys.size() < 2 || tolerance <= 0.0) return;
+
+        std::vector<K> reduced;
+        reduced.push_back(keys.front());
+
+        size_t lastKept = 0;
+        for (size_t i = 1; i + 1 < keys.size(); ++i)
+        {
+            // check whether all the keyframes since the last one kept, including this one, can be interpolated from the last one kept and the next one.
+            auto& start = keys[lastKept];
+            auto& end = keys[i + 1];
+            double delta = end.time - start.time;
+            bool removable = delta > 0.0;
+            for (size_t j = lastKept + 1; j <= i && removable; ++j)
+            {
+                double r = (keys[j].time - start.time) / delta;
+                removable = keyframeError(vsg::mix(start.value, end.value, r), keys[j].value) <= tolerance;
+            }
 
+            if (!removable)
+            {
+                reduced.push_back(keys[i]);
+                lastKept = i;
+            }
+        }
+        reduced.push_back(keys.back());
+
+        if (reduced.size() == 2 && keyframeError(reduced[0].value, reduced[1].value) <= tolerance) reduced.resize(1);
+
+        keys.swap(reduced);
+    }
+} // namespace
+
+void SceneConverter::processAnimations()
+{
     for (unsigned int ai = 0; ai < scene->mNumAnimations; ++ai)
     {
         auto animation = scene->mAnimations[ai];
@@ -1448,6 +2622,21 @@ void SceneConverter::processAnimations()
                     }
                 }
             }
+
+            if (animationSampleRate > 0.0 || animationTolerance > 0.0)
+            {
+                auto& positions = vsg_transformKeyframes->positions;
+                auto& rotations = vsg_transformKeyframes->rotations;
+                auto& scales = vsg_transformKeyframes->scales;
+
+                resampleKeyframes(positions, animationSampleRate);
+                resampleKeyframes(rotations, animationSampleRate);
+                resampleKeyframes(scales, animationSampleRate);
+
+                reduceKeyframes(positions, animationTolerance);
+                reduceKeyframes(rotations, animationTolerance);
+                reduceKeyframes(scales, animationTolerance);
+            }
         }
 
         for (unsigned int moi = 0; moi < animation->mNumMorphMeshChannels; ++moi)
@@ -15,7 +15,11 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <stack>
 
 #include <vsg/all.h>
+#include <vsgXchange/mesh_optimizer.h>
 #include <vsgXchange/models.h>
+#include <vsgXchange/texture_arrays.h>
+
+#include "../all/pipeline_configurations.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
@@ -73,6 +77,12 @@ namespace vsgXchange
         vsg::ref_ptr<vsg::Data> data;
     };
 
+    struct TextureData
+    {
+        vsg::Path filename; // resolved filename of an external texture, empty for embedded textures
+        vsg::ref_ptr<vsg::Data> data;
+    };
+
     struct SubgraphStats
     {
         unsigned int depth = 0;
@@ -81,6 +91,11 @@ namespace vsgXchange
         unsigned int numBones = 0;
         vsg::ref_ptr<vsg::Object> vsg_object;
 
+        // bounds of the converted subgraph in the parent node's coordinate frame, computed during conversion,
+        // bounded is false when the subgraph contains animated transforms or skinned meshes so has no fixed bounds.
+        vsg::dbox bounds;
+        bool bounded = true;
+
         SubgraphStats& operator+=(const SubgraphStats& rhs)
         {
             numMesh += rhs.numMesh;
@@ -139,26 +154,54 @@ namespace vsgXchange
         bool externalTextures = false;
         TextureFormat externalTextureFormat = TextureFormat::native;
         bool culling = true;
+        uint32_t numThreads = 1;
+        bool deferTextures = false;
+        bool uint8Indices = false;
+        vsg::ref_ptr<OptimizeMeshes> meshOptimizer;
+        bool quantizeVertices = false;
+        bool instanceMeshes = false;
+        vsg::ref_ptr<GenerateLODs> lodGenerator;
+        double animationTolerance = 0.0;
+        double animationSampleRate = 0.0;
+        bool packJoints = false;
+        uint32_t maxJoints = 0;
+        bool cullHierarchy = false;
+        bool textureArrays = false;
 
         // set for the file format being read.
         vsg::CoordinateSpace sourceVertexColorSpace = vsg::CoordinateSpace::LINEAR;
         vsg::CoordinateSpace sourceMaterialColorSpace = vsg::CoordinateSpace::LINEAR;
 
         // set for the target ShaderSet's
-        vsg::CoordinateSpace targetVertexColorSpace = vsg::CoordinateSpace::LINEAR;
         vsg::CoordinateSpace targetMaterialCoordinateSpace = vsg::CoordinateSpace::LINEAR;
 
 
         // TODO flatShadedShaderSet?
         vsg::ref_ptr<vsg::ShaderSet> pbrShaderSet;
         vsg::ref_ptr<vsg::ShaderSet> phongShaderSet;
+
+        struct TextureArrayShaderSet
+        {
+            vsg::ref_ptr<vsg::ShaderSet> shaderSet; // null if the ShaderSet's shaders couldn't be converted
+            std::set<std::string> textureNames;
+        };
+        std::map<const vsg::ShaderSet*, TextureArrayShaderSet> textureArrayShaderSets;
         vsg::ref_ptr<vsg::SharedObjects> sharedObjects;
         vsg::ref_ptr<vsg::External> externalObjects;
 
+        std::map<std::string, TextureData> textureData;
+        std::map<const vsg::Data*, vsg::ref_ptr<DeferredTexture>> deferredTextures;
         std::vector<vsg::ref_ptr<vsg::DescriptorConfigurator>> convertedMaterials;
+        std::vector<float> textureLayers; // layer of the texture arrays selected by each material's meshes, -1 for materials without texture arrays
+        PipelineConfigurations pipelineConfigurations;
         std::vector<vsg::ref_ptr<vsg::Node>> convertedMeshes;
+        std::vector<vsg::dbox> convertedMeshBounds;
+        std::map<unsigned int, std::vector<vsg::dmat4>> meshInstances;
+        std::set<std::pair<const aiNode*, unsigned int>> instancedMeshReferences;
         std::set<std::string> animationTransforms;
         vsg::ref_ptr<vsg::JointSampler> jointSampler;
+        std::map<const aiMesh*, vsg::ref_ptr<vsg::DescriptorConfigurator>> jointPaletteMaterials;
+        std::vector<vsg::ref_ptr<JointPaletteSampler>> jointPaletteSamplers;
         vsg::ref_ptr<vsg::Node> topEmptyTransform;
 
         SubgraphStats collectSubgraphStats(const aiNode* node, unsigned int depth);
@@ -246,12 +289,24 @@ namespace vsgXchange
             return phongShaderSet;
         }
 
+        TextureData resolveTexture(const std::string& texPath) const;
+        vsg::ref_ptr<vsg::Data> readTexture(const std::string& texPath, const vsg::Path& externalTextureFilename) const;
+        void readTextures();
+        void collectDeferredTextures();
         SamplerData convertTexture(const aiMaterial& material, aiTextureType type) const;
 
-        void convert(const aiMaterial* material, vsg::DescriptorConfigurator& convertedMaterial);
+        void convert(const aiMaterial* material, vsg::DescriptorConfigurator& convertedMaterial, vsg::ref_ptr<vsg::Data> jointMatrices = {});
+        void createJointPalettes();
+
+        const TextureArrayShaderSet& getOrCreateTextureArrayShaderSet(const vsg::ShaderSet& shaderSet);
+        void consolidateTextureArrays();
+
+        vsg::ref_ptr<vsg::Data> createIndices(const aiMesh* mesh, VkPrimitiveTopology& topology);
+        void convert(const aiMesh* mesh, vsg::ref_ptr<vsg::Node>& node, const std::vector<vsg::dmat4>* instanceMatrices = nullptr, vsg::dbox* meshBounds = nullptr);
 
-        vsg::ref_ptr<vsg::Data> createIndices(const aiMesh* mesh, unsigned int numIndicesPerFace, uint32_t numIndices);
-        void convert(const aiMesh* mesh, vsg::ref_ptr<vsg::Node>& node);
+        void collectMeshInstances(const aiNode* node, const vsg::dmat4& parentMatrix, bool staticTransforms, const std::vector<unsigned int>& uniqueMeshes,
+                                  std::map<unsigned int, std::vector<std::pair<const aiNode*, vsg::dmat4>>>& meshReferences) const;
+        vsg::Group::Children collectMeshInstances();
 
         vsg::ref_ptr<vsg::Node> visit(const aiScene* in_scene, vsg::ref_ptr<const vsg::Options> in_options, const vsg::Path& ext);
         vsg::ref_ptr<vsg::Node> visit(const aiNode* node, int depth);
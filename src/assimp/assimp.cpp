@@ -10,9 +10,19 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <vsgXchange/cancellation.h>
 #include <vsgXchange/models.h>
+#include <vsgXchange/read_write_observer.h>
 
+#include "IOSystem.h"
 #include "SceneConverter.h"
+#include "../all/stream_utils.h"
+
+#include <assimp/ProgressHandler.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
 
 using namespace vsgXchange;
 
@@ -25,7 +35,30 @@ public:
     vsg::ref_ptr<vsg::Object> read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options = {}) const;
     vsg::ref_ptr<vsg::Object> read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options = {}) const;
 
+    /// return the post processing flags for the options, setting any associated importer properties.
+    uint32_t importFlags(Assimp::Importer& importer, const vsg::Options* options) const;
+
+    /// Assimp::Importer isn't thread safe so each read needs its own, but constructing one registers all the importers and post processing steps,
+    /// so keep the Importer from completed reads to reuse for subsequent reads.
+    class PooledImporter
+    {
+    public:
+        /// take an importer from the pool, assigning a progress handler that aborts the import if options has a CancellationToken.
+        PooledImporter(const Implementation& in_implementation, const vsg::Options* options);
+        ~PooledImporter();
+
+        Assimp::Importer* operator->() { return importer.get(); }
+        Assimp::Importer& operator*() { return *importer; }
+
+    protected:
+        const Implementation& implementation;
+        std::unique_ptr<Assimp::Importer> importer;
+    };
+
     const uint32_t _importFlags;
+
+    mutable std::mutex _importerMutex;
+    mutable std::vector<std::unique_ptr<Assimp::Importer>> _importers;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -58,6 +91,41 @@ vsg::ref_ptr<vsg::Object> assimp::read(const uint8_t* ptr, size_t size, vsg::ref
     return _implementation->read(ptr, size, options);
 }
 
+namespace
+{
+    void addOptionFeatures(vsg::ReaderWriter::Features& features)
+    {
+        // enumerate the supported vsg::Options::setValue(str, value) options
+        features.optionNameTypeMap[vsgXchange::assimp::generate_smooth_normals] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::generate_sharp_normals] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::crease_angle] = vsg::type_name<float>();
+        features.optionNameTypeMap[vsgXchange::assimp::two_sided] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::discard_empty_nodes] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::print_assimp] = vsg::type_name<int>();
+        features.optionNameTypeMap[vsgXchange::assimp::external_textures] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::external_texture_format] = vsg::type_name<TextureFormat>();
+        features.optionNameTypeMap[vsgXchange::assimp::culling] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::vertex_color_space] = vsg::type_name<vsg::CoordinateSpace>();
+        features.optionNameTypeMap[vsgXchange::assimp::material_color_space] = vsg::type_name<vsg::CoordinateSpace>();
+        features.optionNameTypeMap[vsgXchange::assimp::num_threads] = vsg::type_name<uint32_t>();
+        features.optionNameTypeMap[vsgXchange::assimp::deferred_textures] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::uint8_indices] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::optimize_meshes] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::quantize_vertices] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::instance_meshes] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::merge_static_meshes] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::lod_levels] = vsg::type_name<uint32_t>();
+        features.optionNameTypeMap[vsgXchange::assimp::lod_error] = vsg::type_name<float>();
+        features.optionNameTypeMap[vsgXchange::assimp::import_flags] = vsg::type_name<uint32_t>();
+        features.optionNameTypeMap[vsgXchange::assimp::animation_tolerance] = vsg::type_name<double>();
+        features.optionNameTypeMap[vsgXchange::assimp::animation_sample_rate] = vsg::type_name<double>();
+        features.optionNameTypeMap[vsgXchange::assimp::pack_joints] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::max_joints] = vsg::type_name<uint32_t>();
+        features.optionNameTypeMap[vsgXchange::assimp::cull_hierarchy] = vsg::type_name<bool>();
+        features.optionNameTypeMap[vsgXchange::assimp::texture_arrays] = vsg::type_name<bool>();
+    }
+} // namespace
+
 bool assimp::getFeatures(Features& features) const
 {
     std::string suported_extensions;
@@ -76,22 +144,28 @@ bool assimp::getFeatures(Features& features) const
     }
     features.extensionFeatureMap[suported_extensions.substr(start, std::string::npos)] = supported_features;
 
-    // enumerate the supported vsg::Options::setValue(str, value) options
-    features.optionNameTypeMap[assimp::generate_smooth_normals] = vsg::type_name<bool>();
-    features.optionNameTypeMap[assimp::generate_sharp_normals] = vsg::type_name<bool>();
-    features.optionNameTypeMap[assimp::crease_angle] = vsg::type_name<float>();
-    features.optionNameTypeMap[assimp::two_sided] = vsg::type_name<bool>();
-    features.optionNameTypeMap[assimp::discard_empty_nodes] = vsg::type_name<bool>();
-    features.optionNameTypeMap[assimp::print_assimp] = vsg::type_name<int>();
-    features.optionNameTypeMap[assimp::external_textures] = vsg::type_name<bool>();
-    features.optionNameTypeMap[assimp::external_texture_format] = vsg::type_name<TextureFormat>();
-    features.optionNameTypeMap[assimp::culling] = vsg::type_name<bool>();
-    features.optionNameTypeMap[assimp::vertex_color_space] = vsg::type_name<vsg::CoordinateSpace>();
-    features.optionNameTypeMap[assimp::material_color_space] = vsg::type_name<vsg::CoordinateSpace>();
+    addOptionFeatures(features);
 
     return true;
 }
 
+void assimp::getStaticFeatures(Features& features)
+{
+    // extensions of the importers built into assimp 5.x by default
+    static const char* s_extensions[] = {
+        ".3d", ".3ds", ".3mf", ".ac", ".ac3d", ".acc", ".amf", ".ase", ".ask", ".assbin", ".b3d", ".blend",
+        ".bsp", ".bvh", ".cob", ".csm", ".dae", ".dxf", ".enff", ".fbx", ".glb", ".gltf", ".hmp", ".ifc",
+        ".ifczip", ".iqm", ".irr", ".irrmesh", ".lwo", ".lws", ".lxo", ".m3d", ".md2", ".md3", ".md5anim", ".md5camera",
+        ".md5mesh", ".mdc", ".mdl", ".mesh", ".mot", ".ms3d", ".ndo", ".nff", ".obj", ".off", ".ogex", ".pk3",
+        ".ply", ".pmx", ".prj", ".q3o", ".q3s", ".raw", ".scn", ".sib", ".smd", ".step", ".stl", ".stp",
+        ".ter", ".uc", ".vta", ".x", ".x3d", ".x3db", ".xgl", ".xml", ".zae", ".zgl"};
+
+    vsg::ReaderWriter::FeatureMask supported_features = static_cast<vsg::ReaderWriter::FeatureMask>(vsg::ReaderWriter::READ_FILENAME | vsg::ReaderWriter::READ_ISTREAM | vsg::ReaderWriter::READ_MEMORY);
+    for (auto ext : s_extensions) features.extensionFeatureMap[ext] = supported_features;
+
+    addOptionFeatures(features);
+}
+
 bool assimp::readOptions(vsg::Options& options, vsg::CommandLine& arguments) const
 {
     bool result = arguments.readAndAssign<bool>(assimp::generate_smooth_normals, &options);
@@ -105,10 +179,51 @@ bool assimp::readOptions(vsg::Options& options, vsg::CommandLine& arguments) con
     result = arguments.readAndAssign<bool>(assimp::culling, &options) || result;
     result = arguments.readAndAssign<vsg::CoordinateSpace>(assimp::vertex_color_space, &options) || result;
     result = arguments.readAndAssign<vsg::CoordinateSpace>(assimp::material_color_space, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(assimp::num_threads, &options) || result;
+    result = arguments.readAndAssign<bool>(assimp::deferred_textures, &options) || result;
+    result = arguments.readAndAssign<bool>(assimp::uint8_indices, &options) || result;
+    result = arguments.readAndAssign<bool>(assimp::optimize_meshes, &options) || result;
+    result = arguments.readAndAssign<bool>(assimp::quantize_vertices, &options) || result;
+    result = arguments.readAndAssign<bool>(assimp::instance_meshes, &options) || result;
+    result = arguments.readAndAssign<bool>(assimp::merge_static_meshes, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(assimp::lod_levels, &options) || result;
+    result = arguments.readAndAssign<float>(assimp::lod_error, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(assimp::import_flags, &options) || result;
+    result = arguments.readAndAssign<double>(assimp::animation_tolerance, &options) || result;
+    result = arguments.readAndAssign<double>(assimp::animation_sample_rate, &options) || result;
+    result = arguments.readAndAssign<bool>(assimp::pack_joints, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(assimp::max_joints, &options) || result;
+    result = arguments.readAndAssign<bool>(assimp::cull_hierarchy, &options) || result;
+    result = arguments.readAndAssign<bool>(assimp::texture_arrays, &options) || result;
 
     return result;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// DeferredTexture
+//
+vsg::ref_ptr<vsg::Data> DeferredTexture::load()
+{
+    auto data = vsg::read_cast<vsg::Data>(filename, options);
+    if (!data)
+    {
+        vsg::warn("Failed to load deferred texture: ", filename);
+        return {};
+    }
+
+    auto image = vsg::Image::create(data);
+    image->usage |= (VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    auto imageView = vsg::ImageView::create(image, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    for (auto& imageInfo : imageInfos)
+    {
+        imageInfo->imageView = imageView;
+    }
+
+    return data;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // assimp ReaderWriter implementation
@@ -118,29 +233,117 @@ assimp::Implementation::Implementation() :
 {
 }
 
+namespace
+{
+    /// aborts an import once the read's CancellationToken is cancelled, assimp polls it as the file is loaded and between post processing steps.
+    class CancellationProgressHandler : public Assimp::ProgressHandler
+    {
+    public:
+        explicit CancellationProgressHandler(vsg::ref_ptr<const vsgXchange::CancellationToken> in_cancellation) :
+            cancellation(in_cancellation) {}
+
+        bool Update(float /*percentage*/) override { return !cancellation->cancelled(); }
+
+        vsg::ref_ptr<const vsgXchange::CancellationToken> cancellation;
+    };
+} // namespace
+
+assimp::Implementation::PooledImporter::PooledImporter(const Implementation& in_implementation, const vsg::Options* options) :
+    implementation(in_implementation)
+{
+    {
+        std::scoped_lock<std::mutex> lock(implementation._importerMutex);
+        if (!implementation._importers.empty())
+        {
+            importer = std::move(implementation._importers.back());
+            implementation._importers.pop_back();
+        }
+        else
+        {
+            importer = std::make_unique<Assimp::Importer>();
+        }
+    }
+
+    // the importer takes ownership of the handler
+    if (auto cancellation = vsgXchange::getCancellationToken(options)) importer->SetProgressHandler(new CancellationProgressHandler(vsg::ref_ptr<const vsgXchange::CancellationToken>(cancellation)));
+}
+
+assimp::Implementation::PooledImporter::~PooledImporter()
+{
+    // release the scene and IOSystem so they don't hold memory or options while pooled
+    importer->FreeScene();
+
+    // SetIOHandler(nullptr) and SetProgressHandler(nullptr) install default handlers without deleting the previous ones, so delete them here
+    auto ioHandler = importer->GetIOHandler();
+    importer->SetIOHandler(nullptr);
+    delete ioHandler;
+
+    auto progressHandler = importer->GetProgressHandler();
+    importer->SetProgressHandler(nullptr);
+    delete progressHandler;
+
+    std::scoped_lock<std::mutex> lock(implementation._importerMutex);
+    implementation._importers.push_back(std::move(importer));
+}
+
+uint32_t assimp::Implementation::importFlags(Assimp::Importer& importer, const vsg::Options* options) const
+{
+    uint32_t flags = vsg::value<uint32_t>(_importFlags, assimp::import_flags, options);
+
+    // reset the properties that a previous read with the pooled Importer may have set
+    importer.SetPropertyFloat(AI_CONFIG_PP_CT_MAX_SMOOTHING_ANGLE, 80.0f);
+    importer.SetPropertyInteger(AI_CONFIG_PP_SBBC_MAX_BONES, AI_SBBC_DEFAULT_MAX_BONES);
+
+    if (vsg::value<bool>(false, assimp::generate_smooth_normals, options))
+    {
+        importer.SetPropertyFloat(AI_CONFIG_PP_CT_MAX_SMOOTHING_ANGLE, vsg::value<float>(80.0f, assimp::crease_angle, options));
+        flags |= aiProcess_GenSmoothNormals;
+    }
+    else if (vsg::value<bool>(false, assimp::generate_sharp_normals, options))
+    {
+        flags |= aiProcess_GenNormals;
+    }
+
+    if (vsg::value<bool>(false, assimp::merge_static_meshes, options))
+    {
+        // collapse the nodes that aren't animated, used as bones or referenced by cameras and lights, pre-transforming their meshes,
+        // so that aiProcess_OptimizeMeshes can then join the meshes that share a material into a single mesh.
+        flags |= aiProcess_OptimizeGraph | aiProcess_OptimizeMeshes;
+    }
+
+    if (auto maxJoints = vsg::value<uint32_t>(0, assimp::max_joints, options); maxJoints > 0)
+    {
+        // split the skinned meshes so each can be drawn with its own palette of joint matrices
+        importer.SetPropertyInteger(AI_CONFIG_PP_SBBC_MAX_BONES, static_cast<int>(maxJoints));
+        flags |= aiProcess_SplitByBoneCount;
+    }
+
+    return flags;
+}
+
 vsg::ref_ptr<vsg::Object> assimp::Implementation::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
 {
-    Assimp::Importer importer;
+    PooledImporter importer(*this, options.get());
     vsg::Path ext = (options && options->extensionHint) ? options->extensionHint : vsg::lowerCaseFileExtension(filename);
 
-    if (importer.IsExtensionSupported(ext.string()))
+    if (importer->IsExtensionSupported(ext.string()))
     {
-        vsg::Path filenameToUse = vsg::findFile(filename, options);
-        if (!filenameToUse) return {};
+        // resolve the files the scene references through the options' paths and ReaderWriters, this also allows scenes to be read from http/https URLs via the curl ReaderWriter.
+        auto ioSystem = new vsgXchange::IOSystem(options);
+        importer->SetIOHandler(ioSystem);
 
-        uint32_t flags = _importFlags;
-        if (vsg::value<bool>(false, assimp::generate_smooth_normals, options))
-        {
-            importer.SetPropertyFloat(AI_CONFIG_PP_CT_MAX_SMOOTHING_ANGLE, vsg::value<float>(80.0f, assimp::crease_angle, options));
-            flags |= aiProcess_GenSmoothNormals;
-        }
-        else if (vsg::value<bool>(false, assimp::generate_sharp_normals, options))
+        vsg::Path filenameToUse = vsg::findFile(filename, options);
+        if (!filenameToUse)
         {
-            flags |= aiProcess_GenNormals;
+            if (!ioSystem->Exists(filename.string().c_str())) return {};
+            filenameToUse = filename;
         }
 
-        if (auto scene = importer.ReadFile(filenameToUse.string(), flags); scene)
+        vsgXchange::ReadWritePhaseTimer phaseTimer("assimp import");
+        if (auto scene = importer->ReadFile(filenameToUse.string(), importFlags(*importer, options)); scene)
         {
+            phaseTimer.end();
+
             auto opt = vsg::clone(options);
             opt->paths.insert(opt->paths.begin(), vsg::filePath(filenameToUse));
 
@@ -156,9 +359,9 @@ vsg::ref_ptr<vsg::Object> assimp::Implementation::read(const vsg::Path& filename
 
             return root;
         }
-        else
+        else if (!vsgXchange::cancelled(options.get()))
         {
-            vsg::warn("Failed to load file: ", filename, '\n', importer.GetErrorString());
+            vsg::warn("Failed to load file: ", filename, '\n', importer->GetErrorString());
         }
     }
 
@@ -169,27 +372,26 @@ vsg::ref_ptr<vsg::Object> assimp::Implementation::read(std::istream& fin, vsg::r
 {
     if (!options || !options->extensionHint) return {};
 
-    Assimp::Importer importer;
-    if (importer.IsExtensionSupported(options->extensionHint.string()))
+    PooledImporter importer(*this, options.get());
+    if (importer->IsExtensionSupported(options->extensionHint.string()))
     {
-        std::string buffer(1 << 16, 0); // 64kB
-        std::string input;
+        vsgXchange::StreamData input;
+        if (!vsgXchange::readStream(fin, input)) return {};
 
-        while (!fin.eof())
-        {
-            fin.read(&buffer[0], buffer.size());
-            const auto bytes_readed = fin.gcount();
-            input.append(&buffer[0], bytes_readed);
-        }
+        // Assimp serves the memory block itself, forwarding requests for the files it references to the IOSystem
+        importer->SetIOHandler(new vsgXchange::IOSystem(options));
 
-        if (auto scene = importer.ReadFileFromMemory(input.data(), input.size(), _importFlags); scene)
+        vsgXchange::ReadWritePhaseTimer phaseTimer("assimp import");
+        if (auto scene = importer->ReadFileFromMemory(input.data, input.size, importFlags(*importer, options)); scene)
         {
+            phaseTimer.end();
+
             SceneConverter converter;
             return converter.visit(scene, options, options->extensionHint);
         }
-        else
+        else if (!vsgXchange::cancelled(options.get()))
         {
-            vsg::warn("Failed to load file from stream: ", importer.GetErrorString());
+            vsg::warn("Failed to load file from stream: ", importer->GetErrorString());
         }
     }
 
@@ -200,17 +402,22 @@ vsg::ref_ptr<vsg::Object> assimp::Implementation::read(const uint8_t* ptr, size_
 {
     if (!options || !options->extensionHint) return {};
 
-    Assimp::Importer importer;
-    if (importer.IsExtensionSupported(options->extensionHint.string()))
+    PooledImporter importer(*this, options.get());
+    if (importer->IsExtensionSupported(options->extensionHint.string()))
     {
-        if (auto scene = importer.ReadFileFromMemory(ptr, size, _importFlags); scene)
+        importer->SetIOHandler(new vsgXchange::IOSystem(options));
+
+        vsgXchange::ReadWritePhaseTimer phaseTimer("assimp import");
+        if (auto scene = importer->ReadFileFromMemory(ptr, size, importFlags(*importer, options)); scene)
         {
+            phaseTimer.end();
+
             SceneConverter converter;
             return converter.visit(scene, options, options->extensionHint);
         }
-        else
+        else if (!vsgXchange::cancelled(options.get()))
         {
-            vsg::warn("Failed to load file from memory: ", importer.GetErrorString());
+            vsg::warn("Failed to load file from memory: ", importer->GetErrorString());
         }
     }
     return {};
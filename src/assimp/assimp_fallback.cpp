@@ -44,7 +44,14 @@ bool assimp::getFeatures(Features&) const
 {
     return false;
 }
+void assimp::getStaticFeatures(Features&)
+{
+}
 bool assimp::readOptions(vsg::Options&, vsg::CommandLine&) const
 {
     return false;
 }
+vsg::ref_ptr<vsg::Data> DeferredTexture::load()
+{
+    return {};
+}
@@ -16,6 +16,7 @@ if (${vsgXchange_assimp})
 
     set(SOURCES ${SOURCES}
         assimp/assimp.cpp
+        assimp/IOSystem.cpp
         assimp/SceneConverter.cpp
     )
     set(EXTRA_INCLUDES ${EXTRA_INCLUDES} ${assimp_INCLUDE_DIRS})
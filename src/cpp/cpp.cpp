@@ -13,13 +13,305 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsgXchange/cpp.h>
 
 #include <vsg/io/AsciiOutput.h>
+#include <vsg/io/Logger.h>
 #include <vsg/io/VSG.h>
 #include <vsg/io/stream.h>
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <streambuf>
+#include <vector>
 
 using namespace vsgXchange;
 
+namespace
+{
+    /// streambuf that formats the bytes written to it as the initializer of a C++ uint8_t array as they arrive, so the serialized object is never held in memory as a whole.
+    /// Unless byteArray is set the first maxStringLiteral bytes are held back, and if the output ends within them it's left to be written as a more compact string literal.
+    class ArrayInitializerStreamBuf : public std::streambuf
+    {
+    public:
+        ArrayInitializerStreamBuf(std::ostream& out, bool byteArray, size_t maxStringLiteral) :
+            _out(out),
+            _maxStringLiteral(maxStringLiteral),
+            _buffer(65536)
+        {
+            setp(_buffer.data(), _buffer.data() + _buffer.size());
+            if (byteArray) beginByteArray();
+        }
+
+        /// flush the pending output, returning true if it was written as a byte array, otherwise the output is available from literal().
+        bool finish()
+        {
+            sync();
+            if (_byteArray) _out << " };\n";
+            return _byteArray;
+        }
+
+        const std::string& literal() const { return _literal; }
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            sync();
+            if (!traits_type::eq_int_type(c, traits_type::eof()))
+            {
+                *pptr() = traits_type::to_char_type(c);
+                pbump(1);
+            }
+            return traits_type::not_eof(c);
+        }
+
+        int sync() override
+        {
+            consume(pbase(), static_cast<size_t>(pptr() - pbase()));
+            setp(_buffer.data(), _buffer.data() + _buffer.size());
+            return _out ? 0 : -1;
+        }
+
+        void consume(const char* data, size_t size)
+        {
+            if (_byteArray)
+            {
+                format(reinterpret_cast<const uint8_t*>(data), size);
+            }
+            else if (size > 0)
+            {
+                _literal.append(data, size);
+                if (_literal.size() > _maxStringLiteral)
+                {
+                    // long string has to be handled as a byte array as VisualStudio can't handle long strings.
+                    beginByteArray();
+                    format(reinterpret_cast<const uint8_t*>(_literal.data()), _literal.size());
+                    std::string().swap(_literal);
+                }
+            }
+        }
+
+        void beginByteArray()
+        {
+            _byteArray = true;
+            _out << "static const uint8_t data[] = {\n";
+        }
+
+        void format(const uint8_t* data, size_t size)
+        {
+            struct Decimal
+            {
+                char text[3];
+                uint8_t length;
+            };
+
+            static const auto s_decimals = []() {
+                std::array<Decimal, 256> decimals{};
+                for (uint32_t i = 0; i < 256; ++i)
+                {
+                    auto& decimal = decimals[i];
+                    if (i >= 100) decimal.text[decimal.length++] = static_cast<char>('0' + i / 100);
+                    if (i >= 10) decimal.text[decimal.length++] = static_cast<char>('0' + (i / 10) % 10);
+                    decimal.text[decimal.length++] = static_cast<char>('0' + i % 10);
+                }
+                return decimals;
+            }();
+
+            // each byte takes at most 3 digits and a 2 character separator
+            _text.resize(size * 5);
+            char* ptr = _text.data();
+            for (size_t i = 0; i < size; ++i, ++_count)
+            {
+                if (_count > 0)
+                {
+                    *ptr++ = ',';
+                    *ptr++ = ((_count % 32) == 0) ? '\n' : ' ';
+                }
+
+                auto& decimal = s_decimals[data[i]];
+                for (uint8_t c = 0; c < decimal.length; ++c) *ptr++ = decimal.text[c];
+            }
+            _out.write(_text.data(), ptr - _text.data());
+        }
+
+        std::ostream& _out;
+        size_t _maxStringLiteral = 0;
+        bool _byteArray = false;
+        size_t _count = 0;
+        std::vector<char> _buffer;
+        std::string _literal;
+        std::string _text;
+    };
+
+    /// compress a block of data in the LZ4 block format, appending the compressed sequences to dst.
+    void compressBlock(const uint8_t* src, size_t size, std::vector<uint8_t>& dst, std::vector<uint32_t>& table)
+    {
+        constexpr size_t minMatch = 4;
+        constexpr uint32_t hashBits = 16;
+        constexpr uint32_t noEntry = 0xffffffff;
+
+        table.assign(size_t(1) << hashBits, noEntry);
+
+        auto read32 = [src](size_t pos) {
+            uint32_t value;
+            std::memcpy(&value, src + pos, sizeof(value));
+            return value;
+        };
+
+        auto writeLength = [&dst](size_t length) {
+            for (; length >= 255; length -= 255) dst.push_back(255);
+            dst.push_back(static_cast<uint8_t>(length));
+        };
+
+        auto writeSequence = [&](size_t literalStart, size_t literalLength, size_t offset, size_t matchLength) {
+            auto tokenPos = dst.size();
+            uint8_t token = static_cast<uint8_t>(std::min(literalLength, size_t(15)) << 4);
+            dst.push_back(0);
+
+            if (literalLength >= 15) writeLength(literalLength - 15);
+            dst.insert(dst.end(), src + literalStart, src + literalStart + literalLength);
+
+            if (matchLength > 0)
+            {
+                dst.push_back(static_cast<uint8_t>(offset & 0xff));
+                dst.push_back(static_cast<uint8_t>(offset >> 8));
+
+                auto length = matchLength - minMatch;
+                token |= static_cast<uint8_t>(std::min(length, size_t(15)));
+                if (length >= 15) writeLength(length - 15);
+            }
+            dst[tokenPos] = token;
+        };
+
+        // the format requires the last match to start at least 12 bytes, and end at least 5 bytes, before the end of the block
+        const size_t matchStartLimit = size > 12 ? size - 12 : 0;
+        const size_t matchEndLimit = size > 5 ? size - 5 : 0;
+
+        size_t anchor = 0;
+        size_t pos = 0;
+        while (pos < matchStartLimit)
+        {
+            auto sequence = read32(pos);
+            auto& entry = table[(sequence * 2654435761u) >> (32 - hashBits)];
+            size_t candidate = entry;
+            entry = static_cast<uint32_t>(pos);
+
+            if (candidate != noEntry && (pos - candidate) <= 65535 && read32(candidate) == sequence)
+            {
+                size_t length = minMatch;
+                while ((pos + length) < matchEndLimit && src[candidate + length] == src[pos + length]) ++length;
+
+                writeSequence(anchor, pos - anchor, pos - candidate, length);
+                pos += length;
+                anchor = pos;
+            }
+            else
+            {
+                ++pos;
+            }
+        }
+
+        writeSequence(anchor, size - anchor, 0, 0);
+    }
+
+    /// streambuf that compresses the bytes written to it in independent blocks, each written to the output as its compressed and uncompressed sizes, as 32 bit little endian values, followed by the LZ4 compressed block.
+    class CompressingStreamBuf : public std::streambuf
+    {
+    public:
+        explicit CompressingStreamBuf(std::ostream& out, size_t blockSize = 1 << 20) :
+            _out(out),
+            _buffer(blockSize)
+        {
+            setp(_buffer.data(), _buffer.data() + _buffer.size());
+        }
+
+        /// compress the remaining output, returning the total uncompressed size.
+        uint64_t finish()
+        {
+            compress();
+            return _uncompressedSize;
+        }
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            compress();
+            if (!traits_type::eq_int_type(c, traits_type::eof()))
+            {
+                *pptr() = traits_type::to_char_type(c);
+                pbump(1);
+            }
+            return traits_type::not_eof(c);
+        }
+
+        void compress()
+        {
+            auto size = static_cast<size_t>(pptr() - pbase());
+            if (size > 0)
+            {
+                _compressed.clear();
+                compressBlock(reinterpret_cast<const uint8_t*>(pbase()), size, _compressed, _table);
+
+                auto writeSize = [this](size_t value) {
+                    char bytes[4] = {static_cast<char>(value & 0xff), static_cast<char>((value >> 8) & 0xff), static_cast<char>((value >> 16) & 0xff), static_cast<char>((value >> 24) & 0xff)};
+                    _out.write(bytes, 4);
+                };
+
+                writeSize(_compressed.size());
+                writeSize(size);
+                _out.write(reinterpret_cast<const char*>(_compressed.data()), _compressed.size());
+                _uncompressedSize += size;
+            }
+            setp(_buffer.data(), _buffer.data() + _buffer.size());
+        }
+
+        std::ostream& _out;
+        std::vector<char> _buffer;
+        std::vector<uint8_t> _compressed;
+        std::vector<uint32_t> _table;
+        uint64_t _uncompressedSize = 0;
+    };
+
+    // decoder for the CompressingStreamBuf output, written into the generated source so it doesn't depend on a compression library
+    const char* s_decompressSource = R"(auto decompress = [](const uint8_t* src, size_t srcSize, uint8_t* dst) {
+    auto readSize = [](const uint8_t* ptr) { return size_t(ptr[0]) | (size_t(ptr[1]) << 8) | (size_t(ptr[2]) << 16) | (size_t(ptr[3]) << 24); };
+    auto readLength = [](const uint8_t*& ptr, size_t length) {
+        if (length == 15)
+        {
+            uint8_t b;
+            do { b = *ptr++; length += b; } while (b == 255);
+        }
+        return length;
+    };
+    const uint8_t* src_end = src + srcSize;
+    while (src < src_end)
+    {
+        size_t compressedSize = readSize(src);
+        size_t uncompressedSize = readSize(src + 4);
+        src += 8;
+        const uint8_t* block_end = src + compressedSize;
+        uint8_t* out = dst;
+        while (src < block_end)
+        {
+            uint8_t token = *src++;
+            size_t length = readLength(src, token >> 4);
+            std::memcpy(out, src, length);
+            out += length;
+            src += length;
+            if (src >= block_end) break;
+
+            size_t offset = size_t(src[0]) | (size_t(src[1]) << 8);
+            src += 2;
+            length = readLength(src, token & 15) + 4;
+            const uint8_t* match = out - offset;
+            while (length-- > 0) *out++ = *match++;
+        }
+        dst += uncompressedSize;
+    }
+};
+)";
+} // namespace
+
 cpp::cpp()
 {
 }
@@ -38,31 +330,86 @@ bool cpp::write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_p
     auto local_options = vsg::Options::create();
     local_options->extensionHint = binary ? ".vsgb" : ".vsgt";
 
-    // serialize object(s) to string
-    std::ostringstream str;
-    vsg::VSG io;
-    io.write(object, str, local_options);
-    std::string s = str.str();
+    std::string embedMode("array");
+    if (options) options->getValue(cpp::embed_mode, embedMode);
+
+    if (embedMode != "array" && embedMode != "compressed" && embedMode != "embed")
+    {
+        vsg::warn("cpp::write(", filename, ") unsupported embed_mode \"", embedMode, "\", writing byte array.");
+        embedMode = "array";
+    }
 
     std::ofstream fout(filename);
+    if (!fout) return false;
+
     fout << "#include <vsg/io/VSG.h>\n";
     fout << "#include <vsg/io/mem_stream.h>\n";
+    if (embedMode == "compressed")
+    {
+        fout << "#include <cstring>\n";
+        fout << "#include <vector>\n";
+    }
     fout << "static auto " << funcname << " = []() {\n";
 
-    if (binary || s.size() > 65535)
+    vsg::VSG io;
+
+    if (embedMode == "embed")
     {
-        // long string has to be handled as a byte array as VisualStudio can't handle long strings.
+        // write the serialized object alongside the .cpp for the compiler to embed, avoiding the parsing of a textual byte array
+        auto payloadFilename = vsg::simpleFilename(filename) + local_options->extensionHint;
+        auto payloadPath = vsg::filePath(filename);
+        payloadPath = payloadPath ? (payloadPath / payloadFilename) : payloadFilename;
+
+        std::ofstream payload(payloadPath, std::ios::out | std::ios::binary);
+        if (!payload || !io.write(object, payload, local_options)) return false;
+
+        fout << "#if defined(__has_embed)\n";
         fout << "static const uint8_t data[] = {\n";
-        fout << uint32_t(uint8_t(s[0]));
-        for (size_t i = 1; i < s.size(); ++i)
-        {
-            if ((i % 32) == 0)
-                fout << ",\n";
-            else
-                fout << ", ";
-            fout << uint32_t(uint8_t(s[i]));
-        }
-        fout << " };\n";
+        fout << "#embed \"" << payloadFilename.string() << "\"\n";
+        fout << "};\n";
+        fout << "#else\n";
+        fout << "#error \"" << vsg::simpleFilename(filename) << ".cpp requires a compiler that supports #embed, regenerate it with the embed_mode option set to array or compressed.\"\n";
+        fout << "#endif\n";
+        fout << "vsg::VSG io;\n";
+        fout << "return io.read_cast<" << object->className() << ">(data, sizeof(data));\n";
+        fout << "};\n";
+        fout.close();
+
+        return fout.good();
+    }
+
+    if (embedMode == "compressed")
+    {
+        // serialize object(s) through the compressor into the formatting of the array initializer
+        ArrayInitializerStreamBuf streambuf(fout, true, 0);
+        std::ostream compressed_str(&streambuf);
+
+        CompressingStreamBuf compressor(compressed_str);
+        std::ostream str(&compressor);
+        io.write(object, str, local_options);
+
+        auto uncompressedSize = compressor.finish();
+        compressed_str.flush();
+        streambuf.finish();
+
+        fout << s_decompressSource;
+        fout << "std::vector<uint8_t> uncompressed(" << uncompressedSize << ");\n";
+        fout << "decompress(data, sizeof(data), uncompressed.data());\n";
+        fout << "vsg::VSG io;\n";
+        fout << "return io.read_cast<" << object->className() << ">(uncompressed.data(), uncompressed.size());\n";
+        fout << "};\n";
+        fout.close();
+
+        return fout.good();
+    }
+
+    // serialize object(s) straight into the formatting of the array initializer
+    ArrayInitializerStreamBuf streambuf(fout, binary, 65535);
+    std::ostream str(&streambuf);
+    io.write(object, str, local_options);
+
+    if (streambuf.finish())
+    {
         //fout<<"vsg::mem_stream str(data, sizeof(data));\n";
         fout << "vsg::VSG io;\n";
         fout << "return io.read_cast<" << object->className() << ">(data, sizeof(data));\n";
@@ -70,7 +417,7 @@ bool cpp::write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_p
     else
     {
         fout << "static const char str[] = \n";
-        write(fout, str.str());
+        write(fout, streambuf.literal());
         fout << ";\n";
         fout << "vsg::VSG io;\n";
         fout << "return io.read_cast<" << object->className() << ">(reinterpret_cast<const uint8_t*>(str), sizeof(str));\n";
@@ -79,11 +426,17 @@ bool cpp::write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_p
     fout << "};\n";
     fout.close();
 
-    return true;
+    return fout.good();
 }
 
 void cpp::write(std::ostream& out, const std::string& str) const
 {
+    auto literal = [&out, &str](std::size_t pos, std::size_t count, const char* suffix) {
+        out << "R\"(";
+        out.write(str.data() + pos, count);
+        out << ")\"" << suffix;
+    };
+
     std::size_t max_string_literal_length = 16360;
     if (str.size() > max_string_literal_length)
     {
@@ -93,29 +446,35 @@ void cpp::write(std::ostream& out, const std::string& str) const
             auto pos_previous_end_of_line = str.find_last_of("\n", n + max_string_literal_length);
             if (pos_previous_end_of_line > n)
             {
-                out << "R\"(" << str.substr(n, pos_previous_end_of_line + 1 - n) << ")\"\n";
+                literal(n, pos_previous_end_of_line + 1 - n, "\n");
                 n = pos_previous_end_of_line + 1;
             }
             else
             {
-                out << "R\"(" << str.substr(n, max_string_literal_length) << ")\" ";
+                literal(n, max_string_literal_length, " ");
                 n += max_string_literal_length;
             }
         }
 
         if (n < str.size())
         {
-            out << "R\"(" << str.substr(n, std::string::npos) << ")\"";
+            literal(n, str.size() - n, "");
         }
     }
     else
     {
-        out << "R\"(" << str << ")\"";
+        literal(0, str.size(), "");
     }
 }
 
 bool cpp::getFeatures(Features& features) const
 {
     features.extensionFeatureMap[".cpp"] = vsg::ReaderWriter::WRITE_FILENAME;
+    features.optionNameTypeMap[cpp::embed_mode] = vsg::type_name<std::string>();
     return true;
 }
+
+bool cpp::readOptions(vsg::Options& options, vsg::CommandLine& arguments) const
+{
+    return arguments.readAndAssign<std::string>(cpp::embed_mode, &options);
+}
@@ -10,14 +10,42 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <vsg/core/ConstVisitor.h>
+#include <vsg/io/Logger.h>
+#include <vsg/io/mem_stream.h>
 #include <vsg/io/read.h>
+#include <vsg/nodes/PagedLOD.h>
+#include <vsgXchange/cancellation.h>
 #include <vsgXchange/curl.h>
 
+#include "../all/content_type.h"
+
 #include <curl/curl.h>
 
+// the zstd decoder is always available, either vendored with libktx or from the full zstd library which also provides the encoder
+#ifdef vsgXchange_ktx_zstd
+#    include <zstd.h>
+#else
+#    include <ktx_zstd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <list>
+#include <map>
+#include <optional>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 using namespace vsgXchange;
 
@@ -57,15 +85,518 @@ namespace vsgXchange
         return {};
     }
 
+    /// resolve the URL to read, prepending the first entry in options->paths if that is a server address. Return true if the resolved serverFilename is a URL.
+    bool resolveServerFilename(const vsg::Path& filename, const vsg::Options* options, vsg::Path& serverFilename)
+    {
+        serverFilename = filename;
+        if (containsServerAddress(filename)) return true;
+
+        if (options && !options->paths.empty() && containsServerAddress(options->paths.front()))
+        {
+            serverFilename = options->paths.front() / filename;
+            return true;
+        }
+        return false;
+    }
+
+    /// HTTP cache validators and expiry time stored in a sidecar file next to each file cache entry.
+    struct CacheMetadata
+    {
+        std::string etag;
+        std::string lastModified;
+        int64_t expires = 0; // seconds since epoch, 0 when the server provided no max-age
+        bool noStore = false;
+
+        // response only Cache-Control directives, not stored in the sidecar file
+        bool noCache = false;
+        bool hasMaxAge = false;
+
+        bool hasValidators() const { return !etag.empty() || !lastModified.empty(); }
+    };
+
+    enum class CacheStatus
+    {
+        MISSING,
+        FRESH,
+        STALE
+    };
+
+    int64_t secondsSinceEpoch()
+    {
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    vsg::Path getCacheMetadataPath(const vsg::Path& fileCachePath)
+    {
+        return vsg::Path(fileCachePath.string() + ".http");
+    }
+
+    /// path of the zstd compressed form of a file cache entry, kept separate from the uncompressed path so other readers of the file cache never see compressed data.
+    vsg::Path getCompressedCachePath(const vsg::Path& fileCachePath)
+    {
+        return vsg::Path(fileCachePath.string() + ".zst");
+    }
+
+    /// read and decompress a zstd compressed file cache entry, return false if the file can't be read or isn't a complete zstd frame.
+    bool readCompressedFile(const vsg::Path& filename, std::vector<uint8_t>& data)
+    {
+        std::ifstream fin(filename, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!fin) return false;
+
+        std::vector<uint8_t> compressed(static_cast<size_t>(fin.tellg()));
+        fin.seekg(0);
+        fin.read(reinterpret_cast<char*>(compressed.data()), compressed.size());
+        if (!fin) return false;
+
+        // entries are written with ZSTD_compress() which records the content size in the frame header
+        auto contentSize = ZSTD_getFrameContentSize(compressed.data(), compressed.size());
+        if (contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize == ZSTD_CONTENTSIZE_ERROR) return false;
+
+        data.resize(static_cast<size_t>(contentSize));
+        auto size = ZSTD_decompress(data.data(), data.size(), compressed.data(), compressed.size());
+        if (ZSTD_isError(size) || size != data.size())
+        {
+            vsg::warn("vsgXchange::curl could not decompress file cache entry ", filename, ", ", ZSTD_isError(size) ? ZSTD_getErrorName(size) : "size mismatch");
+            return false;
+        }
+        return true;
+    }
+
+    /// return the zstd compression level used for file cache entries, 0 when they are stored uncompressed.
+    uint32_t cacheCompressionLevel(const vsg::Options* options)
+    {
+        uint32_t level = 0;
+        if (options) options->getValue(curl::CACHE_COMPRESSION, level);
+        return level;
+    }
+
+    bool readCacheMetadata(const vsg::Path& metadataPath, CacheMetadata& metadata)
+    {
+        std::ifstream fin(metadataPath);
+        if (!fin) return false;
+
+        std::string line;
+        while (std::getline(fin, line))
+        {
+            auto pos = line.find(' ');
+            if (pos == std::string::npos) continue;
+
+            auto key = line.substr(0, pos);
+            auto value = line.substr(pos + 1);
+            if (key == "ETag") metadata.etag = value;
+            else if (key == "Last-Modified") metadata.lastModified = value;
+            else if (key == "Expires")
+            {
+                // a corrupt or truncated value leaves the entry without an expiry, so it's revalidated rather than trusted
+                char* end = nullptr;
+                long long expires = std::strtoll(value.c_str(), &end, 10);
+                metadata.expires = (end != value.c_str() && *end == 0) ? expires : 0;
+            }
+        }
+        return true;
+    }
+
+    /// when the server gave neither a max-age nor an Expires time, apply the RFC 9111 heuristic of 10% of the time since the Last-Modified date, capped at a day.
+    /// Entries with just an ETag have no date to base a heuristic on, so they are revalidated on every access.
+    void applyHeuristicFreshness(CacheMetadata& metadata)
+    {
+        if (metadata.noCache)
+        {
+            metadata.expires = 0;
+            return;
+        }
+
+        if (metadata.expires != 0 || metadata.lastModified.empty()) return;
+
+        auto lastModified = static_cast<int64_t>(curl_getdate(metadata.lastModified.c_str(), nullptr));
+        auto now = secondsSinceEpoch();
+        if (lastModified <= 0 || lastModified >= now) return;
+
+        const int64_t maxHeuristicLifetime = 24 * 60 * 60;
+        auto lifetime = std::min((now - lastModified) / 10, maxHeuristicLifetime);
+        if (lifetime > 0) metadata.expires = now + lifetime;
+    }
+
+    std::string toString(const CacheMetadata& metadata)
+    {
+        std::ostringstream str;
+        if (!metadata.etag.empty()) str << "ETag " << metadata.etag << "\n";
+        if (!metadata.lastModified.empty()) str << "Last-Modified " << metadata.lastModified << "\n";
+        if (metadata.expires != 0) str << "Expires " << metadata.expires << "\n";
+        return str.str();
+    }
+
+    /// write to a temporary file and rename it into place so concurrent readers never see a partially written file.
+    bool writeFileAtomically(const vsg::Path& filename, const void* data, size_t size)
+    {
+        auto temporaryFilename = vsg::Path(vsg::make_string(filename.string(), ".", std::this_thread::get_id(), ".", std::chrono::steady_clock::now().time_since_epoch().count(), ".tmp"));
+        {
+            std::ofstream fout(temporaryFilename, std::ios::out | std::ios::binary);
+            if (!fout) return false;
+
+            fout.write(reinterpret_cast<const char*>(data), size);
+            if (!fout) return false;
+        }
+
+        if (std::rename(temporaryFilename.string().c_str(), filename.string().c_str()) != 0)
+        {
+            // Windows doesn't replace existing files on rename
+            std::remove(filename.string().c_str());
+            if (std::rename(temporaryFilename.string().c_str(), filename.string().c_str()) != 0)
+            {
+                std::remove(temporaryFilename.string().c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// check whether a file cache entry exists for serverFilename and whether it can be used as is, or needs revalidating with the server first.
+    CacheStatus getFileCacheStatus(const vsg::Path& serverFilename, const vsg::Options* options, CacheMetadata& metadata)
+    {
+        if (!options || !options->fileCache) return CacheStatus::MISSING;
+
+        auto fileCachePath = getFileCachePath(options->fileCache, serverFilename);
+        if (!vsg::fileExists(fileCachePath) && !vsg::fileExists(getCompressedCachePath(fileCachePath))) return CacheStatus::MISSING;
+
+        bool revalidate = true;
+        options->getValue(curl::CACHE_REVALIDATE, revalidate);
+
+        // entries written without validators, or by earlier versions of vsgXchange, can't be revalidated so are used as is.
+        if (!revalidate || !readCacheMetadata(getCacheMetadataPath(fileCachePath), metadata) || !metadata.hasValidators()) return CacheStatus::FRESH;
+
+        if (metadata.expires != 0 && secondsSinceEpoch() < metadata.expires) return CacheStatus::FRESH;
+
+        return CacheStatus::STALE;
+    }
+
+    /// return true if the filename's extension is listed in the curl::DEFER_EXTENSIONS option, leaving the read to another ReaderWriter such as one using HTTP range requests to fetch just the parts of the file required.
+    bool deferToOtherReaderWriters(const vsg::Path& filename, const vsg::Options* options)
+    {
+        std::string deferExtensions;
+        if (!options || !options->getValue(curl::DEFER_EXTENSIONS, deferExtensions) || deferExtensions.empty()) return false;
+
+        auto ext = vsg::lowerCaseFileExtension(filename).string();
+        if (ext.empty()) return false;
+
+        std::string lowerCaseExtensions;
+        for (auto c : deferExtensions) lowerCaseExtensions.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+
+        // match whole entries of the comma or space separated list
+        std::string::size_type pos = 0;
+        while ((pos = lowerCaseExtensions.find(ext, pos)) != std::string::npos)
+        {
+            auto end = pos + ext.size();
+            bool startOfEntry = (pos == 0 || lowerCaseExtensions[pos - 1] == ',' || lowerCaseExtensions[pos - 1] == ' ');
+            bool endOfEntry = (end == lowerCaseExtensions.size() || lowerCaseExtensions[end] == ',' || lowerCaseExtensions[end] == ' ');
+            if (startOfEntry && endOfEntry) return true;
+            pos = end;
+        }
+        return false;
+    }
+
+    /// return true if options enable the background download of PagedLOD children.
+    bool prefetchEnabled(const vsg::Options* options)
+    {
+        bool prefetch = false;
+        return options && options->getValue(curl::PREFETCH, prefetch) && prefetch;
+    }
+
+    /// collect the URLs of the PagedLOD children of a loaded subgraph, relative filenames are resolved against the PagedLOD::options paths, or the URL of the file the subgraph was read from.
+    struct CollectPagedLODFilenames : public vsg::ConstVisitor
+    {
+        vsg::Path parentFilename;
+        std::vector<vsg::Path> children;
+        std::set<vsg::Path> visited;
+
+        void apply(const vsg::Node& node) override
+        {
+            node.traverse(*this);
+        }
+
+        void apply(const vsg::PagedLOD& plod) override
+        {
+            if (plod.filename)
+            {
+                vsg::Path serverFilename;
+                if (!resolveServerFilename(plod.filename, plod.options.get(), serverFilename) && !plod.options)
+                {
+                    serverFilename = vsg::filePath(parentFilename) / plod.filename;
+                }
+
+                if (containsServerAddress(serverFilename) && visited.insert(serverFilename).second)
+                {
+                    children.push_back(serverFilename);
+                }
+            }
+
+            plod.traverse(*this);
+        }
+    };
+
+    /// parse data downloaded from filename, using the Content-Type or magic number to identify the format when the URL has no extension.
+    vsg::ref_ptr<vsg::Object> parseDownload(const vsg::Path& filename, const std::vector<uint8_t>& data, const std::string& contentType, vsg::ref_ptr<const vsg::Options> options)
+    {
+        auto local_options = vsg::clone(options);
+        local_options->paths.insert(local_options->paths.begin(), vsg::filePath(filename));
+        if (!local_options->extensionHint)
+        {
+            // prefer the format given by the Content-Type, or identified by the payload's magic number, as tile server URLs often have no extension
+            local_options->extensionHint = extensionFromContentType(contentType);
+            if (!local_options->extensionHint) local_options->extensionHint = extensionFromContents(data.data(), data.size());
+            if (!local_options->extensionHint) local_options->extensionHint = vsg::lowerCaseFileExtension(filename);
+        }
+
+        auto object = vsg::read(data.data(), data.size(), local_options);
+        if (!object)
+        {
+            // fallback to istream path for ReaderWriters that don't support reading from memory
+            vsg::mem_stream stream(data.data(), data.size());
+            object = vsg::read(stream, local_options);
+        }
+        return object;
+    }
+
+    /// read the local copy of serverFilename if one exists in options->fileCache, return null if no file cache entry is available.
+    vsg::ref_ptr<vsg::Object> readFromFileCache(const vsg::Path& filename, const vsg::Path& serverFilename, vsg::ref_ptr<const vsg::Options> options)
+    {
+        if (!options || !options->fileCache) return {};
+
+        auto fileCachePath = getFileCachePath(options->fileCache, serverFilename);
+        if (!vsg::fileExists(fileCachePath))
+        {
+            // fall back to the zstd compressed form of the entry
+            std::vector<uint8_t> data;
+            if (!readCompressedFile(getCompressedCachePath(fileCachePath), data)) return {};
+
+            auto local_options = vsg::clone(options);
+            local_options->paths.insert(local_options->paths.begin(), vsg::filePath(serverFilename));
+            local_options->extensionHint = vsg::lowerCaseFileExtension(filename);
+
+            auto object = vsg::read(data.data(), data.size(), local_options);
+            if (!object)
+            {
+                vsg::mem_stream stream(data.data(), data.size());
+                object = vsg::read(stream, local_options);
+            }
+            return object;
+        }
+
+        auto local_options = vsg::clone(options);
+
+        local_options->paths.insert(local_options->paths.begin(), vsg::filePath(serverFilename));
+        local_options->extensionHint = vsg::lowerCaseFileExtension(filename);
+
+        std::ifstream fin(fileCachePath, std::ios::in | std::ios::binary);
+        return vsg::read(fin, local_options); // do we need to remove any http URL?
+    }
+
+    /// contiguous download buffer, reserved from the Content-Length of the response when available so the payload is written once and passed directly to the memory read path.
+    struct DownloadBuffer
+    {
+        CURL* handle = nullptr;
+        bool reserved = false;
+        std::vector<uint8_t> data;
+
+        // validators sent with a conditional request, and the cache related headers returned by the server
+        bool revalidating = false;
+        curl_slist* requestHeaders = nullptr;
+        CacheMetadata responseHeaders;
+        std::string contentType;
+
+        // token of the read polled by the progress callback, so a cancelled read aborts the transfer
+        vsg::ref_ptr<const CancellationToken> cancellation;
+
+        ~DownloadBuffer()
+        {
+            if (requestHeaders) curl_slist_free_all(requestHeaders);
+        }
+    };
+
     class curl::Implementation
     {
     public:
-        Implementation();
+        explicit Implementation(const curl& readerWriter);
         virtual ~Implementation();
 
-        vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const;
+        /// read filename from the server, if validators is non null a conditional request is made and a 304 Not Modified response reuses the file cache entry.
+        /// concurrent reads of the same filename with equivalent options are coalesced so that only one transfer is made, with all the callers sharing the resulting object.
+        /// if the leading read is cancelled, one of the waiting reads that hasn't been cancelled retries the transfer.
+        vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options, const CacheMetadata* validators) const;
+
+        /// queue filename to be downloaded by the curl_multi thread, the returned future completes the parsing of the downloaded data in the thread that calls get().
+        /// the readerWriter is kept referenced by the returned future so that it remains valid until the parsing is completed.
+        std::future<vsg::ref_ptr<vsg::Object>> readAsync(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options, const CacheMetadata* validators, vsg::ref_ptr<const vsg::Object> readerWriter) const;
+
+        /// take an easy handle from the pool, creating a new one if the pool is empty.
+        CURL* acquireHandle(bool shareConnections) const;
+
+        /// reset the easy handle and return it to the pool so its live connections can be reused, or clean it up if the pool is full.
+        void releaseHandle(CURL* handle, uint32_t poolSize) const;
+
+        /// queue the PagedLOD children of the subgraph read from filename to be downloaded by the prefetch thread, if enabled by the curl::PREFETCH option.
+        /// children already in the file cache, in the prefetch cache or being read are skipped.
+        void prefetchChildren(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const;
+
+        /// return true if the in memory prefetch cache holds the data for filename.
+        bool hasPrefetched(const vsg::Path& filename) const;
+
+        /// parse and remove the data for filename from the in memory prefetch cache, return null if there is no entry.
+        vsg::ref_ptr<vsg::Object> readPrefetched(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const;
+
+        /// discard the queued prefetch requests and abort the prefetch transfers in progress.
+        void cancelPrefetch() const;
 
     protected:
+        struct Transfer
+        {
+            vsg::Path filename;
+            vsg::ref_ptr<const vsg::Options> options;
+            uint32_t handlePoolSize = 16;
+            CURL* handle = nullptr;
+            DownloadBuffer buffer;
+            CURLcode result = CURLE_OK;
+            std::promise<void> completed;
+            std::shared_future<void> completion;
+
+            // key of the _inFlight entry of this transfer, empty if it isn't coalesced
+            std::string inFlightKey;
+
+            // parsed once by whichever of the coalesced callers gets the result first
+            std::once_flag parsed;
+            vsg::ref_ptr<vsg::Object> object;
+
+            ~Transfer()
+            {
+                if (handle) curl_easy_cleanup(handle);
+            }
+        };
+
+        vsg::ref_ptr<vsg::Object> readFromServer(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options, const CacheMetadata* validators) const;
+
+        /// result of an in flight read shared with the coalesced callers, leaderCancelled is set when the read was abandoned because its CancellationToken was cancelled.
+        struct InFlightResult
+        {
+            vsg::ref_ptr<vsg::Object> object;
+            bool leaderCancelled = false;
+        };
+        using InFlightRead = std::shared_future<InFlightResult>;
+
+        /// return the key used to coalesce reads of filename, built from the filename, the Options hints and the identity of the Options values other than the CancellationToken.
+        std::string inFlightKey(const vsg::Path& filename, const vsg::Options* options) const;
+
+        /// return true if there is an in flight read of filename, with any options.
+        bool isInFlight(const vsg::Path& filename) const;
+
+        /// wait for the async transfer to complete and parse its data, only the first caller parses with the others sharing its object.
+        vsg::ref_ptr<vsg::Object> completeTransfer(Transfer& transfer) const;
+
+        void setupHandle(CURL* handle, const vsg::Path& filename, DownloadBuffer& buffer, const vsg::Options* options, const CacheMetadata* validators) const;
+        vsg::ref_ptr<vsg::Object> processResponse(CURL* handle, CURLcode result, const vsg::Path& filename, DownloadBuffer& buffer, vsg::ref_ptr<const vsg::Options> options) const;
+
+        void startMultiThread() const;
+        void runMulti() const;
+
+        /// accumulate the timings of the completed transfer into the ReaderWriter's Statistics, and optionally assign them to the object.
+        void recordTransfer(CURL* handle, bool succeeded, vsg::Object* object, const vsg::Options* options) const;
+
+        /// file cache entry to be written by the background cache writer thread, an empty data with writeData false just refreshes the metadata sidecar.
+        struct CacheWrite
+        {
+            vsg::Path fileCachePath;
+            bool writeData = true;
+            uint32_t compressionLevel = 0; // zstd level, 0 to write the data uncompressed
+            std::vector<uint8_t> data;
+            CacheMetadata metadata;
+        };
+
+        void queueCacheWrite(CacheWrite&& cacheWrite) const;
+        void runCacheWriter() const;
+
+        struct PrefetchRequest
+        {
+            vsg::Path filename;
+            vsg::ref_ptr<const vsg::Options> options;
+        };
+
+        struct PrefetchTransfer
+        {
+            PrefetchRequest request;
+            uint32_t handlePoolSize = 16;
+            CURL* handle = nullptr;
+            DownloadBuffer buffer;
+            std::atomic_bool abandoned{false};
+        };
+
+        struct PrefetchedData
+        {
+            vsg::Path filename;
+            std::vector<uint8_t> data;
+            std::string contentType;
+        };
+
+        /// called before a foreground read is transferred, removing filename from the prefetch queue and aborting its prefetch transfer so the foreground read isn't slowed by the prefetch bandwidth limit.
+        void abandonPrefetch(const vsg::Path& filename) const;
+
+        /// decrement the count of foreground transfers, waking the prefetch thread once there are none in progress.
+        void foregroundTransferCompleted() const;
+
+        void runPrefetch() const;
+        std::shared_ptr<PrefetchTransfer> startPrefetch(PrefetchRequest&& request, CURLM* multi, uint64_t bandwidth) const;
+        void completePrefetch(PrefetchTransfer& transfer, CURLcode result) const;
+        void storePrefetched(PrefetchedData&& prefetched, uint64_t maxSize) const;
+
+        static int prefetchProgress(void* user_data, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow);
+
+        static void lockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+        static void unlockShare(CURL* handle, curl_lock_data data, void* userptr);
+
+        const curl& _readerWriter;
+
+        CURLSH* _share = nullptr;
+        std::mutex _shareMutexes[CURL_LOCK_DATA_LAST];
+
+        mutable std::mutex _handlePoolMutex;
+        mutable std::vector<CURL*> _handlePool;
+
+        // curl_multi state, the multi handle and active transfers are only accessed from the _multiThread.
+        mutable std::mutex _multiMutex;
+        mutable CURLM* _multi = nullptr;
+        mutable std::thread _multiThread;
+        mutable std::atomic_bool _multiActive{false};
+        mutable std::vector<std::shared_ptr<Transfer>> _pendingTransfers;
+        mutable std::map<CURL*, std::shared_ptr<Transfer>> _activeTransfers;
+
+        // single-flight map of the reads currently in progress, keyed on inFlightKey()
+        mutable std::mutex _inFlightMutex;
+        mutable std::map<std::string, InFlightRead> _inFlight;
+
+        // background file cache writer, pending writes are keyed on the cache path so repeated writes of the same entry are merged.
+        mutable std::mutex _cacheWriteMutex;
+        mutable std::condition_variable _cacheWriteCondition;
+        mutable std::map<vsg::Path, CacheWrite> _pendingCacheWrites;
+        mutable std::thread _cacheWriteThread;
+        mutable bool _cacheWriteActive = false;
+        mutable bool _cacheCompressionWarned = false;
+
+        // number of blocking and async reads being transferred, prefetch transfers are only started while there are none.
+        mutable std::atomic_uint32_t _foregroundTransfers{0};
+
+        // prefetch queue, the most recently requested children are at the front so the tiles near the current view are fetched first.
+        mutable std::mutex _prefetchMutex;
+        mutable std::condition_variable _prefetchCondition;
+        mutable std::deque<PrefetchRequest> _prefetchQueue;
+        mutable std::set<vsg::Path> _prefetchQueued;
+        mutable std::map<vsg::Path, std::shared_ptr<PrefetchTransfer>> _prefetchTransfers;
+        mutable uint32_t _prefetchMaxTransfers = 2;
+        mutable std::thread _prefetchThread;
+        mutable bool _prefetchActive = false;
+
+        // in memory cache of prefetched data used when there is no file cache, least recently prefetched entries are at the back and evicted first.
+        mutable std::mutex _prefetchedMutex;
+        mutable std::list<PrefetchedData> _prefetched;
+        mutable std::map<vsg::Path, std::list<PrefetchedData>::iterator> _prefetchedIndex;
+        mutable uint64_t _prefetchedSize = 0;
     };
 
 } // namespace vsgXchange
@@ -84,54 +615,102 @@ curl::~curl()
 }
 vsg::ref_ptr<vsg::Object> curl::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
 {
-    vsg::Path serverFilename = filename;
-
-    bool contains_serverAddress = containsServerAddress(filename);
+    vsg::Path serverFilename;
+    if (!resolveServerFilename(filename, options.get(), serverFilename)) return {};
+    if (deferToOtherReaderWriters(serverFilename, options.get())) return {};
 
-    if (options)
+    CacheMetadata validators;
+    auto cacheStatus = getFileCacheStatus(serverFilename, options.get(), validators);
+    if (cacheStatus == CacheStatus::FRESH)
     {
-        if (!contains_serverAddress && !options->paths.empty())
+        if (auto object = readFromFileCache(filename, serverFilename, options))
         {
-            contains_serverAddress = containsServerAddress(options->paths.front());
-            if (contains_serverAddress)
             {
-                serverFilename = options->paths.front() / filename;
+                std::scoped_lock<std::mutex> lock(_statisticsMutex);
+                ++_statistics.numCacheHits;
             }
+
+            if (prefetchEnabled(options.get())) getImplementation()->prefetchChildren(object, serverFilename, options);
+            return object;
         }
+    }
 
-        if (contains_serverAddress && options->fileCache)
-        {
-            auto fileCachePath = getFileCachePath(options->fileCache, serverFilename);
-            if (vsg::fileExists(fileCachePath))
-            {
-                auto local_options = vsg::clone(options);
+    if (cacheStatus == CacheStatus::MISSING && options && options->fileCache)
+    {
+        std::scoped_lock<std::mutex> lock(_statisticsMutex);
+        ++_statistics.numCacheMisses;
+    }
 
-                local_options->paths.insert(local_options->paths.begin(), vsg::filePath(serverFilename));
-                local_options->extensionHint = vsg::lowerCaseFileExtension(filename);
+    auto implementation = getImplementation();
+    if (prefetchEnabled(options.get()))
+    {
+        if (auto object = implementation->readPrefetched(serverFilename, options)) return object;
+    }
 
-                std::ifstream fin(fileCachePath, std::ios::in | std::ios::binary);
-                auto object = vsg::read(fin, local_options); // do we need to remove any http URL?
-                if (object)
-                {
-                    return object;
-                }
-            }
-        }
+    return implementation->read(serverFilename, options, (cacheStatus == CacheStatus::STALE) ? &validators : nullptr);
+}
+
+std::future<vsg::ref_ptr<vsg::Object>> curl::readAsync(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    vsg::Path serverFilename;
+    if (!resolveServerFilename(filename, options.get(), serverFilename) || deferToOtherReaderWriters(serverFilename, options.get()))
+    {
+        std::promise<vsg::ref_ptr<vsg::Object>> promise;
+        promise.set_value({});
+        return promise.get_future();
     }
 
-    if (contains_serverAddress)
+    CacheMetadata validators;
+    auto cacheStatus = getFileCacheStatus(serverFilename, options.get(), validators);
+    if (cacheStatus == CacheStatus::FRESH || (prefetchEnabled(options.get()) && getImplementation()->hasPrefetched(serverFilename)))
     {
-        {
-            std::scoped_lock<std::mutex> lock(_mutex);
-            if (!_implementation) _implementation = new curl::Implementation();
-        }
+        vsg::ref_ptr<const curl> rw(this);
+        return std::async(std::launch::deferred, [rw, filename, options]() { return rw->read(filename, options); });
+    }
 
-        return _implementation->read(serverFilename, options);
+    if (cacheStatus == CacheStatus::MISSING && options && options->fileCache)
+    {
+        std::scoped_lock<std::mutex> lock(_statisticsMutex);
+        ++_statistics.numCacheMisses;
     }
-    else
+
+    return getImplementation()->readAsync(serverFilename, options, (cacheStatus == CacheStatus::STALE) ? &validators : nullptr, vsg::ref_ptr<const vsg::Object>(this));
+}
+
+std::vector<std::future<vsg::ref_ptr<vsg::Object>>> curl::readAsync(const vsg::Paths& filenames, vsg::ref_ptr<const vsg::Options> options) const
+{
+    std::vector<std::future<vsg::ref_ptr<vsg::Object>>> results;
+    results.reserve(filenames.size());
+    for (auto& filename : filenames)
     {
-        return {};
+        results.push_back(readAsync(filename, options));
     }
+    return results;
+}
+
+curl::Implementation* curl::getImplementation() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    if (!_implementation) _implementation = new curl::Implementation(*this);
+    return _implementation;
+}
+
+void curl::cancelPrefetch() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    if (_implementation) _implementation->cancelPrefetch();
+}
+
+curl::Statistics curl::getStatistics() const
+{
+    std::scoped_lock<std::mutex> lock(_statisticsMutex);
+    return _statistics;
+}
+
+void curl::resetStatistics()
+{
+    std::scoped_lock<std::mutex> lock(_statisticsMutex);
+    _statistics = {};
 }
 
 bool curl::getFeatures(Features& features) const
@@ -139,6 +718,19 @@ bool curl::getFeatures(Features& features) const
     features.protocolFeatureMap["http"] = vsg::ReaderWriter::READ_FILENAME;
     features.protocolFeatureMap["https"] = vsg::ReaderWriter::READ_FILENAME;
     features.optionNameTypeMap[curl::SSL_OPTIONS] = "uint32_t";
+    features.optionNameTypeMap[curl::SHARE_CONNECTIONS] = "bool";
+    features.optionNameTypeMap[curl::HANDLE_POOL_SIZE] = "uint32_t";
+    features.optionNameTypeMap[curl::CACHE_REVALIDATE] = "bool";
+    features.optionNameTypeMap[curl::COALESCE_REQUESTS] = "bool";
+    features.optionNameTypeMap[curl::TRANSFER_METADATA] = "bool";
+    features.optionNameTypeMap[curl::ACCEPT_ENCODING] = vsg::type_name<std::string>();
+    features.optionNameTypeMap[curl::CACHE_COMPRESSION] = "uint32_t";
+    features.optionNameTypeMap[curl::DEFER_EXTENSIONS] = vsg::type_name<std::string>();
+    features.optionNameTypeMap[curl::PREFETCH] = "bool";
+    features.optionNameTypeMap[curl::PREFETCH_BANDWIDTH] = "uint64_t";
+    features.optionNameTypeMap[curl::PREFETCH_MAX_TRANSFERS] = "uint32_t";
+    features.optionNameTypeMap[curl::PREFETCH_MAX_PENDING] = "uint32_t";
+    features.optionNameTypeMap[curl::PREFETCH_MEMORY_CACHE] = "uint64_t";
     return true;
 }
 
@@ -152,7 +744,8 @@ bool curl::s_do_curl_global_init_and_cleanup = true;
 std::mutex s_curlImplementationMutex;
 uint32_t s_curlImplementationCount = 0;
 
-curl::Implementation::Implementation()
+curl::Implementation::Implementation(const curl& readerWriter) :
+    _readerWriter(readerWriter)
 {
     if (curl::s_do_curl_global_init_and_cleanup)
     {
@@ -164,10 +757,81 @@ curl::Implementation::Implementation()
         }
         ++s_curlImplementationCount;
     }
+
+    // share DNS, TLS session and connection caches between all the easy handles used by this ReaderWriter
+    _share = curl_share_init();
+    if (_share)
+    {
+        curl_share_setopt(_share, CURLSHOPT_LOCKFUNC, lockShare);
+        curl_share_setopt(_share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+        curl_share_setopt(_share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+    }
 }
 
 curl::Implementation::~Implementation()
 {
+    // stop the prefetch thread first as it queues file cache writes, the prefetch transfers in progress are abandoned
+    if (_prefetchThread.joinable())
+    {
+        {
+            std::scoped_lock<std::mutex> lock(_prefetchMutex);
+            _prefetchActive = false;
+        }
+        _prefetchCondition.notify_all();
+        _prefetchThread.join();
+    }
+
+    // finish writing any outstanding file cache entries
+    if (_cacheWriteThread.joinable())
+    {
+        {
+            std::scoped_lock<std::mutex> lock(_cacheWriteMutex);
+            _cacheWriteActive = false;
+        }
+        _cacheWriteCondition.notify_all();
+        _cacheWriteThread.join();
+    }
+
+    if (_multiThread.joinable())
+    {
+        _multiActive = false;
+#if LIBCURL_VERSION_NUM >= 0x074400
+        curl_multi_wakeup(_multi);
+#endif
+        _multiThread.join();
+    }
+
+    // release any transfers that didn't get the chance to complete
+    for (auto& [handle, transfer] : _activeTransfers)
+    {
+        curl_multi_remove_handle(_multi, handle);
+        transfer->result = CURLE_ABORTED_BY_CALLBACK;
+        transfer->completed.set_value();
+    }
+    _activeTransfers.clear();
+
+    for (auto& transfer : _pendingTransfers)
+    {
+        transfer->result = CURLE_ABORTED_BY_CALLBACK;
+        transfer->completed.set_value();
+    }
+    _pendingTransfers.clear();
+
+    if (_multi) curl_multi_cleanup(_multi);
+
+    for (auto handle : _handlePool)
+    {
+        curl_easy_cleanup(handle);
+    }
+    _handlePool.clear();
+
+    if (_share) curl_share_cleanup(_share);
+
     if (s_do_curl_global_init_and_cleanup)
     {
         std::scoped_lock<std::mutex> lock(s_curlImplementationMutex);
@@ -180,89 +844,1012 @@ curl::Implementation::~Implementation()
     }
 }
 
-size_t StreamCallback(void* ptr, size_t size, size_t nmemb, void* user_data)
+void curl::Implementation::lockShare(CURL* /*handle*/, curl_lock_data data, curl_lock_access /*access*/, void* userptr)
 {
-    size_t realsize = size * nmemb;
-
-    if (user_data)
-    {
-        std::ostream* ostr = reinterpret_cast<std::ostream*>(user_data);
-        ostr->write(reinterpret_cast<const char*>(ptr), realsize);
-    }
-
-    return realsize;
+    auto implementation = reinterpret_cast<curl::Implementation*>(userptr);
+    implementation->_shareMutexes[data].lock();
 }
 
-vsg::ref_ptr<vsg::Object> curl::Implementation::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+void curl::Implementation::unlockShare(CURL* /*handle*/, curl_lock_data data, void* userptr)
 {
-    auto _curl = curl_easy_init();
+    auto implementation = reinterpret_cast<curl::Implementation*>(userptr);
+    implementation->_shareMutexes[data].unlock();
+}
 
-    curl_easy_setopt(_curl, CURLOPT_USERAGENT, "libcurl-agent/1.0"); // make user controllable?
-    curl_easy_setopt(_curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(_curl, CURLOPT_WRITEFUNCTION, StreamCallback);
+CURL* curl::Implementation::acquireHandle(bool shareConnections) const
+{
+    CURL* handle = nullptr;
+    {
+        std::scoped_lock<std::mutex> lock(_handlePoolMutex);
+        if (!_handlePool.empty())
+        {
+            handle = _handlePool.back();
+            _handlePool.pop_back();
+        }
+    }
+
+    if (!handle) handle = curl_easy_init();
+
+    if (handle && shareConnections && _share) curl_easy_setopt(handle, CURLOPT_SHARE, _share);
+
+    return handle;
+}
+
+void curl::Implementation::releaseHandle(CURL* handle, uint32_t poolSize) const
+{
+    if (!handle) return;
+
+    // curl_easy_reset() clears all options set on the handle but retains live connections, the session ID cache and DNS cache.
+    curl_easy_reset(handle);
+
+    {
+        std::scoped_lock<std::mutex> lock(_handlePoolMutex);
+        if (_handlePool.size() < poolSize)
+        {
+            _handlePool.push_back(handle);
+            return;
+        }
+    }
+
+    curl_easy_cleanup(handle);
+}
+
+int ProgressCallback(void* user_data, curl_off_t /*dltotal*/, curl_off_t /*dlnow*/, curl_off_t /*ultotal*/, curl_off_t /*ulnow*/)
+{
+    // returning non zero aborts the transfer with CURLE_ABORTED_BY_CALLBACK
+    auto buffer = reinterpret_cast<DownloadBuffer*>(user_data);
+    return (buffer && buffer->cancellation && buffer->cancellation->cancelled()) ? 1 : 0;
+}
+
+size_t BufferCallback(void* ptr, size_t size, size_t nmemb, void* user_data)
+{
+    size_t realsize = size * nmemb;
+
+    if (user_data)
+    {
+        DownloadBuffer* buffer = reinterpret_cast<DownloadBuffer*>(user_data);
+        if (!buffer->reserved)
+        {
+            // headers have been processed by the time the first body data arrives so use the Content-Length to size the buffer up front.
+            curl_off_t contentLength = -1;
+            if (curl_easy_getinfo(buffer->handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength) == CURLE_OK && contentLength > 0)
+            {
+                buffer->data.reserve(static_cast<size_t>(contentLength));
+            }
+            buffer->reserved = true;
+        }
+
+        auto data = reinterpret_cast<const uint8_t*>(ptr);
+        buffer->data.insert(buffer->data.end(), data, data + realsize);
+    }
+
+    return realsize;
+}
+
+size_t HeaderCallback(char* ptr, size_t size, size_t nitems, void* user_data)
+{
+    size_t realsize = size * nitems;
+
+    if (user_data)
+    {
+        DownloadBuffer* buffer = reinterpret_cast<DownloadBuffer*>(user_data);
+        CacheMetadata& headers = buffer->responseHeaders;
+
+        std::string line(ptr, realsize);
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) line.pop_back();
+
+        // each response in a redirect chain starts with a status line, only keep the headers from the final response
+        if (line.compare(0, 5, "HTTP/") == 0)
+        {
+            headers = {};
+            buffer->contentType.clear();
+            return realsize;
+        }
+
+        auto pos = line.find(':');
+        if (pos == std::string::npos) return realsize;
+
+        std::string key = line.substr(0, pos);
+        auto value_pos = line.find_first_not_of(' ', pos + 1);
+        std::string value = (value_pos != std::string::npos) ? line.substr(value_pos) : std::string();
+        for (auto& c : key) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+        if (key == "etag")
+        {
+            headers.etag = value;
+        }
+        else if (key == "content-type")
+        {
+            buffer->contentType = value;
+        }
+        else if (key == "last-modified")
+        {
+            headers.lastModified = value;
+        }
+        else if (key == "cache-control")
+        {
+            if (value.find("no-store") != std::string::npos) headers.noStore = true;
+            if (value.find("no-cache") != std::string::npos) headers.noCache = true;
+
+            auto max_age_pos = value.find("max-age=");
+            if (max_age_pos != std::string::npos)
+            {
+                int64_t max_age = std::atoll(value.c_str() + max_age_pos + 8);
+                headers.hasMaxAge = true;
+                headers.expires = (max_age > 0) ? secondsSinceEpoch() + max_age : 0;
+            }
+        }
+        else if (key == "expires")
+        {
+            // max-age takes precedence over Expires
+            if (!headers.hasMaxAge)
+            {
+                auto expires = static_cast<int64_t>(curl_getdate(value.c_str(), nullptr));
+                if (expires > 0) headers.expires = expires;
+            }
+        }
+    }
+
+    return realsize;
+}
+
+void curl::Implementation::setupHandle(CURL* handle, const vsg::Path& filename, DownloadBuffer& buffer, const vsg::Options* options, const CacheMetadata* validators) const
+{
+    buffer.handle = handle;
+
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(handle, CURLOPT_HEADERDATA, (void*)&buffer);
+
+    if (validators)
+    {
+        if (!validators->etag.empty()) buffer.requestHeaders = curl_slist_append(buffer.requestHeaders, ("If-None-Match: " + validators->etag).c_str());
+        if (!validators->lastModified.empty()) buffer.requestHeaders = curl_slist_append(buffer.requestHeaders, ("If-Modified-Since: " + validators->lastModified).c_str());
+        if (buffer.requestHeaders)
+        {
+            curl_easy_setopt(handle, CURLOPT_HTTPHEADER, buffer.requestHeaders);
+            buffer.revalidating = true;
+        }
+    }
+
+    curl_easy_setopt(handle, CURLOPT_USERAGENT, "libcurl-agent/1.0"); // make user controllable?
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+
+    // an empty string requests all the encodings built into libcurl, typically gzip, deflate, br and zstd, with the response decoded before it reaches BufferCallback
+    std::string acceptEncoding;
+    if (options) options->getValue(curl::ACCEPT_ENCODING, acceptEncoding);
+    curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, acceptEncoding.c_str());
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, BufferCallback);
 
-    std::stringstream sstr;
+    curl_easy_setopt(handle, CURLOPT_URL, filename.string().c_str());
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, (void*)&buffer);
 
-    curl_easy_setopt(_curl, CURLOPT_URL, filename.string().c_str());
-    curl_easy_setopt(_curl, CURLOPT_WRITEDATA, (void*)&sstr);
+    // handles are reused, so always set whether progress is reported
+    buffer.cancellation = getCancellationToken(options);
+    if (buffer.cancellation)
+    {
+        curl_easy_setopt(handle, CURLOPT_XFERINFOFUNCTION, ProgressCallback);
+        curl_easy_setopt(handle, CURLOPT_XFERINFODATA, (void*)&buffer);
+        curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0L);
+    }
+    else
+    {
+        curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 1L);
+    }
 
     uint32_t sslOptions = 0;
 #if defined(_WIN32) && defined(CURLSSLOPT_NATIVE_CA)
     sslOptions |= CURLSSLOPT_NATIVE_CA;
 #endif
     if (options) options->getValue(curl::SSL_OPTIONS, sslOptions);
-    if (sslOptions != 0) curl_easy_setopt(_curl, CURLOPT_SSL_OPTIONS, sslOptions);
+    if (sslOptions != 0) curl_easy_setopt(handle, CURLOPT_SSL_OPTIONS, sslOptions);
+}
 
+vsg::ref_ptr<vsg::Object> curl::Implementation::processResponse(CURL* handle, CURLcode result, const vsg::Path& filename, DownloadBuffer& buffer, vsg::ref_ptr<const vsg::Options> options) const
+{
     vsg::ref_ptr<vsg::Object> object;
 
-    CURLcode result = curl_easy_perform(_curl);
     if (result == 0)
     {
         // https://developer.mozilla.org/en-US/docs/Web/HTTP/Status
         long response_code = 0;
-        result = curl_easy_getinfo(_curl, CURLINFO_RESPONSE_CODE, &response_code);
+        result = curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response_code);
 
-        if (result == 0 && response_code >= 200 && response_code<300) // successful responses.
+        if (result == 0 && response_code == 304 && buffer.revalidating) // not modified, so reuse the file cache entry
         {
-            // success
-            auto local_options = vsg::clone(options);
-            local_options->paths.insert(local_options->paths.begin(), vsg::filePath(filename));
-            if (!local_options->extensionHint)
+            object = readFromFileCache(filename, filename, options);
+            if (object)
             {
-                local_options->extensionHint = vsg::lowerCaseFileExtension(filename);
-            }
+                {
+                    std::scoped_lock<std::mutex> lock(_readerWriter._statisticsMutex);
+                    ++_readerWriter._statistics.numCacheRevalidations;
+                }
 
-            object = vsg::read(sstr, local_options);
+                CacheWrite cacheWrite;
+                cacheWrite.fileCachePath = getFileCachePath(options->fileCache, filename);
+                cacheWrite.writeData = false;
+                readCacheMetadata(getCacheMetadataPath(cacheWrite.fileCachePath), cacheWrite.metadata);
+                if (!buffer.responseHeaders.etag.empty()) cacheWrite.metadata.etag = buffer.responseHeaders.etag;
+                if (!buffer.responseHeaders.lastModified.empty()) cacheWrite.metadata.lastModified = buffer.responseHeaders.lastModified;
+                cacheWrite.metadata.expires = buffer.responseHeaders.expires;
+                cacheWrite.metadata.noCache = buffer.responseHeaders.noCache;
+                applyHeuristicFreshness(cacheWrite.metadata);
+                queueCacheWrite(std::move(cacheWrite));
+            }
+            else
+            {
+                object = vsg::ReadError::create(vsg::make_string("vsgXchange::curl could not read file cache entry for ", filename, " after 304 Not Modified response."));
+            }
+        }
+        else if (result == 0 && response_code >= 200 && response_code<300) // successful responses.
+        {
+            // success
+            object = parseDownload(filename, buffer.data, buffer.contentType, options);
 
-            if (object && options->fileCache)
+            if (object && options->fileCache && !buffer.responseHeaders.noStore)
             {
                 auto fileCachePath = getFileCachePath(options->fileCache, filename);
                 if (fileCachePath)
                 {
-                    vsg::makeDirectory(vsg::filePath(fileCachePath));
-
-                    // reset the stringstream iterator to the beginning so we can copy it to the file cache file.
-                    sstr.clear(std::stringstream::goodbit);
-                    sstr.seekg(0);
-
-                    std::ofstream fout(fileCachePath, std::ios::out | std::ios::binary);
-
-                    fout << sstr.rdbuf();
+                    // the object has been parsed so hand the downloaded data over to the cache writer rather than copying it.
+                    CacheWrite cacheWrite;
+                    cacheWrite.fileCachePath = fileCachePath;
+                    cacheWrite.compressionLevel = cacheCompressionLevel(options.get());
+                    cacheWrite.data = std::move(buffer.data);
+                    cacheWrite.metadata = buffer.responseHeaders;
+                    applyHeuristicFreshness(cacheWrite.metadata);
+                    queueCacheWrite(std::move(cacheWrite));
                 }
             }
 
         }
+        else if (buffer.revalidating && (object = readFromFileCache(filename, filename, options)))
+        {
+            // the server couldn't revalidate the entry, so fall back to the stale copy rather than failing the read
+            vsg::warn("vsgXchange::curl could not revalidate ", filename, ", CURLINFO_RESPONSE_CODE = ", response_code, ", using stale file cache entry.");
+        }
         else
         {
             object = vsg::ReadError::create(vsg::make_string("vsgXchange::curl could not read file ", filename, ", CURLINFO_RESPONSE_CODE = ", response_code));
         }
     }
+    else if (result == CURLE_ABORTED_BY_CALLBACK && buffer.cancellation && buffer.cancellation->cancelled())
+    {
+        // the read was abandoned, so there's no error to report
+        vsg::debug("vsgXchange::curl cancelled read of ", filename);
+    }
+    else if (buffer.revalidating && (object = readFromFileCache(filename, filename, options)))
+    {
+        // the server is unreachable, so fall back to the stale copy so that previously cached data remains usable offline
+        vsg::warn("vsgXchange::curl could not revalidate ", filename, ", result = ", result, ", ", curl_easy_strerror(result), ", using stale file cache entry.");
+    }
     else
     {
         object = vsg::ReadError::create(vsg::make_string("vsgXchange::curl could not read file ", filename, ", result = ", result, ", ",curl_easy_strerror(result)));
     }
 
-    if (_curl) curl_easy_cleanup(_curl);
+    bool succeeded = object && !object->is_compatible(typeid(vsg::ReadError));
+    if (succeeded) prefetchChildren(object, filename, options);
+
+    recordTransfer(handle, succeeded, object.get(), options.get());
+
+    return object;
+}
+
+void curl::Implementation::recordTransfer(CURL* handle, bool succeeded, vsg::Object* object, const vsg::Options* options) const
+{
+    // curl reports the times from the start of the transfer to the end of each phase in microseconds
+    curl_off_t namelookup = 0, connect = 0, appconnect = 0, starttransfer = 0, total = 0, size = 0;
+    curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME_T, &namelookup);
+    curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME_T, &appconnect);
+    curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME_T, &starttransfer);
+    curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD_T, &size);
+
+    const double microseconds = 1.0e-6;
+    double dnsTime = static_cast<double>(namelookup) * microseconds;
+    double connectTime = (connect > namelookup) ? static_cast<double>(connect - namelookup) * microseconds : 0.0;
+    double tlsTime = (appconnect > connect) ? static_cast<double>(appconnect - connect) * microseconds : 0.0;
+    double timeToFirstByte = static_cast<double>(starttransfer) * microseconds;
+    double totalTime = static_cast<double>(total) * microseconds;
+
+    {
+        std::scoped_lock<std::mutex> lock(_readerWriter._statisticsMutex);
+        auto& statistics = _readerWriter._statistics;
+        ++statistics.numTransfers;
+        if (!succeeded) ++statistics.numFailedTransfers;
+        statistics.bytesDownloaded += static_cast<uint64_t>(size);
+        statistics.dnsTime += dnsTime;
+        statistics.connectTime += connectTime;
+        statistics.tlsTime += tlsTime;
+        statistics.timeToFirstByte += timeToFirstByte;
+        statistics.totalTime += totalTime;
+    }
+
+    bool transferMetadata = false;
+    if (object && options && options->getValue(curl::TRANSFER_METADATA, transferMetadata) && transferMetadata)
+    {
+        object->setValue("curl_dns_time", dnsTime);
+        object->setValue("curl_connect_time", connectTime);
+        object->setValue("curl_tls_time", tlsTime);
+        object->setValue("curl_time_to_first_byte", timeToFirstByte);
+        object->setValue("curl_total_time", totalTime);
+        object->setValue("curl_bytes", static_cast<uint64_t>(size));
+    }
+}
+
+vsg::ref_ptr<vsg::Object> curl::Implementation::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options, const CacheMetadata* validators) const
+{
+    bool coalesceRequests = true;
+    if (options) options->getValue(curl::COALESCE_REQUESTS, coalesceRequests);
+
+    if (!coalesceRequests) return readFromServer(filename, options, validators);
+
+    auto key = inFlightKey(filename, options.get());
+    for (;;)
+    {
+        std::promise<InFlightResult> promise;
+        {
+            std::unique_lock<std::mutex> lock(_inFlightMutex);
+            auto itr = _inFlight.find(key);
+            if (itr != _inFlight.end())
+            {
+                // another thread is already reading this URL so wait on its result rather than issuing a second transfer
+                auto inFlight = itr->second;
+                lock.unlock();
+
+                auto result = inFlight.get();
+
+                // the leading read was abandoned, so unless this read has also been cancelled retry it, the first waiter to get here leads the new transfer
+                if (result.leaderCancelled && !cancelled(options.get())) continue;
+
+                return result.object;
+            }
+            _inFlight[key] = promise.get_future().share();
+        }
+
+        auto object = readFromServer(filename, options, validators);
+
+        {
+            std::scoped_lock<std::mutex> lock(_inFlightMutex);
+            _inFlight.erase(key);
+        }
+        promise.set_value(InFlightResult{object, cancelled(options.get())});
+
+        return object;
+    }
+}
+
+std::string curl::Implementation::inFlightKey(const vsg::Path& filename, const vsg::Options* options) const
+{
+    std::ostringstream key;
+    key << filename.string();
+    if (options)
+    {
+        key << '\n' << options->extensionHint.string() << '\n' << options->fileCache.string() << '\n' << options->mapRGBtoRGBAHint;
+
+        // the curl and ReaderWriter options are compared by identity, Options copied from one another share their values so still coalesce,
+        // while the CancellationToken is left out so that reads that only differ by token share the transfer.
+        if (auto auxiliary = options->getAuxiliary())
+        {
+            for (auto& [name, value] : auxiliary->userObjects)
+            {
+                if (name != cancellation_token) key << '\n' << name << '=' << static_cast<const void*>(value.get());
+            }
+        }
+    }
+    return key.str();
+}
+
+bool curl::Implementation::isInFlight(const vsg::Path& filename) const
+{
+    const auto& prefix = filename.string();
+
+    std::scoped_lock<std::mutex> lock(_inFlightMutex);
+    for (auto itr = _inFlight.lower_bound(prefix); itr != _inFlight.end() && itr->first.compare(0, prefix.size(), prefix) == 0; ++itr)
+    {
+        if (itr->first.size() == prefix.size() || itr->first[prefix.size()] == '\n') return true;
+    }
+    return false;
+}
+
+vsg::ref_ptr<vsg::Object> curl::Implementation::completeTransfer(Transfer& transfer) const
+{
+    transfer.completion.wait();
+
+    std::call_once(transfer.parsed, [&]() {
+        if (transfer.object) return;
+
+        transfer.object = processResponse(transfer.handle, transfer.result, transfer.filename, transfer.buffer, transfer.options);
+        releaseHandle(transfer.handle, transfer.handlePoolSize);
+        transfer.handle = nullptr;
+    });
+
+    return transfer.object;
+}
+
+vsg::ref_ptr<vsg::Object> curl::Implementation::readFromServer(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options, const CacheMetadata* validators) const
+{
+    bool shareConnections = true;
+    uint32_t handlePoolSize = 16;
+    if (options)
+    {
+        options->getValue(curl::SHARE_CONNECTIONS, shareConnections);
+        options->getValue(curl::HANDLE_POOL_SIZE, handlePoolSize);
+    }
+
+    auto _curl = acquireHandle(shareConnections);
+    if (!_curl) return vsg::ReadError::create(vsg::make_string("vsgXchange::curl could not create curl handle to read file ", filename));
+
+    DownloadBuffer buffer;
+    setupHandle(_curl, filename, buffer, options.get(), validators);
+
+    abandonPrefetch(filename);
+
+    ++_foregroundTransfers;
+    CURLcode result = curl_easy_perform(_curl);
+    foregroundTransferCompleted();
+
+    auto object = processResponse(_curl, result, filename, buffer, options);
+
+    releaseHandle(_curl, handlePoolSize);
+
+    return object;
+}
+
+std::future<vsg::ref_ptr<vsg::Object>> curl::Implementation::readAsync(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options, const CacheMetadata* validators, vsg::ref_ptr<const vsg::Object> readerWriter) const
+{
+    bool coalesceRequests = true;
+    if (options) options->getValue(curl::COALESCE_REQUESTS, coalesceRequests);
+
+    auto transfer = std::make_shared<Transfer>();
+    transfer->filename = filename;
+    transfer->options = options;
+    transfer->completion = transfer->completed.get_future().share();
+
+    if (coalesceRequests)
+    {
+        auto key = inFlightKey(filename, options.get());
+
+        std::scoped_lock<std::mutex> lock(_inFlightMutex);
+        auto itr = _inFlight.find(key);
+        if (itr != _inFlight.end())
+        {
+            // the validators are copied as the caller's are out of scope by the time the deferred get() might need to retry the read
+            std::optional<CacheMetadata> retryValidators;
+            if (validators) retryValidators = *validators;
+
+            auto inFlight = itr->second;
+            return std::async(std::launch::deferred, [this, readerWriter, inFlight, filename, options, retryValidators]() {
+                auto result = inFlight.get();
+                if (result.leaderCancelled && !cancelled(options.get())) return read(filename, options, retryValidators ? &(*retryValidators) : nullptr);
+                return result.object;
+            });
+        }
+
+        // register the transfer so that later reads share it, whichever of the callers gets the result first does the parsing
+        transfer->inFlightKey = key;
+        auto inFlight = std::async(std::launch::deferred, [this, transfer]() { return InFlightResult{completeTransfer(*transfer), cancelled(transfer->options.get())}; });
+        _inFlight[key] = inFlight.share();
+    }
+
+    bool shareConnections = true;
+    if (options)
+    {
+        options->getValue(curl::SHARE_CONNECTIONS, shareConnections);
+        options->getValue(curl::HANDLE_POOL_SIZE, transfer->handlePoolSize);
+    }
+
+    transfer->handle = acquireHandle(shareConnections);
+    if (!transfer->handle)
+    {
+        transfer->object = vsg::ReadError::create(vsg::make_string("vsgXchange::curl could not create curl handle to read file ", filename));
+        if (!transfer->inFlightKey.empty())
+        {
+            std::scoped_lock<std::mutex> lock(_inFlightMutex);
+            _inFlight.erase(transfer->inFlightKey);
+        }
+        transfer->completed.set_value();
+        return std::async(std::launch::deferred, [this, readerWriter, transfer]() { return completeTransfer(*transfer); });
+    }
+
+    setupHandle(transfer->handle, filename, transfer->buffer, options.get(), validators);
+
+    // allow several requests to the same host to be multiplexed over a single HTTP/2 connection
+    curl_easy_setopt(transfer->handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(transfer->handle, CURLOPT_PIPEWAIT, 1L);
+
+    startMultiThread();
+
+    abandonPrefetch(filename);
+    ++_foregroundTransfers;
+
+    {
+        std::scoped_lock<std::mutex> lock(_multiMutex);
+        _pendingTransfers.push_back(transfer);
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+    curl_multi_wakeup(_multi);
+#endif
+
+    // parsing is deferred to the thread that calls future.get() so that the curl_multi thread is only ever doing transfers.
+    return std::async(std::launch::deferred, [this, readerWriter, transfer]() { return completeTransfer(*transfer); });
+}
+
+void curl::Implementation::startMultiThread() const
+{
+    std::scoped_lock<std::mutex> lock(_multiMutex);
+    if (_multiThread.joinable()) return;
+
+    _multi = curl_multi_init();
+    curl_multi_setopt(_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+    _multiActive = true;
+    _multiThread = std::thread([this]() { runMulti(); });
+}
+
+void curl::Implementation::runMulti() const
+{
+    while (_multiActive)
+    {
+        {
+            std::scoped_lock<std::mutex> lock(_multiMutex);
+            for (auto& transfer : _pendingTransfers)
+            {
+                curl_multi_add_handle(_multi, transfer->handle);
+                _activeTransfers[transfer->handle] = transfer;
+            }
+            _pendingTransfers.clear();
+        }
+
+        int runningHandles = 0;
+        curl_multi_perform(_multi, &runningHandles);
+
+        int messagesInQueue = 0;
+        while (CURLMsg* message = curl_multi_info_read(_multi, &messagesInQueue))
+        {
+            if (message->msg != CURLMSG_DONE) continue;
+
+            auto itr = _activeTransfers.find(message->easy_handle);
+            if (itr == _activeTransfers.end()) continue;
+
+            auto transfer = itr->second;
+            _activeTransfers.erase(itr);
+
+            curl_multi_remove_handle(_multi, transfer->handle);
+
+            transfer->result = message->data.result;
+
+            // reads starting from now make a new transfer rather than sharing one that's already complete
+            if (!transfer->inFlightKey.empty())
+            {
+                std::scoped_lock<std::mutex> lock(_inFlightMutex);
+                _inFlight.erase(transfer->inFlightKey);
+            }
+            transfer->completed.set_value();
+
+            foregroundTransferCompleted();
+        }
+
+        // wait for socket activity, or a new transfer being queued
+#if LIBCURL_VERSION_NUM >= 0x074200
+        curl_multi_poll(_multi, nullptr, 0, 100, nullptr);
+#else
+        curl_multi_wait(_multi, nullptr, 0, 10, nullptr);
+#endif
+    }
+}
+
+void curl::Implementation::queueCacheWrite(CacheWrite&& cacheWrite) const
+{
+    {
+        std::scoped_lock<std::mutex> lock(_cacheWriteMutex);
+
+        if (!_cacheWriteThread.joinable())
+        {
+            _cacheWriteActive = true;
+            _cacheWriteThread = std::thread([this]() { runCacheWriter(); });
+        }
+
+        auto itr = _pendingCacheWrites.find(cacheWrite.fileCachePath);
+        if (itr == _pendingCacheWrites.end())
+        {
+            _pendingCacheWrites.emplace(cacheWrite.fileCachePath, std::move(cacheWrite));
+        }
+        else if (cacheWrite.writeData)
+        {
+            // newer download of the same URL supersedes the pending one
+            itr->second = std::move(cacheWrite);
+        }
+        else
+        {
+            itr->second.metadata = cacheWrite.metadata;
+        }
+    }
+    _cacheWriteCondition.notify_one();
+}
+
+void curl::Implementation::runCacheWriter() const
+{
+    std::unique_lock<std::mutex> lock(_cacheWriteMutex);
+    for (;;)
+    {
+        _cacheWriteCondition.wait(lock, [this]() { return !_pendingCacheWrites.empty() || !_cacheWriteActive; });
+
+        if (_pendingCacheWrites.empty())
+        {
+            if (!_cacheWriteActive) break;
+            continue;
+        }
+
+        auto node = _pendingCacheWrites.extract(_pendingCacheWrites.begin());
+        CacheWrite& cacheWrite = node.mapped();
+
+        lock.unlock();
+
+        vsg::makeDirectory(vsg::filePath(cacheWrite.fileCachePath));
+
+        bool dataWritten = !cacheWrite.writeData;
+        if (cacheWrite.writeData)
+        {
+            auto compressedCachePath = getCompressedCachePath(cacheWrite.fileCachePath);
+            std::vector<uint8_t> compressed;
+#ifdef vsgXchange_ktx_zstd
+            if (cacheWrite.compressionLevel > 0)
+            {
+                compressed.resize(ZSTD_compressBound(cacheWrite.data.size()));
+                auto compressedSize = ZSTD_compress(compressed.data(), compressed.size(), cacheWrite.data.data(), cacheWrite.data.size(), static_cast<int>(cacheWrite.compressionLevel));
+
+                // already compressed payloads such as JPEG, PNG and KTX2 gain little, so they are kept uncompressed to avoid decompressing them on every read
+                if (ZSTD_isError(compressedSize) || compressedSize * 10 > cacheWrite.data.size() * 9)
+                    compressed.clear();
+                else
+                    compressed.resize(compressedSize);
+            }
+#else
+            if (cacheWrite.compressionLevel > 0 && !_cacheCompressionWarned)
+            {
+                vsg::warn("vsgXchange::curl file cache compression not supported, build vsgXchange with zstd to enable it. Writing uncompressed file cache entries.");
+                _cacheCompressionWarned = true;
+            }
+#endif
+            // write just one form of the entry, removing any previous entry in the other form
+            if (!compressed.empty())
+            {
+                dataWritten = writeFileAtomically(compressedCachePath, compressed.data(), compressed.size());
+                if (dataWritten) std::remove(cacheWrite.fileCachePath.string().c_str());
+            }
+            else
+            {
+                dataWritten = writeFileAtomically(cacheWrite.fileCachePath, cacheWrite.data.data(), cacheWrite.data.size());
+                if (dataWritten && vsg::fileExists(compressedCachePath)) std::remove(compressedCachePath.string().c_str());
+            }
+        }
+        if (dataWritten)
+        {
+            auto metadata = toString(cacheWrite.metadata);
+            writeFileAtomically(getCacheMetadataPath(cacheWrite.fileCachePath), metadata.data(), metadata.size());
+        }
+        else
+        {
+            vsg::warn("vsgXchange::curl could not write file cache entry ", cacheWrite.fileCachePath);
+        }
+
+        lock.lock();
+    }
+}
+
+void curl::Implementation::prefetchChildren(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!object || !prefetchEnabled(options.get()) || cancelled(options.get())) return;
+
+    CollectPagedLODFilenames collectFilenames;
+    collectFilenames.parentFilename = filename;
+    object->accept(collectFilenames);
+    if (collectFilenames.children.empty()) return;
+
+    uint32_t maxPending = 256;
+    options->getValue(curl::PREFETCH_MAX_PENDING, maxPending);
+
+    {
+        std::scoped_lock<std::mutex> lock(_prefetchMutex);
+        options->getValue(curl::PREFETCH_MAX_TRANSFERS, _prefetchMaxTransfers);
+
+        if (!_prefetchThread.joinable())
+        {
+            _prefetchActive = true;
+            _prefetchThread = std::thread([this]() { runPrefetch(); });
+        }
+
+        // push in reverse so the children keep their order at the front of the queue
+        for (auto itr = collectFilenames.children.rbegin(); itr != collectFilenames.children.rend(); ++itr)
+        {
+            if (!_prefetchQueued.insert(*itr).second) continue; // already queued or being prefetched
+            _prefetchQueue.push_front(PrefetchRequest{*itr, options});
+        }
+
+        while (_prefetchQueue.size() > maxPending)
+        {
+            _prefetchQueued.erase(_prefetchQueue.back().filename);
+            _prefetchQueue.pop_back();
+        }
+    }
+    _prefetchCondition.notify_one();
+}
+
+bool curl::Implementation::hasPrefetched(const vsg::Path& filename) const
+{
+    std::scoped_lock<std::mutex> lock(_prefetchedMutex);
+    return _prefetchedIndex.count(filename) != 0;
+}
+
+vsg::ref_ptr<vsg::Object> curl::Implementation::readPrefetched(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    PrefetchedData prefetched;
+    {
+        std::scoped_lock<std::mutex> lock(_prefetchedMutex);
+        auto itr = _prefetchedIndex.find(filename);
+        if (itr == _prefetchedIndex.end()) return {};
+
+        // the entry is only read once, by the DatabasePager request it was prefetched for
+        prefetched = std::move(*(itr->second));
+        _prefetchedSize -= prefetched.data.size();
+        _prefetched.erase(itr->second);
+        _prefetchedIndex.erase(itr);
+    }
+
+    auto object = parseDownload(filename, prefetched.data, prefetched.contentType, options);
+    if (!object) return {};
+
+    {
+        std::scoped_lock<std::mutex> lock(_readerWriter._statisticsMutex);
+        ++_readerWriter._statistics.numPrefetchHits;
+    }
+
+    prefetchChildren(object, filename, options);
 
     return object;
 }
+
+void curl::Implementation::cancelPrefetch() const
+{
+    std::scoped_lock<std::mutex> lock(_prefetchMutex);
+
+    _prefetchQueue.clear();
+    _prefetchQueued.clear();
+    for (auto& [filename, transfer] : _prefetchTransfers)
+    {
+        transfer->abandoned = true;
+        _prefetchQueued.insert(filename);
+    }
+}
+
+void curl::Implementation::abandonPrefetch(const vsg::Path& filename) const
+{
+    std::scoped_lock<std::mutex> lock(_prefetchMutex);
+
+    if (_prefetchQueued.count(filename) == 0) return;
+
+    if (auto itr = _prefetchTransfers.find(filename); itr != _prefetchTransfers.end())
+    {
+        itr->second->abandoned = true;
+        return;
+    }
+
+    _prefetchQueued.erase(filename);
+    auto itr = std::find_if(_prefetchQueue.begin(), _prefetchQueue.end(), [&filename](const PrefetchRequest& request) { return request.filename == filename; });
+    if (itr != _prefetchQueue.end()) _prefetchQueue.erase(itr);
+}
+
+void curl::Implementation::foregroundTransferCompleted() const
+{
+    if (--_foregroundTransfers == 0) _prefetchCondition.notify_one();
+}
+
+int curl::Implementation::prefetchProgress(void* user_data, curl_off_t /*dltotal*/, curl_off_t /*dlnow*/, curl_off_t /*ultotal*/, curl_off_t /*ulnow*/)
+{
+    auto transfer = reinterpret_cast<PrefetchTransfer*>(user_data);
+    if (transfer->abandoned) return 1;
+    return (transfer->buffer.cancellation && transfer->buffer.cancellation->cancelled()) ? 1 : 0;
+}
+
+std::shared_ptr<curl::Implementation::PrefetchTransfer> curl::Implementation::startPrefetch(PrefetchRequest&& request, CURLM* multi, uint64_t bandwidth) const
+{
+    // skip children that have been cancelled, are already cached or are being read since they were queued
+    if (cancelled(request.options.get())) return {};
+
+    CacheMetadata metadata;
+    if (getFileCacheStatus(request.filename, request.options.get(), metadata) != CacheStatus::MISSING) return {};
+    if (hasPrefetched(request.filename) || isInFlight(request.filename)) return {};
+
+    bool shareConnections = true;
+    auto transfer = std::make_shared<PrefetchTransfer>();
+    transfer->request = std::move(request);
+
+    auto& options = transfer->request.options;
+    options->getValue(curl::SHARE_CONNECTIONS, shareConnections);
+    options->getValue(curl::HANDLE_POOL_SIZE, transfer->handlePoolSize);
+
+    transfer->handle = acquireHandle(shareConnections);
+    if (!transfer->handle) return {};
+
+    setupHandle(transfer->handle, transfer->request.filename, transfer->buffer, options.get(), nullptr);
+
+    // poll for the prefetch being abandoned as well as the read being cancelled
+    curl_easy_setopt(transfer->handle, CURLOPT_XFERINFOFUNCTION, prefetchProgress);
+    curl_easy_setopt(transfer->handle, CURLOPT_XFERINFODATA, (void*)transfer.get());
+    curl_easy_setopt(transfer->handle, CURLOPT_NOPROGRESS, 0L);
+
+    if (bandwidth > 0) curl_easy_setopt(transfer->handle, CURLOPT_MAX_RECV_SPEED_LARGE, static_cast<curl_off_t>(bandwidth));
+
+    curl_easy_setopt(transfer->handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(transfer->handle, CURLOPT_PIPEWAIT, 1L);
+
+    curl_multi_add_handle(multi, transfer->handle);
+
+    return transfer;
+}
+
+void curl::Implementation::completePrefetch(PrefetchTransfer& transfer, CURLcode result) const
+{
+    // abandoned and cancelled prefetches aren't failures so are just discarded
+    if (result == CURLE_ABORTED_BY_CALLBACK || transfer.abandoned) return;
+
+    long response_code = 0;
+    bool succeeded = result == CURLE_OK && curl_easy_getinfo(transfer.handle, CURLINFO_RESPONSE_CODE, &response_code) == CURLE_OK && response_code >= 200 && response_code < 300;
+
+    recordTransfer(transfer.handle, succeeded, nullptr, nullptr);
+
+    {
+        std::scoped_lock<std::mutex> lock(_readerWriter._statisticsMutex);
+        ++_readerWriter._statistics.numPrefetches;
+    }
+
+    if (!succeeded || transfer.buffer.responseHeaders.noStore) return;
+
+    auto& options = transfer.request.options;
+    if (options->fileCache)
+    {
+        CacheWrite cacheWrite;
+        cacheWrite.fileCachePath = getFileCachePath(options->fileCache, transfer.request.filename);
+        if (!cacheWrite.fileCachePath) return;
+
+        cacheWrite.compressionLevel = cacheCompressionLevel(options.get());
+        cacheWrite.data = std::move(transfer.buffer.data);
+        cacheWrite.metadata = transfer.buffer.responseHeaders;
+        applyHeuristicFreshness(cacheWrite.metadata);
+        queueCacheWrite(std::move(cacheWrite));
+    }
+    else
+    {
+        uint64_t maxSize = 64 * 1024 * 1024;
+        options->getValue(curl::PREFETCH_MEMORY_CACHE, maxSize);
+        storePrefetched(PrefetchedData{transfer.request.filename, std::move(transfer.buffer.data), transfer.buffer.contentType}, maxSize);
+    }
+}
+
+void curl::Implementation::storePrefetched(PrefetchedData&& prefetched, uint64_t maxSize) const
+{
+    if (prefetched.data.size() > maxSize) return;
+
+    std::scoped_lock<std::mutex> lock(_prefetchedMutex);
+
+    if (auto itr = _prefetchedIndex.find(prefetched.filename); itr != _prefetchedIndex.end())
+    {
+        _prefetchedSize -= itr->second->data.size();
+        _prefetched.erase(itr->second);
+        _prefetchedIndex.erase(itr);
+    }
+
+    _prefetchedSize += prefetched.data.size();
+    _prefetched.push_front(std::move(prefetched));
+    _prefetchedIndex[_prefetched.front().filename] = _prefetched.begin();
+
+    while (_prefetchedSize > maxSize && !_prefetched.empty())
+    {
+        auto& oldest = _prefetched.back();
+        _prefetchedSize -= oldest.data.size();
+        _prefetchedIndex.erase(oldest.filename);
+        _prefetched.pop_back();
+    }
+}
+
+void curl::Implementation::runPrefetch() const
+{
+    // prefetch transfers use their own curl_multi handle so they never hold up the foreground transfers on the _multiThread
+    CURLM* multi = curl_multi_init();
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+    std::map<CURL*, std::shared_ptr<PrefetchTransfer>> active;
+
+    std::unique_lock<std::mutex> lock(_prefetchMutex);
+    while (_prefetchActive)
+    {
+        // prefetching is low priority so new transfers are only started while no foreground transfers are in progress
+        uint32_t maxTransfers = std::max(_prefetchMaxTransfers, uint32_t(1));
+        while (active.size() < maxTransfers && !_prefetchQueue.empty() && _foregroundTransfers == 0)
+        {
+            auto request = std::move(_prefetchQueue.front());
+            _prefetchQueue.pop_front();
+
+            // the bandwidth limit is shared between the concurrent prefetch transfers
+            uint64_t bandwidth = 0;
+            request.options->getValue(curl::PREFETCH_BANDWIDTH, bandwidth);
+
+            auto filename = request.filename;
+            if (auto transfer = startPrefetch(std::move(request), multi, bandwidth / maxTransfers))
+            {
+                active[transfer->handle] = transfer;
+                _prefetchTransfers[filename] = transfer;
+            }
+            else
+            {
+                _prefetchQueued.erase(filename);
+            }
+        }
+
+        if (active.empty())
+        {
+            _prefetchCondition.wait_for(lock, std::chrono::milliseconds(100), [this]() { return !_prefetchActive || (!_prefetchQueue.empty() && _foregroundTransfers == 0); });
+            continue;
+        }
+
+        lock.unlock();
+
+        int runningHandles = 0;
+        curl_multi_perform(multi, &runningHandles);
+
+        std::vector<std::shared_ptr<PrefetchTransfer>> completed;
+        int messagesInQueue = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &messagesInQueue))
+        {
+            if (message->msg != CURLMSG_DONE) continue;
+
+            auto itr = active.find(message->easy_handle);
+            if (itr == active.end()) continue;
+
+            auto transfer = itr->second;
+            active.erase(itr);
+
+            curl_multi_remove_handle(multi, transfer->handle);
+
+            completePrefetch(*transfer, message->data.result);
+
+            releaseHandle(transfer->handle, transfer->handlePoolSize);
+            transfer->handle = nullptr;
+
+            completed.push_back(transfer);
+        }
+
+        if (completed.empty())
+        {
+#if LIBCURL_VERSION_NUM >= 0x074200
+            curl_multi_poll(multi, nullptr, 0, 100, nullptr);
+#else
+            curl_multi_wait(multi, nullptr, 0, 10, nullptr);
+#endif
+        }
+
+        lock.lock();
+
+        for (auto& transfer : completed)
+        {
+            _prefetchQueued.erase(transfer->request.filename);
+            _prefetchTransfers.erase(transfer->request.filename);
+        }
+    }
+
+    // abandon the prefetch transfers still in progress
+    for (auto& [handle, transfer] : active)
+    {
+        curl_multi_remove_handle(multi, handle);
+        releaseHandle(handle, transfer->handlePoolSize);
+        transfer->handle = nullptr;
+    }
+    _prefetchTransfers.clear();
+    _prefetchQueue.clear();
+    _prefetchQueued.clear();
+
+    curl_multi_cleanup(multi);
+}
@@ -32,6 +32,29 @@ vsg::ref_ptr<vsg::Object> curl::read(const vsg::Path&, vsg::ref_ptr<const vsg::O
 {
     return {};
 }
+std::future<vsg::ref_ptr<vsg::Object>> curl::readAsync(const vsg::Path&, vsg::ref_ptr<const vsg::Options>) const
+{
+    std::promise<vsg::ref_ptr<vsg::Object>> promise;
+    promise.set_value({});
+    return promise.get_future();
+}
+std::vector<std::future<vsg::ref_ptr<vsg::Object>>> curl::readAsync(const vsg::Paths& filenames, vsg::ref_ptr<const vsg::Options> options) const
+{
+    std::vector<std::future<vsg::ref_ptr<vsg::Object>>> results;
+    for (auto& filename : filenames) results.push_back(readAsync(filename, options));
+    return results;
+}
+curl::Implementation* curl::getImplementation() const
+{
+    return nullptr;
+}
+curl::Statistics curl::getStatistics() const
+{
+    return {};
+}
+void curl::resetStatistics()
+{
+}
 bool curl::getFeatures(Features&) const
 {
     return false;
@@ -11,11 +11,21 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 </editor-fold> */
 
 #include <vsgXchange/images.h>
+#include <vsgXchange/read_memory.h>
+
+#include "../all/block_decompress.h"
+#include "../all/image_downsample.h"
+#include "../all/mapped_file.h"
+#include "../all/stream_utils.h"
 
 #include <vsg/io/FileSystem.h>
 #include <vsg/io/stream.h>
+#include <vsg/utils/CommandLine.h>
 
+#include <algorithm>
 #include <cstring>
+#include <fstream>
+#include <vector>
 
 #if defined(__GNUC__)
 #    pragma GCC diagnostic push
@@ -34,247 +44,702 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 namespace
 {
-    const std::unordered_map<tinyddsloader::DDSFile::DXGIFormat, VkFormat> kFormatMap{
-        {tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UNorm, VK_FORMAT_R8G8B8A8_UNORM},
-        {tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_SNorm, VK_FORMAT_R8G8B8A8_SNORM},
-        {tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UNorm_SRGB, VK_FORMAT_R8G8B8A8_SRGB},
-        {tinyddsloader::DDSFile::DXGIFormat::B8G8R8A8_UNorm, VK_FORMAT_B8G8R8A8_UNORM},
-        {tinyddsloader::DDSFile::DXGIFormat::B8G8R8A8_UNorm_SRGB, VK_FORMAT_B8G8R8A8_SRGB},
-        {tinyddsloader::DDSFile::DXGIFormat::R8G8_UNorm, VK_FORMAT_R8G8_UNORM},
-        {tinyddsloader::DDSFile::DXGIFormat::R8G8_SNorm, VK_FORMAT_R8G8_SNORM},
-        {tinyddsloader::DDSFile::DXGIFormat::R8G8_UInt, VK_FORMAT_R8G8_UINT},
-        {tinyddsloader::DDSFile::DXGIFormat::R8G8_SInt, VK_FORMAT_R8G8_SINT},
-        {tinyddsloader::DDSFile::DXGIFormat::BC7_UNorm, VK_FORMAT_BC7_UNORM_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::BC7_UNorm_SRGB, VK_FORMAT_BC7_SRGB_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::BC5_UNorm, VK_FORMAT_BC5_UNORM_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::BC5_SNorm, VK_FORMAT_BC5_SNORM_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::BC4_UNorm, VK_FORMAT_BC4_UNORM_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::BC4_SNorm, VK_FORMAT_BC4_SNORM_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::BC3_UNorm, VK_FORMAT_BC3_UNORM_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::BC3_UNorm_SRGB, VK_FORMAT_BC3_SRGB_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::BC2_UNorm, VK_FORMAT_BC2_UNORM_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::BC2_UNorm_SRGB, VK_FORMAT_BC2_SRGB_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::BC1_UNorm, VK_FORMAT_BC1_RGBA_UNORM_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::BC1_UNorm_SRGB, VK_FORMAT_BC1_RGBA_SRGB_BLOCK},
-        {tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_Float, VK_FORMAT_R16G16B16A16_SFLOAT},
-        {tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_Float, VK_FORMAT_R32G32B32A32_SFLOAT}};
-
-    uint8_t* allocateAndCopyToContiguousBlock(tinyddsloader::DDSFile& ddsFile)
+    using DXGIFormat = tinyddsloader::DDSFile::DXGIFormat;
+
+    const std::unordered_map<DXGIFormat, VkFormat> kFormatMap{
+        // 128 and 96 bit
+        {DXGIFormat::R32G32B32A32_Float, VK_FORMAT_R32G32B32A32_SFLOAT},
+        {DXGIFormat::R32G32B32A32_UInt, VK_FORMAT_R32G32B32A32_UINT},
+        {DXGIFormat::R32G32B32A32_SInt, VK_FORMAT_R32G32B32A32_SINT},
+        {DXGIFormat::R32G32B32_Float, VK_FORMAT_R32G32B32_SFLOAT},
+        {DXGIFormat::R32G32B32_UInt, VK_FORMAT_R32G32B32_UINT},
+        {DXGIFormat::R32G32B32_SInt, VK_FORMAT_R32G32B32_SINT},
+        // 64 bit
+        {DXGIFormat::R16G16B16A16_Float, VK_FORMAT_R16G16B16A16_SFLOAT},
+        {DXGIFormat::R16G16B16A16_UNorm, VK_FORMAT_R16G16B16A16_UNORM},
+        {DXGIFormat::R16G16B16A16_UInt, VK_FORMAT_R16G16B16A16_UINT},
+        {DXGIFormat::R16G16B16A16_SNorm, VK_FORMAT_R16G16B16A16_SNORM},
+        {DXGIFormat::R16G16B16A16_SInt, VK_FORMAT_R16G16B16A16_SINT},
+        {DXGIFormat::R32G32_Float, VK_FORMAT_R32G32_SFLOAT},
+        {DXGIFormat::R32G32_UInt, VK_FORMAT_R32G32_UINT},
+        {DXGIFormat::R32G32_SInt, VK_FORMAT_R32G32_SINT},
+        // 32 bit
+        {DXGIFormat::R10G10B10A2_UNorm, VK_FORMAT_A2B10G10R10_UNORM_PACK32},
+        {DXGIFormat::R10G10B10A2_UInt, VK_FORMAT_A2B10G10R10_UINT_PACK32},
+        {DXGIFormat::R11G11B10_Float, VK_FORMAT_B10G11R11_UFLOAT_PACK32},
+        {DXGIFormat::R9G9B9E5_SHAREDEXP, VK_FORMAT_E5B9G9R9_UFLOAT_PACK32},
+        {DXGIFormat::R8G8B8A8_UNorm, VK_FORMAT_R8G8B8A8_UNORM},
+        {DXGIFormat::R8G8B8A8_UNorm_SRGB, VK_FORMAT_R8G8B8A8_SRGB},
+        {DXGIFormat::R8G8B8A8_UInt, VK_FORMAT_R8G8B8A8_UINT},
+        {DXGIFormat::R8G8B8A8_SNorm, VK_FORMAT_R8G8B8A8_SNORM},
+        {DXGIFormat::R8G8B8A8_SInt, VK_FORMAT_R8G8B8A8_SINT},
+        {DXGIFormat::B8G8R8A8_UNorm, VK_FORMAT_B8G8R8A8_UNORM},
+        {DXGIFormat::B8G8R8A8_UNorm_SRGB, VK_FORMAT_B8G8R8A8_SRGB},
+        {DXGIFormat::B8G8R8X8_UNorm, VK_FORMAT_B8G8R8A8_UNORM},
+        {DXGIFormat::B8G8R8X8_UNorm_SRGB, VK_FORMAT_B8G8R8A8_SRGB},
+        {DXGIFormat::R16G16_Float, VK_FORMAT_R16G16_SFLOAT},
+        {DXGIFormat::R16G16_UNorm, VK_FORMAT_R16G16_UNORM},
+        {DXGIFormat::R16G16_UInt, VK_FORMAT_R16G16_UINT},
+        {DXGIFormat::R16G16_SNorm, VK_FORMAT_R16G16_SNORM},
+        {DXGIFormat::R16G16_SInt, VK_FORMAT_R16G16_SINT},
+        {DXGIFormat::D32_Float, VK_FORMAT_D32_SFLOAT},
+        {DXGIFormat::R32_Float, VK_FORMAT_R32_SFLOAT},
+        {DXGIFormat::R32_UInt, VK_FORMAT_R32_UINT},
+        {DXGIFormat::R32_SInt, VK_FORMAT_R32_SINT},
+        // 16 bit
+        {DXGIFormat::R8G8_UNorm, VK_FORMAT_R8G8_UNORM},
+        {DXGIFormat::R8G8_UInt, VK_FORMAT_R8G8_UINT},
+        {DXGIFormat::R8G8_SNorm, VK_FORMAT_R8G8_SNORM},
+        {DXGIFormat::R8G8_SInt, VK_FORMAT_R8G8_SINT},
+        {DXGIFormat::R16_Float, VK_FORMAT_R16_SFLOAT},
+        {DXGIFormat::D16_UNorm, VK_FORMAT_D16_UNORM},
+        {DXGIFormat::R16_UNorm, VK_FORMAT_R16_UNORM},
+        {DXGIFormat::R16_UInt, VK_FORMAT_R16_UINT},
+        {DXGIFormat::R16_SNorm, VK_FORMAT_R16_SNORM},
+        {DXGIFormat::R16_SInt, VK_FORMAT_R16_SINT},
+        {DXGIFormat::B5G6R5_UNorm, VK_FORMAT_R5G6B5_UNORM_PACK16},
+        {DXGIFormat::B5G5R5A1_UNorm, VK_FORMAT_A1R5G5B5_UNORM_PACK16},
+        {DXGIFormat::B4G4R4A4_UNorm, VK_FORMAT_A4R4G4B4_UNORM_PACK16_EXT},
+        // 8 bit
+        {DXGIFormat::R8_UNorm, VK_FORMAT_R8_UNORM},
+        {DXGIFormat::R8_UInt, VK_FORMAT_R8_UINT},
+        {DXGIFormat::R8_SNorm, VK_FORMAT_R8_SNORM},
+        {DXGIFormat::R8_SInt, VK_FORMAT_R8_SINT},
+        // block compressed
+        {DXGIFormat::BC1_UNorm, VK_FORMAT_BC1_RGBA_UNORM_BLOCK},
+        {DXGIFormat::BC1_UNorm_SRGB, VK_FORMAT_BC1_RGBA_SRGB_BLOCK},
+        {DXGIFormat::BC2_UNorm, VK_FORMAT_BC2_UNORM_BLOCK},
+        {DXGIFormat::BC2_UNorm_SRGB, VK_FORMAT_BC2_SRGB_BLOCK},
+        {DXGIFormat::BC3_UNorm, VK_FORMAT_BC3_UNORM_BLOCK},
+        {DXGIFormat::BC3_UNorm_SRGB, VK_FORMAT_BC3_SRGB_BLOCK},
+        {DXGIFormat::BC4_UNorm, VK_FORMAT_BC4_UNORM_BLOCK},
+        {DXGIFormat::BC4_SNorm, VK_FORMAT_BC4_SNORM_BLOCK},
+        {DXGIFormat::BC5_UNorm, VK_FORMAT_BC5_UNORM_BLOCK},
+        {DXGIFormat::BC5_SNorm, VK_FORMAT_BC5_SNORM_BLOCK},
+        {DXGIFormat::BC6H_UF16, VK_FORMAT_BC6H_UFLOAT_BLOCK},
+        {DXGIFormat::BC6H_SF16, VK_FORMAT_BC6H_SFLOAT_BLOCK},
+        {DXGIFormat::BC7_UNorm, VK_FORMAT_BC7_UNORM_BLOCK},
+        {DXGIFormat::BC7_UNorm_SRGB, VK_FORMAT_BC7_SRGB_BLOCK}};
+
+    /// layout of a DDS file parsed in place, following tinyddsloader::DDSFile::Load() but without it first copying the whole file into a std::vector,
+    /// so the payload is only copied once, straight into the vsg::Data. The image data pointers reference the parsed memory, which must remain valid until readDds() has copied it.
+    struct DdsView
+    {
+        using ImageData = tinyddsloader::DDSFile::ImageData;
+        using TextureDimension = tinyddsloader::DDSFile::TextureDimension;
+
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t depth = 1;
+        uint32_t mipCount = 1;
+        uint32_t arraySize = 1;
+        DXGIFormat format = DXGIFormat::Unknown;
+        TextureDimension dimension = TextureDimension::Unknown;
+        bool isCubemap = false;
+        std::vector<ImageData> images;
+
+        uint32_t GetWidth() const { return width; }
+        uint32_t GetHeight() const { return height; }
+        uint32_t GetDepth() const { return depth; }
+        uint32_t GetMipCount() const { return mipCount; }
+        uint32_t GetArraySize() const { return arraySize; }
+        DXGIFormat GetFormat() const { return format; }
+        bool IsCubemap() const { return isCubemap; }
+        TextureDimension GetTextureDimension() const { return dimension; }
+
+        const ImageData* GetImageData(uint32_t mipIdx, uint32_t arrayIdx) const
+        {
+            if (mipIdx < mipCount && arrayIdx < arraySize) return &images[mipCount * arrayIdx + mipIdx];
+            return nullptr;
+        }
+    };
+
+    /// compute the size of a w x h image and its rows, matching tinyddsloader's private DDSFile::GetImageInfo().
+    void imageInfo(uint32_t w, uint32_t h, DXGIFormat fmt, uint32_t& numBytes, uint32_t& rowBytes)
+    {
+        uint32_t bpe = 0;
+        bool bc = false, packed = false, planar = false;
+        switch (fmt)
+        {
+        case DXGIFormat::BC1_Typeless:
+        case DXGIFormat::BC1_UNorm:
+        case DXGIFormat::BC1_UNorm_SRGB:
+        case DXGIFormat::BC4_Typeless:
+        case DXGIFormat::BC4_UNorm:
+        case DXGIFormat::BC4_SNorm:
+            bc = true;
+            bpe = 8;
+            break;
+        case DXGIFormat::BC2_Typeless:
+        case DXGIFormat::BC2_UNorm:
+        case DXGIFormat::BC2_UNorm_SRGB:
+        case DXGIFormat::BC3_Typeless:
+        case DXGIFormat::BC3_UNorm:
+        case DXGIFormat::BC3_UNorm_SRGB:
+        case DXGIFormat::BC5_Typeless:
+        case DXGIFormat::BC5_UNorm:
+        case DXGIFormat::BC5_SNorm:
+        case DXGIFormat::BC6H_Typeless:
+        case DXGIFormat::BC6H_UF16:
+        case DXGIFormat::BC6H_SF16:
+        case DXGIFormat::BC7_Typeless:
+        case DXGIFormat::BC7_UNorm:
+        case DXGIFormat::BC7_UNorm_SRGB:
+            bc = true;
+            bpe = 16;
+            break;
+        case DXGIFormat::R8G8_B8G8_UNorm:
+        case DXGIFormat::G8R8_G8B8_UNorm:
+        case DXGIFormat::YUY2:
+            packed = true;
+            bpe = 4;
+            break;
+        case DXGIFormat::Y210:
+        case DXGIFormat::Y216:
+            packed = true;
+            bpe = 8;
+            break;
+        case DXGIFormat::NV12:
+        case DXGIFormat::YUV420_OPAQUE:
+            planar = true;
+            bpe = 2;
+            break;
+        case DXGIFormat::P010:
+        case DXGIFormat::P016:
+            planar = true;
+            bpe = 4;
+            break;
+        default:
+            break;
+        }
+
+        if (bc)
+        {
+            uint32_t numBlocksWide = (w > 0) ? std::max<uint32_t>(1, (w + 3) / 4) : 0;
+            uint32_t numBlocksHigh = (h > 0) ? std::max<uint32_t>(1, (h + 3) / 4) : 0;
+            rowBytes = numBlocksWide * bpe;
+            numBytes = rowBytes * numBlocksHigh;
+        }
+        else if (packed)
+        {
+            rowBytes = ((w + 1) >> 1) * bpe;
+            numBytes = rowBytes * h;
+        }
+        else if (fmt == DXGIFormat::NV11)
+        {
+            rowBytes = ((w + 3) >> 2) * 4;
+            numBytes = rowBytes + h * 2;
+        }
+        else if (planar)
+        {
+            rowBytes = ((w + 1) >> 1) * bpe;
+            numBytes = (rowBytes * h) + ((rowBytes * h + 1) >> 1);
+        }
+        else
+        {
+            rowBytes = (w * tinyddsloader::DDSFile::GetBitsPerPixel(fmt) + 7) / 8;
+            numBytes = rowBytes * h;
+        }
+    }
+
+    /// parse the DDS header, optional DX10 header and the payload offsets of each mip level and array element of the DDS file in data.
+    tinyddsloader::Result parseDds(const uint8_t* data, size_t size, DdsView& view)
+    {
+        using DDSFile = tinyddsloader::DDSFile;
+        using TextureDimension = DdsView::TextureDimension;
+
+        if (!data || size < 4) return tinyddsloader::ErrorSize;
+        if (std::memcmp(data, "DDS ", 4) != 0) return tinyddsloader::ErrorMagicWord;
+        if (sizeof(uint32_t) + sizeof(DDSFile::Header) >= size) return tinyddsloader::ErrorSize;
+
+        DDSFile::Header header;
+        std::memcpy(&header, data + sizeof(uint32_t), sizeof(header));
+        if (header.m_size != sizeof(DDSFile::Header) || header.m_pixelFormat.m_size != sizeof(DDSFile::PixelFormat)) return tinyddsloader::ErrorVerify;
+
+        const bool hasDX10Header = (header.m_pixelFormat.m_flags & uint32_t(DDSFile::PixelFormatFlagBits::FourCC)) && header.m_pixelFormat.m_fourCC == DDSFile::MakeFourCC('D', 'X', '1', '0');
+        if (hasDX10Header && sizeof(uint32_t) + sizeof(DDSFile::Header) + sizeof(DDSFile::HeaderDXT10) >= size) return tinyddsloader::ErrorSize;
+
+        size_t offset = sizeof(uint32_t) + sizeof(DDSFile::Header) + (hasDX10Header ? sizeof(DDSFile::HeaderDXT10) : 0);
+
+        view.width = header.m_width;
+        view.height = header.m_height;
+        view.depth = 1;
+        view.mipCount = std::max(header.m_mipMapCount, 1u);
+        view.arraySize = 1;
+        view.isCubemap = false;
+
+        if (hasDX10Header)
+        {
+            DDSFile::HeaderDXT10 dx10Header;
+            std::memcpy(&dx10Header, data + sizeof(uint32_t) + sizeof(DDSFile::Header), sizeof(dx10Header));
+
+            view.arraySize = dx10Header.m_arraySize;
+            if (view.arraySize == 0) return tinyddsloader::ErrorInvalidData;
+
+            switch (dx10Header.m_format)
+            {
+            case DXGIFormat::AI44:
+            case DXGIFormat::IA44:
+            case DXGIFormat::P8:
+            case DXGIFormat::A8P8:
+                return tinyddsloader::ErrorNotSupported;
+            default:
+                if (DDSFile::GetBitsPerPixel(dx10Header.m_format) == 0) return tinyddsloader::ErrorNotSupported;
+            }
+            view.format = dx10Header.m_format;
+
+            switch (dx10Header.m_resourceDimension)
+            {
+            case TextureDimension::Texture1D:
+                if ((header.m_flags & uint32_t(DDSFile::HeaderFlagBits::Height)) && view.height != 1) return tinyddsloader::ErrorInvalidData;
+                view.height = 1;
+                break;
+            case TextureDimension::Texture2D:
+                if (dx10Header.m_miscFlag & uint32_t(DDSFile::DXT10MiscFlagBits::TextureCube))
+                {
+                    view.arraySize *= 6;
+                    view.isCubemap = true;
+                }
+                break;
+            case TextureDimension::Texture3D:
+                if (!(header.m_flags & uint32_t(DDSFile::HeaderFlagBits::Volume))) return tinyddsloader::ErrorInvalidData;
+                if (view.arraySize > 1) return tinyddsloader::ErrorNotSupported;
+                view.depth = std::max(header.m_depth, 1u);
+                break;
+            default:
+                return tinyddsloader::ErrorNotSupported;
+            }
+            view.dimension = dx10Header.m_resourceDimension;
+        }
+        else
+        {
+            view.format = DDSFile::GetDXGIFormat(header.m_pixelFormat);
+            if (view.format == DXGIFormat::Unknown) return tinyddsloader::ErrorNotSupported;
+
+            if (header.m_flags & uint32_t(DDSFile::HeaderFlagBits::Volume))
+            {
+                view.depth = std::max(header.m_depth, 1u);
+                view.dimension = TextureDimension::Texture3D;
+            }
+            else
+            {
+                auto caps2 = header.m_caps2 & uint32_t(DDSFile::HeaderCaps2FlagBits::CubemapAllFaces);
+                if (caps2)
+                {
+                    if (caps2 != uint32_t(DDSFile::HeaderCaps2FlagBits::CubemapAllFaces)) return tinyddsloader::ErrorNotSupported;
+                    view.arraySize = 6;
+                    view.isCubemap = true;
+                }
+                view.dimension = TextureDimension::Texture2D;
+            }
+        }
+
+        // DDS files store each array element with its full mip chain
+        view.images.resize(static_cast<size_t>(view.mipCount) * view.arraySize);
+        size_t idx = 0;
+        for (uint32_t j = 0; j < view.arraySize; ++j)
+        {
+            uint32_t w = view.width, h = view.height, d = view.depth;
+            for (uint32_t i = 0; i < view.mipCount; ++i)
+            {
+                uint32_t numBytes = 0, rowBytes = 0;
+                imageInfo(w, h, view.format, numBytes, rowBytes);
+
+                const size_t imageSize = static_cast<size_t>(numBytes) * d;
+                if (offset + imageSize > size) return tinyddsloader::ErrorInvalidData;
+
+                auto& image = view.images[idx++];
+                image.m_width = w;
+                image.m_height = h;
+                image.m_depth = d;
+                image.m_mem = const_cast<uint8_t*>(data + offset);
+                image.m_memPitch = rowBytes;
+                image.m_memSlicePitch = numBytes;
+
+                offset += imageSize;
+                w = std::max<uint32_t>(1, w / 2);
+                h = std::max<uint32_t>(1, h / 2);
+                d = std::max<uint32_t>(1, d / 2);
+            }
+        }
+
+        return tinyddsloader::Success;
+    }
+
+    // DDS files store each array element/cubemap face with its mip chain while vsg::Data stores level by level, all the array elements of each level together.
+    // The payload of single element textures is already in the vsg::Data order so is copied with a single memcpy into the image data allocated by allocateReadData().
+    // Mip levels before firstLevel are skipped so downscaled textures are never copied at full resolution.
+    uint8_t* allocateAndCopyToContiguousBlock(const DdsView& ddsFile, uint32_t firstLevel)
     {
         const auto numMipMaps = ddsFile.GetMipCount();
         const auto numArrays = ddsFile.GetArraySize();
+        auto imageSize = [](const DdsView::ImageData* data) { return static_cast<size_t>(data->m_memSlicePitch) * data->m_depth; };
+
         size_t totalSize = 0;
-        for (uint32_t i = 0; i < numMipMaps; ++i)
+        for (uint32_t i = firstLevel; i < numMipMaps; ++i)
         {
             for (uint32_t j = 0; j < numArrays; ++j)
             {
-                const auto data = ddsFile.GetImageData(i, j);
-                totalSize += data->m_memSlicePitch;
+                totalSize += imageSize(ddsFile.GetImageData(i, j));
             }
         }
 
         if (totalSize == 0) return nullptr;
 
-        auto raw = new uint8_t[totalSize];
+        auto raw = static_cast<uint8_t*>(vsgXchange::allocateReadData(totalSize));
+        if (!raw) return nullptr;
+
+        if (numArrays == 1)
+        {
+            std::memcpy(raw, ddsFile.GetImageData(firstLevel, 0)->m_mem, totalSize);
+            return raw;
+        }
 
         uint8_t* image_ptr = raw;
-        for (uint32_t i = 0; i < numMipMaps; ++i)
+        for (uint32_t i = firstLevel; i < numMipMaps; ++i)
         {
             for (uint32_t j = 0; j < numArrays; ++j)
             {
                 const auto data = ddsFile.GetImageData(i, j);
+                const auto size = imageSize(data);
 
-                std::memcpy(image_ptr, data->m_mem, data->m_memSlicePitch);
+                std::memcpy(image_ptr, data->m_mem, size);
 
-                image_ptr += data->m_memSlicePitch;
+                image_ptr += size;
             }
         }
         return raw;
     }
 
-    int computeImageViewType(tinyddsloader::DDSFile& ddsFile)
+    template<typename T>
+    vsg::ref_ptr<vsg::Data> createImage(uint32_t arrayDimensions, uint32_t width, uint32_t height, uint32_t depth, uint8_t* data, const vsg::Data::Properties& layout)
     {
-        switch (ddsFile.GetTextureDimension())
+        switch (arrayDimensions)
         {
-        case tinyddsloader::DDSFile::TextureDimension::Texture1D: return VK_IMAGE_VIEW_TYPE_1D;
-        case tinyddsloader::DDSFile::TextureDimension::Texture2D:
-            if (ddsFile.GetArraySize() > 1)
-            {
-                return ddsFile.IsCubemap() ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D_ARRAY;
-            }
-            else
-            {
-                return VK_IMAGE_VIEW_TYPE_2D;
-            }
-        case tinyddsloader::DDSFile::TextureDimension::Texture3D: return VK_IMAGE_VIEW_TYPE_3D;
-        case tinyddsloader::DDSFile::TextureDimension::Unknown: return -1;
+        case 1: return vsg::Array<T>::create(width, reinterpret_cast<T*>(data), layout);
+        case 2: return vsg::Array2D<T>::create(width, height, reinterpret_cast<T*>(data), layout);
+        default: return vsg::Array3D<T>::create(width, height, depth, reinterpret_cast<T*>(data), layout);
         }
-        return -1;
     }
 
-    vsg::ref_ptr<vsg::Data> readCompressed(tinyddsloader::DDSFile& ddsFile, VkFormat targetFormat)
+    vsg::ref_ptr<vsg::Data> createImage(uint32_t arrayDimensions, uint32_t width, uint32_t height, uint32_t depth, uint8_t* data, const vsg::Data::Properties& layout, uint32_t valueSize)
     {
-        const auto width = ddsFile.GetWidth();
-        const auto height = ddsFile.GetHeight();
-        const auto numMipMaps = ddsFile.GetMipCount();
-        const auto numArrays = ddsFile.GetArraySize();
+        // use the vsg types that match the common formats
+        switch (layout.format)
+        {
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_UINT: return createImage<vsg::ubvec2>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R8G8_SNORM:
+        case VK_FORMAT_R8G8_SINT: return createImage<vsg::bvec2>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_R8G8B8A8_UINT:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB: return createImage<vsg::ubvec4>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R8G8B8A8_SNORM:
+        case VK_FORMAT_R8G8B8A8_SINT: return createImage<vsg::bvec4>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R16G16_UNORM:
+        case VK_FORMAT_R16G16_UINT:
+        case VK_FORMAT_R16G16_SFLOAT: return createImage<vsg::usvec2>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R16G16_SNORM:
+        case VK_FORMAT_R16G16_SINT: return createImage<vsg::svec2>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R16G16B16A16_SNORM:
+        case VK_FORMAT_R16G16B16A16_SINT: return createImage<vsg::svec4>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R32_SFLOAT:
+        case VK_FORMAT_D32_SFLOAT: return createImage<float>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R32_SINT: return createImage<int32_t>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R32G32_SFLOAT: return createImage<vsg::vec2>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R32G32_UINT: return createImage<vsg::uivec2>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R32G32_SINT: return createImage<vsg::ivec2>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R32G32B32_SFLOAT: return createImage<vsg::vec3>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R32G32B32_UINT: return createImage<vsg::uivec3>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R32G32B32_SINT: return createImage<vsg::ivec3>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R32G32B32A32_SFLOAT: return createImage<vsg::vec4>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R32G32B32A32_UINT: return createImage<vsg::uivec4>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R32G32B32A32_SINT: return createImage<vsg::ivec4>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R8_SNORM:
+        case VK_FORMAT_R8_SINT: return createImage<int8_t>(arrayDimensions, width, height, depth, data, layout);
+        case VK_FORMAT_R16_SNORM:
+        case VK_FORMAT_R16_SINT: return createImage<int16_t>(arrayDimensions, width, height, depth, data, layout);
+        default: break;
+        }
 
-        auto raw = allocateAndCopyToContiguousBlock(ddsFile);
+        // otherwise fallback to an unsigned type of the same size, which includes the packed formats
+        switch (valueSize)
+        {
+        case 1: return createImage<uint8_t>(arrayDimensions, width, height, depth, data, layout);
+        case 2: return createImage<uint16_t>(arrayDimensions, width, height, depth, data, layout);
+        case 4: return createImage<uint32_t>(arrayDimensions, width, height, depth, data, layout);
+        case 8: return createImage<vsg::usvec4>(arrayDimensions, width, height, depth, data, layout);
+        case 16: return createImage<vsg::uivec4>(arrayDimensions, width, height, depth, data, layout);
+        default: return {};
+        }
+    }
 
-        vsg::ref_ptr<vsg::Data> vsg_data;
+    vsg::ref_ptr<vsg::Data> readDds(const DdsView& ddsFile, const vsg::Options* options)
+    {
+        const auto format = ddsFile.GetFormat();
+        const auto it = kFormatMap.find(format);
+        if (it == kFormatMap.end())
+        {
+            std::cerr << "dds::readDds() Format is not supported yet: " << (uint32_t)format << std::endl;
+            return {};
+        }
+
+        // drop the mip levels larger than the max_texture_size, the remaining levels are loaded as the texture
+        const uint32_t maxSize = maxTextureSize(options);
+        const uint32_t numMipMaps = ddsFile.GetMipCount();
+        const bool is3D = ddsFile.GetTextureDimension() == tinyddsloader::DDSFile::TextureDimension::Texture3D;
+        const uint32_t firstLevel = (numMipMaps > 1) ? std::min(downsampleLevels(ddsFile.GetWidth(), ddsFile.GetHeight(), is3D ? ddsFile.GetDepth() : 1, maxSize), numMipMaps - 1) : 0;
+        const auto baseImage = ddsFile.GetImageData(firstLevel, 0);
 
         vsg::Data::Properties layout;
-        layout.format = targetFormat;
-        layout.maxNumMipmaps = numMipMaps;
-        layout.blockWidth = 4;
-        layout.blockHeight = 4;
-        layout.imageViewType = computeImageViewType(ddsFile);
-
-        switch (targetFormat)
-        {
-        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
-        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
-        case VK_FORMAT_BC4_SNORM_BLOCK:
-        case VK_FORMAT_BC4_UNORM_BLOCK:
-            if (numArrays > 1)
-                vsg_data = vsg::block64Array3D::create(width / layout.blockWidth, height / layout.blockHeight, numArrays, reinterpret_cast<vsg::block64*>(raw), layout);
-            else
-                vsg_data = vsg::block64Array2D::create(width / layout.blockWidth, height / layout.blockHeight, reinterpret_cast<vsg::block64*>(raw), layout);
+        layout.format = it->second;
+        layout.maxNumMipmaps = static_cast<uint8_t>(numMipMaps - firstLevel);
+
+        uint32_t valueSize = tinyddsloader::DDSFile::GetBitsPerPixel(format) / 8;
+        if (tinyddsloader::DDSFile::IsCompressed(format))
+        {
+            layout.blockWidth = 4;
+            layout.blockHeight = 4;
+            // BC1 and BC4 are 4 bits per pixel, 8 bytes per block, the other BC formats 8 bits per pixel, 16 bytes per block
+            valueSize = tinyddsloader::DDSFile::GetBitsPerPixel(format) * 2;
+        }
+        layout.stride = valueSize;
+
+        // dimensions in blocks for the compressed formats
+        const uint32_t width = (baseImage->m_width + layout.blockWidth - 1) / layout.blockWidth;
+        uint32_t height = (baseImage->m_height + layout.blockHeight - 1) / layout.blockHeight;
+        const uint32_t numArrays = ddsFile.GetArraySize();
+
+        uint32_t arrayDimensions = 0;
+        uint32_t depth = 1;
+        switch (ddsFile.GetTextureDimension())
+        {
+        case tinyddsloader::DDSFile::TextureDimension::Texture1D:
+            // 1D arrays are stored as an Array2D with a row per array element
+            layout.imageViewType = (numArrays > 1) ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+            arrayDimensions = (numArrays > 1) ? 2 : 1;
+            height = numArrays;
             break;
-        case VK_FORMAT_BC2_UNORM_BLOCK:
-        case VK_FORMAT_BC2_SRGB_BLOCK:
-        case VK_FORMAT_BC3_UNORM_BLOCK:
-        case VK_FORMAT_BC3_SRGB_BLOCK:
-        case VK_FORMAT_BC5_UNORM_BLOCK:
-        case VK_FORMAT_BC5_SNORM_BLOCK:
-        case VK_FORMAT_BC7_UNORM_BLOCK:
-        case VK_FORMAT_BC7_SRGB_BLOCK:
-            if (numArrays > 1)
-                vsg_data = vsg::block128Array3D::create(width / layout.blockWidth, height / layout.blockHeight, numArrays, reinterpret_cast<vsg::block128*>(raw), layout);
+        case tinyddsloader::DDSFile::TextureDimension::Texture2D:
+            // the array size of cubemaps counts the faces, 6 per cube
+            if (ddsFile.IsCubemap())
+                layout.imageViewType = (numArrays > 6) ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
             else
-                vsg_data = vsg::block128Array2D::create(width / layout.blockWidth, height / layout.blockHeight, reinterpret_cast<vsg::block128*>(raw), layout);
+                layout.imageViewType = (numArrays > 1) ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+            arrayDimensions = (numArrays > 1) ? 3 : 2;
+            depth = numArrays;
             break;
-        default:
-            std::cerr << "dds::readCompressed() Format is not supported yet: " << (uint32_t)targetFormat << std::endl;
+        case tinyddsloader::DDSFile::TextureDimension::Texture3D:
+            layout.imageViewType = VK_IMAGE_VIEW_TYPE_3D;
+            arrayDimensions = 3;
+            depth = baseImage->m_depth;
             break;
+        default:
+            std::cerr << "dds::readDds() Num of dimension (" << (uint32_t)ddsFile.GetTextureDimension() << ")  not supported." << std::endl;
+            return {};
+        }
+
+        auto raw = allocateAndCopyToContiguousBlock(ddsFile, firstLevel);
+        if (!raw) return {};
+
+        vsg::ref_ptr<vsg::Data> vsg_data;
+        if (tinyddsloader::DDSFile::IsCompressed(format))
+        {
+            if (valueSize == 8)
+                vsg_data = createImage<vsg::block64>(arrayDimensions, width, height, depth, raw, layout);
+            else
+                vsg_data = createImage<vsg::block128>(arrayDimensions, width, height, depth, raw, layout);
+        }
+        else
+        {
+            vsg_data = createImage(arrayDimensions, width, height, depth, raw, layout, valueSize);
+        }
+
+        if (!vsg_data)
+        {
+            std::cerr << "dds::readDds() Unsupported value size " << valueSize << " of format " << (uint32_t)format << std::endl;
+            vsg::deallocate(raw);
         }
 
-        return vsg_data;
+        // decode the block compressed formats the device doesn't support, and box filter images without the mip levels to drop down when their format allows
+        vsg_data = decompressUnsupportedFormat(vsg_data, options);
+        return downsampleImage(vsg_data, maxSize);
     }
 
-    vsg::ref_ptr<vsg::Data> readDds(tinyddsloader::DDSFile& ddsFile)
+    template<typename T>
+    void writeValue(std::ostream& fout, T value)
     {
-        const auto width = ddsFile.GetWidth();
-        const auto height = ddsFile.GetHeight();
-        const auto depth = ddsFile.GetDepth();
-        const auto numMipMaps = ddsFile.GetMipCount();
-        const auto format = ddsFile.GetFormat();
-        const auto isCompressed = ddsFile.IsCompressed(format);
-        const auto dim = ddsFile.GetTextureDimension();
-        const auto numArrays = ddsFile.GetArraySize();
+        // DDS files are little endian
+        uint8_t bytes[sizeof(T)];
+        for (size_t i = 0; i < sizeof(T); ++i) bytes[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (i * 8));
+        fout.write(reinterpret_cast<const char*>(bytes), sizeof(T));
+    }
+
+    DXGIFormat dxgiFormat(VkFormat format)
+    {
+        for (auto& [dxgi, vk] : kFormatMap)
+        {
+            // the X8 formats map to the same VkFormat as their A8 equivalents, so prefer the A8 formats that retain alpha
+            if (vk == format && dxgi != DXGIFormat::B8G8R8X8_UNorm && dxgi != DXGIFormat::B8G8R8X8_UNorm_SRGB) return dxgi;
+        }
+        return DXGIFormat::Unknown;
+    }
 
-        // const auto valueCount = vsg::Data::computeValueCountIncludingMipmaps(width, height, depth, numMipMaps) * numArrays;
-        // const auto bpp = tinyddsloader::DDSFile::GetBitsPerPixel(format);
-        //std::cerr << "Fileinfo width: " << width << ", height: " << height << ", depth: " << depth << ", count: " << valueCount
-        //          << ", format: " << (int)format << ", bpp: " << tinyddsloader::DDSFile::GetBitsPerPixel(format)
-        //          << ", mipmaps: " << numMipMaps << ", arrays: " << numArrays
-        //          << std::boolalpha << ", cubemap: " << isCubemap << ", compressed: " << isCompressed << std::endl;
+    // write a vsg::Data, including the mipmaps, array layers and cubemap faces described by its Data::Properties, as a DDS file with a DX10 header
+    bool writeDds(const vsg::Data* data, std::ostream& fout)
+    {
+        const auto& layout = data->properties;
+        const auto format = dxgiFormat(layout.format);
+        if (format == DXGIFormat::Unknown)
+        {
+            std::cerr << "dds::write() VkFormat " << layout.format << " not supported." << std::endl;
+            return false;
+        }
 
-        if (auto it = kFormatMap.find(format); it != kFormatMap.end())
+        auto imageViewType = layout.imageViewType;
+        if (imageViewType == VK_IMAGE_VIEW_TYPE_MAX_ENUM)
         {
-            if (isCompressed)
+            switch (data->dimensions())
             {
-                return readCompressed(ddsFile, it->second);
+            case 1: imageViewType = VK_IMAGE_VIEW_TYPE_1D; break;
+            case 2: imageViewType = VK_IMAGE_VIEW_TYPE_2D; break;
+            default: imageViewType = VK_IMAGE_VIEW_TYPE_3D; break;
             }
-            else
-            {
-                auto raw = allocateAndCopyToContiguousBlock(ddsFile);
+        }
 
-                vsg::ref_ptr<vsg::Data> vsg_data;
+        // dimensions in blocks for compressed formats
+        const uint32_t width = data->width();
+        uint32_t height = data->height();
+        uint32_t depth = 1;
+        uint32_t numElements = 1;
+        auto dimension = tinyddsloader::DDSFile::TextureDimension::Texture2D;
+        bool cubemap = false;
 
-                vsg::Data::Properties layout;
-                layout.format = it->second;
-                layout.maxNumMipmaps = numMipMaps;
-                layout.imageViewType = computeImageViewType(ddsFile);
+        switch (imageViewType)
+        {
+        case VK_IMAGE_VIEW_TYPE_1D:
+        case VK_IMAGE_VIEW_TYPE_1D_ARRAY:
+            dimension = tinyddsloader::DDSFile::TextureDimension::Texture1D;
+            numElements = (imageViewType == VK_IMAGE_VIEW_TYPE_1D_ARRAY) ? data->height() : 1;
+            height = 1;
+            break;
+        case VK_IMAGE_VIEW_TYPE_2D:
+            break;
+        case VK_IMAGE_VIEW_TYPE_2D_ARRAY:
+            numElements = data->depth();
+            break;
+        case VK_IMAGE_VIEW_TYPE_CUBE:
+        case VK_IMAGE_VIEW_TYPE_CUBE_ARRAY:
+            if (data->depth() == 0 || (data->depth() % 6) != 0)
+            {
+                std::cerr << "dds::write() cubemap depth of " << data->depth() << " is not a multiple of 6." << std::endl;
+                return false;
+            }
+            numElements = data->depth();
+            cubemap = true;
+            break;
+        case VK_IMAGE_VIEW_TYPE_3D:
+            dimension = tinyddsloader::DDSFile::TextureDimension::Texture3D;
+            depth = data->depth();
+            break;
+        default:
+            std::cerr << "dds::write() imageViewType " << imageViewType << " not supported." << std::endl;
+            return false;
+        }
 
-                switch (dim)
-                {
-                case tinyddsloader::DDSFile::TextureDimension::Texture1D:
-                    switch (layout.format)
-                    {
-                        case VK_FORMAT_R32G32B32A32_SFLOAT:
-                            vsg_data = vsg::vec4Array::create(width, reinterpret_cast<vsg::vec4*>(raw), layout);
-                            break;
-                        case VK_FORMAT_R16G16B16A16_SFLOAT:
-                            vsg_data = vsg::usvec4Array::create(width, reinterpret_cast<vsg::usvec4*>(raw), layout);
-                            break;
-                        default:
-                            vsg_data = vsg::ubvec4Array::create(width, reinterpret_cast<vsg::ubvec4*>(raw), layout);
-                            break;
-                    }
-                    break;
-                case tinyddsloader::DDSFile::TextureDimension::Texture2D:
-                    if (numArrays > 1)
-                    {
-                        switch (layout.format)
-                        {
-                            case VK_FORMAT_R32G32B32A32_SFLOAT:
-                                vsg_data = vsg::vec4Array3D::create(width, height, numArrays, reinterpret_cast<vsg::vec4*>(raw), layout);
-                                break;
-                            case VK_FORMAT_R16G16B16A16_SFLOAT:
-                                vsg_data = vsg::usvec4Array3D::create(width, height, numArrays, reinterpret_cast<vsg::usvec4*>(raw), layout);
-                                break;
-                            default:
-                                vsg_data = vsg::ubvec4Array3D::create(width, height, numArrays, reinterpret_cast<vsg::ubvec4*>(raw), layout);
-                                break;
-                        }
-                    }
-                    else
-                    {
-                        switch (layout.format)
-                        {
-                            case VK_FORMAT_R32G32B32A32_SFLOAT:
-                                vsg_data = vsg::vec4Array2D::create(width, height, reinterpret_cast<vsg::vec4*>(raw), layout);
-                                break;
-                            case VK_FORMAT_R16G16B16A16_SFLOAT:
-                                vsg_data = vsg::usvec4Array2D::create(width, height, reinterpret_cast<vsg::usvec4*>(raw), layout);
-                                break;
-                            default:
-                                vsg_data = vsg::ubvec4Array2D::create(width, height, reinterpret_cast<vsg::ubvec4*>(raw), layout);
-                               break;
-                        }
-                    }
-                    break;
-                case tinyddsloader::DDSFile::TextureDimension::Texture3D:
-                    switch (layout.format)
-                    {
-                        case VK_FORMAT_R32G32B32A32_SFLOAT:
-                            vsg_data = vsg::vec4Array3D::create(width, height, depth, reinterpret_cast<vsg::vec4*>(raw), layout);
-                            break;
-                        case VK_FORMAT_R16G16B16A16_SFLOAT:
-                            vsg_data = vsg::usvec4Array3D::create(width, height, depth, reinterpret_cast<vsg::usvec4*>(raw), layout);
-                            break;
-                        default:
-                            vsg_data = vsg::ubvec4Array3D::create(width, height, depth, reinterpret_cast<vsg::ubvec4*>(raw), layout);
-                            break;
-                    }
-                    break;
-                case tinyddsloader::DDSFile::TextureDimension::Unknown:
-                    std::cerr << "dds::readDds() Num of dimension (" << (uint32_t)dim << ")  not supported." << std::endl;
-                    break;
-                }
+        const bool compressed = tinyddsloader::DDSFile::IsCompressed(format);
+        const size_t valueSize = data->valueSize();
+        const uint32_t numLevels = std::max(1u, static_cast<uint32_t>(layout.maxNumMipmaps));
 
-                //std::cout << "* Finish: " << valueCount * valueSize << ", " << vsg_data->dataSize() << std::endl;
+        // size of a single array element/face at each level, and the offset of each level in the vsg::Data, which stores all the elements of a level together
+        std::vector<size_t> imageSizes(numLevels);
+        std::vector<size_t> levelOffsets(numLevels);
+        size_t totalSize = 0;
+        for (uint32_t level = 0; level < numLevels; ++level)
+        {
+            imageSizes[level] = static_cast<size_t>(std::max(1u, width >> level)) * std::max(1u, height >> level) * std::max(1u, depth >> level) * valueSize;
+            levelOffsets[level] = totalSize;
+            totalSize += imageSizes[level] * numElements;
+        }
 
-                return vsg_data;
-            }
+        if (totalSize > data->dataSize())
+        {
+            std::cerr << "dds::write() vsg::Data is smaller than the mipmap levels its Data::Properties describe." << std::endl;
+            return false;
         }
-        else
+
+        enum : uint32_t
         {
-            std::cerr << "dds::readDds() Format is not supported yet: " << (uint32_t)format << std::endl;
+            DDSD_CAPS = 0x1,
+            DDSD_HEIGHT = 0x2,
+            DDSD_WIDTH = 0x4,
+            DDSD_PITCH = 0x8,
+            DDSD_PIXELFORMAT = 0x1000,
+            DDSD_MIPMAPCOUNT = 0x20000,
+            DDSD_LINEARSIZE = 0x80000,
+            DDSD_DEPTH = 0x800000,
+            DDPF_FOURCC = 0x4,
+            DDSCAPS_COMPLEX = 0x8,
+            DDSCAPS_TEXTURE = 0x1000,
+            DDSCAPS_MIPMAP = 0x400000,
+            DDSCAPS2_CUBEMAP_ALLFACES = 0xFE00,
+            DDSCAPS2_VOLUME = 0x200000,
+            DDS_RESOURCE_MISC_TEXTURECUBE = 0x4
+        };
+
+        uint32_t flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | (compressed ? DDSD_LINEARSIZE : DDSD_PITCH);
+        if (numLevels > 1) flags |= DDSD_MIPMAPCOUNT;
+        if (depth > 1) flags |= DDSD_DEPTH;
+
+        uint32_t caps = DDSCAPS_TEXTURE;
+        if (numLevels > 1) caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+        if (cubemap || depth > 1 || numElements > 1) caps |= DDSCAPS_COMPLEX;
+
+        uint32_t caps2 = 0;
+        if (cubemap) caps2 |= DDSCAPS2_CUBEMAP_ALLFACES;
+        if (depth > 1) caps2 |= DDSCAPS2_VOLUME;
+
+        // magic and DDS_HEADER
+        fout.write("DDS ", 4);
+        writeValue<uint32_t>(fout, 124);
+        writeValue<uint32_t>(fout, flags);
+        writeValue<uint32_t>(fout, height * layout.blockHeight);
+        writeValue<uint32_t>(fout, width * layout.blockWidth);
+        writeValue<uint32_t>(fout, static_cast<uint32_t>(compressed ? imageSizes[0] : width * valueSize));
+        writeValue<uint32_t>(fout, depth);
+        writeValue<uint32_t>(fout, numLevels);
+        for (int i = 0; i < 11; ++i) writeValue<uint32_t>(fout, 0);
+
+        // DDS_PIXELFORMAT, using a DX10 header to describe the format
+        writeValue<uint32_t>(fout, 32);
+        writeValue<uint32_t>(fout, DDPF_FOURCC);
+        writeValue<uint32_t>(fout, tinyddsloader::DDSFile::MakeFourCC('D', 'X', '1', '0'));
+        for (int i = 0; i < 5; ++i) writeValue<uint32_t>(fout, 0);
+
+        writeValue<uint32_t>(fout, caps);
+        writeValue<uint32_t>(fout, caps2);
+        for (int i = 0; i < 3; ++i) writeValue<uint32_t>(fout, 0);
+
+        // DDS_HEADER_DXT10
+        writeValue<uint32_t>(fout, static_cast<uint32_t>(format));
+        writeValue<uint32_t>(fout, static_cast<uint32_t>(dimension));
+        writeValue<uint32_t>(fout, cubemap ? DDS_RESOURCE_MISC_TEXTURECUBE : 0);
+        writeValue<uint32_t>(fout, cubemap ? numElements / 6 : numElements);
+        writeValue<uint32_t>(fout, 0);
+
+        // DDS stores each array element/face with its mip chain
+        auto source = static_cast<const char*>(data->dataPointer());
+        for (uint32_t element = 0; element < numElements; ++element)
+        {
+            for (uint32_t level = 0; level < numLevels; ++level)
+            {
+                fout.write(source + levelOffsets[level] + element * imageSizes[level], imageSizes[level]);
+            }
         }
 
-        return {};
+        return fout.good();
     }
 } // namespace
 
@@ -292,12 +757,24 @@ vsg::ref_ptr<vsg::Object> dds::read(const vsg::Path& filename, vsg::ref_ptr<cons
     vsg::Path filenameToUse = findFile(filename, options);
     if (!filenameToUse) return {};
 
-    tinyddsloader::DDSFile ddsFile;
+    DdsView ddsFile;
+    tinyddsloader::Result result = tinyddsloader::ErrorRead;
 
-    std::ifstream ifs(filenameToUse, std::ios_base::binary);
-    if (const auto result = ddsFile.Load(ifs); result == tinyddsloader::Success)
+    // parse directly from a memory mapping of the file, falling back to std::ifstream when the file can't be mapped, the mapping must remain valid until readDds() has copied the image data.
+    vsgXchange::MappedFile mappedFile(filenameToUse);
+    vsgXchange::StreamData input;
+    if (mappedFile)
     {
-        return readDds(ddsFile);
+        result = parseDds(mappedFile.data(), mappedFile.size(), ddsFile);
+    }
+    else if (std::ifstream ifs(filenameToUse, std::ios_base::binary); ifs && vsgXchange::readStream(ifs, input))
+    {
+        result = parseDds(input.data, input.size, ddsFile);
+    }
+
+    if (result == tinyddsloader::Success)
+    {
+        return readDds(ddsFile, options.get());
     }
     else
     {
@@ -319,10 +796,14 @@ vsg::ref_ptr<vsg::Object> dds::read(std::istream& fin, vsg::ref_ptr<const vsg::O
 {
     if (!vsg::compatibleExtension(options, _supportedExtensions)) return {};
 
-    tinyddsloader::DDSFile ddsFile;
-    if (const auto result = ddsFile.Load(fin); result == tinyddsloader::Success)
+    vsgXchange::StreamData input;
+    if (!vsgXchange::readStream(fin, input)) return {};
+
+    // parse in place, input retains the storage until readDds() has copied the image data
+    DdsView ddsFile;
+    if (const auto result = parseDds(input.data, input.size, ddsFile); result == tinyddsloader::Success)
     {
-        return readDds(ddsFile);
+        return readDds(ddsFile, options.get());
     }
     else
     {
@@ -344,10 +825,10 @@ vsg::ref_ptr<vsg::Object> dds::read(const uint8_t* ptr, size_t size, vsg::ref_pt
 {
     if (!vsg::compatibleExtension(options, _supportedExtensions)) return {};
 
-    tinyddsloader::DDSFile ddsFile;
-    if (const auto result = ddsFile.Load(ptr, size); result == tinyddsloader::Success)
+    DdsView ddsFile;
+    if (const auto result = parseDds(ptr, size, ddsFile); result == tinyddsloader::Success)
     {
-        return readDds(ddsFile);
+        return readDds(ddsFile, options.get());
     }
     else
     {
@@ -365,11 +846,45 @@ vsg::ref_ptr<vsg::Object> dds::read(const uint8_t* ptr, size_t size, vsg::ref_pt
     return {};
 }
 
+bool dds::write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!vsg::compatibleExtension(filename, options, _supportedExtensions)) return false;
+
+    auto data = object ? object->cast<vsg::Data>() : nullptr;
+    if (!data) return false;
+
+    std::ofstream fout(filename, std::ios::out | std::ios::binary);
+    if (!fout) return false;
+
+    return writeDds(data, fout);
+}
+
+bool dds::write(const vsg::Object* object, std::ostream& fout, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!vsg::compatibleExtension(options, _supportedExtensions)) return false;
+
+    auto data = object ? object->cast<vsg::Data>() : nullptr;
+    if (!data) return false;
+
+    return writeDds(data, fout);
+}
+
 bool dds::getFeatures(Features& features) const
 {
     for (auto& ext : _supportedExtensions)
     {
-        features.extensionFeatureMap[ext] = static_cast<vsg::ReaderWriter::FeatureMask>(vsg::ReaderWriter::READ_FILENAME | vsg::ReaderWriter::READ_ISTREAM | vsg::ReaderWriter::READ_MEMORY);
+        features.extensionFeatureMap[ext] = static_cast<vsg::ReaderWriter::FeatureMask>(vsg::ReaderWriter::READ_FILENAME | vsg::ReaderWriter::READ_ISTREAM | vsg::ReaderWriter::READ_MEMORY | vsg::ReaderWriter::WRITE_FILENAME | vsg::ReaderWriter::WRITE_OSTREAM);
     }
+
+    features.optionNameTypeMap[images::max_texture_size] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[images::supported_compressed_formats] = vsg::type_name<std::string>();
+
     return true;
 }
+
+bool dds::readOptions(vsg::Options& options, vsg::CommandLine& arguments) const
+{
+    bool result = arguments.readAndAssign<uint32_t>(images::max_texture_size, &options);
+    result = arguments.readAndAssign<std::string>(images::supported_compressed_formats, &options) || result;
+    return result;
+}
@@ -21,3 +21,7 @@ else()
         freetype/freetype_fallback.cpp
     )
 endif()
+
+set(SOURCES ${SOURCES}
+    freetype/msdf_shader_set.cpp
+)
@@ -10,10 +10,15 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <vsgXchange/cancellation.h>
 #include <vsgXchange/freetype.h>
 
+#include "../all/mapped_file.h"
+
 #include <vsg/core/Exception.h>
+#include <vsg/io/FileSystem.h>
 #include <vsg/io/Logger.h>
+#include <vsg/io/VSG.h>
 #include <vsg/nodes/Geometry.h>
 #include <vsg/nodes/Group.h>
 #include <vsg/state/ShaderStage.h>
@@ -24,9 +29,17 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include FT_FREETYPE_H
 #include FT_OUTLINE_H
 
-#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <set>
+#include <sstream>
+#include <thread>
+#include <type_traits>
 
 namespace vsgXchange
 {
@@ -47,17 +60,26 @@ namespace vsgXchange
             return (c <= b) && (b < a);
     }
 
+    /// component type of the atlas texels, scalar for single channel signed distance fields and the vec4 element type for multi-channel signed distance fields
+    template<typename T>
+    struct sdf_component
+    {
+        using type = T;
+    };
+
+    template<typename T>
+    struct sdf_component<vsg::t_vec4<T>>
+    {
+        using type = T;
+    };
+
     class freetype::Implementation
     {
     public:
         Implementation();
 
-        void init() const;
-
         vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const;
 
-        ~Implementation();
-
         struct Contour
         {
             std::vector<vsg::vec2> points;
@@ -66,16 +88,154 @@ namespace vsgXchange
 
         using Contours = std::list<Contour>;
 
+        struct Extents
+        {
+            float min_x = std::numeric_limits<float>::max();
+            float max_x = std::numeric_limits<float>::lowest();
+            float min_y = std::numeric_limits<float>::max();
+            float max_y = std::numeric_limits<float>::lowest();
+
+            void add(const vsg::vec2& v)
+            {
+                if (v.x < min_x) min_x = v.x;
+                if (v.y < min_y) min_y = v.y;
+                if (v.x > max_x) max_x = v.x;
+                if (v.y > max_y) max_y = v.y;
+            }
+
+            bool contains(const vsg::vec2& v) const
+            {
+                return v.x >= min_x && v.x <= max_x &&
+                       v.y >= min_y && v.y <= max_y;
+            }
+        };
+
+        /// channel masks of the multi-channel signed distance field edge colours
+        enum EdgeColour : uint8_t
+        {
+            RED = 1,
+            GREEN = 2,
+            BLUE = 4,
+            YELLOW = RED | GREEN,
+            MAGENTA = RED | BLUE,
+            CYAN = GREEN | BLUE,
+            WHITE = RED | GREEN | BLUE
+        };
+
+        /// line segment of a contour, edge holds the normalized direction and length of p0 to p1.
+        /// colour is the channels of a multi-channel signed distance field the segment contributes to, span_start/span_end mark the segments at the corners that bound each run of same coloured segments.
+        struct Segment
+        {
+            vsg::vec2 p0;
+            vsg::vec2 p1;
+            vsg::vec3 edge;
+            uint8_t colour = WHITE;
+            bool span_start = false;
+            bool span_end = false;
+        };
+
+        using Segments = std::vector<Segment>;
+
+        /// uniform grid of a glyph's contour segments, so distance and inside/outside queries only test the segments near the query point
+        struct SegmentGrid
+        {
+            vsg::vec2 origin;
+            float cellSize = 1.0f;
+            int columns = 0;
+            int rows = 0;
+            std::vector<Segment> segments;
+            std::vector<uint32_t> cellOffsets;  // columns * rows + 1 offsets into cellSegments
+            std::vector<uint32_t> cellSegments; // segments whose bounding box overlaps each cell
+            std::vector<uint32_t> rowOffsets;   // rows + 1 offsets into rowSegments
+            std::vector<uint32_t> rowSegments;  // segments whose y range overlaps each row of cells
+
+            void build(const Contours& contours, const vsg::vec2& min, const vsg::vec2& max, float in_cellSize);
+            void build(Segments in_segments, const vsg::vec2& min, const vsg::vec2& max, float in_cellSize);
+
+            int column(float x) const { return std::clamp(static_cast<int>(std::floor((x - origin.x) / cellSize)), 0, columns - 1); }
+            int row(float y) const { return std::clamp(static_cast<int>(std::floor((y - origin.y) / cellSize)), 0, rows - 1); }
+        };
+
+        /// outline of a glyph and its position in the atlas
+        struct GlyphOutline
+        {
+            Contours contours;
+            Extents extents;
+            unsigned int xpos = 0;
+            unsigned int ypos = 0;
+            unsigned int width = 0;
+            unsigned int height = 0;
+        };
+
+        struct GlyphQuad
+        {
+            FT_ULong charcode;
+            FT_ULong glyph_index;
+            unsigned int width;
+            unsigned int height;
+            inline bool operator<(const GlyphQuad& rhs) const { return height < rhs.height; }
+        };
+
+        using GlyphQuads = std::multiset<GlyphQuad>;
+
+        /// inclusive ranges of charcodes to generate glyphs for, empty for all the charcodes of the face
+        using CharacterRanges = std::vector<std::pair<FT_ULong, FT_ULong>>;
+
+        /// settings used to generate the glyphs of a font
+        struct FontSettings
+        {
+            FT_UInt pixel_size = 48;
+            float freetype_pixel_size_scale = 1.0f / 64.0f;
+            unsigned int texel_margin = 0;
+            unsigned int quad_margin = 0;
+            uint32_t numThreads = 1;
+            FT_Int32 load_flags = FT_LOAD_NO_BITMAP;
+            const CancellationToken* cancellation = nullptr; // polled between glyphs, renderGlyphs() stops early once cancelled
+        };
+
+        /// keys of the values assigned to generated vsg::Font so glyphs can be added later
+        static constexpr const char* font_filename = "freetype_filename";
+        static constexpr const char* font_num_glyphs = "freetype_num_glyphs";
+
+        uint32_t addGlyphs(vsg::Font& font, const std::vector<uint32_t>& charcodes, vsg::ref_ptr<const vsg::Options> options) const;
+
+        bool parseCharacterSet(const std::string& str, CharacterRanges& ranges) const;
+        vsg::Path fontCacheFilename(const vsg::Path& cacheDirectory, const vsg::Path& filename, const std::string& settings) const;
+        void writeToFontCache(const vsg::Font& font, const vsg::Path& cacheFilename) const;
+        /// FT_Library and FT_Face used by a single read, FreeType objects aren't thread safe so each read creates its own so that reads of different fonts can run concurrently
+        struct FontFace
+        {
+            FT_Library library = nullptr;
+            FT_Face face = nullptr;
+
+            FontFace() = default;
+            FontFace(const FontFace&) = delete;
+            FontFace& operator=(const FontFace&) = delete;
+            ~FontFace();
+        };
+
+        bool openFace(const vsg::Path& filename, FT_UInt pixel_size, FontFace& fontFace) const;
+        void collectGlyphs(FT_Face face, const CharacterRanges& ranges, const vsg::uintArray* existing, const FontSettings& settings, GlyphQuads& sortedGlyphQuads, FT_ULong& max_charcode) const;
+        unsigned int layoutGlyphs(const GlyphQuads& sortedGlyphQuads, unsigned int width, unsigned int ystart, const FontSettings& settings, std::vector<vsg::uivec2>& positions) const;
+        vsg::ref_ptr<vsg::Data> createAtlas(VkFormat format, uint32_t width, uint32_t height) const;
+        uint32_t renderGlyphs(FT_Face face, const GlyphQuads& sortedGlyphQuads, const std::vector<vsg::uivec2>& positions, vsg::Data& atlas,
+                              vsg::GlyphMetricsArray& glyphMetrics, uint32_t destination_glyphindex, vsg::uintArray& charmap, const FontSettings& settings) const;
+
+        template<class A>
+        uint32_t renderGlyphs(FT_Face face, const GlyphQuads& sortedGlyphQuads, const std::vector<vsg::uivec2>& positions, A& atlas,
+                              vsg::GlyphMetricsArray& glyphMetrics, uint32_t destination_glyphindex, vsg::uintArray& charmap, const FontSettings& settings) const;
+
         unsigned char nearest_edge(const FT_Bitmap& glyph_bitmap, int c, int r, int delta) const;
         vsg::ref_ptr<vsg::Group> createOutlineGeometry(const Contours& contours) const;
         bool generateOutlines(FT_Outline& outline, Contours& contours) const;
         void checkForAndFixDegenerates(Contours& contours) const;
-        float nearest_contour_edge(const Contours& local_contours, const vsg::vec2& v) const;
-        bool outside_contours(const Contours& local_contours, const vsg::vec2& v) const;
+        float nearest_contour_edge(const SegmentGrid& grid, const vsg::vec2& v, float max_distance) const;
+        void colourEdges(const Contours& contours, Segments& segments) const;
+        float contours_orientation(const Contours& contours) const;
+        float nearest_pseudo_distance(const SegmentGrid& grid, const vsg::vec2& v, float max_distance, float orientation, float fallback) const;
+        bool outside_contours(const SegmentGrid& grid, const vsg::vec2& v) const;
 
         std::map<vsg::Path, std::string> _supportedFormats;
-        mutable std::mutex _mutex;
-        mutable FT_Library _library = nullptr;
     };
 
 } // namespace vsgXchange
@@ -99,6 +259,11 @@ vsg::ref_ptr<vsg::Object> freetype::read(const vsg::Path& filename, vsg::ref_ptr
     return _implementation->read(filename, options);
 }
 
+uint32_t freetype::addGlyphs(vsg::Font& font, const std::vector<uint32_t>& charcodes, vsg::ref_ptr<const vsg::Options> options) const
+{
+    return _implementation->addGlyphs(font, charcodes, options);
+}
+
 bool freetype::getFeatures(Features& features) const
 {
     for (auto& ext : _implementation->_supportedFormats)
@@ -109,6 +274,13 @@ bool freetype::getFeatures(Features& features) const
     // enumerate the supported vsg::Options::setValue(str, value) options
     features.optionNameTypeMap[freetype::texel_margin_ratio] = vsg::type_name<float>();
     features.optionNameTypeMap[freetype::quad_margin_ratio] = vsg::type_name<float>();
+    features.optionNameTypeMap[freetype::num_threads] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[freetype::character_set] = vsg::type_name<std::string>();
+    features.optionNameTypeMap[freetype::pixel_size] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[freetype::atlas_format] = vsg::type_name<std::string>();
+    features.optionNameTypeMap[freetype::max_atlas_size] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[freetype::font_cache] = vsg::type_name<std::string>();
+    features.optionNameTypeMap[freetype::msdf] = vsg::type_name<bool>();
 
     return true;
 }
@@ -117,6 +289,13 @@ bool freetype::readOptions(vsg::Options& options, vsg::CommandLine& arguments) c
 {
     bool result = arguments.readAndAssign<float>(freetype::texel_margin_ratio, &options);
     result = arguments.readAndAssign<float>(freetype::quad_margin_ratio, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(freetype::num_threads, &options) || result;
+    result = arguments.readAndAssign<std::string>(freetype::character_set, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(freetype::pixel_size, &options) || result;
+    result = arguments.readAndAssign<std::string>(freetype::atlas_format, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(freetype::max_atlas_size, &options) || result;
+    result = arguments.readAndAssign<std::string>(freetype::font_cache, &options) || result;
+    result = arguments.readAndAssign<bool>(freetype::msdf, &options) || result;
     return result;
 }
 
@@ -139,28 +318,10 @@ freetype::Implementation::Implementation()
     _supportedFormats[".woff"] = "web open font format";
 }
 
-freetype::Implementation::~Implementation()
+freetype::Implementation::FontFace::~FontFace()
 {
-    if (_library)
-    {
-        // std::cout<<"freetype::Implementation::~freetype::Implementation() FT_Done_FreeType library = "<<_library<<std::endl;
-        FT_Done_FreeType(_library);
-    }
-}
-
-void freetype::Implementation::init() const
-{
-    if (_library) return;
-
-    int error = FT_Init_FreeType(&_library);
-    if (error)
-    {
-        // std::cout<<"freetype::Implementation::init() failed."<<std::endl;
-        return;
-        //throw vsg::Exception{"FreeType error occurred during library initialization", error};
-    }
-
-    // std::cout<<"freetype::Implementation() FT_Init_FreeType library = "<<_library<<std::endl;
+    if (face) FT_Done_Face(face);
+    if (library) FT_Done_FreeType(library);
 }
 
 unsigned char freetype::Implementation::nearest_edge(const FT_Bitmap& glyph_bitmap, int c, int r, int delta) const
@@ -435,17 +596,84 @@ void freetype::Implementation::checkForAndFixDegenerates(Contours& contours) con
     }
 }
 
-float freetype::Implementation::nearest_contour_edge(const Contours& local_contours, const vsg::vec2& v) const
+void freetype::Implementation::SegmentGrid::build(const Contours& contours, const vsg::vec2& min, const vsg::vec2& max, float in_cellSize)
 {
-    float min_distance = std::numeric_limits<float>::max();
-    for (auto& contour : local_contours)
+    Segments contourSegments;
+    for (auto& contour : contours)
     {
         auto& points = contour.points;
         auto& edges = contour.edges;
         for (size_t i = 0; i < edges.size(); ++i)
         {
-            auto& p0 = points[i];
-            auto& edge = edges[i];
+            contourSegments.push_back(Segment{points[i], points[i + 1], edges[i]});
+        }
+    }
+
+    build(std::move(contourSegments), min, max, in_cellSize);
+}
+
+void freetype::Implementation::SegmentGrid::build(Segments in_segments, const vsg::vec2& min, const vsg::vec2& max, float in_cellSize)
+{
+    origin = min;
+    cellSize = in_cellSize;
+    columns = std::max(1, static_cast<int>(std::ceil((max.x - min.x) / cellSize)));
+    rows = std::max(1, static_cast<int>(std::ceil((max.y - min.y) / cellSize)));
+
+    segments = std::move(in_segments);
+
+    // bin the segments by the cells their bounding boxes overlap, clamped to the grid, using two passes to count then fill
+    cellOffsets.assign(static_cast<size_t>(columns * rows) + 1, 0);
+    rowOffsets.assign(static_cast<size_t>(rows) + 1, 0);
+
+    auto forEachSegmentCell = [&](auto func) {
+        for (uint32_t s = 0; s < static_cast<uint32_t>(segments.size()); ++s)
+        {
+            auto& segment = segments[s];
+            int c0 = column(std::min(segment.p0.x, segment.p1.x));
+            int c1 = column(std::max(segment.p0.x, segment.p1.x));
+            int r0 = row(std::min(segment.p0.y, segment.p1.y));
+            int r1 = row(std::max(segment.p0.y, segment.p1.y));
+            for (int r = r0; r <= r1; ++r)
+            {
+                func(s, r, -1);
+                for (int c = c0; c <= c1; ++c) func(s, r, c);
+            }
+        }
+    };
+
+    forEachSegmentCell([&](uint32_t, int r, int c) {
+        if (c < 0)
+            ++rowOffsets[r + 1];
+        else
+            ++cellOffsets[r * columns + c + 1];
+    });
+
+    for (size_t i = 1; i < cellOffsets.size(); ++i) cellOffsets[i] += cellOffsets[i - 1];
+    for (size_t i = 1; i < rowOffsets.size(); ++i) rowOffsets[i] += rowOffsets[i - 1];
+
+    cellSegments.resize(cellOffsets.back());
+    rowSegments.resize(rowOffsets.back());
+
+    std::vector<uint32_t> cellFill(cellOffsets.begin(), cellOffsets.end() - 1);
+    std::vector<uint32_t> rowFill(rowOffsets.begin(), rowOffsets.end() - 1);
+    forEachSegmentCell([&](uint32_t s, int r, int c) {
+        if (c < 0)
+            rowSegments[rowFill[r]++] = s;
+        else
+            cellSegments[cellFill[r * columns + c]++] = s;
+    });
+}
+
+float freetype::Implementation::nearest_contour_edge(const SegmentGrid& grid, const vsg::vec2& v, float max_distance) const
+{
+    float min_distance = max_distance * max_distance;
+
+    auto test_cell = [&](int c, int r) {
+        for (uint32_t i = grid.cellOffsets[r * grid.columns + c]; i < grid.cellOffsets[r * grid.columns + c + 1]; ++i)
+        {
+            auto& segment = grid.segments[grid.cellSegments[i]];
+            auto& p0 = segment.p0;
+            auto& edge = segment.edge;
 
             vsg::vec2 v_p0 = v - p0;
             float dot_v_p0 = v_p0.x * edge.x + v_p0.y * edge.y;
@@ -462,71 +690,264 @@ float freetype::Implementation::nearest_contour_edge(const Contours& local_conto
                 if (distance < min_distance) min_distance = distance;
             }
         }
+    };
+
+    // search rings of cells outwards from the cell containing v, cells in ring k + 1 are at least k cells away so once
+    // the nearest edge found is closer than that, or max_distance has been exceeded, no further ring can contain a closer edge.
+    int cv = grid.column(v.x);
+    int rv = grid.row(v.y);
+    int max_ring = static_cast<int>(std::ceil(max_distance / grid.cellSize)) + 1;
+    for (int k = 0; k <= max_ring; ++k)
+    {
+        int c0 = cv - k, c1 = cv + k, r0 = rv - k, r1 = rv + k;
+        if (c0 < 0 && r0 < 0 && c1 >= grid.columns && r1 >= grid.rows) break;
+
+        for (int r = std::max(r0, 0); r <= std::min(r1, grid.rows - 1); ++r)
+        {
+            if (r == r0 || r == r1)
+            {
+                for (int c = std::max(c0, 0); c <= std::min(c1, grid.columns - 1); ++c) test_cell(c, r);
+            }
+            else
+            {
+                if (c0 >= 0) test_cell(c0, r);
+                if (c1 < grid.columns && c1 != c0) test_cell(c1, r);
+            }
+        }
+
+        float ring_distance = float(k) * grid.cellSize;
+        if (min_distance <= ring_distance * ring_distance) break;
     }
+
     return sqrt(min_distance);
 };
 
-bool freetype::Implementation::outside_contours(const Contours& local_contours, const vsg::vec2& v) const
+void freetype::Implementation::colourEdges(const Contours& contours, Segments& segments) const
 {
-    uint32_t numLeft = 0;
-    for (auto& contour : local_contours)
+    // consecutive segments whose directions differ by more than this are treated as meeting at a corner
+    const float corner_threshold = std::cos(vsg::radians(30.0f));
+    const uint8_t colours[] = {CYAN, MAGENTA, YELLOW};
+
+    segments.clear();
+    for (auto& contour : contours)
     {
         auto& points = contour.points;
-        for (size_t i = 0; i < points.size() - 1; ++i)
+        auto& edges = contour.edges;
+        size_t n = edges.size();
+        if (n == 0) continue;
+
+        size_t first = segments.size();
+        for (size_t i = 0; i < n; ++i)
         {
-            auto& p0 = points[i];
-            auto& p1 = points[i + 1];
+            segments.push_back(Segment{points[i], points[i + 1], edges[i]});
+        }
+
+        std::vector<size_t> corners;
+        for (size_t i = 0; i < n; ++i)
+        {
+            auto& previous = edges[(i + n - 1) % n];
+            auto& current = edges[i];
+            if (previous.x * current.x + previous.y * current.y < corner_threshold) corners.push_back(i);
+        }
+
+        // smooth contours have no corners to preserve so contribute to all channels
+        if (corners.empty()) continue;
 
-            if (p0 == v || p1 == v)
+        if (corners.size() == 1)
+        {
+            // a single corner needs differently coloured edges either side of it, so split the contour into three spans
+            size_t start = corners.front();
+            for (size_t i = 0; i < n; ++i)
             {
-                // std::cout<<"v = "<<v<<" on end point p0="<<p0<<", p1"<<p1<<std::endl;
-                return false;
+                segments[first + (start + i) % n].colour = colours[(3 * i) / n];
             }
+            segments[first + start].span_start = true;
+            segments[first + (start + n - 1) % n].span_end = true;
+            continue;
+        }
 
-            if (p0.y == p1.y) // horizontal
+        // cycle the colours of the spans between corners so neighbouring spans share only one channel,
+        // when the last span would get the same colour as the first it's given a colour different to both of its neighbours
+        size_t numSpans = corners.size();
+        for (size_t s = 0; s < numSpans; ++s)
+        {
+            uint8_t colour = colours[s % 3];
+            if (s == numSpans - 1 && s % 3 == 0) colour = MAGENTA;
+
+            size_t begin = corners[s];
+            size_t end = corners[(s + 1) % numSpans];
+            for (size_t i = begin; i != end; i = (i + 1) % n)
             {
-                if (p0.y == v.y)
+                segments[first + i].colour = colour;
+            }
+            segments[first + begin].span_start = true;
+            segments[first + (end + n - 1) % n].span_end = true;
+        }
+    }
+}
+
+float freetype::Implementation::contours_orientation(const Contours& contours) const
+{
+    // the contour enclosing the largest area is an outer contour, so the sign of its area gives which side of the segments is inside the glyph
+    float largest_area = 0.0f;
+    for (auto& contour : contours)
+    {
+        auto& points = contour.points;
+        float area = 0.0f;
+        for (size_t i = 0; i + 1 < points.size(); ++i)
+        {
+            area += points[i].x * points[i + 1].y - points[i + 1].x * points[i].y;
+        }
+        if (std::abs(area) > std::abs(largest_area)) largest_area = area;
+    }
+    return largest_area < 0.0f ? -1.0f : 1.0f;
+}
+
+float freetype::Implementation::nearest_pseudo_distance(const SegmentGrid& grid, const vsg::vec2& v, float max_distance, float orientation, float fallback) const
+{
+    const Segment* nearest = nullptr;
+    float min_distance = max_distance;
+    float min_orthogonality = 1.0f;
+    float nearest_side = 0.0f;
+    float nearest_dot = 0.0f;
+
+    auto test_cell = [&](int c, int r) {
+        for (uint32_t i = grid.cellOffsets[r * grid.columns + c]; i < grid.cellOffsets[r * grid.columns + c + 1]; ++i)
+        {
+            auto& segment = grid.segments[grid.cellSegments[i]];
+            auto& edge = segment.edge;
+
+            vsg::vec2 v_p0 = v - segment.p0;
+            float dot_v_p0 = v_p0.x * edge.x + v_p0.y * edge.y;
+            float side = edge.x * v_p0.y - edge.y * v_p0.x;
+
+            // distance to the segment, and how orthogonal v is to the segment so ties at shared end points go to the segment v is most perpendicular to
+            float distance, orthogonality;
+            if (dot_v_p0 > 0.0f && dot_v_p0 < edge.z)
+            {
+                distance = std::abs(side);
+                orthogonality = 0.0f;
+            }
+            else
+            {
+                vsg::vec2 v_end = (dot_v_p0 <= 0.0f) ? v_p0 : (v - segment.p1);
+                distance = vsg::length(v_end);
+                orthogonality = distance > 0.0f ? std::abs(v_end.x * edge.x + v_end.y * edge.y) / distance : 0.0f;
+            }
+
+            if (distance < min_distance || (distance == min_distance && nearest && orthogonality < min_orthogonality))
+            {
+                nearest = &segment;
+                min_distance = distance;
+                min_orthogonality = orthogonality;
+                nearest_side = side;
+                nearest_dot = dot_v_p0;
+            }
+        }
+    };
+
+    // same ring search as nearest_contour_edge()
+    int cv = grid.column(v.x);
+    int rv = grid.row(v.y);
+    int max_ring = static_cast<int>(std::ceil(max_distance / grid.cellSize)) + 1;
+    for (int k = 0; k <= max_ring; ++k)
+    {
+        int c0 = cv - k, c1 = cv + k, r0 = rv - k, r1 = rv + k;
+        if (c0 < 0 && r0 < 0 && c1 >= grid.columns && r1 >= grid.rows) break;
+
+        for (int r = std::max(r0, 0); r <= std::min(r1, grid.rows - 1); ++r)
+        {
+            if (r == r0 || r == r1)
+            {
+                for (int c = std::max(c0, 0); c <= std::min(c1, grid.columns - 1); ++c) test_cell(c, r);
+            }
+            else
+            {
+                if (c0 >= 0) test_cell(c0, r);
+                if (c1 < grid.columns && c1 != c0) test_cell(c1, r);
+            }
+        }
+
+        if (min_distance <= float(k) * grid.cellSize) break;
+    }
+
+    if (!nearest) return fallback;
+
+    float sign = (nearest_side < 0.0f) ? -orientation : orientation;
+    float distance = sign * min_distance;
+
+    // beyond the corner ends of a span use the distance to the extended segment so the channels' edges stay straight up to the corner
+    bool beforeStart = nearest->span_start && nearest_dot < 0.0f;
+    bool afterEnd = nearest->span_end && nearest_dot > nearest->edge.z;
+    if ((beforeStart || afterEnd) && std::abs(nearest_side) <= min_distance)
+    {
+        distance = sign * std::abs(nearest_side);
+    }
+
+    return distance;
+}
+
+bool freetype::Implementation::outside_contours(const SegmentGrid& grid, const vsg::vec2& v) const
+{
+    // only the segments that overlap the row of cells containing v can cross the horizontal line through v
+    int rv = grid.row(v.y);
+
+    uint32_t numLeft = 0;
+    for (uint32_t i = grid.rowOffsets[rv]; i < grid.rowOffsets[rv + 1]; ++i)
+    {
+        auto& segment = grid.segments[grid.rowSegments[i]];
+        auto& p0 = segment.p0;
+        auto& p1 = segment.p1;
+
+        if (p0 == v || p1 == v)
+        {
+            // std::cout<<"v = "<<v<<" on end point p0="<<p0<<", p1"<<p1<<std::endl;
+            return false;
+        }
+
+        if (p0.y == p1.y) // horizontal
+        {
+            if (p0.y == v.y)
+            {
+                // v same height as segment
+                if (between_or_equal(p0.x, v.x, p1.x))
                 {
-                    // v same height as segment
-                    if (between_or_equal(p0.x, v.x, p1.x))
-                    {
-                        // std::cout<<"Right on horizontal line v="<<v<<", p0 = "<<p0<<", p1 = "<<p1<<std::endl;
-                        return false;
-                    }
+                    // std::cout<<"Right on horizontal line v="<<v<<", p0 = "<<p0<<", p1 = "<<p1<<std::endl;
+                    return false;
                 }
             }
-            else if (p0.x == p1.x) // vertical
+        }
+        else if (p0.x == p1.x) // vertical
+        {
+            if (between_not_equal(p0.y, v.y, p1.y))
             {
-                if (between_not_equal(p0.y, v.y, p1.y))
+                if (v.x == p0.x)
                 {
-                    if (v.x == p0.x)
-                    {
-                        // std::cout<<"Right on vertical line v="<<v<<", p0 = "<<p0<<", p1 = "<<p1<<std::endl;
-                        return false;
-                    }
-                    else if (p0.x < v.x)
-                    {
-                        ++numLeft;
-                    }
+                    // std::cout<<"Right on vertical line v="<<v<<", p0 = "<<p0<<", p1 = "<<p1<<std::endl;
+                    return false;
+                }
+                else if (p0.x < v.x)
+                {
+                    ++numLeft;
                 }
             }
-            else // diagonal
+        }
+        else // diagonal
+        {
+            if (between_not_equal(p0.y, v.y, p1.y))
             {
-                if (between_not_equal(p0.y, v.y, p1.y))
+                if (v.x > p0.x && v.x > p1.x)
                 {
-                    if (v.x > p0.x && v.x > p1.x)
-                    {
-                        // segment wholly left of v
-                        ++numLeft;
-                    }
-                    else if (between_or_equal(p0.x, v.x, p1.x))
-                    {
-                        // segment wholly right of v
-                        // need to do intersection test
-                        float r = (v.y - p0.y) / (p1.y - p0.y);
-                        float x_intersection = p0.x + (p1.x - p0.x) * r;
-                        if (x_intersection < v.x) ++numLeft;
-                    }
+                    // segment wholly left of v
+                    ++numLeft;
+                }
+                else if (between_or_equal(p0.x, v.x, p1.x))
+                {
+                    // segment wholly right of v
+                    // need to do intersection test
+                    float r = (v.y - p0.y) / (p1.y - p0.y);
+                    float x_intersection = p0.x + (p1.x - p0.x) * r;
+                    if (x_intersection < v.x) ++numLeft;
                 }
             }
         }
@@ -534,228 +955,344 @@ bool freetype::Implementation::outside_contours(const Contours& local_contours,
     return (numLeft % 2) == 0;
 }
 
-vsg::ref_ptr<vsg::Object> freetype::Implementation::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+bool freetype::Implementation::parseCharacterSet(const std::string& str, CharacterRanges& ranges) const
 {
-    vsg::Path ext = (options && options->extensionHint) ? options->extensionHint : vsg::lowerCaseFileExtension(filename);
-    if (_supportedFormats.find(ext) == _supportedFormats.end()) return {};
+    ranges.clear();
 
-    vsg::Path filenameToUse = findFile(filename, options);
-    if (!filenameToUse) return {};
+    std::stringstream sstr(str);
+    std::string item;
+    while (std::getline(sstr, item, ','))
+    {
+        auto dash = item.find('-', 1);
+        try
+        {
+            FT_ULong first = std::stoul(item.substr(0, dash), nullptr, 0);
+            FT_ULong last = (dash == std::string::npos) ? first : std::stoul(item.substr(dash + 1), nullptr, 0);
+            if (last < first) std::swap(first, last);
+            ranges.emplace_back(first, last);
+        }
+        catch (...)
+        {
+            vsg::warn("freetype::read() invalid character_set entry \"", item, "\".");
+            return false;
+        }
+    }
+    return !ranges.empty();
+}
 
-    std::scoped_lock<std::mutex> lock(_mutex);
+vsg::Path freetype::Implementation::fontCacheFilename(const vsg::Path& cacheDirectory, const vsg::Path& filename, const std::string& settings) const
+{
+    // FNV-1a hash of the font file's contents and the settings used to generate the font
+    auto hash = [](uint64_t value, const uint8_t* ptr, size_t size) {
+        for (const uint8_t* end = ptr + size; ptr != end; ++ptr) value = (value ^ *ptr) * 0x100000001b3ull;
+        return value;
+    };
 
-    init();
-    if (!_library) return {};
+    MappedFile file(filename);
+    if (!file) return {};
 
-    FT_Face face;
-    FT_Long face_index = 0;
+    uint64_t value = hash(0xcbf29ce484222325ull, file.data(), file.size());
+    value = hash(value, reinterpret_cast<const uint8_t*>(settings.data()), settings.size());
 
-    // Windows workaround for no wchar_t support in Freetype, convert vsg::Path's std::wstring to UTF8 std::string
-    std::string filenameToUse_string = filenameToUse.string();
-    int error = FT_New_Face(_library, filenameToUse_string.c_str(), face_index, &face);
-    if (error == FT_Err_Unknown_File_Format)
+    std::stringstream str;
+    str << vsg::simpleFilename(filename) << "_" << std::hex << std::setw(16) << std::setfill('0') << value << ".vsgb";
+    return cacheDirectory / str.str();
+}
+
+void freetype::Implementation::writeToFontCache(const vsg::Font& font, const vsg::Path& cacheFilename) const
+{
+    auto directory = vsg::filePath(cacheFilename);
+    if (!vsg::fileExists(directory) && !vsg::makeDirectory(directory))
     {
-        std::cout << "Warning: FreeType unable to read font file : " << filenameToUse << ", error = " << FT_Err_Unknown_File_Format << std::endl;
-        return {};
+        vsg::warn("freetype::read() unable to create font_cache directory ", directory);
+        return;
     }
-    else if (error)
+
+    // write to a temporary file then rename it so concurrent readers never see a partially written file
+    std::stringstream suffix;
+    suffix << "." << std::hex << std::hash<std::thread::id>{}(std::this_thread::get_id()) << ".vsgb";
+    vsg::Path temporaryFilename = vsg::removeExtension(cacheFilename).string() + suffix.str();
+
+    if (!vsg::VSG().write(&font, temporaryFilename))
     {
-        std::cout << "Warning: FreeType unable to read font file : " << filenameToUse << ", error = " << error << std::endl;
-        return {};
+        vsg::warn("freetype::read() unable to write to font_cache ", cacheFilename);
+        return;
     }
 
-    FT_UInt pixel_size = 48;
-    FT_UInt freetype_pixel_size = pixel_size;
-    float freetype_pixel_size_scale = float(pixel_size) / (64.0f * float(freetype_pixel_size));
+    if (std::rename(temporaryFilename.string().c_str(), cacheFilename.string().c_str()) != 0)
+    {
+        std::remove(temporaryFilename.string().c_str());
+    }
+}
 
+bool freetype::Implementation::openFace(const vsg::Path& filename, FT_UInt pixel_size, FontFace& fontFace) const
+{
+    int error = FT_Init_FreeType(&fontFace.library);
+    if (error)
     {
-        error = FT_Set_Pixel_Sizes(face, freetype_pixel_size, freetype_pixel_size);
+        fontFace.library = nullptr;
+        std::cout << "Warning: FreeType library initialization failed, error = " << error << std::endl;
+        return false;
     }
 
-    FT_Int32 load_flags = FT_LOAD_NO_BITMAP;
-    FT_Render_Mode render_mode = FT_RENDER_MODE_NORMAL;
+    FT_Long face_index = 0;
 
-    struct GlyphQuad
+    // Windows workaround for no wchar_t support in Freetype, convert vsg::Path's std::wstring to UTF8 std::string
+    std::string filename_string = filename.string();
+    error = FT_New_Face(fontFace.library, filename_string.c_str(), face_index, &fontFace.face);
+    if (error == FT_Err_Unknown_File_Format)
     {
-        FT_ULong charcode;
-        FT_ULong glyph_index;
-        unsigned int width;
-        unsigned int height;
-        inline bool operator<(const GlyphQuad& rhs) const { return height < rhs.height; }
+        fontFace.face = nullptr;
+        std::cout << "Warning: FreeType unable to read font file : " << filename << ", error = " << FT_Err_Unknown_File_Format << std::endl;
+        return false;
+    }
+    else if (error)
+    {
+        fontFace.face = nullptr;
+        std::cout << "Warning: FreeType unable to read font file : " << filename << ", error = " << error << std::endl;
+        return false;
+    }
+
+    FT_Set_Pixel_Sizes(fontFace.face, pixel_size, pixel_size);
+
+    return true;
+}
+
+void freetype::Implementation::collectGlyphs(FT_Face face, const CharacterRanges& ranges, const vsg::uintArray* existing, const FontSettings& settings, GlyphQuads& sortedGlyphQuads, FT_ULong& max_charcode) const
+{
+    auto selected = [&](FT_ULong charcode) {
+        if (existing && charcode < existing->size() && existing->at(charcode) != 0) return false;
+        if (ranges.empty()) return true;
+        for (auto& range : ranges)
+        {
+            if (charcode >= range.first && charcode <= range.second) return true;
+        }
+        return false;
     };
 
-    std::multiset<GlyphQuad> sortedGlyphQuads;
+    auto addGlyph = [&](FT_ULong charcode, FT_UInt glyph_index) {
+        if (FT_Load_Glyph(face, glyph_index, settings.load_flags) != 0) return false;
+
+        if (charcode > max_charcode) max_charcode = charcode;
+
+        GlyphQuad quad{
+            charcode,
+            glyph_index,
+            static_cast<unsigned int>(ceil(float(face->glyph->metrics.width) * settings.freetype_pixel_size_scale)),
+            static_cast<unsigned int>(ceil(float(face->glyph->metrics.height) * settings.freetype_pixel_size_scale))};
+
+        sortedGlyphQuads.insert(quad);
+        return true;
+    };
 
     bool hasSpace = false;
 
-    // collect all the sizes of the glyphs
-    FT_ULong max_charcode = 0;
+    // collect the sizes of the selected glyphs, only loading the glyphs that are selected
+    FT_UInt glyph_index;
+    FT_ULong charcode = FT_Get_First_Char(face, &glyph_index);
+    while (glyph_index != 0)
     {
-        FT_ULong charcode;
-        FT_UInt glyph_index;
+        if (selected(charcode) && addGlyph(charcode, glyph_index) && charcode == 32) hasSpace = true;
 
-        charcode = FT_Get_First_Char(face, &glyph_index);
-        while (glyph_index != 0)
-        {
-            charcode = FT_Get_Next_Char(face, charcode, &glyph_index);
+        charcode = FT_Get_Next_Char(face, charcode, &glyph_index);
+    }
 
-            error = FT_Load_Glyph(face, glyph_index, load_flags);
-            if (error) continue;
+    if (!hasSpace && selected(32))
+    {
+        FT_UInt space_glyph_index = FT_Get_Char_Index(face, 32);
+        if (space_glyph_index != 0) addGlyph(32, space_glyph_index);
+    }
+}
 
-            if (charcode > max_charcode) max_charcode = charcode;
+unsigned int freetype::Implementation::layoutGlyphs(const GlyphQuads& sortedGlyphQuads, unsigned int width, unsigned int ystart, const FontSettings& settings, std::vector<vsg::uivec2>& positions) const
+{
+    auto texel_margin = settings.texel_margin;
 
-            GlyphQuad quad{
-                charcode,
-                glyph_index,
-                static_cast<unsigned int>(ceil(float(face->glyph->metrics.width) * freetype_pixel_size_scale)),
-                static_cast<unsigned int>(ceil(float(face->glyph->metrics.height) * freetype_pixel_size_scale))};
+    // skyline bottom-left packing, each node is a horizontal segment of the skyline with the first free row above it.
+    struct SkylineNode
+    {
+        unsigned int x;
+        unsigned int y;
+        unsigned int width;
+    };
 
-            if (charcode == 32) hasSpace = true;
+    std::vector<SkylineNode> skyline;
+    skyline.push_back(SkylineNode{texel_margin, ystart + texel_margin, (width > texel_margin) ? width - texel_margin : 0});
 
-            sortedGlyphQuads.insert(quad);
-        }
-    }
+    positions.assign(sortedGlyphQuads.size(), vsg::uivec2(texel_margin, ystart + texel_margin));
 
-    if (!hasSpace)
+    unsigned int ytop = ystart + 2 * texel_margin;
+
+    // place the tallest glyphs first, the glyphs are sorted shortest first
+    size_t index = sortedGlyphQuads.size();
+    for (auto itr = sortedGlyphQuads.rbegin(); itr != sortedGlyphQuads.rend(); ++itr)
     {
-        FT_ULong charcode = 32;
-        FT_UInt glyph_index = FT_Get_Char_Index(face, charcode);
+        --index;
+
+        // each glyph occupies its width/height plus the margin to the glyphs to the right and below it
+        unsigned int glyph_width = itr->width + texel_margin;
+        unsigned int glyph_height = itr->height + texel_margin;
 
-        if (glyph_index != 0)
+        // find the position where the top of the glyph is lowest, breaking ties by the leftmost position
+        size_t best_node = skyline.size();
+        unsigned int best_x = 0;
+        unsigned int best_y = std::numeric_limits<unsigned int>::max();
+        for (size_t i = 0; i < skyline.size(); ++i)
         {
-            error = FT_Load_Glyph(face, glyph_index, load_flags);
+            unsigned int x = skyline[i].x;
+            if (x + glyph_width > width) break;
 
-            if (!error)
+            unsigned int y = 0;
+            unsigned int width_left = glyph_width;
+            for (size_t j = i; j < skyline.size() && width_left > 0; ++j)
             {
-                GlyphQuad quad{
-                    charcode,
-                    glyph_index,
-                    static_cast<unsigned int>(ceil(float(face->glyph->metrics.width) * freetype_pixel_size_scale)),
-                    static_cast<unsigned int>(ceil(float(face->glyph->metrics.height) * freetype_pixel_size_scale))};
-
-                sortedGlyphQuads.insert(quad);
+                y = std::max(y, skyline[j].y);
+                width_left -= std::min(width_left, skyline[j].width);
+            }
 
-                hasSpace = true;
+            if (y < best_y)
+            {
+                best_node = i;
+                best_x = x;
+                best_y = y;
             }
         }
-    }
 
-    double total_width = 0.0;
-    double total_height = 0.0;
-    for (auto& glyph : sortedGlyphQuads)
-    {
-        total_width += double(glyph.width);
-        total_height += double(glyph.height);
-    }
-
-    unsigned int average_width = static_cast<unsigned int>(ceil(total_width / double(sortedGlyphQuads.size())));
-
-    auto texel_margin = static_cast<unsigned int>(static_cast<float>(pixel_size) * vsg::value<float>(0.25f, freetype::texel_margin_ratio, options));
-    auto quad_margin = static_cast<unsigned int>(static_cast<float>(pixel_size) * vsg::value<float>(0.125f, freetype::quad_margin_ratio, options));
-
-    vsg::debug("texel_margin = ", texel_margin);
-    vsg::debug("quad_margin = ", quad_margin);
+        if (best_node == skyline.size())
+        {
+            // glyph is wider than the atlas, so place it on a new row at the left edge
+            best_node = 0;
+            best_x = texel_margin;
+            best_y = ytop;
+            skyline.assign(1, SkylineNode{texel_margin, ytop, std::max(glyph_width, (width > texel_margin) ? width - texel_margin : 0)});
+        }
 
-    unsigned int provisional_cells_across = static_cast<unsigned int>(ceil(sqrt(double(face->num_glyphs))));
-    unsigned int provisional_width = provisional_cells_across * (average_width + texel_margin);
+        positions[index].set(best_x, best_y);
 
-    //provisional_width = 1024;
+        // insert the new node and trim the nodes it now covers
+        SkylineNode node{best_x, best_y + glyph_height, glyph_width};
+        skyline.insert(skyline.begin() + best_node, node);
+        for (size_t i = best_node + 1; i < skyline.size();)
+        {
+            unsigned int node_end = node.x + node.width;
+            if (skyline[i].x >= node_end) break;
 
-    unsigned int xpos = texel_margin;
-    unsigned int ypos = texel_margin;
-    unsigned int xtop = 2 * texel_margin;
-    unsigned int ytop = 2 * texel_margin;
-    for (auto& glyphQuad : sortedGlyphQuads)
-    {
-        unsigned int width = glyphQuad.width;
-        unsigned int height = glyphQuad.height;
+            unsigned int shrink = node_end - skyline[i].x;
+            if (shrink >= skyline[i].width)
+            {
+                skyline.erase(skyline.begin() + i);
+            }
+            else
+            {
+                skyline[i].x += shrink;
+                skyline[i].width -= shrink;
+                break;
+            }
+        }
 
-        if ((xpos + width + texel_margin) > provisional_width)
+        // merge neighbouring nodes at the same height
+        for (size_t i = 0; i + 1 < skyline.size();)
         {
-            // glyph doesn't fit in present row so shift to next row.
-            xpos = texel_margin;
-            ypos = ytop;
+            if (skyline[i].y == skyline[i + 1].y)
+            {
+                skyline[i].width += skyline[i + 1].width;
+                skyline.erase(skyline.begin() + i + 1);
+            }
+            else
+            {
+                ++i;
+            }
         }
 
-        unsigned int local_ytop = ypos + height + texel_margin;
-        if (local_ytop > ytop) ytop = local_ytop;
+        ytop = std::max(ytop, node.y);
+    }
 
-        xpos += (width + texel_margin);
-        if (xpos > xtop) xtop = xpos;
+    return ytop;
+}
+
+vsg::ref_ptr<vsg::Data> freetype::Implementation::createAtlas(VkFormat format, uint32_t width, uint32_t height) const
+{
+    // initialize to the minimum value, outside of all glyphs
+    if (format == VK_FORMAT_R8_SNORM)
+    {
+        auto atlas = vsg::byteArray2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R8_SNORM});
+        for (auto& c : *atlas) c = std::numeric_limits<vsg::byteArray2D::value_type>::lowest();
+        return atlas;
     }
+    else if (format == VK_FORMAT_R8G8B8A8_SNORM)
+    {
+        auto atlas = vsg::bvec4Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_SNORM});
+        for (auto& c : *atlas) c.set(-128, -128, -128, -128);
+        return atlas;
+    }
+    else
+    {
+        auto atlas = vsg::shortArray2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R16_SNORM});
+        for (auto& c : *atlas) c = std::numeric_limits<vsg::shortArray2D::value_type>::lowest();
+        return atlas;
+    }
+}
 
-    //std::cout<<"provisional_width = "<<provisional_width<<", xtop = "<<xtop<<", ytop = "<<ytop<<std::endl;
-    //xtop = provisional_width;
+uint32_t freetype::Implementation::renderGlyphs(FT_Face face, const GlyphQuads& sortedGlyphQuads, const std::vector<vsg::uivec2>& positions, vsg::Data& atlas,
+                                                vsg::GlyphMetricsArray& glyphMetrics, uint32_t destination_glyphindex, vsg::uintArray& charmap, const FontSettings& settings) const
+{
+    if (auto atlas8 = atlas.cast<vsg::byteArray2D>()) return renderGlyphs(face, sortedGlyphQuads, positions, *atlas8, glyphMetrics, destination_glyphindex, charmap, settings);
+    if (auto atlas16 = atlas.cast<vsg::shortArray2D>()) return renderGlyphs(face, sortedGlyphQuads, positions, *atlas16, glyphMetrics, destination_glyphindex, charmap, settings);
+    if (auto atlasMSDF = atlas.cast<vsg::bvec4Array2D>()) return renderGlyphs(face, sortedGlyphQuads, positions, *atlasMSDF, glyphMetrics, destination_glyphindex, charmap, settings);
+    return 0;
+}
 
-#if 0
-    auto atlas = vsg::byteArray2D::create(xtop, ytop, vsg::Data::Layout{VK_FORMAT_R8_SNORM});
-    using sdf_type = vsg::byteArray2D::value_type;
-    float min_value = std::numeric_limits<sdf_type>::lowest();
-    float max_value = std::numeric_limits<sdf_type>::max();
-    float mid_value = 0.0f;
-#else
-    auto atlas = vsg::shortArray2D::create(xtop, ytop, vsg::Data::Properties{VK_FORMAT_R16_SNORM});
-    using sdf_type = vsg::shortArray2D::value_type;
-    float min_value = std::numeric_limits<sdf_type>::lowest();
-    float max_value = std::numeric_limits<sdf_type>::max();
-    float mid_value = 0.0f;
-#endif
+template<class A>
+uint32_t freetype::Implementation::renderGlyphs(FT_Face face, const GlyphQuads& sortedGlyphQuads, const std::vector<vsg::uivec2>& positions, A& atlas,
+                                                vsg::GlyphMetricsArray& glyphMetrics, uint32_t destination_glyphindex, vsg::uintArray& charmap, const FontSettings& settings) const
+{
+    using sdf_type = typename A::value_type;
+    using component_type = typename sdf_component<sdf_type>::type;
+    constexpr bool multiChannel = !std::is_same_v<sdf_type, component_type>;
 
-    // initialize to zeros
-    for (auto& c : *atlas) c = static_cast<sdf_type>(min_value);
+    float min_value = std::numeric_limits<component_type>::lowest();
+    float max_value = std::numeric_limits<component_type>::max();
+    float mid_value = 0.0f;
 
-    auto font = vsg::Font::create();
-    font->atlas = atlas;
+    auto pixel_size = settings.pixel_size;
+    auto quad_margin = settings.quad_margin;
+    auto freetype_pixel_size_scale = settings.freetype_pixel_size_scale;
 
-    xpos = texel_margin;
-    ypos = texel_margin;
-    ytop = 0;
+    FT_Render_Mode render_mode = FT_RENDER_MODE_NORMAL;
 
     bool useOutline = true;
     bool computeSDF = true;
 
-    double total_nearest_edge = 0.0;
-    double total_outside_edge = 0.0;
-
-    auto glyphMetrics = vsg::GlyphMetricsArray::create(static_cast<uint32_t>(sortedGlyphQuads.size() + 1));
-    auto charmap = vsg::uintArray::create(max_charcode + 1);
-    uint32_t destination_glyphindex = 0;
-
-    // first entry of glyphMetrics should be a null entry
-    vsg::GlyphMetrics null_metrics;
-    null_metrics.uvrect.set(0.0f, 0.0f, 0.0f, 0.0f);
-    null_metrics.width = 0.0f;
-    null_metrics.height = 0.0f;
-    null_metrics.horiBearingX = 0.0f;
-    null_metrics.horiBearingY = 0.0f;
-    null_metrics.horiAdvance = 0.0f;
-    null_metrics.vertBearingX = 0.0f;
-    null_metrics.vertBearingY = 0.0f;
-    null_metrics.vertAdvance = 0.0f;
-    glyphMetrics->set(destination_glyphindex++, null_metrics);
-
-    // initialize charmap to zeros.
-    for (auto& c : *charmap) c = 0;
+    // outlines of the glyphs, and where they are placed in the atlas, collected while the face is accessed so the signed distance fields can be computed in parallel.
+    std::vector<GlyphOutline> glyphOutlines;
+    glyphOutlines.reserve(sortedGlyphQuads.size());
 
+    uint32_t numGlyphs = 0;
+    auto position_itr = positions.begin();
     for (auto& glyphQuad : sortedGlyphQuads)
     {
-        error = FT_Load_Glyph(face, glyphQuad.glyph_index, load_flags);
+        if (settings.cancellation && settings.cancellation->cancelled()) return 0;
+
+        unsigned int xpos = position_itr->x;
+        unsigned int ypos = position_itr->y;
+        ++position_itr;
+
+        int error = FT_Load_Glyph(face, glyphQuad.glyph_index, settings.load_flags);
         if (error) continue;
 
         unsigned int width = glyphQuad.width;
         unsigned int height = glyphQuad.height;
         auto metrics = face->glyph->metrics;
 
-        if ((xpos + width + texel_margin) > atlas->width())
-        {
-            // glyph doesn't fit in present row so shift to next row.
-            xpos = texel_margin;
-            ypos = ytop;
-        }
-
         if (useOutline)
         {
-            Contours contours;
+            GlyphOutline glyphOutline;
+            glyphOutline.xpos = xpos;
+            glyphOutline.ypos = ypos;
+            glyphOutline.width = width;
+            glyphOutline.height = height;
+
+            auto& contours = glyphOutline.contours;
             generateOutlines(face->glyph->outline, contours);
 
             // scale and offset the outline geometry
@@ -775,35 +1312,13 @@ vsg::ref_ptr<vsg::Object> freetype::Implementation::read(const vsg::Path& filena
 
             // font->setObject(vsg::make_string(glyphQuad.glyph_index), createOutlineGeometry(contours));
 
-            struct Extents
-            {
-                float min_x = std::numeric_limits<float>::max();
-                float max_x = std::numeric_limits<float>::lowest();
-                float min_y = std::numeric_limits<float>::max();
-                float max_y = std::numeric_limits<float>::lowest();
-
-                void add(const vsg::vec2& v)
-                {
-                    if (v.x < min_x) min_x = v.x;
-                    if (v.y < min_y) min_y = v.y;
-                    if (v.x > max_x) max_x = v.x;
-                    if (v.y > max_y) max_y = v.y;
-                }
-
-                bool contains(const vsg::vec2& v) const
-                {
-                    return v.x >= min_x && v.x <= max_x &&
-                           v.y >= min_y && v.y <= max_y;
-                }
-            } extents;
-
             // compute edges and bounding volume
             for (auto& contour : contours)
             {
                 auto& points = contour.points;
                 for (auto& v : points)
                 {
-                    extents.add(v);
+                    glyphOutline.extents.add(v);
                 }
 
                 auto& edges = contour.edges;
@@ -817,46 +1332,9 @@ vsg::ref_ptr<vsg::Object> freetype::Implementation::read(const vsg::Path& filena
                 }
             }
 
-            if (!contours.empty())
-            {
-                float scale = 2.0f / float(pixel_size);
-                int delta = quad_margin - 2;
-                for (int r = -delta; r < static_cast<int>(height + delta); ++r)
-                {
-                    std::size_t index = atlas->index(xpos - delta, ypos + r);
-                    for (int c = -delta; c < static_cast<int>(width + delta); ++c)
-                    {
-                        vsg::vec2 v;
-                        v.set(float(c), float(r));
-
-                        auto before_nearest_edge = std::chrono::steady_clock::now();
-
-                        auto min_distance = nearest_contour_edge(contours, v);
-
-                        auto after_nearest_edge = std::chrono::steady_clock::now();
-
-                        if (!extents.contains(v) || outside_contours(contours, v)) min_distance = -min_distance;
-
-                        auto after_outside_edge = std::chrono::steady_clock::now();
-
-                        total_nearest_edge += std::chrono::duration<double, std::chrono::seconds::period>(after_nearest_edge - before_nearest_edge).count();
-                        total_outside_edge += std::chrono::duration<double, std::chrono::seconds::period>(after_outside_edge - after_nearest_edge).count();
-
-                        //std::cout<<"nearest_contour_edge("<<r<<", "<<c<<") min_distance = "<<min_distance<<std::endl;
-                        float distance_ratio = (min_distance)*scale;
-                        float value = mid_value + distance_ratio * (max_value - min_value);
-
-                        if (value <= min_value)
-                            atlas->at(index++) = static_cast<sdf_type>(min_value);
-                        else if (value >= max_value)
-                            atlas->at(index++) = static_cast<sdf_type>(max_value);
-                        else
-                            atlas->at(index++) = static_cast<sdf_type>(value);
-                    }
-                }
-            }
+            if (!contours.empty()) glyphOutlines.push_back(std::move(glyphOutline));
         }
-        else
+        else if constexpr (!multiChannel)
         {
             if (face->glyph->format != FT_GLYPH_FORMAT_BITMAP)
             {
@@ -874,10 +1352,10 @@ vsg::ref_ptr<vsg::Object> freetype::Implementation::read(const vsg::Path& filena
                 int delta = quad_margin - 2;
                 for (int r = -delta; r < static_cast<int>(bitmap.rows + delta); ++r)
                 {
-                    std::size_t index = atlas->index(xpos - delta, ypos + r);
+                    std::size_t index = atlas.index(xpos - delta, ypos + r);
                     for (int c = -delta; c < static_cast<int>(bitmap.width + delta); ++c)
                     {
-                        atlas->at(index++) = nearest_edge(bitmap, c, r, quad_margin);
+                        atlas.at(index++) = nearest_edge(bitmap, c, r, quad_margin);
                     }
                 }
             }
@@ -886,18 +1364,18 @@ vsg::ref_ptr<vsg::Object> freetype::Implementation::read(const vsg::Path& filena
                 const unsigned char* ptr = bitmap.buffer;
                 for (unsigned int r = 0; r < bitmap.rows; ++r)
                 {
-                    std::size_t index = atlas->index(xpos, ypos + r);
+                    std::size_t index = atlas.index(xpos, ypos + r);
                     for (unsigned int c = 0; c < bitmap.width; ++c)
                     {
-                        atlas->at(index++) = *ptr++;
+                        atlas.at(index++) = *ptr++;
                     }
                 }
             }
         }
 
         vsg::vec4 uvrect(
-            (float(xpos - quad_margin) - 1.0f) / float(atlas->width() - 1), float(ypos + height + quad_margin) / float(atlas->height() - 1),
-            float(xpos + width + quad_margin) / float(atlas->width() - 1), float((ypos - quad_margin) - 1.0f) / float(atlas->height() - 1));
+            (float(xpos - quad_margin) - 1.0f) / float(atlas.width() - 1), float(ypos + height + quad_margin) / float(atlas.height() - 1),
+            float(xpos + width + quad_margin) / float(atlas.width() - 1), float((ypos - quad_margin) - 1.0f) / float(atlas.height() - 1));
 
         vsg::GlyphMetrics vsg_metrics;
         vsg_metrics.uvrect = uvrect;
@@ -911,23 +1389,337 @@ vsg::ref_ptr<vsg::Object> freetype::Implementation::read(const vsg::Path& filena
         vsg_metrics.vertAdvance = (float(metrics.vertAdvance) * freetype_pixel_size_scale) / float(pixel_size);
 
         // assign the glyph metrics and charcode/glyph_index to the VSG glyphMetrics and charmap containers.
-        glyphMetrics->set(destination_glyphindex, vsg_metrics);
-        charmap->set(glyphQuad.charcode, destination_glyphindex);
+        glyphMetrics.set(destination_glyphindex, vsg_metrics);
+        charmap.set(glyphQuad.charcode, destination_glyphindex);
 
         ++destination_glyphindex;
+        ++numGlyphs;
+    }
+
+    // compute the signed distance field of each glyph, the glyphs occupy separate regions of the atlas so can be written to concurrently
+    float scale = 2.0f / float(pixel_size);
+    int delta = quad_margin - 2;
 
-        unsigned int local_ytop = ypos + height + texel_margin;
-        if (local_ytop > ytop) ytop = local_ytop;
+    // distances beyond max_distance all map to the min/max_value so the nearest edge search can stop there
+    float max_distance = std::max(max_value - mid_value, mid_value - min_value) / ((max_value - min_value) * scale) + 1.0f;
+    float cellSize = std::max(2.0f, float(pixel_size) / 12.0f);
+
+    auto toValue = [&](float distance) -> component_type {
+        float value = mid_value + distance * scale * (max_value - min_value);
+        if (value <= min_value)
+            return static_cast<component_type>(min_value);
+        else if (value >= max_value)
+            return static_cast<component_type>(max_value);
+        else
+            return static_cast<component_type>(value);
+    };
+
+    auto computeGlyphSDF = [&](const GlyphOutline& glyphOutline) {
+        vsg::vec2 min(float(-delta), float(-delta));
+        vsg::vec2 max(float(glyphOutline.width + delta), float(glyphOutline.height + delta));
+
+        SegmentGrid grid;
+        grid.build(glyphOutline.contours, min, max, cellSize);
+
+        // multi-channel signed distance fields have a grid of the coloured segments for each of the red, green and blue channels
+        SegmentGrid channelGrids[3];
+        float orientation = 1.0f;
+        if constexpr (multiChannel)
+        {
+            Segments segments;
+            colourEdges(glyphOutline.contours, segments);
+            orientation = contours_orientation(glyphOutline.contours);
 
-        xpos += (width + texel_margin);
-        if (xpos > xtop) xtop = xpos;
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                Segments channelSegments;
+                for (auto& segment : segments)
+                {
+                    if (segment.colour & (1 << channel)) channelSegments.push_back(segment);
+                }
+                channelGrids[channel].build(std::move(channelSegments), min, max, cellSize);
+            }
+        }
+
+        for (int r = -delta; r < static_cast<int>(glyphOutline.height + delta); ++r)
+        {
+            std::size_t index = atlas.index(glyphOutline.xpos - delta, glyphOutline.ypos + r);
+            for (int c = -delta; c < static_cast<int>(glyphOutline.width + delta); ++c)
+            {
+                vsg::vec2 v;
+                v.set(float(c), float(r));
+
+                auto min_distance = nearest_contour_edge(grid, v, max_distance);
+                if (!glyphOutline.extents.contains(v) || outside_contours(grid, v)) min_distance = -min_distance;
+
+                if constexpr (multiChannel)
+                {
+                    // red, green and blue hold the per channel pseudo distances whose median reconstructs sharp corners, alpha holds the true signed distance
+                    float fallback = (min_distance < 0.0f) ? -max_distance : max_distance;
+                    auto& texel = atlas.at(index++);
+                    texel.r = toValue(nearest_pseudo_distance(channelGrids[0], v, max_distance, orientation, fallback));
+                    texel.g = toValue(nearest_pseudo_distance(channelGrids[1], v, max_distance, orientation, fallback));
+                    texel.b = toValue(nearest_pseudo_distance(channelGrids[2], v, max_distance, orientation, fallback));
+                    texel.a = toValue(min_distance);
+                }
+                else
+                {
+                    atlas.at(index++) = toValue(min_distance);
+                }
+            }
+        }
+    };
+
+    uint32_t numThreads = std::max(1u, std::min(settings.numThreads, static_cast<uint32_t>(glyphOutlines.size())));
+    if (numThreads <= 1)
+    {
+        for (auto& glyphOutline : glyphOutlines)
+        {
+            if (settings.cancellation && settings.cancellation->cancelled()) return 0;
+            computeGlyphSDF(glyphOutline);
+        }
+    }
+    else
+    {
+        // glyphs vary greatly in complexity so hand them out one at a time rather than in fixed blocks
+        std::atomic<size_t> nextGlyph{0};
+        auto worker = [&]() {
+            for (size_t i = nextGlyph++; i < glyphOutlines.size(); i = nextGlyph++)
+            {
+                if (settings.cancellation && settings.cancellation->cancelled()) break;
+                computeGlyphSDF(glyphOutlines[i]);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < numThreads; ++i) threads.emplace_back(worker);
+        worker();
+        for (auto& thread : threads) thread.join();
+
+        if (settings.cancellation && settings.cancellation->cancelled()) return 0;
+    }
+
+    return numGlyphs;
+}
+
+vsg::ref_ptr<vsg::Object> freetype::Implementation::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    vsg::Path ext = (options && options->extensionHint) ? options->extensionHint : vsg::lowerCaseFileExtension(filename);
+    if (_supportedFormats.find(ext) == _supportedFormats.end()) return {};
+
+    vsg::Path filenameToUse = findFile(filename, options);
+    if (!filenameToUse) return {};
+
+    CharacterRanges ranges;
+    std::string characterSet;
+    if (options && options->getValue(freetype::character_set, characterSet) && !parseCharacterSet(characterSet, ranges)) return {};
+
+    VkFormat atlasFormat = VK_FORMAT_R16_SNORM;
+    if (vsg::value<bool>(false, freetype::msdf, options))
+    {
+        atlasFormat = VK_FORMAT_R8G8B8A8_SNORM;
     }
+    else if (std::string format; options && options->getValue(freetype::atlas_format, format))
+    {
+        if (format == "r8_snorm")
+            atlasFormat = VK_FORMAT_R8_SNORM;
+        else if (format != "r16_snorm")
+            vsg::warn("freetype::read() unsupported atlas_format \"", format, "\", using r16_snorm.");
+    }
+
+    FontSettings settings;
+    settings.pixel_size = std::max(1u, vsg::value<uint32_t>(48, freetype::pixel_size, options));
+    settings.freetype_pixel_size_scale = 1.0f / 64.0f;
+    settings.texel_margin = static_cast<unsigned int>(static_cast<float>(settings.pixel_size) * vsg::value<float>(0.25f, freetype::texel_margin_ratio, options));
+    settings.quad_margin = static_cast<unsigned int>(static_cast<float>(settings.pixel_size) * vsg::value<float>(0.125f, freetype::quad_margin_ratio, options));
+    settings.numThreads = vsg::value<uint32_t>(std::thread::hardware_concurrency(), freetype::num_threads, options);
+    settings.cancellation = getCancellationToken(options.get());
+
+    uint32_t max_atlas_size = vsg::value<uint32_t>(16384, freetype::max_atlas_size, options);
 
-    font->ascender = float(face->ascender) * freetype_pixel_size_scale / float(pixel_size);
-    font->descender = float(face->descender) * freetype_pixel_size_scale / float(pixel_size);
-    font->height = float(face->height) * freetype_pixel_size_scale / float(pixel_size);
+    vsg::debug("texel_margin = ", settings.texel_margin);
+    vsg::debug("quad_margin = ", settings.quad_margin);
+
+    // use the previously generated font if it's in the font cache
+    vsg::Path cacheFilename;
+    if (std::string fontCache; options && options->getValue(freetype::font_cache, fontCache) && !fontCache.empty())
+    {
+        std::stringstream settingsStr;
+        settingsStr << "vsgXchange::freetype 2 " << settings.pixel_size << " " << settings.texel_margin << " " << settings.quad_margin << " " << atlasFormat << " " << max_atlas_size;
+        for (auto& range : ranges) settingsStr << " " << range.first << "-" << range.second;
+
+        cacheFilename = fontCacheFilename(fontCache, filenameToUse, settingsStr.str());
+        if (cacheFilename && vsg::fileExists(cacheFilename))
+        {
+            if (auto font = vsg::VSG().read_cast<vsg::Font>(cacheFilename))
+            {
+                vsg::debug("freetype::read(", filename, ") using cached font ", cacheFilename);
+                return font;
+            }
+        }
+    }
+
+    FontFace fontFace;
+    if (!openFace(filenameToUse, settings.pixel_size, fontFace)) return {};
+
+    FT_Face face = fontFace.face;
+
+    GlyphQuads sortedGlyphQuads;
+    FT_ULong max_charcode = 0;
+    collectGlyphs(face, ranges, nullptr, settings, sortedGlyphQuads, max_charcode);
+
+    // start with the smallest power of two width that could hold all the glyphs, and double it until the atlas is no taller than it is wide
+    double total_area = 0.0;
+    unsigned int max_glyph_width = 0;
+    for (auto& glyph : sortedGlyphQuads)
+    {
+        total_area += double(glyph.width + settings.texel_margin) * double(glyph.height + settings.texel_margin);
+        max_glyph_width = std::max(max_glyph_width, glyph.width);
+    }
+
+    unsigned int min_width = std::max(static_cast<unsigned int>(ceil(sqrt(total_area))), max_glyph_width + 2 * settings.texel_margin);
+    unsigned int xtop = 1;
+    while (xtop < min_width) xtop *= 2;
+
+    std::vector<vsg::uivec2> positions;
+    unsigned int ytop = layoutGlyphs(sortedGlyphQuads, xtop, 0, settings, positions);
+    while (ytop > xtop && xtop * 2 <= max_atlas_size)
+    {
+        xtop *= 2;
+        ytop = layoutGlyphs(sortedGlyphQuads, xtop, 0, settings, positions);
+    }
+
+    if (std::max(xtop, ytop) > max_atlas_size)
+    {
+        vsg::warn("freetype::read(", filename, ") glyph atlas ", xtop, " x ", ytop, " exceeds max_atlas_size of ", max_atlas_size, ", consider using the character_set option.");
+    }
+
+    auto atlas = createAtlas(atlasFormat, xtop, ytop);
+
+    auto font = vsg::Font::create();
+    font->atlas = atlas;
+
+    auto glyphMetrics = vsg::GlyphMetricsArray::create(static_cast<uint32_t>(sortedGlyphQuads.size() + 1));
+    auto charmap = vsg::uintArray::create(max_charcode + 1);
+
+    // first entry of glyphMetrics should be a null entry
+    vsg::GlyphMetrics null_metrics;
+    null_metrics.uvrect.set(0.0f, 0.0f, 0.0f, 0.0f);
+    null_metrics.width = 0.0f;
+    null_metrics.height = 0.0f;
+    null_metrics.horiBearingX = 0.0f;
+    null_metrics.horiBearingY = 0.0f;
+    null_metrics.horiAdvance = 0.0f;
+    null_metrics.vertBearingX = 0.0f;
+    null_metrics.vertBearingY = 0.0f;
+    null_metrics.vertAdvance = 0.0f;
+    glyphMetrics->set(0, null_metrics);
+
+    // initialize charmap to zeros.
+    for (auto& c : *charmap) c = 0;
+
+    uint32_t numGlyphs = renderGlyphs(face, sortedGlyphQuads, positions, *atlas, *glyphMetrics, 1, *charmap, settings);
+    if (cancelled(options.get())) return {};
+
+    font->ascender = float(face->ascender) * settings.freetype_pixel_size_scale / float(settings.pixel_size);
+    font->descender = float(face->descender) * settings.freetype_pixel_size_scale / float(settings.pixel_size);
+    font->height = float(face->height) * settings.freetype_pixel_size_scale / float(settings.pixel_size);
     font->glyphMetrics = glyphMetrics;
     font->charmap = charmap;
 
+    // record how the font was generated so glyphs can be added to it later by freetype::addGlyphs()
+    font->setValue(font_filename, filenameToUse.string());
+    font->setValue(font_num_glyphs, numGlyphs + 1);
+    font->setValue(freetype::pixel_size, static_cast<uint32_t>(settings.pixel_size));
+    font->setValue(freetype::texel_margin_ratio, vsg::value<float>(0.25f, freetype::texel_margin_ratio, options));
+    font->setValue(freetype::quad_margin_ratio, vsg::value<float>(0.125f, freetype::quad_margin_ratio, options));
+
+    if (atlasFormat == VK_FORMAT_R8G8B8A8_SNORM) font->setObject(freetype::msdf_shader_set, freetype::createMSDFShaderSet(options));
+
+    if (cacheFilename) writeToFontCache(*font, cacheFilename);
+
     return font;
 }
+
+uint32_t freetype::Implementation::addGlyphs(vsg::Font& font, const std::vector<uint32_t>& charcodes, vsg::ref_ptr<const vsg::Options> options) const
+{
+    auto atlas = font.atlas;
+    std::string filename;
+    uint32_t numExistingGlyphs = 0;
+    if (!atlas || !font.glyphMetrics || !font.charmap || !font.getValue(font_filename, filename) || !font.getValue(font_num_glyphs, numExistingGlyphs))
+    {
+        vsg::warn("freetype::addGlyphs() font not generated by vsgXchange::freetype.");
+        return 0;
+    }
+
+    CharacterRanges ranges;
+    for (auto charcode : charcodes) ranges.emplace_back(charcode, charcode);
+    if (ranges.empty()) return 0;
+
+    // use the same settings as the font was originally generated with so the new glyphs match
+    float texel_margin_ratio = 0.25f, quad_margin_ratio = 0.125f;
+    uint32_t pixel_size = 48;
+    font.getValue(freetype::texel_margin_ratio, texel_margin_ratio);
+    font.getValue(freetype::quad_margin_ratio, quad_margin_ratio);
+    font.getValue(freetype::pixel_size, pixel_size);
+
+    FontSettings settings;
+    settings.pixel_size = pixel_size;
+    settings.freetype_pixel_size_scale = 1.0f / 64.0f;
+    settings.texel_margin = static_cast<unsigned int>(static_cast<float>(settings.pixel_size) * texel_margin_ratio);
+    settings.quad_margin = static_cast<unsigned int>(static_cast<float>(settings.pixel_size) * quad_margin_ratio);
+    settings.numThreads = vsg::value<uint32_t>(std::thread::hardware_concurrency(), freetype::num_threads, options);
+    settings.cancellation = getCancellationToken(options.get());
+
+    FontFace fontFace;
+    if (!openFace(filename, settings.pixel_size, fontFace)) return 0;
+
+    FT_Face face = fontFace.face;
+
+    GlyphQuads sortedGlyphQuads;
+    FT_ULong max_charcode = 0;
+    collectGlyphs(face, ranges, font.charmap.get(), settings, sortedGlyphQuads, max_charcode);
+    if (sortedGlyphQuads.empty()) return 0;
+
+    // place the new glyphs below the existing glyphs, growing the atlas to fit
+    unsigned int width = atlas->width();
+    for (auto& glyph : sortedGlyphQuads) width = std::max(width, glyph.width + 2 * settings.texel_margin);
+
+    std::vector<vsg::uivec2> positions;
+    unsigned int ytop = layoutGlyphs(sortedGlyphQuads, width, atlas->height(), settings, positions);
+
+    auto newAtlas = createAtlas(atlas->properties.format, width, ytop);
+    size_t rowSize = atlas->width() * atlas->valueSize();
+    for (uint32_t r = 0; r < atlas->height(); ++r)
+    {
+        std::memcpy(static_cast<uint8_t*>(newAtlas->dataPointer()) + r * width * newAtlas->valueSize(), static_cast<const uint8_t*>(atlas->dataPointer()) + r * rowSize, rowSize);
+    }
+
+    // the existing uvrects were normalized to the old atlas dimensions
+    auto glyphMetrics = vsg::GlyphMetricsArray::create(static_cast<uint32_t>(numExistingGlyphs + sortedGlyphQuads.size()));
+    float uScale = float(atlas->width() - 1) / float(newAtlas->width() - 1);
+    float vScale = float(atlas->height() - 1) / float(newAtlas->height() - 1);
+    for (uint32_t i = 0; i < numExistingGlyphs && i < font.glyphMetrics->size(); ++i)
+    {
+        auto metrics = font.glyphMetrics->at(i);
+        metrics.uvrect.x *= uScale;
+        metrics.uvrect.y *= vScale;
+        metrics.uvrect.z *= uScale;
+        metrics.uvrect.w *= vScale;
+        glyphMetrics->set(i, metrics);
+    }
+
+    auto charmap = vsg::uintArray::create(static_cast<uint32_t>(std::max<size_t>(font.charmap->size(), max_charcode + 1)));
+    for (auto& c : *charmap) c = 0;
+    std::memcpy(charmap->dataPointer(), font.charmap->dataPointer(), font.charmap->dataSize());
+
+    uint32_t numGlyphs = renderGlyphs(face, sortedGlyphQuads, positions, *newAtlas, *glyphMetrics, numExistingGlyphs, *charmap, settings);
+    if (cancelled(options.get())) return 0;
+
+    font.atlas = newAtlas;
+    font.glyphMetrics = glyphMetrics;
+    font.charmap = charmap;
+    font.setValue(font_num_glyphs, numExistingGlyphs + numGlyphs);
+
+    return numGlyphs;
+}
@@ -30,6 +30,10 @@ vsg::ref_ptr<vsg::Object> freetype::read(const vsg::Path&, vsg::ref_ptr<const vs
 {
     return {};
 }
+uint32_t freetype::addGlyphs(vsg::Font&, const std::vector<uint32_t>&, vsg::ref_ptr<const vsg::Options>) const
+{
+    return 0;
+}
 bool freetype::getFeatures(Features&) const
 {
     return false;
@@ -0,0 +1,78 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2020 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/state/ShaderModule.h>
+#include <vsg/state/ShaderStage.h>
+#include <vsgXchange/freetype.h>
+
+using namespace vsgXchange;
+
+// fragment shader matching the interface of the stock text.vert, sampling the median of the edge coloured channels rather than the red channel
+static const char* msdf_text_frag = R"(#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform sampler2D textureAtlas;
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec4 outlineColor;
+layout(location = 2) in float outlineWidth;
+layout(location = 3) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+float median(float r, float g, float b)
+{
+    return max(min(r, g), min(max(r, g), b));
+}
+
+void main()
+{
+    vec4 msdf = texture(textureAtlas, fragTexCoord);
+
+    // the median of the pseudo distances keeps the corners sharp, the outline uses the true signed distance in alpha as the pseudo distances aren't valid away from the edge
+    float distance_from_edge = median(msdf.r, msdf.g, msdf.b);
+    float delta = max(fwidth(distance_from_edge), 1e-5);
+    float alpha = clamp(distance_from_edge / delta + 0.5, 0.0, 1.0);
+
+    if (outlineWidth > 0.0)
+    {
+        float outline_delta = max(fwidth(msdf.a), 1e-5);
+        float outline_alpha = clamp((msdf.a + outlineWidth) / outline_delta + 0.5, 0.0, 1.0);
+        outColor = mix(vec4(outlineColor.rgb, outlineColor.a * outline_alpha), fragColor, alpha);
+    }
+    else
+    {
+        outColor = vec4(fragColor.rgb, fragColor.a * alpha);
+    }
+
+    if (outColor.a == 0.0) discard;
+}
+)";
+
+vsg::ref_ptr<vsg::ShaderSet> freetype::createMSDFShaderSet(vsg::ref_ptr<const vsg::Options> options)
+{
+    // copy as createTextShaderSet() returns the options->shaderSets["text"] entry if there is one
+    auto shaderSet = vsg::ShaderSet::create(*vsg::createTextShaderSet(options));
+
+    for (auto& stage : shaderSet->stages)
+    {
+        if (stage->stage != VK_SHADER_STAGE_FRAGMENT_BIT) continue;
+
+        auto module = vsg::ShaderModule::create(msdf_text_frag, stage->module ? stage->module->hints : vsg::ref_ptr<vsg::ShaderCompileSettings>());
+        auto msdfStage = vsg::ShaderStage::create(stage->stage, stage->entryPointName, module);
+        msdfStage->specializationConstants = stage->specializationConstants;
+        stage = msdfStage;
+    }
+    shaderSet->variants.clear();
+
+    return shaderSet;
+}
@@ -10,17 +10,149 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <vsg/core/Objects.h>
 #include <vsg/io/Logger.h>
 #include <vsgXchange/gdal.h>
+#include <vsgXchange/images.h>
 
+#include "../all/stream_utils.h"
+
+#include <cpl_conv.h>
+#include <gdalwarper.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
 #include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using namespace vsgXchange;
 
 namespace vsgXchange
 {
 
+    /// return the http/https URL of filename, in its own right or relative to the first entry in options->paths, or an empty path if it isn't a remote file.
+    vsg::Path remoteURL(const vsg::Path& filename, const vsg::Options* options)
+    {
+        auto isURL = [](const vsg::Path& path) { return path.compare(0, 7, "http://") == 0 || path.compare(0, 8, "https://") == 0; };
+        if (isURL(filename)) return filename;
+        if (options && !options->paths.empty() && isURL(options->paths.front()) && !vsg::fileExists(filename)) return options->paths.front() / filename;
+        return {};
+    }
+
+    /// read a window of the bands of the raster, without resampling, splitting the rows of blocks across numThreads threads that each open their own dataset handle as GDALDataset isn't thread safe.
+    bool parallelCopyRasterBandsToImage(const vsg::Path& filename, int blockHeight, const std::vector<int>& bandNumbers, int xOffset, int yOffset, int xSize, int ySize, vsg::Data& image, uint32_t numThreads,
+                                        const CancellationToken* cancellation)
+    {
+        // align the strips to the block grid so that no block is decoded by more than one thread
+        int firstBlockRow = yOffset / blockHeight;
+        int lastBlockRow = (yOffset + ySize - 1) / blockHeight;
+        int numBlockRows = lastBlockRow - firstBlockRow + 1;
+        int blockRowsPerThread = (numBlockRows + static_cast<int>(numThreads) - 1) / static_cast<int>(numThreads);
+
+        std::atomic_bool success{true};
+        std::vector<std::thread> threads;
+        for (int blockRow = firstBlockRow; blockRow <= lastBlockRow; blockRow += blockRowsPerThread)
+        {
+            int rowStart = std::max(yOffset, blockRow * blockHeight);
+            int rowEnd = std::min(yOffset + ySize, (blockRow + blockRowsPerThread) * blockHeight);
+
+            threads.emplace_back([&, rowStart, rowEnd]() {
+                auto dataset = vsgXchange::openDataSet(filename, GA_ReadOnly);
+                if (!dataset)
+                {
+                    success = false;
+                    return;
+                }
+
+                auto dataType = dataset->GetRasterBand(bandNumbers.front())->GetRasterDataType();
+                GSpacing pixelSpace = image.stride();
+                GSpacing lineSpace = pixelSpace * image.width();
+                GSpacing bandSpace = GDALGetDataTypeSizeBytes(dataType);
+                uint8_t* dest_ptr = reinterpret_cast<uint8_t*>(image.dataPointer()) + lineSpace * (rowStart - yOffset);
+
+                GDALRasterIOExtraArg extraArg;
+                INIT_RASTERIO_EXTRA_ARG(extraArg);
+                assignCancellation(extraArg, cancellation);
+
+                CPLErr result = dataset->RasterIO(GF_Read, xOffset, rowStart, xSize, rowEnd - rowStart, dest_ptr, xSize, rowEnd - rowStart, dataType,
+                                                  static_cast<int>(bandNumbers.size()), const_cast<int*>(bandNumbers.data()), pixelSpace, lineSpace, bandSpace, &extraArg);
+                if (result != CE_None) success = false;
+            });
+        }
+
+        for (auto& thread : threads) thread.join();
+
+        return success;
+    }
+
+    /// initialize GDAL, registering just the drivers listed in the GDAL::drivers option if it's set.
+    void initGDAL(const vsg::Options* options)
+    {
+        std::string driverList;
+        if (!options || !options->getValue(GDAL::drivers, driverList) || driverList.empty())
+        {
+            vsgXchange::initGDAL();
+            return;
+        }
+
+        std::vector<std::string> driverNames;
+        std::stringstream str(driverList);
+        std::string name;
+        while (std::getline(str, name, ','))
+        {
+            name.erase(0, name.find_first_not_of(' '));
+            name.erase(name.find_last_not_of(' ') + 1);
+            if (!name.empty()) driverNames.push_back(name);
+        }
+
+        vsgXchange::initGDAL(driverNames);
+    }
+
+    GDALResampleAlg resampleAlgorithm(const vsg::Options* options)
+    {
+        std::string resample;
+        if (!options || !options->getValue(GDAL::resample, resample)) return GRA_NearestNeighbour;
+
+        if (resample == "bilinear") return GRA_Bilinear;
+        if (resample == "cubic") return GRA_Cubic;
+        if (resample == "cubicspline") return GRA_CubicSpline;
+        if (resample == "lanczos") return GRA_Lanczos;
+        if (resample == "average") return GRA_Average;
+        return GRA_NearestNeighbour;
+    }
+
+    /// create a warped VRT that reprojects the dataset to the targetSRS on demand, block by block as it's read, so no intermediate reprojected raster is created.
+    std::shared_ptr<GDALDataset> createWarpedDataset(std::shared_ptr<GDALDataset> dataset, const std::string& targetSRS, GDALResampleAlg resampleAlg)
+    {
+        OGRSpatialReference srs;
+        if (srs.SetFromUserInput(targetSRS.c_str()) != OGRERR_NONE)
+        {
+            vsg::warn("GDAL::read() unable to interpret target_srs ", targetSRS);
+            return {};
+        }
+
+        char* targetWKT = nullptr;
+        srs.exportToWkt(&targetWKT);
+
+        auto warped = GDALAutoCreateWarpedVRT(static_cast<GDALDatasetH>(dataset.get()), nullptr, targetWKT, resampleAlg, 0.125, nullptr);
+        CPLFree(targetWKT);
+
+        if (!warped) return {};
+
+        // the warped VRT reads from the source dataset so keep it alive until the warped dataset is closed
+        return std::shared_ptr<GDALDataset>(static_cast<GDALDataset*>(warped), [source = dataset](GDALDataset* ds) { GDALClose(ds); });
+    }
+
     class GDAL::Implementation
     {
     public:
@@ -30,7 +162,28 @@ namespace vsgXchange
         vsg::ref_ptr<vsg::Object> read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options) const;
         vsg::ref_ptr<vsg::Object> read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options) const;
 
+        using ExtensionFeatureMap = std::map<vsg::Path, vsg::ReaderWriter::FeatureMask>;
+
+        /// map of the extensions supported by the registered GDAL raster and vector drivers, computed on first use.
+        const ExtensionFeatureMap& extensionFeatureMap() const;
+
+        /// return true if ext is supported by the registered GDAL raster or vector drivers, an empty extension is treated as supported as some drivers read extensionless files.
+        bool supportedExtension(const vsg::Path& ext) const;
+
+        /// return true if ext is supported by a registered GDAL vector driver.
+        bool vectorExtension(const vsg::Path& ext) const;
+
+        /// return true if ext is supported by a registered GDAL raster driver, or is empty.
+        bool rasterExtension(const vsg::Path& ext) const;
+
+        /// read the vector layers of a file as a scene graph.
+        vsg::ref_ptr<vsg::Object> readVector(const vsg::Path& filenameToUse, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const;
+
     protected:
+        mutable std::once_flag _extensionFeatureMapInitialized;
+        mutable ExtensionFeatureMap _extensionFeatureMap;
+        mutable std::set<vsg::Path> _rasterExtensions;
+        mutable std::set<vsg::Path> _vectorExtensions;
     };
 
 } // namespace vsgXchange
@@ -63,61 +216,181 @@ vsg::ref_ptr<vsg::Object> GDAL::read(const uint8_t* ptr, size_t size, vsg::ref_p
     return _implementation->read(ptr, size, options);
 }
 
+bool GDAL::readOptions(vsg::Options& options, vsg::CommandLine& arguments) const
+{
+    bool result = arguments.readAndAssign<bool>(GDAL::vsicurl, &options);
+    result = arguments.readAndAssign<uint64_t>(GDAL::vsicurl_cache_size, &options) || result;
+    result = arguments.readAndAssign<vsg::ivec4>(GDAL::window, &options) || result;
+    result = arguments.readAndAssign<vsg::dvec4>(GDAL::geographic_window, &options) || result;
+    result = arguments.readAndAssign<vsg::ivec2>(GDAL::output_size, &options) || result;
+    result = arguments.readAndAssign<int>(GDAL::overview_level, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(GDAL::read_threads, &options) || result;
+    result = arguments.readAndAssign<std::string>(GDAL::drivers, &options) || result;
+    result = arguments.readAndAssign<std::string>(GDAL::target_srs, &options) || result;
+    result = arguments.readAndAssign<bool>(GDAL::heightfield, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(GDAL::heightfield_step, &options) || result;
+    result = arguments.readAndAssign<std::string>(GDAL::resample, &options) || result;
+    result = arguments.readAndAssign<std::string>(GDAL::mask, &options) || result;
+    result = arguments.readAndAssign<std::string>(GDAL::vector_layers, &options) || result;
+    result = arguments.readAndAssign<vsg::vec4>(GDAL::vector_color, &options) || result;
+    result = arguments.readAndAssign<double>(GDAL::point_size, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(images::max_texture_size, &options) || result;
+    return result;
+}
+
+namespace
+{
+    void addProtocolAndOptionFeatures(vsg::ReaderWriter::Features& features)
+    {
+        features.protocolFeatureMap["http"] = vsg::ReaderWriter::READ_FILENAME;
+        features.protocolFeatureMap["https"] = vsg::ReaderWriter::READ_FILENAME;
+
+        features.optionNameTypeMap[vsgXchange::GDAL::vsicurl] = "bool";
+        features.optionNameTypeMap[vsgXchange::GDAL::vsicurl_cache_size] = "uint64_t";
+        features.optionNameTypeMap[vsgXchange::GDAL::window] = "ivec4";
+        features.optionNameTypeMap[vsgXchange::GDAL::geographic_window] = "dvec4";
+        features.optionNameTypeMap[vsgXchange::GDAL::output_size] = "ivec2";
+        features.optionNameTypeMap[vsgXchange::GDAL::overview_level] = "int";
+        features.optionNameTypeMap[vsgXchange::GDAL::read_threads] = "uint32_t";
+        features.optionNameTypeMap[vsgXchange::GDAL::drivers] = "std::string";
+        features.optionNameTypeMap[vsgXchange::GDAL::target_srs] = "std::string";
+        features.optionNameTypeMap[vsgXchange::GDAL::heightfield] = "bool";
+        features.optionNameTypeMap[vsgXchange::GDAL::heightfield_step] = "uint32_t";
+        features.optionNameTypeMap[vsgXchange::GDAL::resample] = "std::string";
+        features.optionNameTypeMap[vsgXchange::GDAL::mask] = "std::string";
+        features.optionNameTypeMap[vsgXchange::GDAL::vector_layers] = "std::string";
+        features.optionNameTypeMap[vsgXchange::GDAL::vector_color] = "vec4";
+        features.optionNameTypeMap[vsgXchange::GDAL::point_size] = "double";
+        features.optionNameTypeMap[vsgXchange::images::max_texture_size] = "uint32_t";
+    }
+} // namespace
+
 bool GDAL::getFeatures(Features& features) const
 {
     vsgXchange::initGDAL();
 
-    auto driverManager = GetGDALDriverManager();
-    int driverCount = driverManager->GetDriverCount();
+    auto& extensionFeatureMap = _implementation->extensionFeatureMap();
+    features.extensionFeatureMap.insert(extensionFeatureMap.begin(), extensionFeatureMap.end());
 
-    vsg::ReaderWriter::FeatureMask rasterFeatureMask = vsg::ReaderWriter::READ_FILENAME;
+    addProtocolAndOptionFeatures(features);
 
-    const std::string dotPrefix = ".";
+    return true;
+}
 
-    for (int i = 0; i < driverCount; ++i)
-    {
-        auto driver = driverManager->GetDriver(i);
-        auto raster_meta = driver->GetMetadataItem(GDAL_DCAP_RASTER);
-        auto extensions_meta = driver->GetMetadataItem(GDAL_DMD_EXTENSIONS);
-        // auto longname_meta = driver->GetMetadataItem( GDAL_DMD_LONGNAME );
-        if (raster_meta && extensions_meta)
-        {
-            std::string extensions = extensions_meta;
-            std::string ext;
+void GDAL::getStaticFeatures(Features& features)
+{
+    // extensions of the raster and vector drivers commonly built into GDAL, the full list depends on how GDAL was built so is only known once GDAL is initialized.
+    static const char* s_extensions[] = {
+        ".tif", ".tiff", ".vrt", ".ntf", ".nitf", ".img", ".jp2", ".j2k", ".ecw", ".sid", ".dem", ".dt0",
+        ".dt1", ".dt2", ".hgt", ".asc", ".grd", ".nc", ".hdf", ".h5", ".hdf5", ".kea", ".bil", ".bip",
+        ".bsq", ".rst", ".gpkg", ".mbtiles", ".pix", ".gsb", ".gtx", ".bt", ".ter", ".xyz", ".ers",
+        ".shp", ".geojson", ".kml", ".gml", ".gpx", ".fgb", ".tab", ".mif", ".sqlite"};
+
+    for (auto ext : s_extensions) features.extensionFeatureMap[ext] = vsg::ReaderWriter::READ_FILENAME;
+
+    addProtocolAndOptionFeatures(features);
+}
 
-            std::string::size_type start_pos = 0;
-            for (;;)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// GDAL ReaderWriter implementation
+//
+GDAL::Implementation::Implementation()
+{
+}
+
+const GDAL::Implementation::ExtensionFeatureMap& GDAL::Implementation::extensionFeatureMap() const
+{
+    std::call_once(_extensionFeatureMapInitialized, [&]() {
+        auto driverManager = GetGDALDriverManager();
+        int driverCount = driverManager->GetDriverCount();
+
+        vsg::ReaderWriter::FeatureMask rasterFeatureMask = vsg::ReaderWriter::READ_FILENAME;
+
+        const std::string dotPrefix = ".";
+
+        for (int i = 0; i < driverCount; ++i)
+        {
+            auto driver = driverManager->GetDriver(i);
+            auto raster_meta = driver->GetMetadataItem(GDAL_DCAP_RASTER);
+            auto vector_meta = driver->GetMetadataItem(GDAL_DCAP_VECTOR);
+            auto extensions_meta = driver->GetMetadataItem(GDAL_DMD_EXTENSIONS);
+            // auto longname_meta = driver->GetMetadataItem( GDAL_DMD_LONGNAME );
+            if ((raster_meta || vector_meta) && extensions_meta)
             {
-                start_pos = extensions.find_first_not_of(" .", start_pos);
-                if (start_pos == std::string::npos) break;
+                auto addExtension = [&](const std::string& extension) {
+                    _extensionFeatureMap[dotPrefix + extension] = rasterFeatureMask;
+                    if (raster_meta) _rasterExtensions.insert(dotPrefix + extension);
+                    if (vector_meta) _vectorExtensions.insert(dotPrefix + extension);
+                };
 
-                std::string::size_type delimiter_pos = extensions.find_first_of(" /", start_pos);
-                if (delimiter_pos != std::string::npos)
-                {
-                    ext = extensions.substr(start_pos, delimiter_pos - start_pos);
-                    features.extensionFeatureMap[dotPrefix + ext] = rasterFeatureMask;
-                    start_pos = delimiter_pos + 1;
-                    if (start_pos == extensions.length()) break;
-                }
-                else
+                std::string extensions = extensions_meta;
+                for (auto& c : extensions) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+                std::string ext;
+
+                std::string::size_type start_pos = 0;
+                for (;;)
                 {
-                    ext = extensions.substr(start_pos, std::string::npos);
-                    features.extensionFeatureMap[dotPrefix + ext] = rasterFeatureMask;
-                    break;
+                    start_pos = extensions.find_first_not_of(" .", start_pos);
+                    if (start_pos == std::string::npos) break;
+
+                    std::string::size_type delimiter_pos = extensions.find_first_of(" /", start_pos);
+                    if (delimiter_pos != std::string::npos)
+                    {
+                        ext = extensions.substr(start_pos, delimiter_pos - start_pos);
+                        addExtension(ext);
+                        start_pos = delimiter_pos + 1;
+                        if (start_pos == extensions.length()) break;
+                    }
+                    else
+                    {
+                        ext = extensions.substr(start_pos, std::string::npos);
+                        addExtension(ext);
+                        break;
+                    }
                 }
             }
         }
-    }
+    });
 
-    return true;
+    return _extensionFeatureMap;
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//
-// GDAL ReaderWriter implementation
-//
-GDAL::Implementation::Implementation()
+bool GDAL::Implementation::supportedExtension(const vsg::Path& ext) const
+{
+    if (!ext) return true;
+    auto& extensions = extensionFeatureMap();
+    return extensions.find(ext) != extensions.end();
+}
+
+bool GDAL::Implementation::vectorExtension(const vsg::Path& ext) const
+{
+    extensionFeatureMap();
+    return _vectorExtensions.count(ext) != 0;
+}
+
+bool GDAL::Implementation::rasterExtension(const vsg::Path& ext) const
+{
+    if (!ext) return true;
+    extensionFeatureMap();
+    return _rasterExtensions.count(ext) != 0;
+}
+
+vsg::ref_ptr<vsg::Object> GDAL::Implementation::readVector(const vsg::Path& filenameToUse, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
 {
+    auto dataset = vsgXchange::openVectorDataSet(filenameToUse);
+    if (!dataset || dataset->GetLayerCount() == 0) return {};
+
+    auto scene = vsgXchange::createVectorScene(*dataset, options);
+    if (!scene)
+    {
+        vsg::info("GDAL::read(", filename, ") no vector features read.");
+        return {};
+    }
+
+    assignMetaData(*dataset, *scene);
+    return scene;
 }
 
 vsg::ref_ptr<vsg::Object> GDAL::Implementation::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
@@ -126,28 +399,78 @@ vsg::ref_ptr<vsg::Object> GDAL::Implementation::read(const vsg::Path& filename,
     vsg::Path ext = vsg::lowerCaseFileExtension(filename);
     if (ext == ".vsgb" || ext == ".vsgt" || ext == ".osgb" || ext == ".osgt" || ext == ".osg" || ext == ".tile") return {};
 
-    vsg::Path filenameToUse = (vsg::filePath(filename) == "/vsimem") ? filename : vsg::findFile(filename, options);
+    initGDAL(options.get());
+
+    // reject extensions that none of the the registered raster or vector drivers support before attempting to open the file
+    if (!supportedExtension(ext)) return {};
+
+    // thread local GDAL config options that apply just for the duration of this read, restored to their previous values on return
+    std::vector<std::unique_ptr<CPLConfigOptionSetter>> configOptions;
+
+    vsg::Path filenameToUse;
+    if (vsg::filePath(filename) == "/vsimem")
+    {
+        filenameToUse = filename;
+    }
+    else if (auto url = remoteURL(filename, options.get()))
+    {
+        // remote rasters are only read when /vsicurl/ range requests are enabled, otherwise leave it to vsgXchange::curl to download them
+        bool useVSICurl = false;
+        if (options) options->getValue(GDAL::vsicurl, useVSICurl);
+        if (!useVSICurl) return {};
+
+        uint64_t cacheSize = 0;
+        if (options && options->getValue(GDAL::vsicurl_cache_size, cacheSize) && cacheSize > 0)
+        {
+            CPLSetConfigOption("CPL_VSIL_CURL_CACHE_SIZE", std::to_string(cacheSize).c_str());
+        }
+
+        // avoid GDAL probing the server for sidecar files, and cache the blocks that have been fetched
+        for (auto [key, value] : {std::pair<const char*, const char*>{"GDAL_DISABLE_READDIR_ON_OPEN", "EMPTY_DIR"},
+                                  std::pair<const char*, const char*>{"VSI_CACHE", "TRUE"},
+                                  std::pair<const char*, const char*>{"GDAL_HTTP_MULTIRANGE", "YES"},
+                                  std::pair<const char*, const char*>{"GDAL_HTTP_MERGE_CONSECUTIVE_RANGES", "YES"}})
+        {
+            configOptions.push_back(std::make_unique<CPLConfigOptionSetter>(key, value, false));
+        }
+
+        filenameToUse = vsg::Path("/vsicurl/") + url;
+    }
+    else
+    {
+        filenameToUse = vsg::findFile(filename, options);
+    }
 
     if (!filenameToUse) return {};
 
-    vsgXchange::initGDAL();
+    // extensions only supported by vector drivers, such as .shp and .geojson, are read as vector layers, while those shared by both, such as .gpkg, fall back to vector layers if there is no raster
+    bool vector = vectorExtension(ext);
+    if (vector && !rasterExtension(ext)) return readVector(filenameToUse, filename, options);
 
-    auto dataset = vsgXchange::openSharedDataSet(filenameToUse, GA_ReadOnly);
+    // in memory files have unique per call names so aren't shareable, and opening them unshared avoids concurrent reads sharing a dataset handle.
+    bool inMemory = vsg::filePath(filenameToUse) == "/vsimem";
+    auto dataset = inMemory ? vsgXchange::openDataSet(filenameToUse, GA_ReadOnly) : vsgXchange::openSharedDataSet(filenameToUse, GA_ReadOnly);
     if (!dataset)
     {
+        if (vector) return readVector(filenameToUse, filename, options);
         return {};
     }
 
-    auto types = vsgXchange::dataTypes(*dataset);
-    if (types.size() > 1)
+    // optionally reproject on load
+    std::string targetSRS;
+    bool warped = false;
+    if (options && options->getValue(GDAL::target_srs, targetSRS) && !targetSRS.empty())
     {
-        vsg::info("GDAL::read(", filename, ") multiple input data types not supported.");
-        for (auto& type : types)
+        dataset = createWarpedDataset(dataset, targetSRS, resampleAlgorithm(options.get()));
+        if (!dataset)
         {
-            vsg::info("   GDALDataType ", GDALGetDataTypeName(type));
+            vsg::info("GDAL::read(", filename, ") unable to reproject to target_srs ", targetSRS);
+            return {};
         }
-        return {};
+        warped = true;
     }
+
+    auto types = vsgXchange::dataTypes(*dataset);
     if (types.empty())
     {
         vsg::info("GDAL::read(", filename, ") types set empty.");
@@ -155,8 +478,6 @@ vsg::ref_ptr<vsg::Object> GDAL::Implementation::read(const vsg::Path& filename,
         return {};
     }
 
-    GDALDataType dataType = *types.begin();
-
     std::vector<GDALRasterBand*> rasterBands;
     for (int i = 1; i <= dataset->GetRasterCount(); ++i)
     {
@@ -173,88 +494,319 @@ vsg::ref_ptr<vsg::Object> GDAL::Implementation::read(const vsg::Path& filename,
         }
     }
 
-    int numComponents = static_cast<int>(rasterBands.size());
-    if (numComponents == 0)
+    if (rasterBands.empty())
     {
-        vsg::info("GDAL::read(", filename, ") failed numComponents = ", numComponents);
+        vsg::info("GDAL::read(", filename, ") failed numComponents = 0");
         return {};
     }
 
-    bool mapRGBtoRGBAHint = !options || options->mapRGBtoRGBAHint;
-    if (mapRGBtoRGBAHint && numComponents == 3)
+    // split the bands into groups of up to 4 consecutive bands of the same data type, each group is read into its own image.
+    std::vector<std::vector<GDALRasterBand*>> bandGroups;
+    for (auto band : rasterBands)
     {
-        //std::cout<<"Remapping RGB to RGBA "<<filename<<std::endl;
-        numComponents = 4;
+        if (bandGroups.empty() || bandGroups.back().size() == 4 || bandGroups.back().front()->GetRasterDataType() != band->GetRasterDataType())
+        {
+            bandGroups.emplace_back();
+        }
+        bandGroups.back().push_back(band);
     }
 
-    if (numComponents > 4)
+    if (bandGroups.size() > 1)
     {
-        vsg::info("GDAL::read(", filename, ") Too many raster bands to merge into a single output, maximum of 4 raster bands supported.");
-        return {};
+        vsg::debug("GDAL::read(", filename, ") ", rasterBands.size(), " raster bands of ", types.size(), " data types, reading as ", bandGroups.size(), " images.");
     }
 
-    int width = dataset->GetRasterXSize();
-    int height = dataset->GetRasterYSize();
+    int rasterWidth = dataset->GetRasterXSize();
+    int rasterHeight = dataset->GetRasterYSize();
+
+    double geoTransform[6];
+    bool hasGeoTransform = dataset->GetGeoTransform(geoTransform) == CE_None;
 
-    auto image = vsgXchange::createImage2D(width, height, numComponents, dataType, vsg::dvec4(0.0, 0.0, 0.0, 1.0));
-    if (!image) return {};
+    // window of the full resolution raster to read
+    int xOffset = 0, yOffset = 0, xSize = rasterWidth, ySize = rasterHeight;
 
-    for (int component = 0; component < static_cast<int>(rasterBands.size()); ++component)
+    vsg::ivec4 window;
+    vsg::dvec4 geographicWindow;
+    if (options && options->getValue(GDAL::window, window))
     {
-        vsgXchange::copyRasterBandToImage(*rasterBands[component], *image, component);
+        xOffset = window[0];
+        yOffset = window[1];
+        xSize = window[2];
+        ySize = window[3];
     }
+    else if (options && hasGeoTransform && options->getValue(GDAL::geographic_window, geographicWindow))
+    {
+        double inverseTransform[6];
+        if (!GDALInvGeoTransform(geoTransform, inverseTransform))
+        {
+            vsg::info("GDAL::read(", filename, ") unable to invert GeoTransform to compute geographic_window.");
+            return {};
+        }
 
-    vsgXchange::assignMetaData(*dataset, *image);
+        double minX = std::numeric_limits<double>::max(), minY = minX, maxX = std::numeric_limits<double>::lowest(), maxY = maxX;
+        for (auto& corner : {vsg::dvec2(geographicWindow[0], geographicWindow[1]), vsg::dvec2(geographicWindow[2], geographicWindow[1]), vsg::dvec2(geographicWindow[0], geographicWindow[3]), vsg::dvec2(geographicWindow[2], geographicWindow[3])})
+        {
+            double px, py;
+            GDALApplyGeoTransform(inverseTransform, corner.x, corner.y, &px, &py);
+            minX = std::min(minX, px);
+            minY = std::min(minY, py);
+            maxX = std::max(maxX, px);
+            maxY = std::max(maxY, py);
+        }
 
-    if (dataset->GetProjectionRef() && std::strlen(dataset->GetProjectionRef()) > 0)
-    {
-        image->setValue("ProjectionRef", std::string(dataset->GetProjectionRef()));
+        xOffset = static_cast<int>(std::floor(minX));
+        yOffset = static_cast<int>(std::floor(minY));
+        xSize = static_cast<int>(std::ceil(maxX)) - xOffset;
+        ySize = static_cast<int>(std::ceil(maxY)) - yOffset;
     }
 
-    auto transform = vsg::doubleArray::create(6);
-    if (dataset->GetGeoTransform(transform->data()) == CE_None)
+    // clip the window to the extents of the raster
+    if (xOffset < 0)
     {
-        image->setObject("GeoTransform", transform);
+        xSize += xOffset;
+        xOffset = 0;
+    }
+    if (yOffset < 0)
+    {
+        ySize += yOffset;
+        yOffset = 0;
+    }
+    xSize = std::min(xSize, rasterWidth - xOffset);
+    ySize = std::min(ySize, rasterHeight - yOffset);
+    if (xSize <= 0 || ySize <= 0)
+    {
+        vsg::info("GDAL::read(", filename, ") requested window does not overlap raster.");
+        return {};
     }
 
-    return image;
-}
+    // optionally read from an overview, scaling the window into the overview's pixel coordinates
+    int overviewLevel = -1;
+    if (options) options->getValue(GDAL::overview_level, overviewLevel);
 
-vsg::ref_ptr<vsg::Object> GDAL::Implementation::read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options) const
-{
-    // if (!vsg::compatibleExtension(options, _supportedExtensions)) return {};
+    // fit the window within the max_texture_size, keeping its aspect ratio, unless an explicit output size is requested
+    vsg::ivec2 outputSize;
+    bool hasOutputSize = options && options->getValue(GDAL::output_size, outputSize) && outputSize.x > 0 && outputSize.y > 0;
+
+    uint32_t maxTextureSize = 0;
+    if (options) options->getValue(images::max_texture_size, maxTextureSize);
+    if (!hasOutputSize && maxTextureSize > 0 && static_cast<uint32_t>(std::max(xSize, ySize)) > maxTextureSize)
+    {
+        double scale = static_cast<double>(maxTextureSize) / static_cast<double>(std::max(xSize, ySize));
+        outputSize.set(std::max(1, static_cast<int>(xSize * scale)), std::max(1, static_cast<int>(ySize * scale)));
+        hasOutputSize = true;
+
+        // read from the coarsest overview that still has at least the resolution of the output so the full resolution raster isn't decoded
+        if (overviewLevel < 0)
+        {
+            auto band = rasterBands.front();
+            for (int i = 0; i < band->GetOverviewCount(); ++i)
+            {
+                auto overview = band->GetOverview(i);
+                if (!overview) continue;
 
-    std::string input;
-    std::stringstream* sstr = dynamic_cast<std::stringstream*>(&fin);
-    if (sstr)
+                double overviewXSize = xSize * static_cast<double>(overview->GetXSize()) / static_cast<double>(rasterWidth);
+                double overviewYSize = ySize * static_cast<double>(overview->GetYSize()) / static_cast<double>(rasterHeight);
+                if (overviewXSize >= outputSize.x && overviewYSize >= outputSize.y && (overviewLevel < 0 || overview->GetXSize() < band->GetOverview(overviewLevel)->GetXSize())) overviewLevel = i;
+            }
+        }
+    }
+
+    auto sourceBand = [&](GDALRasterBand* band) {
+        return (overviewLevel >= 0 && overviewLevel < band->GetOverviewCount()) ? band->GetOverview(overviewLevel) : band;
+    };
+
+    double overviewScaleX = 1.0, overviewScaleY = 1.0;
+    if (auto overviewBand = sourceBand(rasterBands.front()); overviewBand != rasterBands.front())
     {
-        input = sstr->str();
+        overviewScaleX = static_cast<double>(overviewBand->GetXSize()) / static_cast<double>(rasterWidth);
+        overviewScaleY = static_cast<double>(overviewBand->GetYSize()) / static_cast<double>(rasterHeight);
     }
     else
     {
-        std::string buffer(1 << 16, 0); // 64kB
-        while (!fin.eof())
+        overviewLevel = -1;
+    }
+
+    int sourceXOffset = static_cast<int>(std::floor(xOffset * overviewScaleX));
+    int sourceYOffset = static_cast<int>(std::floor(yOffset * overviewScaleY));
+    int sourceXSize = std::max(1, static_cast<int>(std::round(xSize * overviewScaleX)));
+    int sourceYSize = std::max(1, static_cast<int>(std::round(ySize * overviewScaleY)));
+
+    int width = sourceXSize;
+    int height = sourceYSize;
+
+    if (hasOutputSize)
+    {
+        width = outputSize.x;
+        height = outputSize.y;
+    }
+
+    uint32_t numThreads = 1;
+    if (options) options->getValue(GDAL::read_threads, numThreads);
+
+    bool mapRGBtoRGBAHint = !options || options->mapRGBtoRGBAHint;
+
+    std::string maskType;
+    if (options) options->getValue(GDAL::mask, maskType);
+
+    // polled as the blocks are read so an abandoned read, such as a tile the DatabasePager no longer needs, stops decoding
+    auto cancellation = getCancellationToken(options.get());
+
+    auto readBandGroup = [&](const std::vector<GDALRasterBand*>& bands) -> vsg::ref_ptr<vsg::Data> {
+        GDALDataType dataType = bands.front()->GetRasterDataType();
+
+        int numComponents = static_cast<int>(bands.size());
+        if (mapRGBtoRGBAHint && numComponents == 3)
+        {
+            //std::cout<<"Remapping RGB to RGBA "<<filename<<std::endl;
+            numComponents = 4;
+        }
+
+        // only fill the image with default values when there are components that won't be read from the raster bands
+        bool allComponentsRead = numComponents == static_cast<int>(bands.size());
+        auto image = allComponentsRead ? vsgXchange::allocateImage2D(width, height, numComponents, dataType) : vsgXchange::createImage2D(width, height, numComponents, dataType, vsg::dvec4(0.0, 0.0, 0.0, 1.0));
+        if (!image) return {};
+
+        if (overviewLevel < 0)
         {
-            fin.read(&buffer[0], buffer.size());
-            const auto bytes_readed = fin.gcount();
-            input.append(&buffer[0], bytes_readed);
+            // read all the bands in a single RasterIO call, interleaving them directly into the image
+            std::vector<int> bandNumbers;
+            for (auto band : bands) bandNumbers.push_back(band->GetBand());
+
+            int blockWidth = 0, blockHeight = 0;
+            bands.front()->GetBlockSize(&blockWidth, &blockHeight);
+
+            // the per thread dataset handles are opened from the file so can't be used when the dataset is warped
+            bool parallel = !warped && numThreads > 1 && width == xSize && height == ySize && blockHeight > 0 && ySize > blockHeight;
+            if (!parallel || !parallelCopyRasterBandsToImage(filenameToUse, blockHeight, bandNumbers, xOffset, yOffset, xSize, ySize, *image, numThreads, cancellation))
+            {
+                if (cancellation && cancellation->cancelled()) return {};
+                vsgXchange::copyRasterBandsToImage(*dataset, bandNumbers, xOffset, yOffset, xSize, ySize, *image, cancellation);
+            }
         }
+        else
+        {
+            for (int component = 0; component < static_cast<int>(bands.size()); ++component)
+            {
+                auto band = sourceBand(bands[component]);
+                int sx = std::min(sourceXOffset, band->GetXSize() - 1);
+                int sy = std::min(sourceYOffset, band->GetYSize() - 1);
+                vsgXchange::copyRasterBandWindowToImage(*band, sx, sy, std::min(sourceXSize, band->GetXSize() - sx), std::min(sourceYSize, band->GetYSize() - sy), *image, component, cancellation);
+            }
+        }
+
+        if (cancellation && cancellation->cancelled()) return {};
+
+        if (!maskType.empty() && maskType != "none")
+        {
+            // the mask is read from the same bands and window as the pixels so stays aligned with the image
+            std::vector<GDALRasterBand*> maskSourceBands;
+            for (auto band : bands) maskSourceBands.push_back(overviewLevel < 0 ? band : sourceBand(band));
+
+            vsg::ref_ptr<vsg::Data> mask;
+            if (overviewLevel < 0)
+                mask = vsgXchange::createMask(maskSourceBands, xOffset, yOffset, xSize, ySize, width, height, maskType == "bit");
+            else
+                mask = vsgXchange::createMask(maskSourceBands, sourceXOffset, sourceYOffset, std::min(sourceXSize, maskSourceBands.front()->GetXSize() - sourceXOffset), std::min(sourceYSize, maskSourceBands.front()->GetYSize() - sourceYOffset), width, height, maskType == "bit");
+
+            if (mask) image->setObject("Mask", mask);
+        }
+
+        int hasNoData = 0;
+        double noDataValue = bands.front()->GetNoDataValue(&hasNoData);
+        if (hasNoData) image->setValue("NoDataValue", noDataValue);
+
+        vsgXchange::assignMetaData(*dataset, *image);
+
+        // record the full raster dimensions so callers reading windows can work out how to tile the dataset
+        image->setValue("RasterXSize", rasterWidth);
+        image->setValue("RasterYSize", rasterHeight);
+
+        if (dataset->GetProjectionRef() && std::strlen(dataset->GetProjectionRef()) > 0)
+        {
+            image->setValue("ProjectionRef", std::string(dataset->GetProjectionRef()));
+        }
+
+        if (hasGeoTransform)
+        {
+            // adjust the GeoTransform to map the pixels of the returned image
+            double scaleX = static_cast<double>(xSize) / static_cast<double>(width);
+            double scaleY = static_cast<double>(ySize) / static_cast<double>(height);
+
+            auto transform = vsg::doubleArray::create(6);
+            (*transform)[0] = geoTransform[0] + xOffset * geoTransform[1] + yOffset * geoTransform[2];
+            (*transform)[1] = geoTransform[1] * scaleX;
+            (*transform)[2] = geoTransform[2] * scaleY;
+            (*transform)[3] = geoTransform[3] + xOffset * geoTransform[4] + yOffset * geoTransform[5];
+            (*transform)[4] = geoTransform[4] * scaleX;
+            (*transform)[5] = geoTransform[5] * scaleY;
+            image->setObject("GeoTransform", transform);
+        }
+
+        return image;
+    };
+
+    bool heightfield = false;
+    if (options && options->getValue(GDAL::heightfield, heightfield) && heightfield && rasterBands.size() == 1)
+    {
+        // build the heightfield mesh and let the elevation image go out of scope, so just the mesh is retained
+        uint32_t step = 1;
+        options->getValue(GDAL::heightfield_step, step);
+
+        auto image = readBandGroup(bandGroups.front());
+        if (!image) return {};
+
+        return vsgXchange::createHeightField(*image, step, options);
     }
 
-    return read(reinterpret_cast<const uint8_t*>(input.data()), input.size(), options);
+    if (bandGroups.size() == 1) return readBandGroup(bandGroups.front());
+
+    // multispectral and mixed data type datasets are returned as a vsg::Objects containing an image per band group,
+    // with the 1 based number of the first band in each group assigned as "Band" so the source bands can be identified.
+    auto objects = vsg::Objects::create();
+    for (auto& bands : bandGroups)
+    {
+        auto image = readBandGroup(bands);
+        if (cancellation && cancellation->cancelled()) return {};
+        if (!image) continue;
+
+        image->setValue("Band", bands.front()->GetBand());
+        objects->addChild(image);
+    }
+
+    if (objects->children.empty()) return {};
+
+    return objects;
+}
+
+vsg::ref_ptr<vsg::Object> GDAL::Implementation::read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options) const
+{
+    initGDAL(options.get());
+    if (options && !supportedExtension(options->extensionHint)) return {};
+
+    vsgXchange::StreamData input;
+    if (!vsgXchange::readStream(fin, input)) return {};
+
+    return read(input.data, input.size, options);
 }
 
 vsg::ref_ptr<vsg::Object> GDAL::Implementation::read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options) const
 {
-    std::string temp_filename("/vsimem/temp");
-    temp_filename.append(options->extensionHint.string());
+    initGDAL(options.get());
+    if (options && !supportedExtension(options->extensionHint)) return {};
+
+    // give each call its own virtual file name so that concurrent reads from different threads don't collide.
+    static std::atomic_uint64_t s_tempFileCount{0};
+    std::string temp_filename = vsg::make_string("/vsimem/vsgXchange_", ++s_tempFileCount);
+    if (options) temp_filename.append(options->extensionHint.string());
 
     // create a GDAL Virtual File for memory block.
     VSILFILE* vsFile = VSIFileFromMemBuffer(temp_filename.c_str(), static_cast<GByte*>(const_cast<uint8_t*>(ptr)), static_cast<vsi_l_offset>(size), 0);
+    if (!vsFile) return {};
 
     auto result = GDAL::Implementation::read(temp_filename, options);
 
     VSIFCloseL(vsFile);
+    VSIUnlink(temp_filename.c_str());
 
     return result;
 }
@@ -40,7 +40,14 @@ vsg::ref_ptr<vsg::Object> GDAL::read(const uint8_t*, size_t, vsg::ref_ptr<const
 {
     return {};
 }
+bool GDAL::readOptions(vsg::Options&, vsg::CommandLine&) const
+{
+    return false;
+}
 bool GDAL::getFeatures(Features&) const
 {
     return false;
 }
+void GDAL::getStaticFeatures(Features&)
+{
+}
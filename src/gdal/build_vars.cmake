@@ -9,6 +9,8 @@ if(${vsgXchange_GDAL})
     set(SOURCES ${SOURCES}
         gdal/gdal_utils.cpp
         gdal/meta_utils.cpp
+        gdal/heightfield_utils.cpp
+        gdal/vector_utils.cpp
         gdal/GDAL.cpp
     )
 
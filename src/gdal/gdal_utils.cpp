@@ -24,29 +24,95 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vsg/core/Array2D.h>
 #include <vsg/core/ConstVisitor.h>
 #include <vsg/core/Visitor.h>
+#include <vsg/io/Logger.h>
 
 #include <vsgXchange/gdal.h>
+#include <vsgXchange/read_memory.h>
 
+#include <gdal_frmts.h>
+
+#include <algorithm>
 #include <cstring>
-#include <functional>
+#include <map>
+#include <mutex>
 #include <iostream>
+#include <set>
 
 using namespace vsgXchange;
 
-static bool s_GDAL_initialized = false;
+static std::once_flag s_GDAL_allRegistered;
+static std::once_flag s_GDAL_errorHandler;
+
+static void setUpErrorHandler()
+{
+    std::call_once(s_GDAL_errorHandler, []() { CPLPushErrorHandler(CPLQuietErrorHandler); });
+}
+
 bool vsgXchange::initGDAL()
 {
-    if (!s_GDAL_initialized)
-    {
-        s_GDAL_initialized = true;
+    setUpErrorHandler();
+
+    bool initialized = false;
+    std::call_once(s_GDAL_allRegistered, [&]() {
         GDALAllRegister();
-        CPLPushErrorHandler(CPLQuietErrorHandler);
-        return true;
-    }
-    else
+        initialized = true;
+    });
+    return initialized;
+}
+
+bool vsgXchange::initGDAL(const std::vector<std::string>& drivers)
+{
+    if (drivers.empty()) return initGDAL();
+
+    setUpErrorHandler();
+
+    // registration entry points of the drivers that are built into GDAL by default without requiring external libraries
+    using RegisterFunction = void (*)();
+    static const std::map<std::string, RegisterFunction> s_registerFunctions{
+        {"GTiff", GDALRegister_GTiff},
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3, 1, 0)
+        {"COG", GDALRegister_COG},
+#endif
+        {"VRT", GDALRegister_VRT},
+        {"MEM", GDALRegister_MEM},
+        {"PNG", GDALRegister_PNG},
+        {"JPEG", GDALRegister_JPEG},
+        {"GIF", GDALRegister_GIF},
+        {"BMP", GDALRegister_BMP},
+        {"HFA", GDALRegister_HFA},
+        {"AAIGrid", GDALRegister_AAIGrid},
+        {"DTED", GDALRegister_DTED},
+        {"SRTMHGT", GDALRegister_SRTMHGT},
+        {"USGSDEM", GDALRegister_USGSDEM},
+        {"NITF", GDALRegister_NITF},
+        {"EHdr", GDALRegister_EHdr},
+        {"ENVI", GDALRegister_ENVI},
+        {"XYZ", GDALRegister_XYZ}};
+
+    static std::mutex s_registerMutex;
+    static std::set<std::string> s_unknownDrivers;
+
+    std::scoped_lock<std::mutex> lock(s_registerMutex);
+
+    // drivers are registered as they are first requested, so later calls requesting further drivers add them rather than being ignored
+    bool registered = false;
+    for (auto& driver : drivers)
     {
-        return false;
+        if (GDALGetDriverByName(driver.c_str())) continue;
+
+        if (auto itr = s_registerFunctions.find(driver); itr != s_registerFunctions.end())
+        {
+            itr->second();
+            registered = true;
+        }
+        else if (s_unknownDrivers.insert(driver).second)
+        {
+            // driver doesn't have a known registration entry point so fallback to registering all drivers
+            vsg::warn("vsgXchange::initGDAL() driver ", driver, " not supported for individual registration, calling GDALAllRegister().");
+            if (initGDAL()) registered = true;
+        }
     }
+    return registered;
 }
 
 bool vsgXchange::compatibleDatasetProjections(const GDALDataset& lhs, const GDALDataset& rhs)
@@ -136,51 +202,61 @@ vsg::t_vec4<T> default_vec4(const vsg::dvec4& value)
     return vsg::t_vec4<T>(default_value<T>(value[0]), default_value<T>(value[1]), default_value<T>(value[2]), default_value<T>(value[3]));
 }
 
-vsg::ref_ptr<vsg::Data> vsgXchange::createImage2D(int width, int height, int numComponents, GDALDataType dataType, vsg::dvec4 def)
+template<typename T>
+vsg::ref_ptr<vsg::Data> createImage2DOfType(uint32_t w, uint32_t h, int numComponents, const vsg::dvec4* def, VkFormat format1, VkFormat format2, VkFormat format3, VkFormat format4)
 {
-    using TypeComponents = std::pair<GDALDataType, int>;
-    using CreateFunction = std::function<vsg::ref_ptr<vsg::Data>(uint32_t w, uint32_t h, vsg::dvec4 def)>;
-
-    std::map<TypeComponents, CreateFunction> createMap;
-    createMap[TypeComponents(GDT_Byte, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ubyteArray2D::create(w, h, default_value<uint8_t>(d[0]), vsg::Data::Properties{VK_FORMAT_R8_UNORM}); };
-    createMap[TypeComponents(GDT_UInt16, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ushortArray2D::create(w, h, default_value<uint16_t>(d[0]), vsg::Data::Properties{VK_FORMAT_R16_UNORM}); };
-    createMap[TypeComponents(GDT_Int16, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::shortArray2D::create(w, h, default_value<int16_t>(d[0]), vsg::Data::Properties{VK_FORMAT_R16_SNORM}); };
-    createMap[TypeComponents(GDT_UInt32, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::uintArray2D::create(w, h, default_value<uint32_t>(d[0]), vsg::Data::Properties{VK_FORMAT_R32_UINT}); };
-    createMap[TypeComponents(GDT_Int32, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::intArray2D::create(w, h, default_value<int32_t>(d[0]), vsg::Data::Properties{VK_FORMAT_R32_SINT}); };
-    createMap[TypeComponents(GDT_Float32, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::floatArray2D::create(w, h, default_value<float>(d[0]), vsg::Data::Properties{VK_FORMAT_R32_SFLOAT}); };
-    createMap[TypeComponents(GDT_Float64, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::doubleArray2D::create(w, h, default_value<double>(d[0]), vsg::Data::Properties{VK_FORMAT_R64_SFLOAT}); };
-
-    createMap[TypeComponents(GDT_Byte, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ubvec2Array2D::create(w, h, default_vec2<uint8_t>(d), vsg::Data::Properties{VK_FORMAT_R8G8_UNORM}); };
-    createMap[TypeComponents(GDT_UInt16, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::usvec2Array2D::create(w, h, default_vec2<uint16_t>(d), vsg::Data::Properties{VK_FORMAT_R16G16_UNORM}); };
-    createMap[TypeComponents(GDT_Int16, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::svec2Array2D::create(w, h, default_vec2<int16_t>(d), vsg::Data::Properties{VK_FORMAT_R16G16_SNORM}); };
-    createMap[TypeComponents(GDT_UInt32, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::uivec2Array2D::create(w, h, default_vec2<uint32_t>(d), vsg::Data::Properties{VK_FORMAT_R32G32_UINT}); };
-    createMap[TypeComponents(GDT_Int32, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ivec2Array2D::create(w, h, default_vec2<int32_t>(d), vsg::Data::Properties{VK_FORMAT_R32G32_SINT}); };
-    createMap[TypeComponents(GDT_Float32, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::vec2Array2D::create(w, h, default_vec2<float>(d), vsg::Data::Properties{VK_FORMAT_R32G32_SFLOAT}); };
-    createMap[TypeComponents(GDT_Float64, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::dvec2Array2D::create(w, h, default_vec2<double>(d), vsg::Data::Properties{VK_FORMAT_R64G64_SFLOAT}); };
-
-    createMap[TypeComponents(GDT_Byte, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ubvec3Array2D::create(w, h, default_vec3<uint8_t>(d), vsg::Data::Properties{VK_FORMAT_R8G8B8_UNORM}); };
-    createMap[TypeComponents(GDT_UInt16, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::usvec3Array2D::create(w, h, default_vec3<uint16_t>(d), vsg::Data::Properties{VK_FORMAT_R16G16B16_UNORM}); };
-    createMap[TypeComponents(GDT_Int16, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::svec3Array2D::create(w, h, default_vec3<int16_t>(d), vsg::Data::Properties{VK_FORMAT_R16G16B16_SNORM}); };
-    createMap[TypeComponents(GDT_UInt32, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::uivec3Array2D::create(w, h, default_vec3<uint32_t>(d), vsg::Data::Properties{VK_FORMAT_R32G32B32_UINT}); };
-    createMap[TypeComponents(GDT_Int32, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ivec3Array2D::create(w, h, default_vec3<int32_t>(d), vsg::Data::Properties{VK_FORMAT_R32G32B32_SINT}); };
-    createMap[TypeComponents(GDT_Float32, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::vec3Array2D::create(w, h, default_vec3<float>(d), vsg::Data::Properties{VK_FORMAT_R32G32B32_SFLOAT}); };
-    createMap[TypeComponents(GDT_Float64, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::dvec3Array2D::create(w, h, default_vec3<double>(d), vsg::Data::Properties{VK_FORMAT_R64G64B64_SFLOAT}); };
-
-    createMap[TypeComponents(GDT_Byte, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ubvec4Array2D::create(w, h, default_vec4<uint8_t>(d), vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM}); };
-    createMap[TypeComponents(GDT_UInt16, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::usvec4Array2D::create(w, h, default_vec4<uint16_t>(d), vsg::Data::Properties{VK_FORMAT_R16G16B16A16_UNORM}); };
-    createMap[TypeComponents(GDT_Int16, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::svec4Array2D::create(w, h, default_vec4<int16_t>(d), vsg::Data::Properties{VK_FORMAT_R16G16B16A16_SNORM}); };
-    createMap[TypeComponents(GDT_UInt32, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::uivec4Array2D::create(w, h, default_vec4<uint32_t>(d), vsg::Data::Properties{VK_FORMAT_R32G32B32A32_UINT}); };
-    createMap[TypeComponents(GDT_Int32, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ivec4Array2D::create(w, h, default_vec4<int32_t>(d), vsg::Data::Properties{VK_FORMAT_R32G32B32A32_SINT}); };
-    createMap[TypeComponents(GDT_Float32, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::vec4Array2D::create(w, h, default_vec4<float>(d), vsg::Data::Properties{VK_FORMAT_R32G32B32A32_SFLOAT}); };
-    createMap[TypeComponents(GDT_Float64, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::dvec4Array2D::create(w, h, default_vec4<double>(d), vsg::Data::Properties{VK_FORMAT_R64G64B64A64_SFLOAT}); };
-
-    auto itr = createMap.find(TypeComponents(dataType, numComponents));
-    if (itr == createMap.end())
+    if (numComponents < 1 || numComponents > 4) return {};
+    if (!vsgXchange::reserveReadMemory(static_cast<uint64_t>(w) * h * numComponents * sizeof(T))) return {};
+
+    // when no default value is provided the arrays are left uninitialized, for callers that will overwrite every pixel
+    switch (numComponents)
     {
+    case (1):
+        if (def) return vsg::Array2D<T>::create(w, h, default_value<T>((*def)[0]), vsg::Data::Properties{format1});
+        return vsg::Array2D<T>::create(w, h, vsg::Data::Properties{format1});
+    case (2):
+        if (def) return vsg::Array2D<vsg::t_vec2<T>>::create(w, h, default_vec2<T>(*def), vsg::Data::Properties{format2});
+        return vsg::Array2D<vsg::t_vec2<T>>::create(w, h, vsg::Data::Properties{format2});
+    case (3):
+        if (def) return vsg::Array2D<vsg::t_vec3<T>>::create(w, h, default_vec3<T>(*def), vsg::Data::Properties{format3});
+        return vsg::Array2D<vsg::t_vec3<T>>::create(w, h, vsg::Data::Properties{format3});
+    case (4):
+        if (def) return vsg::Array2D<vsg::t_vec4<T>>::create(w, h, default_vec4<T>(*def), vsg::Data::Properties{format4});
+        return vsg::Array2D<vsg::t_vec4<T>>::create(w, h, vsg::Data::Properties{format4});
+    default:
+        return {};
+    }
+}
+
+vsg::ref_ptr<vsg::Data> createImage2DOfDataType(int width, int height, int numComponents, GDALDataType dataType, const vsg::dvec4* def)
+{
+    if (width <= 0 || height <= 0) return {};
+
+    uint32_t w = static_cast<uint32_t>(width);
+    uint32_t h = static_cast<uint32_t>(height);
+
+    switch (dataType)
+    {
+    case (GDT_Byte): return createImage2DOfType<uint8_t>(w, h, numComponents, def, VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_R8G8B8A8_UNORM);
+    case (GDT_UInt16): return createImage2DOfType<uint16_t>(w, h, numComponents, def, VK_FORMAT_R16_UNORM, VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16A16_UNORM);
+    case (GDT_Int16): return createImage2DOfType<int16_t>(w, h, numComponents, def, VK_FORMAT_R16_SNORM, VK_FORMAT_R16G16_SNORM, VK_FORMAT_R16G16B16_SNORM, VK_FORMAT_R16G16B16A16_SNORM);
+    case (GDT_UInt32): return createImage2DOfType<uint32_t>(w, h, numComponents, def, VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT);
+    case (GDT_Int32): return createImage2DOfType<int32_t>(w, h, numComponents, def, VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT);
+    case (GDT_Float32): return createImage2DOfType<float>(w, h, numComponents, def, VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT);
+    case (GDT_Float64): return createImage2DOfType<double>(w, h, numComponents, def, VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT);
+    default:
         return {};
     }
+}
+
+vsg::ref_ptr<vsg::Data> vsgXchange::createImage2D(int width, int height, int numComponents, GDALDataType dataType, vsg::dvec4 def)
+{
+    return createImage2DOfDataType(width, height, numComponents, dataType, &def);
+}
 
-    return (itr->second)(width, height, def);
+vsg::ref_ptr<vsg::Data> vsgXchange::allocateImage2D(int width, int height, int numComponents, GDALDataType dataType)
+{
+    return createImage2DOfDataType(width, height, numComponents, dataType, nullptr);
 }
 
 bool vsgXchange::copyRasterBandToImage(GDALRasterBand& band, vsg::Data& image, int component)
@@ -190,65 +266,140 @@ bool vsgXchange::copyRasterBandToImage(GDALRasterBand& band, vsg::Data& image, i
         return false;
     }
 
-    int dataSize = 0;
-    switch (band.GetRasterDataType())
+    // RasterIO with a pixel spacing of the image stride copies each block straight into place, without an intermediate block buffer.
+    return copyRasterBandWindowToImage(band, 0, 0, band.GetXSize(), band.GetYSize(), image, component);
+}
+
+namespace
+{
+    int CPL_STDCALL cancellationProgress(double /*complete*/, const char* /*message*/, void* data)
+    {
+        // returning FALSE makes GDAL abandon the RasterIO
+        return static_cast<const vsgXchange::CancellationToken*>(data)->cancelled() ? FALSE : TRUE;
+    }
+} // namespace
+
+void vsgXchange::assignCancellation(GDALRasterIOExtraArg& extraArg, const CancellationToken* cancellation)
+{
+    if (!cancellation) return;
+
+    extraArg.pfnProgress = cancellationProgress;
+    extraArg.pProgressData = const_cast<CancellationToken*>(cancellation);
+}
+
+bool vsgXchange::copyRasterBandWindowToImage(GDALRasterBand& band, int xOffset, int yOffset, int xSize, int ySize, vsg::Data& image, int component, const CancellationToken* cancellation)
+{
+    if (xOffset < 0 || yOffset < 0 || xSize <= 0 || ySize <= 0 || (xOffset + xSize) > band.GetXSize() || (yOffset + ySize) > band.GetYSize())
     {
-    case (GDT_Byte): dataSize = 1; break;
-    case (GDT_UInt16):
-    case (GDT_Int16): dataSize = 2; break;
-    case (GDT_UInt32):
-    case (GDT_Int32):
-    case (GDT_Float32): dataSize = 4; break;
-    case (GDT_Float64): dataSize = 8; break;
-    default:
         return false;
     }
 
-    int offset = dataSize * component;
-    int stride = image.properties.stride;
+    GDALDataType dataType = band.GetRasterDataType();
+    int dataSize = GDALGetDataTypeSizeBytes(dataType);
+    if (dataSize == 0 || static_cast<uint32_t>(dataSize * (component + 1)) > image.stride()) return false;
 
-    int nBlockXSize, nBlockYSize;
-    band.GetBlockSize(&nBlockXSize, &nBlockYSize);
+    GSpacing pixelSpace = image.stride();
+    GSpacing lineSpace = pixelSpace * image.width();
+    uint8_t* dest_ptr = reinterpret_cast<uint8_t*>(image.dataPointer()) + dataSize * component;
 
-    int nXBlocks = (band.GetXSize() + nBlockXSize - 1) / nBlockXSize;
-    int nYBlocks = (band.GetYSize() + nBlockYSize - 1) / nBlockYSize;
+    GDALRasterIOExtraArg extraArg;
+    INIT_RASTERIO_EXTRA_ARG(extraArg);
+    assignCancellation(extraArg, cancellation);
 
-    uint8_t* block = new uint8_t[dataSize * nBlockXSize * nBlockYSize];
+    CPLErr result = band.RasterIO(GF_Read, xOffset, yOffset, xSize, ySize, dest_ptr, static_cast<int>(image.width()), static_cast<int>(image.height()), dataType, pixelSpace, lineSpace, &extraArg);
+    return result == CE_None;
+}
+
+bool vsgXchange::copyRasterBandsToImage(GDALDataset& dataset, const std::vector<int>& bandNumbers, int xOffset, int yOffset, int xSize, int ySize, vsg::Data& image, const CancellationToken* cancellation)
+{
+    if (bandNumbers.empty()) return false;
 
-    for (int iYBlock = 0; iYBlock < nYBlocks; iYBlock++)
+    if (xOffset < 0 || yOffset < 0 || xSize <= 0 || ySize <= 0 || (xOffset + xSize) > dataset.GetRasterXSize() || (yOffset + ySize) > dataset.GetRasterYSize())
     {
-        for (int iXBlock = 0; iXBlock < nXBlocks; iXBlock++)
+        return false;
+    }
+
+    auto firstBand = dataset.GetRasterBand(bandNumbers.front());
+    if (!firstBand) return false;
+
+    GDALDataType dataType = firstBand->GetRasterDataType();
+    int dataSize = GDALGetDataTypeSizeBytes(dataType);
+    if (dataSize == 0 || static_cast<uint32_t>(dataSize * bandNumbers.size()) > image.stride()) return false;
+
+    GSpacing pixelSpace = image.stride();
+    GSpacing lineSpace = pixelSpace * image.width();
+    GSpacing bandSpace = dataSize;
+
+    GDALRasterIOExtraArg extraArg;
+    INIT_RASTERIO_EXTRA_ARG(extraArg);
+    assignCancellation(extraArg, cancellation);
+
+    CPLErr result = dataset.RasterIO(GF_Read, xOffset, yOffset, xSize, ySize, image.dataPointer(), static_cast<int>(image.width()), static_cast<int>(image.height()), dataType,
+                                     static_cast<int>(bandNumbers.size()), const_cast<int*>(bandNumbers.data()), pixelSpace, lineSpace, bandSpace, &extraArg);
+    return result == CE_None;
+}
+
+vsg::ref_ptr<vsg::Data> vsgXchange::createMask(const std::vector<GDALRasterBand*>& bands, int xOffset, int yOffset, int xSize, int ySize, int width, int height, bool packed)
+{
+    if (width <= 0 || height <= 0) return {};
+
+    // collect the distinct mask bands, bands sharing a per dataset mask only need it to be read once
+    std::vector<GDALRasterBand*> maskBands;
+    for (auto band : bands)
+    {
+        if (band->GetMaskFlags() & GMF_ALL_VALID) continue;
+
+        auto maskBand = band->GetMaskBand();
+        if (maskBand && std::find(maskBands.begin(), maskBands.end(), maskBand) == maskBands.end()) maskBands.push_back(maskBand);
+    }
+
+    if (maskBands.empty()) return {};
+
+    GDALRasterIOExtraArg extraArg;
+    INIT_RASTERIO_EXTRA_ARG(extraArg);
+
+    // the combined mask is transient, the final mask is either the same size or packed to a bit per pixel
+    vsgXchange::ReadMemoryReservation combinedReservation(static_cast<uint64_t>(width) * height);
+    if (!combinedReservation) return {};
+
+    std::vector<uint8_t> combined(static_cast<size_t>(width) * height);
+    if (maskBands.front()->RasterIO(GF_Read, xOffset, yOffset, xSize, ySize, combined.data(), width, height, GDT_Byte, 0, 0, &extraArg) != CE_None) return {};
+
+    std::vector<uint8_t> values;
+    for (size_t b = 1; b < maskBands.size(); ++b)
+    {
+        values.resize(combined.size());
+        if (maskBands[b]->RasterIO(GF_Read, xOffset, yOffset, xSize, ySize, values.data(), width, height, GDT_Byte, 0, 0, &extraArg) != CE_None) return {};
+
+        for (size_t i = 0; i < combined.size(); ++i)
         {
-            int nXValid, nYValid;
-            CPLErr result = band.ReadBlock(iXBlock, iYBlock, block);
-            if (result == 0)
-            {
-                // Compute the portion of the block that is valid
-                // for partial edge blocks.
-                band.GetActualBlockSize(iXBlock, iYBlock, &nXValid, &nYValid);
-
-                for (int iY = 0; iY < nYValid; iY++)
-                {
-                    uint8_t* dest_ptr = reinterpret_cast<uint8_t*>(image.dataPointer(iXBlock * nBlockXSize + (iYBlock * nBlockYSize + iY) * image.width())) + offset;
-                    uint8_t* source_ptr = block + iY * nBlockXSize * dataSize;
-
-                    for (int iX = 0; iX < nXValid; iX++)
-                    {
-                        for (int c = 0; c < dataSize; ++c)
-                        {
-                            dest_ptr[c] = *source_ptr;
-                            ++source_ptr;
-                        }
-
-                        dest_ptr += stride;
-                    }
-                }
-            }
+            if (values[i] == 0) combined[i] = 0;
         }
     }
-    delete[] block;
 
-    return true;
+    uint32_t rowBytes = packed ? (width + 7) / 8 : width;
+    if (!vsgXchange::reserveReadMemory(static_cast<uint64_t>(rowBytes) * height)) return {};
+
+    if (!packed)
+    {
+        auto mask = vsg::ubyteArray2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R8_UNORM});
+        auto itr = mask->begin();
+        for (auto value : combined) *(itr++) = value ? 255 : 0;
+        return mask;
+    }
+
+    auto mask = vsg::ubyteArray2D::create(rowBytes, height, uint8_t(0), vsg::Data::Properties{VK_FORMAT_R8_UINT});
+    for (int r = 0; r < height; ++r)
+    {
+        const uint8_t* src = combined.data() + static_cast<size_t>(r) * width;
+        uint8_t* dest = &mask->at(0, r);
+        for (int c = 0; c < width; ++c)
+        {
+            if (src[c]) dest[c / 8] |= static_cast<uint8_t>(0x80 >> (c % 8));
+        }
+    }
+    mask->setValue("Width", width);
+    return mask;
 }
 
 bool vsgXchange::assignMetaData(GDALDataset& dataset, vsg::Object& object)
@@ -0,0 +1,264 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/commands/VertexIndexDraw.h>
+#include <vsg/core/Array2D.h>
+#include <vsg/io/Logger.h>
+#include <vsg/maths/transform.h>
+#include <vsg/nodes/MatrixTransform.h>
+#include <vsg/nodes/StateGroup.h>
+#include <vsg/state/material.h>
+#include <vsg/utils/GraphicsPipelineConfigurator.h>
+#include <vsg/utils/ShaderSet.h>
+#include <vsg/utils/SharedObjects.h>
+
+#include <vsgXchange/gdal.h>
+#include <vsgXchange/read_memory.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace vsgXchange;
+
+namespace
+{
+    template<typename T>
+    bool copyHeights(const vsg::Data& image, std::vector<float>& heights)
+    {
+        auto array = dynamic_cast<const vsg::Array2D<T>*>(&image);
+        if (!array) return false;
+
+        heights.resize(array->valueCount());
+        for (size_t i = 0; i < heights.size(); ++i)
+        {
+            heights[i] = static_cast<float>((*array)[i]);
+        }
+        return true;
+    }
+
+    /// list of the sample positions along an axis of size samples, every step'th sample with the last sample always included so the patch covers the full extent.
+    std::vector<uint32_t> sampleIndices(uint32_t size, uint32_t step)
+    {
+        std::vector<uint32_t> indices;
+        for (uint32_t i = 0; i < size; i += step) indices.push_back(i);
+        if (indices.back() != size - 1) indices.push_back(size - 1);
+        return indices;
+    }
+} // namespace
+
+vsg::ref_ptr<vsg::Node> vsgXchange::createHeightField(const vsg::Data& image, uint32_t step, vsg::ref_ptr<const vsg::Options> options)
+{
+    uint32_t width = image.width();
+    uint32_t height = image.height();
+    if (width < 2 || height < 2) return {};
+
+    std::vector<float> heights;
+    if (!copyHeights<float>(image, heights) && !copyHeights<double>(image, heights) &&
+        !copyHeights<int16_t>(image, heights) && !copyHeights<uint16_t>(image, heights) &&
+        !copyHeights<int32_t>(image, heights) && !copyHeights<uint32_t>(image, heights) &&
+        !copyHeights<uint8_t>(image, heights))
+    {
+        vsg::info("vsgXchange::createHeightField() unsupported image type ", image.className(), ", requires a single component elevation image.");
+        return {};
+    }
+
+    // NoData and non finite samples are replaced by the lowest valid height so they don't pull the mesh into spikes, and the cells touching them are left out as holes
+    double noDataValue = 0.0;
+    bool hasNoData = image.getValue("NoDataValue", noDataValue);
+    float noDataHeight = static_cast<float>(noDataValue);
+    auto validHeight = [&](float h) { return std::isfinite(h) && !(hasNoData && h == noDataHeight); };
+
+    std::vector<bool> valid(heights.size());
+    float minHeight = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < heights.size(); ++i)
+    {
+        valid[i] = validHeight(heights[i]);
+        if (valid[i]) minHeight = std::min(minHeight, heights[i]);
+    }
+    if (minHeight == std::numeric_limits<float>::max())
+    {
+        vsg::info("vsgXchange::createHeightField() elevation image has no valid samples.");
+        return {};
+    }
+    for (size_t i = 0; i < heights.size(); ++i)
+    {
+        if (!valid[i]) heights[i] = minHeight;
+    }
+
+    double gt[6] = {0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+    if (auto transform = image.getObject<vsg::doubleArray>("GeoTransform"); transform && transform->size() == 6)
+    {
+        for (int i = 0; i < 6; ++i) gt[i] = (*transform)[i];
+    }
+
+    // position of the centre of a pixel in the georeferenced coordinate frame
+    auto position = [&](uint32_t c, uint32_t r) {
+        double x = static_cast<double>(c) + 0.5;
+        double y = static_cast<double>(r) + 0.5;
+        return vsg::dvec3(gt[0] + x * gt[1] + y * gt[2], gt[3] + x * gt[4] + y * gt[5], heights[r * width + c]);
+    };
+
+    step = std::max(step, 1u);
+    auto columns = sampleIndices(width, step);
+    auto rows = sampleIndices(height, step);
+    uint32_t numColumns = static_cast<uint32_t>(columns.size());
+    uint32_t numRows = static_cast<uint32_t>(rows.size());
+    uint32_t numVertices = numColumns * numRows;
+
+    // vertices are placed relative to the first sample so that they can be held at float precision, with the origin held in a MatrixTransform.
+    vsg::dvec3 origin = position(0, 0);
+    origin.z = 0.0;
+
+    // only cells with all four corners valid are triangulated
+    auto validCell = [&](uint32_t i, uint32_t j) {
+        return valid[rows[j] * width + columns[i]] && valid[rows[j] * width + columns[i + 1]] && valid[rows[j + 1] * width + columns[i]] && valid[rows[j + 1] * width + columns[i + 1]];
+    };
+
+    uint32_t numIndices = 0;
+    for (uint32_t j = 0; j < numRows - 1; ++j)
+    {
+        for (uint32_t i = 0; i < numColumns - 1; ++i)
+        {
+            if (validCell(i, j)) numIndices += 6;
+        }
+    }
+    if (numIndices == 0) return {};
+    uint64_t indexSize = (numVertices > 65536) ? sizeof(uint32_t) : sizeof(uint16_t);
+    if (!reserveReadMemory(static_cast<uint64_t>(numVertices) * (sizeof(vsg::vec3) * 2 + sizeof(vsg::vec2)) + numIndices * indexSize)) return {};
+
+    auto vertices = vsg::vec3Array::create(numVertices);
+    auto normals = vsg::vec3Array::create(numVertices);
+    auto texcoords = vsg::vec2Array::create(numVertices);
+
+    for (uint32_t j = 0; j < numRows; ++j)
+    {
+        for (uint32_t i = 0; i < numColumns; ++i)
+        {
+            uint32_t vi = j * numColumns + i;
+            (*vertices)[vi] = vsg::vec3(position(columns[i], rows[j]) - origin);
+            (*texcoords)[vi].set(static_cast<float>(columns[i]) / static_cast<float>(width - 1), static_cast<float>(rows[j]) / static_cast<float>(height - 1));
+        }
+    }
+
+    for (uint32_t j = 0; j < numRows; ++j)
+    {
+        for (uint32_t i = 0; i < numColumns; ++i)
+        {
+            auto& left = (*vertices)[j * numColumns + (i > 0 ? i - 1 : i)];
+            auto& right = (*vertices)[j * numColumns + (i < numColumns - 1 ? i + 1 : i)];
+            auto& below = (*vertices)[(j > 0 ? j - 1 : j) * numColumns + i];
+            auto& above = (*vertices)[(j < numRows - 1 ? j + 1 : j) * numColumns + i];
+
+            auto normal = vsg::normalize(vsg::cross(right - left, above - below));
+            if (normal.z < 0.0f) normal = -normal;
+            (*normals)[j * numColumns + i] = normal;
+        }
+    }
+
+    // flip the winding when the rows run in the negative y direction, as is typical for north up rasters, so triangles face +z
+    bool flip = (gt[1] * gt[5] - gt[2] * gt[4]) < 0.0;
+
+    vsg::ref_ptr<vsg::Data> indices;
+    auto assignIndices = [&](auto indexArray) {
+        size_t pos = 0;
+        for (uint32_t j = 0; j < numRows - 1; ++j)
+        {
+            for (uint32_t i = 0; i < numColumns - 1; ++i)
+            {
+                if (!validCell(i, j)) continue;
+
+                using index_type = typename std::decay_t<decltype(*indexArray)>::value_type;
+                index_type i00 = static_cast<index_type>(j * numColumns + i);
+                index_type i10 = static_cast<index_type>(i00 + 1);
+                index_type i01 = static_cast<index_type>(i00 + numColumns);
+                index_type i11 = static_cast<index_type>(i01 + 1);
+
+                if (flip)
+                {
+                    (*indexArray)[pos++] = i00;
+                    (*indexArray)[pos++] = i01;
+                    (*indexArray)[pos++] = i11;
+                    (*indexArray)[pos++] = i00;
+                    (*indexArray)[pos++] = i11;
+                    (*indexArray)[pos++] = i10;
+                }
+                else
+                {
+                    (*indexArray)[pos++] = i00;
+                    (*indexArray)[pos++] = i10;
+                    (*indexArray)[pos++] = i11;
+                    (*indexArray)[pos++] = i00;
+                    (*indexArray)[pos++] = i11;
+                    (*indexArray)[pos++] = i01;
+                }
+            }
+        }
+        indices = indexArray;
+    };
+
+    if (numVertices > 65536)
+        assignIndices(vsg::uintArray::create(numIndices));
+    else
+        assignIndices(vsg::ushortArray::create(numIndices));
+
+    // set up a phong shaded pipeline, shared with other heightfields through the options->sharedObjects
+    auto sharedObjects = options ? options->sharedObjects : vsg::ref_ptr<vsg::SharedObjects>();
+    if (!sharedObjects) sharedObjects = vsg::SharedObjects::create();
+
+    auto shaderSet = vsg::createPhongShaderSet(options);
+    sharedObjects->share(shaderSet);
+
+    auto material = vsg::DescriptorConfigurator::create(shaderSet);
+    material->assignDescriptor("material", vsg::PhongMaterialValue::create());
+
+    auto config = vsg::GraphicsPipelineConfigurator::create(shaderSet);
+    config->descriptorConfigurator = material;
+
+    vsg::DataList vertexArrays;
+    config->assignArray(vertexArrays, "vsg_Vertex", VK_VERTEX_INPUT_RATE_VERTEX, vertices);
+    config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_VERTEX, normals);
+    config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_VERTEX, texcoords);
+    config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec4Value::create(1.0f, 1.0f, 1.0f, 1.0f));
+
+    sharedObjects->share(config, [](auto gpc) { gpc->init(); });
+
+    auto vid = vsg::VertexIndexDraw::create();
+    vid->assignArrays(vertexArrays);
+    vid->assignIndices(indices);
+    vid->indexCount = numIndices;
+    vid->instanceCount = 1;
+
+    auto stateGroup = vsg::StateGroup::create();
+    config->copyTo(stateGroup, sharedObjects);
+    stateGroup->addChild(vid);
+
+    auto transform = vsg::MatrixTransform::create(vsg::translate(origin));
+    transform->addChild(stateGroup);
+
+    std::string projectionRef;
+    if (image.getValue("ProjectionRef", projectionRef)) transform->setValue("ProjectionRef", projectionRef);
+
+    return transform;
+}
@@ -0,0 +1,946 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/commands/VertexIndexDraw.h>
+#include <vsg/io/Logger.h>
+#include <vsg/io/Options.h>
+#include <vsg/maths/box.h>
+#include <vsg/maths/color.h>
+#include <vsg/maths/transform.h>
+#include <vsg/nodes/Group.h>
+#include <vsg/nodes/MatrixTransform.h>
+#include <vsg/nodes/StateGroup.h>
+#include <vsg/state/ColorBlendState.h>
+#include <vsg/state/InputAssemblyState.h>
+#include <vsg/state/material.h>
+#include <vsg/utils/GraphicsPipelineConfigurator.h>
+#include <vsg/utils/ShaderSet.h>
+#include <vsg/utils/SharedObjects.h>
+
+#include <vsgXchange/cancellation.h>
+#include <vsgXchange/gdal.h>
+#include <vsgXchange/read_memory.h>
+
+#include <ogr_featurestyle.h>
+#include <ogrsf_frmts.h>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace vsgXchange;
+
+namespace
+{
+    //
+    // ear clipping triangulation of polygons with holes, following the approach of mapbox's earcut: holes are bridged into the outer ring,
+    // then ears are clipped, falling back to curing self intersections and splitting the polygon along a valid diagonal when no ear can be found.
+    //
+    class Triangulator
+    {
+    public:
+        /// triangulate the polygon whose rings, outer ring first, index into points, appending the triangles' point indices to triangles.
+        void triangulate(const std::vector<vsg::dvec2>& points, const std::vector<std::pair<uint32_t, uint32_t>>& rings, std::vector<uint32_t>& triangles)
+        {
+            _nodes.clear();
+            _triangles = &triangles;
+            if (rings.empty()) return;
+
+            Node* outer = linkedList(points, rings.front().first, rings.front().second, true);
+            if (!outer || outer->next == outer->prev) return;
+
+            if (rings.size() > 1) outer = eliminateHoles(points, rings, outer);
+            earcutLinked(outer, 0);
+        }
+
+    protected:
+        struct Node
+        {
+            uint32_t i;
+            double x, y;
+            Node* prev = nullptr;
+            Node* next = nullptr;
+            bool steiner = false;
+        };
+
+        std::deque<Node> _nodes;
+        std::vector<uint32_t>* _triangles = nullptr;
+
+        static double area(const Node* p, const Node* q, const Node* r) { return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y); }
+        static bool equals(const Node* p, const Node* q) { return p->x == q->x && p->y == q->y; }
+        static int sign(double value) { return value > 0.0 ? 1 : (value < 0.0 ? -1 : 0); }
+
+        static bool pointInTriangle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py)
+        {
+            return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+                   (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+                   (bx - px) * (cy - py) >= (cx - px) * (by - py);
+        }
+
+        static bool onSegment(const Node* p, const Node* q, const Node* r)
+        {
+            return q->x <= std::max(p->x, r->x) && q->x >= std::min(p->x, r->x) && q->y <= std::max(p->y, r->y) && q->y >= std::min(p->y, r->y);
+        }
+
+        static bool intersects(const Node* p1, const Node* q1, const Node* p2, const Node* q2)
+        {
+            int o1 = sign(area(p1, q1, p2));
+            int o2 = sign(area(p1, q1, q2));
+            int o3 = sign(area(p2, q2, p1));
+            int o4 = sign(area(p2, q2, q1));
+
+            if (o1 != o2 && o3 != o4) return true;
+            if (o1 == 0 && onSegment(p1, p2, q1)) return true;
+            if (o2 == 0 && onSegment(p1, q2, q1)) return true;
+            if (o3 == 0 && onSegment(p2, p1, q2)) return true;
+            if (o4 == 0 && onSegment(p2, q1, q2)) return true;
+            return false;
+        }
+
+        static bool intersectsPolygon(const Node* a, const Node* b)
+        {
+            const Node* p = a;
+            do
+            {
+                if (p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i && intersects(p, p->next, a, b)) return true;
+                p = p->next;
+            } while (p != a);
+            return false;
+        }
+
+        static bool locallyInside(const Node* a, const Node* b)
+        {
+            return area(a->prev, a, a->next) < 0.0 ? (area(a, b, a->next) >= 0.0 && area(a, a->prev, b) >= 0.0) : (area(a, b, a->prev) < 0.0 || area(a, a->next, b) < 0.0);
+        }
+
+        static bool middleInside(const Node* a, const Node* b)
+        {
+            const Node* p = a;
+            bool inside = false;
+            double px = (a->x + b->x) * 0.5;
+            double py = (a->y + b->y) * 0.5;
+            do
+            {
+                if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y && (px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x)) inside = !inside;
+                p = p->next;
+            } while (p != a);
+            return inside;
+        }
+
+        static bool isValidDiagonal(const Node* a, const Node* b)
+        {
+            return a->next->i != b->i && a->prev->i != b->i && !intersectsPolygon(a, b) &&
+                   ((locallyInside(a, b) && locallyInside(b, a) && middleInside(a, b) && (area(a->prev, a, b->prev) != 0.0 || area(a, b->prev, b) != 0.0)) ||
+                    (equals(a, b) && area(a->prev, a, a->next) > 0.0 && area(b->prev, b, b->next) > 0.0));
+        }
+
+        static bool sectorContainsSector(const Node* m, const Node* p)
+        {
+            return area(m->prev, m, p->prev) < 0.0 && area(p->next, m, m->next) < 0.0;
+        }
+
+        Node* insertNode(uint32_t i, const vsg::dvec2& point, Node* last)
+        {
+            Node* p = &_nodes.emplace_back();
+            p->i = i;
+            p->x = point.x;
+            p->y = point.y;
+            if (!last)
+            {
+                p->prev = p;
+                p->next = p;
+            }
+            else
+            {
+                p->next = last->next;
+                p->prev = last;
+                last->next->prev = p;
+                last->next = p;
+            }
+            return p;
+        }
+
+        static void removeNode(Node* p)
+        {
+            p->next->prev = p->prev;
+            p->prev->next = p->next;
+        }
+
+        Node* linkedList(const std::vector<vsg::dvec2>& points, uint32_t start, uint32_t end, bool clockwise)
+        {
+            double signedArea = 0.0;
+            for (uint32_t i = start, j = end - 1; i < end; j = i++)
+            {
+                signedArea += (points[j].x - points[i].x) * (points[i].y + points[j].y);
+            }
+
+            Node* last = nullptr;
+            if (clockwise == (signedArea > 0.0))
+            {
+                for (uint32_t i = start; i < end; ++i) last = insertNode(i, points[i], last);
+            }
+            else
+            {
+                for (uint32_t i = end; i > start; --i) last = insertNode(i - 1, points[i - 1], last);
+            }
+
+            if (last && equals(last, last->next))
+            {
+                removeNode(last);
+                last = last->next;
+            }
+            return last;
+        }
+
+        static Node* filterPoints(Node* start, Node* end = nullptr)
+        {
+            if (!start) return start;
+            if (!end) end = start;
+
+            Node* p = start;
+            bool again;
+            do
+            {
+                again = false;
+                if (!p->steiner && (equals(p, p->next) || area(p->prev, p, p->next) == 0.0))
+                {
+                    removeNode(p);
+                    p = end = p->prev;
+                    if (p == p->next) break;
+                    again = true;
+                }
+                else
+                {
+                    p = p->next;
+                }
+            } while (again || p != end);
+            return end;
+        }
+
+        static bool isEar(const Node* ear)
+        {
+            const Node* a = ear->prev;
+            const Node* b = ear;
+            const Node* c = ear->next;
+            if (area(a, b, c) >= 0.0) return false; // reflex
+
+            double x0 = std::min({a->x, b->x, c->x}), y0 = std::min({a->y, b->y, c->y});
+            double x1 = std::max({a->x, b->x, c->x}), y1 = std::max({a->y, b->y, c->y});
+
+            for (const Node* p = c->next; p != a; p = p->next)
+            {
+                if (p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && pointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) && area(p->prev, p, p->next) >= 0.0) return false;
+            }
+            return true;
+        }
+
+        void addTriangle(const Node* a, const Node* b, const Node* c)
+        {
+            _triangles->push_back(a->i);
+            _triangles->push_back(b->i);
+            _triangles->push_back(c->i);
+        }
+
+        Node* cureLocalIntersections(Node* start)
+        {
+            Node* p = start;
+            do
+            {
+                Node* a = p->prev;
+                Node* b = p->next->next;
+                if (!equals(a, b) && intersects(a, p, p->next, b) && locallyInside(a, b) && locallyInside(b, a))
+                {
+                    addTriangle(a, p, b);
+                    removeNode(p);
+                    removeNode(p->next);
+                    p = start = b;
+                }
+                p = p->next;
+            } while (p != start);
+            return filterPoints(p);
+        }
+
+        Node* splitPolygon(Node* a, Node* b)
+        {
+            Node* a2 = &_nodes.emplace_back(*a);
+            Node* b2 = &_nodes.emplace_back(*b);
+            Node* an = a->next;
+            Node* bp = b->prev;
+
+            a->next = b;
+            b->prev = a;
+            a2->next = an;
+            an->prev = a2;
+            b2->next = a2;
+            a2->prev = b2;
+            bp->next = b2;
+            b2->prev = bp;
+            return b2;
+        }
+
+        void splitEarcut(Node* start)
+        {
+            Node* a = start;
+            do
+            {
+                for (Node* b = a->next->next; b != a->prev; b = b->next)
+                {
+                    if (a->i != b->i && isValidDiagonal(a, b))
+                    {
+                        Node* c = splitPolygon(a, b);
+                        a = filterPoints(a, a->next);
+                        c = filterPoints(c, c->next);
+                        earcutLinked(a, 0);
+                        earcutLinked(c, 0);
+                        return;
+                    }
+                }
+                a = a->next;
+            } while (a != start);
+        }
+
+        void earcutLinked(Node* ear, int pass)
+        {
+            if (!ear) return;
+
+            Node* stop = ear;
+            while (ear->prev != ear->next)
+            {
+                Node* prev = ear->prev;
+                Node* next = ear->next;
+                if (isEar(ear))
+                {
+                    addTriangle(prev, ear, next);
+                    removeNode(ear);
+                    ear = next->next;
+                    stop = next->next;
+                    continue;
+                }
+
+                ear = next;
+                if (ear == stop)
+                {
+                    if (pass == 0)
+                        earcutLinked(filterPoints(ear), 1);
+                    else if (pass == 1)
+                        earcutLinked(cureLocalIntersections(filterPoints(ear)), 2);
+                    else
+                        splitEarcut(ear);
+                    break;
+                }
+            }
+        }
+
+        static Node* getLeftmost(Node* start)
+        {
+            Node* p = start;
+            Node* leftmost = start;
+            do
+            {
+                if (p->x < leftmost->x || (p->x == leftmost->x && p->y < leftmost->y)) leftmost = p;
+                p = p->next;
+            } while (p != start);
+            return leftmost;
+        }
+
+        static Node* findHoleBridge(const Node* hole, Node* outer)
+        {
+            Node* p = outer;
+            double hx = hole->x;
+            double hy = hole->y;
+            double qx = -std::numeric_limits<double>::infinity();
+            Node* m = nullptr;
+
+            // find a segment intersected by a ray from the hole's leftmost point to the left, the segment's endpoint with the lesser x is a potential connection point
+            do
+            {
+                if (hy <= p->y && hy >= p->next->y && p->next->y != p->y)
+                {
+                    double x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+                    if (x <= hx && x > qx)
+                    {
+                        qx = x;
+                        m = p->x < p->next->x ? p : p->next;
+                        if (x == hx) return m;
+                    }
+                }
+                p = p->next;
+            } while (p != outer);
+
+            if (!m) return nullptr;
+
+            // look for points inside the triangle of the hole point, the intersection point and m, connecting to the one with the minimum angle to the ray
+            const Node* stop = m;
+            double mx = m->x;
+            double my = m->y;
+            double tanMin = std::numeric_limits<double>::infinity();
+            p = m;
+            do
+            {
+                if (hx >= p->x && p->x >= mx && hx != p->x && pointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y))
+                {
+                    double tan = std::abs(hy - p->y) / (hx - p->x);
+                    if (locallyInside(p, hole) && (tan < tanMin || (tan == tanMin && (p->x > m->x || (p->x == m->x && sectorContainsSector(m, p))))))
+                    {
+                        m = p;
+                        tanMin = tan;
+                    }
+                }
+                p = p->next;
+            } while (p != stop);
+
+            return m;
+        }
+
+        Node* eliminateHoles(const std::vector<vsg::dvec2>& points, const std::vector<std::pair<uint32_t, uint32_t>>& rings, Node* outer)
+        {
+            std::vector<Node*> holes;
+            for (size_t r = 1; r < rings.size(); ++r)
+            {
+                Node* list = linkedList(points, rings[r].first, rings[r].second, false);
+                if (!list) continue;
+                if (list == list->next) list->steiner = true;
+                holes.push_back(getLeftmost(list));
+            }
+            std::sort(holes.begin(), holes.end(), [](const Node* lhs, const Node* rhs) { return lhs->x < rhs->x; });
+
+            for (auto hole : holes)
+            {
+                Node* bridge = findHoleBridge(hole, outer);
+                if (!bridge) continue;
+
+                Node* bridgeReverse = splitPolygon(bridge, hole);
+                filterPoints(bridgeReverse, bridgeReverse->next);
+                outer = filterPoints(bridge, bridge->next);
+            }
+            return outer;
+        }
+    };
+
+    enum PrimitiveType
+    {
+        POINTS,
+        LINES,
+        POLYGONS
+    };
+
+    /// the geometry of the features of a layer that share a primitive type and color, drawn with a single VertexIndexDraw.
+    struct Batch
+    {
+        std::vector<vsg::vec3> vertices; // quad centers for points
+        std::vector<uint32_t> indices;
+    };
+
+    /// accumulates the features of a layer into a Batch per primitive type and color, relative to the layer's first vertex so that float precision is retained.
+    class LayerBuilder
+    {
+    public:
+        std::map<std::pair<PrimitiveType, uint32_t>, Batch> batches;
+        vsg::dvec3 origin;
+        bool hasOrigin = false;
+
+        /// add the geometry, returns false if its memory would exceed the read's read_memory_budget.
+        bool add(const OGRGeometry& geometry, const vsg::vec4& pointColor, const vsg::vec4& lineColor, const vsg::vec4& polygonColor)
+        {
+            switch (wkbFlatten(geometry.getGeometryType()))
+            {
+            case wkbPoint: {
+                auto& point = static_cast<const OGRPoint&>(geometry);
+                if (point.IsEmpty()) return true;
+
+                auto& batch = batchFor(POINTS, pointColor);
+                batch.vertices.push_back(local(point.getX(), point.getY(), point.getZ()));
+                return reserveReadMemory(sizeof(vsg::vec3));
+            }
+            case wkbLineString:
+            case wkbLinearRing: {
+                auto& line = static_cast<const OGRSimpleCurve&>(geometry);
+                int numPoints = line.getNumPoints();
+                if (numPoints < 2) return true;
+
+                auto& batch = batchFor(LINES, lineColor);
+                auto base = static_cast<uint32_t>(batch.vertices.size());
+                for (int i = 0; i < numPoints; ++i) batch.vertices.push_back(local(line.getX(i), line.getY(i), line.getZ(i)));
+                for (int i = 1; i < numPoints; ++i)
+                {
+                    batch.indices.push_back(base + static_cast<uint32_t>(i - 1));
+                    batch.indices.push_back(base + static_cast<uint32_t>(i));
+                }
+                return reserveReadMemory(numPoints * sizeof(vsg::vec3) + (numPoints - 1) * 2 * sizeof(uint32_t));
+            }
+            case wkbPolygon:
+            case wkbTriangle: {
+                auto& polygon = static_cast<const OGRPolygon&>(geometry);
+                if (polygon.IsEmpty()) return true;
+
+                // flatten the rings into one list of points, dropping the closing point of each ring
+                points.clear();
+                rings.clear();
+                elevations.clear();
+                for (int r = 0; r < polygon.getNumInteriorRings() + 1; ++r)
+                {
+                    auto ring = (r == 0) ? polygon.getExteriorRing() : polygon.getInteriorRing(r - 1);
+                    if (!ring) continue;
+
+                    int numPoints = ring->getNumPoints();
+                    if (numPoints > 1 && ring->getX(0) == ring->getX(numPoints - 1) && ring->getY(0) == ring->getY(numPoints - 1)) --numPoints;
+                    if (numPoints < 3)
+                    {
+                        if (r == 0) return true;
+                        continue;
+                    }
+
+                    auto start = static_cast<uint32_t>(points.size());
+                    for (int i = 0; i < numPoints; ++i)
+                    {
+                        auto v = local(ring->getX(i), ring->getY(i), ring->getZ(i));
+                        points.emplace_back(v.x, v.y);
+                        elevations.push_back(v.z);
+                    }
+                    rings.emplace_back(start, static_cast<uint32_t>(points.size()));
+                }
+                if (rings.empty()) return true;
+
+                triangles.clear();
+                triangulator.triangulate(points, rings, triangles);
+                if (triangles.empty()) return true;
+
+                auto& batch = batchFor(POLYGONS, polygonColor);
+                auto base = static_cast<uint32_t>(batch.vertices.size());
+                for (size_t i = 0; i < points.size(); ++i) batch.vertices.emplace_back(static_cast<float>(points[i].x), static_cast<float>(points[i].y), elevations[i]);
+
+                // wind the triangles counter clockwise when viewed from above
+                for (size_t i = 0; i < triangles.size(); i += 3)
+                {
+                    auto& a = points[triangles[i]];
+                    auto& b = points[triangles[i + 1]];
+                    auto& c = points[triangles[i + 2]];
+                    bool clockwise = ((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) < 0.0;
+
+                    batch.indices.push_back(base + triangles[i]);
+                    batch.indices.push_back(base + triangles[clockwise ? i + 2 : i + 1]);
+                    batch.indices.push_back(base + triangles[clockwise ? i + 1 : i + 2]);
+                }
+                return reserveReadMemory(points.size() * sizeof(vsg::vec3) + triangles.size() * sizeof(uint32_t));
+            }
+            case wkbMultiPoint:
+            case wkbMultiLineString:
+            case wkbMultiPolygon:
+            case wkbGeometryCollection: {
+                auto& collection = static_cast<const OGRGeometryCollection&>(geometry);
+                for (int i = 0; i < collection.getNumGeometries(); ++i)
+                {
+                    auto child = collection.getGeometryRef(i);
+                    if (child && !add(*child, pointColor, lineColor, polygonColor)) return false;
+                }
+                return true;
+            }
+            case wkbPolyhedralSurface:
+            case wkbTIN: {
+                std::unique_ptr<OGRGeometry> multiPolygon(OGRGeometryFactory::forceToMultiPolygon(geometry.clone()));
+                return !multiPolygon || add(*multiPolygon, pointColor, lineColor, polygonColor);
+            }
+            default: {
+                // curves are approximated by line segments
+                if (!geometry.hasCurveGeometry()) return true;
+                std::unique_ptr<OGRGeometry> linear(geometry.getLinearGeometry());
+                return !linear || add(*linear, pointColor, lineColor, polygonColor);
+            }
+            }
+        }
+
+    protected:
+        Triangulator triangulator;
+        std::vector<vsg::dvec2> points;
+        std::vector<std::pair<uint32_t, uint32_t>> rings;
+        std::vector<float> elevations;
+        std::vector<uint32_t> triangles;
+
+        vsg::vec3 local(double x, double y, double z)
+        {
+            if (!hasOrigin)
+            {
+                origin.set(x, y, z);
+                hasOrigin = true;
+            }
+            return vsg::vec3(static_cast<float>(x - origin.x), static_cast<float>(y - origin.y), static_cast<float>(z - origin.z));
+        }
+
+        Batch& batchFor(PrimitiveType type, const vsg::vec4& color)
+        {
+            auto packed = [](float c) { return static_cast<uint32_t>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f); };
+            uint32_t rgba = (packed(color.r) << 24) | (packed(color.g) << 16) | (packed(color.b) << 8) | packed(color.a);
+            return batches[std::make_pair(type, rgba)];
+        }
+    };
+
+    /// colors of the pen, brush and symbol of an OGR feature style string, parsed once for each distinct style string of a dataset.
+    struct FeatureColors
+    {
+        vsg::vec4 point;
+        vsg::vec4 line;
+        vsg::vec4 polygon;
+    };
+
+    class StyleColors
+    {
+    public:
+        StyleColors(GDALDataset& dataset, const vsg::vec4& in_defaultColor) :
+            styleManager(dataset.GetStyleTable()),
+            defaultColors{in_defaultColor, in_defaultColor, in_defaultColor}
+        {
+        }
+
+        const FeatureColors& colors(OGRFeature& feature)
+        {
+            auto styleString = feature.GetStyleString();
+            if (!styleString || !*styleString) return defaultColors;
+
+            auto [itr, inserted] = styleColors.emplace(styleString, defaultColors);
+            if (!inserted) return itr->second;
+
+            auto& colors = itr->second;
+            if (!styleManager.InitFromFeature(&feature)) return colors;
+
+            bool hasPen = false, hasBrush = false;
+            for (int i = 0; i < styleManager.GetPartCount(); ++i)
+            {
+                std::unique_ptr<OGRStyleTool> tool(styleManager.GetPart(i));
+                if (!tool) continue;
+
+                GBool isNull = TRUE;
+                const char* color = nullptr;
+                vsg::vec4* target = nullptr;
+                switch (tool->GetType())
+                {
+                case OGRSTCPen:
+                    color = static_cast<OGRStylePen*>(tool.get())->Color(isNull);
+                    target = &colors.line;
+                    break;
+                case OGRSTCBrush:
+                    color = static_cast<OGRStyleBrush*>(tool.get())->ForeColor(isNull);
+                    target = &colors.polygon;
+                    break;
+                case OGRSTCSymbol:
+                    color = static_cast<OGRStyleSymbol*>(tool.get())->Color(isNull);
+                    target = &colors.point;
+                    break;
+                default: break;
+                }
+
+                int r = 0, g = 0, b = 0, a = 255;
+                if (target && !isNull && color && tool->GetRGBFromString(color, r, g, b, a))
+                {
+                    target->set(r / 255.0f, g / 255.0f, b / 255.0f, a / 255.0f);
+                    hasPen = hasPen || target == &colors.line;
+                    hasBrush = hasBrush || target == &colors.polygon;
+                }
+            }
+
+            // polygons with an outline pen but no brush are drawn in the pen color
+            if (hasPen && !hasBrush) colors.polygon = colors.line;
+            return colors;
+        }
+
+    protected:
+        OGRStyleMgr styleManager;
+        FeatureColors defaultColors;
+        std::map<std::string, FeatureColors> styleColors;
+    };
+
+    using CoordinateTransformation = std::unique_ptr<OGRCoordinateTransformation, void (*)(OGRCoordinateTransformation*)>;
+
+    CoordinateTransformation createTransformation(const OGRSpatialReference* source, const OGRSpatialReference& target)
+    {
+        CoordinateTransformation transformation(nullptr, [](OGRCoordinateTransformation* ct) { OGRCoordinateTransformation::DestroyCT(ct); });
+        if (!source) return transformation;
+
+        OGRSpatialReference sourceSRS(*source);
+#if GDAL_VERSION_NUM >= 3000000
+        // keep x as longitude/easting regardless of the axis order of the spatial reference's authority
+        sourceSRS.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+#endif
+        transformation.reset(OGRCreateCoordinateTransformation(&sourceSRS, &target));
+        return transformation;
+    }
+
+    /// create the subgraph that draws a batch, sharing the pipelines and material between the batches.
+    vsg::ref_ptr<vsg::Node> createBatchSubgraph(PrimitiveType type, uint32_t rgba, const Batch& batch, double pointSize, vsg::ShaderSet& shaderSet, vsg::ref_ptr<vsg::DescriptorConfigurator> material, vsg::SharedObjects& sharedObjects)
+    {
+        vsg::vec4 color(((rgba >> 24) & 0xff) / 255.0f, ((rgba >> 16) & 0xff) / 255.0f, ((rgba >> 8) & 0xff) / 255.0f, (rgba & 0xff) / 255.0f);
+        vsg::convert(color, vsg::CoordinateSpace::sRGB, shaderSet.getAttributeBinding("vsg_Color").coordinateSpace);
+
+        // points are drawn as quads in the xy plane, a single quad instanced at each point when the ShaderSet supports instance translations
+        bool instanced = type == POINTS && shaderSet.getAttributeBinding("vsg_Translation");
+        uint32_t instanceCount = instanced ? static_cast<uint32_t>(batch.vertices.size()) : 1;
+
+        vsg::ref_ptr<vsg::vec3Array> vertices;
+        vsg::ref_ptr<vsg::Data> indices;
+        size_t numIndices = 0;
+
+        auto createIndices = [&](size_t count, size_t numVertices) {
+            numIndices = count;
+            if (numVertices > 65536)
+                indices = vsg::uintArray::create(static_cast<uint32_t>(count));
+            else
+                indices = vsg::ushortArray::create(static_cast<uint32_t>(count));
+        };
+        auto setIndex = [&](size_t i, uint32_t value) {
+            if (auto ui = indices.cast<vsg::uintArray>())
+                (*ui)[i] = value;
+            else
+                (*indices.cast<vsg::ushortArray>())[i] = static_cast<uint16_t>(value);
+        };
+
+        if (type == POINTS)
+        {
+            float h = static_cast<float>(pointSize * 0.5);
+            const vsg::vec3 corners[4] = {{-h, -h, 0.0f}, {h, -h, 0.0f}, {h, h, 0.0f}, {-h, h, 0.0f}};
+            const uint32_t quad[6] = {0, 1, 2, 0, 2, 3};
+
+            size_t numQuads = instanced ? 1 : batch.vertices.size();
+            vertices = vsg::vec3Array::create(static_cast<uint32_t>(numQuads * 4));
+            createIndices(numQuads * 6, numQuads * 4);
+            for (size_t q = 0; q < numQuads; ++q)
+            {
+                vsg::vec3 center = instanced ? vsg::vec3() : batch.vertices[q];
+                for (size_t c = 0; c < 4; ++c) (*vertices)[q * 4 + c] = center + corners[c];
+                for (size_t i = 0; i < 6; ++i) setIndex(q * 6 + i, static_cast<uint32_t>(q * 4 + quad[i]));
+            }
+        }
+        else
+        {
+            vertices = vsg::vec3Array::create(static_cast<uint32_t>(batch.vertices.size()));
+            std::copy(batch.vertices.begin(), batch.vertices.end(), vertices->begin());
+            createIndices(batch.indices.size(), batch.vertices.size());
+            for (size_t i = 0; i < batch.indices.size(); ++i) setIndex(i, batch.indices[i]);
+        }
+
+        auto config = vsg::GraphicsPipelineConfigurator::create(vsg::ref_ptr<vsg::ShaderSet>(&shaderSet));
+        config->descriptorConfigurator = material;
+
+        vsg::DataList vertexArrays;
+        config->assignArray(vertexArrays, "vsg_Vertex", VK_VERTEX_INPUT_RATE_VERTEX, vertices);
+        if (instanceCount > 1)
+        {
+            config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec3Array::create(instanceCount, vsg::vec3(0.0f, 0.0f, 1.0f)));
+            config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec2Array::create(instanceCount, vsg::vec2(0.0f, 0.0f)));
+            config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec4Array::create(instanceCount, color));
+        }
+        else
+        {
+            config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec3Value::create(0.0f, 0.0f, 1.0f));
+            config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec2Value::create(0.0f, 0.0f));
+            config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec4Value::create(color));
+        }
+        if (instanced)
+        {
+            auto translations = vsg::vec3Array::create(instanceCount);
+            std::copy(batch.vertices.begin(), batch.vertices.end(), translations->begin());
+            config->assignArray(vertexArrays, "vsg_Translation", VK_VERTEX_INPUT_RATE_INSTANCE, translations);
+        }
+
+        // set the GraphicsPipelineStates to the required values.
+        struct SetPipelineStates : public vsg::Visitor
+        {
+            VkPrimitiveTopology topology;
+            bool blending;
+
+            SetPipelineStates(VkPrimitiveTopology in_topology, bool in_blending) :
+                topology(in_topology), blending(in_blending) {}
+
+            void apply(vsg::Object& object) override { object.traverse(*this); }
+            void apply(vsg::RasterizationState& rs) override { rs.cullMode = VK_CULL_MODE_NONE; }
+            void apply(vsg::InputAssemblyState& ias) override { ias.topology = topology; }
+            void apply(vsg::ColorBlendState& cbs) override { cbs.configureAttachments(blending); }
+        } sps(type == LINES ? VK_PRIMITIVE_TOPOLOGY_LINE_LIST : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, color.a < 1.0f);
+        config->accept(sps);
+
+        sharedObjects.share(config, [](auto gpc) { gpc->init(); });
+
+        auto vid = vsg::VertexIndexDraw::create();
+        vid->assignArrays(vertexArrays);
+        vid->assignIndices(indices);
+        vid->indexCount = static_cast<uint32_t>(numIndices);
+        vid->instanceCount = instanceCount;
+
+        auto stateGroup = vsg::StateGroup::create();
+        config->copyTo(stateGroup, vsg::ref_ptr<vsg::SharedObjects>(&sharedObjects));
+        stateGroup->addChild(vid);
+        return stateGroup;
+    }
+
+    std::set<std::string> layerNames(const vsg::Options* options)
+    {
+        std::set<std::string> names;
+        std::string layerList;
+        if (!options || !options->getValue(GDAL::vector_layers, layerList)) return names;
+
+        std::stringstream str(layerList);
+        std::string name;
+        while (std::getline(str, name, ','))
+        {
+            name.erase(0, name.find_first_not_of(' '));
+            name.erase(name.find_last_not_of(' ') + 1);
+            if (!name.empty()) names.insert(name);
+        }
+        return names;
+    }
+
+} // namespace
+
+vsg::ref_ptr<vsg::Node> vsgXchange::createVectorScene(GDALDataset& dataset, vsg::ref_ptr<const vsg::Options> options)
+{
+    auto selectedLayers = layerNames(options.get());
+
+    vsg::vec4 defaultColor(1.0f, 1.0f, 1.0f, 1.0f);
+    double pointSize = 0.0;
+    vsg::dvec4 spatialFilter;
+    bool hasSpatialFilter = false;
+    std::string targetSRSString;
+    if (options)
+    {
+        options->getValue(GDAL::vector_color, defaultColor);
+        options->getValue(GDAL::point_size, pointSize);
+        hasSpatialFilter = options->getValue(GDAL::geographic_window, spatialFilter);
+        options->getValue(GDAL::target_srs, targetSRSString);
+    }
+
+    OGRSpatialReference targetSRS;
+    if (!targetSRSString.empty())
+    {
+        if (targetSRS.SetFromUserInput(targetSRSString.c_str()) != OGRERR_NONE)
+        {
+            vsg::warn("GDAL::read() unable to interpret target_srs ", targetSRSString);
+            return {};
+        }
+#if GDAL_VERSION_NUM >= 3000000
+        targetSRS.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+#endif
+    }
+
+    auto sharedObjects = options ? options->sharedObjects : vsg::ref_ptr<vsg::SharedObjects>();
+    if (!sharedObjects) sharedObjects = vsg::SharedObjects::create();
+
+    auto shaderSet = vsg::createFlatShadedShaderSet(options);
+    sharedObjects->share(shaderSet);
+
+    // all the batches share one material, their colors are assigned as vsg_Color so they also share the pipelines of each primitive type
+    auto material = vsg::DescriptorConfigurator::create(shaderSet);
+    material->assignDescriptor("material", vsg::PhongMaterialValue::create());
+    for (auto& ds : material->descriptorSets)
+    {
+        if (ds)
+        {
+            sharedObjects->share(ds->descriptors);
+            sharedObjects->share(ds);
+        }
+    }
+
+    auto cancellation = getCancellationToken(options.get());
+    StyleColors styleColors(dataset, defaultColor);
+
+    auto group = vsg::Group::create();
+    for (int layerIndex = 0; layerIndex < dataset.GetLayerCount(); ++layerIndex)
+    {
+        auto layer = dataset.GetLayer(layerIndex);
+        if (!layer) continue;
+
+        std::string layerName = layer->GetName();
+        if (!selectedLayers.empty() && selectedLayers.count(layerName) == 0) continue;
+
+        CoordinateTransformation transformation(nullptr, [](OGRCoordinateTransformation* ct) { OGRCoordinateTransformation::DestroyCT(ct); });
+        if (!targetSRSString.empty())
+        {
+            transformation = createTransformation(layer->GetSpatialRef(), targetSRS);
+            if (!transformation)
+            {
+                vsg::warn("GDAL::read() unable to reproject layer ", layerName, " to target_srs ", targetSRSString);
+                continue;
+            }
+        }
+
+        // only the features that intersect the area of interest are read, using the layer's spatial index where the driver has one
+        if (hasSpatialFilter)
+            layer->SetSpatialFilterRect(spatialFilter[0], spatialFilter[1], spatialFilter[2], spatialFilter[3]);
+        else
+            layer->SetSpatialFilter(nullptr);
+
+        // features are streamed one at a time and appended to the batches, so the layer's features are never all resident
+        LayerBuilder builder;
+        layer->ResetReading();
+        size_t numFeatures = 0;
+        for (OGRFeatureUniquePtr feature(layer->GetNextFeature()); feature; feature.reset(layer->GetNextFeature()))
+        {
+            if ((++numFeatures % 1024) == 0 && cancellation && cancellation->cancelled()) return {};
+
+            auto geometry = feature->GetGeometryRef();
+            if (!geometry) continue;
+            if (transformation && geometry->transform(transformation.get()) != OGRERR_NONE) continue;
+
+            auto& colors = styleColors.colors(*feature);
+            if (!builder.add(*geometry, colors.point, colors.line, colors.polygon)) return {};
+        }
+        if (cancellation && cancellation->cancelled()) return {};
+
+        if (builder.batches.empty()) continue;
+
+        auto transform = vsg::MatrixTransform::create(vsg::translate(builder.origin));
+        transform->setValue("name", layerName);
+
+        auto srs = transformation ? &targetSRS : layer->GetSpatialRef();
+        if (srs)
+        {
+            char* wkt = nullptr;
+            if (srs->exportToWkt(&wkt) == OGRERR_NONE && wkt) transform->setValue("ProjectionRef", std::string(wkt));
+            CPLFree(wkt);
+        }
+
+        for (auto& [key, batch] : builder.batches)
+        {
+            double size = pointSize;
+            if (key.first == POINTS && size <= 0.0)
+            {
+                // default to a 500th of the extent of the layer's points
+                vsg::box bounds;
+                for (auto& v : batch.vertices) bounds.add(v);
+                size = std::max(bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y) / 500.0;
+                if (size <= 0.0) size = 1.0;
+            }
+
+            transform->addChild(createBatchSubgraph(key.first, key.second, batch, size, *shaderSet, material, *sharedObjects));
+        }
+
+        vsg::debug("GDAL::read() layer ", layerName, " ", numFeatures, " features in ", builder.batches.size(), " batches");
+        group->addChild(transform);
+    }
+
+    if (group->children.empty()) return {};
+    return group;
+}
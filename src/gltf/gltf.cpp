@@ -0,0 +1,1198 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgXchange/cancellation.h>
+#include <vsgXchange/models.h>
+#include <vsgXchange/read_memory.h>
+#include <vsgXchange/read_write_observer.h>
+
+#include "../all/color_space.h"
+#include "../all/content_type.h"
+#include "../all/parallel_for.h"
+#include "../all/pipeline_configurations.h"
+#include "json.h"
+
+#include <vsg/all.h>
+#include <vsg/io/mem_stream.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <thread>
+
+using namespace vsgXchange;
+
+namespace
+{
+    constexpr uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+    constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+    constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;  // "BIN\0"
+
+    // accessor componentTypes
+    constexpr uint64_t GLTF_BYTE = 5120;
+    constexpr uint64_t GLTF_UNSIGNED_BYTE = 5121;
+    constexpr uint64_t GLTF_SHORT = 5122;
+    constexpr uint64_t GLTF_UNSIGNED_SHORT = 5123;
+    constexpr uint64_t GLTF_UNSIGNED_INT = 5125;
+    constexpr uint64_t GLTF_FLOAT = 5126;
+
+    constexpr uint64_t NO_INDEX = ~uint64_t(0);
+
+    bool supportedExtension(const vsg::Path& ext)
+    {
+        return ext == ".gltf" || ext == ".glb";
+    }
+
+    /// allocate a buffer of size bytes against the read's read_memory_budget, vsg::Array sizes are 32 bit so larger buffers can't be held.
+    vsg::ref_ptr<vsg::ubyteArray> allocateBuffer(uint64_t size)
+    {
+        if (size == 0 || size > std::numeric_limits<uint32_t>::max()) return {};
+        auto ptr = static_cast<uint8_t*>(allocateReadData(static_cast<size_t>(size)));
+        if (!ptr) return {};
+        return vsg::ubyteArray::create(static_cast<uint32_t>(size), ptr);
+    }
+
+    int base64Value(char c)
+    {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+' || c == '-') return 62;
+        if (c == '/' || c == '_') return 63;
+        return -1;
+    }
+
+    /// decode the base64 payload of a data: URI, returning the number of bytes written to out, which must hold size * 3 / 4 bytes.
+    size_t decodeBase64(const char* ptr, size_t size, uint8_t* out)
+    {
+        uint8_t* start = out;
+        uint32_t bits = 0;
+        int numBits = 0;
+        for (size_t i = 0; i < size; ++i)
+        {
+            int value = base64Value(ptr[i]);
+            if (value < 0) continue; // padding and whitespace
+            bits = (bits << 6) | static_cast<uint32_t>(value);
+            numBits += 6;
+            if (numBits >= 8)
+            {
+                numBits -= 8;
+                *out++ = static_cast<uint8_t>(bits >> numBits);
+            }
+        }
+        return static_cast<size_t>(out - start);
+    }
+
+    /// split a "data:[<mediatype>][;base64],<data>" URI into its media type and payload, returns false for other URIs and data: URIs that aren't base64 encoded.
+    bool splitDataURI(const std::string& uri, std::string& mediaType, const char*& payload, size_t& payloadSize)
+    {
+        if (uri.compare(0, 5, "data:") != 0) return false;
+        auto comma = uri.find(',');
+        if (comma == std::string::npos) return false;
+
+        auto header = uri.substr(5, comma - 5);
+        static const std::string base64 = ";base64";
+        if (header.size() < base64.size() || header.compare(header.size() - base64.size(), base64.size(), base64) != 0) return false;
+
+        mediaType = header.substr(0, header.find(';'));
+        payload = uri.data() + comma + 1;
+        payloadSize = uri.size() - comma - 1;
+        return true;
+    }
+
+    /// decode the %XX escapes of a relative URI to the filename it refers to.
+    vsg::Path decodeURI(const std::string& uri)
+    {
+        std::string filename;
+        filename.reserve(uri.size());
+        for (size_t i = 0; i < uri.size(); ++i)
+        {
+            if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) && std::isxdigit(static_cast<unsigned char>(uri[i + 2])))
+            {
+                filename.push_back(static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+                i += 2;
+            }
+            else
+            {
+                filename.push_back(uri[i]);
+            }
+        }
+        return filename;
+    }
+
+    uint32_t componentSize(uint64_t componentType)
+    {
+        switch (componentType)
+        {
+        case GLTF_BYTE:
+        case GLTF_UNSIGNED_BYTE: return 1;
+        case GLTF_SHORT:
+        case GLTF_UNSIGNED_SHORT: return 2;
+        case GLTF_UNSIGNED_INT:
+        case GLTF_FLOAT: return 4;
+        default: return 0;
+        }
+    }
+
+    uint32_t numComponents(const std::string& type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        return 0; // matrices aren't used by the attributes converted
+    }
+
+    /// elements of an accessor within its buffer, accessors without a bufferView have a null buffer and all their elements are zero.
+    struct Accessor
+    {
+        vsg::ref_ptr<vsg::ubyteArray> buffer;
+        uint64_t offset = 0;
+        uint32_t stride = 0;
+        uint32_t count = 0;
+        uint64_t componentType = 0;
+        uint32_t numComponents = 0;
+        bool normalized = false;
+
+        const uint8_t* element(uint32_t i) const { return static_cast<const uint8_t*>(buffer->dataPointer()) + offset + static_cast<uint64_t>(stride) * i; }
+
+        /// return component c of element i, normalized integers are mapped to [0, 1] or [-1, 1].
+        float component(uint32_t i, uint32_t c) const
+        {
+            if (!buffer) return 0.0f;
+
+            const uint8_t* ptr = element(i) + c * componentSize(componentType);
+            switch (componentType)
+            {
+            case GLTF_BYTE: {
+                auto value = *reinterpret_cast<const int8_t*>(ptr);
+                return normalized ? std::max(static_cast<float>(value) / 127.0f, -1.0f) : static_cast<float>(value);
+            }
+            case GLTF_UNSIGNED_BYTE:
+                return normalized ? static_cast<float>(*ptr) / 255.0f : static_cast<float>(*ptr);
+            case GLTF_SHORT: {
+                int16_t value;
+                std::memcpy(&value, ptr, sizeof(value));
+                return normalized ? std::max(static_cast<float>(value) / 32767.0f, -1.0f) : static_cast<float>(value);
+            }
+            case GLTF_UNSIGNED_SHORT: {
+                uint16_t value;
+                std::memcpy(&value, ptr, sizeof(value));
+                return normalized ? static_cast<float>(value) / 65535.0f : static_cast<float>(value);
+            }
+            case GLTF_UNSIGNED_INT: {
+                uint32_t value;
+                std::memcpy(&value, ptr, sizeof(value));
+                return static_cast<float>(value);
+            }
+            case GLTF_FLOAT: {
+                float value;
+                std::memcpy(&value, ptr, sizeof(value));
+                return value;
+            }
+            default:
+                return 0.0f;
+            }
+        }
+
+        uint32_t index(uint32_t i) const
+        {
+            if (!buffer) return 0;
+
+            const uint8_t* ptr = element(i);
+            switch (componentType)
+            {
+            case GLTF_UNSIGNED_BYTE: return *ptr;
+            case GLTF_UNSIGNED_SHORT: {
+                uint16_t value;
+                std::memcpy(&value, ptr, sizeof(value));
+                return value;
+            }
+            case GLTF_UNSIGNED_INT: {
+                uint32_t value;
+                std::memcpy(&value, ptr, sizeof(value));
+                return value;
+            }
+            default:
+                return 0;
+            }
+        }
+
+        /// return true if the elements are tightly packed components of componentType that can be viewed in place as a vsg::Array of elementSize values.
+        /// vsg::Array offsets are 32 bit, and interleaved attributes are converted as each vsg::Array view would upload the whole interleaved range.
+        bool viewable(uint64_t requiredComponentType, uint32_t elementSize) const
+        {
+            return buffer && componentType == requiredComponentType && numComponents * componentSize(componentType) == elementSize && stride == elementSize &&
+                   (offset % componentSize(componentType)) == 0 && offset <= std::numeric_limits<uint32_t>::max() &&
+                   offset + static_cast<uint64_t>(stride) * count <= buffer->dataSize();
+        }
+    };
+
+    /// return a view of the accessor's elements when they are already stored as the float vectors of the array's value_type, otherwise convert them,
+    /// filling any components the accessor doesn't have from defaultValue. Arrays that are to be modified in place are always converted.
+    template<class A>
+    vsg::ref_ptr<A> floatArray(const Accessor& accessor, VkFormat format, const typename A::value_type& defaultValue, bool modifiable = false)
+    {
+        using value_type = typename A::value_type;
+        constexpr uint32_t N = static_cast<uint32_t>(sizeof(value_type) / sizeof(float));
+
+        if (!modifiable && accessor.viewable(GLTF_FLOAT, sizeof(value_type)))
+        {
+            return A::create(accessor.buffer, static_cast<uint32_t>(accessor.offset), accessor.stride, accessor.count, vsg::Data::Properties{format});
+        }
+
+        if (!reserveReadMemory(static_cast<uint64_t>(accessor.count) * sizeof(value_type))) return {};
+
+        auto array = A::create(accessor.count, vsg::Data::Properties{format});
+        uint32_t numComponents = std::min(accessor.numComponents, N);
+        for (uint32_t i = 0; i < accessor.count; ++i)
+        {
+            value_type value = defaultValue;
+            for (uint32_t c = 0; c < numComponents; ++c) value[c] = accessor.component(i, c);
+            array->set(i, value);
+        }
+        return array;
+    }
+
+    /// return a view of 16 and 32 bit indices, converting 8 bit indices to 16 bit as uint8_t indices need the VK_EXT_index_type_uint8 extension.
+    vsg::ref_ptr<vsg::Data> indexArray(const Accessor& accessor)
+    {
+        if (accessor.numComponents != 1) return {};
+
+        if (accessor.viewable(GLTF_UNSIGNED_SHORT, 2)) return vsg::ushortArray::create(accessor.buffer, static_cast<uint32_t>(accessor.offset), 2, accessor.count);
+        if (accessor.viewable(GLTF_UNSIGNED_INT, 4)) return vsg::uintArray::create(accessor.buffer, static_cast<uint32_t>(accessor.offset), 4, accessor.count);
+
+        if (accessor.componentType == GLTF_UNSIGNED_INT)
+        {
+            if (!reserveReadMemory(static_cast<uint64_t>(accessor.count) * 4)) return {};
+            auto indices = vsg::uintArray::create(accessor.count);
+            for (uint32_t i = 0; i < accessor.count; ++i) indices->set(i, accessor.index(i));
+            return indices;
+        }
+        else if (accessor.componentType == GLTF_UNSIGNED_SHORT || accessor.componentType == GLTF_UNSIGNED_BYTE)
+        {
+            if (!reserveReadMemory(static_cast<uint64_t>(accessor.count) * 2)) return {};
+            auto indices = vsg::ushortArray::create(accessor.count);
+            for (uint32_t i = 0; i < accessor.count; ++i) indices->set(i, static_cast<uint16_t>(accessor.index(i)));
+            return indices;
+        }
+        return {};
+    }
+
+    uint32_t maxIndex(const vsg::Data& indices)
+    {
+        uint32_t result = 0;
+        if (auto ushortIndices = indices.cast<vsg::ushortArray>())
+        {
+            for (auto index : *ushortIndices) result = std::max(result, static_cast<uint32_t>(index));
+        }
+        else if (auto uintIndices = indices.cast<vsg::uintArray>())
+        {
+            for (auto index : *uintIndices) result = std::max(result, index);
+        }
+        return result;
+    }
+
+    VkSamplerAddressMode getWrapMode(uint64_t wrap)
+    {
+        switch (wrap)
+        {
+        case 33071: return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        case 33648: return VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+        default: return VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        }
+    }
+
+    struct SamplerImage
+    {
+        vsg::ref_ptr<vsg::Data> data;
+        vsg::ref_ptr<vsg::Sampler> sampler;
+    };
+
+    /// converts a parsed glTF document to a VSG scene graph, resolving buffers, images and textures, materials, meshes and nodes in turn.
+    class GLTFConverter
+    {
+    public:
+        GLTFConverter(const json::Value& in_document, vsg::ref_ptr<const vsg::Options> in_options) :
+            document(in_document)
+        {
+            // the document's extension hint must not be passed on to the reads of its images and buffers
+            options = in_options ? vsg::clone(in_options) : vsg::Options::create();
+            options->extensionHint = vsg::Path();
+
+            sharedObjects = options->sharedObjects;
+            if (!sharedObjects) sharedObjects = vsg::SharedObjects::create();
+
+            numThreads = vsg::value<uint32_t>(std::thread::hardware_concurrency(), gltf::num_threads, in_options.get());
+            cancellation = getCancellationToken(in_options.get());
+        }
+
+        /// return the feature of the document that the converter doesn't support, or an empty string if it can be converted.
+        std::string unsupported() const;
+
+        /// convert the document, binChunk is the binary chunk of a GLB file, or null for .gltf files.
+        vsg::ref_ptr<vsg::Node> convert(vsg::ref_ptr<vsg::ubyteArray> binChunk, const vsg::Path& ext);
+
+    protected:
+        const json::Value& document;
+        vsg::ref_ptr<vsg::Options> options;
+        vsg::ref_ptr<vsg::SharedObjects> sharedObjects;
+        vsg::ref_ptr<vsg::ShaderSet> pbrShaderSet;
+        uint32_t numThreads = 1;
+        const CancellationToken* cancellation = nullptr;
+
+        // glTF colors are linear
+        vsg::CoordinateSpace targetMaterialCoordinateSpace = vsg::CoordinateSpace::LINEAR;
+        vsg::CoordinateSpace targetVertexColorSpace = vsg::CoordinateSpace::LINEAR;
+
+        std::vector<vsg::ref_ptr<vsg::ubyteArray>> buffers;
+        std::vector<vsg::ref_ptr<vsg::Data>> images;
+        std::vector<SamplerImage> textures;
+        std::vector<vsg::ref_ptr<vsg::DescriptorConfigurator>> materials;
+        vsg::ref_ptr<vsg::DescriptorConfigurator> defaultMaterial;
+        std::vector<vsg::ref_ptr<vsg::Node>> meshes;
+        mutable PipelineConfigurations pipelineConfigurations;
+
+        bool cancelled() const { return cancellation && cancellation->cancelled(); }
+
+        bool readBuffers(vsg::ref_ptr<vsg::ubyteArray> binChunk);
+        bool accessor(uint64_t index, Accessor& result) const;
+        vsg::ref_ptr<vsg::Data> readImage(const json::Value& image) const;
+        void readTextures();
+        vsg::ref_ptr<vsg::DescriptorConfigurator> convertMaterial(const json::Value& material) const;
+        vsg::ref_ptr<vsg::Node> convertPrimitive(const json::Value& primitive) const;
+        vsg::ref_ptr<vsg::Node> convertMesh(const json::Value& mesh) const;
+        vsg::ref_ptr<vsg::Node> convertNode(uint64_t index, uint32_t depth) const;
+        vsg::ref_ptr<vsg::MatrixTransform> processCoordinateFrame(const vsg::Path& ext) const;
+    };
+
+    std::string GLTFConverter::unsupported() const
+    {
+        const auto& asset = document["asset"];
+        if (asset["version"].asString().compare(0, 2, "2.") != 0) return "glTF version " + asset["version"].asString();
+        if (asset.has("minVersion") && asset["minVersion"].asString() != "2.0") return "glTF minVersion " + asset["minVersion"].asString();
+
+        static const std::set<std::string> supportedRequiredExtensions{"KHR_mesh_quantization", "KHR_texture_basisu"};
+        for (auto& extension : document["extensionsRequired"].array)
+        {
+            if (supportedRequiredExtensions.count(extension.asString()) == 0) return extension.asString();
+        }
+
+        // extensions that change what is drawn, so can't be ignored even when the file has uncompressed fallbacks
+        static const std::set<std::string> unsupportedExtensions{"KHR_lights_punctual", "KHR_draco_mesh_compression", "EXT_meshopt_compression", "EXT_mesh_gpu_instancing", "KHR_materials_pbrSpecularGlossiness", "KHR_texture_transform"};
+        for (auto& extension : document["extensionsUsed"].array)
+        {
+            if (unsupportedExtensions.count(extension.asString()) != 0) return extension.asString();
+        }
+
+        if (document["skins"].size() > 0) return "skins";
+        if (document["animations"].size() > 0) return "animations";
+        if (document["cameras"].size() > 0) return "cameras";
+
+        for (auto& accessor : document["accessors"].array)
+        {
+            if (accessor.has("sparse")) return "sparse accessors";
+        }
+
+        for (auto& mesh : document["meshes"].array)
+        {
+            for (auto& primitive : mesh["primitives"].array)
+            {
+                if (primitive.has("targets")) return "morph targets";
+            }
+        }
+
+        return {};
+    }
+
+    bool GLTFConverter::readBuffers(vsg::ref_ptr<vsg::ubyteArray> binChunk)
+    {
+        const auto& gltfBuffers = document["buffers"].array;
+        buffers.resize(gltfBuffers.size());
+        for (size_t i = 0; i < gltfBuffers.size(); ++i)
+        {
+            const auto& buffer = gltfBuffers[i];
+            auto byteLength = buffer["byteLength"].asIndex(0);
+            const auto& uri = buffer["uri"].asString();
+
+            std::string mediaType;
+            const char* payload = nullptr;
+            size_t payloadSize = 0;
+
+            if (!buffer.has("uri"))
+            {
+                // the first buffer of a GLB file is its binary chunk, which may be padded to 4 bytes
+                if (i != 0 || !binChunk || binChunk->dataSize() < byteLength) return false;
+                buffers[i] = binChunk;
+            }
+            else if (splitDataURI(uri, mediaType, payload, payloadSize))
+            {
+                auto data = allocateBuffer(std::max<uint64_t>(byteLength, (static_cast<uint64_t>(payloadSize) * 3 + 3) / 4));
+                if (!data || decodeBase64(payload, payloadSize, static_cast<uint8_t*>(data->dataPointer())) < byteLength) return false;
+                buffers[i] = data;
+            }
+            else
+            {
+                // read external buffers straight into the vsg::ubyteArray that the vertex and index arrays view
+                auto filename = vsg::findFile(decodeURI(uri), options);
+                if (!filename) return false;
+
+                std::ifstream fin(filename, std::ios::in | std::ios::binary);
+                auto data = allocateBuffer(byteLength);
+                if (!fin || !data) return false;
+                if (!fin.read(reinterpret_cast<char*>(data->dataPointer()), static_cast<std::streamsize>(byteLength))) return false;
+                buffers[i] = data;
+            }
+        }
+        return true;
+    }
+
+    bool GLTFConverter::accessor(uint64_t index, Accessor& result) const
+    {
+        const auto& accessor = document["accessors"].at(index);
+        if (!accessor.isObject()) return false;
+
+        auto count = accessor["count"].asIndex(0);
+        if (count == 0 || count > std::numeric_limits<uint32_t>::max()) return false;
+
+        result.count = static_cast<uint32_t>(count);
+        result.componentType = accessor["componentType"].asIndex(0);
+        result.numComponents = numComponents(accessor["type"].asString());
+        result.normalized = accessor["normalized"].asBool(false);
+
+        uint32_t elementSize = result.numComponents * componentSize(result.componentType);
+        if (elementSize == 0) return false;
+
+        if (!accessor.has("bufferView"))
+        {
+            result.buffer = {};
+            result.stride = elementSize;
+            return true;
+        }
+
+        const auto& bufferView = document["bufferViews"].at(accessor["bufferView"].asIndex());
+        auto bufferIndex = bufferView["buffer"].asIndex();
+        if (bufferIndex >= buffers.size() || !buffers[bufferIndex]) return false;
+
+        auto viewOffset = bufferView["byteOffset"].asIndex(0);
+        auto viewLength = bufferView["byteLength"].asIndex(0);
+        auto byteStride = bufferView["byteStride"].asIndex(0);
+
+        result.buffer = buffers[bufferIndex];
+        result.offset = viewOffset + accessor["byteOffset"].asIndex(0);
+        result.stride = byteStride != 0 ? static_cast<uint32_t>(std::min<uint64_t>(byteStride, 256)) : elementSize;
+
+        // all the elements must lie within the bufferView, and the bufferView within the buffer
+        uint64_t end = result.offset + static_cast<uint64_t>(result.stride) * (result.count - 1) + elementSize;
+        return end <= viewOffset + viewLength && viewOffset + viewLength <= result.buffer->dataSize();
+    }
+
+    vsg::ref_ptr<vsg::Data> GLTFConverter::readImage(const json::Value& image) const
+    {
+        const auto& uri = image["uri"].asString();
+
+        std::vector<uint8_t> decoded;
+        const uint8_t* ptr = nullptr;
+        size_t size = 0;
+        std::string mediaType = image["mimeType"].asString();
+
+        const char* payload = nullptr;
+        size_t payloadSize = 0;
+        if (image.has("uri") && !splitDataURI(uri, mediaType, payload, payloadSize))
+        {
+            return vsg::read_cast<vsg::Data>(decodeURI(uri), options);
+        }
+        else if (payload)
+        {
+            decoded.resize(payloadSize / 4 * 3 + 3);
+            size = decodeBase64(payload, payloadSize, decoded.data());
+            ptr = decoded.data();
+        }
+        else
+        {
+            const auto& bufferView = document["bufferViews"].at(image["bufferView"].asIndex());
+            auto bufferIndex = bufferView["buffer"].asIndex();
+            if (bufferIndex >= buffers.size() || !buffers[bufferIndex]) return {};
+
+            auto offset = bufferView["byteOffset"].asIndex(0);
+            size = bufferView["byteLength"].asIndex(0);
+            if (offset + size > buffers[bufferIndex]->dataSize()) return {};
+            ptr = static_cast<const uint8_t*>(buffers[bufferIndex]->dataPointer()) + offset;
+        }
+
+        // embedded images are decoded from memory, identified by their mimeType, or failing that their contents
+        auto local_options = vsg::clone(options);
+        local_options->extensionHint = extensionFromContentType(mediaType);
+        if (!local_options->extensionHint) local_options->extensionHint = extensionFromContents(ptr, size);
+
+        auto object = vsg::read(ptr, size, local_options);
+        if (!object)
+        {
+            // fallback to istream path for ReaderWriters that don't support reading from memory
+            vsg::mem_stream stream(ptr, size);
+            object = vsg::read(stream, local_options);
+        }
+        return object.cast<vsg::Data>();
+    }
+
+    void GLTFConverter::readTextures()
+    {
+        const auto& gltfTextures = document["textures"].array;
+
+        // prefer the plain source, KHR_texture_basisu images need vsgXchange built with Basis Universal transcoding
+        auto textureSource = [](const json::Value& texture) {
+            if (texture.has("source")) return texture["source"].asIndex();
+            return texture["extensions"]["KHR_texture_basisu"]["source"].asIndex();
+        };
+
+        // read the images the textures use in parallel
+        const auto& gltfImages = document["images"].array;
+        images.clear();
+        images.resize(gltfImages.size());
+
+        std::vector<uint64_t> usedImages;
+        for (auto& texture : gltfTextures)
+        {
+            auto source = textureSource(texture);
+            if (source < images.size()) usedImages.push_back(source);
+        }
+        std::sort(usedImages.begin(), usedImages.end());
+        usedImages.erase(std::unique(usedImages.begin(), usedImages.end()), usedImages.end());
+
+        parallel_for(usedImages.size(), numThreads, [&](size_t i) {
+            if (cancelled()) return;
+            auto index = usedImages[i];
+            images[index] = readImage(gltfImages[index]);
+            if (!images[index]) vsg::warn("vsgXchange::gltf could not read image ", index, " ", gltfImages[index]["uri"].asString().substr(0, 256));
+        });
+
+        for (auto& data : images)
+        {
+            if (data) sharedObjects->share(data);
+        }
+
+        textures.clear();
+        textures.resize(gltfTextures.size());
+        for (size_t i = 0; i < gltfTextures.size(); ++i)
+        {
+            const auto& texture = gltfTextures[i];
+            auto source = textureSource(texture);
+            if (source >= images.size() || !images[source]) continue;
+
+            auto& samplerImage = textures[i];
+            samplerImage.data = images[source];
+
+            const auto& gltfSampler = document["samplers"].at(texture["sampler"].asIndex());
+            auto minFilter = gltfSampler["minFilter"].asIndex(9987);
+
+            auto sampler = vsg::Sampler::create();
+            sampler->addressModeU = getWrapMode(gltfSampler["wrapS"].asIndex(10497));
+            sampler->addressModeV = getWrapMode(gltfSampler["wrapT"].asIndex(10497));
+            sampler->addressModeW = sampler->addressModeU;
+            sampler->magFilter = gltfSampler["magFilter"].asIndex(9729) == 9728 ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+            sampler->minFilter = (minFilter == 9728 || minFilter == 9984 || minFilter == 9986) ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+            sampler->mipmapMode = (minFilter == 9984 || minFilter == 9985) ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            sampler->anisotropyEnable = VK_TRUE;
+            sampler->maxAnisotropy = 16.0f;
+
+            if (minFilter == 9728 || minFilter == 9729)
+            {
+                // NEAREST and LINEAR minification filters don't use mipmaps
+                sampler->maxLod = 0.0f;
+            }
+            else
+            {
+                sampler->maxLod = samplerImage.data->properties.maxNumMipmaps;
+                if (sampler->maxLod <= 1.0)
+                {
+                    // Calculate maximum lod level
+                    auto maxDim = std::max(samplerImage.data->width(), samplerImage.data->height());
+                    sampler->maxLod = std::floor(std::log2f(static_cast<float>(maxDim)));
+                }
+            }
+
+            sharedObjects->share(sampler);
+            samplerImage.sampler = sampler;
+        }
+    }
+
+    vsg::ref_ptr<vsg::DescriptorConfigurator> GLTFConverter::convertMaterial(const json::Value& material) const
+    {
+        auto convertedMaterial = vsg::DescriptorConfigurator::create();
+        convertedMaterial->shaderSet = pbrShaderSet;
+
+        auto getColor = [&](const json::Value& value, vsg::vec4& color) {
+            for (size_t c = 0; c < value.size() && c < 4; ++c) color[c] = static_cast<float>(value.at(c).asNumber(color[c]));
+            vsg::convert(color, vsg::CoordinateSpace::LINEAR, targetMaterialCoordinateSpace);
+        };
+
+        auto assignTexture = [&](const char* name, const json::Value& textureInfo) {
+            auto index = textureInfo["index"].asIndex();
+            if (index >= textures.size() || !textures[index].data) return;
+            convertedMaterial->assignTexture(name, textures[index].data, textures[index].sampler);
+        };
+
+        vsg::PbrMaterial pbr;
+        const auto& pbrMetallicRoughness = material["pbrMetallicRoughness"];
+        getColor(pbrMetallicRoughness["baseColorFactor"], pbr.baseColorFactor);
+        pbr.metallicFactor = static_cast<float>(pbrMetallicRoughness["metallicFactor"].asNumber(1.0));
+        pbr.roughnessFactor = static_cast<float>(pbrMetallicRoughness["roughnessFactor"].asNumber(1.0));
+
+        pbr.emissiveFactor.set(0.0f, 0.0f, 0.0f, 1.0f);
+        getColor(material["emissiveFactor"], pbr.emissiveFactor);
+        if (auto strength = material["extensions"]["KHR_materials_emissive_strength"]["emissiveStrength"].asNumber(1.0); strength != 1.0)
+        {
+            pbr.emissiveFactor.r *= static_cast<float>(strength);
+            pbr.emissiveFactor.g *= static_cast<float>(strength);
+            pbr.emissiveFactor.b *= static_cast<float>(strength);
+        }
+
+        const auto& alphaMode = material["alphaMode"].asString();
+        if (alphaMode == "BLEND")
+        {
+            convertedMaterial->blending = true;
+            pbr.alphaMask = 0.0f;
+        }
+        else if (alphaMode == "MASK")
+        {
+            pbr.alphaMaskCutoff = static_cast<float>(material["alphaCutoff"].asNumber(0.5));
+        }
+        else
+        {
+            pbr.alphaMaskCutoff = 0.0f;
+        }
+
+        if (material["doubleSided"].asBool(false))
+        {
+            convertedMaterial->two_sided = true;
+            convertedMaterial->defines.insert("VSG_TWO_SIDED_LIGHTING");
+        }
+
+        assignTexture("diffuseMap", pbrMetallicRoughness["baseColorTexture"]);
+        assignTexture("mrMap", pbrMetallicRoughness["metallicRoughnessTexture"]);
+        assignTexture("normalMap", material["normalTexture"]);
+        assignTexture("aoMap", material["occlusionTexture"]);
+        assignTexture("emissiveMap", material["emissiveTexture"]);
+
+        convertedMaterial->assignDescriptor("material", vsg::PbrMaterialValue::create(pbr));
+        return convertedMaterial;
+    }
+
+    vsg::ref_ptr<vsg::Node> GLTFConverter::convertPrimitive(const json::Value& primitive) const
+    {
+        const auto& attributes = primitive["attributes"];
+
+        Accessor positions;
+        if (!accessor(attributes["POSITION"].asIndex(), positions) || positions.numComponents != 3) return {};
+
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        auto mode = primitive["mode"].asIndex(4);
+        switch (mode)
+        {
+        case 0: topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST; break;
+        case 1: topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST; break;
+        case 2: // LINE_LOOP is drawn as a closed line strip
+        case 3: topology = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP; break;
+        case 4: topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST; break;
+        case 5: topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP; break;
+        case 6: topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN; break;
+        default: return {};
+        }
+
+        vsg::ref_ptr<vsg::Data> indices;
+        if (primitive.has("indices"))
+        {
+            Accessor indexAccessor;
+            if (!accessor(primitive["indices"].asIndex(), indexAccessor) || !(indices = indexArray(indexAccessor))) return {};
+
+            if (maxIndex(*indices) >= positions.count)
+            {
+                vsg::warn("vsgXchange::gltf primitive indices exceed its ", positions.count, " vertices, discarding primitive.");
+                return {};
+            }
+        }
+
+        if (mode == 2)
+        {
+            // close the loop by repeating the first vertex
+            uint32_t count = indices ? static_cast<uint32_t>(indices->valueCount()) : positions.count;
+            if (!reserveReadMemory(static_cast<uint64_t>(count + 1) * 4)) return {};
+
+            auto loop = vsg::uintArray::create(count + 1);
+            auto ushortIndices = indices.cast<vsg::ushortArray>();
+            auto uintIndices = indices.cast<vsg::uintArray>();
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (ushortIndices)
+                    loop->set(i, ushortIndices->at(i));
+                else if (uintIndices)
+                    loop->set(i, uintIndices->at(i));
+                else
+                    loop->set(i, i);
+            }
+            loop->set(count, loop->at(0));
+            indices = loop;
+        }
+
+        auto material = defaultMaterial;
+        if (auto materialIndex = primitive["material"].asIndex(); materialIndex < materials.size()) material = materials[materialIndex];
+
+        auto config = vsg::GraphicsPipelineConfigurator::create(material->shaderSet);
+        config->descriptorConfigurator = material;
+        if (options) config->assignInheritedState(options->inheritedState);
+
+        vsg::DataList vertexArrays;
+
+        auto vertices = floatArray<vsg::vec3Array>(positions, VK_FORMAT_R32G32B32_SFLOAT, vsg::vec3(0.0f, 0.0f, 0.0f));
+        if (!vertices) return {};
+        config->assignArray(vertexArrays, "vsg_Vertex", VK_VERTEX_INPUT_RATE_VERTEX, vertices);
+
+        Accessor normalAccessor;
+        if (accessor(attributes["NORMAL"].asIndex(), normalAccessor) && normalAccessor.count == positions.count)
+        {
+            auto normals = floatArray<vsg::vec3Array>(normalAccessor, VK_FORMAT_R32G32B32_SFLOAT, vsg::vec3(0.0f, 0.0f, 1.0f));
+            if (!normals) return {};
+            config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_VERTEX, normals);
+        }
+        else
+        {
+            config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec3Value::create(vsg::vec3(0.0f, 0.0f, 1.0f)));
+        }
+
+        Accessor texcoordAccessor;
+        if (accessor(attributes["TEXCOORD_0"].asIndex(), texcoordAccessor) && texcoordAccessor.count == positions.count)
+        {
+            auto texcoords = floatArray<vsg::vec2Array>(texcoordAccessor, VK_FORMAT_R32G32_SFLOAT, vsg::vec2(0.0f, 0.0f));
+            if (!texcoords) return {};
+            config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_VERTEX, texcoords);
+        }
+        else
+        {
+            config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec2Value::create(vsg::vec2(0.0f, 0.0f)));
+        }
+
+        bool convertColors = targetVertexColorSpace != vsg::CoordinateSpace::LINEAR;
+        Accessor colorAccessor;
+        if (accessor(attributes["COLOR_0"].asIndex(), colorAccessor) && colorAccessor.count == positions.count)
+        {
+            auto colors = floatArray<vsg::vec4Array>(colorAccessor, VK_FORMAT_R32G32B32A32_SFLOAT, vsg::vec4(0.0f, 0.0f, 0.0f, 1.0f), convertColors);
+            if (!colors) return {};
+            if (convertColors) vsgXchange::convertColors(colors->size(), colors->data(), vsg::CoordinateSpace::LINEAR, targetVertexColorSpace);
+            config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_VERTEX, colors);
+        }
+        else
+        {
+            vsg::vec4 color(1.0f, 1.0f, 1.0f, 1.0f);
+            vsg::convert(color, vsg::CoordinateSpace::LINEAR, targetVertexColorSpace);
+            config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec4Value::create(color));
+        }
+
+        vsg::ref_ptr<vsg::Node> draw;
+        if (indices)
+        {
+            auto vid = vsg::VertexIndexDraw::create();
+            vid->assignArrays(vertexArrays);
+            vid->assignIndices(indices);
+            vid->indexCount = static_cast<uint32_t>(indices->valueCount());
+            vid->instanceCount = 1;
+            draw = vid;
+        }
+        else
+        {
+            auto vd = vsg::VertexDraw::create();
+            vd->assignArrays(vertexArrays);
+            vd->vertexCount = positions.count;
+            vd->instanceCount = 1;
+            draw = vd;
+        }
+
+        // set the GraphicsPipelineStates to the required values.
+        struct SetPipelineStates : public vsg::Visitor
+        {
+            VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+            bool blending = false;
+            bool two_sided = false;
+
+            SetPipelineStates(VkPrimitiveTopology in_topology, bool in_blending, bool in_two_sided) :
+                topology(in_topology), blending(in_blending), two_sided(in_two_sided) {}
+
+            void apply(vsg::Object& object) { object.traverse(*this); }
+            void apply(vsg::RasterizationState& rs)
+            {
+                if (two_sided) rs.cullMode = VK_CULL_MODE_NONE;
+            }
+            void apply(vsg::InputAssemblyState& ias) { ias.topology = topology; }
+            void apply(vsg::ColorBlendState& cbs) { cbs.configureAttachments(blending); }
+        } sps(topology, material->blending, material->two_sided);
+        config->accept(sps);
+
+        // the pipeline is bound once all the meshes are converted, so the unique configurations can be initialized concurrently
+        auto stateGroup = vsg::StateGroup::create();
+        pipelineConfigurations.assign(config, stateGroup);
+        stateGroup->addChild(draw);
+
+        if (material->blending)
+        {
+            // POSITION accessors are required to have their min and max, but compute the bounds if they're missing
+            vsg::dbox bounds;
+            const auto& min = document["accessors"].at(attributes["POSITION"].asIndex())["min"];
+            const auto& max = document["accessors"].at(attributes["POSITION"].asIndex())["max"];
+            if (min.size() == 3 && max.size() == 3)
+            {
+                bounds.add(min.at(0).asNumber(), min.at(1).asNumber(), min.at(2).asNumber());
+                bounds.add(max.at(0).asNumber(), max.at(1).asNumber(), max.at(2).asNumber());
+            }
+            else
+            {
+                for (auto& vertex : *vertices) bounds.add(vsg::dvec3(vertex));
+            }
+
+            auto depthSorted = vsg::DepthSorted::create();
+            depthSorted->binNumber = 10;
+            depthSorted->bound.set((bounds.min.x + bounds.max.x) * 0.5, (bounds.min.y + bounds.max.y) * 0.5, (bounds.min.z + bounds.max.z) * 0.5, vsg::length(bounds.max - bounds.min) * 0.5);
+            depthSorted->child = stateGroup;
+            return depthSorted;
+        }
+
+        return stateGroup;
+    }
+
+    vsg::ref_ptr<vsg::Node> GLTFConverter::convertMesh(const json::Value& mesh) const
+    {
+        vsg::Group::Children children;
+        for (auto& primitive : mesh["primitives"].array)
+        {
+            if (cancelled()) return {};
+            if (auto node = convertPrimitive(primitive)) children.push_back(node);
+        }
+
+        vsg::ref_ptr<vsg::Node> node;
+        if (children.size() == 1)
+        {
+            node = children.front();
+        }
+        else if (!children.empty())
+        {
+            auto group = vsg::Group::create();
+            group->children = std::move(children);
+            node = group;
+        }
+
+        const auto& name = mesh["name"].asString();
+        if (node && !name.empty()) node->setValue("name", name);
+        return node;
+    }
+
+    vsg::ref_ptr<vsg::Node> GLTFConverter::convertNode(uint64_t index, uint32_t depth) const
+    {
+        const auto& nodes = document["nodes"];
+        const auto& node = nodes.at(index);
+
+        // nodes must form a forest, so a deeper recursion than there are nodes means the document has a cycle
+        if (!node.isObject() || depth > nodes.size()) return {};
+
+        vsg::Group::Children children;
+        if (auto meshIndex = node["mesh"].asIndex(); meshIndex < meshes.size() && meshes[meshIndex]) children.push_back(meshes[meshIndex]);
+
+        for (auto& child : node["children"].array)
+        {
+            if (auto childNode = convertNode(child.asIndex(), depth + 1)) children.push_back(childNode);
+        }
+
+        if (children.empty()) return {};
+
+        vsg::dmat4 matrix;
+        if (const auto& m = node["matrix"]; m.size() == 16)
+        {
+            // glTF matrices are column major, like vsg::dmat4
+            for (size_t c = 0; c < 4; ++c)
+            {
+                for (size_t r = 0; r < 4; ++r) matrix[c][r] = m.at(c * 4 + r).asNumber(c == r ? 1.0 : 0.0);
+            }
+        }
+        else
+        {
+            const auto& t = node["translation"];
+            const auto& r = node["rotation"];
+            const auto& s = node["scale"];
+            if (t.size() == 3) matrix = matrix * vsg::translate(t.at(0).asNumber(), t.at(1).asNumber(), t.at(2).asNumber());
+            if (r.size() == 4) matrix = matrix * vsg::rotate(vsg::dquat(r.at(0).asNumber(), r.at(1).asNumber(), r.at(2).asNumber(), r.at(3).asNumber(1.0)));
+            if (s.size() == 3) matrix = matrix * vsg::scale(s.at(0).asNumber(1.0), s.at(1).asNumber(1.0), s.at(2).asNumber(1.0));
+        }
+
+        const auto& name = node["name"].asString();
+        vsg::ref_ptr<vsg::Group> group;
+        if (matrix != vsg::dmat4())
+        {
+            group = vsg::MatrixTransform::create(matrix);
+        }
+        else if (children.size() == 1 && name.empty())
+        {
+            return children.front();
+        }
+        else
+        {
+            group = vsg::Group::create();
+        }
+
+        group->children = std::move(children);
+        if (!name.empty()) group->setValue("name", name);
+        return group;
+    }
+
+    vsg::ref_ptr<vsg::MatrixTransform> GLTFConverter::processCoordinateFrame(const vsg::Path& ext) const
+    {
+        // glTF is defined to be Y up
+        vsg::CoordinateConvention source_coordinateConvention = vsg::CoordinateConvention::Y_UP;
+
+        if (auto itr = options->formatCoordinateConventions.find(ext); itr != options->formatCoordinateConventions.end())
+        {
+            source_coordinateConvention = itr->second;
+        }
+
+        vsg::dmat4 matrix;
+        if (vsg::transform(source_coordinateConvention, options->sceneCoordinateConvention, matrix))
+        {
+            return vsg::MatrixTransform::create(matrix);
+        }
+        else
+        {
+            return {};
+        }
+    }
+
+    vsg::ref_ptr<vsg::Node> GLTFConverter::convert(vsg::ref_ptr<vsg::ubyteArray> binChunk, const vsg::Path& ext)
+    {
+        vsgXchange::ReadWritePhaseTimer phaseTimer("gltf buffers");
+        if (!readBuffers(binChunk))
+        {
+            vsg::warn("vsgXchange::gltf could not read the buffers of the glTF file.");
+            return {};
+        }
+        if (cancelled()) return {};
+
+        phaseTimer.next("gltf textures");
+        readTextures();
+        if (cancelled()) return {};
+
+        phaseTimer.next("gltf materials");
+        pbrShaderSet = vsg::createPhysicsBasedRenderingShaderSet(options);
+        sharedObjects->share(pbrShaderSet);
+        targetMaterialCoordinateSpace = pbrShaderSet->getDescriptorBinding("material").coordinateSpace;
+        targetVertexColorSpace = pbrShaderSet->getAttributeBinding("vsg_Color").coordinateSpace;
+
+        defaultMaterial = convertMaterial(json::Value());
+        materials.clear();
+        for (auto& material : document["materials"].array) materials.push_back(convertMaterial(material));
+
+        // convert the meshes in parallel, each mesh only reads the converted materials and writes its own meshes entry,
+        // the node graph that references them is then assembled serially by convertNode()
+        phaseTimer.next("gltf meshes");
+        const auto& gltfMeshes = document["meshes"].array;
+        meshes.clear();
+        meshes.resize(gltfMeshes.size());
+        parallel_for(gltfMeshes.size(), numThreads, [&](size_t i) {
+            if (cancelled()) return;
+            meshes[i] = convertMesh(gltfMeshes[i]);
+        });
+        if (cancelled()) return {};
+
+        // meshes that would exceed the read's read_memory_budget are skipped, so rather than return an incomplete model abandon the read
+        if (auto readMemory = currentReadMemory(); readMemory && readMemory->exceeded()) return {};
+
+        phaseTimer.next("gltf pipelines");
+        pipelineConfigurations.initialize(sharedObjects, numThreads);
+
+        phaseTimer.next("gltf scene graph");
+        std::vector<uint64_t> rootNodes;
+        const auto& scenes = document["scenes"];
+        if (scenes.size() > 0)
+        {
+            const auto& scene = scenes.at(document["scene"].asIndex(0));
+            for (auto& node : scene["nodes"].array) rootNodes.push_back(node.asIndex());
+        }
+        else
+        {
+            // without scenes draw all the nodes that aren't the children of other nodes
+            const auto& nodes = document["nodes"].array;
+            std::vector<bool> isChild(nodes.size(), false);
+            for (auto& node : nodes)
+            {
+                for (auto& child : node["children"].array)
+                {
+                    if (auto index = child.asIndex(); index < isChild.size()) isChild[index] = true;
+                }
+            }
+            for (size_t i = 0; i < nodes.size(); ++i)
+            {
+                if (!isChild[i]) rootNodes.push_back(i);
+            }
+        }
+
+        vsg::Group::Children children;
+        for (auto index : rootNodes)
+        {
+            if (auto node = convertNode(index, 0)) children.push_back(node);
+        }
+
+        if (children.empty()) return {};
+
+        vsg::ref_ptr<vsg::Node> vsg_scene;
+        if (children.size() == 1)
+        {
+            vsg_scene = children.front();
+        }
+        else
+        {
+            auto group = vsg::Group::create();
+            group->children = std::move(children);
+            vsg_scene = group;
+        }
+
+        // decorate scene graph with transform if required to standardize the coordinate frame
+        if (auto transform = processCoordinateFrame(ext))
+        {
+            transform->addChild(vsg_scene);
+            vsg_scene = transform;
+        }
+
+        return vsg_scene;
+    }
+
+    /// read a .gltf or .glb file from fin, the JSON is parsed and checked for unsupported features before the binary chunk is read.
+    vsg::ref_ptr<vsg::Object> readGLTF(std::istream& fin, vsg::ref_ptr<const vsg::Options> options, const vsg::Path& ext)
+    {
+        vsgXchange::ReadWritePhaseTimer phaseTimer("gltf parse");
+
+        std::string jsonText;
+        uint64_t binChunkLength = 0;
+
+        uint32_t header[3] = {0, 0, 0};
+        fin.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (fin.gcount() == sizeof(header) && header[0] == GLB_MAGIC)
+        {
+            if (header[1] != 2) return {};
+
+            uint32_t chunkHeader[2] = {0, 0};
+            if (!fin.read(reinterpret_cast<char*>(chunkHeader), sizeof(chunkHeader)) || chunkHeader[1] != GLB_CHUNK_JSON) return {};
+
+            jsonText.resize(chunkHeader[0]);
+            if (!fin.read(jsonText.data(), static_cast<std::streamsize>(jsonText.size()))) return {};
+
+            // the binary chunk is optional
+            if (fin.read(reinterpret_cast<char*>(chunkHeader), sizeof(chunkHeader)) && chunkHeader[1] == GLB_CHUNK_BIN) binChunkLength = chunkHeader[0];
+        }
+        else
+        {
+            jsonText.assign(reinterpret_cast<const char*>(header), static_cast<size_t>(fin.gcount()));
+            fin.clear();
+            jsonText.append(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+        }
+
+        json::Value document;
+        std::string error;
+        if (!json::parse(jsonText.data(), jsonText.data() + jsonText.size(), document, error) || !document.isObject())
+        {
+            vsg::warn("vsgXchange::gltf could not parse glTF JSON: ", error);
+            return {};
+        }
+        jsonText = std::string();
+
+        GLTFConverter converter(document, options);
+        if (auto feature = converter.unsupported(); !feature.empty())
+        {
+            vsg::debug("vsgXchange::gltf leaving file that uses ", feature, " to other ReaderWriters.");
+            return {};
+        }
+
+        // read the binary chunk straight into the buffer that the vertex and index arrays view
+        vsg::ref_ptr<vsg::ubyteArray> binChunk;
+        if (binChunkLength > 0)
+        {
+            binChunk = allocateBuffer(binChunkLength);
+            if (!binChunk || !fin.read(reinterpret_cast<char*>(binChunk->dataPointer()), static_cast<std::streamsize>(binChunkLength))) return {};
+        }
+
+        phaseTimer.end();
+        return converter.convert(binChunk, ext);
+    }
+
+} // namespace
+
+gltf::gltf()
+{
+}
+
+vsg::ref_ptr<vsg::Object> gltf::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    vsg::Path ext = (options && options->extensionHint) ? options->extensionHint : vsg::lowerCaseFileExtension(filename);
+    if (!supportedExtension(ext) || vsg::value<bool>(false, gltf::use_assimp, options.get())) return {};
+
+    vsg::Path filenameToUse = vsg::findFile(filename, options);
+    if (!filenameToUse) return {};
+
+    std::ifstream fin(filenameToUse, std::ios::in | std::ios::binary);
+    if (!fin) return {};
+
+    // resolve the external buffers and images relative to the glTF file
+    auto opt = options ? vsg::clone(options) : vsg::Options::create();
+    opt->paths.insert(opt->paths.begin(), vsg::filePath(filenameToUse));
+
+    return readGLTF(fin, opt, ext);
+}
+
+vsg::ref_ptr<vsg::Object> gltf::read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!options || !supportedExtension(options->extensionHint) || vsg::value<bool>(false, gltf::use_assimp, options.get())) return {};
+
+    // restore the stream position for the next ReaderWriter if the file isn't read
+    auto pos = fin.tellg();
+    auto object = readGLTF(fin, options, options->extensionHint);
+    if (!object && pos != std::istream::pos_type(-1))
+    {
+        fin.clear();
+        fin.seekg(pos);
+    }
+    return object;
+}
+
+vsg::ref_ptr<vsg::Object> gltf::read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!options || !supportedExtension(options->extensionHint) || vsg::value<bool>(false, gltf::use_assimp, options.get())) return {};
+
+    vsg::mem_stream fin(ptr, size);
+    return readGLTF(fin, options, options->extensionHint);
+}
+
+bool gltf::getFeatures(Features& features) const
+{
+    vsg::ReaderWriter::FeatureMask supported_features = static_cast<vsg::ReaderWriter::FeatureMask>(vsg::ReaderWriter::READ_FILENAME | vsg::ReaderWriter::READ_ISTREAM | vsg::ReaderWriter::READ_MEMORY);
+    features.extensionFeatureMap[".gltf"] = supported_features;
+    features.extensionFeatureMap[".glb"] = supported_features;
+
+    features.optionNameTypeMap[gltf::use_assimp] = vsg::type_name<bool>();
+    features.optionNameTypeMap[gltf::num_threads] = vsg::type_name<uint32_t>();
+
+    return true;
+}
+
+bool gltf::readOptions(vsg::Options& options, vsg::CommandLine& arguments) const
+{
+    bool result = arguments.readAndAssign<bool>(gltf::use_assimp, &options);
+    result = arguments.readAndAssign<uint32_t>(gltf::num_threads, &options) || result;
+    return result;
+}
@@ -0,0 +1,290 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include "json.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace vsgXchange;
+using namespace vsgXchange::json;
+
+namespace
+{
+    const Value s_nullValue;
+    const std::string s_emptyString;
+
+    // glTF documents nest a few levels deep, the limit guards the recursion against malicious input
+    constexpr unsigned int MAX_DEPTH = 256;
+
+    struct Parser
+    {
+        const char* ptr;
+        const char* end;
+        std::string& error;
+
+        bool fail(const char* message)
+        {
+            if (error.empty()) error = message;
+            return false;
+        }
+
+        void skipWhitespace()
+        {
+            while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\n' || *ptr == '\r')) ++ptr;
+        }
+
+        bool match(const char* literal)
+        {
+            size_t length = std::strlen(literal);
+            if (static_cast<size_t>(end - ptr) < length || std::memcmp(ptr, literal, length) != 0) return false;
+            ptr += length;
+            return true;
+        }
+
+        static void appendUTF8(std::string& str, uint32_t codepoint)
+        {
+            if (codepoint < 0x80)
+            {
+                str.push_back(static_cast<char>(codepoint));
+            }
+            else if (codepoint < 0x800)
+            {
+                str.push_back(static_cast<char>(0xc0 | (codepoint >> 6)));
+                str.push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+            }
+            else if (codepoint < 0x10000)
+            {
+                str.push_back(static_cast<char>(0xe0 | (codepoint >> 12)));
+                str.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f)));
+                str.push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+            }
+            else
+            {
+                str.push_back(static_cast<char>(0xf0 | (codepoint >> 18)));
+                str.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f)));
+                str.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f)));
+                str.push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+            }
+        }
+
+        bool parseHex4(uint32_t& value)
+        {
+            if (end - ptr < 4) return fail("truncated \\u escape");
+            value = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                char c = *ptr++;
+                value <<= 4;
+                if (c >= '0' && c <= '9')
+                    value |= static_cast<uint32_t>(c - '0');
+                else if (c >= 'a' && c <= 'f')
+                    value |= static_cast<uint32_t>(c - 'a' + 10);
+                else if (c >= 'A' && c <= 'F')
+                    value |= static_cast<uint32_t>(c - 'A' + 10);
+                else
+                    return fail("invalid \\u escape");
+            }
+            return true;
+        }
+
+        bool parseString(std::string& str)
+        {
+            ++ptr; // opening quote
+            while (ptr < end)
+            {
+                // copy the runs of unescaped characters in one go
+                const char* start = ptr;
+                while (ptr < end && *ptr != '"' && *ptr != '\\') ++ptr;
+                str.append(start, ptr);
+                if (ptr >= end) break;
+
+                if (*ptr++ == '"') return true;
+
+                if (ptr >= end) break;
+                switch (char c = *ptr++)
+                {
+                case '"': str.push_back('"'); break;
+                case '\\': str.push_back('\\'); break;
+                case '/': str.push_back('/'); break;
+                case 'b': str.push_back('\b'); break;
+                case 'f': str.push_back('\f'); break;
+                case 'n': str.push_back('\n'); break;
+                case 'r': str.push_back('\r'); break;
+                case 't': str.push_back('\t'); break;
+                case 'u': {
+                    uint32_t codepoint = 0;
+                    if (!parseHex4(codepoint)) return false;
+                    if (codepoint >= 0xd800 && codepoint < 0xdc00)
+                    {
+                        // surrogate pair
+                        uint32_t low = 0;
+                        if (!match("\\u") || !parseHex4(low) || low < 0xdc00 || low >= 0xe000) return fail("invalid surrogate pair");
+                        codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+                    }
+                    appendUTF8(str, codepoint);
+                    break;
+                }
+                default:
+                    (void)c;
+                    return fail("invalid escape sequence");
+                }
+            }
+            return fail("unterminated string");
+        }
+
+        bool parseNumber(double& number)
+        {
+            const char* start = ptr;
+            if (ptr < end && *ptr == '-') ++ptr;
+            while (ptr < end && ((*ptr >= '0' && *ptr <= '9') || *ptr == '.' || *ptr == 'e' || *ptr == 'E' || *ptr == '+' || *ptr == '-')) ++ptr;
+            if (ptr == start) return fail("invalid value");
+
+            // strtod needs a null terminated string, numbers are short so copy to the stack
+            char buffer[64];
+            size_t length = static_cast<size_t>(ptr - start);
+            if (length >= sizeof(buffer)) return fail("number too long");
+            std::memcpy(buffer, start, length);
+            buffer[length] = 0;
+
+            char* numberEnd = nullptr;
+            number = std::strtod(buffer, &numberEnd);
+            if (numberEnd != buffer + length) return fail("invalid number");
+            return true;
+        }
+
+        bool parseValue(Value& value, unsigned int depth)
+        {
+            if (depth > MAX_DEPTH) return fail("nesting too deep");
+
+            skipWhitespace();
+            if (ptr >= end) return fail("unexpected end of document");
+
+            switch (*ptr)
+            {
+            case '{': {
+                ++ptr;
+                value.type = Value::OBJECT;
+                skipWhitespace();
+                if (ptr < end && *ptr == '}')
+                {
+                    ++ptr;
+                    return true;
+                }
+                while (true)
+                {
+                    skipWhitespace();
+                    if (ptr >= end || *ptr != '"') return fail("expected object member name");
+                    value.object.emplace_back();
+                    auto& member = value.object.back();
+                    if (!parseString(member.first)) return false;
+                    skipWhitespace();
+                    if (ptr >= end || *ptr++ != ':') return fail("expected ':'");
+                    if (!parseValue(member.second, depth + 1)) return false;
+                    skipWhitespace();
+                    if (ptr >= end) return fail("unterminated object");
+                    if (*ptr == ',')
+                    {
+                        ++ptr;
+                        continue;
+                    }
+                    if (*ptr++ == '}') return true;
+                    return fail("expected ',' or '}'");
+                }
+            }
+            case '[': {
+                ++ptr;
+                value.type = Value::ARRAY;
+                skipWhitespace();
+                if (ptr < end && *ptr == ']')
+                {
+                    ++ptr;
+                    return true;
+                }
+                while (true)
+                {
+                    value.array.emplace_back();
+                    if (!parseValue(value.array.back(), depth + 1)) return false;
+                    skipWhitespace();
+                    if (ptr >= end) return fail("unterminated array");
+                    if (*ptr == ',')
+                    {
+                        ++ptr;
+                        continue;
+                    }
+                    if (*ptr++ == ']') return true;
+                    return fail("expected ',' or ']'");
+                }
+            }
+            case '"':
+                value.type = Value::STRING;
+                return parseString(value.string);
+            case 't':
+                value.type = Value::BOOLEAN;
+                value.boolean = true;
+                return match("true") || fail("invalid value");
+            case 'f':
+                value.type = Value::BOOLEAN;
+                value.boolean = false;
+                return match("false") || fail("invalid value");
+            case 'n':
+                value.type = Value::NULL_VALUE;
+                return match("null") || fail("invalid value");
+            default:
+                value.type = Value::NUMBER;
+                return parseNumber(value.number);
+            }
+        }
+    };
+} // namespace
+
+const Value& Value::operator[](const char* key) const
+{
+    if (type != OBJECT) return s_nullValue;
+    for (auto& [name, member] : object)
+    {
+        if (name == key) return member;
+    }
+    return s_nullValue;
+}
+
+const Value& Value::at(size_t i) const
+{
+    if (type != ARRAY || i >= array.size()) return s_nullValue;
+    return array[i];
+}
+
+const std::string& Value::asString() const
+{
+    return type == STRING ? string : s_emptyString;
+}
+
+uint64_t Value::asIndex(uint64_t defaultValue) const
+{
+    if (type != NUMBER || number < 0.0 || number > 9007199254740992.0 || std::floor(number) != number) return defaultValue;
+    return static_cast<uint64_t>(number);
+}
+
+bool json::parse(const char* begin, const char* end, Value& value, std::string& error)
+{
+    // skip any UTF-8 byte order mark
+    if (end - begin >= 3 && std::memcmp(begin, "\xef\xbb\xbf", 3) == 0) begin += 3;
+
+    Parser parser{begin, end, error};
+    value = Value();
+    if (!parser.parseValue(value, 0)) return false;
+
+    parser.skipWhitespace();
+    if (parser.ptr != end) return parser.fail("unexpected characters after document");
+    return true;
+}
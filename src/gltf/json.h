@@ -0,0 +1,74 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vsgXchange
+{
+    namespace json
+    {
+        /// node of a parsed JSON document, objects keep their members in document order and are searched linearly as glTF objects only have a handful of members.
+        struct Value
+        {
+            enum Type : uint8_t
+            {
+                NULL_VALUE,
+                BOOLEAN,
+                NUMBER,
+                STRING,
+                ARRAY,
+                OBJECT
+            };
+
+            Type type = NULL_VALUE;
+            bool boolean = false;
+            double number = 0.0;
+            std::string string;
+            std::vector<Value> array;
+            std::vector<std::pair<std::string, Value>> object;
+
+            bool isNull() const { return type == NULL_VALUE; }
+            bool isNumber() const { return type == NUMBER; }
+            bool isString() const { return type == STRING; }
+            bool isArray() const { return type == ARRAY; }
+            bool isObject() const { return type == OBJECT; }
+
+            /// return the member named key, or a null Value if this isn't an object or doesn't have the member.
+            const Value& operator[](const char* key) const;
+
+            /// return the i'th element, or a null Value if this isn't an array or i is out of range.
+            const Value& at(size_t i) const;
+
+            bool has(const char* key) const { return !(*this)[key].isNull(); }
+
+            /// number of elements of an array or members of an object.
+            size_t size() const { return type == ARRAY ? array.size() : (type == OBJECT ? object.size() : 0); }
+
+            double asNumber(double defaultValue = 0.0) const { return type == NUMBER ? number : defaultValue; }
+            bool asBool(bool defaultValue = false) const { return type == BOOLEAN ? boolean : defaultValue; }
+            const std::string& asString() const;
+
+            /// return the number as an index, or defaultValue if it isn't a non negative integer.
+            uint64_t asIndex(uint64_t defaultValue = ~uint64_t(0)) const;
+        };
+
+        /// parse the UTF-8 JSON document in [begin, end) into value, returning false and setting error on a syntax error.
+        extern bool parse(const char* begin, const char* end, Value& value, std::string& error);
+
+    } // namespace json
+
+} // namespace vsgXchange
@@ -16,6 +16,9 @@ using namespace vsgXchange;
 
 images::images()
 {
+#ifdef vsgXchange_turbojpeg
+    add(turbojpeg::create());
+#endif
     add(stbi::create());
     add(dds::create());
     add(ktx::create());
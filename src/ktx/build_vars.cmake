@@ -13,7 +13,7 @@ set(KTX_SOURCES
     ktx/libktx/dfdutils/vk2dfd.c
 #    ktx/libktx/dfdutils/vulkan/vk_platform.h
 #    ktx/libktx/dfdutils/vulkan/vulkan_core.h
-#    ktx/libktx/etcdec.cxx
+    ktx/libktx/etcdec.cxx
 #    ktx/libktx/etcunpack.cxx
     ktx/libktx/filestream.c
     ktx/libktx/filestream.h
@@ -45,6 +45,42 @@ set(KTX_SOURCES
     ktx/libktx/vkloader.c
     ktx/libktx/zstddeclib.c
 )
+# optional Basis Universal transcoding of KTX2 textures, requires the transcoder sources from a KTX-Software source tree matching the version of ktx/libktx
+set(KTX_SOFTWARE_SOURCE_DIR "" CACHE PATH "KTX-Software source directory, used to build the Basis Universal transcoder")
+if(KTX_SOFTWARE_SOURCE_DIR AND EXISTS "${KTX_SOFTWARE_SOURCE_DIR}/lib/basis_transcode.cpp")
+    OPTION(vsgXchange_ktx_basis "Optional KTX2 Basis Universal transcoding support" ON)
+endif()
+
+if(${vsgXchange_ktx_basis})
+    set(KTX_SOURCES ${KTX_SOURCES}
+        ${KTX_SOFTWARE_SOURCE_DIR}/lib/basis_transcode.cpp
+        ${KTX_SOFTWARE_SOURCE_DIR}/lib/basisu/transcoder/basisu_transcoder.cpp
+    )
+    set(EXTRA_DEFINES ${EXTRA_DEFINES} vsgXchange_ktx_basis BASISD_SUPPORT_KTX2=0 BASISD_SUPPORT_KTX2_ZSTD=0)
+    set(EXTRA_INCLUDES ${EXTRA_INCLUDES} $<BUILD_INTERFACE:${KTX_SOFTWARE_SOURCE_DIR}/lib/basisu>)
+endif()
+
+# optional zstd supercompression when writing KTX2, the full zstd library also provides the decompression otherwise built from the vendored zstddeclib.c
+find_package(zstd CONFIG QUIET)
+if(zstd_FOUND)
+    OPTION(vsgXchange_ktx_zstd "Optional KTX2 zstd supercompression support" ON)
+endif()
+
+if(${vsgXchange_ktx_zstd})
+    list(REMOVE_ITEM KTX_SOURCES ktx/libktx/zstddeclib.c)
+    # ktx_zstd.h declares the zstd API with hidden visibility by default, which would prevent linking to a shared zstd library
+    set(EXTRA_DEFINES ${EXTRA_DEFINES} vsgXchange_ktx_zstd ZSTDLIB_VISIBILITY=)
+    if(TARGET zstd::libzstd_shared)
+        set(EXTRA_LIBRARIES ${EXTRA_LIBRARIES} zstd::libzstd_shared)
+    else()
+        set(EXTRA_LIBRARIES ${EXTRA_LIBRARIES} zstd::libzstd_static)
+    endif()
+
+    if(NOT BUILD_SHARED_LIBS)
+        set(FIND_DEPENDENCY ${FIND_DEPENDENCY} "find_dependency(zstd CONFIG)")
+    endif()
+endif()
+
 source_group(libktx FILES ${KTX_SOURCES})
 set(SOURCES ${SOURCES} ${KTX_SOURCES} ktx/ktx.cpp)
 set(EXTRA_DEFINES ${EXTRA_DEFINES} KHRONOS_STATIC LIBKTX BASISD_SUPPORT_FXT1=0 BASISU_NO_ITERATOR_DEBUG_LEVEL KTX_FEATURE_KTX1 KTX_FEATURE_KTX2)
@@ -11,19 +11,37 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 </editor-fold> */
 
 #include <vsgXchange/images.h>
+#include <vsgXchange/read_memory.h>
+
+#include "../all/block_decompress.h"
+#include "../all/image_downsample.h"
+#include "../all/mapped_file.h"
+#include "../all/stream_utils.h"
 
 #include <vsg/core/Exception.h>
+#include <vsg/io/Logger.h>
 #include <vsg/io/stream.h>
 #include <vsg/state/DescriptorImage.h>
+#include <vsg/utils/CommandLine.h>
 
+#include <KHR/khr_df.h>
 #include <ktx.h>
 #include <ktxvulkan.h>
 #include <texture.h>
 #include <vk_format.h>
 
+#ifdef vsgXchange_ktx_zstd
+#    include <zstd.h>
+#endif
+
 #include <algorithm>
+#include <cctype>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
 
 namespace
 {
@@ -40,14 +58,64 @@ namespace
         }
     }
 
-    vsg::ref_ptr<vsg::Data> readKtx(ktxTexture* texture, const vsg::Path& /*filename*/)
+    // select the first of the comma separated ktx::transcode_formats that is recognized, defaulting to uncompressed RGBA
+    ktx_transcode_fmt_e transcodeFormat(vsg::ref_ptr<const vsg::Options> options)
+    {
+        std::string formats;
+        if (options) options->getValue(vsgXchange::ktx::transcode_formats, formats);
+
+        std::stringstream sstr(formats);
+        std::string format;
+        while (std::getline(sstr, format, ','))
+        {
+            format.erase(0, format.find_first_not_of(' '));
+            format.erase(format.find_last_not_of(' ') + 1);
+            std::transform(format.begin(), format.end(), format.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+            if (format == "bc7") return KTX_TTF_BC7_RGBA;
+            if (format == "astc") return KTX_TTF_ASTC_4x4_RGBA;
+            if (format == "etc2") return KTX_TTF_ETC;
+            if (format == "bc1" || format == "bc3") return KTX_TTF_BC1_OR_3;
+            if (format == "rgba") return KTX_TTF_RGBA32;
+        }
+
+        return KTX_TTF_RGBA32;
+    }
+
+    // transcode Basis Universal (ETC1S/UASTC) KTX2 textures to a GPU native format
+    void transcodeIfRequired(ktxTexture* texture, vsg::ref_ptr<const vsg::Options> options)
     {
+        if (texture->classId != ktxTexture2_c) return;
+
+        auto texture2 = reinterpret_cast<ktxTexture2*>(texture);
+        if (!ktxTexture2_NeedsTranscoding(texture2)) return;
+
+#ifdef vsgXchange_ktx_basis
+        if (!ktxTexture_GetData(texture) && ktxTexture_LoadImageData(texture, nullptr, 0) != KTX_SUCCESS)
+        {
+            throw vsg::Exception{"Unable to load image data."};
+        }
+
+        if (auto result = ktxTexture2_TranscodeBasis(texture2, transcodeFormat(options), 0); result != KTX_SUCCESS)
+        {
+            throw vsg::Exception{"Basis Universal transcode failed.", result};
+        }
+#else
+        (void)options;
+        throw vsg::Exception{"KTX2 file requires Basis Universal transcoding, build vsgXchange with vsgXchange_ktx_basis enabled to support it."};
+#endif
+    }
+
+    vsg::ref_ptr<vsg::Data> readKtx(ktxTexture* texture, const vsg::Path& /*filename*/, vsg::ref_ptr<const vsg::Options> options)
+    {
+        transcodeIfRequired(texture, options);
+
         uint32_t width = texture->baseWidth;
         uint32_t height = texture->baseHeight;
         uint32_t depth = texture->baseDepth;
         const auto numMipMaps = texture->numLevels;
         const auto numLayers = texture->numLayers;
-        const auto textureData = ktxTexture_GetData(texture);
+        auto textureData = ktxTexture_GetData(texture);
         const auto format = ktxTexture_GetVkFormat(texture);
 
         ktxFormatSize formatSize;
@@ -74,7 +142,6 @@ namespace
         layout.blockWidth = texture->_protected->_formatSize.blockWidth;
         layout.blockHeight = texture->_protected->_formatSize.blockHeight;
         layout.blockDepth = texture->_protected->_formatSize.blockDepth;
-        layout.maxNumMipmaps = numMipMaps;
         layout.origin = static_cast<uint8_t>(((texture->orientation.x == KTX_ORIENT_X_RIGHT) ? 0 : 1) |
                                              ((texture->orientation.y == KTX_ORIENT_Y_DOWN) ? 0 : 2) |
                                              ((texture->orientation.z == KTX_ORIENT_Z_OUT) ? 0 : 4));
@@ -83,7 +150,33 @@ namespace
         height /= layout.blockHeight;
         depth /= layout.blockDepth;
 
-        // compute the textureSize.
+        // select the range of mip levels to load, so texture streamers can bring in the low resolution levels first and refine later
+        uint32_t firstLevel = 0;
+        uint32_t numLevels = numMipMaps;
+        if (options)
+        {
+            // the images::max_texture_size common to all the image ReaderWriters applies as well as the ktx specific max_dimension
+            uint32_t maxDimension = 0;
+            options->getValue(vsgXchange::ktx::max_dimension, maxDimension);
+            if (uint32_t maxSize = maxTextureSize(options.get()); maxSize > 0 && (maxDimension == 0 || maxSize < maxDimension)) maxDimension = maxSize;
+            if (maxDimension > 0)
+            {
+                while ((firstLevel + 1) < numMipMaps && std::max({texture->baseWidth >> firstLevel, texture->baseHeight >> firstLevel, texture->baseDepth >> firstLevel}) > maxDimension) ++firstLevel;
+            }
+
+            uint32_t baseLevel = 0;
+            if (options->getValue(vsgXchange::ktx::base_level, baseLevel)) firstLevel = std::max(firstLevel, std::min(baseLevel, numMipMaps - 1));
+
+            options->getValue(vsgXchange::ktx::num_levels, numLevels);
+        }
+        numLevels = std::max(1u, std::min(numLevels, numMipMaps - firstLevel));
+
+        const bool partial = firstLevel != 0 || numLevels != numMipMaps;
+        layout.maxNumMipmaps = numLevels;
+
+        // compute the size of a face of each level, the offsets of the selected levels in the VSG layout and the textureSize.
+        std::vector<size_t> faceSizes(numMipMaps, 0);
+        std::vector<size_t> levelOffsets(numMipMaps, 0);
         size_t textureSize = 0;
         {
             auto mipWidth = width;
@@ -92,43 +185,117 @@ namespace
 
             for (uint32_t level = 0; level < numMipMaps; ++level)
             {
-                const auto faceSize = std::max(mipWidth * mipHeight * mipDepth * valueSize, valueSize);
-                textureSize += faceSize;
+                faceSizes[level] = std::max(mipWidth * mipHeight * mipDepth * valueSize, valueSize);
+
+                if (level == firstLevel)
+                {
+                    width = mipWidth;
+                    height = mipHeight;
+                    depth = mipDepth;
+                }
+
+                if (level >= firstLevel && level < (firstLevel + numLevels))
+                {
+                    levelOffsets[level] = textureSize;
+                    textureSize += faceSizes[level] * texture->numLayers * texture->numFaces;
+                }
 
                 if (mipWidth > 1) mipWidth /= 2;
                 if (mipHeight > 1) mipHeight /= 2;
                 if (mipDepth > 1) mipDepth /= 2;
             }
-            textureSize *= (texture->numLayers * texture->numFaces);
         }
 
-        // copy the data and repack into ordering assumed by VSG
-        uint8_t* copiedData = static_cast<uint8_t*>(vsg::allocate(textureSize, vsg::ALLOCATOR_AFFINITY_DATA));
+        const bool supercompressed = texture->classId == ktxTexture2_c && reinterpret_cast<ktxTexture2*>(texture)->supercompressionScheme != KTX_SS_NONE;
 
-        size_t offset = 0;
+        // single layer, non cubemap textures are usually stored in the order VSG assumes, in which case the image data can be loaded straight into the VSG allocated buffer.
+        bool matchesVSGLayout = !partial && !textureData && !supercompressed && texture->numLayers == 1 && texture->numFaces == 1 && ktxTexture_GetDataSize(texture) == textureSize;
+        for (uint32_t level = 0; level < numMipMaps && matchesVSGLayout; ++level)
+        {
+            ktx_size_t ktxOffset = 0;
+            matchesVSGLayout = ktxTexture_GetImageOffset(texture, level, 0, 0, &ktxOffset) == KTX_SUCCESS && ktxOffset == levelOffsets[level];
+        }
+
+        // when loading a subset of the levels of non cubemap textures iterate through the levels, only copying the selected ones, so the whole mip chain is never resident.
+        const bool streamLevels = partial && !textureData && texture->numFaces == 1;
 
-        auto mipWidth = width;
-        auto mipHeight = height;
-        auto mipDepth = depth;
+        // image data libktx has already loaded, such as transcoded or inflated textures, is resident alongside the copy until the ktxTexture is destroyed
+        vsgXchange::ReadMemoryReservation loadedData(textureData ? ktxTexture_GetDataSize(texture) : 0);
+        if (!loadedData) return {};
 
-        for (uint32_t level = 0; level < numMipMaps; ++level)
+        uint8_t* copiedData = static_cast<uint8_t*>(vsgXchange::allocateReadData(textureSize));
+        if (!copiedData) return {};
+
+        if (matchesVSGLayout)
+        {
+            if (ktxTexture_LoadImageData(texture, copiedData, textureSize) != KTX_SUCCESS)
+            {
+                vsg::deallocate(copiedData);
+                throw vsg::Exception{"Unable to load image data."};
+            }
+        }
+        else if (streamLevels)
         {
-            const auto faceSize = std::max(mipWidth * mipHeight * mipDepth * valueSize, valueSize);
-            for (uint32_t layer = 0; layer < texture->numLayers; ++layer)
+            struct LevelSelection
             {
-                for (uint32_t face = 0; face < texture->numFaces; ++face)
+                uint8_t* dest;
+                uint32_t firstLevel;
+                uint32_t numLevels;
+                const std::vector<size_t>* faceSizes;
+                const std::vector<size_t>* levelOffsets;
+                uint32_t numLayers;
+
+                size_t levelSize(uint32_t level) const { return (*faceSizes)[level] * numLayers; }
+            };
+
+            LevelSelection selection{copiedData, firstLevel, numLevels, &faceSizes, &levelOffsets, texture->numLayers};
+
+            auto copyLevel = [](int miplevel, int /*face*/, int /*width*/, int /*height*/, int /*depth*/, ktx_uint64_t faceLodSize, void* pixels, void* userdata) -> KTX_error_code {
+                auto& levels = *static_cast<LevelSelection*>(userdata);
+                auto level = static_cast<uint32_t>(miplevel);
+                if (level >= levels.firstLevel && level < (levels.firstLevel + levels.numLevels))
                 {
-                    if (ktx_size_t ktxOffset = 0; ktxTexture_GetImageOffset(texture, level, layer, face, &ktxOffset) == KTX_SUCCESS)
+                    std::memcpy(levels.dest + (*levels.levelOffsets)[level], pixels, std::min(static_cast<size_t>(faceLodSize), levels.levelSize(level)));
+                }
+                return KTX_SUCCESS;
+            };
+
+            if (ktxTexture_IterateLoadLevelFaces(texture, copyLevel, &selection) != KTX_SUCCESS)
+            {
+                vsg::deallocate(copiedData);
+                throw vsg::Exception{"Unable to load image data."};
+            }
+        }
+        else
+        {
+            if (!textureData)
+            {
+                if (ktxTexture_LoadImageData(texture, nullptr, 0) != KTX_SUCCESS)
+                {
+                    vsg::deallocate(copiedData);
+                    throw vsg::Exception{"Unable to load image data."};
+                }
+                textureData = ktxTexture_GetData(texture);
+            }
+
+            // copy the data of the selected levels and repack into ordering assumed by VSG
+            for (uint32_t level = firstLevel; level < (firstLevel + numLevels); ++level)
+            {
+                const auto faceSize = faceSizes[level];
+                size_t offset = levelOffsets[level];
+                for (uint32_t layer = 0; layer < texture->numLayers; ++layer)
+                {
+                    for (uint32_t face = 0; face < texture->numFaces; ++face)
                     {
-                        std::memcpy(copiedData + offset, textureData + ktxOffset, faceSize);
-                    }
+                        if (ktx_size_t ktxOffset = 0; ktxTexture_GetImageOffset(texture, level, layer, face, &ktxOffset) == KTX_SUCCESS)
+                        {
+                            std::memcpy(copiedData + offset, textureData + ktxOffset, faceSize);
+                        }
 
-                    offset += faceSize;
+                        offset += faceSize;
+                    }
                 }
             }
-            if (mipWidth > 1) mipWidth /= 2;
-            if (mipHeight > 1) mipHeight /= 2;
-            if (mipDepth > 1) mipDepth /= 2;
         }
 
         uint32_t arrayDimensions = 0;
@@ -230,6 +397,251 @@ namespace
         return {};
     }
 
+    // read the texture and adapt it to the target device, decoding block compressed formats it doesn't support and downscaling to the max_texture_size
+    vsg::ref_ptr<vsg::Data> readImage(ktxTexture* texture, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options)
+    {
+        auto image = decompressUnsupportedFormat(readKtx(texture, filename, options), options.get());
+        return downsampleImage(image, maxTextureSize(options.get()));
+    }
+
+    template<typename T>
+    void writeValue(std::ostream& fout, T value)
+    {
+        // KTX2 files are little endian
+        uint8_t bytes[sizeof(T)];
+        for (size_t i = 0; i < sizeof(T); ++i) bytes[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (i * 8));
+        fout.write(reinterpret_cast<const char*>(bytes), sizeof(T));
+    }
+
+    void writePadding(std::ostream& fout, size_t numBytes)
+    {
+        static const char zeros[16] = {};
+        for (; numBytes > sizeof(zeros); numBytes -= sizeof(zeros)) fout.write(zeros, sizeof(zeros));
+        fout.write(zeros, numBytes);
+    }
+
+    size_t alignTo(size_t value, size_t alignment)
+    {
+        return ((value + alignment - 1) / alignment) * alignment;
+    }
+
+    struct LevelData
+    {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        size_t uncompressedSize = 0;
+        size_t offset = 0;
+        std::vector<uint8_t> compressed;
+    };
+
+    // write a vsg::Data, including the mipmaps, layers and cubemap faces described by its Data::Properties, as a KTX2 file
+    void writeKtx2(const vsg::Data* data, std::ostream& fout, vsg::ref_ptr<const vsg::Options> options)
+    {
+        const auto& layout = data->properties;
+        if (layout.format == VK_FORMAT_UNDEFINED) throw vsg::Exception{"vsg::Data has no VkFormat assigned."};
+
+        auto imageViewType = layout.imageViewType;
+        if (imageViewType == VK_IMAGE_VIEW_TYPE_MAX_ENUM)
+        {
+            switch (data->dimensions())
+            {
+            case 1: imageViewType = VK_IMAGE_VIEW_TYPE_1D; break;
+            case 2: imageViewType = VK_IMAGE_VIEW_TYPE_2D; break;
+            default: imageViewType = VK_IMAGE_VIEW_TYPE_3D; break;
+            }
+        }
+
+        ktxTextureCreateInfo createInfo{};
+        createInfo.vkFormat = layout.format;
+        createInfo.baseWidth = data->width() * layout.blockWidth;
+        createInfo.baseHeight = data->height() * layout.blockHeight;
+        createInfo.baseDepth = 1;
+        createInfo.numDimensions = 2;
+        createInfo.numLevels = std::max(1u, static_cast<uint32_t>(layout.maxNumMipmaps));
+        createInfo.numLayers = 1;
+        createInfo.numFaces = 1;
+        createInfo.isArray = KTX_FALSE;
+        createInfo.generateMipmaps = KTX_FALSE;
+
+        switch (imageViewType)
+        {
+        case VK_IMAGE_VIEW_TYPE_1D:
+            createInfo.numDimensions = 1;
+            createInfo.baseHeight = 1;
+            break;
+        case VK_IMAGE_VIEW_TYPE_1D_ARRAY:
+            createInfo.numDimensions = 1;
+            createInfo.baseHeight = 1;
+            createInfo.numLayers = data->height();
+            createInfo.isArray = KTX_TRUE;
+            break;
+        case VK_IMAGE_VIEW_TYPE_2D:
+            break;
+        case VK_IMAGE_VIEW_TYPE_2D_ARRAY:
+            createInfo.numLayers = data->depth();
+            createInfo.isArray = KTX_TRUE;
+            break;
+        case VK_IMAGE_VIEW_TYPE_CUBE:
+        case VK_IMAGE_VIEW_TYPE_CUBE_ARRAY:
+            if (data->depth() == 0 || (data->depth() % 6) != 0) throw vsg::Exception{"Cubemap vsg::Data depth is not a multiple of 6."};
+            createInfo.numFaces = 6;
+            createInfo.numLayers = data->depth() / 6;
+            createInfo.isArray = (imageViewType == VK_IMAGE_VIEW_TYPE_CUBE_ARRAY) ? KTX_TRUE : KTX_FALSE;
+            break;
+        case VK_IMAGE_VIEW_TYPE_3D:
+            createInfo.numDimensions = 3;
+            createInfo.baseDepth = data->depth() * layout.blockDepth;
+            break;
+        default:
+            throw vsg::Exception{"Unsupported imageViewType."};
+        }
+
+        // use libktx to set up the DFD, typeSize and image sizes for the format, the image data itself is written directly from the vsg::Data
+        ktxTexture2* createdTexture = nullptr;
+        if (auto result = ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_NO_STORAGE, &createdTexture); result != KTX_SUCCESS)
+        {
+            throw vsg::Exception{"Unable to create KTX2 texture, VkFormat or dimensions not supported.", result};
+        }
+        std::unique_ptr<ktxTexture2, decltype(&ktxTexture2_Destroy)> texture(createdTexture, &ktxTexture2_Destroy);
+
+        uint32_t zstdLevel = 0;
+        if (options) options->getValue(vsgXchange::ktx::zstd_level, zstdLevel);
+#ifndef vsgXchange_ktx_zstd
+        if (zstdLevel > 0)
+        {
+            vsg::warn("ktx::write() zstd supercompression not supported, build vsgXchange with zstd to enable it. Writing uncompressed KTX2.");
+            zstdLevel = 0;
+        }
+#endif
+
+        // vsg::Data stores the levels one after another, each level containing all the layers/faces, which matches the level order of KTX2 images
+        const auto numLevels = texture->numLevels;
+        const size_t imagesPerLevel = texture->numLayers * texture->numFaces;
+        auto source = static_cast<const uint8_t*>(data->dataPointer());
+
+        std::vector<LevelData> levels(numLevels);
+        size_t sourceOffset = 0;
+        for (uint32_t level = 0; level < numLevels; ++level)
+        {
+            auto& levelData = levels[level];
+            levelData.uncompressedSize = ktxTexture_GetImageSize(ktxTexture(texture.get()), level) * std::max(1u, createInfo.baseDepth >> level) * imagesPerLevel;
+            levelData.data = source + sourceOffset;
+            levelData.size = levelData.uncompressedSize;
+            sourceOffset += levelData.uncompressedSize;
+        }
+
+        if (sourceOffset > data->dataSize()) throw vsg::Exception{"vsg::Data is smaller than the mipmap levels its Data::Properties describe."};
+
+#ifdef vsgXchange_ktx_zstd
+        if (zstdLevel > 0)
+        {
+            for (auto& levelData : levels)
+            {
+                levelData.compressed.resize(ZSTD_compressBound(levelData.uncompressedSize));
+                auto compressedSize = ZSTD_compress(levelData.compressed.data(), levelData.compressed.size(), levelData.data, levelData.uncompressedSize, static_cast<int>(zstdLevel));
+                if (ZSTD_isError(compressedSize)) throw vsg::Exception{std::string("zstd supercompression failed : ") + ZSTD_getErrorName(compressedSize)};
+
+                levelData.compressed.resize(compressedSize);
+                levelData.data = levelData.compressed.data();
+                levelData.size = compressedSize;
+            }
+        }
+#endif
+        const bool supercompressed = zstdLevel > 0;
+
+        // key/value data, keys in sorted order
+        std::string orientation = (layout.origin & 1) ? "l" : "r";
+        if (createInfo.numDimensions > 1) orientation += (layout.origin & 2) ? "u" : "d";
+        if (createInfo.numDimensions > 2) orientation += (layout.origin & 4) ? "i" : "o";
+
+        const std::pair<std::string, std::string> keyValues[] = {{"KTXorientation", orientation}, {"KTXwriter", "vsgXchange"}};
+
+        size_t kvdSize = 0;
+        for (auto& [key, value] : keyValues) kvdSize += alignTo(sizeof(uint32_t) + key.size() + 1 + value.size() + 1, 4);
+
+        // file layout
+        const uint32_t dfdSize = texture->pDfd[0];
+        const size_t levelIndexOffset = 80;
+        const size_t dfdOffset = levelIndexOffset + numLevels * 3 * sizeof(uint64_t);
+        const size_t kvdOffset = dfdOffset + dfdSize;
+
+        // uncompressed levels are aligned to the least common multiple of the texel block size and 4
+        size_t levelAlignment = 1;
+        if (!supercompressed)
+        {
+            const size_t blockSize = std::max(1u, texture->_protected->_formatSize.blockSizeInBits / 8);
+            levelAlignment = blockSize;
+            while ((levelAlignment % 4) != 0) levelAlignment += blockSize;
+        }
+
+        // levels are stored smallest first
+        size_t offset = kvdOffset + kvdSize;
+        for (uint32_t level = numLevels; level-- > 0;)
+        {
+            offset = alignTo(offset, levelAlignment);
+            levels[level].offset = offset;
+            offset += levels[level].size;
+        }
+
+        // header
+        static const uint8_t identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+        fout.write(reinterpret_cast<const char*>(identifier), sizeof(identifier));
+        writeValue<uint32_t>(fout, texture->vkFormat);
+        writeValue<uint32_t>(fout, texture->_protected->_typeSize);
+        writeValue<uint32_t>(fout, createInfo.baseWidth);
+        writeValue<uint32_t>(fout, createInfo.numDimensions > 1 ? createInfo.baseHeight : 0);
+        writeValue<uint32_t>(fout, createInfo.numDimensions > 2 ? createInfo.baseDepth : 0);
+        writeValue<uint32_t>(fout, createInfo.isArray ? createInfo.numLayers : 0);
+        writeValue<uint32_t>(fout, createInfo.numFaces);
+        writeValue<uint32_t>(fout, numLevels);
+        writeValue<uint32_t>(fout, supercompressed ? KTX_SS_ZSTD : KTX_SS_NONE);
+        writeValue<uint32_t>(fout, static_cast<uint32_t>(dfdOffset));
+        writeValue<uint32_t>(fout, dfdSize);
+        writeValue<uint32_t>(fout, static_cast<uint32_t>(kvdOffset));
+        writeValue<uint32_t>(fout, static_cast<uint32_t>(kvdSize));
+        writeValue<uint64_t>(fout, 0); // no supercompression global data
+        writeValue<uint64_t>(fout, 0);
+
+        // level index
+        for (auto& levelData : levels)
+        {
+            writeValue<uint64_t>(fout, levelData.offset);
+            writeValue<uint64_t>(fout, levelData.size);
+            writeValue<uint64_t>(fout, supercompressed ? levelData.uncompressedSize : levelData.size);
+        }
+
+        // data format descriptor, generated in native endian so written as is, other than supercompressed textures requiring bytesPlane0..7 of the basic block to be zero
+        std::vector<uint32_t> dfd(texture->pDfd, texture->pDfd + dfdSize / sizeof(uint32_t));
+        if (supercompressed)
+        {
+            uint32_t* bdb = dfd.data() + 1;
+            bdb[KHR_DF_WORD_BYTESPLANE0] = 0;
+            bdb[KHR_DF_WORD_BYTESPLANE4] = 0;
+        }
+        fout.write(reinterpret_cast<const char*>(dfd.data()), dfdSize);
+
+        // key/value data
+        for (auto& [key, value] : keyValues)
+        {
+            const size_t length = key.size() + 1 + value.size() + 1;
+            writeValue<uint32_t>(fout, static_cast<uint32_t>(length));
+            fout.write(key.c_str(), key.size() + 1);
+            fout.write(value.c_str(), value.size() + 1);
+            writePadding(fout, alignTo(length, 4) - length);
+        }
+
+        // image data
+        offset = kvdOffset + kvdSize;
+        for (uint32_t level = numLevels; level-- > 0;)
+        {
+            writePadding(fout, levels[level].offset - offset);
+            fout.write(reinterpret_cast<const char*>(levels[level].data), levels[level].size);
+            offset = levels[level].offset + levels[level].size;
+        }
+
+        if (!fout) throw vsg::Exception{"Error writing KTX2 data to stream."};
+    }
+
 } // namespace
 
 using namespace vsgXchange;
@@ -246,20 +658,32 @@ vsg::ref_ptr<vsg::Object> ktx::read(const vsg::Path& filename, vsg::ref_ptr<cons
     vsg::Path filenameToUse = vsg::findFile(filename, options);
     if (!filenameToUse) return {};
 
-    auto file = vsg::fopen(filenameToUse, "rb");
-    if (!file) return {};
-
     ktxTexture* texture = nullptr;
-    auto result = ktxTexture_CreateFromStdioStream(file, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &texture);
+    KTX_error_code result = KTX_FILE_OPEN_FAILED;
 
-    fclose(file);
+    // the image data is loaded by readKtx() so the mapping/file must remain valid until it has completed
+    FILE* file = nullptr;
+    vsgXchange::MappedFile mappedFile(filenameToUse);
 
+    // load directly from a memory mapping of the file, falling back to stdio when the file can't be mapped
+    if (mappedFile)
+    {
+        result = ktxTexture_CreateFromMemory(mappedFile.data(), mappedFile.size(), KTX_TEXTURE_CREATE_NO_FLAGS, &texture);
+    }
+    else
+    {
+        file = vsg::fopen(filenameToUse, "rb");
+        if (!file) return {};
+
+        result = ktxTexture_CreateFromStdioStream(file, KTX_TEXTURE_CREATE_NO_FLAGS, &texture);
+    }
+
+    vsg::ref_ptr<vsg::Data> data;
     if (result == KTX_SUCCESS)
     {
-        vsg::ref_ptr<vsg::Data> data;
         try
         {
-            data = readKtx(texture, filename);
+            data = readImage(texture, filename, options);
         }
         catch (const vsg::Exception& ve)
         {
@@ -267,33 +691,26 @@ vsg::ref_ptr<vsg::Object> ktx::read(const vsg::Path& filename, vsg::ref_ptr<cons
         }
 
         ktxTexture_Destroy(texture);
-
-        return data;
     }
 
-    return {};
+    if (file) fclose(file);
+
+    return data;
 }
 
 vsg::ref_ptr<vsg::Object> ktx::read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options) const
 {
     if (!vsg::compatibleExtension(options, _supportedExtensions)) return {};
 
-    std::string buffer(1 << 16, 0); // 64kB
-    std::string input;
+    vsgXchange::StreamData input;
+    if (!vsgXchange::readStream(fin, input)) return {};
 
-    while (!fin.eof())
-    {
-        fin.read(&buffer[0], buffer.size());
-        const auto bytes_readed = fin.gcount();
-        input.append(&buffer[0], bytes_readed);
-    }
-
-    if (ktxTexture * texture{nullptr}; ktxTexture_CreateFromMemory((const ktx_uint8_t*)input.data(), input.size(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &texture) == KTX_SUCCESS)
+    if (ktxTexture * texture{nullptr}; ktxTexture_CreateFromMemory(input.data, input.size, KTX_TEXTURE_CREATE_NO_FLAGS, &texture) == KTX_SUCCESS)
     {
         vsg::ref_ptr<vsg::Data> data;
         try
         {
-            data = readKtx(texture, "");
+            data = readImage(texture, "", options);
         }
         catch (const vsg::Exception& ve)
         {
@@ -313,12 +730,12 @@ vsg::ref_ptr<vsg::Object> ktx::read(const uint8_t* ptr, size_t size, vsg::ref_pt
     if (!vsg::compatibleExtension(options, _supportedExtensions)) return {};
 
     ktxTexture* texture = nullptr;
-    if (ktxTexture_CreateFromMemory(ptr, size, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &texture) == KTX_SUCCESS)
+    if (ktxTexture_CreateFromMemory(ptr, size, KTX_TEXTURE_CREATE_NO_FLAGS, &texture) == KTX_SUCCESS)
     {
         vsg::ref_ptr<vsg::Data> data;
         try
         {
-            data = readKtx(texture, "");
+            data = readImage(texture, "", options);
         }
         catch (const vsg::Exception& ve)
         {
@@ -333,11 +750,77 @@ vsg::ref_ptr<vsg::Object> ktx::read(const uint8_t* ptr, size_t size, vsg::ref_pt
     return {};
 }
 
+bool ktx::write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    // only the KTX2 container is written
+    if (vsg::lowerCaseFileExtension(filename) != ".ktx2") return false;
+
+    auto data = object ? object->cast<vsg::Data>() : nullptr;
+    if (!data) return false;
+
+    std::ofstream fout(filename, std::ios::out | std::ios::binary);
+    if (!fout) return false;
+
+    try
+    {
+        writeKtx2(data, fout, options);
+        return true;
+    }
+    catch (const vsg::Exception& ve)
+    {
+        std::cout << "ktx::write(" << filename << ") failed : " << ve.message << std::endl;
+    }
+
+    return false;
+}
+
+bool ktx::write(const vsg::Object* object, std::ostream& fout, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!options || options->extensionHint != ".ktx2") return false;
+
+    auto data = object ? object->cast<vsg::Data>() : nullptr;
+    if (!data) return false;
+
+    try
+    {
+        writeKtx2(data, fout, options);
+        return true;
+    }
+    catch (const vsg::Exception& ve)
+    {
+        std::cout << "ktx::write(std::ostream&) failed : " << ve.message << std::endl;
+    }
+
+    return false;
+}
+
 bool ktx::getFeatures(Features& features) const
 {
     for (auto& ext : _supportedExtensions)
     {
         features.extensionFeatureMap[ext] = static_cast<vsg::ReaderWriter::FeatureMask>(vsg::ReaderWriter::READ_FILENAME | vsg::ReaderWriter::READ_ISTREAM | vsg::ReaderWriter::READ_MEMORY);
     }
+    features.extensionFeatureMap[".ktx2"] = static_cast<vsg::ReaderWriter::FeatureMask>(features.extensionFeatureMap[".ktx2"] | vsg::ReaderWriter::WRITE_FILENAME | vsg::ReaderWriter::WRITE_OSTREAM);
+
+    features.optionNameTypeMap[ktx::transcode_formats] = vsg::type_name<std::string>();
+    features.optionNameTypeMap[ktx::base_level] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[ktx::num_levels] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[ktx::max_dimension] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[ktx::zstd_level] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[images::max_texture_size] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[images::supported_compressed_formats] = vsg::type_name<std::string>();
+
     return true;
 }
+
+bool ktx::readOptions(vsg::Options& options, vsg::CommandLine& arguments) const
+{
+    bool result = arguments.readAndAssign<std::string>(ktx::transcode_formats, &options);
+    result = arguments.readAndAssign<uint32_t>(ktx::base_level, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(ktx::num_levels, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(ktx::max_dimension, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(ktx::zstd_level, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(images::max_texture_size, &options) || result;
+    result = arguments.readAndAssign<std::string>(images::supported_compressed_formats, &options) || result;
+    return result;
+}
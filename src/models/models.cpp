@@ -16,6 +16,10 @@ using namespace vsgXchange;
 
 models::models()
 {
+    // the native glTF ReaderWriter leaves the files using features it doesn't support to assimp
+    add(gltf::create());
+    add(pointcloud::create());
+
 #ifdef vsgXchange_assimp
     add(assimp::create());
 #endif
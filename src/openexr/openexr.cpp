@@ -10,16 +10,29 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+#include <vsg/core/Objects.h>
 #include <vsg/io/FileSystem.h>
 #include <vsg/io/stream.h>
 #include <vsgXchange/images.h>
 
+#include "../all/image_downsample.h"
+#include "../all/stream_utils.h"
+
 #include <OpenEXR/ImfChannelList.h>
 #include <OpenEXR/ImfFrameBuffer.h>
 #include <OpenEXR/ImfInputFile.h>
 #include <OpenEXR/ImfOutputFile.h>
 #include <OpenEXR/ImfRgbaFile.h>
+#include <OpenEXR/ImfTestFile.h>
+#include <OpenEXR/ImfThreading.h>
+#include <OpenEXR/ImfTiledInputFile.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <string>
+#include <vector>
 #ifdef EXRVERSION3
 #    include <Imath/half.h>
 #    include <ImfInt64.h>
@@ -32,32 +45,6 @@ using namespace vsgXchange;
 namespace
 {
 
-    class CPP_IStream : public Imf::IStream
-    {
-    public:
-        CPP_IStream(std::istream& file, const char fileName[]) :
-            IStream(fileName), _file(file) {}
-        virtual bool read(char c[], int n)
-        {
-            _file.read(c, n);
-            return !_file.eof();
-        };
-        virtual uint64_t tellg()
-        {
-            return _file.tellg();
-        };
-        virtual void seekg(uint64_t pos)
-        {
-            _file.seekg(pos);
-        };
-        virtual void clear()
-        {
-            _file.clear();
-        };
-
-    private:
-        std::istream& _file;
-    };
     class CPP_OStream : public Imf::OStream
     {
     public:
@@ -83,28 +70,41 @@ namespace
     private:
         std::ostream& _file;
     };
+    /// Imf::IStream that reads from a block of memory, implementing the memory mapped interface so OpenEXR can decode directly from the block without copying it.
     class Array_IStream : public Imf::IStream
     {
     public:
         Array_IStream(const uint8_t* in_data, size_t in_size, const char fileName[]) :
             IStream(fileName), data(in_data), size(in_size), curPlace(0) {}
+        virtual bool isMemoryMapped() const
+        {
+            return true;
+        }
+        virtual char* readMemoryMapped(int n)
+        {
+            if (n < 0 || curPlace + n > size)
+                throw Iex::InputExc("Unexpected end of file.");
+            auto ptr = reinterpret_cast<char*>(const_cast<uint8_t*>(data + curPlace));
+            curPlace += n;
+            return ptr;
+        }
         virtual bool read(char c[], int n)
         {
-            if (curPlace + n > size)
+            if (n < 0 || curPlace + n > size)
                 throw Iex::InputExc("Unexpected end of file.");
-            std::copy_n(data + curPlace, n, c);
+            std::memcpy(c, data + curPlace, n);
             curPlace += n;
             return curPlace != size;
-        };
+        }
         virtual uint64_t tellg()
         {
             return curPlace;
-        };
+        }
         virtual void seekg(uint64_t pos)
         {
             curPlace = pos;
-        };
-        virtual void clear() {};
+        }
+        virtual void clear() {}
 
     private:
         const uint8_t* data;
@@ -112,192 +112,328 @@ namespace
         size_t curPlace;
     };
 
-    static vsg::ref_ptr<vsg::Object> parseOpenExr(Imf::InputFile& file)
+    /// settings for reading an OpenEXR file, taken from the vsg::Options
+    struct ReadSettings
     {
-        Imath::Box2i dw = file.header().dataWindow();
-
-        int max_valid_value = 32768;
-        int width = dw.max.x - dw.min.x + 1;
-        int height = dw.max.y - dw.min.y + 1;
-        if (std::abs(dw.max.x) > max_valid_value || std::abs(dw.max.x) > max_valid_value || std::abs(width) > max_valid_value || std::abs(height) > max_valid_value)
+        int numThreads;
+        bool hasWindow = false;
+        bool hasLevel = false;
+        vsg::ivec4 window;
+        vsg::ivec2 level;
+        uint32_t maxTextureSize = 0;
+
+        explicit ReadSettings(const vsg::Options* options)
         {
-            return vsg::ReadError::create("OpenEXR dataWindow out of bounds");
-        }
+            numThreads = Imf::globalThreadCount();
 
-        int channelCount = 0;
-        auto type = file.header().channels().begin().channel().type;
-        for (auto itr = file.header().channels().begin(); itr != file.header().channels().end(); ++itr)
-        {
-            ++channelCount;
-            if (type != itr.channel().type)
+            uint32_t requestedThreads = 0;
+            if (options && options->getValue(openexr::num_threads, requestedThreads) && requestedThreads > 0)
             {
-                // types not consistent, only consistent type channels are supported so return a null ref_ptr<>.
-                return {};
+                // the file's line buffers and tiles are decoded by the global thread pool, so make sure it's large enough
+                numThreads = static_cast<int>(requestedThreads);
+                if (Imf::globalThreadCount() < numThreads) Imf::setGlobalThreadCount(numThreads);
             }
-        }
 
-        if (channelCount == 1)
-        {
-            vsg::ref_ptr<vsg::Data> image;
-            if (type == Imf::HALF)
-            {
-                // single element half precision float
-                image = vsg::ushortArray2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R16_SFLOAT});
-            }
-            else if (type == Imf::FLOAT)
+            if (options)
             {
-                // single element single precision float
-                image = vsg::floatArray2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32_SFLOAT});
+                hasWindow = options->getValue(openexr::window, window);
+                hasLevel = options->getValue(openexr::level, level);
             }
-            else if (type == Imf::UINT)
+            maxTextureSize = vsgXchange::maxTextureSize(options);
+        }
+    };
+
+    static vsg::ref_ptr<vsg::Data> createImage(Imf::PixelType type, int channelCount, uint32_t width, uint32_t height)
+    {
+        switch (channelCount)
+        {
+        case (1):
+            if (type == Imf::HALF) return vsg::ushortArray2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R16_SFLOAT});
+            if (type == Imf::FLOAT) return vsg::floatArray2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32_SFLOAT});
+            if (type == Imf::UINT) return vsg::uintArray2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32_UINT});
+            break;
+        case (2):
+            if (type == Imf::HALF) return vsg::usvec2Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R16G16_SFLOAT});
+            if (type == Imf::FLOAT) return vsg::vec2Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32_SFLOAT});
+            if (type == Imf::UINT) return vsg::uivec2Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32_UINT});
+            break;
+        case (3):
+            if (type == Imf::HALF) return vsg::usvec3Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R16G16B16_SFLOAT});
+            if (type == Imf::FLOAT) return vsg::vec3Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32B32_SFLOAT});
+            if (type == Imf::UINT) return vsg::uivec3Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32B32_UINT});
+            break;
+        case (4):
+            if (type == Imf::HALF) return vsg::usvec4Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R16G16B16A16_SFLOAT});
+            if (type == Imf::FLOAT) return vsg::vec4Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32B32A32_SFLOAT});
+            if (type == Imf::UINT) return vsg::uivec4Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32B32A32_UINT});
+            break;
+        default:
+            break;
+        }
+        return {};
+    }
+
+    /// channels of the same layer and pixel type that are loaded into a single vsg::Data.
+    struct ChannelGroup
+    {
+        std::string layer;
+        Imf::PixelType type;
+        std::vector<std::string> names;
+
+        vsg::ref_ptr<vsg::Data> image;
+        std::vector<char> scratch;
+    };
+
+    /// group the channels by layer and pixel type, in R, G, B, A order where the channels are named that way, and in groups of up to 4 channels.
+    static std::vector<ChannelGroup> groupChannels(const Imf::ChannelList& channels)
+    {
+        std::vector<ChannelGroup> groups;
+        auto componentIndex = [](const std::string& name) -> int {
+            static const std::string components[] = {"R", "G", "B", "A"};
+            auto base = name.substr(name.find_last_of('.') + 1);
+            for (int i = 0; i < 4; ++i)
             {
-                // single element single precision uint
-                image = vsg::uintArray2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32_UINT});
+                if (base == components[i]) return i;
             }
+            return 4;
+        };
 
-            if (image)
+        // channels are listed in alphabetical order so members of a layer are adjacent
+        for (auto itr = channels.begin(); itr != channels.end(); ++itr)
+        {
+            std::string name = itr.name();
+            if (itr.channel().xSampling != 1 || itr.channel().ySampling != 1)
             {
-                auto valueSize = image->valueSize();
-                auto name = file.header().channels().begin().name();
+                std::cout << "openexr::read() subsampled channel " << name << " not supported, ignoring channel." << std::endl;
+                continue;
+            }
 
-                Imf::FrameBuffer frameBuffer;
-                frameBuffer.insert(name, Imf::Slice(type, reinterpret_cast<char*>(image->dataPointer()) - valueSize * (dw.min.x + dw.min.y * width), valueSize, valueSize * width));
+            auto dot = name.find_last_of('.');
+            std::string layer = (dot == std::string::npos) ? std::string() : name.substr(0, dot);
+            auto type = itr.channel().type;
 
-                file.setFrameBuffer(frameBuffer);
-                file.readPixels(dw.min.y, dw.max.y);
+            auto group = std::find_if(groups.begin(), groups.end(), [&](const ChannelGroup& g) { return g.layer == layer && g.type == type && g.names.size() < 4; });
+            if (group == groups.end()) group = groups.insert(groups.end(), ChannelGroup{layer, type, {}, {}, {}});
+            group->names.push_back(name);
+        }
 
-                return image;
-            }
+        for (auto& group : groups)
+        {
+            std::stable_sort(group.names.begin(), group.names.end(), [&](const std::string& lhs, const std::string& rhs) { return componentIndex(lhs) < componentIndex(rhs); });
         }
-        else if (channelCount == 2)
+
+        return groups;
+    }
+
+    /// read the window of the specified data window into vsg::Data, one for each group of channels, all decoded in a single pass.
+    /// The channels are grouped by layer and pixel type, when there is just one group its vsg::Data is returned, otherwise a vsg::Objects containing
+    /// a vsg::Data for each group, with the "layer" and "channels" values assigned, is returned.
+    /// readBox is the region that the decoder will write to, covering the window and extended to whole scanlines or tiles,
+    /// readRegion(frameBuffer) decodes readBox, and when it is larger than the window it's decoded into scratch memory and the window is copied out of it.
+    template<typename ReadRegion>
+    vsg::ref_ptr<vsg::Object> parseOpenExr(const Imf::Header& header, const Imath::Box2i& window, const Imath::Box2i& readBox, ReadRegion readRegion)
+    {
+        int width = window.max.x - window.min.x + 1;
+        int height = window.max.y - window.min.y + 1;
+
+        auto groups = groupChannels(header.channels());
+        if (groups.empty()) return {};
+
+        bool directRead = (readBox.min.x == window.min.x && readBox.max.x == window.max.x && readBox.min.y == window.min.y && readBox.max.y == window.max.y);
+        size_t readWidth = static_cast<size_t>(readBox.max.x - readBox.min.x + 1);
+        size_t readHeight = static_cast<size_t>(readBox.max.y - readBox.min.y + 1);
+
+        Imf::FrameBuffer frameBuffer;
+        for (auto& group : groups)
         {
-            vsg::ref_ptr<vsg::Data> image;
-            size_t componentSize = 0;
-            if (type == Imf::HALF)
-            {
-                // single element half precision float
-                image = vsg::usvec2Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R16G16_SFLOAT});
-                componentSize = 2;
-            }
-            else if (type == Imf::FLOAT)
-            {
-                // single element single precision float
-                image = vsg::vec2Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32_SFLOAT});
-                componentSize = 4;
-            }
-            else if (type == Imf::UINT)
+            group.image = createImage(group.type, static_cast<int>(group.names.size()), width, height);
+            if (!group.image)
             {
-                // single element single precision uint
-                image = vsg::uivec2Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32_UINT});
-                componentSize = 4;
+                std::cout << "Unsupported channelCount = " << group.names.size() << std::endl;
+                return {};
             }
 
-            if (image)
-            {
-                auto valueSize = image->valueSize();
-                char* ptr = reinterpret_cast<char*>(image->dataPointer()) - valueSize * (dw.min.x + dw.min.y * width);
+            size_t valueSize = group.image->valueSize();
+            size_t componentSize = (group.type == Imf::HALF) ? 2 : 4;
 
-                Imf::FrameBuffer frameBuffer;
-                frameBuffer.insert("R", Imf::Slice(type, ptr + 0 * componentSize, valueSize, valueSize * width));
-                frameBuffer.insert("G", Imf::Slice(type, ptr + 1 * componentSize, valueSize, valueSize * width));
+            if (!directRead) group.scratch.resize(readWidth * readHeight * valueSize);
 
-                file.setFrameBuffer(frameBuffer);
-                file.readPixels(dw.min.y, dw.max.y);
+            char* target = directRead ? reinterpret_cast<char*>(group.image->dataPointer()) : group.scratch.data();
+            size_t rowStride = valueSize * readWidth;
+            char* ptr = target - valueSize * readBox.min.x - rowStride * readBox.min.y;
 
-                return image;
+            for (size_t c = 0; c < group.names.size(); ++c)
+            {
+                frameBuffer.insert(group.names[c], Imf::Slice(group.type, ptr + c * componentSize, valueSize, rowStride));
             }
         }
-        else if (channelCount == 3)
+
+        readRegion(frameBuffer);
+
+        for (auto& group : groups)
         {
-            vsg::ref_ptr<vsg::Data> image;
-            size_t componentSize = 0;
-            if (type == Imf::HALF)
+            if (directRead) continue;
+
+            size_t valueSize = group.image->valueSize();
+            size_t rowStride = valueSize * readWidth;
+            size_t windowRowSize = valueSize * width;
+            size_t offset = valueSize * (window.min.x - readBox.min.x) + rowStride * (window.min.y - readBox.min.y);
+            auto dest = reinterpret_cast<char*>(group.image->dataPointer());
+            for (int r = 0; r < height; ++r)
             {
-                // single element half precision float
-                image = vsg::usvec3Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R16G16B16_SFLOAT});
-                componentSize = 2;
+                std::memcpy(dest + r * windowRowSize, group.scratch.data() + offset + r * rowStride, windowRowSize);
             }
-            else if (type == Imf::FLOAT)
-            {
-                // single element single precision float
-                image = vsg::vec3Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32B32_SFLOAT});
-                componentSize = 4;
-            }
-            else if (type == Imf::UINT)
+        }
+
+        if (groups.size() == 1) return groups.front().image;
+
+        auto objects = vsg::Objects::create();
+        for (auto& group : groups)
+        {
+            std::string channelNames;
+            for (auto& name : group.names)
             {
-                // single element single precision uint
-                image = vsg::uivec3Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32B32_UINT});
-                componentSize = 4;
+                if (!channelNames.empty()) channelNames += ",";
+                channelNames += name;
             }
 
-            if (image)
-            {
-                auto valueSize = image->valueSize();
-                char* ptr = reinterpret_cast<char*>(image->dataPointer()) - valueSize * (dw.min.x + dw.min.y * width);
+            group.image->setValue("layer", group.layer);
+            group.image->setValue("channels", channelNames);
+            objects->children.push_back(group.image);
+        }
+        return objects;
+    }
 
-                Imf::FrameBuffer frameBuffer;
-                frameBuffer.insert("R", Imf::Slice(type, ptr + 0 * componentSize, valueSize, valueSize * width));
-                frameBuffer.insert("G", Imf::Slice(type, ptr + 1 * componentSize, valueSize, valueSize * width));
-                frameBuffer.insert("B", Imf::Slice(type, ptr + 2 * componentSize, valueSize, valueSize * width));
+    /// compute the region of the dataWindow to read, returning false if it's empty.
+    static bool computeWindow(const Imath::Box2i& dataWindow, const ReadSettings& settings, Imath::Box2i& window)
+    {
+        window = dataWindow;
+        if (settings.hasWindow)
+        {
+            window.min.x = std::max(dataWindow.min.x, settings.window[0]);
+            window.min.y = std::max(dataWindow.min.y, settings.window[1]);
+            window.max.x = std::min(dataWindow.max.x, settings.window[0] + settings.window[2] - 1);
+            window.max.y = std::min(dataWindow.max.y, settings.window[1] + settings.window[3] - 1);
+        }
+        return window.min.x <= window.max.x && window.min.y <= window.max.y;
+    }
 
-                file.setFrameBuffer(frameBuffer);
-                file.readPixels(dw.min.y, dw.max.y);
+    static bool validDataWindow(const Imath::Box2i& dw)
+    {
+        int max_valid_value = 32768;
+        int width = dw.max.x - dw.min.x + 1;
+        int height = dw.max.y - dw.min.y + 1;
+        return !(std::abs(dw.min.x) > max_valid_value || std::abs(dw.max.x) > max_valid_value || std::abs(dw.min.y) > max_valid_value || std::abs(dw.max.y) > max_valid_value ||
+                 width > max_valid_value || height > max_valid_value);
+    }
 
-                return image;
-            }
+    static vsg::ref_ptr<vsg::Object> parseOpenExr(Imf::InputFile& file, const ReadSettings& settings)
+    {
+        if (settings.level.x != 0 || settings.level.y != 0)
+        {
+            return vsg::ReadError::create("OpenEXR file has no level requested, levels are only supported by tiled files");
         }
-        else if (channelCount == 4)
+
+        Imath::Box2i dw = file.header().dataWindow();
+        if (!validDataWindow(dw)) return vsg::ReadError::create("OpenEXR dataWindow out of bounds");
+
+        Imath::Box2i window;
+        if (!computeWindow(dw, settings, window)) return vsg::ReadError::create("OpenEXR window outside of dataWindow");
+
+        // scanlines are always decoded across the whole of the data window
+        Imath::Box2i readBox(Imath::V2i(dw.min.x, window.min.y), Imath::V2i(dw.max.x, window.max.y));
+
+        return parseOpenExr(file.header(), window, readBox, [&](const Imf::FrameBuffer& frameBuffer) {
+            file.setFrameBuffer(frameBuffer);
+            file.readPixels(readBox.min.y, readBox.max.y);
+        });
+    }
+
+    static vsg::ref_ptr<vsg::Object> parseOpenExr(Imf::TiledInputFile& file, const ReadSettings& settings)
+    {
+        int lx = settings.level.x;
+        int ly = settings.level.y;
+        if (!file.isValidLevel(lx, ly))
         {
-            vsg::ref_ptr<vsg::Data> image;
-            size_t componentSize = 0;
-            if (type == Imf::HALF)
-            {
-                // single element half precision float
-                image = vsg::usvec4Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R16G16B16A16_SFLOAT});
-                componentSize = 2;
-            }
-            else if (type == Imf::FLOAT)
-            {
-                // single element single precision float
-                image = vsg::vec4Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32B32A32_SFLOAT});
-                componentSize = 4;
-            }
-            else if (type == Imf::UINT)
-            {
-                // single element single precision uint
-                image = vsg::uivec4Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R32G32B32A32_UINT});
-                componentSize = 4;
-            }
+            return vsg::ReadError::create("OpenEXR file has no level requested");
+        }
 
-            if (image)
-            {
-                auto valueSize = image->valueSize();
-                char* ptr = reinterpret_cast<char*>(image->dataPointer()) - valueSize * (dw.min.x + dw.min.y * width);
+        Imath::Box2i dw = file.dataWindowForLevel(lx, ly);
+        if (!validDataWindow(dw)) return vsg::ReadError::create("OpenEXR dataWindow out of bounds");
 
-                Imf::FrameBuffer frameBuffer;
-                frameBuffer.insert("R", Imf::Slice(type, ptr + 0 * componentSize, valueSize, valueSize * width));
-                frameBuffer.insert("G", Imf::Slice(type, ptr + 1 * componentSize, valueSize, valueSize * width));
-                frameBuffer.insert("B", Imf::Slice(type, ptr + 2 * componentSize, valueSize, valueSize * width));
-                frameBuffer.insert("A", Imf::Slice(type, ptr + 3 * componentSize, valueSize, valueSize * width));
+        Imath::Box2i window;
+        if (!computeWindow(dw, settings, window)) return vsg::ReadError::create("OpenEXR window outside of dataWindow");
 
-                file.setFrameBuffer(frameBuffer);
+        // only decode the tiles that overlap the window
+        int tileWidth = static_cast<int>(file.tileXSize());
+        int tileHeight = static_cast<int>(file.tileYSize());
+        int tx0 = (window.min.x - dw.min.x) / tileWidth;
+        int tx1 = (window.max.x - dw.min.x) / tileWidth;
+        int ty0 = (window.min.y - dw.min.y) / tileHeight;
+        int ty1 = (window.max.y - dw.min.y) / tileHeight;
 
-                file.readPixels(dw.min.y, dw.max.y);
+        Imath::Box2i readBox(Imath::V2i(dw.min.x + tx0 * tileWidth, dw.min.y + ty0 * tileHeight),
+                             Imath::V2i(std::min(dw.max.x, dw.min.x + (tx1 + 1) * tileWidth - 1), std::min(dw.max.y, dw.min.y + (ty1 + 1) * tileHeight - 1)));
 
-                return image;
-            }
+        return parseOpenExr(file.header(), window, readBox, [&](const Imf::FrameBuffer& frameBuffer) {
+            file.setFrameBuffer(frameBuffer);
+            file.readTiles(tx0, tx1, ty0, ty1, lx, ly);
+        });
+    }
+
+    /// select the first mipmap or ripmap level of a tiled file that fits within the max_texture_size, returns false if the file has no levels smaller than the full resolution.
+    static bool selectLevel(Imf::TiledInputFile& file, uint32_t maxTextureSize, vsg::ivec2& level)
+    {
+        if (file.levelMode() == Imf::ONE_LEVEL) return false;
+
+        auto fits = [&](int size) { return static_cast<uint32_t>(size) <= maxTextureSize; };
+
+        int lx = 0, ly = 0;
+        if (file.levelMode() == Imf::MIPMAP_LEVELS)
+        {
+            while ((lx + 1) < file.numLevels() && !(fits(file.levelWidth(lx)) && fits(file.levelHeight(lx)))) ++lx;
+            ly = lx;
         }
         else
         {
-            std::cout << "Unsupported channelCount = " << channelCount << std::endl;
+            while ((lx + 1) < file.numXLevels() && !fits(file.levelWidth(lx))) ++lx;
+            while ((ly + 1) < file.numYLevels() && !fits(file.levelHeight(ly))) ++ly;
         }
-        return {};
+
+        level.set(lx, ly);
+        return lx != 0 || ly != 0;
+    }
+
+    /// open the file as a tiled file when it's tiled and a level or window is requested so only the required tiles are decoded, otherwise as a general InputFile.
+    /// When a max_texture_size is set the coarsest level of tiled files that fits is read, and images still too large are box filtered down.
+    template<typename Source>
+    vsg::ref_ptr<vsg::Object> readOpenExr(Source&& source, bool isTiled, const ReadSettings& settings)
+    {
+        vsg::ref_ptr<vsg::Object> object;
+        if (isTiled && (settings.hasWindow || settings.level.x != 0 || settings.level.y != 0 || (settings.maxTextureSize > 0 && !settings.hasLevel)))
+        {
+            Imf::TiledInputFile file(source, settings.numThreads);
+
+            if (ReadSettings levelSettings = settings; !settings.hasLevel && !settings.hasWindow && settings.maxTextureSize > 0 && selectLevel(file, settings.maxTextureSize, levelSettings.level))
+                object = parseOpenExr(file, levelSettings);
+            else
+                object = parseOpenExr(file, settings);
+        }
+        else
+        {
+            Imf::InputFile file(source, settings.numThreads);
+            object = parseOpenExr(file, settings);
+        }
+
+        if (auto data = object.cast<vsg::Data>(); data && settings.maxTextureSize > 0) return downsampleImage(data, settings.maxTextureSize);
+        return object;
     }
 
     struct InitializeHeader : public vsg::ConstVisitor
     {
         std::unique_ptr<Imf::Header> header;
         int numScanLines = 0;
+        Imf::PixelType floatType = Imf::FLOAT; // OpenEXR converts the float values when writing to HALF channels
 
         void apply(const vsg::ushortArray2D& obj)
         { //single precision half float
@@ -309,7 +445,7 @@ namespace
         void apply(const vsg::floatArray2D& obj) override
         { //single precision float
             header.reset(new Imf::Header(obj.width(), obj.height()));
-            header->channels().insert("Y", Imf::Channel(Imf::FLOAT));
+            header->channels().insert("Y", Imf::Channel(floatType));
             numScanLines = obj.height();
         }
 
@@ -332,9 +468,9 @@ namespace
         void apply(const vsg::vec3Array2D& obj) override
         { //single precision float
             header.reset(new Imf::Header(obj.width(), obj.height()));
-            header->channels().insert("R", Imf::Channel(Imf::FLOAT));
-            header->channels().insert("G", Imf::Channel(Imf::FLOAT));
-            header->channels().insert("B", Imf::Channel(Imf::FLOAT));
+            header->channels().insert("R", Imf::Channel(floatType));
+            header->channels().insert("G", Imf::Channel(floatType));
+            header->channels().insert("B", Imf::Channel(floatType));
             numScanLines = obj.height();
         }
 
@@ -360,10 +496,10 @@ namespace
         void apply(const vsg::vec4Array2D& obj) override
         { //single precision float
             header.reset(new Imf::Header(obj.width(), obj.height()));
-            header->channels().insert("R", Imf::Channel(Imf::FLOAT));
-            header->channels().insert("G", Imf::Channel(Imf::FLOAT));
-            header->channels().insert("B", Imf::Channel(Imf::FLOAT));
-            header->channels().insert("A", Imf::Channel(Imf::FLOAT));
+            header->channels().insert("R", Imf::Channel(floatType));
+            header->channels().insert("G", Imf::Channel(floatType));
+            header->channels().insert("B", Imf::Channel(floatType));
+            header->channels().insert("A", Imf::Channel(floatType));
             numScanLines = obj.height();
         }
 
@@ -443,6 +579,54 @@ namespace
         }
     };
 
+    static bool compressionFromString(const std::string& name, Imf::Compression& compression)
+    {
+        static const std::map<std::string, Imf::Compression> s_compressionMap{
+            {"none", Imf::NO_COMPRESSION},
+            {"rle", Imf::RLE_COMPRESSION},
+            {"zips", Imf::ZIPS_COMPRESSION},
+            {"zip", Imf::ZIP_COMPRESSION},
+            {"piz", Imf::PIZ_COMPRESSION},
+            {"pxr24", Imf::PXR24_COMPRESSION},
+            {"b44", Imf::B44_COMPRESSION},
+            {"b44a", Imf::B44A_COMPRESSION},
+            {"dwaa", Imf::DWAA_COMPRESSION},
+            {"dwab", Imf::DWAB_COMPRESSION}};
+
+        auto lowerCaseName = name;
+        std::transform(lowerCaseName.begin(), lowerCaseName.end(), lowerCaseName.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        if (auto itr = s_compressionMap.find(lowerCaseName); itr != s_compressionMap.end())
+        {
+            compression = itr->second;
+            return true;
+        }
+        return false;
+    }
+
+    /// set up the header for writing the object, using the openexr::compression and openexr::half_float options.
+    static InitializeHeader initializeHeader(const vsg::Object* object, const vsg::Options* options)
+    {
+        InitializeHeader v;
+
+        bool halfFloat = false;
+        if (options && options->getValue(openexr::half_float, halfFloat) && halfFloat) v.floatType = Imf::HALF;
+
+        object->accept(v);
+
+        std::string compressionName;
+        if (v.header && options && options->getValue(openexr::compression, compressionName))
+        {
+            Imf::Compression compression;
+            if (compressionFromString(compressionName, compression))
+                v.header->compression() = compression;
+            else
+                std::cout << "openexr::write() unsupported compression \"" << compressionName << "\", using default compression." << std::endl;
+        }
+
+        return v;
+    }
+
 } // end of namespace
 
 openexr::openexr() :
@@ -462,9 +646,13 @@ vsg::ref_ptr<vsg::Object> openexr::read(const vsg::Path& filename, vsg::ref_ptr<
         vsg::Path filenameToUse = findFile(filename, options);
         if (!filenameToUse) return {};
 
-        Imf::InputFile file(filenameToUse.string().c_str());
+        ReadSettings settings(options.get());
+
+        auto filenameString = filenameToUse.string();
+        bool isTiled = false;
+        if (!Imf::isOpenExrFile(filenameString.c_str(), isTiled)) return {};
 
-        return parseOpenExr(file);
+        return readOpenExr(filenameString.c_str(), isTiled, settings);
     }
     catch (Iex::BaseExc& e)
     {
@@ -482,10 +670,17 @@ vsg::ref_ptr<vsg::Object> openexr::read(std::istream& fin, vsg::ref_ptr<const vs
 
     try
     {
-        CPP_IStream stream(fin, "");
-        Imf::InputFile file(stream);
+        vsgXchange::StreamData input;
+        if (!vsgXchange::readStream(fin, input)) return {};
+
+        ReadSettings settings(options.get());
 
-        return parseOpenExr(file);
+        // decode directly from the memory, input retains the storage until the image has been read
+        Array_IStream stream(input.data, input.size, "");
+        bool isTiled = false;
+        if (!Imf::isOpenExrFile(stream, isTiled)) return {};
+
+        return readOpenExr(stream, isTiled, settings);
     }
     catch (Iex::BaseExc& e)
     {
@@ -503,10 +698,13 @@ vsg::ref_ptr<vsg::Object> openexr::read(const uint8_t* ptr, size_t size, vsg::re
 
     try
     {
+        ReadSettings settings(options.get());
+
         Array_IStream stream(ptr, size, "");
-        Imf::InputFile file(stream);
+        bool isTiled = false;
+        if (!Imf::isOpenExrFile(stream, isTiled)) return {};
 
-        return parseOpenExr(file);
+        return readOpenExr(stream, isTiled, settings);
     }
     catch (Iex::BaseExc& e)
     {
@@ -524,7 +722,7 @@ bool openexr::write(const vsg::Object* object, const vsg::Path& filename, vsg::r
 
     try
     {
-        auto v = vsg::visit<InitializeHeader>(object);
+        auto v = initializeHeader(object, options.get());
         if (v.header)
         {
             Imf::OutputFile file(filename.string().c_str(), *v.header);
@@ -551,7 +749,7 @@ bool openexr::write(const vsg::Object* object, std::ostream& fout, vsg::ref_ptr<
 
     try
     {
-        auto v = vsg::visit<InitializeHeader>(object);
+        auto v = initializeHeader(object, options.get());
         if (v.header)
         {
             CPP_OStream stream(fout, "");
@@ -579,5 +777,24 @@ bool openexr::getFeatures(Features& features) const
     {
         features.extensionFeatureMap[ext] = static_cast<vsg::ReaderWriter::FeatureMask>(vsg::ReaderWriter::READ_FILENAME | vsg::ReaderWriter::READ_ISTREAM | vsg::ReaderWriter::READ_MEMORY | vsg::ReaderWriter::WRITE_FILENAME | vsg::ReaderWriter::WRITE_OSTREAM);
     }
+
+    features.optionNameTypeMap[openexr::num_threads] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[openexr::window] = vsg::type_name<vsg::ivec4>();
+    features.optionNameTypeMap[openexr::level] = vsg::type_name<vsg::ivec2>();
+    features.optionNameTypeMap[openexr::compression] = vsg::type_name<std::string>();
+    features.optionNameTypeMap[openexr::half_float] = vsg::type_name<bool>();
+    features.optionNameTypeMap[images::max_texture_size] = vsg::type_name<uint32_t>();
+
     return true;
 }
+
+bool openexr::readOptions(vsg::Options& options, vsg::CommandLine& arguments) const
+{
+    bool result = arguments.readAndAssign<uint32_t>(openexr::num_threads, &options);
+    result = arguments.readAndAssign<vsg::ivec4>(openexr::window, &options) || result;
+    result = arguments.readAndAssign<vsg::ivec2>(openexr::level, &options) || result;
+    result = arguments.readAndAssign<std::string>(openexr::compression, &options) || result;
+    result = arguments.readAndAssign<bool>(openexr::half_float, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(images::max_texture_size, &options) || result;
+    return result;
+}
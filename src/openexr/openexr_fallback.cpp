@@ -39,3 +39,8 @@ bool openexr::getFeatures(Features&) const
 {
     return false;
 }
+
+bool openexr::readOptions(vsg::Options&, vsg::CommandLine&) const
+{
+    return false;
+}
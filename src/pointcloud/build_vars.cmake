@@ -0,0 +1,30 @@
+# add point cloud support, .las files are read natively, and .laz and .e57 files if LASzip and libE57Format are available
+find_path(LASZIP_INCLUDE_DIR laszip/laszip_api.h)
+find_library(LASZIP_LIBRARY NAMES laszip laszip3)
+find_package(E57Format CONFIG QUIET)
+
+if(LASZIP_INCLUDE_DIR AND LASZIP_LIBRARY)
+    OPTION(vsgXchange_LASzip "Optional LASzip support for .laz point clouds provided" ON)
+endif()
+
+if(E57Format_FOUND)
+    OPTION(vsgXchange_E57 "Optional libE57Format support for .e57 point clouds provided" ON)
+endif()
+
+set(SOURCES ${SOURCES}
+    pointcloud/pointcloud.cpp
+)
+
+if(${vsgXchange_LASzip})
+    set(EXTRA_INCLUDES ${EXTRA_INCLUDES} ${LASZIP_INCLUDE_DIR})
+    set(EXTRA_LIBRARIES ${EXTRA_LIBRARIES} ${LASZIP_LIBRARY})
+    set(EXTRA_DEFINES ${EXTRA_DEFINES} USE_LASZIP)
+endif()
+
+if(${vsgXchange_E57})
+    set(EXTRA_LIBRARIES ${EXTRA_LIBRARIES} E57Format)
+    set(EXTRA_DEFINES ${EXTRA_DEFINES} USE_E57)
+    if(NOT BUILD_SHARED_LIBS)
+        set(FIND_DEPENDENCY ${FIND_DEPENDENCY} "find_dependency(E57Format CONFIG)")
+    endif()
+endif()
@@ -0,0 +1,1167 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <vsgXchange/cancellation.h>
+#include <vsgXchange/models.h>
+
+#include "../all/parallel_for.h"
+
+#include <vsg/all.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef USE_LASZIP
+#    include <laszip/laszip_api.h>
+#endif
+
+#ifdef USE_E57
+#    include <E57SimpleReader.h>
+#endif
+
+using namespace vsgXchange;
+
+namespace
+{
+    struct Point
+    {
+        vsg::dvec3 position;
+        vsg::ubvec4 color;
+    };
+
+    /// source of the points of a point cloud file, read in chunks so that only a chunk of the file's points is resident at a time.
+    class PointSource
+    {
+    public:
+        virtual ~PointSource() {}
+
+        /// bounds of the points when known from the file's header, otherwise invalid and computed by a pass over the points.
+        vsg::dbox bounds;
+
+        /// number of points in the file.
+        uint64_t count = 0;
+
+        /// restart reading from the first point.
+        virtual bool rewind() = 0;
+
+        /// replace the contents of points with the next up to maxPoints points, returning the number read, 0 once all the points have been read.
+        virtual size_t read(std::vector<Point>& points, size_t maxPoints) = 0;
+    };
+
+    /// LAS stores colors and intensities as 16 bit values, but many writers store 8 bit values in them, so the depth is detected from the first values read.
+    struct ColorDepth
+    {
+        int shift = -1;
+
+        uint8_t operator()(uint16_t value) const { return static_cast<uint8_t>(std::min(value >> std::max(shift, 0), 255)); }
+
+        void detect(uint16_t maxValue)
+        {
+            if (shift < 0 && maxValue > 0) shift = (maxValue > 255) ? 8 : 0;
+        }
+    };
+
+    template<typename T>
+    T get(const uint8_t* ptr)
+    {
+        T value;
+        std::memcpy(&value, ptr, sizeof(T));
+        return value;
+    }
+
+    /// reads the points of uncompressed LAS 1.0 to 1.4 files, point data record formats 0 to 10.
+    class LASSource : public PointSource
+    {
+    public:
+        bool compressed = false;
+
+        bool open(const vsg::Path& filename)
+        {
+            _fin.open(filename, std::ios::in | std::ios::binary);
+            if (!_fin) return false;
+
+            uint8_t header[375] = {};
+            _fin.read(reinterpret_cast<char*>(header), sizeof(header));
+            auto headerSize = _fin.gcount();
+            if (headerSize < 227 || std::memcmp(header, "LASF", 4) != 0) return false;
+
+            uint8_t versionMinor = header[25];
+            _pointsOffset = get<uint32_t>(header + 96);
+            uint8_t pointFormat = header[104];
+            _recordLength = get<uint16_t>(header + 105);
+            count = get<uint32_t>(header + 107);
+            if (versionMinor >= 4 && headerSize >= 255 && get<uint64_t>(header + 247) > 0) count = get<uint64_t>(header + 247);
+
+            _scale.set(get<double>(header + 131), get<double>(header + 139), get<double>(header + 147));
+            _offset.set(get<double>(header + 155), get<double>(header + 163), get<double>(header + 171));
+            bounds.max.set(get<double>(header + 179), get<double>(header + 195), get<double>(header + 211));
+            bounds.min.set(get<double>(header + 187), get<double>(header + 203), get<double>(header + 219));
+
+            // LAZ files set the top bits of the point data format
+            if (pointFormat & 0xc0)
+            {
+                compressed = true;
+                return false;
+            }
+
+            static const uint16_t s_recordLengths[] = {20, 28, 26, 34, 57, 63, 30, 36, 38, 59, 67};
+            if (pointFormat > 10 || _recordLength < s_recordLengths[pointFormat]) return false;
+
+            switch (pointFormat)
+            {
+            case 2: _rgbOffset = 20; break;
+            case 3:
+            case 5: _rgbOffset = 28; break;
+            case 7:
+            case 8:
+            case 10: _rgbOffset = 30; break;
+            default: _rgbOffset = 0; break;
+            }
+
+            return rewind();
+        }
+
+        bool rewind() override
+        {
+            _fin.clear();
+            _fin.seekg(_pointsOffset);
+            _remaining = count;
+            return _fin.good();
+        }
+
+        size_t read(std::vector<Point>& points, size_t maxPoints) override
+        {
+            points.clear();
+
+            size_t numPoints = static_cast<size_t>(std::min<uint64_t>(maxPoints, _remaining));
+            if (numPoints == 0) return 0;
+
+            _buffer.resize(numPoints * _recordLength);
+            _fin.read(reinterpret_cast<char*>(_buffer.data()), _buffer.size());
+            numPoints = static_cast<size_t>(_fin.gcount()) / _recordLength;
+            _remaining = (numPoints > 0) ? _remaining - numPoints : 0;
+
+            uint16_t maxValue = 0;
+            for (size_t i = 0; i < numPoints && _depth.shift < 0; ++i)
+            {
+                const uint8_t* record = _buffer.data() + i * _recordLength;
+                if (_rgbOffset)
+                    maxValue = std::max({maxValue, get<uint16_t>(record + _rgbOffset), get<uint16_t>(record + _rgbOffset + 2), get<uint16_t>(record + _rgbOffset + 4)});
+                else
+                    maxValue = std::max(maxValue, get<uint16_t>(record + 12));
+            }
+            _depth.detect(maxValue);
+
+            points.resize(numPoints);
+            for (size_t i = 0; i < numPoints; ++i)
+            {
+                const uint8_t* record = _buffer.data() + i * _recordLength;
+                auto& point = points[i];
+                point.position.set(get<int32_t>(record) * _scale.x + _offset.x, get<int32_t>(record + 4) * _scale.y + _offset.y, get<int32_t>(record + 8) * _scale.z + _offset.z);
+                if (_rgbOffset)
+                {
+                    point.color.set(_depth(get<uint16_t>(record + _rgbOffset)), _depth(get<uint16_t>(record + _rgbOffset + 2)), _depth(get<uint16_t>(record + _rgbOffset + 4)), 255);
+                }
+                else
+                {
+                    uint8_t intensity = _depth(get<uint16_t>(record + 12));
+                    point.color.set(intensity, intensity, intensity, 255);
+                }
+            }
+            return numPoints;
+        }
+
+    protected:
+        std::ifstream _fin;
+        uint64_t _pointsOffset = 0;
+        uint16_t _recordLength = 0;
+        uint16_t _rgbOffset = 0;
+        uint64_t _remaining = 0;
+        vsg::dvec3 _scale;
+        vsg::dvec3 _offset;
+        ColorDepth _depth;
+        std::vector<uint8_t> _buffer;
+    };
+
+#ifdef USE_LASZIP
+    /// reads the points of LAZ and LAS files using LASzip.
+    class LASzipSource : public PointSource
+    {
+    public:
+        ~LASzipSource()
+        {
+            if (_laszip)
+            {
+                if (_opened) laszip_close_reader(_laszip);
+                laszip_destroy(_laszip);
+            }
+        }
+
+        bool open(const vsg::Path& filename)
+        {
+            _filename = filename.string();
+            if (laszip_create(&_laszip) != 0 || !openReader()) return false;
+
+            laszip_header* header = nullptr;
+            laszip_get_header_pointer(_laszip, &header);
+
+            count = (header->extended_number_of_point_records > 0) ? header->extended_number_of_point_records : header->number_of_point_records;
+            _scale.set(header->x_scale_factor, header->y_scale_factor, header->z_scale_factor);
+            _offset.set(header->x_offset, header->y_offset, header->z_offset);
+            bounds.min.set(header->min_x, header->min_y, header->min_z);
+            bounds.max.set(header->max_x, header->max_y, header->max_z);
+
+            switch (header->point_data_format & 0x3f)
+            {
+            case 2:
+            case 3:
+            case 5:
+            case 7:
+            case 8:
+            case 10: _hasColor = true; break;
+            default: _hasColor = false; break;
+            }
+            return true;
+        }
+
+        bool rewind() override
+        {
+            // LAZ is read sequentially, so reopen the reader rather than relying on the chunk table being present to seek
+            if (_opened) laszip_close_reader(_laszip);
+            _opened = false;
+            return openReader();
+        }
+
+        size_t read(std::vector<Point>& points, size_t maxPoints) override
+        {
+            points.clear();
+            size_t numPoints = static_cast<size_t>(std::min<uint64_t>(maxPoints, _remaining));
+
+            std::vector<std::array<uint16_t, 3>> values;
+            values.reserve(numPoints);
+            points.reserve(numPoints);
+
+            uint16_t maxValue = 0;
+            for (size_t i = 0; i < numPoints; ++i)
+            {
+                if (laszip_read_point(_laszip) != 0)
+                {
+                    _remaining = 0;
+                    break;
+                }
+
+                points.push_back(Point{vsg::dvec3(_point->X * _scale.x + _offset.x, _point->Y * _scale.y + _offset.y, _point->Z * _scale.z + _offset.z), {}});
+                if (_hasColor)
+                    values.push_back({_point->rgb[0], _point->rgb[1], _point->rgb[2]});
+                else
+                    values.push_back({_point->intensity, _point->intensity, _point->intensity});
+                maxValue = std::max({maxValue, values.back()[0], values.back()[1], values.back()[2]});
+            }
+            _remaining -= std::min<uint64_t>(_remaining, points.size());
+            _depth.detect(maxValue);
+
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                points[i].color.set(_depth(values[i][0]), _depth(values[i][1]), _depth(values[i][2]), 255);
+            }
+            return points.size();
+        }
+
+    protected:
+        bool openReader()
+        {
+            laszip_BOOL isCompressed = 0;
+            if (laszip_open_reader(_laszip, _filename.c_str(), &isCompressed) != 0)
+            {
+                laszip_CHAR* error = nullptr;
+                laszip_get_error(_laszip, &error);
+                vsg::warn("pointcloud::read(", _filename, ") LASzip error: ", error ? error : "unknown");
+                return false;
+            }
+            _opened = true;
+            _remaining = count;
+            laszip_get_point_pointer(_laszip, &_point);
+            return true;
+        }
+
+        std::string _filename;
+        laszip_POINTER _laszip = nullptr;
+        laszip_point* _point = nullptr;
+        bool _opened = false;
+        bool _hasColor = false;
+        uint64_t _remaining = 0;
+        vsg::dvec3 _scale;
+        vsg::dvec3 _offset;
+        ColorDepth _depth;
+    };
+#endif
+
+#ifdef USE_E57
+    /// reads the cartesian points of each scan of an E57 file using libE57Format, transformed by the scans' poses.
+    class E57Source : public PointSource
+    {
+    public:
+        bool open(const vsg::Path& filename)
+        {
+            try
+            {
+                _reader = std::make_unique<e57::Reader>(filename.string());
+                if (!_reader->IsOpen()) return false;
+
+                for (int64_t i = 0; i < _reader->GetData3DCount(); ++i)
+                {
+                    Scan scan;
+                    scan.index = i;
+                    _reader->ReadData3D(i, scan.header);
+                    if (!scan.header.pointFields.cartesianXField)
+                    {
+                        vsg::warn("pointcloud::read(", filename, ") scan ", i, " has no cartesian coordinates, skipping.");
+                        continue;
+                    }
+
+                    int64_t rows = 0, columns = 0, pointsSize = 0, groupsSize = 0, countSize = 0;
+                    bool columnIndex = false;
+                    _reader->GetData3DSizes(i, rows, columns, pointsSize, groupsSize, countSize, columnIndex);
+
+                    auto& pose = scan.header.pose;
+                    scan.transform = vsg::translate(pose.translation.x, pose.translation.y, pose.translation.z) * vsg::rotate(vsg::dquat(pose.rotation.x, pose.rotation.y, pose.rotation.z, pose.rotation.w));
+
+                    count += static_cast<uint64_t>(pointsSize);
+                    _scans.push_back(scan);
+                }
+            }
+            catch (const std::exception& e)
+            {
+                vsg::warn("pointcloud::read(", filename, ") E57 error: ", e.what());
+                return false;
+            }
+            return !_scans.empty();
+        }
+
+        bool rewind() override
+        {
+            closeScan();
+            _scanIndex = 0;
+            return true;
+        }
+
+        size_t read(std::vector<Point>& points, size_t maxPoints) override
+        {
+            points.clear();
+            try
+            {
+                while (points.size() < maxPoints)
+                {
+                    if (_position >= _size && !fillBuffer()) break;
+
+                    auto& scan = _scans[_scanIndex];
+                    auto& fields = scan.header.pointFields;
+                    for (; _position < _size && points.size() < maxPoints; ++_position)
+                    {
+                        if (fields.cartesianInvalidStateField && _invalid[_position] != 0) continue;
+
+                        Point point;
+                        point.position = scan.transform * vsg::dvec3(_x[_position], _y[_position], _z[_position]);
+                        if (fields.colorRedField)
+                            point.color.set(scale(_red[_position], scan.colorMin, scan.colorMax), scale(_green[_position], scan.colorMin, scan.colorMax), scale(_blue[_position], scan.colorMin, scan.colorMax), 255);
+                        else if (fields.intensityField)
+                            point.color.set(scale(_intensity[_position], scan.intensityMin, scan.intensityMax), scale(_intensity[_position], scan.intensityMin, scan.intensityMax), scale(_intensity[_position], scan.intensityMin, scan.intensityMax), 255);
+                        else
+                            point.color.set(255, 255, 255, 255);
+                        points.push_back(point);
+                    }
+                }
+            }
+            catch (const std::exception& e)
+            {
+                vsg::warn("pointcloud::read() E57 error: ", e.what());
+                _scanIndex = _scans.size();
+            }
+            return points.size();
+        }
+
+    protected:
+        using Buffers = e57::Data3DPointsData_d;
+        using IntensityType = std::remove_pointer_t<decltype(Buffers::intensity)>;
+        using ColorType = std::remove_pointer_t<decltype(Buffers::colorRed)>;
+
+        struct Scan
+        {
+            int64_t index = 0;
+            e57::Data3D header;
+            vsg::dmat4 transform;
+            double colorMin = 0.0;
+            double colorMax = 255.0;
+            double intensityMin = 0.0;
+            double intensityMax = 1.0;
+        };
+
+        static uint8_t scale(double value, double minimum, double maximum)
+        {
+            double range = maximum - minimum;
+            double ratio = (range > 0.0) ? (value - minimum) / range : value / 255.0;
+            return static_cast<uint8_t>(std::clamp(ratio, 0.0, 1.0) * 255.0 + 0.5);
+        }
+
+        /// read the next block of points, moving on to the next scan when the current one is exhausted, returning false when all the scans have been read.
+        bool fillBuffer()
+        {
+            while (_scanIndex < _scans.size())
+            {
+                if (!_vectorReader)
+                {
+                    auto& scan = _scans[_scanIndex];
+                    auto& header = scan.header;
+                    if (header.colorLimits.colorRedMaximum > header.colorLimits.colorRedMinimum)
+                    {
+                        scan.colorMin = static_cast<double>(header.colorLimits.colorRedMinimum);
+                        scan.colorMax = static_cast<double>(header.colorLimits.colorRedMaximum);
+                    }
+                    if (header.intensityLimits.intensityMaximum > header.intensityLimits.intensityMinimum)
+                    {
+                        scan.intensityMin = static_cast<double>(header.intensityLimits.intensityMinimum);
+                        scan.intensityMax = static_cast<double>(header.intensityLimits.intensityMaximum);
+                    }
+
+                    _x.resize(s_bufferSize);
+                    _y.resize(s_bufferSize);
+                    _z.resize(s_bufferSize);
+                    _invalid.resize(s_bufferSize);
+                    _intensity.resize(s_bufferSize);
+                    _red.resize(s_bufferSize);
+                    _green.resize(s_bufferSize);
+                    _blue.resize(s_bufferSize);
+
+                    Buffers buffers;
+                    buffers.cartesianX = _x.data();
+                    buffers.cartesianY = _y.data();
+                    buffers.cartesianZ = _z.data();
+                    if (header.pointFields.cartesianInvalidStateField) buffers.cartesianInvalidState = _invalid.data();
+                    if (header.pointFields.intensityField) buffers.intensity = _intensity.data();
+                    if (header.pointFields.colorRedField)
+                    {
+                        buffers.colorRed = _red.data();
+                        buffers.colorGreen = _green.data();
+                        buffers.colorBlue = _blue.data();
+                    }
+
+                    _vectorReader = std::make_unique<e57::CompressedVectorReader>(_reader->SetUpData3DPointsData(scan.index, s_bufferSize, buffers));
+                }
+
+                _size = _vectorReader->read();
+                _position = 0;
+                if (_size > 0) return true;
+
+                closeScan();
+                ++_scanIndex;
+            }
+            return false;
+        }
+
+        void closeScan()
+        {
+            if (_vectorReader) _vectorReader->close();
+            _vectorReader.reset();
+            _size = 0;
+            _position = 0;
+        }
+
+        static constexpr size_t s_bufferSize = 65536;
+
+        std::unique_ptr<e57::Reader> _reader;
+        std::vector<Scan> _scans;
+        size_t _scanIndex = 0;
+        std::unique_ptr<e57::CompressedVectorReader> _vectorReader;
+        size_t _size = 0;
+        size_t _position = 0;
+
+        std::vector<double> _x, _y, _z;
+        std::vector<int8_t> _invalid;
+        std::vector<IntensityType> _intensity;
+        std::vector<ColorType> _red, _green, _blue;
+    };
+#endif
+
+    std::unique_ptr<PointSource> openPointSource(const vsg::Path& filename, const vsg::Path& ext)
+    {
+        if (ext == ".las")
+        {
+            auto source = std::make_unique<LASSource>();
+            if (source->open(filename)) return source;
+            if (!source->compressed) return {};
+        }
+
+#ifdef USE_LASZIP
+        if (ext == ".las" || ext == ".laz")
+        {
+            auto source = std::make_unique<LASzipSource>();
+            if (source->open(filename)) return source;
+            return {};
+        }
+#endif
+
+#ifdef USE_E57
+        if (ext == ".e57")
+        {
+            auto source = std::make_unique<E57Source>();
+            if (source->open(filename)) return source;
+            return {};
+        }
+#endif
+
+        vsg::warn("pointcloud::read(", filename, ") compressed point clouds require vsgXchange to be built with LASzip.");
+        return {};
+    }
+
+    /// builds an octree of tiles from the points of a PointSource, writing each tile as a .vsgb file that references its children through vsg::PagedLOD.
+    /// The points are read three times: to count them on a coarse grid, to distribute them to the nodes of the top of the octree and to the chunk files
+    /// of the subtrees below them, each of which then fits in memory, and finally each chunk is read back to build its subtree.
+    /// Each node keeps the first point that falls into each cell of a resolution^3 grid over its cube, passing the rest down to its children,
+    /// so each point is stored once and the nodes of a subtree progressively add detail to their ancestors.
+    class OctreeBuilder
+    {
+    public:
+        uint32_t pointsPerTile = 65536;
+        uint32_t resolution = 128;
+        uint64_t chunkPoints = 2000000;
+        double lodScreenRatio = 0.5;
+        uint32_t numThreads = 1;
+        uint32_t maxLevel = 24;
+
+        vsg::Path tileDirectory;
+        vsg::ref_ptr<const vsg::Options> tileOptions;
+        const CancellationToken* cancellation = nullptr;
+
+        static vsg::Path tileFilename(uint32_t level, uint32_t x, uint32_t y, uint32_t z)
+        {
+            // name the tiles by the octants of the path from the root, in a new directory every 4 levels so that no directory holds too many files
+            std::string name("r");
+            for (uint32_t l = level; l > 0; --l)
+            {
+                name.push_back(static_cast<char>('0' + (((x >> (l - 1)) & 1) | (((y >> (l - 1)) & 1) << 1) | (((z >> (l - 1)) & 1) << 2))));
+            }
+            return vsg::Path(name.substr(0, ((name.size() - 1) / 4) * 4 + 1)) / (name + ".vsgb");
+        }
+
+        vsg::ref_ptr<vsg::Node> build(PointSource& source)
+        {
+            if (source.count == 0) return {};
+
+            createConfig();
+
+            // the header's bounds are trusted if present, otherwise they are computed with an extra pass
+            std::vector<Point> points;
+            auto bounds = source.bounds;
+            if (!bounds.valid() || bounds.min == bounds.max)
+            {
+                bounds = {};
+                source.rewind();
+                while (source.read(points, s_readSize) > 0)
+                {
+                    for (auto& point : points) bounds.add(point.position);
+                    if (cancelled()) return {};
+                }
+                if (!bounds.valid()) return {};
+            }
+
+            auto extents = bounds.max - bounds.min;
+            _rootSize = std::max({extents.x, extents.y, extents.z});
+            _rootSize = (_rootSize > 0.0) ? _rootSize * (1.0 + 1e-6) : 1.0;
+            _rootMin = (bounds.min + bounds.max) * 0.5 - vsg::dvec3(_rootSize, _rootSize, _rootSize) * 0.5;
+
+            // count the points in each cell of the coarse grid
+            std::vector<uint64_t> counts(s_gridSize * s_gridSize * s_gridSize, 0);
+            source.rewind();
+            while (source.read(points, s_readSize) > 0)
+            {
+                for (auto& point : points) ++counts[gridIndex(point.position)];
+                if (cancelled()) return {};
+            }
+
+            partition(counts);
+            vsg::debug("pointcloud::read() ", source.count, " points partitioned into ", _chunks.size(), " chunks");
+
+            auto chunkDirectory = tileDirectory / "chunks";
+            if (!vsg::makeDirectory(chunkDirectory))
+            {
+                vsg::warn("pointcloud::read() unable to create ", chunkDirectory);
+                return {};
+            }
+
+            if (!distribute(source, chunkDirectory)) return {};
+
+            // build the subtrees of the chunks, each only holding its own chunk's points in memory
+            std::atomic_bool success{true};
+            vsgXchange::parallel_for(_chunks.size(), numThreads, [&](size_t i) {
+                auto& chunk = _chunks[i];
+                if (!success || cancelled())
+                {
+                    success = false;
+                    return;
+                }
+
+                auto chunkContents = readChunk(chunkFilename(chunkDirectory, i));
+                chunk.exists = buildNode(chunk.level, chunk.x, chunk.y, chunk.z, chunkContents);
+            });
+
+            std::error_code ec;
+            std::filesystem::remove_all(chunkDirectory.string(), ec);
+
+            if (!success) return {};
+
+            return buildUpperNodes();
+        }
+
+    protected:
+        static constexpr uint32_t s_gridLevel = 6;
+        static constexpr uint32_t s_gridSize = 1u << s_gridLevel;
+        static constexpr size_t s_readSize = 1 << 20;
+        static constexpr size_t s_chunkBufferSize = 4096;
+
+        struct Chunk
+        {
+            uint32_t level = 0;
+            uint32_t x = 0, y = 0, z = 0;
+            std::vector<Point> buffer;
+            bool exists = false;
+        };
+
+        struct UpperNode
+        {
+            std::unordered_set<uint32_t> cells;
+            std::vector<Point> points;
+        };
+
+        double _rootSize = 1.0;
+        vsg::dvec3 _rootMin;
+        std::vector<Chunk> _chunks;
+        std::vector<uint32_t> _cellChunks;
+        std::unordered_map<uint64_t, UpperNode> _upperNodes;
+        vsg::ref_ptr<vsg::GraphicsPipelineConfigurator> _config;
+        bool _assignedNormal = false;
+        bool _assignedTexCoord = false;
+        std::array<uint8_t, 256> _colorTable;
+
+        bool cancelled() const { return cancellation && cancellation->cancelled(); }
+
+        static uint64_t nodeKey(uint32_t level, uint32_t x, uint32_t y, uint32_t z)
+        {
+            return (static_cast<uint64_t>(level) << 57) | (static_cast<uint64_t>(x) << 38) | (static_cast<uint64_t>(y) << 19) | static_cast<uint64_t>(z);
+        }
+
+        double nodeSize(uint32_t level) const { return _rootSize / static_cast<double>(1ull << level); }
+
+        vsg::dvec3 nodeMin(uint32_t level, uint32_t x, uint32_t y, uint32_t z) const
+        {
+            return _rootMin + vsg::dvec3(x, y, z) * nodeSize(level);
+        }
+
+        static uint32_t cell(double value, double minimum, double size, uint32_t divisions)
+        {
+            double position = (value - minimum) / size * divisions;
+            if (position <= 0.0) return 0;
+            return std::min(static_cast<uint32_t>(position), divisions - 1);
+        }
+
+        vsg::uivec3 gridCell(const vsg::dvec3& position) const
+        {
+            return vsg::uivec3(cell(position.x, _rootMin.x, _rootSize, s_gridSize), cell(position.y, _rootMin.y, _rootSize, s_gridSize), cell(position.z, _rootMin.z, _rootSize, s_gridSize));
+        }
+
+        size_t gridIndex(const vsg::dvec3& position) const
+        {
+            auto c = gridCell(position);
+            return (static_cast<size_t>(c.z) * s_gridSize + c.y) * s_gridSize + c.x;
+        }
+
+        /// return the index of the cell of the node's resolution^3 grid that position falls in.
+        uint32_t nodeCell(const vsg::dvec3& position, const vsg::dvec3& minimum, double size) const
+        {
+            return (cell(position.z, minimum.z, size, resolution) * resolution + cell(position.y, minimum.y, size, resolution)) * resolution + cell(position.x, minimum.x, size, resolution);
+        }
+
+        /// divide the coarse grid into the largest octree nodes holding no more than chunkPoints points, so that each chunk's subtree can be built in memory.
+        void partition(const std::vector<uint64_t>& counts)
+        {
+            // sum the counts up the levels of the octree
+            std::vector<std::vector<uint64_t>> levels(s_gridLevel + 1);
+            levels[s_gridLevel] = counts;
+            for (uint32_t level = s_gridLevel; level > 0; --level)
+            {
+                uint32_t size = 1u << level;
+                uint32_t parentSize = size / 2;
+                auto& parentCounts = levels[level - 1];
+                parentCounts.assign(static_cast<size_t>(parentSize) * parentSize * parentSize, 0);
+                for (uint32_t z = 0; z < size; ++z)
+                    for (uint32_t y = 0; y < size; ++y)
+                        for (uint32_t x = 0; x < size; ++x)
+                            parentCounts[((z / 2) * parentSize + y / 2) * parentSize + x / 2] += levels[level][(static_cast<size_t>(z) * size + y) * size + x];
+            }
+
+            _chunks.clear();
+            _cellChunks.assign(counts.size(), 0);
+
+            std::function<void(uint32_t, uint32_t, uint32_t, uint32_t)> subdivide = [&](uint32_t level, uint32_t x, uint32_t y, uint32_t z) {
+                uint32_t size = 1u << level;
+                uint64_t count = levels[level][(static_cast<size_t>(z) * size + y) * size + x];
+                if (count == 0) return;
+
+                if (count > chunkPoints && level < s_gridLevel)
+                {
+                    for (uint32_t c = 0; c < 8; ++c) subdivide(level + 1, x * 2 + (c & 1), y * 2 + ((c >> 1) & 1), z * 2 + (c >> 2));
+                    return;
+                }
+
+                // assign the grid cells within the chunk to it
+                uint32_t index = static_cast<uint32_t>(_chunks.size());
+                _chunks.push_back(Chunk{level, x, y, z, {}, false});
+
+                uint32_t cellsPerNode = 1u << (s_gridLevel - level);
+                for (uint32_t cz = z * cellsPerNode; cz < (z + 1) * cellsPerNode; ++cz)
+                    for (uint32_t cy = y * cellsPerNode; cy < (y + 1) * cellsPerNode; ++cy)
+                        for (uint32_t cx = x * cellsPerNode; cx < (x + 1) * cellsPerNode; ++cx)
+                            _cellChunks[(static_cast<size_t>(cz) * s_gridSize + cy) * s_gridSize + cx] = index;
+            };
+            subdivide(0, 0, 0, 0);
+        }
+
+        static vsg::Path chunkFilename(const vsg::Path& chunkDirectory, size_t index)
+        {
+            return chunkDirectory / (std::to_string(index) + ".points");
+        }
+
+        static bool appendChunk(const vsg::Path& filename, std::vector<Point>& buffer)
+        {
+            if (buffer.empty()) return true;
+
+            std::ofstream fout(filename, std::ios::out | std::ios::binary | std::ios::app);
+            fout.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(Point));
+            buffer.clear();
+            return fout.good();
+        }
+
+        static std::vector<Point> readChunk(const vsg::Path& filename)
+        {
+            std::vector<Point> points;
+            std::ifstream fin(filename, std::ios::in | std::ios::binary | std::ios::ate);
+            if (!fin) return points;
+
+            auto size = static_cast<size_t>(fin.tellg());
+            fin.seekg(0);
+            points.resize(size / sizeof(Point));
+            fin.read(reinterpret_cast<char*>(points.data()), points.size() * sizeof(Point));
+            points.resize(static_cast<size_t>(fin.gcount()) / sizeof(Point));
+            return points;
+        }
+
+        /// stream the points through the nodes above the chunks, keeping those that fall in unoccupied cells of the nodes' grids and appending the rest to their chunk's file.
+        bool distribute(PointSource& source, const vsg::Path& chunkDirectory)
+        {
+            std::vector<Point> points;
+            source.rewind();
+            while (source.read(points, s_readSize) > 0)
+            {
+                for (auto& point : points)
+                {
+                    auto c = gridCell(point.position);
+                    auto index = _cellChunks[(static_cast<size_t>(c.z) * s_gridSize + c.y) * s_gridSize + c.x];
+                    auto& chunk = _chunks[index];
+
+                    bool kept = false;
+                    for (uint32_t level = 0; level < chunk.level && !kept; ++level)
+                    {
+                        uint32_t shift = s_gridLevel - level;
+                        uint32_t x = c.x >> shift, y = c.y >> shift, z = c.z >> shift;
+                        auto& node = _upperNodes[nodeKey(level, x, y, z)];
+                        if (node.cells.insert(nodeCell(point.position, nodeMin(level, x, y, z), nodeSize(level))).second)
+                        {
+                            node.points.push_back(point);
+                            kept = true;
+                        }
+                    }
+                    if (kept) continue;
+
+                    chunk.buffer.push_back(point);
+                    if (chunk.buffer.size() >= s_chunkBufferSize && !appendChunk(chunkFilename(chunkDirectory, index), chunk.buffer))
+                    {
+                        vsg::warn("pointcloud::read() unable to write to ", chunkDirectory);
+                        return false;
+                    }
+                }
+                if (cancelled()) return false;
+            }
+
+            for (size_t i = 0; i < _chunks.size(); ++i)
+            {
+                if (!appendChunk(chunkFilename(chunkDirectory, i), _chunks[i].buffer))
+                {
+                    vsg::warn("pointcloud::read() unable to write to ", chunkDirectory);
+                    return false;
+                }
+                _chunks[i].buffer.shrink_to_fit();
+            }
+            return true;
+        }
+
+        /// build the subtree of a node from its points, writing its tiles, returning false if it has no points.
+        bool buildNode(uint32_t level, uint32_t x, uint32_t y, uint32_t z, std::vector<Point>& points)
+        {
+            if (points.empty()) return false;
+
+            std::vector<Point> kept;
+            std::array<std::vector<Point>, 8> children;
+            if (points.size() <= pointsPerTile || level >= maxLevel)
+            {
+                kept.swap(points);
+            }
+            else
+            {
+                auto minimum = nodeMin(level, x, y, z);
+                double size = nodeSize(level);
+                auto center = minimum + vsg::dvec3(size, size, size) * 0.5;
+
+                std::unordered_set<uint32_t> cells;
+                for (auto& point : points)
+                {
+                    if (cells.insert(nodeCell(point.position, minimum, size)).second)
+                    {
+                        kept.push_back(point);
+                    }
+                    else
+                    {
+                        auto& p = point.position;
+                        children[(p.x >= center.x ? 1 : 0) | (p.y >= center.y ? 2 : 0) | (p.z >= center.z ? 4 : 0)].push_back(point);
+                    }
+                }
+                std::vector<Point>().swap(points);
+            }
+
+            std::array<bool, 8> childExists;
+            for (uint32_t c = 0; c < 8; ++c)
+            {
+                childExists[c] = buildNode(level + 1, x * 2 + (c & 1), y * 2 + ((c >> 1) & 1), z * 2 + (c >> 2), children[c]);
+            }
+
+            return writeTile(createTile(level, x, y, z, kept, childExists), tileFilename(level, x, y, z));
+        }
+
+        /// write the tiles of the nodes above the chunks, deepest first so that each knows which of its children exist, returning the root tile.
+        vsg::ref_ptr<vsg::Node> buildUpperNodes()
+        {
+            std::unordered_map<uint64_t, bool> exists;
+            std::vector<std::vector<vsg::uivec3>> levels(s_gridLevel);
+            for (auto& chunk : _chunks)
+            {
+                exists[nodeKey(chunk.level, chunk.x, chunk.y, chunk.z)] = chunk.exists;
+                for (uint32_t level = 0; level < chunk.level; ++level)
+                {
+                    uint32_t shift = chunk.level - level;
+                    vsg::uivec3 node(chunk.x >> shift, chunk.y >> shift, chunk.z >> shift);
+                    if (exists.emplace(nodeKey(level, node.x, node.y, node.z), false).second) levels[level].push_back(node);
+                }
+            }
+
+            vsg::ref_ptr<vsg::Node> root;
+            for (uint32_t level = s_gridLevel; level-- > 0;)
+            {
+                for (auto& node : levels[level])
+                {
+                    std::array<bool, 8> childExists;
+                    bool anyChildren = false;
+                    for (uint32_t c = 0; c < 8; ++c)
+                    {
+                        auto itr = exists.find(nodeKey(level + 1, node.x * 2 + (c & 1), node.y * 2 + ((c >> 1) & 1), node.z * 2 + (c >> 2)));
+                        childExists[c] = itr != exists.end() && itr->second;
+                        anyChildren = anyChildren || childExists[c];
+                    }
+
+                    auto key = nodeKey(level, node.x, node.y, node.z);
+                    std::vector<Point> points;
+                    if (auto itr = _upperNodes.find(key); itr != _upperNodes.end()) points.swap(itr->second.points);
+                    if (points.empty() && !anyChildren) continue;
+
+                    auto tile = createTile(level, node.x, node.y, node.z, points, childExists);
+                    if (level > 0 && !writeTile(tile, tileFilename(level, node.x, node.y, node.z))) return {};
+
+                    exists[key] = true;
+                    if (level == 0) root = tile;
+                }
+            }
+
+            // the whole point cloud fits in one chunk, so the root is the chunk's root
+            if (!root && !_chunks.empty() && _chunks.front().level == 0 && _chunks.front().exists)
+            {
+                root = vsg::read_cast<vsg::Node>(tileDirectory / tileFilename(0, 0, 0, 0), tileOptions);
+            }
+            else if (root && !writeTile(root, tileFilename(0, 0, 0, 0)))
+            {
+                return {};
+            }
+            _upperNodes.clear();
+            return root;
+        }
+
+        void createConfig()
+        {
+            auto shaderSet = vsg::createFlatShadedShaderSet(tileOptions);
+            _config = vsg::GraphicsPipelineConfigurator::create(shaderSet);
+
+            auto material = vsg::DescriptorConfigurator::create(shaderSet);
+            material->assignDescriptor("material", vsg::PhongMaterialValue::create());
+            _config->descriptorConfigurator = material;
+
+            vsg::DataList vertexArrays;
+            _config->assignArray(vertexArrays, "vsg_Vertex", VK_VERTEX_INPUT_RATE_VERTEX, vsg::svec4Array::create(1, vsg::Data::Properties{VK_FORMAT_R16G16B16A16_SNORM}));
+            _assignedNormal = _config->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec3Value::create(0.0f, 0.0f, 1.0f));
+            _assignedTexCoord = _config->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_INSTANCE, vsg::vec2Value::create(0.0f, 0.0f));
+            _config->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_VERTEX, vsg::ubvec4Array::create(1, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM}));
+
+            struct SetPipelineStates : public vsg::Visitor
+            {
+                void apply(vsg::Object& object) override { object.traverse(*this); }
+                void apply(vsg::RasterizationState& rs) override { rs.cullMode = VK_CULL_MODE_NONE; }
+                void apply(vsg::InputAssemblyState& ias) override { ias.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST; }
+            } sps;
+            _config->accept(sps);
+            _config->init();
+
+            // point colors are sRGB, so convert them to the color space the ShaderSet expects
+            auto colorSpace = shaderSet->getAttributeBinding("vsg_Color").coordinateSpace;
+            for (size_t i = 0; i < _colorTable.size(); ++i)
+            {
+                vsg::vec4 color(i / 255.0f, i / 255.0f, i / 255.0f, 1.0f);
+                vsg::convert(color, vsg::CoordinateSpace::sRGB, colorSpace);
+                _colorTable[i] = static_cast<uint8_t>(std::clamp(color.r, 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+
+        /// create the subgraph of a node, its points quantized to snorm16 within its cube and unorm8 colors, with a vsg::PagedLOD for each of its children.
+        vsg::ref_ptr<vsg::Node> createTile(uint32_t level, uint32_t x, uint32_t y, uint32_t z, const std::vector<Point>& points, const std::array<bool, 8>& childExists) const
+        {
+            auto group = vsg::Group::create();
+            double size = nodeSize(level);
+            double halfSize = size * 0.5;
+            auto center = nodeMin(level, x, y, z) + vsg::dvec3(halfSize, halfSize, halfSize);
+
+            if (!points.empty())
+            {
+                auto numPoints = static_cast<uint32_t>(points.size());
+                auto vertices = vsg::svec4Array::create(numPoints, vsg::Data::Properties{VK_FORMAT_R16G16B16A16_SNORM});
+                auto colors = vsg::ubvec4Array::create(numPoints, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
+
+                auto quantize = [](double value) { return static_cast<int16_t>(std::lround(std::clamp(value, -1.0, 1.0) * 32767.0)); };
+                double inverseScale = 1.0 / halfSize;
+                for (uint32_t i = 0; i < numPoints; ++i)
+                {
+                    auto v = (points[i].position - center) * inverseScale;
+                    vertices->at(i).set(quantize(v.x), quantize(v.y), quantize(v.z), 32767);
+
+                    auto& c = points[i].color;
+                    colors->at(i).set(_colorTable[c.r], _colorTable[c.g], _colorTable[c.b], c.a);
+                }
+
+                // the tiles are created concurrently, so rather than assigning the arrays through the shared GraphicsPipelineConfigurator, list them in the order createConfig() assigned their bindings
+                vsg::DataList vertexArrays{vertices};
+                if (_assignedNormal) vertexArrays.push_back(vsg::vec3Value::create(0.0f, 0.0f, 1.0f));
+                if (_assignedTexCoord) vertexArrays.push_back(vsg::vec2Value::create(0.0f, 0.0f));
+                vertexArrays.push_back(colors);
+
+                auto draw = vsg::VertexDraw::create();
+                draw->assignArrays(vertexArrays);
+                draw->vertexCount = numPoints;
+                draw->instanceCount = 1;
+
+                auto dequantize = vsg::MatrixTransform::create(vsg::translate(center) * vsg::scale(halfSize, halfSize, halfSize));
+                dequantize->subgraphRequiresLocalFrustum = false;
+                dequantize->addChild(draw);
+
+                auto stateGroup = vsg::StateGroup::create();
+                _config->copyTo(stateGroup);
+                stateGroup->addChild(dequantize);
+                group->addChild(stateGroup);
+            }
+
+            double childHalfSize = halfSize * 0.5;
+            for (uint32_t c = 0; c < 8; ++c)
+            {
+                if (!childExists[c]) continue;
+
+                uint32_t cx = x * 2 + (c & 1), cy = y * 2 + ((c >> 1) & 1), cz = z * 2 + (c >> 2);
+                auto childCenter = nodeMin(level + 1, cx, cy, cz) + vsg::dvec3(childHalfSize, childHalfSize, childHalfSize);
+
+                // the children add detail to this tile's points, so there's no lower resolution child to draw until they are loaded
+                auto plod = vsg::PagedLOD::create();
+                plod->bound = vsg::dsphere(childCenter, childHalfSize * std::sqrt(3.0));
+                plod->children[0] = vsg::PagedLOD::Child{lodScreenRatio, {}};
+                plod->children[1] = vsg::PagedLOD::Child{0.0, vsg::Group::create()};
+                plod->filename = tileFilename(level + 1, cx, cy, cz);
+                plod->options = tileOptions;
+                group->addChild(plod);
+            }
+
+            return group;
+        }
+
+        bool writeTile(vsg::ref_ptr<vsg::Node> tile, const vsg::Path& filename) const
+        {
+            auto fullPath = tileDirectory / filename;
+            auto directory = vsg::filePath(fullPath);
+            if (!vsg::fileExists(directory) && !vsg::makeDirectory(directory))
+            {
+                vsg::warn("pointcloud::read() unable to create ", directory);
+                return false;
+            }
+
+            if (!vsg::VSG().write(tile, fullPath, tileOptions))
+            {
+                vsg::warn("pointcloud::read() unable to write ", fullPath);
+                return false;
+            }
+            return true;
+        }
+    };
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// pointcloud ReaderWriter
+//
+pointcloud::pointcloud()
+{
+}
+
+vsg::ref_ptr<vsg::Object> pointcloud::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    auto ext = vsg::lowerCaseFileExtension(filename);
+    if (!supportedExtension(ext)) return {};
+
+    auto filenameToUse = vsg::findFile(filename, options);
+    if (!filenameToUse) return {};
+
+    OctreeBuilder builder;
+    builder.pointsPerTile = std::max(1u, vsg::value<uint32_t>(builder.pointsPerTile, pointcloud::points_per_tile, options.get()));
+    builder.resolution = std::clamp(vsg::value<uint32_t>(builder.resolution, pointcloud::tile_resolution, options.get()), 1u, 1024u);
+    builder.chunkPoints = std::max(uint64_t(1), vsg::value<uint64_t>(builder.chunkPoints, pointcloud::chunk_points, options.get()));
+    builder.lodScreenRatio = vsg::value<double>(builder.lodScreenRatio, pointcloud::lod_screen_ratio, options.get());
+    builder.numThreads = vsg::value<uint32_t>(std::thread::hardware_concurrency(), pointcloud::num_threads, options.get());
+    builder.cancellation = getCancellationToken(options.get());
+
+    // the tiles are written to a directory named by a hash of the file's path, size, modification time and the settings used to build them, so an unchanged file reuses its tiles
+    std::error_code ec;
+    auto fileSize = std::filesystem::file_size(filenameToUse.string(), ec);
+    auto modified = std::filesystem::last_write_time(filenameToUse.string(), ec).time_since_epoch().count();
+
+    std::stringstream settings;
+    settings << filenameToUse.string() << " " << fileSize << " " << modified << " " << builder.pointsPerTile << " " << builder.resolution << " " << builder.lodScreenRatio;
+    auto settingsString = settings.str();
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (auto c : settingsString) hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+
+    std::stringstream directoryName;
+    directoryName << vsg::simpleFilename(filenameToUse) << "_" << std::hex << std::setw(16) << std::setfill('0') << hash;
+
+    vsg::Path tileDirectory;
+    std::string tileDirectoryString;
+    if (options && options->getValue(pointcloud::tile_directory, tileDirectoryString) && !tileDirectoryString.empty())
+        tileDirectory = tileDirectoryString;
+    else if (options && options->fileCache)
+        tileDirectory = options->fileCache / directoryName.str();
+    else
+        tileDirectory = vsg::Path(std::filesystem::temp_directory_path(ec).string()) / "vsgXchange_pointcloud" / directoryName.str();
+
+    // the tiles are read with the tile directory in the paths so the PagedLOD filenames, relative to the tile directory, are found
+    auto tileOptions = options ? vsg::Options::create(*options) : vsg::Options::create();
+    tileOptions->paths.insert(tileOptions->paths.begin(), tileDirectory);
+    builder.tileDirectory = tileDirectory;
+    builder.tileOptions = tileOptions;
+
+    // the root tile is written last, so its presence shows that a previous read completed the octree
+    auto rootFilename = tileDirectory / OctreeBuilder::tileFilename(0, 0, 0, 0);
+    if (!vsg::value<bool>(false, pointcloud::rebuild, options.get()) && vsg::fileExists(rootFilename))
+    {
+        if (auto root = vsg::read_cast<vsg::Node>(rootFilename, tileOptions)) return root;
+    }
+    std::remove(rootFilename.string().c_str());
+
+    if (!vsg::fileExists(tileDirectory) && !vsg::makeDirectory(tileDirectory))
+    {
+        vsg::warn("pointcloud::read(", filename, ") unable to create tile_directory ", tileDirectory);
+        return {};
+    }
+
+    auto source = openPointSource(filenameToUse, ext);
+    if (!source) return {};
+
+    vsg::info("pointcloud::read(", filename, ") building octree of ", source->count, " points in ", tileDirectory);
+    auto root = builder.build(*source);
+    if (root) root->setValue("tile_directory", tileDirectory.string());
+    return root;
+}
+
+bool pointcloud::supportedExtension(const vsg::Path& ext) const
+{
+    if (ext == ".las") return true;
+#ifdef USE_LASZIP
+    if (ext == ".laz") return true;
+#endif
+#ifdef USE_E57
+    if (ext == ".e57") return true;
+#endif
+    return false;
+}
+
+bool pointcloud::getFeatures(Features& features) const
+{
+    features.extensionFeatureMap[".las"] = vsg::ReaderWriter::READ_FILENAME;
+#ifdef USE_LASZIP
+    features.extensionFeatureMap[".laz"] = vsg::ReaderWriter::READ_FILENAME;
+#endif
+#ifdef USE_E57
+    features.extensionFeatureMap[".e57"] = vsg::ReaderWriter::READ_FILENAME;
+#endif
+
+    features.optionNameTypeMap[pointcloud::tile_directory] = vsg::type_name<std::string>();
+    features.optionNameTypeMap[pointcloud::points_per_tile] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[pointcloud::tile_resolution] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[pointcloud::chunk_points] = vsg::type_name<uint64_t>();
+    features.optionNameTypeMap[pointcloud::lod_screen_ratio] = vsg::type_name<double>();
+    features.optionNameTypeMap[pointcloud::num_threads] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[pointcloud::rebuild] = vsg::type_name<bool>();
+
+    return true;
+}
+
+bool pointcloud::readOptions(vsg::Options& options, vsg::CommandLine& arguments) const
+{
+    bool result = arguments.readAndAssign<std::string>(pointcloud::tile_directory, &options);
+    result = arguments.readAndAssign<uint32_t>(pointcloud::points_per_tile, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(pointcloud::tile_resolution, &options) || result;
+    result = arguments.readAndAssign<uint64_t>(pointcloud::chunk_points, &options) || result;
+    result = arguments.readAndAssign<double>(pointcloud::lod_screen_ratio, &options) || result;
+    result = arguments.readAndAssign<uint32_t>(pointcloud::num_threads, &options) || result;
+    result = arguments.readAndAssign<bool>(pointcloud::rebuild, &options) || result;
+    return result;
+}
@@ -11,6 +11,12 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 </editor-fold> */
 
 #include <vsgXchange/images.h>
+#include <vsgXchange/read_memory.h>
+
+#include "../all/color_space.h"
+#include "../all/image_downsample.h"
+#include "../all/mapped_file.h"
+#include "../all/stream_utils.h"
 
 #include <vsg/io/FileSystem.h>
 #include <vsg/io/Logger.h>
@@ -18,11 +24,23 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <vsg/utils/CommandLine.h>
 
 #include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
 
 #include <iostream>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define VSGXCHANGE_STBI_SSE2
+#    include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    define VSGXCHANGE_STBI_NEON
+#    include <arm_neon.h>
+#endif
+
 #define STB_IMAGE_STATIC
 #define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_STATIC
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 
 #if defined(__GNUC__)
@@ -49,7 +67,7 @@ void* cpp_realloc_sized(void* old_ptr, size_t old_size, size_t new_size)
 
     if (old_size >= new_size) return old_ptr;
 
-    void* new_ptr = vsg::allocate(new_size);
+    void* new_ptr = vsg::allocate(new_size, vsg::ALLOCATOR_AFFINITY_DATA);
 
     std::memcpy(new_ptr, old_ptr, old_size);
 
@@ -78,18 +96,199 @@ static void writeToStream(void* context, void* data, int size)
     reinterpret_cast<std::ostream*>(context)->write(reinterpret_cast<const char*>(data), size);
 }
 
-static void process_image_format(vsg::ref_ptr<const vsg::Options> options, VkFormat& format)
+// number of components to decode an image with, by default all images are expanded to RGBA, with native_channels 1 and 2 channel images retain their channels
+// and RGB is only expanded to RGBA when options->mapRGBtoRGBAHint is set.
+static int required_components(int channels, vsg::ref_ptr<const vsg::Options> options)
+{
+    bool native_channels = false;
+    if (!options || !options->getValue(stbi::native_channels, native_channels) || !native_channels) return STBI_rgb_alpha;
+
+    if (channels == STBI_rgb && options->mapRGBtoRGBAHint) return STBI_rgb_alpha;
+    return (channels >= STBI_grey && channels <= STBI_rgb_alpha) ? channels : STBI_rgb_alpha;
+}
+
+// wrap the pixels decoded by stbi in a vsg::Data of the type matching the number of components, taking ownership of the pixels.
+template<typename T>
+static vsg::ref_ptr<vsg::Data> create_image(T* pixels, int width, int height, int components, const VkFormat (&formats)[4])
+{
+    if (!pixels) return {};
+
+    using vec2_type = vsg::t_vec2<T>;
+    using vec3_type = vsg::t_vec3<T>;
+    using vec4_type = vsg::t_vec4<T>;
+
+    VkFormat format = formats[components - 1];
+    switch (components)
+    {
+    case (STBI_grey): return vsg::Array2D<T>::create(width, height, pixels, vsg::Data::Properties{format});
+    case (STBI_grey_alpha): return vsg::Array2D<vec2_type>::create(width, height, reinterpret_cast<vec2_type*>(pixels), vsg::Data::Properties{format});
+    case (STBI_rgb): return vsg::Array2D<vec3_type>::create(width, height, reinterpret_cast<vec3_type*>(pixels), vsg::Data::Properties{format});
+    default: return vsg::Array2D<vec4_type>::create(width, height, reinterpret_cast<vec4_type*>(pixels), vsg::Data::Properties{format});
+    }
+}
+
+static vsg::ref_ptr<vsg::Data> create_image(stbi_uc* pixels, int width, int height, int components, vsg::ref_ptr<const vsg::Options> options)
+{
+    static const VkFormat formats[4] = {VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8B8_SRGB, VK_FORMAT_R8G8B8A8_SRGB};
+
+    auto vsg_data = create_image(reinterpret_cast<uint8_t*>(pixels), width, height, components, formats);
+    if (vsg_data) applyImageFormat(*vsg_data, options.get());
+    return vsg_data;
+}
+
+static vsg::ref_ptr<vsg::Data> create_image(stbi_us* pixels, int width, int height, int components)
+{
+    static const VkFormat formats[4] = {VK_FORMAT_R16_UNORM, VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16A16_UNORM};
+    return create_image(reinterpret_cast<uint16_t*>(pixels), width, height, components, formats);
+}
+
+static vsg::ref_ptr<vsg::Data> create_image(float* pixels, int width, int height, int components)
+{
+    static const VkFormat formats[4] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+    return create_image(pixels, width, height, components, formats);
+}
+
+// reserve the decoded image against the read's read_memory_budget before decoding it.
+static bool reserve_image(int width, int height, int components, size_t componentSize)
+{
+    return vsgXchange::reserveReadMemory(static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * static_cast<uint64_t>(components) * componentSize);
+}
+
+static vsg::ref_ptr<vsg::Data> read_image(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options)
+{
+    int width, height, channels;
+    int components = STBI_rgb_alpha;
+    if (!stbi_info_from_memory(ptr, static_cast<int>(size), &width, &height, &channels)) return {};
+    components = required_components(channels, options);
+
+    bool hdr = stbi_is_hdr_from_memory(ptr, static_cast<int>(size)) != 0;
+    bool is16bit = !hdr && stbi_is_16_bit_from_memory(ptr, static_cast<int>(size));
+    if (!reserve_image(width, height, components, hdr ? sizeof(float) : (is16bit ? sizeof(stbi_us) : sizeof(stbi_uc)))) return {};
+
+    // decode .hdr as float and 16 bit PNG/PNM as uint16_t to retain their precision
+    if (hdr)
+    {
+        return create_image(stbi_loadf_from_memory(ptr, static_cast<int>(size), &width, &height, &channels, components), width, height, components);
+    }
+
+    if (is16bit)
+    {
+        return create_image(stbi_load_16_from_memory(ptr, static_cast<int>(size), &width, &height, &channels, components), width, height, components);
+    }
+
+    return create_image(stbi_load_from_memory(ptr, static_cast<int>(size), &width, &height, &channels, components), width, height, components, options);
+}
+
+static vsg::ref_ptr<vsg::Data> read_image(FILE* file, vsg::ref_ptr<const vsg::Options> options)
+{
+    int width, height, channels;
+    int components = STBI_rgb_alpha;
+    if (!stbi_info_from_file(file, &width, &height, &channels)) return {};
+    components = required_components(channels, options);
+
+    bool hdr = stbi_is_hdr_from_file(file) != 0;
+    bool is16bit = !hdr && stbi_is_16_bit_from_file(file);
+    if (!reserve_image(width, height, components, hdr ? sizeof(float) : (is16bit ? sizeof(stbi_us) : sizeof(stbi_uc)))) return {};
+
+    if (hdr)
+    {
+        return create_image(stbi_loadf_from_file(file, &width, &height, &channels, components), width, height, components);
+    }
+
+    if (is16bit)
+    {
+        return create_image(stbi_load_from_file_16(file, &width, &height, &channels, components), width, height, components);
+    }
+
+    return create_image(stbi_load_from_file(file, &width, &height, &channels, components), width, height, components, options);
+}
+
+// swap the red and blue channels of count pixels. BGRA is swapped four pixels at a time with SSE2 masks and shifts of each 32 bit pixel,
+// NEON de-interleaves 16 pixels of either layout into planes so the red and blue planes can be exchanged, the remainder is done a pixel at a time.
+template<size_t N>
+static void swizzleRedBlue(const uint8_t* __restrict src, uint8_t* __restrict dest, size_t count)
 {
-    if (!options) return;
+    size_t i = 0;
+#if defined(VSGXCHANGE_STBI_SSE2)
+    if constexpr (N == 4)
+    {
+        const __m128i redBlueMask = _mm_set1_epi32(0x00FF00FF);
+        for (; i + 4 <= count; i += 4, src += 16, dest += 16)
+        {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            __m128i redBlue = _mm_and_si128(pixels, redBlueMask);
+            __m128i swapped = _mm_or_si128(_mm_slli_epi32(redBlue, 16), _mm_srli_epi32(redBlue, 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_or_si128(_mm_andnot_si128(redBlueMask, pixels), swapped));
+        }
+    }
+#elif defined(VSGXCHANGE_STBI_NEON)
+    for (; i + 16 <= count; i += 16, src += 16 * N, dest += 16 * N)
+    {
+        if constexpr (N == 3)
+        {
+            uint8x16x3_t pixels = vld3q_u8(src);
+            std::swap(pixels.val[0], pixels.val[2]);
+            vst3q_u8(dest, pixels);
+        }
+        else
+        {
+            uint8x16x4_t pixels = vld4q_u8(src);
+            std::swap(pixels.val[0], pixels.val[2]);
+            vst4q_u8(dest, pixels);
+        }
+    }
+#endif
 
-    vsg::CoordinateSpace coordinateSpace;
-    if (options->getValue(stbi::image_format, coordinateSpace))
+    for (; i < count; ++i, src += N, dest += N)
     {
-        if (coordinateSpace==vsg::CoordinateSpace::sRGB) format = vsg::uNorm_to_sRGB(format);
-        else if (coordinateSpace==vsg::CoordinateSpace::LINEAR) format = vsg::sRGB_to_uNorm(format);
+        dest[0] = src[2];
+        dest[1] = src[1];
+        dest[2] = src[0];
+        if constexpr (N == 4) dest[3] = src[3];
     }
 }
 
+// stb_image_write keeps the png settings in statics shared by all threads, so writes using the default settings share the lock
+// while a write with its own settings holds it exclusively, applying the settings for the duration of the write and restoring the defaults on destruction.
+static std::shared_mutex s_pngSettingsMutex;
+
+struct ScopedPngSettings
+{
+    explicit ScopedPngSettings(vsg::ref_ptr<const vsg::Options> options)
+    {
+        int compression_level = default_compression_level;
+        int filter = default_filter;
+        if (options)
+        {
+            options->getValue(stbi::png_compression_level, compression_level);
+            options->getValue(stbi::png_filter, filter);
+        }
+
+        if (compression_level == default_compression_level && filter == default_filter)
+        {
+            sharedLock = std::shared_lock<std::shared_mutex>(s_pngSettingsMutex);
+            return;
+        }
+
+        exclusiveLock = std::unique_lock<std::shared_mutex>(s_pngSettingsMutex);
+        stbi_write_png_compression_level = compression_level;
+        stbi_write_force_png_filter = filter;
+    }
+
+    ~ScopedPngSettings()
+    {
+        if (!exclusiveLock.owns_lock()) return;
+        stbi_write_png_compression_level = default_compression_level;
+        stbi_write_force_png_filter = default_filter;
+    }
+
+    static constexpr int default_compression_level = 8;
+    static constexpr int default_filter = -1;
+
+    std::shared_lock<std::shared_mutex> sharedLock;
+    std::unique_lock<std::shared_mutex> exclusiveLock;
+};
+
 // if the data is in BGR or BGRA form create a copy that is reformated into RGB or RGBA respectively
 static std::pair<int, vsg::ref_ptr<const vsg::Data>> reformatForWriting(const vsg::Data* data, const vsg::Path& filename)
 {
@@ -114,12 +313,7 @@ static std::pair<int, vsg::ref_ptr<const vsg::Data>> reformatForWriting(const vs
     case (VK_FORMAT_B8G8R8_SRGB):
     case (VK_FORMAT_B8G8R8_UNORM): {
         auto dest_data = vsg::ubvec3Array2D::create(data->width(), data->height(), vsg::Data::Properties{VK_FORMAT_R8G8B8_UNORM});
-        auto src_ptr = static_cast<const vsg::ubvec3*>(data->dataPointer());
-        for (auto& dest : *dest_data)
-        {
-            auto& src = *(src_ptr++);
-            dest.set(src[2], src[1], src[0]);
-        }
+        swizzleRedBlue<3>(static_cast<const uint8_t*>(data->dataPointer()), static_cast<uint8_t*>(dest_data->dataPointer()), dest_data->valueCount());
 
         num_components = 3;
         local_data = dest_data;
@@ -128,12 +322,7 @@ static std::pair<int, vsg::ref_ptr<const vsg::Data>> reformatForWriting(const vs
     case (VK_FORMAT_B8G8R8A8_SRGB):
     case (VK_FORMAT_B8G8R8A8_UNORM): {
         auto dest_data = vsg::ubvec4Array2D::create(data->width(), data->height(), vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
-        auto src_ptr = static_cast<const vsg::ubvec4*>(data->dataPointer());
-        for (auto& dest : *dest_data)
-        {
-            auto& src = *(src_ptr++);
-            dest.set(src[2], src[1], src[0], src[3]);
-        }
+        swizzleRedBlue<4>(static_cast<const uint8_t*>(data->dataPointer()), static_cast<uint8_t*>(dest_data->dataPointer()), dest_data->valueCount());
 
         num_components = 4;
         local_data = dest_data;
@@ -147,7 +336,7 @@ static std::pair<int, vsg::ref_ptr<const vsg::Data>> reformatForWriting(const vs
 }
 
 stbi::stbi() :
-    _supportedExtensions{".jpg", ".jpeg", ".jpe", ".png", ".gif", ".bmp", ".tga", ".psd", ".pgm", ".ppm"}
+    _supportedExtensions{".jpg", ".jpeg", ".jpe", ".png", ".gif", ".bmp", ".tga", ".psd", ".pgm", ".ppm", ".hdr"}
 {
 }
 
@@ -164,9 +353,15 @@ bool stbi::getFeatures(Features& features) const
     features.extensionFeatureMap[".psd"] = read_mask;
     features.extensionFeatureMap[".pgm"] = read_mask;
     features.extensionFeatureMap[".ppm"] = read_mask;
+    features.extensionFeatureMap[".hdr"] = read_mask;
 
     features.optionNameTypeMap[stbi::jpeg_quality] = vsg::type_name<int>();
     features.optionNameTypeMap[stbi::image_format] = vsg::type_name<vsg::CoordinateSpace>();
+    features.optionNameTypeMap[stbi::convert_pixels] = vsg::type_name<bool>();
+    features.optionNameTypeMap[stbi::native_channels] = vsg::type_name<bool>();
+    features.optionNameTypeMap[stbi::png_compression_level] = vsg::type_name<int>();
+    features.optionNameTypeMap[stbi::png_filter] = vsg::type_name<int>();
+    features.optionNameTypeMap[images::max_texture_size] = vsg::type_name<uint32_t>();
 
     return true;
 }
@@ -175,6 +370,11 @@ bool stbi::readOptions(vsg::Options& options, vsg::CommandLine& arguments) const
 {
     bool result = arguments.readAndAssign<int>(stbi::jpeg_quality, &options);
     result = arguments.readAndAssign<vsg::CoordinateSpace>(stbi::image_format, &options) | result;
+    result = arguments.readAndAssign<bool>(stbi::convert_pixels, &options) | result;
+    result = arguments.readAndAssign<bool>(stbi::native_channels, &options) | result;
+    result = arguments.readAndAssign<int>(stbi::png_compression_level, &options) | result;
+    result = arguments.readAndAssign<int>(stbi::png_filter, &options) | result;
+    result = arguments.readAndAssign<uint32_t>(images::max_texture_size, &options) | result;
     return result;
 }
 
@@ -185,65 +385,38 @@ vsg::ref_ptr<vsg::Object> stbi::read(const vsg::Path& filename, vsg::ref_ptr<con
     vsg::Path filenameToUse = findFile(filename, options);
     if (!filenameToUse) return {};
 
-    int width, height, channels;
+    // decode directly from a memory mapping of the file, falling back to stdio when the file can't be mapped.
+    // stbi only decodes at full resolution, so images larger than the max_texture_size are box filtered down once decoded.
+    if (vsgXchange::MappedFile mappedFile(filenameToUse); mappedFile)
+    {
+        return downsampleImage(read_image(mappedFile.data(), mappedFile.size(), options), maxTextureSize(options.get()));
+    }
 
     auto file = vsg::fopen(filenameToUse, "rb");
     if (!file) return {};
 
-    const auto pixels = stbi_load_from_file(file, &width, &height, &channels, STBI_rgb_alpha);
+    auto image = read_image(file, options);
 
     fclose(file);
 
-    if (pixels)
-    {
-        auto vsg_data = vsg::ubvec4Array2D::create(width, height, reinterpret_cast<vsg::ubvec4*>(pixels), vsg::Data::Properties{VK_FORMAT_R8G8B8A8_SRGB});
-        process_image_format(options, vsg_data->properties.format);
-        return vsg_data;
-    }
-
-    return {};
+    return downsampleImage(image, maxTextureSize(options.get()));
 }
 
 vsg::ref_ptr<vsg::Object> stbi::read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options) const
 {
     if (!vsg::compatibleExtension(options, _supportedExtensions)) return {};
 
-    std::string buffer(1 << 16, 0); // 64kB
-    std::string input;
-
-    while (!fin.eof())
-    {
-        fin.read(&buffer[0], buffer.size());
-        const auto bytes_readed = fin.gcount();
-        input.append(&buffer[0], bytes_readed);
-    }
-
-    int width, height, channels;
-    const auto pixels = stbi_load_from_memory(reinterpret_cast<stbi_uc*>(input.data()), static_cast<int>(input.size()), &width, &height, &channels, STBI_rgb_alpha);
-    if (pixels)
-    {
-        auto vsg_data = vsg::ubvec4Array2D::create(width, height, reinterpret_cast<vsg::ubvec4*>(pixels), vsg::Data::Properties{VK_FORMAT_R8G8B8A8_SRGB});
-        process_image_format(options, vsg_data->properties.format);
-        return vsg_data;
-    }
+    vsgXchange::StreamData input;
+    if (!vsgXchange::readStream(fin, input)) return {};
 
-    return {};
+    return downsampleImage(read_image(input.data, input.size, options), maxTextureSize(options.get()));
 }
 
 vsg::ref_ptr<vsg::Object> stbi::read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options) const
 {
     if (!vsg::compatibleExtension(options, _supportedExtensions)) return {};
 
-    int width, height, channels;
-    const auto pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(ptr), static_cast<int>(size), &width, &height, &channels, STBI_rgb_alpha);
-    if (pixels)
-    {
-        auto vsg_data = vsg::ubvec4Array2D::create(width, height, reinterpret_cast<vsg::ubvec4*>(pixels), vsg::Data::Properties{VK_FORMAT_R8G8B8A8_SRGB});
-        process_image_format(options, vsg_data->properties.format);
-        return vsg_data;
-    }
-
-    return {};
+    return downsampleImage(read_image(ptr, size, options), maxTextureSize(options.get()));
 }
 
 bool stbi::write(const vsg::Object* object, std::ostream& stream, vsg::ref_ptr<const vsg::Options> options) const
@@ -265,6 +438,7 @@ bool stbi::write(const vsg::Object* object, std::ostream& stream, vsg::ref_ptr<c
     int result = 0;
     if (ext == ".png")
     {
+        ScopedPngSettings pngSettings(options);
         result = stbi_write_png_to_func(&writeToStream, &stream, data->width(), data->height(), num_components, data->dataPointer(), data->properties.stride * data->width());
     }
     else if (ext == ".bmp")
@@ -308,6 +482,7 @@ bool stbi::write(const vsg::Object* object, const vsg::Path& filename, vsg::ref_
     int result = 0;
     if (ext == ".png")
     {
+        ScopedPngSettings pngSettings(options);
         result = stbi_write_png(filename_str.c_str(), data->width(), data->height(), num_components, data->dataPointer(), data->properties.stride * data->width());
     }
     else if (ext == ".bmp")
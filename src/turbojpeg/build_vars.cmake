@@ -0,0 +1,25 @@
+# add libjpeg-turbo if available
+find_package(libjpeg-turbo CONFIG QUIET)
+
+if(libjpeg-turbo_FOUND)
+    OPTION(vsgXchange_turbojpeg "Optional libjpeg-turbo support provided" ON)
+endif()
+
+if (${vsgXchange_turbojpeg})
+    set(SOURCES ${SOURCES}
+        turbojpeg/turbojpeg.cpp
+    )
+    if(TARGET libjpeg-turbo::turbojpeg)
+        set(EXTRA_LIBRARIES ${EXTRA_LIBRARIES} libjpeg-turbo::turbojpeg)
+    else()
+        set(EXTRA_LIBRARIES ${EXTRA_LIBRARIES} libjpeg-turbo::turbojpeg-static)
+    endif()
+
+    if(NOT BUILD_SHARED_LIBS)
+        set(FIND_DEPENDENCY ${FIND_DEPENDENCY} "find_dependency(libjpeg-turbo CONFIG)")
+    endif()
+else()
+    set(SOURCES ${SOURCES}
+        turbojpeg/turbojpeg_fallback.cpp
+    )
+endif()
@@ -0,0 +1,184 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgXchange/images.h>
+
+#include "../all/color_space.h"
+#include "../all/image_downsample.h"
+#include "../all/mapped_file.h"
+#include "../all/stream_utils.h"
+
+#include <vsg/io/FileSystem.h>
+#include <vsg/io/Logger.h>
+#include <vsg/utils/CommandLine.h>
+#include <vsg/utils/CoordinateSpace.h>
+
+#include <turbojpeg.h>
+
+#include <algorithm>
+#include <memory>
+
+using namespace vsgXchange;
+
+namespace
+{
+    /// choose the DCT scaling factor to decode with, the largest factor supported by libjpeg-turbo, no larger than the requested 1/scale, that fits within maxSize.
+    /// If none fit the smallest supported factor is used, with the remaining downscaling done by box filtering the decoded image. Returns null when no scaling is required.
+    const tjscalingfactor* chooseScalingFactor(uint32_t scale, uint32_t maxSize, int width, int height)
+    {
+        int numScalingFactors = 0;
+        const tjscalingfactor* scalingFactors = tjGetScalingFactors(&numScalingFactors);
+        if (!scalingFactors || numScalingFactors <= 0) return nullptr;
+
+        auto ratio = [](const tjscalingfactor& sf) { return static_cast<double>(sf.num) / static_cast<double>(sf.denom); };
+
+        const tjscalingfactor* requested = nullptr;
+        if (scale > 1)
+        {
+            for (int i = 0; i < numScalingFactors; ++i)
+            {
+                if (scalingFactors[i].num == 1 && scalingFactors[i].denom == static_cast<int>(scale)) requested = &scalingFactors[i];
+            }
+            if (!requested) vsg::warn("turbojpeg::read() jpeg_scale of ", scale, " not supported, use 1, 2, 4 or 8.");
+        }
+
+        if (maxSize == 0) return requested;
+
+        const double maxRatio = requested ? ratio(*requested) : 1.0;
+        const int largestDimension = std::max(width, height);
+        const tjscalingfactor* largestFitting = nullptr;
+        const tjscalingfactor* smallest = nullptr;
+        for (int i = 0; i < numScalingFactors; ++i)
+        {
+            auto& sf = scalingFactors[i];
+            if (ratio(sf) > maxRatio) continue;
+
+            if (!smallest || ratio(sf) < ratio(*smallest)) smallest = &sf;
+            if (TJSCALED(largestDimension, sf) <= static_cast<int>(maxSize) && (!largestFitting || ratio(sf) > ratio(*largestFitting))) largestFitting = &sf;
+        }
+
+        auto chosen = largestFitting ? largestFitting : smallest;
+        if (chosen && chosen->num == chosen->denom) return nullptr;
+        return chosen;
+    }
+
+    vsg::ref_ptr<vsg::Data> decode(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options)
+    {
+        std::unique_ptr<void, int (*)(tjhandle)> handle(tjInitDecompress(), tjDestroy);
+        if (!handle) return {};
+
+        int width, height, subsamp, colorspace;
+        if (tjDecompressHeader3(handle.get(), ptr, static_cast<unsigned long>(size), &width, &height, &subsamp, &colorspace) != 0)
+        {
+            vsg::debug("turbojpeg::read() unable to read header : ", tjGetErrorStr2(handle.get()));
+            return {};
+        }
+
+        // downscale during the decode so the full resolution image is never created
+        uint32_t scale = 1;
+        if (options) options->getValue(turbojpeg::jpeg_scale, scale);
+
+        const uint32_t maxSize = maxTextureSize(options.get());
+        if (auto scalingFactor = chooseScalingFactor(scale, maxSize, width, height))
+        {
+            width = TJSCALED(width, *scalingFactor);
+            height = TJSCALED(height, *scalingFactor);
+        }
+
+        // follow stbi's native_channels handling so that the format of the images is independent of which ReaderWriter decoded them
+        bool native_channels = false;
+        if (options) options->getValue(stbi::native_channels, native_channels);
+
+        vsg::ref_ptr<vsg::Data> vsg_data;
+        int pixelFormat = TJPF_RGBA;
+        if (native_channels && colorspace == TJCS_GRAY)
+        {
+            pixelFormat = TJPF_GRAY;
+            vsg_data = vsg::ubyteArray2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R8_UNORM});
+        }
+        else if (native_channels && !options->mapRGBtoRGBAHint)
+        {
+            pixelFormat = TJPF_RGB;
+            vsg_data = vsg::ubvec3Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R8G8B8_SRGB});
+        }
+        else
+        {
+            vsg_data = vsg::ubvec4Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_SRGB});
+        }
+
+        int pitch = width * tjPixelSize[pixelFormat];
+        if (tjDecompress2(handle.get(), ptr, static_cast<unsigned long>(size), static_cast<unsigned char*>(vsg_data->dataPointer()), width, pitch, height, pixelFormat, 0) != 0)
+        {
+            vsg::debug("turbojpeg::read() unable to decompress : ", tjGetErrorStr2(handle.get()));
+            return {};
+        }
+
+        applyImageFormat(*vsg_data, options.get());
+
+        return downsampleImage(vsg_data, maxSize);
+    }
+} // namespace
+
+turbojpeg::turbojpeg() :
+    _supportedExtensions{".jpg", ".jpeg", ".jpe"}
+{
+}
+
+vsg::ref_ptr<vsg::Object> turbojpeg::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!vsg::compatibleExtension(filename, options, _supportedExtensions)) return {};
+
+    vsg::Path filenameToUse = vsg::findFile(filename, options);
+    if (!filenameToUse) return {};
+
+    vsgXchange::MappedFile mappedFile(filenameToUse);
+    if (!mappedFile) return {};
+
+    return decode(mappedFile.data(), mappedFile.size(), options);
+}
+
+vsg::ref_ptr<vsg::Object> turbojpeg::read(std::istream& fin, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!vsg::compatibleExtension(options, _supportedExtensions)) return {};
+
+    vsgXchange::StreamData input;
+    if (!vsgXchange::readStream(fin, input)) return {};
+
+    return decode(input.data, input.size, options);
+}
+
+vsg::ref_ptr<vsg::Object> turbojpeg::read(const uint8_t* ptr, size_t size, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!vsg::compatibleExtension(options, _supportedExtensions)) return {};
+
+    return decode(ptr, size, options);
+}
+
+bool turbojpeg::getFeatures(Features& features) const
+{
+    for (auto& ext : _supportedExtensions)
+    {
+        features.extensionFeatureMap[ext] = static_cast<vsg::ReaderWriter::FeatureMask>(vsg::ReaderWriter::READ_FILENAME | vsg::ReaderWriter::READ_ISTREAM | vsg::ReaderWriter::READ_MEMORY);
+    }
+
+    features.optionNameTypeMap[turbojpeg::jpeg_scale] = vsg::type_name<uint32_t>();
+    features.optionNameTypeMap[images::max_texture_size] = vsg::type_name<uint32_t>();
+
+    return true;
+}
+
+bool turbojpeg::readOptions(vsg::Options& options, vsg::CommandLine& arguments) const
+{
+    bool result = arguments.readAndAssign<uint32_t>(turbojpeg::jpeg_scale, &options);
+    result = arguments.readAndAssign<uint32_t>(images::max_texture_size, &options) || result;
+    return result;
+}